@@ -0,0 +1,54 @@
+/*
+ * App Loop - One pass of the application loop
+ * Everything loop() does between two delays: LVGL, the serial commands,
+ * the battery, the current screen's updates and the background jobs in
+ * LVGL's slack. Shared by src/main.cpp and the host harness (tools/e2e),
+ * so the harness runs the device's loop and not a copy of it.
+ *
+ * Usage:
+ *   loop:
+ *     app_loop_step(appState, serialManager, powerMonitor);
+ *     delay(1);
+ */
+
+#ifndef APP_LOOP_H
+#define APP_LOOP_H
+
+#include <lvgl.h>
+#include "state/AppState.h"
+#include "state/SerialManager.h"
+#include "state/PowerMonitor.h"
+#include "main.h"
+
+static inline void app_loop_step(AppState* appState, SerialManager* serialManager, PowerMonitor* powerMonitor) {
+    // Update LVGL (high frequency for smooth animations)
+    // The returned time until LVGL's next timer is the slack for the background jobs
+    idle_sched_set_deadline(lv_timer_handler());
+
+    // Update serial communication (handles {"screen": N} commands and nose tracking "X:###,Y:###")
+    serialManager->update();
+
+    // Battery sample every POWER_SAMPLE_INTERVAL_MS, AppState only hears of changes
+    powerMonitor->update();
+
+    // Update Screen 7 target position and progress if on Screen 7
+    if (appState->getCurrentScreen() == SCREEN_7) {
+        screen7_update();  // Declared in Screen7.h
+    }
+
+    // Check if screen needs to change based on state
+    static ScreenID lastScreen = SCREEN_1;
+    ScreenID currentScreen = appState->getCurrentScreen();
+    if (currentScreen != lastScreen) {
+        switch_to_screen(currentScreen, true);  // true = with animation
+        lastScreen = currentScreen;
+    }
+
+    // Update UI based on state changes
+    update_ui();
+
+    // Background jobs in the rest of the slack
+    idle_sched_run();
+}
+
+#endif // APP_LOOP_H
@@ -3,13 +3,14 @@
  * Implements the packet-based protocol for display control
  * 
  * Protocol: [0xAA] [LEN] [CMD] [DATA...] [CHECKSUM] [0x55]
+ * LEN = 1 + data bytes (1-29), CHECKSUM = LEN ^ CMD ^ each data byte
  * Baud: 115200
  */
 
 #ifndef SERIAL_PROTOCOL_H
 #define SERIAL_PROTOCOL_H
 
-#include <Arduino.h>
+#include "state/ArduinoCompat.h"
 #include "state/AppState.h"
 #include "ScreenMapping.h"
 
@@ -58,6 +59,12 @@ private:
                     memcpy(&x, &data[0], 4);
                     memcpy(&y, &data[4], 4);
                     
+                    // Also keeps NaN and huge values out of the int16_t conversion below
+                    if (!(x >= 0.0f && x <= 1.0f && y >= 0.0f && y <= 1.0f)) {
+                        Serial.println("[PROTOCOL] Nose position out of range");
+                        break;
+                    }
+                    
                     // Convert normalized 0.0-1.0 to screen coordinates (600x450)
                     int16_t screenX = (int16_t)(x * 600.0f);
                     int16_t screenY = (int16_t)(y * 450.0f);
@@ -75,7 +82,8 @@ private:
                     uint8_t percent = data[0];
                     Serial.printf("[PROTOCOL] Progress: %d%%\n", percent);
                     
-                    // TODO: Update progress bar if on processing screen
+                    // Shown by the processing screen (Screen 7)
+                    appState->updateProgress(percent);
                 }
                 break;
             }
@@ -114,6 +122,14 @@ public:
                 // Collect packet bytes
                 buffer[bufferIndex++] = byte;
                 
+                // LEN counts CMD and DATA, the rest of the packet has to fit the buffer
+                if (bufferIndex == 1 && (byte == 0 || byte > MAX_PACKET_SIZE - 3)) {
+                    Serial.printf("[PROTOCOL] Invalid length: %d\n", byte);
+                    inPacket = false;
+                    bufferIndex = 0;
+                    continue;
+                }
+                
                 // Check if we have enough for a minimal packet
                 if (bufferIndex >= 4) {  // LEN + CMD + at least CHECKSUM + END
                     uint8_t len = buffer[0];
@@ -121,13 +137,13 @@ public:
                     
                     // Check if packet is complete
                     if (bufferIndex >= (2 + dataLen + 2)) {  // LEN + CMD + DATA + CHECKSUM + END
-                        uint8_t expectedEnd = buffer[1 + dataLen + 1];
+                        uint8_t expectedEnd = buffer[2 + dataLen + 1];
                         
                         if (expectedEnd == PACKET_END) {
                             // Valid packet structure
                             uint8_t cmd = buffer[1];
                             uint8_t* data = &buffer[2];
-                            uint8_t receivedChecksum = buffer[1 + dataLen];
+                            uint8_t receivedChecksum = buffer[2 + dataLen];
                             uint8_t calculatedChecksum = calculateChecksum(len, cmd, data, dataLen);
                             
                             if (receivedChecksum == calculatedChecksum) {
@@ -49,9 +49,9 @@ typedef struct {
     lv_obj_t* container;        // Container object
     lv_obj_t** tick_lines;      // Array of tick line objects
 #if LV_VERSION_CHECK(9, 0, 0)
-    lv_point_precise_t** tick_points; // LVGL 9: precise points (must persist!)
+    lv_point_precise_t* tick_points; // LVGL 9: precise points, 2 per tick (must persist!)
 #else
-    lv_point_t** tick_points;   // LVGL 8: integer points (must persist!)
+    lv_point_t* tick_points;    // LVGL 8: integer points, 2 per tick (must persist!)
 #endif
     circular_ring_config_t config;  // Current configuration
     lv_timer_t* anim_timer;     // Animation timer (for placeholder demo)
@@ -150,11 +150,12 @@ static inline circular_ring_t* circular_ring_create(lv_obj_t* parent, circular_r
         return NULL;
     }
     
-    // Allocate tick points array - CRITICAL: Points must persist for LVGL!
+    // Allocate the points of all ticks in one block - CRITICAL: Points must persist for LVGL!
+    // (One small block per tick would leave 60+ tiny holes in the heap per ring)
 #if LV_VERSION_CHECK(9, 0, 0)
-    ring->tick_points = (lv_point_precise_t**)malloc(sizeof(lv_point_precise_t*) * config->tick_count);
+    ring->tick_points = (lv_point_precise_t*)malloc(sizeof(lv_point_precise_t) * 2 * config->tick_count);
 #else
-    ring->tick_points = (lv_point_t**)malloc(sizeof(lv_point_t*) * config->tick_count);
+    ring->tick_points = (lv_point_t*)malloc(sizeof(lv_point_t) * 2 * config->tick_count);
 #endif
     if (!ring->tick_points) {
         free(ring->tick_lines);
@@ -179,30 +180,19 @@ static inline circular_ring_t* circular_ring_create(lv_obj_t* parent, circular_r
         int16_t inner_x = container_center + (int16_t)((config->radius - config->tick_length) * cos(angle_rad));
         int16_t inner_y = container_center + (int16_t)((config->radius - config->tick_length) * sin(angle_rad));
         
-        // Allocate persistent points for this line - MUST persist for LVGL!
+        // Persistent points of this line - MUST persist for LVGL!
 #if LV_VERSION_CHECK(9, 0, 0)
-        ring->tick_points[i] = (lv_point_precise_t*)malloc(sizeof(lv_point_precise_t) * 2);
+        lv_point_precise_t* points = &ring->tick_points[i * 2];
 #else
-        ring->tick_points[i] = (lv_point_t*)malloc(sizeof(lv_point_t) * 2);
+        lv_point_t* points = &ring->tick_points[i * 2];
 #endif
-        if (!ring->tick_points[i]) {
-            // Cleanup on failure
-            for (int j = 0; j < i; j++) {
-                free(ring->tick_points[j]);
-            }
-            free(ring->tick_points);
-            free(ring->tick_lines);
-            free(ring);
-            return NULL;
-        }
-        
-        ring->tick_points[i][0].x = inner_x;
-        ring->tick_points[i][0].y = inner_y;
-        ring->tick_points[i][1].x = outer_x;
-        ring->tick_points[i][1].y = outer_y;
+        points[0].x = inner_x;
+        points[0].y = inner_y;
+        points[1].x = outer_x;
+        points[1].y = outer_y;
         
         lv_obj_t* line = lv_line_create(ring->container);
-        lv_line_set_points(line, ring->tick_points[i], 2);  // Points will persist!
+        lv_line_set_points(line, points, 2);  // Points will persist!
         
         // Style the tick
         lv_obj_set_style_line_width(line, config->tick_width, 0);
@@ -347,13 +337,8 @@ static inline void circular_ring_delete(circular_ring_t* ring) {
     
     circular_ring_stop_anim(ring);
     
-    // Free point arrays
+    // Free point array
     if (ring->tick_points) {
-        for (int i = 0; i < ring->tick_count; i++) {
-            if (ring->tick_points[i]) {
-                free(ring->tick_points[i]);
-            }
-        }
         free(ring->tick_points);
     }
     
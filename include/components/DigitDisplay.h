@@ -0,0 +1,348 @@
+/*
+ * Digit Display Component - Numeric readout drawn from a digit atlas
+ *
+ * Features:
+ * - For values updated many times a second (progress percentages,
+ *   countdowns, sensor readings)
+ * - The digits of a font are rasterized once to an 8 bit atlas (in PSRAM)
+ *   and blitted, the text isn't measured or laid out on updates
+ * - Every digit gets the same slot width so the number doesn't jitter
+ *   with proportional fonts like Stack Sans
+ * - Only the slots whose character changed are invalidated
+ * - Works with any font having the digits, e.g. the stack_sans_* fonts
+ *
+ * Usage:
+ *   digit_display_config_t config = digit_display_config_default(&stack_sans_semibold_48);
+ *   config.slots = 4;                        // "100%"
+ *   digit_display_t* dd = digit_display_create(screen, &config);
+ *   lv_obj_align(dd->obj, LV_ALIGN_CENTER, 0, 60);
+ *   digit_display_set_int(dd, 42, "%");      // " 42%"
+ */
+
+#ifndef DIGIT_DISPLAY_H
+#define DIGIT_DISPLAY_H
+
+#include "lvgl.h"
+#include <stdint.h>
+#include <stdlib.h>  // For malloc/free
+#include <string.h>
+
+// Characters in the atlas. The digits, space, '+' and '-' use the same slot width.
+#define DIGIT_DISPLAY_CHARS "0123456789 +-%.:"
+#define DIGIT_DISPLAY_CHAR_CNT 16
+#define DIGIT_DISPLAY_FIXED_CNT 13  // The first ones with the slot width
+
+// Longest text of a display
+#ifndef DIGIT_DISPLAY_MAX_SLOTS
+#define DIGIT_DISPLAY_MAX_SLOTS 12
+#endif
+
+// Fonts with an atlas (a 48 px font takes ~25 KB)
+#ifndef DIGIT_DISPLAY_ATLAS_CNT
+#define DIGIT_DISPLAY_ATLAS_CNT 4
+#endif
+
+// ============================================================================
+// DIGIT ATLAS
+// ============================================================================
+
+/**
+ * Pre-rasterized characters of a font, every cell is line height tall
+ */
+typedef struct {
+    const lv_font_t* font;
+    lv_coord_t slot_w;                           // Width of the digit slots
+    lv_coord_t cell_h;
+    lv_coord_t cell_w[DIGIT_DISPLAY_CHAR_CNT];
+    uint32_t cell_ofs[DIGIT_DISPLAY_CHAR_CNT];   // Start of the cells in `cells`
+    uint8_t* cells;                              // 8 bit coverage
+} digit_atlas_t;
+
+static digit_atlas_t digit_atlases[DIGIT_DISPLAY_ATLAS_CNT];
+
+static inline int digit_atlas_index(char c) {
+    const char* p = (c != '\0') ? strchr(DIGIT_DISPLAY_CHARS, c) : NULL;
+    return p ? (int)(p - DIGIT_DISPLAY_CHARS) : -1;
+}
+
+/**
+ * Copy the glyph of a letter into a cell, centered horizontally
+ */
+static inline void digit_atlas_render(const lv_font_t* font, uint32_t letter, uint8_t* cell,
+                                      lv_coord_t cell_w, lv_coord_t cell_h) {
+    lv_font_glyph_dsc_t g;
+    if (!lv_font_get_glyph_dsc(font, &g, letter, 0)) return;
+    if (g.box_w == 0 || g.box_h == 0) return;
+    const uint8_t* bitmap = lv_font_get_glyph_bitmap(g.resolved_font, letter);
+    if (bitmap == NULL) return;
+
+    // Compressed 3 bpp fonts are decompressed to 4 bpp
+    uint32_t bpp = g.bpp == 3 ? 4 : g.bpp;
+    if (bpp != 1 && bpp != 2 && bpp != 4 && bpp != 8) return;
+    uint32_t max = (1 << bpp) - 1;
+
+    // Same place as lv_draw_letter() puts it on the line, kept inside the cell if it overhangs
+    lv_coord_t x0 = (cell_w - g.adv_w) / 2 + g.ofs_x;
+    if (x0 + g.box_w > cell_w) x0 = cell_w - g.box_w;
+    if (x0 < 0) x0 = 0;
+    lv_coord_t y0 = (font->line_height - font->base_line) - g.box_h - g.ofs_y;
+
+    // The rows of the glyph bitmap follow each other without padding
+    uint32_t bit = 0;
+    for (lv_coord_t y = 0; y < g.box_h; y++) {
+        for (lv_coord_t x = 0; x < g.box_w; x++, bit += bpp) {
+            uint32_t v = (bitmap[bit >> 3] >> (8 - bpp - (bit & 7))) & max;
+            lv_coord_t cx = x0 + x;
+            lv_coord_t cy = y0 + y;
+            if (v == 0 || cx < 0 || cx >= cell_w || cy < 0 || cy >= cell_h) continue;
+            cell[cy * cell_w + cx] = (uint8_t)(v * 255 / max);
+        }
+    }
+}
+
+/**
+ * Width of a cell holding a letter: its advance or its bitmap if that's wider
+ */
+static inline lv_coord_t digit_atlas_cell_w(const lv_font_t* font, uint32_t letter) {
+    lv_font_glyph_dsc_t g;
+    if (!lv_font_get_glyph_dsc(font, &g, letter, 0)) return 0;
+    return g.box_w > g.adv_w ? g.box_w : g.adv_w;
+}
+
+/**
+ * Get the atlas of a font, rasterize it on the first use
+ * @return The atlas or NULL if it couldn't be allocated
+ */
+static inline const digit_atlas_t* digit_atlas_get(const lv_font_t* font) {
+    digit_atlas_t* free_atlas = NULL;
+    for (int i = 0; i < DIGIT_DISPLAY_ATLAS_CNT; i++) {
+        if (digit_atlases[i].font == font) return &digit_atlases[i];
+        if (digit_atlases[i].font == NULL && free_atlas == NULL) free_atlas = &digit_atlases[i];
+    }
+    if (free_atlas == NULL) return NULL;
+
+    digit_atlas_t atlas;
+    memset(&atlas, 0, sizeof(atlas));
+    atlas.font = font;
+    atlas.cell_h = lv_font_get_line_height(font);
+    for (int i = 0; i < DIGIT_DISPLAY_FIXED_CNT; i++) {
+        lv_coord_t w = digit_atlas_cell_w(font, DIGIT_DISPLAY_CHARS[i]);
+        if (w > atlas.slot_w) atlas.slot_w = w;
+    }
+
+    uint32_t size = 0;
+    for (int i = 0; i < DIGIT_DISPLAY_CHAR_CNT; i++) {
+        atlas.cell_w[i] = i < DIGIT_DISPLAY_FIXED_CNT ? atlas.slot_w :
+                          digit_atlas_cell_w(font, DIGIT_DISPLAY_CHARS[i]);
+        atlas.cell_ofs[i] = size;
+        size += atlas.cell_w[i] * atlas.cell_h;
+    }
+
+    atlas.cells = (uint8_t*)lv_mem_alloc_large(size);
+    if (atlas.cells == NULL) return NULL;
+    memset(atlas.cells, 0, size);
+
+    for (int i = 0; i < DIGIT_DISPLAY_CHAR_CNT; i++) {
+        digit_atlas_render(font, DIGIT_DISPLAY_CHARS[i], atlas.cells + atlas.cell_ofs[i],
+                           atlas.cell_w[i], atlas.cell_h);
+    }
+
+    *free_atlas = atlas;
+    return free_atlas;
+}
+
+/**
+ * Free the atlases (the displays using them must be deleted first)
+ */
+static inline void digit_atlas_clean() {
+    for (int i = 0; i < DIGIT_DISPLAY_ATLAS_CNT; i++) {
+        if (digit_atlases[i].cells) lv_mem_free(digit_atlases[i].cells);
+        memset(&digit_atlases[i], 0, sizeof(digit_atlas_t));
+    }
+}
+
+// ============================================================================
+// DIGIT DISPLAY CONFIGURATION
+// ============================================================================
+
+/**
+ * Digit display configuration
+ */
+typedef struct {
+    const lv_font_t* font;      // Font of the digits
+    lv_color_t color;           // Text color
+    lv_opa_t opa;               // Text opacity
+    uint8_t slots;              // Texts are padded with spaces on the left to this length
+} digit_display_config_t;
+
+/**
+ * Digit display object structure
+ */
+typedef struct {
+    lv_obj_t* obj;              // The object drawing the digits (align it)
+    const digit_atlas_t* atlas;
+    digit_display_config_t config;
+    char text[DIGIT_DISPLAY_MAX_SLOTS + 1];
+    uint8_t len;
+    uint32_t invalidated_px;    // Pixels invalidated by the updates (for comparisons)
+} digit_display_t;
+
+/**
+ * Create default digit display config
+ */
+static inline digit_display_config_t digit_display_config_default(const lv_font_t* font) {
+    digit_display_config_t config;
+    config.font = font;
+    config.color = lv_color_white();
+    config.opa = LV_OPA_COVER;
+    config.slots = 3;
+    return config;
+}
+
+// ============================================================================
+// DIGIT DISPLAY CREATION & MANAGEMENT
+// ============================================================================
+
+static inline lv_coord_t digit_display_char_w(const digit_atlas_t* atlas, char c) {
+    int i = digit_atlas_index(c);
+    return i >= 0 ? atlas->cell_w[i] : atlas->slot_w;
+}
+
+/**
+ * Blit the cells of the characters
+ */
+static inline void digit_display_draw_cb(lv_event_t* e) {
+    digit_display_t* dd = (digit_display_t*)lv_event_get_user_data(e);
+    lv_obj_t* obj = lv_event_get_target(e);
+    lv_draw_ctx_t* draw_ctx = lv_event_get_draw_ctx(e);
+
+    lv_draw_img_dsc_t img_dsc;
+    lv_draw_img_dsc_init(&img_dsc);
+    img_dsc.recolor = dd->config.color;
+    img_dsc.opa = dd->config.opa;
+
+    lv_area_t cell;
+    cell.x1 = obj->coords.x1;
+    cell.y1 = obj->coords.y1;
+    cell.y2 = cell.y1 + dd->atlas->cell_h - 1;
+    for (uint8_t i = 0; i < dd->len; i++) {
+        int idx = digit_atlas_index(dd->text[i]);
+        lv_coord_t w = digit_display_char_w(dd->atlas, dd->text[i]);
+        cell.x2 = cell.x1 + w - 1;
+
+        lv_area_t clipped;
+        if (idx >= 0 && _lv_area_intersect(&clipped, &cell, draw_ctx->clip_area)) {
+            lv_draw_img_decoded(draw_ctx, &img_dsc, &cell, dd->atlas->cells + dd->atlas->cell_ofs[idx],
+                                LV_IMG_CF_ALPHA_8BIT);
+        }
+        cell.x1 += w;
+    }
+}
+
+static inline void digit_display_delete_cb(lv_event_t* e) {
+    free(lv_event_get_user_data(e));
+}
+
+/**
+ * Create digit display component
+ * @param parent Parent screen/object
+ * @param config Display configuration
+ * @return Digit display object or NULL
+ */
+static inline digit_display_t* digit_display_create(lv_obj_t* parent, const digit_display_config_t* config) {
+    const digit_atlas_t* atlas = digit_atlas_get(config->font);
+    if (!atlas) return NULL;
+
+    digit_display_t* dd = (digit_display_t*)malloc(sizeof(digit_display_t));
+    if (!dd) return NULL;
+    memset(dd, 0, sizeof(digit_display_t));
+    dd->atlas = atlas;
+    dd->config = *config;
+    if (dd->config.slots > DIGIT_DISPLAY_MAX_SLOTS) dd->config.slots = DIGIT_DISPLAY_MAX_SLOTS;
+
+    // A bare object, everything is drawn by digit_display_draw_cb
+    dd->obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(dd->obj);
+    lv_obj_clear_flag(dd->obj, (lv_obj_flag_t)(LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE));
+    lv_obj_set_size(dd->obj, atlas->slot_w * dd->config.slots, atlas->cell_h);
+    lv_obj_add_event_cb(dd->obj, digit_display_draw_cb, LV_EVENT_DRAW_MAIN, dd);
+    lv_obj_add_event_cb(dd->obj, digit_display_delete_cb, LV_EVENT_DELETE, dd);
+
+    return dd;
+}
+
+/**
+ * Set the text (only the characters of DIGIT_DISPLAY_CHARS are drawn)
+ * @param dd Digit display
+ * @param text New text, padded on the left to the configured slots
+ */
+static inline void digit_display_set_text(digit_display_t* dd, const char* text) {
+    if (!dd) return;
+
+    char padded[DIGIT_DISPLAY_MAX_SLOTS + 1];
+    size_t len = strlen(text);
+    if (len > DIGIT_DISPLAY_MAX_SLOTS) len = DIGIT_DISPLAY_MAX_SLOTS;
+    size_t pad = len < dd->config.slots ? dd->config.slots - len : 0;
+    memset(padded, ' ', pad);
+    memcpy(padded + pad, text, len);
+    len += pad;
+    padded[len] = '\0';
+
+    // Same widths in the same order: invalidate only the changed slots
+    bool same_layout = len == dd->len;
+    for (size_t i = 0; same_layout && i < len; i++) {
+        same_layout = digit_display_char_w(dd->atlas, padded[i]) == digit_display_char_w(dd->atlas, dd->text[i]);
+    }
+
+    if (!same_layout) {
+        lv_coord_t w = 0;
+        for (size_t i = 0; i < len; i++) w += digit_display_char_w(dd->atlas, padded[i]);
+        lv_obj_invalidate(dd->obj);
+        if (w != lv_obj_get_width(dd->obj)) lv_obj_set_width(dd->obj, w);
+        dd->invalidated_px += lv_area_get_size(&dd->obj->coords);
+    } else {
+        lv_area_t area;
+        area.x1 = dd->obj->coords.x1;
+        area.y1 = dd->obj->coords.y1;
+        area.y2 = dd->obj->coords.y2;
+        for (size_t i = 0; i < len; i++) {
+            area.x2 = area.x1 + digit_display_char_w(dd->atlas, padded[i]) - 1;
+            if (padded[i] != dd->text[i]) {
+                lv_obj_invalidate_area(dd->obj, &area);
+                dd->invalidated_px += lv_area_get_size(&area);
+            }
+            area.x1 = area.x2 + 1;
+        }
+    }
+
+    memcpy(dd->text, padded, len + 1);
+    dd->len = (uint8_t)len;
+}
+
+/**
+ * Show an integer with an optional suffix (e.g. "%")
+ */
+static inline void digit_display_set_int(digit_display_t* dd, int32_t value, const char* suffix) {
+    char buf[DIGIT_DISPLAY_MAX_SLOTS + 1];
+    lv_snprintf(buf, sizeof(buf), "%ld%s", (long)value, suffix ? suffix : "");
+    digit_display_set_text(dd, buf);
+}
+
+/**
+ * Set color of the digits
+ */
+static inline void digit_display_set_color(digit_display_t* dd, lv_color_t color) {
+    if (!dd) return;
+    dd->config.color = color;
+    lv_obj_invalidate(dd->obj);
+}
+
+/**
+ * Delete digit display (the atlas is kept for the next displays)
+ */
+static inline void digit_display_delete(digit_display_t* dd) {
+    if (!dd) return;
+    lv_obj_del(dd->obj);  // Frees `dd` in digit_display_delete_cb
+}
+
+#endif // DIGIT_DISPLAY_H
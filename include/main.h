@@ -8,6 +8,7 @@
 
 #include <lvgl.h>
 #include "utils/SmartTransition.h"
+#include "utils/IdleScheduler.h"
 
 // Include fonts (only once here)
 #include "fonts/stack_sans_semibold_48.c"
@@ -38,53 +39,58 @@ static lv_obj_t* all_screens[14] = {NULL};
 static int current_screen_index = 0;
 
 /**
- * Initialize UI - Create all screens
- * Call this once at startup
+ * Create a screen by index
+ * @param screen_index Screen index (0-13)
+ * @return The new screen or NULL
  */
-static inline void init_ui() {
-    // Create Screen 0 (Test screen)
-    all_screens[0] = screen0_create();
-    
-    // Create Screen 1
-    all_screens[1] = screen1_create();
-    
-    // Create Screen 2
-    all_screens[2] = screen2_create();
-    
-    // Create Screen 3
-    all_screens[3] = screen3_create();
-
-    // Create Screen 4
-    all_screens[4] = screen4_create();
-
-    // Create Screen 5
-    all_screens[5] = screen5_create();
-
-    // Create Screen 6
-    all_screens[6] = screen6_create();
-
-    // Create Screen 7
-    all_screens[7] = screen7_create();
-
-    // Create Screen 8
-    all_screens[8] = screen8_create();
+static inline lv_obj_t* create_screen(int screen_index) {
+    switch (screen_index) {
+        case 0: return screen0_create();    // Test screen
+        case 1: return screen1_create();
+        case 2: return screen2_create();
+        case 3: return screen3_create();
+        case 4: return screen4_create();
+        case 5: return screen5_create();
+        case 6: return screen6_create();
+        case 7: return screen7_create();
+        case 8: return screen8_create();
+        case 9: return screen9_create();
+        case 10: return screen10_create();
+        case 11: return screen11_create();  // WiFi Change - Connecting
+        case 12: return screen12_create();  // WiFi Change - Success
+        case 13: return screen13_create();  // WiFi Change - Failed
+        default: return NULL;
+    }
+}
 
-    // Create Screen 9
-    all_screens[9] = screen9_create();
+// Next screen built in the idle time
+static int next_screen_to_build = 0;
 
-    // Create Screen 10
-    all_screens[10] = screen10_create();
-    
-    // Create Screen 11 (WiFi Change - Connecting)
-    all_screens[11] = screen11_create();
-    
-    // Create Screen 12 (WiFi Change - Success)
-    all_screens[12] = screen12_create();
+/**
+ * Idle job: build one of the remaining screens per step
+ */
+static bool build_screens_step(void* user_data) {
+    LV_UNUSED(user_data);
+    while (next_screen_to_build < 14 && all_screens[next_screen_to_build] != NULL) {
+        next_screen_to_build++;
+    }
+    if (next_screen_to_build >= 14) return true;
     
-    // Create Screen 13 (WiFi Change - Failed)
-    all_screens[13] = screen13_create();
+    all_screens[next_screen_to_build] = create_screen(next_screen_to_build);
+    next_screen_to_build++;
+    return next_screen_to_build >= 14;
+}
+
+/**
+ * Initialize UI - Create the first screen, the others are built in the
+ * idle time between frames (or when they are switched to)
+ * Call this once at startup
+ */
+static inline void init_ui() {
+    // Create Screen 1 (Logo, skip test screen 0)
+    all_screens[1] = create_screen(1);
     
-    // Load first screen (Screen 1 - Logo, skip test screen 0)
+    // Load first screen
     if (all_screens[1] != NULL) {
 #if LV_VERSION_CHECK(9, 0, 0)
         lv_screen_load(all_screens[1]);
@@ -93,6 +99,9 @@ static inline void init_ui() {
 #endif
         current_screen_index = 1;
     }
+    
+    // Without idle_sched_run() in the loop the screens are built on demand
+    idle_sched_add(build_screens_step, NULL, 8000, "screens");
 }
 
 /**
@@ -107,21 +116,28 @@ static inline void switch_to_screen(int screen_index, bool animate) {
     }
     
     if (all_screens[screen_index] == NULL) {
-        return;  // Screen not created yet
+        // Not built in the idle time yet
+        all_screens[screen_index] = create_screen(screen_index);
+        if (all_screens[screen_index] == NULL) {
+            return;
+        }
     }
     
     current_screen_index = screen_index;
     
     if (animate) {
-        // Black overlay fade: to black (200ms) → switch → from black (200ms)
-        smooth_black_fade_transition(all_screens[screen_index]);
+        // Blend snapshots of the two screens (SMART_TRANSITION_STYLE), black fade if out of PSRAM
+        smart_transition(all_screens[screen_index]);
     } else {
         // Instant load
+        latency_trace_watch(LATENCY_TRACE_KIND_SCREEN, 0, 0, lv_disp_get_hor_res(NULL) - 1,
+                            lv_disp_get_ver_res(NULL) - 1);
         #if LV_VERSION_CHECK(9, 0, 0)
         lv_screen_load(all_screens[screen_index]);
         #else
         lv_scr_load(all_screens[screen_index]);
         #endif
+        latency_trace_screen_loaded();
     }
 }
 
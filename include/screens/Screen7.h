@@ -1,5 +1,7 @@
 /*
  * Screen 7 - Nose Tracking with target icon and circular ring
+ * The ring shows the processing progress ({"progress": N} or CMD_PROGRESS)
+ * with the percentage below the target, a placeholder animation until then.
  */
 
 #ifndef SCREEN_7_H
@@ -8,14 +10,21 @@
 #include <lvgl.h>
 #include "../components/TargetIcon.h"
 #include "../components/CircularRing.h"
+#include "../components/DigitDisplay.h"
 #include "../state/AppState.h"
 #include "../utils/LayerManager.h"
+#include "../utils/LatencyTrace.h"
+
+// Font declaration (defined in main.h)
+extern const lv_font_t stack_sans_semibold_48;
 
 // Screen 7 objects
 static lv_obj_t* screen7 = NULL;
 static lv_obj_t* screen7_target = NULL;
 static circular_ring_t* screen7_ring = NULL;
 static AppState* screen7_appState = NULL;
+static digit_display_t* screen7_percent = NULL;
+static int16_t screen7_shown_progress = -1;  // -1: placeholder animation
 
 /**
  * Create Screen 7 - Target icon with circular ring and nose tracking
@@ -52,6 +61,16 @@ static inline lv_obj_t* screen7_create() {
         circular_ring_start_placeholder_anim(screen7_ring);
     }
 
+    // Progress percentage below the target, hidden until the first update ("100%")
+    digit_display_config_t percent_config = digit_display_config_default(&stack_sans_semibold_48);
+    percent_config.slots = 4;
+    screen7_percent = digit_display_create(screen7, &percent_config);
+    if (screen7_percent) {
+        lv_obj_align(screen7_percent->obj, LV_ALIGN_CENTER, 0, 100);
+        lv_obj_add_flag(screen7_percent->obj, LV_OBJ_FLAG_HIDDEN);
+    }
+    screen7_shown_progress = -1;
+
     // Display target icon at center (initial position) - 30x30px
     screen7_target = target_icon_create(screen7, 233 - 15, 233 - 15);  // Center at (233, 233)
     
@@ -71,26 +90,67 @@ static inline lv_obj_t* screen7_create() {
  */
 static inline void screen7_update_position() {
     if (screen7_target && screen7_appState) {
-        // Only update position if tracking is active
+        // Center the 30x30px icon on the tracked position, or keep it centered without tracking data
+        lv_coord_t x = 233 - 15;
+        lv_coord_t y = 233 - 15;
         if (screen7_appState->isTrackingActive()) {
-            int16_t targetX = screen7_appState->getTargetX();
-            int16_t targetY = screen7_appState->getTargetY();
-            
-            // Set position (center the 30x30px icon on the target coordinates)
-            lv_obj_set_pos(screen7_target, targetX - 15, targetY - 15);
-        } else {
-            // No tracking data - keep centered
-            lv_obj_set_pos(screen7_target, 233 - 15, 233 - 15);
+            x = screen7_appState->getTargetX() - 15;
+            y = screen7_appState->getTargetY() - 15;
+        }
+
+        lv_area_t old_area;
+        lv_obj_get_coords(screen7_target, &old_area);
+        if (x != old_area.x1 || y != old_area.y1) {
+            // The move is drawn where the icon was and where it goes
+            latency_trace_watch(LATENCY_TRACE_KIND_TARGET, old_area.x1, old_area.y1, old_area.x2, old_area.y2);
+            latency_trace_watch(LATENCY_TRACE_KIND_TARGET, x, y, x + lv_area_get_width(&old_area) - 1,
+                                y + lv_area_get_height(&old_area) - 1);
         }
+        lv_obj_set_pos(screen7_target, x, y);
     }
 }
 
 /**
- * Update Screen 7 (if needed for other updates)
+ * Update Screen 7 - Show the processing progress on the ring and the digits
+ * Only a changed value is redrawn, and only the digits that changed
+ */
+static inline void screen7_update_progress() {
+    if (!screen7_ring || !screen7_appState) return;
+
+    if (!screen7_appState->isProgressActive()) {
+        // Back to the placeholder until the next progress
+        if (screen7_shown_progress >= 0) {
+            if (screen7_percent) lv_obj_add_flag(screen7_percent->obj, LV_OBJ_FLAG_HIDDEN);
+            circular_ring_start_placeholder_anim(screen7_ring);
+            screen7_shown_progress = -1;
+        }
+        return;
+    }
+
+    int16_t progress = screen7_appState->getProgress();
+    if (progress == screen7_shown_progress) return;
+
+    // Drawn on the ring, the digits are inside it
+    lv_area_t ring_area;
+    lv_obj_get_coords(screen7_ring->container, &ring_area);
+    latency_trace_watch(LATENCY_TRACE_KIND_PROGRESS, ring_area.x1, ring_area.y1, ring_area.x2, ring_area.y2);
+
+    if (screen7_shown_progress < 0) {
+        circular_ring_stop_anim(screen7_ring);
+        if (screen7_percent) lv_obj_clear_flag(screen7_percent->obj, LV_OBJ_FLAG_HIDDEN);
+    }
+    circular_ring_set_percentage(screen7_ring, progress);
+    digit_display_set_int(screen7_percent, progress, "%");
+    screen7_shown_progress = progress;
+}
+
+/**
+ * Update Screen 7 - Target position and progress
+ * Call this from your main loop when on Screen 7
  */
 static inline void screen7_update() {
-    // Called when state changes
     screen7_update_position();
+    screen7_update_progress();
 }
 
 #endif // SCREEN_7_H
\ No newline at end of file
@@ -7,12 +7,14 @@
 
 #include "StateTypes.h"
 #include "ArduinoCompat.h"
+#include "../utils/LatencyTrace.h"
 
 class AppState {
 private:
     static AppState* instance;
     AppStateData state;
     void (*screenChangeCallback)(ScreenID newScreen) = nullptr;
+    void (*powerChangeCallback)(float level, bool charging) = nullptr;
     
     AppState() {
         state.currentScreen = SCREEN_0;  // Start with test screen
@@ -25,6 +27,8 @@ private:
         state.targetY = 233;  // Center Y
         state.trackingActive = false;
         state.lastTrackingUpdate = 0;
+        state.progress = 0;
+        state.progressActive = false;
     }
     
 public:
@@ -44,6 +48,8 @@ public:
     void changeScreen(ScreenID newScreen) {
         state.previousScreen = state.currentScreen;
         state.currentScreen = newScreen;
+        state.progressActive = false;  // A new screen starts without progress
+        latency_trace_state_changed(LATENCY_TRACE_KIND_SCREEN);
         Serial.printf("Screen changed: %d -> %d\n", state.previousScreen, state.currentScreen);
         
         // Call the callback to actually load the screen
@@ -54,11 +60,29 @@ public:
     
     ScreenID getCurrentScreen() { return state.currentScreen; }
     
+    void setPowerChangeCallback(void (*callback)(float level, bool charging)) {
+        powerChangeCallback = callback;
+    }
+    
+    // Battery level in percent, called by PowerMonitor when the shown value changes
+    void updatePower(float level, bool charging) {
+        if (level == state.batteryLevel && charging == state.isCharging) return;
+        state.batteryLevel = level;
+        state.isCharging = charging;
+        if (powerChangeCallback) {
+            powerChangeCallback(level, charging);
+        }
+    }
+    
+    float getBatteryLevel() { return state.batteryLevel; }
+    bool isCharging() { return state.isCharging; }
+    
     void updateTargetPosition(int16_t x, int16_t y) {
         state.targetX = x;
         state.targetY = y;
         state.trackingActive = true;
         state.lastTrackingUpdate = millis();
+        latency_trace_state_changed(LATENCY_TRACE_KIND_TARGET);
     }
     
     int16_t getTargetX() { return state.targetX; }
@@ -68,13 +92,19 @@ public:
         return state.trackingActive && (millis() - state.lastTrackingUpdate < 2000);
     }
     
+    // Progress of the processing in percent (0-100)
+    void updateProgress(uint8_t percent) {
+        state.progress = percent > 100 ? 100 : percent;
+        state.progressActive = true;
+        latency_trace_state_changed(LATENCY_TRACE_KIND_PROGRESS);
+    }
+    
+    uint8_t getProgress() { return state.progress; }
+    bool isProgressActive() { return state.progressActive; }
+    
     void updateFromSerial(String data) {
         // Parse and update state from serial data
-#ifdef ARDUINO
         Serial.println("State updated from serial: " + data);
-#else
-        Serial.println("State updated from serial");
-#endif
     }
 };
 
@@ -1,5 +1,27 @@
 /*
  * Arduino Compatibility Layer for Simulator
+ * Host versions of the parts of the Arduino core used by the state and
+ * protocol code (String, Serial, millis/micros/delay), so SerialManager and
+ * SerialProtocol compile and behave the same on Linux as on the device.
+ *
+ * millis()/micros() read the simulator clock. It follows the wall clock by
+ * default; switched to virtual time it moves only when advanced, so LVGL's
+ * tick, the animations and transition timers, and the state timeouts
+ * (AppState::isTrackingActive) all see the same time and a simulated
+ * session runs as fast as the CPU allows and the same way on every run
+ * (tools/soak/kiosk_soak.cpp). In virtual time delay() advances the clock
+ * instead of sleeping.
+ *
+ * Serial reads from an in-memory receive queue and captures what's written,
+ * or reads and writes a file descriptor (e.g. a pty) once attached.
+ *
+ * Usage (simulator):
+ *   SerialClass Serial;                     // in one .cpp
+ *   sim_clock_set_tick_cb(lv_tick_inc);     // if LV_TICK_CUSTOM is 0
+ *   sim_clock_use_virtual(0);
+ *   Serial.inject("{\"screen\": 2}\n");     // or Serial.attach(pty_fd)
+ *   sim_clock_run(3600000, LV_DISP_DEF_REFR_PERIOD, sim_loop);  // 1 hour of loop()
+ *   std::string out = Serial.take_output();
  */
 
 #ifndef ARDUINO_COMPAT_H
@@ -9,25 +31,378 @@
 // Real Arduino environment - use real functions
 #include <Arduino.h>
 #else
-// Simulator environment - provide stub
+// Simulator environment - provide host versions
 #include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/time.h>
+#include <string>
 
-// Stub Serial object for simulator
-class SerialClass {
-public:
-    void printf(const char* format, ...) {}
-    void println(const char* msg) {}
-};
-extern SerialClass Serial;
+// Keep at most this many bytes of Serial output when no fd is attached
+#ifndef ARDUINO_COMPAT_TX_CAPTURE
+#define ARDUINO_COMPAT_TX_CAPTURE (64 * 1024)
+#endif
 
-// Stub millis() for simulator
-static inline unsigned long millis() {
+/**
+ * Time source of the simulator
+ */
+typedef struct {
+    bool is_virtual;
+    uint64_t virtual_us;          // Current time in virtual mode
+    void (*tick_cb)(uint32_t ms); // Told how many ms passed on advance, e.g. lv_tick_inc
+} sim_clock_t;
+
+static sim_clock_t sim_clock;
+
+static inline uint64_t sim_clock_now_us() {
+    if (sim_clock.is_virtual) return sim_clock.virtual_us;
     struct timeval tv;
     gettimeofday(&tv, NULL);
-    return (tv.tv_sec * 1000UL) + (tv.tv_usec / 1000UL);
+    return (uint64_t)tv.tv_sec * 1000000ULL + tv.tv_usec;
 }
-#endif
 
+/**
+ * Stop following the wall clock
+ * @param start_ms Time to start from (millis() returns this)
+ */
+static inline void sim_clock_use_virtual(uint32_t start_ms) {
+    sim_clock.virtual_us = (uint64_t)start_ms * 1000;
+    sim_clock.is_virtual = true;
+}
+
+static inline void sim_clock_use_real() {
+    sim_clock.is_virtual = false;
+}
+
+/**
+ * @param tick_cb Called with the whole ms passed on each advance (NULL: none)
+ */
+static inline void sim_clock_set_tick_cb(void (*tick_cb)(uint32_t ms)) {
+    sim_clock.tick_cb = tick_cb;
+}
+
+/**
+ * Move the virtual clock forward (no effect on the wall clock)
+ */
+static inline void sim_clock_advance_us(uint64_t us) {
+    if (!sim_clock.is_virtual) return;
+    uint64_t prev_ms = sim_clock.virtual_us / 1000;
+    sim_clock.virtual_us += us;
+    uint64_t ms = sim_clock.virtual_us / 1000 - prev_ms;
+    if (sim_clock.tick_cb && ms) sim_clock.tick_cb((uint32_t)ms);
+}
+
+static inline void sim_clock_advance_ms(uint32_t ms) {
+    sim_clock_advance_us((uint64_t)ms * 1000);
+}
+
+/**
+ * Call a loop function for a span of virtual time without waiting
+ * @param duration_ms Virtual time to simulate (delays in loop_fn count too)
+ * @param step_ms Virtual time between two calls, e.g. the refresh period
+ * @param loop_fn Does one iteration, like loop()
+ * @return Number of calls
+ */
+static inline uint32_t sim_clock_run(uint32_t duration_ms, uint32_t step_ms, void (*loop_fn)(void)) {
+    if (!sim_clock.is_virtual) sim_clock_use_virtual(0);
+    if (step_ms == 0) step_ms = 1;
+    uint64_t end_us = sim_clock.virtual_us + (uint64_t)duration_ms * 1000;
+    uint32_t calls = 0;
+    while (sim_clock.virtual_us < end_us) {
+        loop_fn();
+        sim_clock_advance_ms(step_ms);
+        calls++;
+    }
+    return calls;
+}
+
+static inline unsigned long millis() {
+    return (unsigned long)(sim_clock_now_us() / 1000);
+}
+
+static inline unsigned long micros() {
+    return (unsigned long)sim_clock_now_us();
+}
+
+static inline void delay(unsigned long ms) {
+    if (sim_clock.is_virtual) sim_clock_advance_ms(ms);
+    else usleep(ms * 1000);
+}
+
+static inline void delayMicroseconds(unsigned int us) {
+    if (sim_clock.is_virtual) sim_clock_advance_us(us);
+    else usleep(us);
+}
+
+static inline void yield() {}
+
+/**
+ * The subset of Arduino's String used by the state and protocol code.
+ * Out of range arguments give the same results as on the device.
+ */
+class String {
+private:
+    std::string s;
+
+    static int found(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+
+    void fromULong(unsigned long value, unsigned char base) {
+        char buf[8 * sizeof(long) + 1];
+        char* p = buf + sizeof(buf) - 1;
+        *p = 0;
+        if (base < 2 || base > 36) base = 10;
+        do {
+            unsigned int d = value % base;
+            *--p = d < 10 ? '0' + d : 'a' + d - 10;
+            value /= base;
+        } while (value);
+        s = p;
+    }
+
+    void fromLong(long value, unsigned char base) {
+        if (value < 0 && base == 10) {
+            fromULong(0UL - (unsigned long)value, base);
+            s.insert(0, 1, '-');
+        } else {
+            fromULong((unsigned long)value, base);
+        }
+    }
+
+    void fromDouble(double value, unsigned int decimals) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+        s = buf;
+    }
+
+public:
+    String() {}
+    String(const char* cstr) : s(cstr ? cstr : "") {}
+    String(const std::string& str) : s(str) {}
+    explicit String(char c) : s(1, c) {}
+    explicit String(int value, unsigned char base = 10) { fromLong(value, base); }
+    explicit String(unsigned int value, unsigned char base = 10) { fromULong(value, base); }
+    explicit String(long value, unsigned char base = 10) { fromLong(value, base); }
+    explicit String(unsigned long value, unsigned char base = 10) { fromULong(value, base); }
+    explicit String(float value, unsigned int decimals = 2) { fromDouble(value, decimals); }
+    explicit String(double value, unsigned int decimals = 2) { fromDouble(value, decimals); }
+
+    unsigned int length() const { return (unsigned int)s.length(); }
+    const char* c_str() const { return s.c_str(); }
+    bool reserve(unsigned int size) { s.reserve(size); return true; }
+
+    char charAt(unsigned int index) const { return index < s.length() ? s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) {
+        static char dummy;
+        dummy = 0;
+        return index < s.length() ? s[index] : dummy;
+    }
+
+    String& operator=(const char* cstr) { s = cstr ? cstr : ""; return *this; }
+    String& operator+=(const String& str) { s += str.s; return *this; }
+    String& operator+=(const char* cstr) { if (cstr) s += cstr; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    String& operator+=(int value) { return *this += String(value); }
+    String& operator+=(unsigned int value) { return *this += String(value); }
+    String& operator+=(long value) { return *this += String(value); }
+    String& operator+=(unsigned long value) { return *this += String(value); }
+    bool concat(const String& str) { s += str.s; return true; }
+    bool concat(const char* cstr) { if (cstr) s += cstr; return true; }
+    bool concat(char c) { s += c; return true; }
+
+    bool equals(const String& str) const { return s == str.s; }
+    bool equals(const char* cstr) const { return s == (cstr ? cstr : ""); }
+    bool operator==(const String& str) const { return s == str.s; }
+    bool operator==(const char* cstr) const { return equals(cstr); }
+    bool operator!=(const String& str) const { return s != str.s; }
+    bool operator!=(const char* cstr) const { return !equals(cstr); }
+    bool operator<(const String& str) const { return s < str.s; }
+    bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.length(), prefix.s) == 0; }
+    bool endsWith(const String& suffix) const {
+        return s.length() >= suffix.s.length() &&
+               s.compare(s.length() - suffix.s.length(), suffix.s.length(), suffix.s) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { return found(s.find(c, from)); }
+    int indexOf(const String& str, unsigned int from = 0) const { return found(s.find(str.s, from)); }
+    int indexOf(const char* cstr, unsigned int from = 0) const { return found(s.find(cstr, from)); }
+    int lastIndexOf(char c) const { return found(s.rfind(c)); }
+    int lastIndexOf(const String& str) const { return found(s.rfind(str.s)); }
+
+    // Reversed bounds are swapped and the end is clamped to the length
+    String substring(unsigned int left, unsigned int right) const {
+        if (left > right) { unsigned int t = left; left = right; right = t; }
+        if (left >= s.length()) return String();
+        if (right > s.length()) right = (unsigned int)s.length();
+        return String(s.substr(left, right - left));
+    }
+    String substring(unsigned int left) const { return substring(left, (unsigned int)s.length()); }
+
+    void trim() {
+        size_t begin = 0, end = s.length();
+        while (begin < end && isspace((unsigned char)s[begin])) begin++;
+        while (end > begin && isspace((unsigned char)s[end - 1])) end--;
+        s = s.substr(begin, end - begin);
+    }
+    void toLowerCase() { for (size_t i = 0; i < s.length(); i++) s[i] = tolower((unsigned char)s[i]); }
+    void toUpperCase() { for (size_t i = 0; i < s.length(); i++) s[i] = toupper((unsigned char)s[i]); }
+    void replace(const String& from, const String& to) {
+        if (from.s.empty()) return;
+        size_t pos = 0;
+        while ((pos = s.find(from.s, pos)) != std::string::npos) {
+            s.replace(pos, from.s.length(), to.s);
+            pos += to.s.length();
+        }
+    }
+    void remove(unsigned int index) { if (index < s.length()) s.erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < s.length()) s.erase(index, count); }
+
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return (float)atof(s.c_str()); }
+    double toDouble() const { return atof(s.c_str()); }
+
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + (b ? b : "")); }
+    friend String operator+(const char* a, const String& b) { return String((a ? a : "") + b.s); }
+    friend String operator+(const String& a, char c) { return String(a.s + c); }
+    friend String operator+(const String& a, int value) { return a + String(value); }
+    friend String operator+(const String& a, unsigned long value) { return a + String(value); }
+};
+
+/**
+ * Serial over an in-memory byte stream, or over a file descriptor
+ */
+class SerialClass {
+private:
+    std::string rx;
+    size_t rx_head = 0;
+    std::string tx;
+    uint32_t tx_dropped = 0;
+    int fd = -1;
+
+    // Take what the fd has received without blocking
+    void poll_fd() {
+        if (fd < 0) return;
+        char buf[256];
+        ssize_t n;
+        while ((n = ::read(fd, buf, sizeof(buf))) > 0) rx.append(buf, n);
+    }
+
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+    operator bool() const { return true; }
+
+    /**
+     * Receive from and send to a file descriptor from now on
+     * @param new_fd Open fd, e.g. a pty, made non-blocking here (-1: back to memory)
+     */
+    void attach(int new_fd) {
+        fd = new_fd;
+        if (fd >= 0) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    /**
+     * Queue bytes as if they were received
+     */
+    void inject(const void* data, size_t len) {
+        rx.append((const char*)data, len);
+    }
+    void inject(const char* cstr) { inject(cstr, strlen(cstr)); }
+
+    /**
+     * @return Output written since the last call (nothing is kept with an fd attached)
+     */
+    std::string take_output() {
+        std::string out;
+        out.swap(tx);
+        return out;
+    }
+
+    /**
+     * @return Bytes lost because the capture was full
+     */
+    uint32_t get_tx_dropped() const { return tx_dropped; }
+
+    int available() {
+        poll_fd();
+        return (int)(rx.size() - rx_head);
+    }
+
+    int peek() {
+        poll_fd();
+        return rx_head < rx.size() ? (uint8_t)rx[rx_head] : -1;
+    }
+
+    int read() {
+        poll_fd();
+        if (rx_head >= rx.size()) return -1;
+        int c = (uint8_t)rx[rx_head++];
+        if (rx_head == rx.size()) {
+            rx.clear();
+            rx_head = 0;
+        }
+        return c;
+    }
+
+    size_t write(const uint8_t* data, size_t len) {
+        if (fd >= 0) {
+            size_t done = 0;
+            while (done < len) {
+                ssize_t n = ::write(fd, data + done, len - done);
+                if (n > 0) done += n;
+                else if (n < 0 && errno != EAGAIN && errno != EINTR) break;
+            }
+            return done;
+        }
+        size_t room = tx.size() < ARDUINO_COMPAT_TX_CAPTURE ? ARDUINO_COMPAT_TX_CAPTURE - tx.size() : 0;
+        size_t n = len < room ? len : room;
+        tx.append((const char*)data, n);
+        tx_dropped += len - n;
+        return len;
+    }
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const char* cstr) { return write((const uint8_t*)cstr, strlen(cstr)); }
+    void flush() {}
+
+    size_t print(const char* cstr) { return write(cstr); }
+    size_t print(const String& str) { return write((const uint8_t*)str.c_str(), str.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int value) { return print(String(value)); }
+    size_t print(unsigned int value) { return print(String(value)); }
+    size_t print(long value) { return print(String(value)); }
+    size_t print(unsigned long value) { return print(String(value)); }
+    size_t print(double value, int decimals = 2) { return print(String(value, decimals)); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    size_t println(double value, int decimals) { size_t n = print(value, decimals); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[128];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        if (len < 0) return 0;
+        if ((size_t)len < sizeof(buf)) return write((const uint8_t*)buf, len);
+
+        // Longer than the stack buffer, format again into the heap like the ESP32 core
+        std::string big(len + 1, 0);
+        va_start(args, format);
+        vsnprintf(&big[0], big.size(), format, args);
+        va_end(args);
+        return write((const uint8_t*)big.data(), len);
+    }
+};
+extern SerialClass Serial;
 #endif
 
+#endif
@@ -0,0 +1,287 @@
+/*
+ * PowerMonitor - Battery level and charge state for AppState
+ * Reads the battery every few seconds from a source (the ADC divider on
+ * BATTERY_VOLTAGE_ADC_DATA, or a PMU fuel gauge), filters the voltage over
+ * tens of seconds so load steps (panel on, radio bursts) don't move the
+ * level, turns it into a percent with a LiPo open-circuit curve when the
+ * source has no gauge, and holds the shown percent until the filtered one
+ * is clearly past it. The level only goes down while discharging and only
+ * up while charging. Charge state comes from the source, or without one
+ * from steps and the trend of the voltage.
+ *
+ * AppState is updated only when the shown percent or the charge state
+ * changes, so a screen's battery widget redraws a few dozen times per
+ * charge instead of at every sample.
+ *
+ * Usage:
+ *   PowerMonitor power;
+ *   power.begin(power_read_adc);                  // or a PMU, see power_read_pmu()
+ *   appState->setPowerChangeCallback(on_power);   // level 0-100, charging
+ *   loop:
+ *     power.update();
+ *   PMU interrupt: power.requestSample();
+ */
+
+#ifndef POWER_MONITOR_H
+#define POWER_MONITOR_H
+
+#include <stdint.h>
+#include "ArduinoCompat.h"
+#include "AppState.h"
+
+// Time between two readings
+#ifndef POWER_SAMPLE_INTERVAL_MS
+#define POWER_SAMPLE_INTERVAL_MS 2000
+#endif
+
+// Time constant of the voltage filter
+#ifndef POWER_FILTER_TAU_MS
+#define POWER_FILTER_TAU_MS 30000
+#endif
+
+// How far (in percent) the filtered level must be past the shown one to change it
+#ifndef POWER_HYSTERESIS_PCT
+#define POWER_HYSTERESIS_PCT 1.0f
+#endif
+
+// A move against the charge direction bigger than this is shown anyway (a wrong start)
+#ifndef POWER_REVERSE_PCT
+#define POWER_REVERSE_PCT 8.0f
+#endif
+
+// A reading this far from the filter is a spike, or with the next one a step (charger plugged/unplugged)
+#ifndef POWER_STEP_MV
+#define POWER_STEP_MV 40
+#endif
+
+// Readings in a row past POWER_STEP_MV that restart the filter without a charger change (a long heavy load)
+#ifndef POWER_STEP_HOLD
+#define POWER_STEP_HOLD 5
+#endif
+
+// Without a charge state from the source: voltage change over POWER_TREND_MS for charging/discharging
+#ifndef POWER_TREND_MS
+#define POWER_TREND_MS 60000
+#endif
+#ifndef POWER_TREND_UP_MV
+#define POWER_TREND_UP_MV 8
+#endif
+#ifndef POWER_TREND_DOWN_MV
+#define POWER_TREND_DOWN_MV 6
+#endif
+
+// ADC source: pin, divider ratio and readings averaged per sample
+#ifndef POWER_ADC_PIN
+#ifdef BATTERY_VOLTAGE_ADC_DATA
+#define POWER_ADC_PIN BATTERY_VOLTAGE_ADC_DATA
+#else
+#define POWER_ADC_PIN 4
+#endif
+#endif
+#ifndef POWER_ADC_DIVIDER
+#define POWER_ADC_DIVIDER 2
+#endif
+#ifndef POWER_ADC_OVERSAMPLE
+#define POWER_ADC_OVERSAMPLE 8
+#endif
+
+/**
+ * One reading of the battery
+ */
+struct PowerSample {
+    uint16_t millivolts;    // 0: unknown
+    int8_t percent;         // Fuel gauge, -1: none (worked out from the voltage)
+    int8_t charging;        // 1 or 0, -1: unknown (worked out from the voltage)
+};
+
+/**
+ * Read the battery
+ * @return false if it couldn't be read, the sample is skipped
+ */
+typedef bool (*PowerSource)(PowerSample* out);
+
+/**
+ * Open-circuit voltage of a 1S LiPo in steps of 5%, 0% to 100%
+ */
+static const uint16_t power_ocv_mv[21] = {
+    3300, 3500, 3600, 3650, 3690, 3710, 3730, 3750, 3770, 3790, 3810,
+    3830, 3860, 3890, 3920, 3950, 3990, 4030, 4070, 4120, 4180,
+};
+
+static inline float power_percent_from_mv(float mv) {
+    if (mv <= power_ocv_mv[0]) return 0;
+    if (mv >= power_ocv_mv[20]) return 100;
+    int i = 1;
+    while (mv > power_ocv_mv[i]) i++;
+    float lo = power_ocv_mv[i - 1];
+    return (i - 1) * 5 + 5 * (mv - lo) / (power_ocv_mv[i] - lo);
+}
+
+#ifdef ARDUINO
+/**
+ * Battery voltage from the ADC divider, no gauge and no charge state
+ */
+static inline bool power_read_adc(PowerSample* out) {
+    uint32_t sum = 0;
+    for (int i = 0; i < POWER_ADC_OVERSAMPLE; i++) {
+        sum += analogReadMilliVolts(POWER_ADC_PIN);
+    }
+    out->millivolts = (uint16_t)(sum * POWER_ADC_DIVIDER / POWER_ADC_OVERSAMPLE);
+    out->percent = -1;
+    out->charging = -1;
+    return out->millivolts != 0;
+}
+#endif
+
+/**
+ * Battery from a PMU of XPowersLib (gauge, voltage and charge state)
+ * With XPowersAXP2101::setSnapshotMaxAge() this costs one snapshot read.
+ *   power.begin([](PowerSample* s) { return power_read_pmu(pmu, s); });
+ */
+template <class PMU>
+static inline bool power_read_pmu(PMU& pmu, PowerSample* out) {
+    if (!pmu.isBatteryConnect()) return false;
+    int percent = pmu.getBatteryPercent();
+    out->millivolts = pmu.getBattVoltage();
+    out->percent = percent >= 0 && percent <= 100 ? (int8_t)percent : -1;
+    out->charging = pmu.isCharging() ? 1 : 0;
+    return true;
+}
+
+class PowerMonitor {
+private:
+    AppState* appState;
+    PowerSource source = nullptr;
+    bool sampleRequested = false;
+    uint32_t lastSampleMs = 0;
+    uint32_t samples = 0;
+
+    float filteredMv = 0;
+    float filteredPct = 0;
+    int8_t stepSign = 0;         // Direction of the readings past POWER_STEP_MV
+    uint8_t stepCount = 0;       // How many in a row
+    bool charging = false;
+    uint32_t trendStartMs = 0;
+    float trendStartMv = 0;
+    uint8_t trendUp = 0;         // Windows in a row the voltage rose
+
+    int shownPct = -1;           // -1: nothing published yet
+    bool shownCharging = false;
+    uint32_t publishes = 0;
+
+    void restartFilter(const PowerSample& s, uint32_t now) {
+        filteredMv = s.millivolts;
+        filteredPct = s.percent >= 0 ? s.percent : power_percent_from_mv(filteredMv);
+        trendStartMs = now;
+        trendStartMv = filteredMv;
+        trendUp = 0;
+        stepSign = 0;
+        stepCount = 0;
+    }
+
+    // A charge state worked out from the voltage: steps at once, slopes over POWER_TREND_MS.
+    // Rising takes two windows, the cell recovering after a load (panel off) takes one.
+    void followTrend(uint32_t now) {
+        if (now - trendStartMs < POWER_TREND_MS) return;
+        float change = filteredMv - trendStartMv;
+        trendUp = change >= POWER_TREND_UP_MV ? trendUp + 1 : 0;
+        if (trendUp >= 2) charging = true;
+        else if (change <= -POWER_TREND_DOWN_MV) charging = false;
+        trendStartMs = now;
+        trendStartMv = filteredMv;
+    }
+
+    void filter(const PowerSample& s, uint32_t now, uint32_t dt) {
+        float diff = (float)s.millivolts - filteredMv;
+        if (diff > POWER_STEP_MV || diff < -POWER_STEP_MV) {
+            int8_t sign = diff > 0 ? 1 : -1;
+            stepCount = stepSign == sign ? stepCount + 1 : 1;
+            stepSign = sign;
+            // Up while discharging or down while charging: a charger came or went if the next reading agrees.
+            // Otherwise spikes, wait longer.
+            bool chargerStep = s.charging < 0 && (sign > 0) != charging;
+            if (stepCount < (chargerStep ? 2 : POWER_STEP_HOLD)) return;
+            if (chargerStep) charging = sign > 0;
+            restartFilter(s, now);
+            return;
+        }
+        stepSign = 0;
+        stepCount = 0;
+
+        float alpha = (float)dt / (POWER_FILTER_TAU_MS + dt);
+        filteredMv += alpha * diff;
+        if (s.percent >= 0) {
+            filteredPct += alpha * (s.percent - filteredPct);
+        } else {
+            filteredPct = power_percent_from_mv(filteredMv);
+        }
+        if (s.charging < 0) followTrend(now);
+    }
+
+    // Percent to show: past the hysteresis, and only in the direction of the charge
+    int nextShownPct() {
+        if (shownPct < 0 || charging != shownCharging) return (int)(filteredPct + 0.5f);
+        float diff = filteredPct - shownPct;
+        if (diff < 0.5f + POWER_HYSTERESIS_PCT && diff > -0.5f - POWER_HYSTERESIS_PCT) return shownPct;
+        bool reverse = charging ? diff < 0 : diff > 0;
+        if (reverse && diff < POWER_REVERSE_PCT && diff > -POWER_REVERSE_PCT) return shownPct;
+        return (int)(filteredPct + 0.5f);
+    }
+
+public:
+    PowerMonitor() {
+        appState = AppState::getInstance();
+    }
+
+    void begin(PowerSource readFn) {
+        source = readFn;
+        samples = 0;
+        shownPct = -1;
+        sampleRequested = true;
+    }
+
+    /**
+     * Read the battery now instead of at the next interval (charger or PMU interrupt)
+     */
+    void requestSample() {
+        sampleRequested = true;
+    }
+
+    /**
+     * Take a sample when one is due and publish a changed level to AppState
+     * @return true if AppState was updated
+     */
+    bool update(uint32_t now = millis()) {
+        if (!source) return false;
+        if (!sampleRequested && now - lastSampleMs < POWER_SAMPLE_INTERVAL_MS) return false;
+        sampleRequested = false;
+        uint32_t dt = now - lastSampleMs;
+        lastSampleMs = now;
+
+        PowerSample s;
+        if (!source(&s) || s.millivolts == 0) return false;
+        bool chargingBefore = charging;
+        if (s.charging >= 0) charging = s.charging != 0;
+        if (samples++ == 0 || charging != chargingBefore) {
+            restartFilter(s, now);
+        } else {
+            filter(s, now, dt);
+        }
+
+        int pct = nextShownPct();
+        if (pct < 0) pct = 0;
+        if (pct > 100) pct = 100;
+        if (pct == shownPct && charging == shownCharging) return false;
+        shownPct = pct;
+        shownCharging = charging;
+        publishes++;
+        appState->updatePower((float)pct, charging);
+        return true;
+    }
+
+    float getFilteredMillivolts() { return filteredMv; }
+    float getFilteredPercent() { return filteredPct; }
+    uint32_t getPublishCount() { return publishes; }
+};
+
+#endif
@@ -1,12 +1,12 @@
 /*
  * SerialManager - Handle serial communication
- * Format: JSON messages like {"screen": 2} or {"data": "value"}
+ * Format: JSON messages like {"screen": 2}, {"progress": 42} or {"data": "value"}
  */
 
 #ifndef SERIAL_MANAGER_H
 #define SERIAL_MANAGER_H
 
-#include <Arduino.h>
+#include "ArduinoCompat.h"
 #include "AppState.h"
 
 class SerialManager {
@@ -73,9 +73,11 @@ public:
             if (c == '\n' || c == '\r') {
                 if (rxBuffer.length() > 0) {
                     handleMessage(rxBuffer);
+                    latency_trace_end();
                     rxBuffer = "";
                 }
             } else {
+                if (rxBuffer.length() == 0) latency_trace_begin();
                 rxBuffer += c;
                 if (rxBuffer.length() > 512) {
                     Serial.println("ERR: Buffer overflow");
@@ -88,9 +90,21 @@ public:
     void handleMessage(String msg) {
         msg.trim();
         
-        // Simple number format: just "0" to "10"
-        if (msg.length() <= 2 && msg.toInt() >= 0 && msg.toInt() <= 10) {
+        // Dump the latency trace: "TRACE"
+        if (msg == "TRACE") {
+#if LATENCY_TRACE_ENABLED
+            latency_trace_dump();
+#else
+            Serial.println("ERR: Build with -DLATENCY_TRACE_ENABLED=1");
+#endif
+            return;
+        }
+        
+        // Simple number format: just "0" to "10" (toInt() is 0 for a line without digits too)
+        if (msg.length() >= 1 && msg.length() <= 2 && isdigit((unsigned char)msg[0]) &&
+            (msg.length() == 1 || isdigit((unsigned char)msg[1])) && msg.toInt() <= 10) {
             int screenId = msg.toInt();
+            latency_trace_parsed();
             appState->changeScreen((ScreenID)screenId);
             Serial.printf("OK: Switched to Screen %d\n", screenId);
             return;
@@ -111,6 +125,7 @@ public:
                 
                 // Validate bounds (466x466 display)
                 if (x >= 0 && x < 466 && y >= 0 && y < 466) {
+                    latency_trace_parsed();
                     appState->updateTargetPosition(x, y);
                     // Don't spam serial with tracking updates
                     return;
@@ -127,6 +142,7 @@ public:
             if (screenValue.length() > 0) {
                 int screenId = screenValue.toInt();
                 if (screenId >= 1 && screenId <= 10) {
+                    latency_trace_parsed();
                     appState->changeScreen((ScreenID)(screenId - 1));  // Convert 1-based to 0-based
                     Serial.println("OK: Screen changed to " + String(screenId));
                 } else {
@@ -135,6 +151,21 @@ public:
             }
         }
         
+        // Parse processing progress: {"progress": 42}
+        if (msg.indexOf("progress") != -1) {
+            String progressValue = parseJsonValue(msg, "progress");
+            if (progressValue.length() > 0) {
+                int percent = progressValue.toInt();
+                if (percent >= 0 && percent <= 100) {
+                    latency_trace_parsed();
+                    appState->updateProgress((uint8_t)percent);
+                    Serial.println("OK: Progress " + String(percent) + "%");
+                } else {
+                    Serial.println("ERR: Progress must be 0-100");
+                }
+            }
+        }
+        
         // Parse other data fields
         if (msg.indexOf("data") != -1) {
             String dataValue = parseJsonValue(msg, "data");
@@ -5,13 +5,7 @@
 #ifndef STATE_TYPES_H
 #define STATE_TYPES_H
 
-#ifdef ARDUINO
-#include <Arduino.h>
-#else
-#include <stdint.h>
-#include <stdbool.h>
-typedef struct { const char* data; int len; } String; // Dummy for simulator
-#endif
+#include "ArduinoCompat.h"
 
 // Screen identifiers
 enum ScreenID {
@@ -45,6 +39,10 @@ struct AppStateData {
     bool trackingActive;
     unsigned long lastTrackingUpdate;
     
+    // Processing progress in percent (for Screen 7), inactive until the first update
+    uint8_t progress;
+    bool progressActive;
+    
     // Add your custom data fields
     String customData1;
     float customData2;
@@ -0,0 +1,416 @@
+/*
+ * Circular Text - Flow text into the round panel line by line
+ * A wrapped label has one width, so on the circle the lines near the top or
+ * bottom edge get clipped while the ones across the middle waste space.
+ * Here every line is broken to the chord available at its own line box
+ * (the edge farther from the center), in one pass over the text (only the
+ * word moved to a new line is measured again) using a table of glyph
+ * advances (kerning included) per font. The result is the text with the
+ * line breaks inserted, shown by a label that doesn't wrap.
+ *
+ * Layouts are cached by (text hash, font, top Y, letter space), so
+ * re-applying a status string already seen costs a hash and a compare
+ * instead of measuring it again.
+ *
+ * Usage:
+ *   lv_obj_t* label = lv_label_create(screen);
+ *   lv_obj_set_style_text_font(label, font, 0);
+ *   circular_text_set_top(label, y);          // top of the first line
+ *   circular_text_set(label, "Connecting to WiFi...");
+ */
+
+#ifndef CIRCULAR_TEXT_H
+#define CIRCULAR_TEXT_H
+
+#include <lvgl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "DisplayUtils.h"
+
+// Layouts kept for re-use (a screen's status strings repeat)
+#ifndef CIRCULAR_TEXT_CACHE_SIZE
+#define CIRCULAR_TEXT_CACHE_SIZE 16
+#endif
+
+// Fonts with a glyph advance table (95x96 bytes each, in PSRAM)
+#ifndef CIRCULAR_TEXT_FONT_CNT
+#define CIRCULAR_TEXT_FONT_CNT 4
+#endif
+
+// Narrowest line even at the very top or bottom of the circle
+#ifndef CIRCULAR_TEXT_MIN_WIDTH
+#define CIRCULAR_TEXT_MIN_WIDTH 100
+#endif
+
+// Marks the labels laid out by circular_text_set()
+#define CIRCULAR_TEXT_FLAG LV_OBJ_FLAG_USER_1
+
+// Advances of the printable ASCII letters, followed by any of them or a line end
+#define CIRCULAR_TEXT_ADV_FIRST 0x20
+#define CIRCULAR_TEXT_ADV_CNT 95
+#define CIRCULAR_TEXT_ADV_COLS (CIRCULAR_TEXT_ADV_CNT + 1)
+#define CIRCULAR_TEXT_ADV_NONE 0xFF  // Doesn't fit into a byte, ask the font
+
+typedef struct {
+    const char* text;      // The text with the line breaks inserted
+    lv_coord_t width;      // Widest line
+    lv_coord_t height;
+    uint16_t line_cnt;
+    bool fits;             // Every line is inside the circle
+} circular_text_layout_t;
+
+/**
+ * Counters since the last circular_text_reset_stats()
+ */
+typedef struct {
+    uint32_t hits;         // Layouts found in the cache
+    uint32_t misses;       // Layouts computed
+    uint32_t evictions;
+    uint32_t tables;       // Glyph advance tables built
+} circular_text_stats_t;
+
+typedef struct {
+    circular_text_layout_t layout;
+    char* src;             // The original text to rule out hash collisions
+    uint32_t hash;
+    const lv_font_t* font;
+    int16_t top_y;
+    int16_t letter_space;
+    int16_t line_space;
+    uint32_t last_use;
+} circular_text_entry_t;
+
+typedef struct {
+    const lv_font_t* font;
+    uint8_t* adv;          // CIRCULAR_TEXT_ADV_CNT rows of CIRCULAR_TEXT_ADV_COLS
+} circular_text_font_t;
+
+static circular_text_entry_t circular_text_cache[CIRCULAR_TEXT_CACHE_SIZE];
+static circular_text_font_t circular_text_fonts[CIRCULAR_TEXT_FONT_CNT];
+static circular_text_stats_t circular_text_stats;
+static uint32_t circular_text_use_cnt;
+static uint32_t circular_text_next_font;
+
+static inline uint32_t circular_text_hash(const char* text) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    while (*text) {
+        h ^= (uint8_t)*text++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * Get the advance table of a font, build it on the first use
+ * @return The table or NULL if it couldn't be allocated
+ */
+static inline const uint8_t* circular_text_get_adv(const lv_font_t* font) {
+    for (int i = 0; i < CIRCULAR_TEXT_FONT_CNT; i++) {
+        if (circular_text_fonts[i].font == font) return circular_text_fonts[i].adv;
+    }
+
+    uint8_t* adv = (uint8_t*)lv_mem_alloc_large(CIRCULAR_TEXT_ADV_CNT * CIRCULAR_TEXT_ADV_COLS);
+    if (adv == NULL) return NULL;
+
+    for (uint32_t c = 0; c < CIRCULAR_TEXT_ADV_CNT; c++) {
+        uint8_t* row = adv + c * CIRCULAR_TEXT_ADV_COLS;
+        for (uint32_t n = 0; n < CIRCULAR_TEXT_ADV_COLS; n++) {
+            uint32_t next = n < CIRCULAR_TEXT_ADV_CNT ? CIRCULAR_TEXT_ADV_FIRST + n : 0;
+            uint16_t w = lv_font_get_glyph_width(font, CIRCULAR_TEXT_ADV_FIRST + c, next);
+            row[n] = w < CIRCULAR_TEXT_ADV_NONE ? (uint8_t)w : CIRCULAR_TEXT_ADV_NONE;
+        }
+    }
+
+    // Replace the fonts round robin, the screens use only a few
+    circular_text_font_t* slot = &circular_text_fonts[circular_text_next_font];
+    circular_text_next_font = (circular_text_next_font + 1) % CIRCULAR_TEXT_FONT_CNT;
+    if (slot->adv) lv_mem_free(slot->adv);
+    slot->font = font;
+    slot->adv = adv;
+    circular_text_stats.tables++;
+    return adv;
+}
+
+/**
+ * Advance of a letter like lv_font_get_glyph_width() but from the table if possible
+ */
+static inline uint16_t circular_text_glyph_w(const lv_font_t* font, const uint8_t* adv,
+                                             uint32_t letter, uint32_t next) {
+    if (adv && letter >= CIRCULAR_TEXT_ADV_FIRST && letter < CIRCULAR_TEXT_ADV_FIRST + CIRCULAR_TEXT_ADV_CNT) {
+        int32_t col = -1;
+        if (next >= CIRCULAR_TEXT_ADV_FIRST && next < CIRCULAR_TEXT_ADV_FIRST + CIRCULAR_TEXT_ADV_CNT) {
+            col = next - CIRCULAR_TEXT_ADV_FIRST;
+        } else if (next == '\0' || next == '\n' || next == '\r') {
+            col = CIRCULAR_TEXT_ADV_CNT;
+        }
+        if (col >= 0) {
+            uint8_t w = adv[(letter - CIRCULAR_TEXT_ADV_FIRST) * CIRCULAR_TEXT_ADV_COLS + col];
+            if (w != CIRCULAR_TEXT_ADV_NONE) return w;
+        }
+    }
+    return lv_font_get_glyph_width(font, letter, next);
+}
+
+/**
+ * Width available for a line box: the chord at its edge farther from the center
+ * @param top Top of the line box
+ * @param h Height of the line box
+ * @param raw_out The chord itself (0 outside the circle)
+ * @return Width for the text, with the safe margin on both sides
+ */
+static inline lv_coord_t circular_text_line_width(lv_coord_t top, lv_coord_t h, lv_coord_t* raw_out) {
+    lv_coord_t dy_top = abs(top - DISPLAY_CENTER_Y);
+    lv_coord_t dy_bottom = abs(top + h - DISPLAY_CENTER_Y);
+    lv_coord_t dy = dy_top > dy_bottom ? dy_top : dy_bottom;
+
+    lv_coord_t raw = display_max_width_at_y(DISPLAY_CENTER_Y + dy);
+    *raw_out = raw;
+
+    lv_coord_t w = raw - 2 * display_get_safe_margin();
+    return w < CIRCULAR_TEXT_MIN_WIDTH ? CIRCULAR_TEXT_MIN_WIDTH : w;
+}
+
+/**
+ * Break the text into lines in one pass. Lines are broken at the last space
+ * (replaced by the line break) or inside a word if it doesn't fit alone.
+ * The broken text is laid out the same again.
+ * @param out Buffer for the broken text, at least 2 * strlen(text) + 1 bytes
+ */
+static inline void circular_text_flow(const char* text, const lv_font_t* font, lv_coord_t top_y,
+                                      lv_coord_t letter_space, lv_coord_t line_space,
+                                      char* out, circular_text_layout_t* layout) {
+    const uint8_t* adv = circular_text_get_adv(font);
+    lv_coord_t line_h = lv_font_get_line_height(font);
+
+    lv_coord_t raw;
+    lv_coord_t avail = circular_text_line_width(top_y, line_h, &raw);
+    layout->fits = raw > 0;
+    layout->width = 0;
+    layout->line_cnt = 1;
+
+    uint32_t out_len = 0;
+    lv_coord_t w = 0;          // Width of the line with the letter space after the last letter
+    uint32_t prev = 0;         // The last letter on the line
+    lv_coord_t prev_w = 0;     // and its advance (followed by the current letter)
+
+    // The last space on the line
+    int32_t space_pos = -1;
+    lv_coord_t space_w_before = 0;  // Line width before the letter ahead of the space
+    uint32_t space_prev = 0;        // The letter ahead of the space
+    uint32_t space_next = 0;        // Index of the letter after the space in text
+
+    uint32_t i = 0;
+    uint32_t letter;
+    uint32_t next;
+    while (text[i] != '\0') {
+        uint32_t start = i;
+        _lv_txt_encoded_letter_next_2(text, &letter, &next, &i);
+
+        lv_coord_t letter_w = letter == '\n' ? 0 : circular_text_glyph_w(font, adv, letter, next);
+        lv_coord_t end_w = 0;  // Width of a finished line
+        bool brk = false;
+        bool restart = false;
+        int32_t insert_pos = -1;
+
+        if (letter == '\n') {
+            end_w = w > 0 ? w - letter_space : 0;
+            brk = true;
+        } else {
+            if (w > 0 && w + letter_w > avail) {
+                if (space_pos >= 0) {
+                    // The new line starts after the space, its letters are measured again as it can be narrower
+                    out[space_pos] = '\n';
+                    end_w = space_w_before;
+                    if (space_prev) end_w += circular_text_glyph_w(font, adv, space_prev, '\n');
+                    out_len = space_pos + 1;
+                    i = space_next;
+                    restart = true;
+                } else {
+                    // Break the word before this letter
+                    end_w = w - letter_space;
+                    if (prev_w > 0) end_w += circular_text_glyph_w(font, adv, prev, '\n') - prev_w;
+                    insert_pos = out_len;
+                    w = 0;
+                }
+                brk = true;
+            }
+        }
+
+        if (brk) {
+            if (end_w > layout->width) layout->width = end_w;
+            if (end_w > raw) layout->fits = false;
+
+            lv_coord_t top = top_y + layout->line_cnt * (line_h + line_space);
+            avail = circular_text_line_width(top, line_h, &raw);
+            if (raw == 0) layout->fits = false;
+            layout->line_cnt++;
+            space_pos = -1;
+
+            if (insert_pos >= 0) out[out_len++] = '\n';
+        }
+
+        if (!restart) {
+            while (start < i) out[out_len++] = text[start++];
+        }
+
+        if (letter == '\n' || restart) {
+            w = 0;
+            prev = 0;
+            prev_w = 0;
+            continue;
+        }
+
+        if (letter == ' ') {
+            space_pos = out_len - 1;
+            space_prev = prev;
+            space_w_before = w - (prev_w > 0 ? prev_w + letter_space : 0);
+            space_next = i;
+        }
+        if (letter_w > 0) w += letter_w + letter_space;
+        prev = letter;
+        prev_w = letter_w;
+    }
+    out[out_len] = '\0';
+
+    lv_coord_t end_w = w > 0 ? w - letter_space : 0;
+    if (end_w > layout->width) layout->width = end_w;
+    if (end_w > raw) layout->fits = false;
+
+    layout->text = out;
+    layout->height = layout->line_cnt * line_h + (layout->line_cnt - 1) * line_space;
+}
+
+/**
+ * Get the layout of a text from the cache or compute it
+ * @param text The text, line breaks in it are kept
+ * @param font Font of the text
+ * @param top_y Top of the first line on the display
+ * @param letter_space Letter space of the label
+ * @param line_space Line space of the label
+ * @return The layout (valid until the next call) or NULL on out of memory
+ */
+static inline const circular_text_layout_t* circular_text_layout(const char* text, const lv_font_t* font,
+                                                                 lv_coord_t top_y, lv_coord_t letter_space,
+                                                                 lv_coord_t line_space) {
+    uint32_t hash = circular_text_hash(text);
+    circular_text_entry_t* lru = &circular_text_cache[0];
+
+    for (int i = 0; i < CIRCULAR_TEXT_CACHE_SIZE; i++) {
+        circular_text_entry_t* e = &circular_text_cache[i];
+        if (e->src && e->hash == hash && e->font == font && e->top_y == top_y &&
+            e->letter_space == letter_space && e->line_space == line_space && strcmp(e->src, text) == 0) {
+            e->last_use = ++circular_text_use_cnt;
+            circular_text_stats.hits++;
+            return &e->layout;
+        }
+        if (e->src == NULL || (lru->src && e->last_use < lru->last_use)) lru = e;
+    }
+
+    // The original text followed by the broken one, at most one break per letter
+    size_t len = strlen(text);
+    char* buf = (char*)lv_mem_alloc(len + 1 + 2 * len + 1);
+    if (buf == NULL) return NULL;
+    memcpy(buf, text, len + 1);
+
+    if (lru->src) {
+        lv_mem_free(lru->src);
+        circular_text_stats.evictions++;
+    }
+    lru->src = buf;
+    lru->hash = hash;
+    lru->font = font;
+    lru->top_y = top_y;
+    lru->letter_space = letter_space;
+    lru->line_space = line_space;
+    lru->last_use = ++circular_text_use_cnt;
+    circular_text_flow(text, font, top_y, letter_space, line_space, buf + len + 1, &lru->layout);
+    circular_text_stats.misses++;
+    return &lru->layout;
+}
+
+/**
+ * Set the top of the first line of a label laid out by circular_text_set()
+ * The label is centered horizontally on a full screen parent.
+ */
+static inline void circular_text_set_top(lv_obj_t* label, lv_coord_t y) {
+    lv_obj_add_flag(label, CIRCULAR_TEXT_FLAG);
+    lv_label_set_long_mode(label, LV_LABEL_LONG_CLIP);
+    lv_obj_set_style_text_align(label, LV_TEXT_ALIGN_CENTER, 0);
+    lv_obj_align(label, LV_ALIGN_TOP_MID, 0, y);
+}
+
+/**
+ * Set the text of a label flowed into the circle
+ * @param label A label prepared with circular_text_set_top()
+ * @param text The new text
+ * @return The layout or NULL if it couldn't be computed (the text is set as it is)
+ */
+static inline const circular_text_layout_t* circular_text_set(lv_obj_t* label, const char* text) {
+    const lv_font_t* font = lv_obj_get_style_text_font(label, LV_PART_MAIN);
+    lv_coord_t letter_space = lv_obj_get_style_text_letter_space(label, LV_PART_MAIN);
+    lv_coord_t line_space = lv_obj_get_style_text_line_space(label, LV_PART_MAIN);
+    lv_coord_t top_y = lv_obj_get_style_y(label, LV_PART_MAIN);
+
+    const circular_text_layout_t* layout = circular_text_layout(text, font, top_y, letter_space, line_space);
+    if (layout == NULL) {
+        lv_label_set_text(label, text);
+        return NULL;
+    }
+
+    // The label wraps at its width only if a line is wider, leave room for the trailing letter space
+    lv_obj_set_size(label, layout->width + (letter_space > 0 ? letter_space : 0), layout->height);
+    lv_label_set_text(label, layout->text);
+    return layout;
+}
+
+/**
+ * Check if a label is laid out by circular_text_set()
+ */
+static inline bool circular_text_is_flowed(lv_obj_t* label) {
+    return lv_obj_has_flag(label, CIRCULAR_TEXT_FLAG);
+}
+
+/**
+ * Check if every line of a label laid out by circular_text_set() is inside the circle
+ */
+static inline bool circular_text_fits(lv_obj_t* label) {
+    // The text already has the line breaks so it's laid out the same again. Not through the cache:
+    // the broken text would take the place of a layout circular_text_set() can use.
+    const char* text = lv_label_get_text(label);
+    char* out = (char*)lv_mem_buf_get(2 * strlen(text) + 1);
+    if (out == NULL) return false;
+
+    circular_text_layout_t layout;
+    circular_text_flow(text, lv_obj_get_style_text_font(label, LV_PART_MAIN), lv_obj_get_style_y(label, LV_PART_MAIN),
+                       lv_obj_get_style_text_letter_space(label, LV_PART_MAIN),
+                       lv_obj_get_style_text_line_space(label, LV_PART_MAIN), out, &layout);
+    lv_mem_buf_release(out);
+    return layout.fits;
+}
+
+/**
+ * Drop the cached layouts and advance tables (e.g. after unloading a font)
+ */
+static inline void circular_text_clean() {
+    for (int i = 0; i < CIRCULAR_TEXT_CACHE_SIZE; i++) {
+        if (circular_text_cache[i].src) lv_mem_free(circular_text_cache[i].src);
+        circular_text_cache[i].src = NULL;
+    }
+    for (int i = 0; i < CIRCULAR_TEXT_FONT_CNT; i++) {
+        if (circular_text_fonts[i].adv) lv_mem_free(circular_text_fonts[i].adv);
+        circular_text_fonts[i].adv = NULL;
+        circular_text_fonts[i].font = NULL;
+    }
+}
+
+static inline circular_text_stats_t circular_text_get_stats() {
+    return circular_text_stats;
+}
+
+static inline void circular_text_reset_stats() {
+    memset(&circular_text_stats, 0, sizeof(circular_text_stats));
+}
+
+#endif // CIRCULAR_TEXT_H
@@ -0,0 +1,317 @@
+/*
+ * Frame Diff - Send only the tiles that really changed to the panel
+ * LVGL re-renders every invalidated area, but often to the same pixels
+ * (a ring tick restyled to the same color, a 0 opacity overlay, a target
+ * moving back and forth). The panel is split into 32x8 tiles; every flushed
+ * tile is hashed and compared to the hash of what the panel shows.
+ * Unchanged tiles are not transmitted over QSPI.
+ *
+ * Optionally a mirror of the panel contents is kept in PSRAM to confirm the
+ * hash matches byte by byte, so a hash collision can never leave a stale tile.
+ *
+ * Usage:
+ *   frame_diff_init(LCD_WIDTH, LCD_HEIGHT, send_cb, true);
+ *   disp_drv.rounder_cb = frame_diff_rounder;   // align areas to the tiles
+ *   flush_cb: frame_diff_flush(area, color_p); lv_disp_flush_ready(disp);
+ */
+
+#ifndef FRAME_DIFF_H
+#define FRAME_DIFF_H
+
+#include <lvgl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Set to 1 (e.g. with -DFRAME_DIFF_ENABLED=1) to skip the unchanged tiles, 0 flushes every area as it is
+#ifndef FRAME_DIFF_ENABLED
+#define FRAME_DIFF_ENABLED 0
+#endif
+
+// Print the counters over Serial this often (0: never)
+#ifndef FRAME_DIFF_LOG_INTERVAL_MS
+#define FRAME_DIFF_LOG_INTERVAL_MS 0
+#endif
+
+#define FRAME_DIFF_TILE_W 32
+#define FRAME_DIFF_TILE_H 8
+
+// Allocator of the panel mirror (~424 KB for 466x466)
+#ifndef FRAME_DIFF_MIRROR_ALLOC
+#if defined(ARDUINO) && defined(BOARD_HAS_PSRAM)
+#define FRAME_DIFF_MIRROR_ALLOC(size) ps_malloc(size)
+#else
+#define FRAME_DIFF_MIRROR_ALLOC(size) malloc(size)
+#endif
+#endif
+
+/**
+ * Sends a contiguous block of RGB565 pixels to the panel
+ * (e.g. gfx->draw16bitRGBBitmap(x, y, pixels, w, h))
+ */
+typedef void (*frame_diff_send_cb_t)(int32_t x, int32_t y, uint32_t w, uint32_t h, uint16_t* pixels);
+
+/**
+ * Counters since the last frame_diff_reset_stats()
+ */
+typedef struct {
+    uint32_t flushes;          // Flushed areas
+    uint32_t tiles_checked;    // Tiles in the flushed areas
+    uint32_t tiles_skipped;    // Tiles not sent because they didn't change
+    uint32_t hash_collisions;  // Hash matched but the mirror differed (sent anyway)
+    uint32_t windows_sent;     // Calls of the send callback
+    uint32_t bytes_sent;
+    uint32_t bytes_skipped;
+    uint32_t unhashed_flushes; // Areas sent whole because the hashes couldn't be allocated
+    uint32_t unverified_skips; // Tiles skipped on the hash alone because the mirror couldn't be allocated
+} frame_diff_stats_t;
+
+typedef struct {
+    uint16_t hor_res;
+    uint16_t ver_res;
+    uint16_t cols;
+    uint16_t rows;
+    uint32_t* hashes;          // Hash of every tile on the panel, 0: unknown
+    uint16_t* mirror;          // Panel contents or NULL to trust the hashes
+    uint16_t* scratch;         // One band of tiles to send partial bands contiguously
+    uint8_t* changed;          // Changed flags of the tiles of the current band
+    bool mirror_wanted;        // Mirror requested in frame_diff_init()
+    frame_diff_send_cb_t send_cb;
+    frame_diff_stats_t stats;
+} frame_diff_t;
+
+static frame_diff_t frame_diff;
+
+// ============================================================================
+// INTERNAL HELPERS
+// ============================================================================
+
+/**
+ * FNV-1a over pixel pairs. Never returns 0 (reserved for "unknown")
+ */
+static inline uint32_t frame_diff_hash(const uint16_t* px, uint32_t stride, uint32_t w, uint32_t h) {
+    uint32_t hash = 2166136261u;
+    for (uint32_t y = 0; y < h; y++) {
+        const uint16_t* row = px + y * stride;
+        uint32_t x = 0;
+        for (; x + 1 < w; x += 2) {
+            hash = (hash ^ (row[x] | ((uint32_t)row[x + 1] << 16))) * 16777619u;
+        }
+        if (x < w) hash = (hash ^ row[x]) * 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+static inline bool frame_diff_rows_equal(const uint16_t* a, uint32_t a_stride,
+                                         const uint16_t* b, uint32_t b_stride, uint32_t w, uint32_t h) {
+    for (uint32_t y = 0; y < h; y++) {
+        if (memcmp(a + y * a_stride, b + y * b_stride, w * sizeof(uint16_t)) != 0) return false;
+    }
+    return true;
+}
+
+static inline void frame_diff_copy_rows(uint16_t* dest, uint32_t dest_stride,
+                                        const uint16_t* src, uint32_t src_stride, uint32_t w, uint32_t h) {
+    for (uint32_t y = 0; y < h; y++) {
+        memcpy(dest + y * dest_stride, src + y * src_stride, w * sizeof(uint16_t));
+    }
+}
+
+static inline void frame_diff_send(int32_t x, int32_t y, uint32_t w, uint32_t h, uint16_t* pixels) {
+    frame_diff.send_cb(x, y, w, h, pixels);
+    frame_diff.stats.windows_sent++;
+    frame_diff.stats.bytes_sent += w * h * sizeof(uint16_t);
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+/**
+ * Allocate the tile hashes (and the mirror)
+ * @param hor_res Panel width
+ * @param ver_res Panel height
+ * @param send_cb Sends pixels to the panel
+ * @param use_mirror Keep a copy of the panel to confirm hash matches
+ * @return false if out of memory: without the hashes frame_diff_flush() sends every area,
+ *         without the mirror it trusts the hashes. The stats count both cases.
+ */
+static inline bool frame_diff_init(uint16_t hor_res, uint16_t ver_res, frame_diff_send_cb_t send_cb, bool use_mirror) {
+    frame_diff.hor_res = hor_res;
+    frame_diff.ver_res = ver_res;
+    frame_diff.cols = (hor_res + FRAME_DIFF_TILE_W - 1) / FRAME_DIFF_TILE_W;
+    frame_diff.rows = (ver_res + FRAME_DIFF_TILE_H - 1) / FRAME_DIFF_TILE_H;
+    frame_diff.send_cb = send_cb;
+    frame_diff.mirror_wanted = use_mirror;
+    memset(&frame_diff.stats, 0, sizeof(frame_diff.stats));
+
+    frame_diff.hashes = (uint32_t*)calloc((size_t)frame_diff.cols * frame_diff.rows, sizeof(uint32_t));
+    frame_diff.scratch = (uint16_t*)malloc((size_t)hor_res * FRAME_DIFF_TILE_H * sizeof(uint16_t));
+    frame_diff.changed = (uint8_t*)malloc(frame_diff.cols);
+    if (!frame_diff.hashes || !frame_diff.scratch || !frame_diff.changed) {
+        free(frame_diff.hashes);
+        free(frame_diff.scratch);
+        free(frame_diff.changed);
+        frame_diff.hashes = NULL;
+        frame_diff.scratch = NULL;
+        frame_diff.changed = NULL;
+        return false;
+    }
+
+    // Without the mirror the hashes are trusted (a collision leaves a stale tile until it changes again)
+    frame_diff.mirror = NULL;
+    if (use_mirror) {
+        frame_diff.mirror = (uint16_t*)FRAME_DIFF_MIRROR_ALLOC((size_t)hor_res * ver_res * sizeof(uint16_t));
+        if (!frame_diff.mirror) return false;
+    }
+
+    return true;
+}
+
+/**
+ * Forget what is on the panel (e.g. after drawing to it without LVGL)
+ */
+static inline void frame_diff_invalidate() {
+    if (frame_diff.hashes) {
+        memset(frame_diff.hashes, 0, (size_t)frame_diff.cols * frame_diff.rows * sizeof(uint32_t));
+    }
+}
+
+/**
+ * Rounder callback: extend the areas to whole tiles so every tile can be hashed.
+ * The tiles start at even coordinates and have even sizes as the CO5300 requires.
+ */
+static inline void frame_diff_rounder(lv_disp_drv_t* disp_drv, lv_area_t* area) {
+    LV_UNUSED(disp_drv);
+    area->x1 = (area->x1 / FRAME_DIFF_TILE_W) * FRAME_DIFF_TILE_W;
+    area->y1 = (area->y1 / FRAME_DIFF_TILE_H) * FRAME_DIFF_TILE_H;
+    area->x2 = (area->x2 / FRAME_DIFF_TILE_W) * FRAME_DIFF_TILE_W + FRAME_DIFF_TILE_W - 1;
+    area->y2 = (area->y2 / FRAME_DIFF_TILE_H) * FRAME_DIFF_TILE_H + FRAME_DIFF_TILE_H - 1;
+    if (frame_diff.hor_res && area->x2 >= frame_diff.hor_res) area->x2 = frame_diff.hor_res - 1;
+    if (frame_diff.ver_res && area->y2 >= frame_diff.ver_res) area->y2 = frame_diff.ver_res - 1;
+}
+
+/**
+ * Send the changed tiles of a rendered area to the panel.
+ * Call it from the flush callback (lv_disp_flush_ready() is not called here).
+ * Bands where every tile changed are merged and sent directly from the draw buffer,
+ * runs of changed tiles in other bands are copied together first.
+ * Tiles only partly covered by the area are always sent.
+ * @param area Flushed area
+ * @param color_p Rendered pixels of the area
+ */
+static inline void frame_diff_flush(const lv_area_t* area, lv_color_t* color_p) {
+    uint16_t* px = (uint16_t*)&color_p->full;
+    int32_t w = area->x2 - area->x1 + 1;
+    int32_t h = area->y2 - area->y1 + 1;
+
+    if (!frame_diff.hashes) {
+        frame_diff.stats.unhashed_flushes++;
+        frame_diff_send(area->x1, area->y1, w, h, px);
+        return;
+    }
+
+    frame_diff.stats.flushes++;
+
+    int32_t col_first = area->x1 / FRAME_DIFF_TILE_W;
+    int32_t col_last = area->x2 / FRAME_DIFF_TILE_W;
+    int32_t row_first = area->y1 / FRAME_DIFF_TILE_H;
+    int32_t row_last = area->y2 / FRAME_DIFF_TILE_H;
+
+    // Consecutive bands where every tile changed: sent in one window
+    int32_t pending_y1 = -1;
+    int32_t pending_y2 = -1;
+
+    for (int32_t row = row_first; row <= row_last; row++) {
+        int32_t tile_y1 = row * FRAME_DIFF_TILE_H;
+        int32_t tile_y2 = LV_MIN(tile_y1 + FRAME_DIFF_TILE_H - 1, frame_diff.ver_res - 1);
+        int32_t band_y1 = LV_MAX(tile_y1, area->y1);
+        int32_t band_y2 = LV_MIN(tile_y2, area->y2);
+        int32_t band_h = band_y2 - band_y1 + 1;
+        bool band_whole = band_y1 == tile_y1 && band_y2 == tile_y2;
+        uint16_t* band_px = px + (band_y1 - area->y1) * w;
+
+        bool all_changed = true;
+        for (int32_t col = col_first; col <= col_last; col++) {
+            int32_t tile_x1 = col * FRAME_DIFF_TILE_W;
+            int32_t tile_x2 = LV_MIN(tile_x1 + FRAME_DIFF_TILE_W - 1, frame_diff.hor_res - 1);
+            int32_t x1 = LV_MAX(tile_x1, area->x1);
+            int32_t x2 = LV_MIN(tile_x2, area->x2);
+            int32_t tile_w = x2 - x1 + 1;
+            const uint16_t* tile_px = band_px + (x1 - area->x1);
+            uint32_t* hash = &frame_diff.hashes[row * frame_diff.cols + col];
+            uint16_t* mirror = frame_diff.mirror ? frame_diff.mirror + band_y1 * frame_diff.hor_res + x1 : NULL;
+
+            bool changed = true;
+            if (band_whole && x1 == tile_x1 && x2 == tile_x2) {
+                uint32_t new_hash = frame_diff_hash(tile_px, w, tile_w, band_h);
+                if (*hash == new_hash) {
+                    changed = mirror && !frame_diff_rows_equal(mirror, frame_diff.hor_res, tile_px, w, tile_w, band_h);
+                    if (changed) frame_diff.stats.hash_collisions++;
+                    else if (!mirror && frame_diff.mirror_wanted) frame_diff.stats.unverified_skips++;
+                }
+                *hash = new_hash;
+            } else {
+                *hash = 0;
+            }
+
+            if (changed) {
+                if (mirror) frame_diff_copy_rows(mirror, frame_diff.hor_res, tile_px, w, tile_w, band_h);
+            } else {
+                frame_diff.stats.tiles_skipped++;
+                frame_diff.stats.bytes_skipped += tile_w * band_h * sizeof(uint16_t);
+                all_changed = false;
+            }
+            frame_diff.changed[col - col_first] = changed;
+            frame_diff.stats.tiles_checked++;
+        }
+
+        if (all_changed) {
+            if (pending_y1 < 0) pending_y1 = band_y1;
+            pending_y2 = band_y2;
+            continue;
+        }
+
+        if (pending_y1 >= 0) {
+            frame_diff_send(area->x1, pending_y1, w, pending_y2 - pending_y1 + 1, px + (pending_y1 - area->y1) * w);
+            pending_y1 = -1;
+        }
+
+        // Send the runs of changed tiles of this band
+        int32_t col = col_first;
+        while (col <= col_last) {
+            if (!frame_diff.changed[col - col_first]) {
+                col++;
+                continue;
+            }
+            int32_t run_first = col;
+            while (col <= col_last && frame_diff.changed[col - col_first]) col++;
+
+            int32_t x1 = LV_MAX(run_first * FRAME_DIFF_TILE_W, area->x1);
+            int32_t x2 = LV_MIN(col * FRAME_DIFF_TILE_W - 1, area->x2);
+            int32_t run_w = x2 - x1 + 1;
+            frame_diff_copy_rows(frame_diff.scratch, run_w, band_px + (x1 - area->x1), w, run_w, band_h);
+            frame_diff_send(x1, band_y1, run_w, band_h, frame_diff.scratch);
+        }
+    }
+
+    if (pending_y1 >= 0) {
+        frame_diff_send(area->x1, pending_y1, w, pending_y2 - pending_y1 + 1, px + (pending_y1 - area->y1) * w);
+    }
+}
+
+/**
+ * Get the counters
+ */
+static inline frame_diff_stats_t frame_diff_get_stats() {
+    return frame_diff.stats;
+}
+
+/**
+ * Clear the counters
+ */
+static inline void frame_diff_reset_stats() {
+    memset(&frame_diff.stats, 0, sizeof(frame_diff.stats));
+}
+
+#endif // FRAME_DIFF_H
@@ -0,0 +1,215 @@
+/*
+ * Idle Scheduler - Run deferred work in the slack between frames
+ * lv_timer_handler() returns how long LVGL doesn't need the CPU (until the
+ * next refresh or timer). Background jobs (building screens, warming caches,
+ * draining logs) are split into resumable steps and a step is started only
+ * if it's expected to end before that deadline. The cost of a job's steps
+ * is learned from the slowest recent step, so a step which doesn't fit waits
+ * for a longer gap instead of delaying a frame. Steps ending after the
+ * deadline anyway are counted as missed deadlines.
+ *
+ * A waiting job's estimate shrinks a little with every slice it's deferred,
+ * and a slice where LVGL had nothing to draw runs the next step even if it
+ * doesn't fit, so a step costing more than any slice still gets its turn.
+ * tools/idle_sched/idle_sched_sim.cpp runs the scheduler on a virtual clock.
+ *
+ * Usage:
+ *   idle_sched_init(now_us);                                  // e.g. micros()
+ *   idle_sched_add(warm_cache_step, NULL, 2000, "cache");    // step ~2 ms
+ *   loop:
+ *     idle_sched_set_deadline(lv_timer_handler());
+ *     ... other work ...
+ *     idle_sched_run();
+ */
+
+#ifndef IDLE_SCHEDULER_H
+#define IDLE_SCHEDULER_H
+
+#include <lvgl.h>
+#include <stdint.h>
+#include <string.h>
+
+// Jobs waiting at the same time
+#ifndef IDLE_SCHED_MAX_JOBS
+#define IDLE_SCHED_MAX_JOBS 8
+#endif
+
+// Time kept free before the deadline for the rest of loop() (serial, delay)
+#ifndef IDLE_SCHED_GUARD_US
+#define IDLE_SCHED_GUARD_US 1500
+#endif
+
+// Longest idle slice if no LVGL timer is pending
+#ifndef IDLE_SCHED_MAX_SLICE_MS
+#define IDLE_SCHED_MAX_SLICE_MS LV_DISP_DEF_REFR_PERIOD
+#endif
+
+// Slices at least this long are fully idle: LVGL returned a whole refresh
+// period (less the millisecond it rounds away)
+#ifndef IDLE_SCHED_FULL_SLICE_MS
+#define IDLE_SCHED_FULL_SLICE_MS (IDLE_SCHED_MAX_SLICE_MS - 1)
+#endif
+
+// A deferred job's estimate shrinks by 1/N per slice
+#ifndef IDLE_SCHED_DEFER_DECAY
+#define IDLE_SCHED_DEFER_DECAY 64
+#endif
+
+// Print the counters over Serial this often (0: never)
+#ifndef IDLE_SCHED_LOG_INTERVAL_MS
+#define IDLE_SCHED_LOG_INTERVAL_MS 0
+#endif
+
+/**
+ * One step of a job
+ * @return true when the job is finished
+ */
+typedef bool (*idle_job_step_t)(void* user_data);
+
+typedef uint32_t (*idle_sched_clock_t)(void);
+
+/**
+ * Counters since the last idle_sched_reset_stats()
+ */
+typedef struct {
+    uint32_t slices;           // Idle slices offered by idle_sched_run()
+    uint32_t steps;            // Steps run
+    uint32_t jobs_done;
+    uint32_t deferred;         // Slices where the next step didn't fit
+    uint32_t forced;           // Steps run over budget in a fully idle slice
+    uint32_t missed;           // Steps ending after the deadline
+    uint32_t max_overrun_us;   // Worst lateness of a missed step
+    uint32_t busy_us;          // Time spent in steps
+} idle_sched_stats_t;
+
+typedef struct {
+    idle_job_step_t step;
+    void* user_data;
+    const char* name;
+    uint32_t est_us;           // Expected cost of a step
+} idle_job_t;
+
+typedef struct {
+    idle_sched_clock_t now_us;
+    idle_job_t jobs[IDLE_SCHED_MAX_JOBS];
+    uint8_t job_cnt;
+    bool has_deadline;
+    bool full_slice;           // LVGL had nothing to draw, see IDLE_SCHED_FULL_SLICE_MS
+    uint32_t deadline_us;
+    idle_sched_stats_t stats;
+} idle_sched_t;
+
+static idle_sched_t idle_sched;
+
+static inline uint32_t idle_sched_tick_us() {
+    return lv_tick_get() * 1000;
+}
+
+/**
+ * @param now_us Microsecond clock (NULL: LVGL's tick)
+ */
+static inline void idle_sched_init(idle_sched_clock_t now_us) {
+    idle_sched.now_us = now_us ? now_us : idle_sched_tick_us;
+}
+
+/**
+ * Queue a job. Its steps are called until one returns true.
+ * @param step Does a bounded piece of the work
+ * @param user_data Passed to step
+ * @param step_us Expected cost of a step until it's measured
+ * @param name For the logs
+ * @return false if the queue is full
+ */
+static inline bool idle_sched_add(idle_job_step_t step, void* user_data, uint32_t step_us, const char* name) {
+    if (idle_sched.job_cnt >= IDLE_SCHED_MAX_JOBS) return false;
+    idle_job_t* job = &idle_sched.jobs[idle_sched.job_cnt++];
+    job->step = step;
+    job->user_data = user_data;
+    job->name = name;
+    job->est_us = step_us;
+    return true;
+}
+
+/**
+ * Set the end of the current idle slice
+ * @param idle_ms Return value of lv_timer_handler()
+ */
+static inline void idle_sched_set_deadline(uint32_t idle_ms) {
+    if (!idle_sched.now_us) idle_sched_init(NULL);
+    idle_sched.full_slice = idle_ms >= IDLE_SCHED_FULL_SLICE_MS;
+    if (idle_ms > IDLE_SCHED_MAX_SLICE_MS) idle_ms = IDLE_SCHED_MAX_SLICE_MS;
+    idle_sched.deadline_us = idle_sched.now_us() + idle_ms * 1000;
+    idle_sched.has_deadline = true;
+}
+
+static inline void idle_sched_remove(uint8_t i) {
+    memmove(&idle_sched.jobs[i], &idle_sched.jobs[i + 1], (idle_sched.job_cnt - i - 1) * sizeof(idle_job_t));
+    idle_sched.job_cnt--;
+}
+
+/**
+ * Run steps while they fit before the deadline. The oldest job goes first,
+ * the others fill the gaps where its next step doesn't fit. At the start of
+ * a fully idle slice the first step runs whatever its estimate.
+ */
+static inline void idle_sched_run() {
+    if (!idle_sched.has_deadline || idle_sched.job_cnt == 0) return;
+    idle_sched.has_deadline = false;
+    idle_sched.stats.slices++;
+
+    idle_sched_stats_t* stats = &idle_sched.stats;
+    bool force = idle_sched.full_slice;
+    uint8_t i = 0;
+    while (i < idle_sched.job_cnt) {
+        idle_job_t* job = &idle_sched.jobs[i];
+        uint32_t start = idle_sched.now_us();
+        int32_t slack = (int32_t)(idle_sched.deadline_us - start) - IDLE_SCHED_GUARD_US;
+        if (slack <= 0) break;
+
+        if (job->est_us > (uint32_t)slack && !force) {
+            if (i == 0) stats->deferred++;
+            // A slow step measured once mustn't keep the job waiting for a gap that never comes
+            job->est_us -= job->est_us / IDLE_SCHED_DEFER_DECAY;
+            i++;
+            continue;
+        }
+        if (job->est_us > (uint32_t)slack) stats->forced++;
+        force = false;
+
+        bool done = job->step(job->user_data);
+
+        uint32_t end = idle_sched.now_us();
+        uint32_t took = end - start;
+        stats->steps++;
+        stats->busy_us += took;
+
+        // Follow the slowest recent step, forget it slowly
+        uint32_t decayed = job->est_us - job->est_us / 8;
+        job->est_us = took > decayed ? took : decayed;
+
+        int32_t late = (int32_t)(end - idle_sched.deadline_us);
+        if (late > 0) {
+            stats->missed++;
+            if ((uint32_t)late > stats->max_overrun_us) stats->max_overrun_us = late;
+        }
+
+        if (done) {
+            stats->jobs_done++;
+            idle_sched_remove(i);
+        }
+    }
+}
+
+static inline uint8_t idle_sched_get_job_cnt() {
+    return idle_sched.job_cnt;
+}
+
+static inline idle_sched_stats_t idle_sched_get_stats() {
+    return idle_sched.stats;
+}
+
+static inline void idle_sched_reset_stats() {
+    memset(&idle_sched.stats, 0, sizeof(idle_sched.stats));
+}
+
+#endif // IDLE_SCHEDULER_H
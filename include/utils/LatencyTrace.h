@@ -0,0 +1,299 @@
+/*
+ * Latency Trace - Where the time goes from a serial byte to the panel
+ * Every message received over serial gets an event ID when its first byte
+ * arrives. The ID follows it through parsing and the state change it makes,
+ * and stays pending until the change is drawn: the first invalidation of the
+ * area the change is drawn in, the end of rendering and the end of the flush
+ * (and for a screen change, the moment the transition really loads the new
+ * screen). The UI code applying a change names that area (the target icon's
+ * old and new place, the progress ring, the whole screen for a transition),
+ * so an animation elsewhere doesn't count as drawing it, and a change nothing
+ * shows (the target off screen 7) is dropped after a few refreshes. Each point is
+ * stored with a microsecond timestamp in a fixed ring, dumped over Serial
+ * on request, so the latency can be split into parsing, transition delays,
+ * rendering and bus time.
+ *
+ * Usage:
+ *   latency_trace_init(now_us);                  // e.g. micros()
+ *   first byte: latency_trace_begin();  parsed: latency_trace_parsed();
+ *   done with the message: latency_trace_end();
+ *   AppState: latency_trace_state_changed(LATENCY_TRACE_KIND_TARGET);
+ *   UI, applying it: latency_trace_watch(LATENCY_TRACE_KIND_TARGET, x1, y1, x2, y2);
+ *   rounder_cb: latency_trace_invalidated(area->x1, area->y1, area->x2, area->y2);
+ *   flush_cb of the last area: latency_trace_rendered(); ...send...; latency_trace_flushed();
+ *   latency_trace_dump();                        // or send "TRACE" over serial
+ */
+
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "../state/ArduinoCompat.h"
+
+// Set to 1 (e.g. with -DLATENCY_TRACE_ENABLED=1) to record the trace points
+#ifndef LATENCY_TRACE_ENABLED
+#define LATENCY_TRACE_ENABLED 0
+#endif
+
+// Entries kept in the ring (8 bytes each)
+#ifndef LATENCY_TRACE_SIZE
+#define LATENCY_TRACE_SIZE 256
+#endif
+
+// Events waiting to be drawn at the same time
+#define LATENCY_TRACE_MAX_PENDING 8
+
+// A pending event without an invalidation of its area is dropped after this many refreshes
+#define LATENCY_TRACE_MAX_AGE 2
+
+/**
+ * What a state change shows on the panel
+ */
+typedef enum {
+    LATENCY_TRACE_KIND_SCREEN,   // A screen change, drawn by its transition
+    LATENCY_TRACE_KIND_TARGET,   // The tracking target of screen 7
+    LATENCY_TRACE_KIND_PROGRESS, // The progress ring and digits of screen 7
+} latency_trace_kind_t;
+
+typedef enum {
+    LATENCY_TRACE_RX,            // First byte of the message received
+    LATENCY_TRACE_PARSED,        // Message recognized
+    LATENCY_TRACE_STATE,         // AppState changed
+    LATENCY_TRACE_INVALIDATED,   // First area invalidated after the change
+    LATENCY_TRACE_RENDERED,      // Last area of the next refresh rendered
+    LATENCY_TRACE_FLUSHED,       // ...and sent to the panel
+    LATENCY_TRACE_LOADED,        // New screen loaded by the transition
+    _LATENCY_TRACE_POINT_CNT
+} latency_trace_point_t;
+
+typedef uint32_t (*latency_trace_clock_t)(void);
+
+typedef struct {
+    uint32_t t_us;
+    uint16_t id;
+    uint8_t point;
+} latency_trace_entry_t;
+
+typedef struct {
+    int16_t x1;
+    int16_t y1;
+    int16_t x2;
+    int16_t y2;
+} latency_trace_area_t;
+
+typedef struct {
+    uint16_t id;
+    uint8_t kind;
+    uint8_t watched;             // The area is set
+    uint8_t invalidated;
+    uint8_t age;
+    latency_trace_area_t area;
+} latency_trace_pending_t;
+
+typedef struct {
+    latency_trace_clock_t now_us;
+    latency_trace_entry_t ring[LATENCY_TRACE_SIZE];
+    uint16_t head;               // Next entry to write
+    uint16_t cnt;
+    uint16_t next_id;
+    uint16_t cur_id;             // Message being received or handled (0: none)
+    uint16_t load_id;            // Screen change waiting for its transition to start
+    uint16_t loading_id;         // Screen change whose transition is running
+    latency_trace_pending_t pending[LATENCY_TRACE_MAX_PENDING];
+    uint8_t pending_cnt;
+} latency_trace_t;
+
+#if LATENCY_TRACE_ENABLED
+
+static latency_trace_t latency_trace;
+
+static inline void latency_trace_init(latency_trace_clock_t now_us) {
+    memset(&latency_trace, 0, sizeof(latency_trace));
+    latency_trace.now_us = now_us;
+}
+
+static inline void latency_trace_add(uint16_t id, latency_trace_point_t point) {
+    latency_trace_entry_t* e = &latency_trace.ring[latency_trace.head];
+    e->t_us = latency_trace.now_us();
+    e->id = id;
+    e->point = point;
+    latency_trace.head = (latency_trace.head + 1) % LATENCY_TRACE_SIZE;
+    if (latency_trace.cnt < LATENCY_TRACE_SIZE) latency_trace.cnt++;
+}
+
+/**
+ * A message starts, give it a new event ID
+ */
+static inline void latency_trace_begin() {
+    if (!latency_trace.now_us) return;
+    if (++latency_trace.next_id == 0) latency_trace.next_id = 1;
+    latency_trace.cur_id = latency_trace.next_id;
+    latency_trace_add(latency_trace.cur_id, LATENCY_TRACE_RX);
+}
+
+static inline void latency_trace_parsed() {
+    if (latency_trace.cur_id) latency_trace_add(latency_trace.cur_id, LATENCY_TRACE_PARSED);
+}
+
+/**
+ * The message is handled, state changes from now on aren't caused by it
+ */
+static inline void latency_trace_end() {
+    latency_trace.cur_id = 0;
+}
+
+/**
+ * The current message changed AppState, wait for the change to be drawn
+ * @param kind What it changes, the UI names the area with latency_trace_watch()
+ */
+static inline void latency_trace_state_changed(latency_trace_kind_t kind) {
+    uint16_t id = latency_trace.cur_id;
+    if (!id) return;
+    latency_trace_add(id, LATENCY_TRACE_STATE);
+    if (kind == LATENCY_TRACE_KIND_SCREEN) latency_trace.load_id = id;
+
+    for (uint8_t i = 0; i < latency_trace.pending_cnt; i++) {
+        if (latency_trace.pending[i].id == id) return;
+    }
+    if (latency_trace.pending_cnt == LATENCY_TRACE_MAX_PENDING) {
+        // Drop the oldest
+        memmove(&latency_trace.pending[0], &latency_trace.pending[1],
+                (LATENCY_TRACE_MAX_PENDING - 1) * sizeof(latency_trace_pending_t));
+        latency_trace.pending_cnt--;
+    }
+    latency_trace_pending_t* p = &latency_trace.pending[latency_trace.pending_cnt++];
+    memset(p, 0, sizeof(*p));
+    p->id = id;
+    p->kind = kind;
+}
+
+/**
+ * The newest pending change of a kind is drawn in this area (absolute
+ * coordinates), call it where the UI applies the change. Called again
+ * before the invalidation, the areas are joined. Older changes of the kind
+ * were overwritten and are dropped when they age.
+ */
+static inline void latency_trace_watch(latency_trace_kind_t kind, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+    for (uint8_t i = latency_trace.pending_cnt; i > 0; i--) {
+        latency_trace_pending_t* p = &latency_trace.pending[i - 1];
+        if (p->kind != kind) continue;
+        if (p->invalidated) return;
+
+        if (!p->watched) {
+            p->watched = 1;
+            p->area.x1 = x1;
+            p->area.y1 = y1;
+            p->area.x2 = x2;
+            p->area.y2 = y2;
+        } else {
+            if (x1 < p->area.x1) p->area.x1 = x1;
+            if (y1 < p->area.y1) p->area.y1 = y1;
+            if (x2 > p->area.x2) p->area.x2 = x2;
+            if (y2 > p->area.y2) p->area.y2 = y2;
+        }
+        if (kind == LATENCY_TRACE_KIND_SCREEN && p->id == latency_trace.load_id) {
+            // Its transition starts now
+            latency_trace.loading_id = p->id;
+            latency_trace.load_id = 0;
+        }
+        return;
+    }
+}
+
+/**
+ * An area was invalidated (call it from the rounder_cb, it's cheap without pending events)
+ */
+static inline void latency_trace_invalidated(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+    for (uint8_t i = 0; i < latency_trace.pending_cnt; i++) {
+        latency_trace_pending_t* p = &latency_trace.pending[i];
+        if (!p->watched || p->invalidated) continue;
+        if (x1 > p->area.x2 || x2 < p->area.x1 || y1 > p->area.y2 || y2 < p->area.y1) continue;
+        p->invalidated = 1;
+        latency_trace_add(p->id, LATENCY_TRACE_INVALIDATED);
+    }
+}
+
+/**
+ * The last area of a refresh is rendered (beginning of its flush)
+ */
+static inline void latency_trace_rendered() {
+    for (uint8_t i = 0; i < latency_trace.pending_cnt; i++) {
+        if (latency_trace.pending[i].invalidated) latency_trace_add(latency_trace.pending[i].id, LATENCY_TRACE_RENDERED);
+    }
+}
+
+/**
+ * The last area of a refresh is on the panel, the invalidated events are done.
+ * A screen change waiting for a running transition to end doesn't age.
+ */
+static inline void latency_trace_flushed() {
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < latency_trace.pending_cnt; i++) {
+        latency_trace_pending_t p = latency_trace.pending[i];
+        if (p.invalidated) {
+            latency_trace_add(p.id, LATENCY_TRACE_FLUSHED);
+        } else if (p.id == latency_trace.load_id || ++p.age < LATENCY_TRACE_MAX_AGE) {
+            latency_trace.pending[kept++] = p;
+        }
+    }
+    latency_trace.pending_cnt = kept;
+}
+
+/**
+ * A screen transition loaded its new screen
+ */
+static inline void latency_trace_screen_loaded() {
+    if (!latency_trace.loading_id) return;
+    latency_trace_add(latency_trace.loading_id, LATENCY_TRACE_LOADED);
+    latency_trace.loading_id = 0;
+}
+
+/**
+ * Print one line per event still in the ring, the times relative to its first byte
+ */
+static inline void latency_trace_dump() {
+    static const char* names[_LATENCY_TRACE_POINT_CNT] = {
+        "rx", "parsed", "state", "invalidated", "rendered", "flushed", "loaded"
+    };
+    if (!latency_trace.now_us) return;
+
+    uint16_t start = (latency_trace.head + LATENCY_TRACE_SIZE - latency_trace.cnt) % LATENCY_TRACE_SIZE;
+    Serial.printf("Latency trace: %u entries (us from the first byte)\n", latency_trace.cnt);
+    for (uint16_t i = 0; i < latency_trace.cnt; i++) {
+        latency_trace_entry_t* rx = &latency_trace.ring[(start + i) % LATENCY_TRACE_SIZE];
+        if (rx->point != LATENCY_TRACE_RX) continue;
+
+        char line[160];
+        int len = snprintf(line, sizeof(line), "#%u", rx->id);
+        for (uint16_t j = i + 1; j < latency_trace.cnt && len < (int)sizeof(line); j++) {
+            latency_trace_entry_t* e = &latency_trace.ring[(start + j) % LATENCY_TRACE_SIZE];
+            if (e->id != rx->id) continue;
+            len += snprintf(line + len, sizeof(line) - len, " %s %lu", names[e->point],
+                            (unsigned long)(e->t_us - rx->t_us));
+        }
+        Serial.printf("%s\n", line);
+    }
+}
+
+#else
+
+static inline void latency_trace_init(latency_trace_clock_t now_us) { (void)now_us; }
+static inline void latency_trace_begin() {}
+static inline void latency_trace_parsed() {}
+static inline void latency_trace_end() {}
+static inline void latency_trace_state_changed(latency_trace_kind_t kind) { (void)kind; }
+static inline void latency_trace_watch(latency_trace_kind_t kind, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+    (void)kind; (void)x1; (void)y1; (void)x2; (void)y2;
+}
+static inline void latency_trace_invalidated(int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+    (void)x1; (void)y1; (void)x2; (void)y2;
+}
+static inline void latency_trace_rendered() {}
+static inline void latency_trace_flushed() {}
+static inline void latency_trace_screen_loaded() {}
+static inline void latency_trace_dump() {}
+
+#endif
+
+#endif // LATENCY_TRACE_H
@@ -1,18 +1,52 @@
 /*
  * Smart Screen Transition - Black overlay fade for OLED/AMOLED displays
  * Perfect for hiding color rendering issues with smooth black wipe
+ *
+ * Snapshot transitions: both screens are rendered once into PSRAM with
+ * lv_snapshot, then every frame is blended from the two pictures straight
+ * into LVGL's draw buffer, band by band, by an RGB565 kernel. The object
+ * trees aren't drawn during the animation, so a cross-fade costs a fraction
+ * of LVGL's FADE_ON, which draws both trees every frame (see
+ * tools/transition/transition_bench.cpp). Styles: cross-fade, slide and a
+ * radial wipe growing from the center of the round panel.
+ *
+ * A smart_transition() during a running transition isn't dropped: the
+ * newest one waits and starts when the running one has loaded its screen.
+ *
+ * Usage:
+ *   smart_transition(new_screen);   // SMART_TRANSITION_STYLE, black fade as fallback
+ *   snapshot_transition(new_screen, SNAPSHOT_TRANSITION_RADIAL_WIPE, 350);
  */
 
 #ifndef SMART_TRANSITION_H
 #define SMART_TRANSITION_H
 
 #include <lvgl.h>
+#include <math.h>
+#include <string.h>
+#include "DisplayUtils.h"
+#include "LatencyTrace.h"
+
+// Transition of smart_transition(): 0 black fade, 1 cross-fade, 2 slide, 3 radial wipe
+#ifndef SMART_TRANSITION_STYLE
+#define SMART_TRANSITION_STYLE 1
+#endif
+
+// Duration of the snapshot transitions of smart_transition()
+#ifndef SMART_TRANSITION_TIME_MS
+#define SMART_TRANSITION_TIME_MS 350
+#endif
 
 // Overlay for transition
 static lv_obj_t* black_overlay = NULL;
 static lv_obj_t* target_screen = NULL;
 static bool transition_in_progress = false;
 
+// Screen of a smart_transition() called during a running transition
+static lv_obj_t* queued_screen = NULL;
+
+static void smart_transition_queued();
+
 /**
  * Callback when fade-out completes (overlay becomes transparent, revealing new screen)
  */
@@ -23,6 +57,7 @@ static void black_fade_out_complete(lv_anim_t* a) {
     }
     transition_in_progress = false;
     target_screen = NULL;
+    smart_transition_queued();
 }
 
 /**
@@ -46,6 +81,7 @@ static void black_fade_in_complete(lv_anim_t* a) {
         #else
         lv_scr_load(new_screen);
         #endif
+        latency_trace_screen_loaded();
         
         // Move overlay to new screen
         lv_obj_set_parent(black_overlay, new_screen);
@@ -98,6 +134,8 @@ static inline void black_fade_transition(lv_obj_t* new_screen, uint32_t fade_in_
     
     transition_in_progress = true;
     target_screen = new_screen;
+    latency_trace_watch(LATENCY_TRACE_KIND_SCREEN, 0, 0, lv_disp_get_hor_res(NULL) - 1,
+                        lv_disp_get_ver_res(NULL) - 1);
     
     // Create full-screen black overlay on current screen (FULL SIZE!)
     black_overlay = lv_obj_create(lv_scr_act());
@@ -151,5 +189,304 @@ static inline void smooth_black_fade_transition(lv_obj_t* new_screen) {
     black_fade_transition(new_screen, 200, 200);
 }
 
+// ============================================================================
+// SNAPSHOT TRANSITIONS
+// ============================================================================
+
+typedef enum {
+    SNAPSHOT_TRANSITION_CROSSFADE = 1,
+    SNAPSHOT_TRANSITION_SLIDE = 2,         // The new screen pushes the old one to the left
+    SNAPSHOT_TRANSITION_RADIAL_WIPE = 3,   // The new screen grows from the center
+} snapshot_transition_type_t;
+
+typedef struct {
+    lv_obj_t* screen;           // Bare screen showing the blended frames
+    lv_obj_t* target;
+    lv_color_t* from;           // Snapshots of the screens (PSRAM)
+    lv_color_t* to;
+    lv_coord_t w;
+    lv_coord_t h;
+    snapshot_transition_type_t type;
+    int32_t progress;           // 0..256
+    lv_coord_t radius;          // Radius of the wipe drawn last
+} snapshot_transition_t;
+
+static snapshot_transition_t snapshot_tr;
+
+#if LV_COLOR_DEPTH == 16
+/**
+ * Spread RGB565 to 32 bits with gaps between the channels: ----GGGGGG-----RRRRR------BBBBB
+ * so the three channels can be multiplied by 0..32 at once
+ */
+static inline uint32_t snapshot_spread_565(uint16_t c) {
+#if LV_COLOR_16_SWAP
+    c = (uint16_t)((c << 8) | (c >> 8));
+#endif
+    return (c | ((uint32_t)c << 16)) & 0x07E0F81F;
+}
+
+static inline uint16_t snapshot_pack_565(uint32_t c) {
+    uint16_t p = (uint16_t)(c | (c >> 16));
+#if LV_COLOR_16_SWAP
+    p = (uint16_t)((p << 8) | (p >> 8));
+#endif
+    return p;
+}
+#endif
+
+/**
+ * Blend a row of the two snapshots
+ * @param mix Weight of `b`, 0..32
+ */
+static inline void snapshot_blend_row(lv_color_t* dst, const lv_color_t* a, const lv_color_t* b,
+                                      int32_t len, uint32_t mix) {
+    if (mix == 0) {
+        memcpy(dst, a, len * sizeof(lv_color_t));
+        return;
+    }
+    if (mix >= 32) {
+        memcpy(dst, b, len * sizeof(lv_color_t));
+        return;
+    }
+
+#if LV_COLOR_DEPTH == 16
+    uint16_t* d = (uint16_t*)dst;
+    const uint16_t* pa = (const uint16_t*)a;
+    const uint16_t* pb = (const uint16_t*)b;
+    uint32_t inv = 32 - mix;
+    for (int32_t i = 0; i < len; i++) {
+        // Same pixel on both screens (e.g. the black background)
+        if (pa[i] == pb[i]) {
+            d[i] = pa[i];
+            continue;
+        }
+        uint32_t ca = snapshot_spread_565(pa[i]);
+        uint32_t cb = snapshot_spread_565(pb[i]);
+        d[i] = snapshot_pack_565(((ca * inv + cb * mix) >> 5) & 0x07E0F81F);
+    }
+#else
+    lv_opa_t opa = (lv_opa_t)(mix * 255 / 32);
+    for (int32_t i = 0; i < len; i++) dst[i] = lv_color_mix(b[i], a[i], opa);
+#endif
+}
+
+/**
+ * Write the frame into the draw buffer instead of drawing objects
+ */
+static void snapshot_transition_draw_cb(lv_event_t* e) {
+    lv_draw_ctx_t* draw_ctx = lv_event_get_draw_ctx(e);
+    snapshot_transition_t* tr = &snapshot_tr;
+    if (!tr->from || !tr->to) return;
+
+    lv_area_t full = {0, 0, (lv_coord_t)(tr->w - 1), (lv_coord_t)(tr->h - 1)};
+    lv_area_t clip;
+    if (!_lv_area_intersect(&clip, draw_ctx->clip_area, &full)) return;
+
+    const lv_area_t* buf_area = draw_ctx->buf_area;
+    lv_coord_t buf_w = lv_area_get_width(buf_area);
+    lv_coord_t len = lv_area_get_width(&clip);
+    uint32_t mix = (tr->progress + 4) >> 3;
+    lv_coord_t slide = (lv_coord_t)((tr->progress * tr->w) >> 8);
+    lv_coord_t cx = tr->w / 2;
+    lv_coord_t cy = tr->h / 2;
+
+    for (lv_coord_t y = clip.y1; y <= clip.y2; y++) {
+        lv_color_t* dst = (lv_color_t*)draw_ctx->buf + (y - buf_area->y1) * buf_w + (clip.x1 - buf_area->x1);
+        const lv_color_t* from = tr->from + y * tr->w;
+        const lv_color_t* to = tr->to + y * tr->w;
+
+        switch (tr->type) {
+            case SNAPSHOT_TRANSITION_CROSSFADE:
+                snapshot_blend_row(dst, from + clip.x1, to + clip.x1, len, mix);
+                break;
+
+            case SNAPSHOT_TRANSITION_SLIDE: {
+                // Pixel x shows x + slide of the old screen, then the new screen starts
+                lv_coord_t split = tr->w - slide;
+                lv_coord_t x = clip.x1;
+                if (x < split) {
+                    lv_coord_t n = LV_MIN(clip.x2 + 1, split) - x;
+                    memcpy(dst, from + x + slide, n * sizeof(lv_color_t));
+                    dst += n;
+                    x += n;
+                }
+                if (x <= clip.x2) memcpy(dst, to + x - split, (clip.x2 + 1 - x) * sizeof(lv_color_t));
+                break;
+            }
+
+            case SNAPSHOT_TRANSITION_RADIAL_WIPE: {
+                // The new screen inside the circle, the old one outside
+                lv_coord_t dy = y - cy;
+                lv_coord_t half = -1;
+                if (LV_ABS(dy) <= tr->radius) {
+                    half = (lv_coord_t)sqrtf((float)(tr->radius * tr->radius - dy * dy));
+                }
+                lv_coord_t in_x1 = LV_MAX(cx - half, clip.x1);
+                lv_coord_t in_x2 = LV_MIN(cx + half, clip.x2);
+                if (half < 0 || in_x1 > in_x2) {
+                    memcpy(dst, from + clip.x1, len * sizeof(lv_color_t));
+                    break;
+                }
+                memcpy(dst, from + clip.x1, (in_x1 - clip.x1) * sizeof(lv_color_t));
+                memcpy(dst + in_x1 - clip.x1, to + in_x1, (in_x2 - in_x1 + 1) * sizeof(lv_color_t));
+                memcpy(dst + in_x2 + 1 - clip.x1, from + in_x2 + 1, (clip.x2 - in_x2) * sizeof(lv_color_t));
+                break;
+            }
+        }
+    }
+}
+
+static inline lv_coord_t snapshot_transition_max_radius(snapshot_transition_t* tr) {
+#if DISPLAY_IS_CIRCULAR
+    // The corners aren't visible on the round panel
+    return LV_MAX(tr->w, tr->h) / 2 + 1;
+#else
+    return (lv_coord_t)sqrtf((float)(tr->w * tr->w + tr->h * tr->h)) / 2 + 1;
+#endif
+}
+
+static void snapshot_transition_anim_cb(void* var, int32_t v) {
+    snapshot_transition_t* tr = &snapshot_tr;
+    tr->progress = v;
+
+    if (tr->type == SNAPSHOT_TRANSITION_RADIAL_WIPE) {
+        // Only the ring between the last and the new radius changes, redraw its bounding box
+        lv_coord_t r = (lv_coord_t)((v * snapshot_transition_max_radius(tr)) >> 8);
+        if (r == tr->radius) return;
+        tr->radius = r;
+        lv_area_t area;
+        area.x1 = tr->w / 2 - r;
+        area.y1 = tr->h / 2 - r;
+        area.x2 = tr->w / 2 + r;
+        area.y2 = tr->h / 2 + r;
+        lv_obj_invalidate_area((lv_obj_t*)var, &area);
+    } else {
+        lv_obj_invalidate((lv_obj_t*)var);
+    }
+}
+
+static void snapshot_transition_free() {
+    if (snapshot_tr.from) lv_mem_free(snapshot_tr.from);
+    if (snapshot_tr.to) lv_mem_free(snapshot_tr.to);
+    snapshot_tr.from = NULL;
+    snapshot_tr.to = NULL;
+}
+
+static void snapshot_transition_complete(lv_anim_t* a) {
+    snapshot_transition_t* tr = &snapshot_tr;
+
+    lv_scr_load(tr->target);
+    latency_trace_screen_loaded();
+    lv_obj_del(tr->screen);
+    tr->screen = NULL;
+    tr->target = NULL;
+    snapshot_transition_free();
+    transition_in_progress = false;
+    smart_transition_queued();
+}
+
+/**
+ * Take the snapshot of a screen into a new PSRAM buffer of the display's size
+ */
+static inline lv_color_t* snapshot_transition_take(lv_obj_t* screen, lv_coord_t w, lv_coord_t h) {
+#if LV_USE_SNAPSHOT
+    lv_obj_update_layout(screen);
+    uint32_t size = lv_snapshot_buf_size_needed(screen, LV_IMG_CF_TRUE_COLOR);
+    if (size != (uint32_t)w * h * sizeof(lv_color_t)) return NULL;
+
+    lv_color_t* buf = (lv_color_t*)lv_mem_alloc_large(size);
+    if (buf == NULL) return NULL;
+
+    lv_img_dsc_t dsc;
+    if (lv_snapshot_take_to_buf(screen, LV_IMG_CF_TRUE_COLOR, &dsc, buf, size) != LV_RES_OK) {
+        lv_mem_free(buf);
+        return NULL;
+    }
+    return buf;
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * Snapshot transition to a screen
+ * @param new_screen Screen to load
+ * @param type Cross-fade, slide or radial wipe
+ * @param time_ms Duration
+ * @return false if the snapshots couldn't be taken (LV_USE_SNAPSHOT 0 or out of PSRAM)
+ */
+static inline bool snapshot_transition(lv_obj_t* new_screen, snapshot_transition_type_t type, uint32_t time_ms) {
+    if (!new_screen || transition_in_progress) {
+        return false;
+    }
+    
+    if (lv_scr_act() == new_screen) {
+        return true;
+    }
+    
+    snapshot_transition_t* tr = &snapshot_tr;
+    tr->w = lv_disp_get_hor_res(NULL);
+    tr->h = lv_disp_get_ver_res(NULL);
+    tr->from = snapshot_transition_take(lv_scr_act(), tr->w, tr->h);
+    tr->to = tr->from ? snapshot_transition_take(new_screen, tr->w, tr->h) : NULL;
+    if (!tr->to) {
+        snapshot_transition_free();
+        return false;
+    }
+    
+    transition_in_progress = true;
+    latency_trace_watch(LATENCY_TRACE_KIND_SCREEN, 0, 0, tr->w - 1, tr->h - 1);
+    tr->target = new_screen;
+    tr->type = type;
+    tr->progress = 0;
+    tr->radius = -1;
+    
+    // A bare screen drawn only by snapshot_transition_draw_cb
+    tr->screen = lv_obj_create(NULL);
+    lv_obj_remove_style_all(tr->screen);
+    lv_obj_clear_flag(tr->screen, (lv_obj_flag_t)(LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE));
+    lv_obj_add_event_cb(tr->screen, snapshot_transition_draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_scr_load(tr->screen);
+    
+    lv_anim_t anim;
+    lv_anim_init(&anim);
+    lv_anim_set_var(&anim, tr->screen);
+    lv_anim_set_values(&anim, 0, 256);
+    lv_anim_set_time(&anim, time_ms);
+    lv_anim_set_exec_cb(&anim, snapshot_transition_anim_cb);
+    lv_anim_set_path_cb(&anim, type == SNAPSHOT_TRANSITION_CROSSFADE ? lv_anim_path_linear : lv_anim_path_ease_in_out);
+    lv_anim_set_ready_cb(&anim, snapshot_transition_complete);
+    lv_anim_start(&anim);
+    return true;
+}
+
+/**
+ * Transition of SMART_TRANSITION_STYLE, falls back to the black fade.
+ * During a running transition it's queued (only the newest one).
+ */
+static inline void smart_transition(lv_obj_t* new_screen) {
+    if (transition_in_progress) {
+        queued_screen = new_screen;
+        return;
+    }
+    queued_screen = NULL;
+#if SMART_TRANSITION_STYLE != 0
+    if (snapshot_transition(new_screen, (snapshot_transition_type_t)SMART_TRANSITION_STYLE,
+                            SMART_TRANSITION_TIME_MS)) {
+        return;
+    }
+#endif
+    smooth_black_fade_transition(new_screen);
+}
+
+/**
+ * A transition ended, start the one queued meanwhile
+ */
+static void smart_transition_queued() {
+    lv_obj_t* next = queued_screen;
+    queued_screen = NULL;
+    if (next && next != lv_scr_act()) smart_transition(next);
+}
+
 #endif // SMART_TRANSITION_H
 
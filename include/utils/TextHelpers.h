@@ -8,6 +8,7 @@
 
 #include <lvgl.h>
 #include "DisplayUtils.h"
+#include "CircularText.h"
 
 // ============================================================================
 // HTML5-LIKE BOX MODEL STRUCTURES
@@ -180,6 +181,26 @@ static inline lv_obj_t* create_paragraph(lv_obj_t* parent, const char* text,
     return container;
 }
 
+/**
+ * Mark a label as static text (like a pre-rendered <img> of the text)
+ * The text is rasterized once and blitted as a bitmap when something
+ * underneath animates. It's rasterized again only if the text, font or
+ * width changes, so update_text() still works on it.
+ * Only for labels whose redraws were measured as hot: blitting the bitmap
+ * isn't cheaper than drawing cached glyphs, and freezing every label made
+ * Screen3 and Screen11 slower. Needs LV_LABEL_FROZEN in lv_conf.h.
+ * @param label Label object
+ * @return The same label
+ */
+static inline lv_obj_t* freeze_text(lv_obj_t* label) {
+#if LV_LABEL_FROZEN
+    if (label) {
+        lv_label_set_frozen(label, true);
+    }
+#endif
+    return label;
+}
+
 /**
  * Create a smart text label that handles wrapping and centering
  * @param parent Parent screen
@@ -249,17 +270,21 @@ static inline lv_obj_t* create_centered_text(lv_obj_t* parent, const char* text,
                                               const lv_font_t* font,
                                               int16_t y,
                                               lv_color_t color) {
-    return create_smart_text(parent, text, font, DISPLAY_CENTER_X, y, 
-                            DISPLAY_WIDTH - 60, color, LV_TEXT_ALIGN_CENTER);
+    lv_obj_t* label = create_smart_text(parent, text, font, DISPLAY_CENTER_X, y, 
+                                        DISPLAY_WIDTH - 60, color, LV_TEXT_ALIGN_CENTER);
+    
+    return label;
 }
 
 /**
  * Create multiline centered text that wraps automatically
+ * With max_width 0 every line is broken to the width of the circle at its
+ * own height (see CircularText.h), otherwise all lines wrap to max_width.
  * @param parent Parent screen
  * @param text Text content
  * @param font Font to use (NULL for default)
- * @param y Y position
- * @param max_width Maximum width (0 = auto)
+ * @param y Y position (top of the first line)
+ * @param max_width Maximum width (0 = follow the circle)
  * @param color Text color
  * @return Label object
  */
@@ -269,7 +294,6 @@ static inline lv_obj_t* create_multiline_text(lv_obj_t* parent, const char* text
                                                 int16_t max_width,
                                                 lv_color_t color) {
     lv_obj_t* label = lv_label_create(parent);
-    lv_label_set_text(label, text);
     
     if (font != NULL) {
         lv_obj_set_style_text_font(label, font, 0);
@@ -277,44 +301,34 @@ static inline lv_obj_t* create_multiline_text(lv_obj_t* parent, const char* text
     
     lv_obj_set_style_text_color(label, color, 0);
     
-    // Calculate safe width for circular display
-    int16_t safe_width = max_width;
-    if (safe_width == 0) {
-        // Calculate width based on Y position for circular screen
-        int16_t center_y = DISPLAY_CENTER_Y;
-        int16_t radius = DISPLAY_RADIUS;
-        int16_t y_offset = abs(y - center_y);
-        
-        // Calculate available width at this Y position (Pythagorean theorem)
-        if (y_offset < radius) {
-            int16_t chord_half = (int16_t)sqrt((radius * radius) - (y_offset * y_offset));
-            safe_width = (chord_half * 2) - 40;  // 20px margin on each side
-        } else {
-            safe_width = DISPLAY_WIDTH - 60;
-        }
-        
-        // Minimum width constraint
-        if (safe_width < 100) {
-            safe_width = 100;
-        }
+    if (max_width == 0) {
+        // Flow the lines into the circle
+        circular_text_set_top(label, y);
+        circular_text_set(label, text);
+    } else {
+        lv_label_set_text(label, text);
+        lv_label_set_long_mode(label, LV_LABEL_LONG_WRAP);
+        lv_obj_set_width(label, max_width);
+        lv_obj_set_style_text_align(label, LV_TEXT_ALIGN_CENTER, 0);
+        lv_obj_align(label, LV_ALIGN_TOP_MID, 0, y);
     }
     
-    lv_label_set_long_mode(label, LV_LABEL_LONG_WRAP);
-    lv_obj_set_width(label, safe_width);
-    lv_obj_set_style_text_align(label, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_align(label, LV_ALIGN_TOP_MID, 0, y);
-    
     return label;
 }
 
 /**
  * Update text of an existing label
+ * Labels flowed into the circle are laid out again (usually from the cache).
  * @param label Label object
  * @param text New text
  */
 static inline void update_text(lv_obj_t* label, const char* text) {
     if (label) {
-        lv_label_set_text(label, text);
+        if (circular_text_is_flowed(label)) {
+            circular_text_set(label, text);
+        } else {
+            lv_label_set_text(label, text);
+        }
     }
 }
 
@@ -326,6 +340,11 @@ static inline void update_text(lv_obj_t* label, const char* text) {
 static inline bool text_fits_in_circle(lv_obj_t* label) {
     if (!label) return false;
     
+    // Flowed labels know the width of the circle at every line
+    if (circular_text_is_flowed(label)) {
+        return circular_text_fits(label);
+    }
+    
     lv_coord_t x = lv_obj_get_x(label);
     lv_coord_t y = lv_obj_get_y(label);
     lv_coord_t w = lv_obj_get_width(label);
@@ -0,0 +1,152 @@
+// OneWireAsync - timer driven OneWire, see OneWireAsync.h
+//
+// The slots have OneWire.cpp's timing and direct I/O, with the delay that
+// follows each one left to the timer instead of delayMicroseconds().
+
+#include <Arduino.h>
+#include "OneWireAsync.h"
+#include "util/OneWire_direct_gpio.h"
+
+#ifdef ARDUINO_ARCH_ESP32
+// The slots must not wait on a flash cache miss with interrupts off
+#  define CRIT_TIMING IRAM_ATTR
+#else
+#  define CRIT_TIMING
+#endif
+
+
+void OneWireAsyncPin::begin(uint8_t pin)
+{
+	pinMode(pin, INPUT);
+	bitmask = PIN_TO_BITMASK(pin);
+	baseReg = (volatile void *)PIN_TO_BASEREG(pin);
+}
+
+uint8_t OneWireAsyncPin::read(void)
+{
+	IO_REG_TYPE mask IO_REG_MASK_ATTR = bitmask;
+	__attribute__((unused)) volatile IO_REG_TYPE *reg IO_REG_BASE_ATTR = (volatile IO_REG_TYPE *)baseReg;
+
+	return DIRECT_READ(reg, mask);
+}
+
+//
+// Start of a reset pulse, released by slot(0, ...) 480 us later
+//
+void OneWireAsyncPin::low(void)
+{
+	IO_REG_TYPE mask IO_REG_MASK_ATTR = bitmask;
+	__attribute__((unused)) volatile IO_REG_TYPE *reg IO_REG_BASE_ATTR = (volatile IO_REG_TYPE *)baseReg;
+
+	noInterrupts();
+	DIRECT_WRITE_LOW(reg, mask);
+	DIRECT_MODE_OUTPUT(reg, mask);	// drive output low
+	interrupts();
+}
+
+//
+// One slot: write 1 is (10, 0), write 0 (65, 0), read (3, 10) and the
+// presence sample after a reset (0, 70)
+//
+uint8_t CRIT_TIMING OneWireAsyncPin::slot(uint16_t lowUs, uint16_t sampleUs, bool power)
+{
+	IO_REG_TYPE mask IO_REG_MASK_ATTR = bitmask;
+	__attribute__((unused)) volatile IO_REG_TYPE *reg IO_REG_BASE_ATTR = (volatile IO_REG_TYPE *)baseReg;
+	uint8_t r = 1;
+
+	noInterrupts();
+	if (lowUs) {
+		DIRECT_WRITE_LOW(reg, mask);
+		DIRECT_MODE_OUTPUT(reg, mask);	// drive output low
+		delayMicroseconds(lowUs);
+	}
+	DIRECT_MODE_INPUT(reg, mask);	// let pin float, pull up will raise
+	if (sampleUs) {
+		delayMicroseconds(sampleUs);
+		r = DIRECT_READ(reg, mask);
+	}
+	if (power) {
+		DIRECT_WRITE_HIGH(reg, mask);	// hold high for parasite power
+		DIRECT_MODE_OUTPUT(reg, mask);
+	}
+	interrupts();
+	return r;
+}
+
+void OneWireAsyncPin::power(bool on)
+{
+	IO_REG_TYPE mask IO_REG_MASK_ATTR = bitmask;
+	__attribute__((unused)) volatile IO_REG_TYPE *reg IO_REG_BASE_ATTR = (volatile IO_REG_TYPE *)baseReg;
+
+	noInterrupts();
+	if (on) {
+		DIRECT_WRITE_HIGH(reg, mask);
+		DIRECT_MODE_OUTPUT(reg, mask);
+	} else {
+		DIRECT_MODE_INPUT(reg, mask);
+		DIRECT_WRITE_LOW(reg, mask);
+	}
+	interrupts();
+}
+
+
+void OneWireAsync::begin(uint8_t pin)
+{
+	this->pin.begin(pin);
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+
+// Runs in the esp_timer task: steps until the next wait is long enough to re-arm
+void OneWireAsync::onTimer(void *arg)
+{
+	OneWireAsync *self = (OneWireAsync *)arg;
+
+	for (;;) {
+		uint32_t us = self->step(micros());
+		if (!us) return;
+		if (us > ONEWIRE_ASYNC_SPIN_US) {
+			esp_timer_start_once(self->timer, us);
+			return;
+		}
+		delayMicroseconds(us);
+	}
+}
+
+void OneWireAsync::wake(void)
+{
+	if (!timer) {
+		esp_timer_create_args_t args = {};
+		args.callback = onTimer;
+		args.arg = this;
+		args.dispatch_method = ESP_TIMER_TASK;
+		args.name = "onewire";
+		if (esp_timer_create(&args, &timer) != ESP_OK) return;
+	}
+	esp_timer_start_once(timer, 1);
+}
+
+void OneWireAsync::poll(void)
+{
+}
+
+#else
+
+void OneWireAsync::wake(void)
+{
+	nextUs = micros();
+}
+
+void OneWireAsync::poll(void)
+{
+	while (busy() && (int32_t)(micros() - nextUs) >= 0) {
+		uint32_t us = step(micros());
+		nextUs = micros() + us;
+		if (us > ONEWIRE_ASYNC_SPIN_US) return;
+		delayMicroseconds(us);
+	}
+}
+
+#endif
+
+#undef CRIT_TIMING
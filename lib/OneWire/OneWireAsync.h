@@ -0,0 +1,539 @@
+#ifndef OneWireAsync_h
+#define OneWireAsync_h
+
+#ifdef __cplusplus
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// OneWireAsync runs the same bus protocol as OneWire, as a state machine
+// stepped by a timer instead of a loop of delays.  Each step does one
+// thing on the bus (a reset pulse, a presence sample, one read or write
+// slot) and returns how long to wait before the next one.  Interrupts are
+// only off for the slot itself (3 to 70 microseconds), the waits between
+// slots and a temperature conversion (up to 750 ms) leave the CPU free.
+//
+// The steps run from an esp_timer callback on ESP32, or from poll() in
+// loop() on other boards.  Completion callbacks run in that context too:
+// keep them short, and only record the results there.
+//
+// transfer(), search() and requestTemperatures() are called from a single
+// task (loop(), or the one task owning the bus) once busy() is false, not
+// from the callbacks: busy() stays true until the step that ran the last
+// callback has returned, so a start from a callback fails.
+//
+//   OneWireAsync ds(10);
+//   uint8_t roms[8][8];
+//   ds.search(roms, 8, found);                      // found(count, arg)
+//   ds.requestTemperatures(roms, count, reading);   // reading(i, rom, temp16, ok, arg), per sensor
+//
+// The engine itself, OneWireAsyncT, only needs a Pin class (see
+// OneWireAsyncPin) and can be stepped on a host against a model of the
+// bus, see tools/onewire_sim.
+
+// Waits up to this long are spun in the timer callback, longer ones re-arm the timer
+#ifndef ONEWIRE_ASYNC_SPIN_US
+#define ONEWIRE_ASYNC_SPIN_US 20
+#endif
+
+// How often an externally powered sensor is asked whether its conversion is done
+#ifndef ONEWIRE_ASYNC_POLL_US
+#define ONEWIRE_ASYNC_POLL_US 10000
+#endif
+
+// Largest transfer(): ROM command, ROM and a few bytes of function command
+#ifndef ONEWIRE_ASYNC_TX_MAX
+#define ONEWIRE_ASYNC_TX_MAX 16
+#endif
+
+template <class Pin>
+class OneWireAsyncT
+{
+  public:
+    // transfer() done, ok is false if no device answered the reset
+    typedef void (*DoneCallback)(bool ok, void *arg);
+    // search() done, count ROMs with a valid CRC were stored
+    typedef void (*SearchCallback)(uint8_t count, void *arg);
+    // One sensor read by requestTemperatures(), temp16 in 1/16 degree C
+    typedef void (*TempCallback)(uint8_t index, const uint8_t *rom, int16_t temp16, bool ok, void *arg);
+
+    // Slot timing in microseconds, as OneWire.cpp
+    enum {
+        RESET_LOW_US = 480,
+        PRESENCE_SAMPLE_US = 70,
+        RESET_RECOVERY_US = 410,
+        WRITE1_LOW_US = 10,
+        WRITE1_RECOVERY_US = 55,
+        WRITE0_LOW_US = 65,
+        WRITE0_RECOVERY_US = 5,
+        READ_LOW_US = 3,
+        READ_SAMPLE_US = 10,
+        READ_RECOVERY_US = 53,
+    };
+
+    OneWireAsyncT() { }
+    virtual ~OneWireAsyncT() { }
+
+    Pin &getPin() { return pin; }
+
+    bool busy() const { return __atomic_load_n(&op, __ATOMIC_ACQUIRE) != OP_NONE; }
+
+    // Reset, write tx (ROM command first), then read rxLen bytes into rx.
+    // If 'power' is set the bus is held high after the last bit for
+    // parasite powered devices, until the next operation.
+    bool transfer(const uint8_t *tx, uint8_t txLen, uint8_t *rx, uint8_t rxLen,
+                  DoneCallback cb, void *arg = NULL, bool power = false)
+    {
+        if (busy() || txLen > ONEWIRE_ASYNC_TX_MAX) return false;
+        memcpy(txBuf, tx, txLen);
+        doneCb = cb;
+        cbArg = arg;
+        parasite = false;
+        sequence(txLen, rx, rxLen, PH_END, power);
+        return start(OP_TRANSFER);
+    }
+
+    // Find the ROMs of up to maxCount devices, in the order OneWire::search()
+    // returns them.  alarmOnly uses the conditional search (0xEC).
+    bool search(uint8_t (*roms)[8], uint8_t maxCount, SearchCallback cb, void *arg = NULL,
+                bool alarmOnly = false)
+    {
+        if (busy() || !maxCount) return false;
+        searchRoms = roms;
+        searchMax = maxCount;
+        searchFound = 0;
+        searchPasses = 0;
+        searchCmd = alarmOnly ? 0xEC : 0xF0;
+        searchCb = cb;
+        cbArg = arg;
+        parasite = false;
+        lastDiscrepancy = 0;
+        memset(romNo, 0, sizeof(romNo));
+        searchPass();
+        return start(OP_SEARCH);
+    }
+
+    // Start a conversion on every DS18x20 (skip ROM), wait for it in the
+    // background and read each sensor's scratchpad.  cb is called once per
+    // sensor; with roms NULL there must be a single sensor on the bus.
+    // conversionMs is the sensors' longest conversion (750 at 12 bits).
+    // Externally powered sensors are polled and read as soon as they are
+    // done, parasite powered ones get the bus held high for conversionMs.
+    bool requestTemperatures(const uint8_t (*roms)[8], uint8_t count, TempCallback cb, void *arg = NULL,
+                             uint16_t conversionMs = 750, bool parasitePower = false)
+    {
+        if (busy() || (!roms && count != 1) || !count) return false;
+        tempRoms = roms;
+        tempCount = count;
+        tempIndex = -1;
+        tempCb = cb;
+        cbArg = arg;
+        conversionUs = (uint32_t)conversionMs * 1000;
+        parasite = parasitePower;
+        txBuf[0] = 0xCC;    // Skip ROM
+        txBuf[1] = 0x44;    // Convert T
+        sequence(2, NULL, 0, PH_CONVERT, parasite);
+        return start(OP_TEMPERATURE);
+    }
+
+    // Run the next step.  Returns the microseconds to wait before calling
+    // again, 0 when there is nothing left to do.  The operation ends here,
+    // after its callbacks, and the caller must not touch the engine again
+    // before the next start.
+    uint32_t step(uint32_t nowUs)
+    {
+        uint32_t us = run(nowUs);
+        if (!us) __atomic_store_n(&op, (uint8_t)OP_NONE, __ATOMIC_RELEASE);
+        return us;
+    }
+
+    static uint8_t crc8(const uint8_t *addr, uint8_t len)
+    {
+        uint8_t crc = 0;
+        while (len--) {
+            uint8_t inbyte = *addr++;
+            for (uint8_t i = 8; i; i--) {
+                uint8_t mix = (crc ^ inbyte) & 0x01;
+                crc >>= 1;
+                if (mix) crc ^= 0x8C;
+                inbyte >>= 1;
+            }
+        }
+        return crc;
+    }
+
+    // Temperature in 1/16 degree C from a DS18S20 (family 0x10) or DS18B20/DS1822 scratchpad
+    static int16_t scratchpadTemp16(const uint8_t *data, uint8_t family)
+    {
+        int16_t raw = (int16_t)((data[1] << 8) | data[0]);
+        if (family == 0x10) {
+            // 9 bit, extended with COUNT_REMAIN
+            raw = raw * 8;
+            if (data[7] == 0x10) raw = (raw & 0xFFF0) + 12 - data[6];
+        } else {
+            // Undefined low bits at lower resolutions
+            uint8_t cfg = data[4] & 0x60;
+            if (cfg == 0x00) raw = raw & ~7;
+            else if (cfg == 0x20) raw = raw & ~3;
+            else if (cfg == 0x40) raw = raw & ~1;
+        }
+        return raw;
+    }
+
+  protected:
+    Pin pin;
+
+    // Called when an operation starts: arm the timer
+    virtual void wake(void) { }
+
+  private:
+    enum Op : uint8_t { OP_NONE, OP_TRANSFER, OP_SEARCH, OP_TEMPERATURE };
+    enum Phase : uint8_t {
+        PH_IDLE, PH_RESET, PH_PRESENCE, PH_WRITE, PH_READ, PH_SEARCH, PH_CONVERT, PH_END, PH_FAIL,
+    };
+
+    uint8_t op = OP_NONE;         // Read by other tasks through busy()
+    uint8_t phase = PH_IDLE;
+    void *cbArg = NULL;
+
+    // The running sequence: reset, write txBuf, read rx, then 'next'
+    uint8_t txBuf[ONEWIRE_ASYNC_TX_MAX];
+    uint8_t txLen = 0;
+    uint8_t *rx = NULL;
+    uint8_t rxLen = 0;
+    uint8_t next = PH_END;
+    bool powerAfter = false;
+    bool parasite = false;
+    uint16_t bitPos = 0;
+    uint8_t resetWaits = 0;
+
+    DoneCallback doneCb = NULL;
+
+    // Search state, as OneWire::search()
+    SearchCallback searchCb = NULL;
+    uint8_t (*searchRoms)[8] = NULL;
+    uint8_t searchMax = 0;
+    uint8_t searchFound = 0;
+    uint16_t searchPasses = 0;
+    uint8_t searchCmd = 0xF0;
+    uint8_t romNo[8];
+    uint8_t lastDiscrepancy = 0;
+    uint8_t lastZero = 0;
+    uint8_t idBit = 0;
+    uint8_t searchSub = 0;        // Read id bit, read complement, write direction
+    bool searchLost = false;      // Every device dropped out after the first bit
+
+    // Conversion and scratchpad reads
+    TempCallback tempCb = NULL;
+    const uint8_t (*tempRoms)[8] = NULL;
+    uint8_t tempCount = 0;
+    int16_t tempIndex = -1;       // -1: converting
+    uint8_t scratchpad[9];
+    uint32_t conversionUs = 0;
+    uint32_t convertStartUs = 0;
+    bool converting = false;
+
+    bool start(uint8_t newOp)
+    {
+        op = newOp;
+        wake();
+        return true;
+    }
+
+    void sequence(uint8_t nTx, uint8_t *rxBuf, uint8_t nRx, uint8_t after, bool power)
+    {
+        txLen = nTx;
+        rx = rxBuf;
+        rxLen = nRx;
+        next = after;
+        powerAfter = power;
+        bitPos = 0;
+        resetWaits = 0;
+        phase = PH_RESET;
+    }
+
+    // Phase after the presence pulse, and after the last bit written
+    uint8_t afterReset(bool present) { return !present ? (uint8_t)PH_FAIL : txLen ? (uint8_t)PH_WRITE : afterWrite(); }
+    uint8_t afterWrite() { return rxLen ? (uint8_t)PH_READ : next; }
+
+    uint32_t run(uint32_t nowUs)
+    {
+        switch (phase) {
+        case PH_RESET:
+            // Wait up to 250 us for the bus to come high
+            if (!pin.read()) {
+                if (++resetWaits >= 125) phase = PH_FAIL;
+                return 2;
+            }
+            if (parasite) {
+                // A long low would let parasite powered sensors power up again (and lose the conversion)
+                phase = afterReset(!pin.slot(RESET_LOW_US, PRESENCE_SAMPLE_US));
+                return RESET_RECOVERY_US;
+            }
+            pin.low();
+            phase = PH_PRESENCE;
+            return RESET_LOW_US;
+
+        case PH_PRESENCE:
+            phase = afterReset(!pin.slot(0, PRESENCE_SAMPLE_US));
+            return RESET_RECOVERY_US;
+
+        case PH_WRITE: {
+            uint8_t bit = (txBuf[bitPos >> 3] >> (bitPos & 7)) & 1;
+            bool last = ++bitPos == (uint16_t)txLen * 8;
+            pin.slot(bit ? WRITE1_LOW_US : WRITE0_LOW_US, 0, last && powerAfter);
+            if (last) {
+                bitPos = 0;
+                phase = afterWrite();
+            }
+            return bit ? WRITE1_RECOVERY_US : WRITE0_RECOVERY_US;
+        }
+
+        case PH_READ: {
+            uint8_t mask = 1 << (bitPos & 7);
+            if (pin.slot(READ_LOW_US, READ_SAMPLE_US)) rx[bitPos >> 3] |= mask;
+            else rx[bitPos >> 3] &= ~mask;
+            if (++bitPos == (uint16_t)rxLen * 8) {
+                bitPos = 0;
+                phase = next;
+            }
+            return READ_RECOVERY_US;
+        }
+
+        case PH_SEARCH:
+            return searchStep();
+
+        case PH_CONVERT:
+            if (!converting) {
+                converting = true;
+                convertStartUs = nowUs;
+                return parasite ? conversionUs : ONEWIRE_ASYNC_POLL_US;
+            }
+            if (parasite) {
+                pin.power(false);
+                converting = false;
+                phase = PH_END;
+                return 1;
+            }
+            // The sensor answers 1 once the conversion is done
+            if (pin.slot(READ_LOW_US, READ_SAMPLE_US) || nowUs - convertStartUs >= conversionUs) {
+                converting = false;
+                phase = PH_END;
+                return READ_RECOVERY_US;
+            }
+            return ONEWIRE_ASYNC_POLL_US;
+
+        case PH_END:
+        case PH_FAIL:
+            sequenceDone(phase == PH_END);
+            return phase == PH_IDLE ? 0 : 1;
+
+        default:
+            return 0;
+        }
+    }
+
+    // The last callback follows, step() ends the operation
+    void finish()
+    {
+        phase = PH_IDLE;
+        converting = false;
+    }
+
+    void sequenceDone(bool ok)
+    {
+        if (op == OP_TRANSFER) {
+            DoneCallback cb = doneCb;
+            finish();
+            if (cb) cb(ok, cbArg);
+        } else if (op == OP_SEARCH) {
+            searchDone(ok);
+        } else if (op == OP_TEMPERATURE) {
+            temperatureDone(ok);
+        } else {
+            finish();
+        }
+    }
+
+    //
+    // ROM search, one pass per device: the search command, then per ROM bit
+    // the bit and its complement from every device and the direction taken
+    //
+
+    void searchPass()
+    {
+        txBuf[0] = searchCmd;
+        lastZero = 0;
+        searchSub = 0;
+        searchLost = false;
+        sequence(1, NULL, 0, PH_SEARCH, false);
+        searchPasses++;
+    }
+
+    uint32_t searchStep()
+    {
+        uint8_t n = bitPos + 1;    // id_bit_number of OneWire::search()
+        uint8_t mask = 1 << (bitPos & 7);
+        uint8_t &romByte = romNo[bitPos >> 3];
+
+        if (searchSub == 0) {
+            idBit = pin.slot(READ_LOW_US, READ_SAMPLE_US);
+            searchSub = 1;
+            return READ_RECOVERY_US;
+        }
+        if (searchSub == 1) {
+            uint8_t cmpBit = pin.slot(READ_LOW_US, READ_SAMPLE_US);
+            if (idBit && cmpBit) {
+                // No device on the bus (or with an alarm), or none left on this path
+                searchLost = bitPos > 0;
+                phase = PH_FAIL;
+                return READ_RECOVERY_US;
+            }
+            uint8_t direction;
+            if (idBit != cmpBit) {
+                direction = idBit;
+            } else {
+                direction = n < lastDiscrepancy ? (romByte & mask) != 0 : n == lastDiscrepancy;
+                if (!direction) lastZero = n;
+            }
+            if (direction) romByte |= mask;
+            else romByte &= ~mask;
+            searchSub = 2;
+            return READ_RECOVERY_US;
+        }
+        uint8_t direction = (romByte & mask) != 0;
+        pin.slot(direction ? WRITE1_LOW_US : WRITE0_LOW_US, 0);
+        searchSub = 0;
+        if (++bitPos == 64) phase = PH_END;
+        return direction ? WRITE1_RECOVERY_US : WRITE0_RECOVERY_US;
+    }
+
+    void searchDone(bool ok)
+    {
+        bool valid = ok && romNo[0] && crc8(romNo, 7) == romNo[7];
+        bool last = !ok && !searchLost;
+        if (valid) {
+            lastDiscrepancy = lastZero;
+            last = lastDiscrepancy == 0;
+            bool seen = false;
+            for (uint8_t i = 0; i < searchFound; i++) {
+                if (!memcmp(searchRoms[i], romNo, 8)) seen = true;
+            }
+            if (!seen) memcpy(searchRoms[searchFound++], romNo, 8);
+        } else if (!last) {
+            // A bit went wrong on the way: start over, keeping the ROMs found so far
+            lastDiscrepancy = 0;
+            memset(romNo, 0, sizeof(romNo));
+        }
+        // Don't let a noisy bus go on forever
+        if (last || searchFound == searchMax || searchPasses >= 2 * searchMax + 2) {
+            SearchCallback cb = searchCb;
+            uint8_t found = searchFound;
+            finish();
+            if (cb) cb(found, cbArg);
+            return;
+        }
+        searchPass();
+    }
+
+    //
+    // Conversion, then one scratchpad read per sensor
+    //
+
+    void readScratchpad()
+    {
+        uint8_t n = 0;
+        if (tempRoms) {
+            txBuf[n++] = 0x55;    // Match ROM
+            memcpy(txBuf + n, tempRoms[tempIndex], 8);
+            n += 8;
+        } else {
+            txBuf[n++] = 0xCC;
+        }
+        txBuf[n++] = 0xBE;        // Read scratchpad
+        sequence(n, scratchpad, sizeof(scratchpad), PH_END, false);
+    }
+
+    void report(uint8_t index, int16_t temp16, bool ok)
+    {
+        TempCallback cb = tempCb;
+        const uint8_t *rom = tempRoms ? tempRoms[index] : NULL;
+        if (index + 1 >= tempCount) finish();
+        if (cb) cb(index, rom, temp16, ok, cbArg);
+    }
+
+    void temperatureDone(bool ok)
+    {
+        if (tempIndex < 0) {
+            if (!ok) {
+                // Nobody on the bus
+                for (uint8_t i = 0; i < tempCount; i++) report(i, 0, false);
+                return;
+            }
+            tempIndex = 0;
+            readScratchpad();
+            return;
+        }
+
+        uint8_t any = 0;
+        for (uint8_t i = 0; i < sizeof(scratchpad); i++) any |= scratchpad[i];
+        bool valid = ok && any && crc8(scratchpad, 8) == scratchpad[8];
+        uint8_t family = tempRoms ? tempRoms[tempIndex][0] : (scratchpad[4] == 0xFF ? 0x10 : 0x28);
+        int16_t temp16 = valid ? scratchpadTemp16(scratchpad, family) : 0;
+        uint8_t index = tempIndex++;
+        if (tempIndex < tempCount) readScratchpad();
+        report(index, temp16, valid);
+    }
+};
+
+#if defined(ARDUINO)
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_timer.h>
+#endif
+
+// The bus pin, with OneWire's direct I/O.  A slot runs with interrupts off:
+// drive low for lowUs (0: it already is), release, and after sampleUs read
+// the bus (0: don't).  power holds the bus high afterwards.
+class OneWireAsyncPin
+{
+  private:
+    uint32_t bitmask;
+    volatile void *baseReg;
+
+  public:
+    void begin(uint8_t pin);
+    uint8_t read(void);
+    void low(void);
+    uint8_t slot(uint16_t lowUs, uint16_t sampleUs, bool power = false);
+    void power(bool on);
+};
+
+class OneWireAsync : public OneWireAsyncT<OneWireAsyncPin>
+{
+  public:
+    OneWireAsync() { }
+    OneWireAsync(uint8_t pin) { begin(pin); }
+    void begin(uint8_t pin);
+
+    // Run the steps that are due.  Needed from loop() on boards without
+    // esp_timer, does nothing on ESP32.
+    void poll(void);
+
+  protected:
+    void wake(void);
+
+  private:
+#if defined(ARDUINO_ARCH_ESP32)
+    esp_timer_handle_t timer = NULL;
+    static void onTimer(void *arg);
+#else
+    uint32_t nextUs = 0;
+#endif
+};
+
+#endif // ARDUINO
+
+#endif // __cplusplus
+#endif // OneWireAsync_h
@@ -0,0 +1,62 @@
+#include <OneWireAsync.h>
+
+// OneWire DS18S20, DS18B20, DS1822 Temperature Example, without blocking
+//
+// The same readings as DS18x20_Temperature, but the search, the 750 ms
+// conversion and the scratchpad reads run in the background while loop()
+// keeps going.  The results arrive in the callbacks below.
+
+OneWireAsync  ds(10);  // on pin 10 (a 4.7K resistor is necessary)
+
+#define MAX_SENSORS 8
+
+uint8_t roms[MAX_SENSORS][8];
+uint8_t sensorCount = 0;
+bool searched = false;
+unsigned long lastRequest = 0;
+unsigned long loops = 0;
+
+void found(uint8_t count, void *arg) {
+  sensorCount = count;
+  searched = true;
+}
+
+void reading(uint8_t index, const uint8_t *rom, int16_t temp16, bool ok, void *arg) {
+  Serial.print("ROM =");
+  for (uint8_t i = 0; i < 8; i++) {
+    Serial.write(' ');
+    Serial.print(rom[i], HEX);
+  }
+  if (ok) {
+    Serial.print("  Temperature = ");
+    Serial.print((float)temp16 / 16.0);
+    Serial.println(" Celsius");
+  } else {
+    Serial.println("  no reading");
+  }
+}
+
+void setup(void) {
+  Serial.begin(9600);
+  ds.search(roms, MAX_SENSORS, found);
+}
+
+void loop(void) {
+  ds.poll();      // runs the bus on boards without esp_timer
+  loops++;
+
+  if (searched && !ds.busy() && millis() - lastRequest >= 2000) {
+    lastRequest = millis();
+    Serial.print(sensorCount);
+    Serial.print(" sensors, ");
+    Serial.print(loops);
+    Serial.println(" loops since the last request");
+    loops = 0;
+    if (sensorCount) {
+      ds.requestTemperatures(roms, sensorCount, reading);
+    } else {
+      searched = false;
+      ds.search(roms, MAX_SENSORS, found);
+    }
+  }
+}
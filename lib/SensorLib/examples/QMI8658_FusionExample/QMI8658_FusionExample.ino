@@ -0,0 +1,157 @@
+/**
+ *
+ * @license MIT License
+ *
+ * Copyright (c) 2024 lewis he
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file      QMI8658_FusionExample.ino
+ *
+ */
+#include <Arduino.h>
+#include <Wire.h>
+#include <SPI.h>
+#include "SensorQMI8658.hpp"
+#include "SensorFusion.hpp"
+
+#ifndef SENSOR_SDA
+#define SENSOR_SDA  17
+#endif
+
+#ifndef SENSOR_SCL
+#define SENSOR_SCL  18
+#endif
+
+#ifndef SENSOR_IRQ
+#define SENSOR_IRQ  33
+#endif
+
+// Print every sample as t_us,ax,ay,az,gx,gy,gz for tools/imu_fusion/fusion_bench --csv
+// #define PRINT_RAW_CSV
+
+
+SensorQMI8658 qmi;
+
+SensorFusion fusion;
+
+// One batch holds a full FIFO, keep it out of the stack
+IMUbatch batch;
+
+volatile bool fifoReady = false;
+volatile uint32_t fifoReadyMicros = 0;
+
+uint32_t fusionCycles = 0;
+uint32_t fusionUpdates = 0;
+uint32_t lastPrint = 0;
+
+void IRAM_ATTR setFlag()
+{
+    fifoReadyMicros = micros();
+    fifoReady = true;
+}
+
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial);
+
+    qmi.setPins(SENSOR_IRQ);
+
+    if (!qmi.begin(Wire, QMI8658_L_SLAVE_ADDRESS, SENSOR_SDA, SENSOR_SCL)) {
+        Serial.println("Failed to find QMI8658 - check your wiring!");
+        while (1) {
+            delay(1000);
+        }
+    }
+
+    qmi.configAccelerometer(SensorQMI8658::ACC_RANGE_4G, SensorQMI8658::ACC_ODR_1000Hz, SensorQMI8658::LPF_MODE_0);
+
+    qmi.configGyroscope(SensorQMI8658::GYR_RANGE_512DPS, SensorQMI8658::GYR_ODR_896_8Hz, SensorQMI8658::LPF_MODE_3);
+
+    qmi.configFIFO(SensorQMI8658::FIFO_MODE_FIFO,
+                   SensorQMI8658::FIFO_SAMPLES_128,
+                   SensorQMI8658::INTERRUPT_PIN_1,
+                   16);
+
+    qmi.enableAccelerometer();
+
+    qmi.enableGyroscope();
+
+    qmi.enableINT(SensorQMI8658::INTERRUPT_PIN_1, true);
+    qmi.enableINT(SensorQMI8658::INTERRUPT_PIN_2, false);
+
+    pinMode(SENSOR_IRQ, INPUT);
+    attachInterrupt(SENSOR_IRQ, setFlag, RISING);
+
+    /*
+    * Samples come at 896.8Hz, the filter averages them down to 100 updates per second.
+    * With a magnetometer, pass its readings in the axes of the QMI8658 to
+    * fusion.setMagnetometer() before each update to hold the heading.
+    * */
+    fusion.begin(100, SensorFusion::FUSION_MADGWICK);
+    fusion.setMadgwickGain(0.1);
+
+    Serial.println("Read data now...");
+}
+
+
+void loop()
+{
+    uint32_t irqMicros = 0;
+    if (fifoReady) {
+        fifoReady = false;
+        irqMicros = fifoReadyMicros;
+    }
+
+    uint16_t samples = qmi.readFromFifo(&batch, irqMicros);
+    if (samples == 0) {
+        return;
+    }
+
+#ifdef PRINT_RAW_CSV
+    for (uint16_t i = 0; i < samples; ++i) {
+        Serial.printf("%lu,%.5f,%.5f,%.5f,%.3f,%.3f,%.3f\n", (unsigned long)batch.timestamp[i],
+                      batch.accel[0][i], batch.accel[1][i], batch.accel[2][i],
+                      batch.gyro[0][i], batch.gyro[1][i], batch.gyro[2][i]);
+    }
+#endif
+
+    uint32_t start = ESP.getCycleCount();
+    uint16_t updates = fusion.update(batch);
+    fusionCycles += ESP.getCycleCount() - start;
+    fusionUpdates += updates;
+
+#ifndef PRINT_RAW_CSV
+    if (millis() - lastPrint < 200 || fusionUpdates == 0) {
+        return;
+    }
+    lastPrint = millis();
+
+    // Where "up" is on the screen, this is what a tilt driven UI follows
+    float x, y, z;
+    fusion.getGravity(x, y, z);
+    Serial.printf("ROLL %7.2f PITCH %7.2f YAW %7.2f  TILT %6.2f  UP %.3f %.3f %.3f  %lu cycles/update\n",
+                  fusion.getRoll(), fusion.getPitch(), fusion.getYaw(), fusion.getTilt(), x, y, z,
+                  (unsigned long)(fusionCycles / fusionUpdates));
+    fusionCycles = 0;
+    fusionUpdates = 0;
+#endif
+}
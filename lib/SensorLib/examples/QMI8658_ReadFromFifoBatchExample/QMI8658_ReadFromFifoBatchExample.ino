@@ -0,0 +1,137 @@
+/**
+ *
+ * @license MIT License
+ *
+ * Copyright (c) 2024 lewis he
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file      QMI8658_ReadFromFifoBatchExample.ino
+ *
+ */
+#include <Arduino.h>
+#include <Wire.h>
+#include <SPI.h>
+#include "SensorQMI8658.hpp"
+
+#ifndef SENSOR_SDA
+#define SENSOR_SDA  17
+#endif
+
+#ifndef SENSOR_SCL
+#define SENSOR_SCL  18
+#endif
+
+#ifndef SENSOR_IRQ
+#define SENSOR_IRQ  33
+#endif
+
+
+SensorQMI8658 qmi;
+
+// One batch holds a full FIFO, keep it out of the stack
+IMUbatch batch;
+
+volatile bool fifoReady = false;
+volatile uint32_t fifoReadyMicros = 0;
+
+// The watermark interrupt only saves the time, the bus is read in loop()
+void IRAM_ATTR setFlag()
+{
+    fifoReadyMicros = micros();
+    fifoReady = true;
+}
+
+
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial);
+
+    qmi.setPins(SENSOR_IRQ);
+
+    if (!qmi.begin(Wire, QMI8658_L_SLAVE_ADDRESS, SENSOR_SDA, SENSOR_SCL)) {
+        Serial.println("Failed to find QMI8658 - check your wiring!");
+        while (1) {
+            delay(1000);
+        }
+    }
+
+    Serial.print("Device ID:"); Serial.println(qmi.getChipID(), HEX);
+
+    qmi.configAccelerometer(SensorQMI8658::ACC_RANGE_4G, SensorQMI8658::ACC_ODR_1000Hz, SensorQMI8658::LPF_MODE_0);
+
+    qmi.configGyroscope(SensorQMI8658::GYR_RANGE_64DPS, SensorQMI8658::GYR_ODR_896_8Hz, SensorQMI8658::LPF_MODE_3);
+
+    /*
+    * The FIFO holds 128 samples (143ms at 896.8Hz), the interrupt is raised at 32 of them,
+    * so loop() has about 100ms to come around before anything is dropped.
+    * */
+    qmi.configFIFO(SensorQMI8658::FIFO_MODE_FIFO,
+                   SensorQMI8658::FIFO_SAMPLES_128,
+                   SensorQMI8658::INTERRUPT_PIN_1,
+                   32);
+
+    qmi.enableAccelerometer();
+
+    qmi.enableGyroscope();
+
+    qmi.enableINT(SensorQMI8658::INTERRUPT_PIN_1, true);
+    qmi.enableINT(SensorQMI8658::INTERRUPT_PIN_2, false);
+
+    pinMode(SENSOR_IRQ, INPUT);
+    attachInterrupt(SENSOR_IRQ, setFlag, RISING);
+
+    Serial.println("Read data now...");
+}
+
+
+void loop()
+{
+    uint32_t irqMicros = 0;
+    if (fifoReady) {
+        fifoReady = false;
+        irqMicros = fifoReadyMicros;
+    }
+
+    // Without a pending watermark this is a pin read, no bus transaction
+    uint16_t samples = qmi.readFromFifo(&batch, irqMicros);
+    if (samples == 0) {
+        return;
+    }
+
+    if (batch.overflow) {
+        Serial.println("FIFO overflow, samples were dropped");
+    }
+
+    // Mean of the batch per axis
+    float accel[3] = {0}, gyro[3] = {0};
+    for (int axis = 0; axis < 3; ++axis) {
+        for (uint16_t i = 0; i < samples; ++i) {
+            accel[axis] += batch.accel[axis][i];
+            gyro[axis] += batch.gyro[axis][i];
+        }
+        accel[axis] /= samples;
+        gyro[axis] /= samples;
+    }
+
+    Serial.printf("%u samples %lu..%lu us  ACCEL %.3f %.3f %.3f g  GYRO %.2f %.2f %.2f dps\n",
+                  samples, (unsigned long)batch.timestamp[0], (unsigned long)batch.timestamp[samples - 1],
+                  accel[0], accel[1], accel[2], gyro[0], gyro[1], gyro[2]);
+}
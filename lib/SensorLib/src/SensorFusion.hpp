@@ -0,0 +1,390 @@
+/**
+ *
+ * @license MIT License
+ *
+ * Copyright (c) 2022 lewis he
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file      SensorFusion.hpp
+ * @note      Orientation from an accelerometer, a gyroscope and optionally a magnetometer,
+ *            with the gradient descent filter of Madgwick or the complementary filter of Mahony
+ *            (https://x-io.co.uk/open-source-imu-and-ahrs-algorithms/). Single precision, no allocation.
+ */
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+class SensorFusion
+{
+public:
+
+    enum Algorithm {
+        FUSION_MADGWICK,
+        FUSION_MAHONY,
+    };
+
+    SensorFusion()
+    {
+        reset();
+    }
+
+    /**
+     * @brief  begin
+     * @note   Samples that come faster than the update rate are averaged into one filter update,
+     *         so an 896.8Hz FIFO stream can drive a 100Hz filter for about a ninth of the cost.
+     * @param  updateHz: Filter updates per second, 0 to update on every sample
+     * @param  algorithm: FUSION_MADGWICK or FUSION_MAHONY
+     */
+    void begin(float updateHz = 100.0f, Algorithm algorithm = FUSION_MADGWICK)
+    {
+        __algorithm = algorithm;
+        __period_us = updateHz > 0 ? (uint32_t)(1000000.0f / updateHz + 0.5f) : 0;
+        reset();
+    }
+
+    // Madgwick: weight of the accelerometer and magnetometer against the gyroscope (default 0.1)
+    void setMadgwickGain(float beta)
+    {
+        __beta = beta;
+    }
+
+    // Mahony: proportional and integral gains (default 1.0 and 0, an integral gain removes gyroscope bias)
+    void setMahonyGains(float kp, float ki)
+    {
+        __twoKp = 2.0f * kp;
+        __twoKi = 2.0f * ki;
+    }
+
+    // Start over, the next sample sets the orientation from gravity (and the magnetometer)
+    void reset()
+    {
+        q0 = 1.0f;
+        q1 = q2 = q3 = 0.0f;
+        __integral[0] = __integral[1] = __integral[2] = 0.0f;
+        __initialized = false;
+        clearWindow();
+    }
+
+    /**
+     * @brief  update
+     * @note   Adds one sample. The accelerometer may be in any unit, the gyroscope is in degrees per second.
+     * @param  timestamp: micros() when the sample was taken
+     * @retval true when the filter was updated
+     */
+    bool update(float ax, float ay, float az, float gx, float gy, float gz, uint32_t timestamp)
+    {
+        if (!__initialized) {
+            align(ax, ay, az);
+            __last_us = timestamp;
+            __initialized = true;
+            return false;
+        }
+
+        // Gaps longer than 100ms (stalls, lost samples) are not integrated
+        uint32_t dt = timestamp - __last_us;
+        __last_us = timestamp;
+        if (dt > 100000) {
+            dt = 100000;
+        }
+
+        // Gyroscope weighted by time, so the window integrates the rotation exactly
+        __gyro_sum[0] += gx * dt;
+        __gyro_sum[1] += gy * dt;
+        __gyro_sum[2] += gz * dt;
+        __accel_sum[0] += ax;
+        __accel_sum[1] += ay;
+        __accel_sum[2] += az;
+        __window_us += dt;
+        __window_count++;
+        if (__window_us < __period_us || __window_us == 0) {
+            return false;
+        }
+
+        float rate = (float)(M_PI / 180.0) / __window_us;
+        float count = 1.0f / __window_count;
+        step(__gyro_sum[0] * rate, __gyro_sum[1] * rate, __gyro_sum[2] * rate,
+             __accel_sum[0] * count, __accel_sum[1] * count, __accel_sum[2] * count,
+             __window_us * 1e-6f);
+        clearWindow();
+        return true;
+    }
+
+    /**
+     * @brief  update
+     * @note   Adds a batch as SensorQMI8658::readFromFifo(IMUbatch *) fills it
+     * @retval Number of filter updates
+     */
+    template <class Batch>
+    uint16_t update(const Batch &batch)
+    {
+        uint16_t updates = 0;
+        for (uint16_t i = 0; i < batch.count; ++i) {
+            updates += update(batch.accel[0][i], batch.accel[1][i], batch.accel[2][i],
+                              batch.gyro[0][i], batch.gyro[1][i], batch.gyro[2][i],
+                              batch.timestamp[i]);
+        }
+        return updates;
+    }
+
+    /**
+     * @brief  setMagnetometer
+     * @note   Latest magnetometer reading, used by the updates that follow. It must be in the axes
+     *         of the IMU (swap and negate the axes of the magnetometer to match) and hard iron corrected.
+     *         Any unit, only the direction is used.
+     */
+    void setMagnetometer(float mx, float my, float mz)
+    {
+        float norm = mx * mx + my * my + mz * mz;
+        if (norm == 0.0f) {
+            return;
+        }
+        norm = 1.0f / sqrtf(norm);
+        __mag[0] = mx * norm;
+        __mag[1] = my * norm;
+        __mag[2] = mz * norm;
+        __has_mag = true;
+    }
+
+    // Back to accelerometer and gyroscope only, the heading then follows the gyroscope
+    void clearMagnetometer()
+    {
+        __has_mag = false;
+    }
+
+    void getQuaternion(float &w, float &x, float &y, float &z)
+    {
+        w = q0;
+        x = q1;
+        y = q2;
+        z = q3;
+    }
+
+    // Rotation about the x axis in degrees
+    float getRoll()
+    {
+        return atan2f(q0 * q1 + q2 * q3, 0.5f - q1 * q1 - q2 * q2) * (float)(180.0 / M_PI);
+    }
+
+    // Rotation about the y axis in degrees
+    float getPitch()
+    {
+        float s = 2.0f * (q0 * q2 - q1 * q3);
+        return asinf(s > 1.0f ? 1.0f : (s < -1.0f ? -1.0f : s)) * (float)(180.0 / M_PI);
+    }
+
+    // Heading in degrees, from magnetic north with a magnetometer or from the start without one
+    float getYaw()
+    {
+        return atan2f(q0 * q3 + q1 * q2, 0.5f - q2 * q2 - q3 * q3) * (float)(180.0 / M_PI);
+    }
+
+    /**
+     * @brief  getGravity
+     * @note   Direction of "up" in the axes of the sensor, a unit vector. Level and face up is (0, 0, 1),
+     *         x and y are how far a bubble level or a parallax layer on the screen moves.
+     */
+    void getGravity(float &x, float &y, float &z)
+    {
+        x = 2.0f * (q1 * q3 - q0 * q2);
+        y = 2.0f * (q0 * q1 + q2 * q3);
+        z = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+    }
+
+    // Angle between the z axis and up in degrees, 0 when level and face up
+    float getTilt()
+    {
+        float z = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+        return acosf(z > 1.0f ? 1.0f : (z < -1.0f ? -1.0f : z)) * (float)(180.0 / M_PI);
+    }
+
+private:
+
+    void clearWindow()
+    {
+        __gyro_sum[0] = __gyro_sum[1] = __gyro_sum[2] = 0.0f;
+        __accel_sum[0] = __accel_sum[1] = __accel_sum[2] = 0.0f;
+        __window_us = 0;
+        __window_count = 0;
+    }
+
+    // Orientation from gravity, and the heading from the magnetometer when there is one
+    void align(float ax, float ay, float az)
+    {
+        float roll = atan2f(ay, az);
+        float pitch = atan2f(-ax, sqrtf(ay * ay + az * az));
+        float yaw = 0.0f;
+        float cr = cosf(roll), sr = sinf(roll);
+        float cp = cosf(pitch), sp = sinf(pitch);
+        if (__has_mag) {
+            float hx = __mag[0] * cp + __mag[1] * sr * sp + __mag[2] * cr * sp;
+            float hy = __mag[1] * cr - __mag[2] * sr;
+            yaw = atan2f(-hy, hx);
+        }
+        cr = cosf(roll * 0.5f);
+        sr = sinf(roll * 0.5f);
+        cp = cosf(pitch * 0.5f);
+        sp = sinf(pitch * 0.5f);
+        float cy = cosf(yaw * 0.5f), sy = sinf(yaw * 0.5f);
+        q0 = cr * cp * cy + sr * sp * sy;
+        q1 = sr * cp * cy - cr * sp * sy;
+        q2 = cr * sp * cy + sr * cp * sy;
+        q3 = cr * cp * sy - sr * sp * cy;
+    }
+
+    // One filter update, gyroscope in rad/s
+    void step(float gx, float gy, float gz, float ax, float ay, float az, float dt)
+    {
+        float norm = ax * ax + ay * ay + az * az;
+        bool accel = norm > 0.0f;
+        if (accel) {
+            norm = 1.0f / sqrtf(norm);
+            ax *= norm;
+            ay *= norm;
+            az *= norm;
+        }
+        if (__algorithm == FUSION_MAHONY) {
+            mahony(gx, gy, gz, ax, ay, az, accel, dt);
+        } else {
+            madgwick(gx, gy, gz, ax, ay, az, accel, dt);
+        }
+        norm = 1.0f / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+        q0 *= norm;
+        q1 *= norm;
+        q2 *= norm;
+        q3 *= norm;
+    }
+
+    void madgwick(float gx, float gy, float gz, float ax, float ay, float az, bool accel, float dt)
+    {
+        // Rate of change of the quaternion from the gyroscope
+        float qDot0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+        float qDot1 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+        float qDot2 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+        float qDot3 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+        if (accel) {
+            // Gradient of the error between the gravity the orientation predicts and the measured one
+            float fx = 2.0f * (q1 * q3 - q0 * q2) - ax;
+            float fy = 2.0f * (q0 * q1 + q2 * q3) - ay;
+            float fz = 1.0f - 2.0f * (q1 * q1 + q2 * q2) - az;
+            float s0 = -2.0f * q2 * fx + 2.0f * q1 * fy;
+            float s1 = 2.0f * q3 * fx + 2.0f * q0 * fy - 4.0f * q1 * fz;
+            float s2 = -2.0f * q0 * fx + 2.0f * q3 * fy - 4.0f * q2 * fz;
+            float s3 = 2.0f * q1 * fx + 2.0f * q2 * fy;
+
+            if (__has_mag) {
+                // Same for the magnetic field, with the reference field turned to the estimated heading
+                float mx = __mag[0], my = __mag[1], mz = __mag[2];
+                float hx = mx * (1.0f - 2.0f * (q2 * q2 + q3 * q3)) + my * 2.0f * (q1 * q2 - q0 * q3) + mz * 2.0f * (q1 * q3 + q0 * q2);
+                float hy = mx * 2.0f * (q1 * q2 + q0 * q3) + my * (1.0f - 2.0f * (q1 * q1 + q3 * q3)) + mz * 2.0f * (q2 * q3 - q0 * q1);
+                float bx = sqrtf(hx * hx + hy * hy);
+                float bz = mx * 2.0f * (q1 * q3 - q0 * q2) + my * 2.0f * (q2 * q3 + q0 * q1) + mz * (1.0f - 2.0f * (q1 * q1 + q2 * q2));
+                float bx2 = 2.0f * bx, bz2 = 2.0f * bz;
+
+                float ex = bx * (1.0f - 2.0f * (q2 * q2 + q3 * q3)) + bz2 * (q1 * q3 - q0 * q2) - mx;
+                float ey = bx2 * (q1 * q2 - q0 * q3) + bz2 * (q0 * q1 + q2 * q3) - my;
+                float ez = bx2 * (q0 * q2 + q1 * q3) + bz * (1.0f - 2.0f * (q1 * q1 + q2 * q2)) - mz;
+                s0 += -bz2 * q2 * ex + (-bx2 * q3 + bz2 * q1) * ey + bx2 * q2 * ez;
+                s1 += bz2 * q3 * ex + (bx2 * q2 + bz2 * q0) * ey + (bx2 * q3 - 2.0f * bz2 * q1) * ez;
+                s2 += (-2.0f * bx2 * q2 - bz2 * q0) * ex + (bx2 * q1 + bz2 * q3) * ey + (bx2 * q0 - 2.0f * bz2 * q2) * ez;
+                s3 += (-2.0f * bx2 * q3 + bz2 * q1) * ex + (-bx2 * q0 + bz2 * q2) * ey + bx2 * q1 * ez;
+            }
+
+            float norm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+            if (norm > 0.0f) {
+                norm = __beta / sqrtf(norm);
+                qDot0 -= norm * s0;
+                qDot1 -= norm * s1;
+                qDot2 -= norm * s2;
+                qDot3 -= norm * s3;
+            }
+        }
+
+        q0 += qDot0 * dt;
+        q1 += qDot1 * dt;
+        q2 += qDot2 * dt;
+        q3 += qDot3 * dt;
+    }
+
+    void mahony(float gx, float gy, float gz, float ax, float ay, float az, bool accel, float dt)
+    {
+        if (accel) {
+            // Error is the cross product between the measured and the predicted directions
+            float vx = q1 * q3 - q0 * q2;
+            float vy = q0 * q1 + q2 * q3;
+            float vz = q0 * q0 - 0.5f + q3 * q3;
+            float ex = ay * vz - az * vy;
+            float ey = az * vx - ax * vz;
+            float ez = ax * vy - ay * vx;
+
+            if (__has_mag) {
+                float mx = __mag[0], my = __mag[1], mz = __mag[2];
+                float hx = 2.0f * (mx * (0.5f - q2 * q2 - q3 * q3) + my * (q1 * q2 - q0 * q3) + mz * (q1 * q3 + q0 * q2));
+                float hy = 2.0f * (mx * (q1 * q2 + q0 * q3) + my * (0.5f - q1 * q1 - q3 * q3) + mz * (q2 * q3 - q0 * q1));
+                float bx = sqrtf(hx * hx + hy * hy);
+                float bz = 2.0f * (mx * (q1 * q3 - q0 * q2) + my * (q2 * q3 + q0 * q1) + mz * (0.5f - q1 * q1 - q2 * q2));
+                float wx = bx * (0.5f - q2 * q2 - q3 * q3) + bz * (q1 * q3 - q0 * q2);
+                float wy = bx * (q1 * q2 - q0 * q3) + bz * (q0 * q1 + q2 * q3);
+                float wz = bx * (q0 * q2 + q1 * q3) + bz * (0.5f - q1 * q1 - q2 * q2);
+                ex += my * wz - mz * wy;
+                ey += mz * wx - mx * wz;
+                ez += mx * wy - my * wx;
+            }
+
+            if (__twoKi > 0.0f) {
+                __integral[0] += __twoKi * ex * dt;
+                __integral[1] += __twoKi * ey * dt;
+                __integral[2] += __twoKi * ez * dt;
+                gx += __integral[0];
+                gy += __integral[1];
+                gz += __integral[2];
+            }
+            gx += __twoKp * ex;
+            gy += __twoKp * ey;
+            gz += __twoKp * ez;
+        }
+
+        gx *= 0.5f * dt;
+        gy *= 0.5f * dt;
+        gz *= 0.5f * dt;
+        float a = q0, b = q1, c = q2;
+        q0 += -b * gx - c * gy - q3 * gz;
+        q1 += a * gx + c * gz - q3 * gy;
+        q2 += a * gy - b * gz + q3 * gx;
+        q3 += a * gz + b * gy - c * gx;
+    }
+
+    float q0, q1, q2, q3;
+    Algorithm __algorithm = FUSION_MADGWICK;
+    uint32_t __period_us = 10000;
+    float __beta = 0.1f;
+    float __twoKp = 2.0f;
+    float __twoKi = 0.0f;
+    float __integral[3];
+    float __mag[3] = {0};
+    bool __has_mag = false;
+    bool __initialized;
+    uint32_t __last_us = 0;
+    float __gyro_sum[3];
+    float __accel_sum[3];
+    uint32_t __window_us;
+    uint16_t __window_count;
+};
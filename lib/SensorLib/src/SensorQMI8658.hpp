@@ -41,6 +41,31 @@ typedef struct __IMUdata {
     float z;
 } IMUdata;
 
+// Largest FIFO content, 128 samples
+#ifndef QMI8658_FIFO_BATCH_SIZE
+#define QMI8658_FIFO_BATCH_SIZE     128
+#endif
+
+// Largest read of one transaction when draining the FIFO over I2C
+#ifndef QMI8658_FIFO_BURST_LENGTH
+#if defined(ARDUINO_ARCH_ESP32)
+#define QMI8658_FIFO_BURST_LENGTH   128     // ESP32 Wire buffer
+#elif defined(ARDUINO)
+#define QMI8658_FIFO_BURST_LENGTH   I2C_BUFFER_LENGTH
+#else
+#define QMI8658_FIFO_BURST_LENGTH   252     // The custom read callback takes a uint8_t length
+#endif
+#endif
+
+// FIFO samples as arrays per axis, filled by readFromFifo(IMUbatch *)
+typedef struct __IMUbatch {
+    float accel[3][QMI8658_FIFO_BATCH_SIZE];        // x, y, z
+    float gyro[3][QMI8658_FIFO_BATCH_SIZE];         // x, y, z
+    uint32_t timestamp[QMI8658_FIFO_BATCH_SIZE];    // micros() when the sensor took the sample (estimated)
+    uint16_t count;
+    bool overflow;                                  // The FIFO was full and samples were dropped
+} IMUbatch;
+
 class SensorQMI8658 :
     public SensorCommon<SensorQMI8658>
 {
@@ -386,6 +411,7 @@ public:
         if (writeRegister(QMI8658_REG_CTRL2, 0xF0, odr) != DEV_WIRE_NONE) {
             return DEV_WIRE_ERR;
         }
+        __accel_odr = odr;
 
         if (lpfOdr != LPF_OFF) {
             // setAccelLowPassFitterOdr
@@ -441,6 +467,7 @@ public:
         if (writeRegister(QMI8658_REG_CTRL3, 0xF0, odr) != DEV_WIRE_NONE) {
             return DEV_WIRE_ERR;
         }
+        __gyro_odr = odr;
 
         // setGyroLowPassFitterOdr
         if (lpfOdr != LPF_OFF) {
@@ -517,6 +544,7 @@ public:
         if (writeRegister(QMI8658_REG_FIFO_WTM_TH, trigger_samples ) == DEV_WIRE_ERR) {
             return DEV_WIRE_ERR;
         }
+        __fifo_wtm = trigger_samples;
 
         if (enGyro) {
             enableGyroscope();
@@ -623,9 +651,109 @@ public:
         return samples_per_sensor;
     }
 
+    /**
+     * @brief  readFromFifo
+     * @note   Drains the FIFO in one read session and converts it into per axis arrays with a
+     *         timestamp per sample. configFIFO should be called before use. Meant to be called
+     *         on the watermark interrupt, which gets all the samples since the last one with a
+     *         handful of bus transactions instead of several per sample.
+     * @param  *batch: Receives up to QMI8658_FIFO_BATCH_SIZE samples, the arrays of a disabled sensor are not written
+     * @param  irqMicros: micros() at the rising edge of the FIFO interrupt, 0 when polling
+     * @retval Number of samples in batch
+     */
+    uint16_t readFromFifo(IMUbatch *batch, uint32_t irqMicros = 0)
+    {
+        batch->count = 0;
+        batch->overflow = false;
+
+        if (__fifo_mode == FIFO_MODE_BYPASS) {
+            log_e("FIFO is not configured.");
+            return 0;
+        }
+
+        if (!__gyro_enabled && !__accel_enabled) {
+            log_e("Sensor not enabled.");
+            return 0;
+        }
+
+        uint32_t now = micros();
+        uint16_t data_bytes = readFromFifo();
+        if (data_bytes == 0) {
+            return 0;
+        }
+
+        // Each sample holds the enabled sensors in turn, accelerometer first
+        uint8_t sample_bytes = (__accel_enabled && __gyro_enabled) ? 12 : 6;
+        uint16_t samples = data_bytes / sample_bytes;
+        if (samples > QMI8658_FIFO_BATCH_SIZE) {
+            samples = QMI8658_FIFO_BATCH_SIZE;
+        }
+        const uint8_t *data = __fifo_buffer;
+        if (__accel_enabled) {
+            scaleFifoAxes(data, samples, sample_bytes, accelScales, batch->accel[0], batch->accel[1], batch->accel[2]);
+            data += 6;
+        }
+        if (__gyro_enabled) {
+            scaleFifoAxes(data, samples, sample_bytes, gyroScales, batch->gyro[0], batch->gyro[1], batch->gyro[2]);
+        }
+
+        /*
+        * The FIFO has no time, so the samples are spaced by the output data rate from one of known time:
+        * the watermark sample at the interrupt, or the newest sample when the count was read.
+        * A Stream mode overflow drops the oldest samples, and with them the watermark sample.
+        * */
+        batch->overflow = __fifo_status & _BV(5);
+        uint16_t anchor = samples - 1;
+        if (irqMicros && __fifo_wtm && __fifo_wtm <= samples &&
+                !(batch->overflow && (__fifo_mode & 0x03) == FIFO_MODE_STREAM)) {
+            anchor = __fifo_wtm - 1;
+            now = irqMicros;
+        }
+        int64_t period_ns = getFifoPeriodNs();
+        for (uint16_t i = 0; i < samples; ++i) {
+            batch->timestamp[i] = now + (int32_t)(((int32_t)i - anchor) * period_ns / 1000);
+        }
+
+        batch->count = samples;
+        return samples;
+    }
+
+    // Time between FIFO samples, from the gyroscope output data rate when it is enabled
+    uint32_t getFifoPeriodNs()
+    {
+        if (__gyro_enabled) {
+            // 7174.4Hz halved per step
+            return 139385UL << __gyro_odr;
+        }
+        switch (__accel_odr) {
+        case ACC_ODR_LOWPOWER_128Hz: return 7812500UL;
+        case ACC_ODR_LOWPOWER_21Hz: return 47619048UL;
+        case ACC_ODR_LOWPOWER_11Hz: return 90909091UL;
+        case ACC_ODR_LOWPOWER_3Hz: return 333333333UL;
+        default:
+            // 1000Hz doubled per step below it (8000/4000/2000Hz), halved per step above
+            if (__accel_odr < ACC_ODR_1000Hz) {
+                return 1000000UL >> (ACC_ODR_1000Hz - __accel_odr);
+            }
+            return 1000000UL << (__accel_odr - ACC_ODR_1000Hz);
+        }
+    }
+
 
 private:
 
+    // Little-endian x, y, z at the start of every sample into one array per axis
+    static void scaleFifoAxes(const uint8_t *__restrict data, uint16_t samples, uint8_t sample_bytes, float scales,
+                              float *__restrict x, float *__restrict y, float *__restrict z)
+    {
+        for (uint16_t i = 0; i < samples; ++i) {
+            const uint8_t *p = data + i * sample_bytes;
+            x[i] = (int16_t)(p[1] << 8 | p[0]) * scales;
+            y[i] = (int16_t)(p[3] << 8 | p[2]) * scales;
+            z[i] = (int16_t)(p[5] << 8 | p[4]) * scales;
+        }
+    }
+
     uint16_t getFifoNeedBytes()
     {
         uint8_t sam[] = {16, 32, 64, 128};
@@ -676,13 +804,18 @@ private:
                 log_e("Realloc buffer size %u bytes failed!", alloc_size);
                 return 0;
             }
+            __fifo_size = alloc_size;
         }
 
         // 1.Got FIFO watermark interrupt by INT pin or polling the FIFO_STATUS register (FIFO_WTM and/or FIFO_FULL).
-        int val = readRegister(QMI8658_REG_FIFO_STATUS);
-        if (val == DEV_WIRE_ERR) {
+        // 2.Read the FIFO_SMPL_CNT and FIFO_STATUS registers, to calculate the level of FIFO content data, refer to 8.4 FIFO Sample Count.
+        // FIFO_STATUS follows FIFO_COUNT, so one read gets both
+        if (readRegister(QMI8658_REG_FIFO_COUNT, status, 2) == DEV_WIRE_ERR) {
+            log_e("Bus communication failed!");
             return 0;
         }
+        int val = status[1];
+        __fifo_status = val;
         log_d("FIFO status:0x%x", val);
 
         if (!(val & _BV(4))) {
@@ -700,14 +833,11 @@ private:
             log_d("FIFO is Full");
         }
 
-        // 2.Read the FIFO_SMPL_CNT and FIFO_STATUS registers, to calculate the level of FIFO content data, refer to 8.4 FIFO Sample Count.
-        if (readRegister(QMI8658_REG_FIFO_COUNT, status, 2) == DEV_WIRE_ERR) {
-            log_e("Bus communication failed!");
-            return 0;
-        }
-
         // FIFO_Sample_Count (in byte) = 2 * (fifo_smpl_cnt_msb[1:0] * 256 + fifo_smpl_cnt_lsb[7:0])
         fifo_bytes = 2 * (((status[1] & 0x03)) << 8 | status[0]);
+        if (fifo_bytes > __fifo_size) {
+            fifo_bytes = __fifo_size;
+        }
 
         log_d("reg fifo_bytes:%d ", fifo_bytes);
 
@@ -722,12 +852,24 @@ private:
             return 0;
         }
         // 4.Read from the FIFO_DATA register per FIFO_Sample_Count.
-        if (readRegister(QMI8658_REG_FIFO_DATA, __fifo_buffer, fifo_bytes) == DEV_WIRE_ERR) {
-            log_e("Request FIFO data failed !");
-            return 0;
+        // SPI takes it in one transfer, I2C in reads the Wire buffer (or callback length) can hold
+        uint16_t burst = QMI8658_FIFO_BURST_LENGTH;
+#if defined(ARDUINO)
+        if (__spi) {
+            burst = fifo_bytes;
+        }
+#endif
+        for (uint16_t offset = 0; offset < fifo_bytes; offset += burst) {
+            uint16_t length = fifo_bytes - offset < burst ? fifo_bytes - offset : burst;
+            if (readRegister(QMI8658_REG_FIFO_DATA, __fifo_buffer + offset, length) == DEV_WIRE_ERR) {
+                log_e("Request FIFO data failed !");
+                fifo_bytes = 0;
+                break;
+            }
         }
 
         // 5.Disable the FIFO Read Mode by setting FIFO_CTRL.FIFO_rd_mode to 0. New data will be filled into FIFO afterwards.
+        // Also after a failed read, the FIFO would stay in read mode otherwise
         if (writeRegister(QMI8658_REG_FIFO_CTRL, __fifo_mode) == DEV_WIRE_ERR) {
             log_e("Clear FIFO flag failed!");
             return 0;
@@ -1371,6 +1513,7 @@ public:
         if (writeRegister(QMI8658_REG_CTRL2, 0xF0, odr) != DEV_WIRE_NONE) {
             return DEV_WIRE_ERR;
         }
+        __accel_odr = odr;
 
         //set wom
         if (writeRegister(QMI8658_REG_CAL1_L, WoMThreshold) != DEV_WIRE_NONE) {
@@ -1899,6 +2042,10 @@ private:
     bool __fifo_interrupt = false;;
     uint8_t *__fifo_buffer = NULL;
     uint16_t __fifo_size = 0;
+    uint8_t __fifo_wtm = 0;
+    uint8_t __fifo_status = 0;
+    uint8_t __accel_odr = ACC_ODR_1000Hz;
+    uint8_t __gyro_odr = GYR_ODR_896_8Hz;
 
     EventCallBack_t eventWomEvent = NULL;
     EventCallBack_t eventTagEvent = NULL;
@@ -1921,12 +2068,16 @@ private:
         startMillis = millis();
         do {
             val = readRegister(QMI8658_REG_STATUS_INT);
+            if (val == DEV_WIRE_ERR || (val & 0x80)) {
+                break;
+            }
+            // Only wait while the command runs, most are done by the first read
             delay(1);
             if (millis() - startMillis > wait_ms) {
                 log_e("wait for ctrl9 command done time out : %d val:%d", cmd, val);
                 return DEV_WIRE_TIMEOUT;
             }
-        } while (val != DEV_WIRE_ERR && !(val & 0x80));
+        } while (true);
 
         if (writeRegister(QMI8658_REG_CTRL9, CTRL_CMD_ACK) == DEV_WIRE_ERR) {
             return DEV_WIRE_ERR;
@@ -1935,12 +2086,15 @@ private:
         startMillis = millis();
         do {
             val = readRegister(QMI8658_REG_STATUS_INT);
+            if (val == DEV_WIRE_ERR || !(val & 0x80)) {
+                break;
+            }
             delay(1);
             if (millis() - startMillis > wait_ms) {
                 log_e("Clear ctrl9 command done flag timeout : %d val:%d", cmd, val);
                 return DEV_WIRE_TIMEOUT;
             }
-        } while (val != DEV_WIRE_ERR && (val & 0x80));
+        } while (true);
 
         return DEV_WIRE_NONE;
     }
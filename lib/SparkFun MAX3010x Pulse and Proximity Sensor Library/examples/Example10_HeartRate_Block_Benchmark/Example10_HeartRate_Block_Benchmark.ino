@@ -0,0 +1,226 @@
+/*
+  Block beat detector versus checkForBeat()
+  No sensor needed
+
+  Runs the same IR traces through checkForBeat() one sample at a time and
+  through BeatDetector::process() in blocks of varying size, then prints:
+  -whether every beat decision matched (they must, bit for bit)
+  -samples per second of each, and of four channels with their own detector
+
+  The traces are synthetic at 100 samples per second (Example5_HeartRate's
+  sensor settings): pulses at several rates, a finger put on and taken off,
+  motion and random values that hit every truncation of the filter. On a
+  computer recorded traces can be replayed too, any file of IR values works,
+  one per line as Example4_HeartBeat_Plotter prints them or as "IR=..." lines
+  of Example5_HeartRate:
+
+    g++ -O2 -x c++ Example10_HeartRate_Block_Benchmark.ino ../../src/heartRate.cpp \
+        -I../../src -o beat_bench
+    ./beat_bench [capture.txt ...]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "heartRate.h"
+
+#ifdef ARDUINO
+static inline uint32_t elapsedMicros(uint32_t start) { return micros() - start; }
+static inline uint32_t nowMicros() { return micros(); }
+#else
+// Build on a computer: the little of Arduino this sketch uses
+#include <time.h>
+static inline uint32_t nowMicros() { struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts); return ts.tv_sec * 1000000UL + ts.tv_nsec / 1000; }
+static inline uint32_t elapsedMicros(uint32_t start) { return nowMicros() - start; }
+struct HostSerial {
+  void begin(unsigned long) {}
+  void println(const char *s) { puts(s); }
+} Serial;
+#endif
+
+#define SAMPLE_RATE 100
+#define CHANNELS 4
+#ifdef ARDUINO
+#define MAX_SAMPLES (SAMPLE_RATE * 60)
+#define REPEAT 1
+#else
+#define MAX_SAMPLES (SAMPLE_RATE * 3600)   // longest replayed capture
+#define REPEAT 20                          // timing runs, for a stable figure
+#endif
+
+int32_t samples[MAX_SAMPLES];
+bool beatsRef[MAX_SAMPLES];
+bool beatsBlock[MAX_SAMPLES];
+
+uint32_t seed = 1;
+
+uint32_t random_u32()
+{
+  seed = seed * 1103515245UL + 12345UL;
+  return seed;
+}
+
+float random_unit()
+{
+  return ((random_u32() >> 8) & 0xFFFF) / 65536.0f;
+}
+
+float pulse_shape(float phase)
+{
+  float a = (phase - 0.15f) / (phase < 0.15f ? 0.06f : 0.12f);
+  float b = (phase - 0.42f) / 0.10f;
+  return expf(-a * a) + 0.25f * expf(-b * b);
+}
+
+// Adds a pulse trace at bpm to samples[], returns the new length
+uint32_t add_pulse(uint32_t n, uint32_t seconds, float bpm, float dc, float ac, float noise)
+{
+  float phase = 0;
+  for (uint32_t i = 0; i < seconds * SAMPLE_RATE && n < MAX_SAMPLES; i++, n++) {
+    float wander = 1 + 0.03f * sinf(2 * 3.14159f * 0.25f * i / SAMPLE_RATE);
+    float v = dc * wander * (1 - ac * pulse_shape(phase)) + (random_unit() - 0.5f) * 2 * noise;
+    samples[n] = (int32_t)v;
+    phase += bpm / 60.0f / SAMPLE_RATE;
+    if (phase >= 1) phase -= 1;
+  }
+  return n;
+}
+
+uint32_t make_traces()
+{
+  uint32_t n = 0;
+  seed = 1;
+  n = add_pulse(n, 10, 0, 800, 0, 50);            // no finger
+  n = add_pulse(n, 30, 60, 52000, 0.020f, 20);    // finger on, rest
+  n = add_pulse(n, 30, 75, 61000, 0.020f, 30);
+  n = add_pulse(n, 30, 150, 58000, 0.020f, 40);   // exercise
+  n = add_pulse(n, 20, 80, 120000, 0.010f, 60);   // DC past 16 bits
+  for (uint32_t i = 0; i < 5 * SAMPLE_RATE && n < MAX_SAMPLES; i++, n++) {
+    samples[n] = 60000 + (int32_t)(random_u32() % 40000) - 20000;  // motion
+  }
+  for (uint32_t i = 0; i < 10 * SAMPLE_RATE && n < MAX_SAMPLES; i++, n++) {
+    samples[n] = (int32_t)random_u32();  // anything
+  }
+  n = add_pulse(n, 10, 0, 900, 0, 50);            // finger off
+  return n;
+}
+
+// Block sizes cycle through these, to cross the internal block boundaries at
+// every offset
+const uint16_t blockSizes[] = {1, 7, 32, 33, 100, 3, 64, 25};
+
+void run_block(BeatDetector *det, const int32_t *in, uint32_t n, bool *beats)
+{
+  uint8_t b = 0;
+  for (uint32_t i = 0; i < n; ) {
+    uint16_t len = blockSizes[b++ % (sizeof(blockSizes) / sizeof(blockSizes[0]))];
+    if (len > n - i) len = n - i;
+    det->process(in + i, len, beats + i);
+    i += len;
+  }
+}
+
+void print_rate(const char *name, uint32_t n, uint32_t us)
+{
+  char line[160];
+  snprintf(line, sizeof(line), "  %-36.36s %10lu samples/s", name, (unsigned long)(us ? (uint64_t)n * 1000000 / us : 0));
+  Serial.println(line);
+}
+
+// checkForBeat() keeps its state from the previous trace, so every trace is
+// compared with one detector that has seen the same samples before it
+BeatDetector reference;
+
+void run_trace(const char *name, uint32_t n)
+{
+  char line[160];
+  uint32_t start, us;
+  uint32_t mismatches = 0, beats = 0;
+
+  BeatDetector copy = reference;
+  for (uint32_t i = 0; i < n; i++) beatsRef[i] = checkForBeat(samples[i]);
+  run_block(&reference, samples, n, beatsBlock);
+  for (uint32_t i = 0; i < n; i++) {
+    if (beatsRef[i] != beatsBlock[i]) mismatches++;
+    if (beatsRef[i]) beats++;
+  }
+  snprintf(line, sizeof(line), "%s: %lu samples, %lu beats, %lu mismatches%s", name,
+           (unsigned long)n, (unsigned long)beats, (unsigned long)mismatches, mismatches ? "  FAIL" : "");
+  Serial.println(line);
+
+  // Timing (checkForBeat() carries on from here, it doesn't change the figure)
+  start = nowMicros();
+  for (uint8_t r = 0; r < REPEAT; r++)
+    for (uint32_t i = 0; i < n; i++) beatsRef[i] = checkForBeat(samples[i]);
+  us = elapsedMicros(start);
+  print_rate("checkForBeat()", n * REPEAT, us);
+
+  start = nowMicros();
+  for (uint8_t r = 0; r < REPEAT; r++)
+    for (uint32_t i = 0; i < n; i++) beatsBlock[i] = copy.check(samples[i]);
+  us = elapsedMicros(start);
+  print_rate("BeatDetector::check()", n * REPEAT, us);
+
+  start = nowMicros();
+  for (uint8_t r = 0; r < REPEAT; r++) copy.process(samples, n, beatsBlock);
+  us = elapsedMicros(start);
+  print_rate("BeatDetector::process()", n * REPEAT, us);
+
+  // Channels in turn, 25 samples (a quarter second) each, as from a FIFO drain
+  BeatDetector channels[CHANNELS];
+  uint32_t per = n / CHANNELS;
+  start = nowMicros();
+  for (uint8_t r = 0; r < REPEAT; r++)
+    for (uint32_t i = 0; i < per; i += 25)
+      for (uint8_t c = 0; c < CHANNELS; c++)
+        channels[c].process(samples + c * per + i, (per - i < 25) ? per - i : 25, beatsBlock + c * per + i);
+  us = elapsedMicros(start);
+  snprintf(line, sizeof(line), "BeatDetector::process(), %d channels", CHANNELS);
+  print_rate(line, per * CHANNELS * REPEAT, us);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("Block beat detector benchmark");
+
+  uint32_t n = make_traces();
+  run_trace("synthetic", n);
+}
+
+void loop()
+{
+}
+
+#ifndef ARDUINO
+// Replay a capture: IR values, one per line, or "IR=..." lines
+bool load_capture(const char *path, uint32_t *pn)
+{
+  FILE *f = fopen(path, "r");
+  char text[256];
+  long ir;
+  if (!f) return false;
+  *pn = 0;
+  while (*pn < MAX_SAMPLES && fgets(text, sizeof(text), f)) {
+    if (sscanf(text, "IR=%ld", &ir) != 1 && sscanf(text, "%ld", &ir) != 1) continue;
+    samples[(*pn)++] = (int32_t)ir;
+  }
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  setup();
+  for (int i = 1; i < argc; i++) {
+    uint32_t n;
+    if (!load_capture(argv[i], &n)) {
+      fprintf(stderr, "can't read %s\n", argv[i]);
+      return 1;
+    }
+    run_trace(argv[i], n);
+  }
+  return 0;
+}
+#endif
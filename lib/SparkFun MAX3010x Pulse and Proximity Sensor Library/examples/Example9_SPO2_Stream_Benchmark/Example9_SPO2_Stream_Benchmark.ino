@@ -0,0 +1,263 @@
+/*
+  Streaming SpO2/heart rate estimator versus the batch Maxim algorithm
+  No sensor needed
+
+  Feeds PPG traces to both estimators the way Example8_SPO2 uses the batch one
+  (maxim_heart_rate_and_oxygen_saturation() on the last 100 samples every 25
+  samples) and to maxim_spo2_stream_add_sample() one sample at a time, then
+  prints per trace:
+  -how far each one is from the heart rate and SpO2 the trace was made with
+  -how far the streaming results are from the batch ones
+  -how often each one reports valid results
+  -the cost: cycles per sample (the batch cost is spread over its 25 samples)
+
+  The traces are synthetic (pulse with a dicrotic notch, beat to beat jitter,
+  breathing baseline wander and noise) at 25 samples per second. On a computer
+  recorded traces can be replayed too, any file of Example8_SPO2 output
+  ("red=..., ir=..." lines) works:
+
+    g++ -O2 -x c++ Example9_SPO2_Stream_Benchmark.ino ../../src/spo2_algorithm.cpp \
+        ../../src/spo2_stream.cpp -I../../src -o spo2_bench
+    ./spo2_bench [capture.txt ...]
+
+  On an ESP32 the cycles come from the cycle counter, on other boards from
+  micros() scaled by F_CPU.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "spo2_algorithm.h"
+#include "spo2_stream.h"
+
+#ifdef ARDUINO
+#if defined(ARDUINO_ARCH_ESP32)
+static inline uint32_t cycles() { return ESP.getCycleCount(); }
+#else
+static inline uint32_t cycles() { return micros() * (F_CPU / 1000000UL); }
+#endif
+#else
+// Build on a computer: the little of Arduino this sketch uses
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint32_t cycles() { return (uint32_t)__rdtsc(); }
+#else
+#include <time.h>
+static inline uint32_t cycles() { struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts); return ts.tv_sec * 1000000000UL + ts.tv_nsec; }
+#endif
+struct HostSerial {
+  void begin(unsigned long) {}
+  void println(const char *s) { puts(s); }
+} Serial;
+#endif
+
+#define TRACE_SECONDS 60
+#define MAX_TRACE_SAMPLES (FreqS * 120)  // longest replayed capture
+
+typedef struct {
+  const char *name;
+  float bpm;            // 0: unknown (recorded trace)
+  float ratio;          // (AC/DC red) / (AC/DC IR)
+  float ac_ir;          // pulse amplitude relative to the IR DC
+  float jitter;         // beat to beat change of the period (fraction)
+  float wander;         // baseline wander relative to the DC
+  float noise;          // noise in counts
+} trace_spec_t;
+
+const trace_spec_t traces[] = {
+  {"slow 45 bpm", 45, 0.60f, 0.010f, 0.04f, 0.004f, 40},
+  {"rest 60 bpm", 60, 0.45f, 0.012f, 0.03f, 0.002f, 20},
+  {"normal 75 bpm", 75, 0.60f, 0.010f, 0.05f, 0.003f, 30},
+  {"exercise 120 bpm", 120, 0.55f, 0.008f, 0.04f, 0.004f, 40},
+  {"fast 160 bpm", 160, 0.60f, 0.010f, 0.04f, 0.004f, 40},
+  {"low SpO2 90 bpm", 90, 0.95f, 0.010f, 0.05f, 0.003f, 30},
+  {"weak pulse 70 bpm", 70, 0.65f, 0.004f, 0.05f, 0.002f, 40},
+  {"noisy 80 bpm", 80, 0.60f, 0.010f, 0.08f, 0.006f, 120},
+};
+
+uint32_t irSamples[MAX_TRACE_SAMPLES];
+uint32_t redSamples[MAX_TRACE_SAMPLES];
+uint32_t irBuffer[BUFFER_SIZE];
+uint32_t redBuffer[BUFFER_SIZE];
+
+uint32_t seed = 1;
+
+float random_unit()
+{
+  seed = seed * 1103515245UL + 12345UL;
+  return ((seed >> 8) & 0xFFFF) / 65536.0f;
+}
+
+float pulse_shape(float phase)
+{
+  // fast systolic rise, slow fall with the reflected wave as a shoulder after the notch
+  float a = (phase - 0.15f) / (phase < 0.15f ? 0.06f : 0.12f);
+  float b = (phase - 0.42f) / 0.10f;
+  return expf(-a * a) + 0.25f * expf(-b * b);
+}
+
+uint32_t make_trace(const trace_spec_t *spec)
+{
+  const float dc_ir = 110000, dc_red = 90000;
+  uint32_t n = FreqS * TRACE_SECONDS;
+  float phase = 0, period = 60.0f / spec->bpm;
+
+  seed = 1;
+  for (uint32_t i = 0; i < n; i++) {
+    float t = (float)i / FreqS;
+    float wander = 1 + spec->wander * sinf(2 * 3.14159f * 0.25f * t);
+    float p = pulse_shape(phase);
+    float noise_ir = (random_unit() + random_unit() + random_unit() - 1.5f) * 2 * spec->noise;
+    float noise_red = (random_unit() + random_unit() + random_unit() - 1.5f) * 2 * spec->noise;
+    // more blood absorbs more light: the raw signal dips with every beat
+    irSamples[i] = (uint32_t)(dc_ir * wander * (1 - spec->ac_ir * p) + noise_ir);
+    redSamples[i] = (uint32_t)(dc_red * wander * (1 - spec->ratio * spec->ac_ir * p) + noise_red);
+
+    phase += 1.0f / FreqS / period;
+    if (phase >= 1) {
+      phase -= 1;
+      period = 60.0f / spec->bpm * (1 + spec->jitter * (2 * random_unit() - 1));
+    }
+  }
+  return n;
+}
+
+typedef struct {
+  uint32_t calls;
+  uint32_t hr_valid, spo2_valid;
+  uint32_t hr_err, spo2_err;          // sums of the absolute errors against the trace
+  uint32_t both_hr, both_spo2;        // both valid
+  uint32_t hr_diff, spo2_diff;        // sums of the absolute stream - batch differences
+} compare_t;
+
+int32_t iabs(int32_t x) { return x < 0 ? -x : x; }
+
+void run_trace(const trace_spec_t *spec, uint32_t n)
+{
+  maxim_spo2_stream_t st;
+  compare_t batch, stream;
+  int32_t spo2_ref = -1;
+  uint32_t start, stream_cycles, batch_cycles = 0, batch_max = 0;
+  char line[160];
+
+  memset(&batch, 0, sizeof(batch));
+  memset(&stream, 0, sizeof(stream));
+  if (spec->bpm > 0) spo2_ref = uch_spo2_table[(int)(spec->ratio * 100 + 0.5f)];
+
+  // Streaming alone for its cost
+  maxim_spo2_stream_init(&st);
+  start = cycles();
+  for (uint32_t i = 0; i < n; i++) maxim_spo2_stream_add_sample(&st, irSamples[i], redSamples[i]);
+  stream_cycles = cycles() - start;
+
+  // Both, compared like Example8_SPO2 reads them: every 25 samples after the first 100
+  maxim_spo2_stream_init(&st);
+  for (uint32_t i = 0; i < n; i++) {
+    maxim_spo2_stream_add_sample(&st, irSamples[i], redSamples[i]);
+    if (i + 1 < BUFFER_SIZE || (i + 1) % FreqS) continue;
+
+    int32_t b_spo2, b_hr, s_spo2, s_hr;
+    int8_t b_spo2_ok, b_hr_ok, s_spo2_ok, s_hr_ok;
+    memcpy(irBuffer, &irSamples[i + 1 - BUFFER_SIZE], sizeof(irBuffer));
+    memcpy(redBuffer, &redSamples[i + 1 - BUFFER_SIZE], sizeof(redBuffer));
+    start = cycles();
+    maxim_heart_rate_and_oxygen_saturation(irBuffer, BUFFER_SIZE, redBuffer, &b_spo2, &b_spo2_ok, &b_hr, &b_hr_ok);
+    uint32_t took = cycles() - start;
+    batch_cycles += took;
+    if (took > batch_max) batch_max = took;
+    maxim_spo2_stream_get(&st, &s_spo2, &s_spo2_ok, &s_hr, &s_hr_ok);
+
+    batch.calls++;
+    stream.calls++;
+    if (b_hr_ok) {batch.hr_valid++; batch.hr_err += iabs(b_hr - (int32_t)spec->bpm);}
+    if (s_hr_ok) {stream.hr_valid++; stream.hr_err += iabs(s_hr - (int32_t)spec->bpm);}
+    if (b_spo2_ok) {batch.spo2_valid++; batch.spo2_err += iabs(b_spo2 - spo2_ref);}
+    if (s_spo2_ok) {stream.spo2_valid++; stream.spo2_err += iabs(s_spo2 - spo2_ref);}
+    if (b_hr_ok && s_hr_ok) {stream.both_hr++; stream.hr_diff += iabs(s_hr - b_hr);}
+    if (b_spo2_ok && s_spo2_ok) {stream.both_spo2++; stream.spo2_diff += iabs(s_spo2 - b_spo2);}
+  }
+
+  snprintf(line, sizeof(line), "%s: %lu samples", spec->name, (unsigned long)n);
+  Serial.println(line);
+  if (spec->bpm > 0) {
+    snprintf(line, sizeof(line), "  trace      HR %3d      SpO2 %3d", (int)spec->bpm, (int)spo2_ref);
+    Serial.println(line);
+  }
+  for (int k = 0; k < 2; k++) {
+    compare_t *c = k ? &stream : &batch;
+    if (spec->bpm > 0 && c->calls) {
+      snprintf(line, sizeof(line), "  %s  HR valid %3lu%% err %3lu.%lu  SpO2 valid %3lu%% err %3lu.%lu", k ? "stream" : "batch ",
+               (unsigned long)(c->hr_valid * 100 / c->calls),
+               (unsigned long)(c->hr_valid ? c->hr_err / c->hr_valid : 0), (unsigned long)(c->hr_valid ? c->hr_err * 10 / c->hr_valid % 10 : 0),
+               (unsigned long)(c->spo2_valid * 100 / c->calls),
+               (unsigned long)(c->spo2_valid ? c->spo2_err / c->spo2_valid : 0), (unsigned long)(c->spo2_valid ? c->spo2_err * 10 / c->spo2_valid % 10 : 0));
+    } else if (c->calls) {
+      snprintf(line, sizeof(line), "  %s  HR valid %3lu%%  SpO2 valid %3lu%%", k ? "stream" : "batch ",
+               (unsigned long)(c->hr_valid * 100 / c->calls), (unsigned long)(c->spo2_valid * 100 / c->calls));
+    } else {
+      continue;
+    }
+    Serial.println(line);
+  }
+  snprintf(line, sizeof(line), "  stream-batch  HR diff %lu.%lu (%lu reads)  SpO2 diff %lu.%lu (%lu reads)",
+           (unsigned long)(stream.both_hr ? stream.hr_diff / stream.both_hr : 0), (unsigned long)(stream.both_hr ? stream.hr_diff * 10 / stream.both_hr % 10 : 0),
+           (unsigned long)stream.both_hr,
+           (unsigned long)(stream.both_spo2 ? stream.spo2_diff / stream.both_spo2 : 0), (unsigned long)(stream.both_spo2 ? stream.spo2_diff * 10 / stream.both_spo2 % 10 : 0),
+           (unsigned long)stream.both_spo2);
+  Serial.println(line);
+  snprintf(line, sizeof(line), "  cycles/sample  stream %lu  batch %lu (worst call %lu)",
+           (unsigned long)(stream_cycles / n), (unsigned long)(batch.calls ? batch_cycles / batch.calls / FreqS : 0),
+           (unsigned long)batch_max);
+  Serial.println(line);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("SpO2 streaming estimator benchmark");
+
+  for (uint8_t t = 0; t < sizeof(traces) / sizeof(traces[0]); t++) {
+    uint32_t n = make_trace(&traces[t]);
+    run_trace(&traces[t], n);
+  }
+}
+
+void loop()
+{
+}
+
+#ifndef ARDUINO
+// Replay a capture of Example8_SPO2 output
+bool load_capture(const char *path, uint32_t *pn)
+{
+  FILE *f = fopen(path, "r");
+  char text[256];
+  unsigned long red, ir;
+  if (!f) return false;
+  *pn = 0;
+  while (*pn < MAX_TRACE_SAMPLES && fgets(text, sizeof(text), f)) {
+    if (sscanf(text, "red=%lu, ir=%lu", &red, &ir) != 2) continue;
+    redSamples[*pn] = red;
+    irSamples[*pn] = ir;
+    (*pn)++;
+  }
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  setup();
+  for (int i = 1; i < argc; i++) {
+    trace_spec_t spec = {argv[i], 0, 0, 0, 0, 0, 0};
+    uint32_t n;
+    if (!load_capture(argv[i], &n)) {
+      fprintf(stderr, "can't read %s\n", argv[i]);
+      return 1;
+    }
+    run_trace(&spec, n);
+  }
+  return 0;
+}
+#endif
@@ -3,7 +3,7 @@
   It should also work with the MAX30102. However, the MAX30102 does not have a Green LED.
 
   These sensors use I2C to communicate, as well as a single (optional)
-  interrupt line that is not currently supported in this driver.
+  interrupt line used by beginInterrupt() to drain the FIFO.
 
   Written by Peter Jansen and Nathan Seidle (SparkFun)
   BSD license, all text above must be included in any redistribution.
@@ -135,8 +135,23 @@ static const uint8_t SLOT_GREEN_PILOT = 		0x07;
 
 static const uint8_t MAX_30105_EXPECTEDPARTID = 0x15;
 
+MAX30105 *MAX30105::intInstance = NULL;
+
 MAX30105::MAX30105() {
   // Constructor
+  sense.head = 0; //Instances outside static storage start with an empty buffer too
+  sense.tail = 0;
+  sampleRate = 50; //Power on values
+  sampleAverage = 1;
+  ring = NULL;
+  ringSize = 0;
+  ringHead = 0;
+  ringTail = 0;
+  lostSamples = 0;
+  intPin = -1;
+  almostFull = 32;
+  intPending = false;
+  intTime = 0;
 }
 
 boolean MAX30105::begin(TwoWire &wirePort, uint32_t i2cSpeed, uint8_t i2caddr) {
@@ -223,6 +238,8 @@ void MAX30105::softReset(void) {
     if ((response & MAX30105_RESET) == 0) break; //We're done!
     delay(1); //Let's not over burden the I2C bus
   }
+  sampleRate = 50; //Back to power on values
+  sampleAverage = 1;
 }
 
 void MAX30105::shutDown(void) {
@@ -251,6 +268,9 @@ void MAX30105::setADCRange(uint8_t adcRange) {
 void MAX30105::setSampleRate(uint8_t sampleRate) {
   // sampleRate: one of MAX30105_SAMPLERATE_50, _100, _200, _400, _800, _1000, _1600, _3200
   bitMask(MAX30105_PARTICLECONFIG, MAX30105_SAMPLERATE_MASK, sampleRate);
+
+  static const uint16_t rates[8] = {50, 100, 200, 400, 800, 1000, 1600, 3200};
+  this->sampleRate = rates[(sampleRate >> 2) & 0x07];
 }
 
 void MAX30105::setPulseWidth(uint8_t pulseWidth) {
@@ -323,6 +343,8 @@ void MAX30105::disableSlots(void) {
 //Set sample average (Table 3, Page 18)
 void MAX30105::setFIFOAverage(uint8_t numberOfSamples) {
   bitMask(MAX30105_FIFOCONFIG, MAX30105_SAMPLEAVG_MASK, numberOfSamples);
+  uint8_t shift = (numberOfSamples >> 5) & 0x07;
+  sampleAverage = 1 << (shift > 5 ? 5 : shift); //0xC0 and 0xE0 also average 32 samples
 }
 
 //Resets all points to start in a known state
@@ -698,6 +720,182 @@ uint16_t MAX30105::check(void)
   return (numberOfSamples); //Let the world know how much new data we found
 }
 
+//
+// Interrupt driven FIFO reading
+//
+
+//Give the ring drainFIFO() fills
+void MAX30105::setSampleRing(max30105_sample *ring, uint16_t size)
+{
+  this->ring = ring;
+  ringSize = size;
+  ringHead = 0;
+  ringTail = 0;
+}
+
+//Called on the falling edge of INT, only takes note of the time
+#if defined(ARDUINO_ARCH_ESP32)
+void IRAM_ATTR MAX30105::intHandler(void)
+#else
+void MAX30105::intHandler(void)
+#endif
+{
+  if (intInstance == NULL) return;
+  intInstance->intTime = micros();
+  intInstance->intPending = true;
+}
+
+//INT is open drain and active low, it goes low when almostFull samples wait in the FIFO
+//Reading the FIFO releases it
+//Returns false without a ring to drain to
+boolean MAX30105::beginInterrupt(uint8_t intPin, uint8_t almostFull)
+{
+  if (ring == NULL || ringSize < 2) return (false);
+  if (almostFull < 17) almostFull = 17;
+  if (almostFull > 32) almostFull = 32;
+
+  this->intPin = intPin;
+  this->almostFull = almostFull;
+  intPending = false;
+  intInstance = this;
+
+  pinMode(intPin, INPUT_PULLUP);
+  setFIFOAlmostFull(32 - almostFull); //Counts the free slots
+  enableAFULL();
+  getINT1(); //Clear an old A_FULL so the next one is an edge
+  attachInterrupt(digitalPinToInterrupt(intPin), intHandler, FALLING);
+  return (true);
+}
+
+void MAX30105::endInterrupt(void)
+{
+  if (intPin < 0) return;
+  detachInterrupt(digitalPinToInterrupt(intPin));
+  disableAFULL();
+  intPin = -1;
+  intInstance = NULL;
+}
+
+//Reads the whole FIFO into the ring
+//With an interrupt it does nothing (no I2C) until INT is raised
+//Without one it checks the FIFO pointers every call
+uint16_t MAX30105::drainFIFO(void)
+{
+  boolean fromInterrupt = false;
+  uint32_t anchorTime = 0;
+
+  if (intPin >= 0)
+  {
+    noInterrupts();
+    fromInterrupt = intPending;
+    anchorTime = intTime;
+    intPending = false;
+    interrupts();
+
+    //INT stays low until the FIFO is read, so an edge lost while it was low would stop the interrupts
+    if (fromInterrupt == false && digitalRead(intPin) == HIGH) return (0);
+  }
+  if (ring == NULL) return (0);
+
+  //FIFO_WR_PTR, OVF_COUNTER and FIFO_RD_PTR follow each other: one read for the three
+  _i2cPort->beginTransmission(_i2caddr);
+  _i2cPort->write(MAX30105_FIFOWRITEPTR);
+  _i2cPort->endTransmission(false);
+  _i2cPort->requestFrom((uint8_t)_i2caddr, (uint8_t)3);
+  if (_i2cPort->available() < 3) return (0);
+  byte writePointer = _i2cPort->read() & 0x1F;
+  byte overflow = _i2cPort->read() & 0x1F;
+  byte readPointer = _i2cPort->read() & 0x1F;
+
+  int numberOfSamples = (writePointer - readPointer) & 0x1F;
+  if (overflow > 0)
+  {
+    lostSamples += overflow;
+    if (numberOfSamples == 0) numberOfSamples = 32; //Full
+  }
+  if (numberOfSamples == 0) return (0);
+
+  //Sample k of this read was taken about (k - newest) periods before the newest one
+  //The interrupt marks sample almostFull - 1, unless older ones were lost
+  uint32_t period = (uint32_t)1000000UL * sampleAverage / sampleRate;
+  int anchorIndex = almostFull - 1;
+  if (fromInterrupt == false || overflow > 0 || numberOfSamples < almostFull)
+  {
+    anchorTime = micros();
+    anchorIndex = numberOfSamples - 1;
+  }
+
+  //Get ready to read a burst of data from the FIFO register
+  _i2cPort->beginTransmission(_i2caddr);
+  _i2cPort->write(MAX30105_FIFODATA);
+  _i2cPort->endTransmission(false);
+
+  byte sampleBytes = activeLEDs * 3;
+  int bytesLeftToRead = numberOfSamples * sampleBytes;
+  uint16_t added = 0;
+  int k = 0;
+  while (bytesLeftToRead > 0)
+  {
+    int toGet = bytesLeftToRead;
+    if (toGet > MAX30105_BURST_LENGTH)
+      toGet = MAX30105_BURST_LENGTH - (MAX30105_BURST_LENGTH % sampleBytes); //Whole samples only
+    bytesLeftToRead -= toGet;
+
+    _i2cPort->requestFrom((uint8_t)_i2caddr, (uint8_t)toGet);
+    for ( ; toGet > 0; toGet -= sampleBytes, k++)
+    {
+      uint32_t values[3] = {0, 0, 0};
+      for (byte led = 0; led < activeLEDs && led < 3; led++)
+      {
+        uint32_t value = (uint32_t)_i2cPort->read() << 16;
+        value |= (uint32_t)_i2cPort->read() << 8;
+        value |= _i2cPort->read();
+        values[led] = value & 0x3FFFF; //Zero out all but 18 bits
+      }
+
+      uint16_t next = ringHead + 1;
+      if (next == ringSize) next = 0;
+      if (next == ringTail)
+      {
+        lostSamples++; //Ring full, the reader is late
+        continue;
+      }
+      max30105_sample *sample = &ring[ringHead];
+      sample->red = values[0];
+      sample->IR = values[1];
+      sample->green = values[2];
+      sample->time = anchorTime + (int32_t)(k - anchorIndex) * (int32_t)period;
+      ringHead = next;
+      added++;
+    }
+  }
+
+  return (added);
+}
+
+//Number of samples waiting in the ring
+uint16_t MAX30105::ringAvailable(void)
+{
+  int count = (int)ringHead - (int)ringTail;
+  if (count < 0) count += ringSize;
+  return (count);
+}
+
+boolean MAX30105::ringRead(max30105_sample *sample)
+{
+  if (ringTail == ringHead) return (false);
+  *sample = ring[ringTail];
+  uint16_t next = ringTail + 1;
+  if (next == ringSize) next = 0;
+  ringTail = next;
+  return (true);
+}
+
+uint32_t MAX30105::getLostSamples(void)
+{
+  return (lostSamples);
+}
+
 //Check for new data but give up after a certain amount of time
 //Returns true if new data was found
 //Returns false if new data was not found
@@ -3,7 +3,7 @@
  It should also work with the MAX30102. However, the MAX30102 does not have a Green LED.
 
  These sensors use I2C to communicate, as well as a single (optional)
- interrupt line that is not currently supported in this driver.
+ interrupt line used by beginInterrupt() to drain the FIFO.
  
  Written by Peter Jansen and Nathan Seidle (SparkFun)
  BSD license, all text above must be included in any redistribution.
@@ -43,6 +43,25 @@
 
 #endif
 
+//Largest read of one transaction when draining the whole FIFO with drainFIFO()
+//The ESP32 Wire buffer holds 128 bytes, enough for 21 Red+IR samples at once
+#ifndef MAX30105_BURST_LENGTH
+  #if defined(ARDUINO_ARCH_ESP32)
+    #define MAX30105_BURST_LENGTH 128
+  #else
+    #define MAX30105_BURST_LENGTH I2C_BUFFER_LENGTH
+  #endif
+#endif
+
+//One FIFO sample as stored by drainFIFO()
+typedef struct
+{
+  uint32_t red;
+  uint32_t IR;
+  uint32_t green;
+  uint32_t time; //micros() when the sensor took it (estimated from the interrupt and the sample rate)
+} max30105_sample;
+
 class MAX30105 {
  public: 
   MAX30105(void);
@@ -110,6 +129,17 @@ class MAX30105 {
   uint8_t getReadPointer(void);
   void clearFIFO(void); //Sets the read/write pointers to zero
 
+  //Interrupt driven FIFO reading
+  //The A_FULL interrupt only sets a flag, drainFIFO() then reads the whole FIFO in one burst
+  //into a ring given by the caller. Without an interrupt drainFIFO() costs a flag check.
+  void setSampleRing(max30105_sample *ring, uint16_t size);
+  boolean beginInterrupt(uint8_t intPin, uint8_t almostFull = 24); //INT pin and FIFO samples (17 to 32) raising it
+  void endInterrupt(void);
+  uint16_t drainFIFO(void); //Returns the number of samples added to the ring
+  uint16_t ringAvailable(void);
+  boolean ringRead(max30105_sample *sample); //Oldest sample of the ring, false if it's empty
+  uint32_t getLostSamples(void); //Overwritten in the sensor FIFO or dropped because the ring was full
+
   //Proximity Mode Interrupt Threshold
   void setPROXINTTHRESH(uint8_t val);
 
@@ -140,6 +170,24 @@ class MAX30105 {
   void readRevisionID();
 
   void bitMask(uint8_t reg, uint8_t mask, uint8_t thing);
+
+  //Sample period from the sample rate and averaging, for the timestamps
+  uint16_t sampleRate;
+  uint8_t sampleAverage;
+
+  //Interrupt driven reading
+  max30105_sample *ring;
+  uint16_t ringSize;
+  volatile uint16_t ringHead; //Written by drainFIFO()
+  volatile uint16_t ringTail; //Written by ringRead()
+  uint32_t lostSamples;
+  int16_t intPin; //-1 when drainFIFO() polls
+  uint8_t almostFull;
+  volatile boolean intPending;
+  volatile uint32_t intTime;
+
+  static MAX30105 *intInstance;
+  static void intHandler(void);
  
    #define STORAGE_SIZE 4 //Each long is 4 bytes so limit this to fit on your micro
   typedef struct Record
@@ -165,3 +165,143 @@ int32_t mul16(int16_t x, int16_t y)
 {
   return((long)x * (long)y);
 }
+
+//  Block version
+//  The DC estimator and the edge detection depend on the previous sample, so
+//  they still go sample by sample. The filter does not: it runs over the whole
+//  block from a linear buffer (the history, then the block) with the taps
+//  written out, which leaves the compiler straight line code it can vectorize.
+//  Every intermediate is truncated where checkForBeat() truncates it.
+
+BeatDetector::BeatDetector()
+{
+  reset();
+}
+
+void BeatDetector::reset()
+{
+  avgReg = 0;
+  averageEstimated = 0;
+  for (uint8_t i = 0 ; i < BEAT_FIR_HISTORY ; i++)
+    history[i] = 0;
+
+  acMax = 20;
+  acMin = -20;
+  acSignalCurrent = 0;
+  acSignalMin = 0;
+  acSignalMax = 0;
+  positiveEdge = 0;
+  negativeEdge = 0;
+}
+
+bool BeatDetector::check(int32_t sample)
+{
+  bool beat;
+  processBlock(&sample, 1, &beat);
+  return (beat);
+}
+
+uint16_t BeatDetector::process(const int32_t *samples, uint16_t n, bool *beats)
+{
+  uint16_t count = 0;
+
+  while (n > 0)
+  {
+    uint8_t len = (n > BEAT_BLOCK_SIZE) ? BEAT_BLOCK_SIZE : n;
+    count += processBlock(samples, len, beats);
+    samples += len;
+    if (beats) beats += len;
+    n -= len;
+  }
+  return (count);
+}
+
+uint16_t BeatDetector::processBlock(const int32_t *samples, uint8_t n, bool *beats)
+{
+  int16_t x[BEAT_FIR_HISTORY + BEAT_BLOCK_SIZE]; //Filter input: history, then this block
+  int16_t ac[BEAT_BLOCK_SIZE];
+  uint8_t i;
+
+  for (i = 0 ; i < BEAT_FIR_HISTORY ; i++)
+    x[i] = history[i];
+
+  //  DC removal
+  int32_t reg = avgReg;
+  int16_t average = averageEstimated;
+  for (i = 0 ; i < n ; i++)
+  {
+    reg += ((((int32_t)(uint16_t)samples[i] << 15) - reg) >> 4);
+    average = (int16_t)(reg >> 15);
+    x[BEAT_FIR_HISTORY + i] = (int16_t)(samples[i] - average);
+  }
+  avgReg = reg;
+  averageEstimated = average;
+
+  //  Low pass filter, symmetric taps folded
+  const int16_t c0 = FIRCoeffs[0], c1 = FIRCoeffs[1], c2 = FIRCoeffs[2], c3 = FIRCoeffs[3];
+  const int16_t c4 = FIRCoeffs[4], c5 = FIRCoeffs[5], c6 = FIRCoeffs[6], c7 = FIRCoeffs[7];
+  const int16_t c8 = FIRCoeffs[8], c9 = FIRCoeffs[9], c10 = FIRCoeffs[10], c11 = FIRCoeffs[11];
+  for (i = 0 ; i < n ; i++)
+  {
+    const int16_t *w = &x[i]; //w[22] is the new sample, w[0] the oldest
+    int32_t z = (int32_t)c11 * w[11];
+    z += (int32_t)c0 * (int16_t)(w[22] + w[0]);
+    z += (int32_t)c1 * (int16_t)(w[21] + w[1]);
+    z += (int32_t)c2 * (int16_t)(w[20] + w[2]);
+    z += (int32_t)c3 * (int16_t)(w[19] + w[3]);
+    z += (int32_t)c4 * (int16_t)(w[18] + w[4]);
+    z += (int32_t)c5 * (int16_t)(w[17] + w[5]);
+    z += (int32_t)c6 * (int16_t)(w[16] + w[6]);
+    z += (int32_t)c7 * (int16_t)(w[15] + w[7]);
+    z += (int32_t)c8 * (int16_t)(w[14] + w[8]);
+    z += (int32_t)c9 * (int16_t)(w[13] + w[9]);
+    z += (int32_t)c10 * (int16_t)(w[12] + w[10]);
+    ac[i] = (int16_t)(z >> 15);
+  }
+
+  for (i = 0 ; i < BEAT_FIR_HISTORY ; i++)
+    history[i] = x[n + i];
+
+  //  Edge detection, as in checkForBeat()
+  uint16_t count = 0;
+  int16_t current = acSignalCurrent;
+  for (i = 0 ; i < n ; i++)
+  {
+    int16_t previous = current;
+    bool beatDetected = false;
+    current = ac[i];
+
+    if ((previous < 0) & (current >= 0))
+    {
+      acMax = acSignalMax;
+      acMin = acSignalMin;
+      positiveEdge = 1;
+      negativeEdge = 0;
+      acSignalMax = 0;
+
+      if (((acMax - acMin) > 20) & ((acMax - acMin) < 1000))
+      {
+        beatDetected = true;
+        count++;
+      }
+    }
+
+    if ((previous > 0) & (current <= 0))
+    {
+      positiveEdge = 0;
+      negativeEdge = 1;
+      acSignalMin = 0;
+    }
+
+    if (positiveEdge & (current > previous))
+      acSignalMax = current;
+
+    if (negativeEdge & (current < previous))
+      acSignalMin = current;
+
+    if (beats) beats[i] = beatDetected;
+  }
+  acSignalCurrent = current;
+
+  return (count);
+}
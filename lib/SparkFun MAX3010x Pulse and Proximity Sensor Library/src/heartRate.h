@@ -55,7 +55,12 @@
 * 
 */
 
-#if (ARDUINO >= 100)
+#ifndef HEARTRATE_H
+#define HEARTRATE_H
+
+#if !defined(ARDUINO)
+ #include <stdint.h> //Host builds (benchmarks, tests)
+#elif (ARDUINO >= 100)
  #include "Arduino.h"
 #else
  #include "WProgram.h"
@@ -65,3 +70,43 @@ bool checkForBeat(int32_t sample);
 int16_t averageDCEstimator(int32_t *p, uint16_t x);
 int16_t lowPassFIRFilter(int16_t din);
 int32_t mul16(int16_t x, int16_t y);
+
+#define BEAT_FIR_HISTORY 22 //Previous samples the 23 tap low pass filter needs
+#define BEAT_BLOCK_SIZE 32  //Samples filtered together by BeatDetector::process()
+
+//  The same detector as checkForBeat(), with its state in an object so several
+//  channels or sensors can each have their own, and fed a block of samples at a
+//  time. The beat decisions are bit for bit the ones checkForBeat() makes.
+class BeatDetector {
+ public:
+  BeatDetector();
+  void reset();
+
+  //  Returns true if a beat is detected, like checkForBeat()
+  bool check(int32_t sample);
+
+  //  Runs n samples through the detector
+  //  beats (may be NULL) gets true at the samples where a beat is detected
+  //  Returns the number of beats detected
+  uint16_t process(const int32_t *samples, uint16_t n, bool *beats);
+
+  int16_t getAC(void) { return (acSignalCurrent); } //Filtered AC signal of the last sample
+  int16_t getDC(void) { return (averageEstimated); } //DC estimate of the last sample
+
+ private:
+  uint16_t processBlock(const int32_t *samples, uint8_t n, bool *beats);
+
+  int32_t avgReg;
+  int16_t averageEstimated;
+  int16_t history[BEAT_FIR_HISTORY]; //Filter input of the last samples, oldest first
+
+  int16_t acMax;
+  int16_t acMin;
+  int16_t acSignalCurrent;
+  int16_t acSignalMin;
+  int16_t acSignalMax;
+  int16_t positiveEdge;
+  int16_t negativeEdge;
+};
+
+#endif
@@ -62,7 +62,14 @@
 #ifndef SPO2_ALGORITHM_H_
 #define SPO2_ALGORITHM_H_
 
+#ifdef ARDUINO
 #include <Arduino.h>
+#else
+#include <stdint.h> // host builds of the benchmarks
+#ifndef min
+#define min(x,y) ((x) < (y) ? (x) : (y))
+#endif
+#endif
 
 #define FreqS 25    //sampling frequency
 #define BUFFER_SIZE (FreqS * 4) 
@@ -80,8 +87,6 @@ const uint8_t uch_spo2_table[184]={ 95, 95, 95, 96, 96, 96, 97, 97, 97, 97, 97,
               49, 48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 31, 30, 29, 
               28, 27, 26, 25, 23, 22, 21, 20, 19, 17, 16, 15, 14, 12, 11, 10, 9, 7, 6, 5, 
               3, 2, 1 } ;
-static  int32_t an_x[ BUFFER_SIZE]; //ir
-static  int32_t an_y[ BUFFER_SIZE]; //red
 
 
 #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
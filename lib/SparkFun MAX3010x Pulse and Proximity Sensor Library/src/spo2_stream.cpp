@@ -0,0 +1,297 @@
+/** \file spo2_stream.cpp ******************************************************
+*
+* Description: Streaming heart rate/SpO2 calculation, see spo2_stream.h
+*
+* The moving average of sample i covers the samples i-3..i and belongs to
+* index i-3 like an_x[] in the batch algorithm, so a valley found on it is
+* the index of a raw sample as well.
+*
+*******************************************************************************
+*/
+#include <string.h>
+#include "spo2_stream.h"
+
+#define SPO2_STREAM_RAW_MASK (SPO2_STREAM_RAW_SIZE - 1)
+
+void maxim_spo2_stream_init(maxim_spo2_stream_t *ps)
+/**
+* \brief        Reset the estimator
+*
+* \param[out]   *ps                     - Estimator state
+*
+* \retval       None
+*/
+{
+  memset(ps, 0, sizeof(*ps));
+  ps->n_th_q8 = 30 << 8;
+  ps->n_spo2 = -999;
+  ps->n_heart_rate = -999;
+}
+
+static void spo2_stream_track_max(maxim_spo2_stream_t *ps, uint32_t un_i)
+/**
+* \brief        Add a raw sample to the maxima of the current beat
+*/
+{
+  int32_t n_x = ps->aun_ir[un_i & SPO2_STREAM_RAW_MASK];
+  int32_t n_y = ps->aun_red[un_i & SPO2_STREAM_RAW_MASK];
+  if (n_x > ps->n_x_dc_max) {ps->n_x_dc_max = n_x; ps->un_x_dc_max_idx = un_i;}
+  if (n_y > ps->n_y_dc_max) {ps->n_y_dc_max = n_y; ps->un_y_dc_max_idx = un_i; ps->n_x_at_y_max = n_x;}
+}
+
+static void spo2_stream_update(maxim_spo2_stream_t *ps)
+/**
+* \brief        Heart rate and SpO2 from the valleys and ratios in the window
+* \par          Details
+*               Same formulas as maxim_heart_rate_and_oxygen_saturation(), including
+*               its median of an even count of ratios.
+*
+* \retval       None
+*/
+{
+  int32_t an_ratio[SPO2_STREAM_MAX_RATIOS];
+  int32_t k, n_cnt, n_middle_idx, n_ratio_average;
+
+  if (ps->uch_valley_cnt >= 2) {
+    uint32_t un_first = ps->aun_valleys[ps->uch_valley_head];
+    uint32_t un_last = ps->aun_valleys[(ps->uch_valley_head + ps->uch_valley_cnt - 1) % SPO2_STREAM_MAX_VALLEYS];
+    // intervals over time instead of 60 s over the mean interval: no rounding to whole samples
+    ps->n_heart_rate = (FreqS * 60 * (ps->uch_valley_cnt - 1)) / (int32_t)(un_last - un_first);
+    ps->ch_hr_valid = 1;
+  }
+  else {
+    ps->n_heart_rate = -999;
+    ps->ch_hr_valid = 0;
+  }
+
+  n_cnt = ps->uch_ratio_cnt;
+  for (k = 0; k < n_cnt; k++) an_ratio[k] = ps->an_ratio[(ps->uch_ratio_head + k) % SPO2_STREAM_MAX_RATIOS];
+  if (n_cnt == 0) an_ratio[0] = 0;
+  maxim_sort_ascend(an_ratio, n_cnt);
+  n_middle_idx = n_cnt / 2;
+  if (n_middle_idx > 1)
+    n_ratio_average = (an_ratio[n_middle_idx - 1] + an_ratio[n_middle_idx]) / 2;
+  else
+    n_ratio_average = an_ratio[n_middle_idx];
+
+  if (n_ratio_average > 2 && n_ratio_average < 184) {
+    ps->n_spo2 = uch_spo2_table[n_ratio_average];
+    ps->ch_spo2_valid = 1;
+  }
+  else {
+    ps->n_spo2 = -999;
+    ps->ch_spo2_valid = 0;
+  }
+}
+
+static uint32_t spo2_stream_refine_valley(const maxim_spo2_stream_t *ps, uint32_t un_v)
+/**
+* \brief        The lowest raw IR sample within SPO2_STREAM_REFINE of a valley
+* \par          Details
+*               The moving average and the DC tracking shift the valley by a sample
+*               or two. The ratio interpolates the DC between the raw samples at the
+*               valleys, so they have to be the minima. Not before the beat start.
+*
+* \retval       Sample index of the valley
+*/
+{
+  uint32_t un_k, un_best = un_v;
+  uint32_t un_lo = un_v > SPO2_STREAM_REFINE ? un_v - SPO2_STREAM_REFINE : 0;
+
+  if (ps->un_n - un_v > SPO2_STREAM_RAW_SIZE) return un_v;
+  if (ps->un_n - un_lo > SPO2_STREAM_RAW_SIZE) un_lo = ps->un_n - SPO2_STREAM_RAW_SIZE;
+  if (ps->ch_seg && un_lo <= ps->un_seg_start + 3) un_lo = ps->un_seg_start + 4;
+  for (un_k = un_lo; un_k <= un_v + SPO2_STREAM_REFINE && un_k < ps->un_n; un_k++) {
+    if (ps->aun_ir[un_k & SPO2_STREAM_RAW_MASK] < ps->aun_ir[un_best & SPO2_STREAM_RAW_MASK]) un_best = un_k;
+  }
+  return un_best;
+}
+
+static void spo2_stream_add_valley(maxim_spo2_stream_t *ps, uint32_t un_v, int32_t n_depth)
+/**
+* \brief        A valley is final: close the beat started at the previous one
+* \par          Details
+*               The ratio of the beat is computed like in the batch algorithm (with
+*               its IR AC taken at the red maximum). The samples of the beat not
+*               looked at yet are still in the raw ring unless the valley was found
+*               very late (long flat stretches), else the beat is skipped.
+*
+* \retval       None
+*/
+{
+  int8_t ch_in_ring;
+  uint32_t un_u = ps->un_seg_start;
+
+  ps->n_depth_q8 += ((n_depth << 8) - ps->n_depth_q8) >> 2;
+  un_v = spo2_stream_refine_valley(ps, un_v);
+  ch_in_ring = ps->un_n - un_v <= SPO2_STREAM_RAW_SIZE;
+
+  if (ps->ch_seg && ch_in_ring && un_v - un_u > 3 && un_v - un_u < BUFFER_SIZE &&
+      ps->un_n - ps->un_seg_next <= SPO2_STREAM_RAW_SIZE) {
+    int32_t n_len, n_x_u, n_y_u, n_x_v, n_y_v, n_y_ac, n_x_ac, n_nume, n_denom;
+    if (ps->un_seg_next > un_v) ps->un_seg_next = un_v; // moved back, the samples after it are no maxima
+    while (ps->un_seg_next < un_v) spo2_stream_track_max(ps, ps->un_seg_next++);
+
+    n_len = un_v - un_u;
+    n_x_u = ps->n_x_start;
+    n_y_u = ps->n_y_start;
+    n_x_v = ps->aun_ir[un_v & SPO2_STREAM_RAW_MASK];
+    n_y_v = ps->aun_red[un_v & SPO2_STREAM_RAW_MASK];
+
+    n_y_ac = (n_y_v - n_y_u) * (int32_t)(ps->un_y_dc_max_idx - un_u); //red
+    n_y_ac = n_y_u + n_y_ac / n_len;
+    n_y_ac = ps->n_y_dc_max - n_y_ac;    // subracting linear DC compoenents from raw
+    n_x_ac = (n_x_v - n_x_u) * (int32_t)(ps->un_x_dc_max_idx - un_u); // ir
+    n_x_ac = n_x_u + n_x_ac / n_len;
+    n_x_ac = ps->n_x_at_y_max - n_x_ac;
+    n_nume = (n_y_ac * ps->n_x_dc_max) >> 7; //prepare X100 to preserve floating value
+    n_denom = (n_x_ac * ps->n_y_dc_max) >> 7;
+    if (n_denom > 0 && n_nume != 0) {
+      // the oldest ratio is replaced when the ring is full
+      uint8_t uch_slot = (ps->uch_ratio_head + ps->uch_ratio_cnt) % SPO2_STREAM_MAX_RATIOS;
+      if (ps->uch_ratio_cnt < SPO2_STREAM_MAX_RATIOS) ps->uch_ratio_cnt++;
+      else ps->uch_ratio_head = (ps->uch_ratio_head + 1) % SPO2_STREAM_MAX_RATIOS;
+      ps->an_ratio[uch_slot] = (n_nume * 100) / n_denom;
+      ps->aun_ratio_start[uch_slot] = un_u;
+    }
+  }
+
+  // the next beat starts here
+  ps->ch_seg = ch_in_ring;
+  if (ch_in_ring) {
+    ps->un_seg_start = un_v;
+    ps->un_seg_next = un_v;
+    ps->n_x_start = ps->aun_ir[un_v & SPO2_STREAM_RAW_MASK];
+    ps->n_y_start = ps->aun_red[un_v & SPO2_STREAM_RAW_MASK];
+    ps->n_x_dc_max = -16777216;
+    ps->n_y_dc_max = -16777216;
+  }
+
+  ps->aun_valleys[(ps->uch_valley_head + ps->uch_valley_cnt) % SPO2_STREAM_MAX_VALLEYS] = un_v;
+  if (ps->uch_valley_cnt < SPO2_STREAM_MAX_VALLEYS) ps->uch_valley_cnt++;
+  else ps->uch_valley_head = (ps->uch_valley_head + 1) % SPO2_STREAM_MAX_VALLEYS;
+}
+
+int8_t maxim_spo2_stream_add_sample(maxim_spo2_stream_t *ps, uint32_t un_ir, uint32_t un_red)
+/**
+* \brief        Add a sample
+* \par          Details
+*               Samples are expected at FreqS like for the batch algorithm. The
+*               results are updated when a valley is final (about SPO2_STREAM_DELAY
+*               samples after it) and when the oldest valley leaves the window.
+*
+* \param[in,out] *ps                    - Estimator state
+* \param[in]    un_ir                   - IR sample
+* \param[in]    un_red                  - Red sample
+*
+* \retval       1 if the results changed
+*/
+{
+  uint32_t un_i = ps->un_n++;
+  int8_t ch_changed = 0;
+  int32_t n_ma;
+  uint32_t un_j, un_limit;
+
+  ps->aun_ir[un_i & SPO2_STREAM_RAW_MASK] = un_ir;
+  ps->aun_red[un_i & SPO2_STREAM_RAW_MASK] = un_red;
+
+  // remove DC and invert signal so that we can use peak detector as valley detector
+  if (un_i == 0) ps->n_ir_dc_q8 = (int32_t)un_ir * 256;
+  else ps->n_ir_dc_q8 += ((int32_t)un_ir * 256 - ps->n_ir_dc_q8) >> SPO2_STREAM_DC_SHIFT;
+  ps->n_ac_sum -= ps->an_ac[un_i % MA4_SIZE];
+  ps->an_ac[un_i % MA4_SIZE] = (ps->n_ir_dc_q8 >> 8) - (int32_t)un_ir;
+  ps->n_ac_sum += ps->an_ac[un_i % MA4_SIZE];
+  if (un_i < MA4_SIZE - 1) return 0;
+
+  // 4 pt Moving Average, at index j
+  un_j = un_i - (MA4_SIZE - 1);
+  n_ma = ps->n_ac_sum / (int)4;
+  ps->n_th_q8 += (n_ma * 256 - ps->n_th_q8) >> SPO2_STREAM_TH_SHIFT;
+
+  if (un_j > 0) {
+    int32_t n_th = ps->n_th_q8 >> 8;
+    if (n_th < 30) n_th = 30; // min allowed
+    if (n_th > 60) n_th = 60; // max allowed
+    if (n_th < ps->n_depth_q8 >> (8 + SPO2_STREAM_TH_SHIFT_AMP)) n_th = ps->n_depth_q8 >> (8 + SPO2_STREAM_TH_SHIFT_AMP);
+
+    if (ps->ch_cand && n_ma < ps->n_cand_val) {
+      // right edge, for flat peaks the location is the left edge
+      ps->ch_cand = 0;
+      if (!ps->ch_pend) {
+        ps->ch_pend = 1;
+        ps->un_pend = ps->un_cand;
+        ps->n_pend_val = ps->n_cand_val;
+      }
+      else if (ps->un_cand - ps->un_pend <= SPO2_STREAM_MIN_DISTANCE) {
+        if (ps->n_cand_val > ps->n_pend_val) {
+          ps->un_pend = ps->un_cand;
+          ps->n_pend_val = ps->n_cand_val;
+        }
+      }
+      else {
+        spo2_stream_add_valley(ps, ps->un_pend, ps->n_pend_val);
+        ch_changed = 1;
+        ps->un_pend = ps->un_cand;
+        ps->n_pend_val = ps->n_cand_val;
+      }
+    }
+    else if (ps->ch_cand && n_ma == ps->n_cand_val) {
+      // flat peak, keep looking for its right edge
+    }
+    else if (n_ma > n_th && n_ma > ps->n_prev_ma) {
+      // left edge of a potential peak
+      ps->ch_cand = 1;
+      ps->un_cand = un_j;
+      ps->n_cand_val = n_ma;
+    }
+    else {
+      ps->ch_cand = 0;
+    }
+  }
+  ps->n_prev_ma = n_ma;
+
+  // nothing can come close enough to the pending valley anymore
+  if (ps->ch_pend && un_j - ps->un_pend > SPO2_STREAM_MIN_DISTANCE &&
+      !(ps->ch_cand && ps->un_cand - ps->un_pend <= SPO2_STREAM_MIN_DISTANCE)) {
+    spo2_stream_add_valley(ps, ps->un_pend, ps->n_pend_val);
+    ps->ch_pend = 0;
+    ch_changed = 1;
+  }
+
+  // track the maxima of the beat, without passing a valley which may still be confirmed
+  if (ps->ch_seg) {
+    un_limit = ps->un_n > SPO2_STREAM_DELAY ? ps->un_n - SPO2_STREAM_DELAY : 0;
+    if (ps->ch_pend && ps->un_pend < un_limit) un_limit = ps->un_pend;
+    if (ps->ch_cand && ps->un_cand < un_limit) un_limit = ps->un_cand;
+    if (ps->un_n - ps->un_seg_next > SPO2_STREAM_RAW_SIZE) ps->ch_seg = 0; // lost
+    else while (ps->un_seg_next < un_limit) spo2_stream_track_max(ps, ps->un_seg_next++);
+  }
+
+  // forget what left the window
+  while (ps->uch_valley_cnt && un_j - ps->aun_valleys[ps->uch_valley_head] >= BUFFER_SIZE) {
+    ps->uch_valley_head = (ps->uch_valley_head + 1) % SPO2_STREAM_MAX_VALLEYS;
+    ps->uch_valley_cnt--;
+    ch_changed = 1;
+  }
+  while (ps->uch_ratio_cnt && un_j - ps->aun_ratio_start[ps->uch_ratio_head] >= BUFFER_SIZE) {
+    ps->uch_ratio_head = (ps->uch_ratio_head + 1) % SPO2_STREAM_MAX_RATIOS;
+    ps->uch_ratio_cnt--;
+    ch_changed = 1;
+  }
+
+  if (ch_changed) spo2_stream_update(ps);
+  return ch_changed;
+}
+
+void maxim_spo2_stream_get(const maxim_spo2_stream_t *ps, int32_t *pn_spo2, int8_t *pch_spo2_valid, int32_t *pn_heart_rate, int8_t *pch_hr_valid)
+/**
+* \brief        Latest results, same meaning as the outputs of maxim_heart_rate_and_oxygen_saturation()
+*
+* \retval       None
+*/
+{
+  *pn_spo2 = ps->n_spo2;
+  *pch_spo2_valid = ps->ch_spo2_valid;
+  *pn_heart_rate = ps->n_heart_rate;
+  *pch_hr_valid = ps->ch_hr_valid;
+}
@@ -0,0 +1,101 @@
+/** \file spo2_stream.h ******************************************************
+*
+* Description: Streaming version of maxim_heart_rate_and_oxygen_saturation()
+*
+* The batch algorithm needs BUFFER_SIZE samples and redoes all of its work
+* (mean, moving average, peak search, sorting) on every call, usually every
+* FreqS new samples. This one takes the samples one by one and keeps the
+* same quantities up to date with a bounded amount of work per sample:
+*
+*\n IR DC           running average (exponential) instead of the window mean
+*\n valleys         4 point moving average of the inverted IR AC and a peak
+*\n                 detector following maxim_peaks_above_min_height() and
+*\n                 maxim_remove_close_peaks() as the samples arrive, with
+*\n                 a threshold of at least a quarter of the recent valley
+*\n                 depths and 8 samples between valleys (up to 187 bpm),
+*\n                 then moved onto the lowest raw IR sample next to them
+*\n AC/DC ratios    red and IR maxima tracked between consecutive valleys
+*\n                 from a small ring of raw samples, one ratio per beat
+*\n heart rate      valleys per time over the last BUFFER_SIZE samples
+*\n SpO2            median of the last 5 ratios through uch_spo2_table[]
+*
+* Everything is integer (the ratios use the same scaling as the batch
+* algorithm) and the state is a few hundred bytes instead of two buffers of
+* BUFFER_SIZE samples.
+*
+* The dicrotic shoulder and noise give the batch peak search extra valleys
+* (it only needs 30-60 counts and 4 samples). Those short beats are most of
+* its heart rate error and, with the valleys off the raw minimum, of its
+* SpO2 error: the linear DC between two valleys is then wrong.
+*
+* Usage:
+*\n maxim_spo2_stream_t st;
+*\n maxim_spo2_stream_init(&st);
+*\n every sample: maxim_spo2_stream_add_sample(&st, un_ir, un_red);
+*\n maxim_spo2_stream_get(&st, &n_spo2, &ch_spo2_valid, &n_heart_rate, &ch_hr_valid);
+*
+*******************************************************************************
+*/
+#ifndef SPO2_STREAM_H_
+#define SPO2_STREAM_H_
+
+#include "spo2_algorithm.h"
+
+#define SPO2_STREAM_RAW_SIZE 16   // raw samples kept for the maxima between valleys (power of 2)
+#define SPO2_STREAM_DELAY 8       // the maxima are tracked this many samples behind the input
+#define SPO2_STREAM_DC_SHIFT 3    // the IR DC follows the signal within 2^3 samples (keeps up with breathing)
+#define SPO2_STREAM_TH_SHIFT 6    // the peak threshold follows the mean with 2^6 samples
+#define SPO2_STREAM_MAX_VALLEYS 15
+#define SPO2_STREAM_MAX_RATIOS 5
+#define SPO2_STREAM_TH_SHIFT_AMP 2  // the peak threshold is at least the mean valley depth / 2^2
+#define SPO2_STREAM_MIN_DISTANCE 8  // closer valleys are merged, the deepest is kept
+#define SPO2_STREAM_REFINE 2        // a valley moves to the lowest raw IR sample within +-2
+
+typedef struct {
+  uint32_t un_n;                                  // samples added
+  int32_t n_ir_dc_q8;                             // IR DC, 8 fractional bits
+
+  int32_t an_ac[MA4_SIZE];                        // last inverted IR AC samples
+  int32_t n_ac_sum;
+  int32_t n_prev_ma;                              // previous moving average
+  int32_t n_th_q8;                                // mean of the moving average, 8 fractional bits
+  int32_t n_depth_q8;                             // mean moving average at the valleys, 8 fractional bits
+
+  int8_t ch_cand;                                 // left edge of a possible valley
+  uint32_t un_cand;
+  int32_t n_cand_val;
+  int8_t ch_pend;                                 // valley waiting for a deeper one nearby
+  uint32_t un_pend;
+  int32_t n_pend_val;
+
+  uint32_t aun_valleys[SPO2_STREAM_MAX_VALLEYS];  // sample index of the valleys, ring
+  uint8_t uch_valley_head;
+  uint8_t uch_valley_cnt;
+
+  uint32_t aun_ir[SPO2_STREAM_RAW_SIZE];          // raw samples, ring
+  uint32_t aun_red[SPO2_STREAM_RAW_SIZE];
+
+  int8_t ch_seg;                                  // tracking the maxima after the last valley
+  uint32_t un_seg_start;
+  uint32_t un_seg_next;                           // next sample to look at
+  int32_t n_x_start, n_y_start;                   // raw IR and red at the last valley
+  int32_t n_x_dc_max, n_y_dc_max;
+  uint32_t un_x_dc_max_idx, un_y_dc_max_idx;
+  int32_t n_x_at_y_max;                           // IR at the red maximum
+
+  int32_t an_ratio[SPO2_STREAM_MAX_RATIOS];       // ring
+  uint32_t aun_ratio_start[SPO2_STREAM_MAX_RATIOS];
+  uint8_t uch_ratio_head;
+  uint8_t uch_ratio_cnt;
+
+  int32_t n_spo2;
+  int8_t ch_spo2_valid;
+  int32_t n_heart_rate;
+  int8_t ch_hr_valid;
+} maxim_spo2_stream_t;
+
+void maxim_spo2_stream_init(maxim_spo2_stream_t *ps);
+int8_t maxim_spo2_stream_add_sample(maxim_spo2_stream_t *ps, uint32_t un_ir, uint32_t un_red);
+void maxim_spo2_stream_get(const maxim_spo2_stream_t *ps, int32_t *pn_spo2, int8_t *pch_spo2_valid, int32_t *pn_heart_rate, int8_t *pch_hr_valid);
+
+#endif /* SPO2_STREAM_H_ */
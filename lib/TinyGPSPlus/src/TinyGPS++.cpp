@@ -27,11 +27,6 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <ctype.h>
 #include <stdlib.h>
 
-#define _GPRMCterm   "GPRMC"
-#define _GPGGAterm   "GPGGA"
-#define _GNRMCterm   "GNRMC"
-#define _GNGGAterm   "GNGGA"
-
 TinyGPSPlus::TinyGPSPlus()
   :  parity(0)
   ,  isChecksumTerm(false)
@@ -39,14 +34,30 @@ TinyGPSPlus::TinyGPSPlus()
   ,  curTermNumber(0)
   ,  curTermOffset(0)
   ,  sentenceHasFix(false)
+  ,  inSentence(false)
+  ,  sentenceLen(0)
   ,  customElts(0)
   ,  customCandidates(0)
+  ,  customCandidateCount(0)
+  ,  customNext(0)
+  ,  customNextCount(0)
+  ,  customIndexFull(false)
+  ,  fixCallback(0)
+  ,  fixArg(0)
+  ,  sentenceCallback(0)
+  ,  sentenceArg(0)
+  ,  fixSentences(_GPS_FIX_RMC | _GPS_FIX_GGA)
+  ,  fixSlot(0)
   ,  encodedCharCount(0)
   ,  sentencesWithFixCount(0)
   ,  failedChecksumCount(0)
   ,  passedChecksumCount(0)
 {
   term[0] = '\0';
+  memset(customSentences, 0, sizeof(customSentences));
+  memset(&fixStaging, 0, sizeof(fixStaging));
+  memset(fixSlots, 0, sizeof(fixSlots));
+  fixSlotSeq[0] = fixSlotSeq[1] = 0;
 }
 
 //
@@ -65,25 +76,19 @@ bool TinyGPSPlus::encode(char c)
   case '\n':
   case '*':
     {
-      bool isValidSentence = false;
-      if (curTermOffset < sizeof(term))
-      {
-        term[curTermOffset] = 0;
-        isValidSentence = endOfTermHandler();
-      }
-      ++curTermNumber;
-      curTermOffset = 0;
-      isChecksumTerm = c == '*';
+      bool sentenceEnds = isChecksumTerm && inSentence;
+      bool isValidSentence = endOfTerm(c);
+      if (sentenceEnds)
+        endOfSentence(sentence, sentenceLen, isValidSentence);
+      else if (inSentence)
+        addToSentence(&c, 1);
       return isValidSentence;
     }
-    break;
 
   case '$': // sentence begin
-    curTermNumber = curTermOffset = 0;
-    parity = 0;
-    curSentenceType = GPS_SENTENCE_OTHER;
-    isChecksumTerm = false;
-    sentenceHasFix = false;
+    beginSentence();
+    if (sentenceCallback)
+      addToSentence(&c, 1);
     return false;
 
   default: // ordinary characters
@@ -91,15 +96,247 @@ bool TinyGPSPlus::encode(char c)
       term[curTermOffset++] = c;
     if (!isChecksumTerm)
       parity ^= c;
+    if (inSentence)
+      addToSentence(&c, 1);
     return false;
   }
 
   return false;
 }
 
+// Same as encode(char) on every character of the block, without the call
+// and the switch per character: runs of ordinary characters are copied into
+// the term and folded into the checksum in one loop. All the delimiters sort
+// below '-', so one compare tells nearly every character apart from them.
+// Once nothing but the checksum is left to look at in a sentence (a type we
+// don't parse, no custom field further on), its terms aren't even stored:
+// the rest of it is only folded into the checksum and its commas counted.
+size_t TinyGPSPlus::encode(const char *buf, size_t len)
+{
+  const char *end = buf + len;
+  const char *sentenceStart = buf; // of the one in progress, or where this block joins it
+  size_t validSentences = 0;
+
+  encodedCharCount += len;
+  while (buf < end)
+  {
+    uint8_t x = 0;
+    char c = 0;
+
+    if (curSentenceType == GPS_SENTENCE_OTHER && curTermNumber != 0 && !isChecksumTerm && customNextCount == 0)
+    {
+      uint8_t termNumber = curTermNumber;
+      for ( ; buf < end; ++buf)
+      {
+        c = *buf;
+        if ((uint8_t)c < ',' && (c == '\r' || c == '\n' || c == '*' || c == '$'))
+          break;
+        if ((c == ',') & (termNumber == 255)) // the term number wraps to the sentence name: the general path
+          break;
+        termNumber += (c == ','); // no branch on the commas, they come every few characters
+        x ^= c;
+      }
+      curTermNumber = termNumber;
+      curTermOffset = 0;
+      parity ^= x;
+      if (buf == end)
+        break;
+      x = 0;
+    }
+
+    uint8_t offset = curTermOffset;
+    while (buf < end)
+    {
+      c = *buf;
+      if ((uint8_t)c <= ',' && (c == ',' || c == '\r' || c == '\n' || c == '*' || c == '$'))
+        break;
+      if (offset < sizeof(term) - 1)
+        term[offset++] = c;
+      x ^= c;
+      ++buf;
+    }
+    curTermOffset = offset;
+    if (!isChecksumTerm)
+      parity ^= x;
+    if (buf == end)
+      break;
+
+    ++buf;
+    if (c == '$')
+    {
+      beginSentence();
+      sentenceStart = buf - 1;
+    }
+    else
+    {
+      if (c == ',')
+        parity ^= (uint8_t)c;
+      bool sentenceEnds = isChecksumTerm && inSentence;
+      bool isValidSentence = endOfTerm(c);
+      if (isValidSentence)
+        ++validSentences;
+      if (sentenceEnds)
+      {
+        if (sentenceLen == 0)
+        {
+          endOfSentence(sentenceStart, buf - 1 - sentenceStart, isValidSentence);
+        }
+        else
+        {
+          addToSentence(sentenceStart, buf - 1 - sentenceStart);
+          endOfSentence(sentence, sentenceLen, isValidSentence);
+        }
+      }
+    }
+  }
+
+  // Keep the start of a sentence cut off by the end of the block
+  if (inSentence)
+    addToSentence(sentenceStart, end - sentenceStart);
+  return validSentences;
+}
+
 //
 // internal utilities
 //
+void TinyGPSPlus::beginSentence()
+{
+  curTermNumber = curTermOffset = 0;
+  parity = 0;
+  curSentenceType = GPS_SENTENCE_OTHER;
+  isChecksumTerm = false;
+  sentenceHasFix = false;
+  inSentence = sentenceCallback != NULL;
+  sentenceLen = 0;
+}
+
+// Sentences longer than the buffer are counted on, never given to the callback
+void TinyGPSPlus::addToSentence(const char *chars, size_t len)
+{
+  if (sentenceLen + len > _GPS_MAX_SENTENCE_SIZE)
+  {
+    sentenceLen = _GPS_MAX_SENTENCE_SIZE + 1;
+    return;
+  }
+  memcpy(sentence + sentenceLen, chars, len);
+  sentenceLen += len;
+}
+
+void TinyGPSPlus::endOfSentence(const char *chars, size_t len, bool valid)
+{
+  inSentence = false;
+  sentenceLen = 0;
+  if (sentenceCallback && len <= _GPS_MAX_SENTENCE_SIZE)
+    sentenceCallback(chars, len, valid, sentenceArg);
+}
+
+// Adds what a sentence that just passed its checksum says to the record of
+// its epoch, publishing the record when the epoch is complete
+void TinyGPSPlus::stageFix()
+{
+  uint8_t sentenceBit = curSentenceType == GPS_SENTENCE_GPRMC ? _GPS_FIX_RMC : _GPS_FIX_GGA;
+
+  // A new epoch, or the same sentence again, ends the one so far
+  if (fixStaging.sentences && (fixStaging.time != time.time || (fixStaging.sentences & sentenceBit)))
+    publishFix();
+
+  fixStaging.sentences |= sentenceBit;
+  fixStaging.time = time.time;
+  fixStaging.updated |= _GPS_FIX_TIME;
+  if (sentenceHasFix)
+  {
+    const RawDegrees *deg[2] = {&location.rawLatData, &location.rawLngData};
+    int32_t *out[2] = {&fixStaging.lat, &fixStaging.lng};
+    for (uint8_t i = 0; i < 2; ++i)
+    {
+      int32_t v = (int32_t)deg[i]->deg * 10000000L + (int32_t)((deg[i]->billionths + 50) / 100);
+      *out[i] = deg[i]->negative ? -v : v;
+    }
+    fixStaging.updated |= _GPS_FIX_LOCATION;
+  }
+
+  if (curSentenceType == GPS_SENTENCE_GPRMC)
+  {
+    fixStaging.date = date.date;
+    fixStaging.updated |= _GPS_FIX_DATE;
+    if (sentenceHasFix)
+    {
+      fixStaging.speed = speed.val;
+      fixStaging.course = course.val;
+      fixStaging.updated |= _GPS_FIX_SPEED | _GPS_FIX_COURSE;
+    }
+  }
+  else
+  {
+    if (sentenceHasFix)
+    {
+      fixStaging.altitude = altitude.val;
+      fixStaging.updated |= _GPS_FIX_ALTITUDE;
+    }
+    fixStaging.satellites = satellites.val > 255 ? 255 : (uint8_t)satellites.val;
+    fixStaging.hdop = hdop.val;
+    fixStaging.updated |= _GPS_FIX_SATELLITES | _GPS_FIX_HDOP;
+  }
+
+  if ((fixStaging.sentences & fixSentences) == fixSentences)
+    publishFix();
+}
+
+// Copies the record into the slot readers aren't pointed at, then points
+// them at it. The slot's sequence is odd while it is written, so a reader
+// that was still copying it from two records ago sees the change and retries.
+void TinyGPSPlus::publishFix()
+{
+  uint8_t w = fixSlot ^ 1;
+
+  fixStaging.version = _GPS_FIX_VERSION;
+  fixStaging.sequence = fixSlots[fixSlot].sequence + 1;
+  fixStaging.timestamp = millis();
+
+  fixSlotSeq[w] = fixSlotSeq[w] + 1;
+  _GPS_FENCE();
+  fixSlots[w] = fixStaging;
+  _GPS_FENCE();
+  fixSlotSeq[w] = fixSlotSeq[w] + 1;
+  _GPS_FENCE();
+  fixSlot = w;
+
+  fixStaging.sentences = 0;
+  fixStaging.updated = 0;
+  if (fixCallback)
+    fixCallback(fixSlots[w], fixArg);
+}
+
+bool TinyGPSPlus::getFix(TinyGPSFix &fix) const
+{
+  for (;;)
+  {
+    uint8_t s = fixSlot;
+    uint32_t seq = fixSlotSeq[s];
+    _GPS_FENCE();
+    if (seq & 1)
+      continue;
+    fix = fixSlots[s];
+    _GPS_FENCE();
+    if (fixSlotSeq[s] == seq)
+      return fix.sequence != 0;
+  }
+}
+
+bool TinyGPSPlus::endOfTerm(char c)
+{
+  bool isValidSentence = false;
+  if (curTermOffset < sizeof(term))
+  {
+    term[curTermOffset] = 0;
+    isValidSentence = endOfTermHandler();
+  }
+  ++curTermNumber;
+  curTermOffset = 0;
+  isChecksumTerm = c == '*';
+  return isValidSentence;
+}
+
 int TinyGPSPlus::fromHex(char a)
 {
   if (a >= 'A' && a <= 'F')
@@ -193,8 +430,12 @@ bool TinyGPSPlus::endOfTermHandler()
       }
 
       // Commit all custom listeners of this sentence type
-      for (TinyGPSCustom *p = customCandidates; p != NULL && strcmp(p->sentenceName, customCandidates->sentenceName) == 0; p = p->next)
+      TinyGPSCustom *p = customCandidates;
+      for (uint16_t n = customCandidateCount; n > 0; --n, p = p->next)
          p->commit();
+
+      if (curSentenceType != GPS_SENTENCE_OTHER)
+        stageFix();
       return true;
     }
 
@@ -209,17 +450,24 @@ bool TinyGPSPlus::endOfTermHandler()
   // the first term determines the sentence type
   if (curTermNumber == 0)
   {
-    if (!strcmp(term, _GPRMCterm) || !strcmp(term, _GNRMCterm))
-      curSentenceType = GPS_SENTENCE_GPRMC;
-    else if (!strcmp(term, _GPGGAterm) || !strcmp(term, _GNGGAterm))
-      curSentenceType = GPS_SENTENCE_GPGGA;
-    else
-      curSentenceType = GPS_SENTENCE_OTHER;
+    // All four names are talker GP/GN and RMC/GGA: check the talker, then
+    // the three letters after it as one number
+    curSentenceType = GPS_SENTENCE_OTHER;
+    if (curTermOffset == 5 && term[0] == 'G' && (term[1] == 'P' || term[1] == 'N'))
+    {
+      uint32_t type = ((uint32_t)(uint8_t)term[2] << 16) | ((uint32_t)(uint8_t)term[3] << 8) | (uint8_t)term[4];
+      if (type == (('R' << 16) | ('M' << 8) | 'C'))
+        curSentenceType = GPS_SENTENCE_GPRMC;
+      else if (type == (('G' << 16) | ('G' << 8) | 'A'))
+        curSentenceType = GPS_SENTENCE_GPGGA;
+    }
 
     // Any custom candidates of this sentence type?
-    for (customCandidates = customElts; customCandidates != NULL && strcmp(customCandidates->sentenceName, term) < 0; customCandidates = customCandidates->next);
-    if (customCandidates != NULL && strcmp(customCandidates->sentenceName, term) > 0)
-       customCandidates = NULL;
+    customCandidates = customElts ? findCustom(term, &customCandidateCount) : NULL;
+    if (customCandidates == NULL)
+      customCandidateCount = 0;
+    customNext = customCandidates;
+    customNextCount = customCandidateCount;
 
     return false;
   }
@@ -273,10 +521,16 @@ bool TinyGPSPlus::endOfTermHandler()
       break;
   }
 
-  // Set custom values as needed
-  for (TinyGPSCustom *p = customCandidates; p != NULL && strcmp(p->sentenceName, customCandidates->sentenceName) == 0 && p->termNumber <= curTermNumber; p = p->next)
-    if (p->termNumber == curTermNumber)
-         p->set(term);
+  // Set custom values as needed (the candidates are in term order, so the
+  // ones behind this term are passed for good)
+  while (customNextCount > 0 && customNext->termNumber < curTermNumber)
+  {
+    customNext = customNext->next;
+    --customNextCount;
+  }
+  TinyGPSCustom *p = customNext;
+  for (uint16_t n = customNextCount; n > 0 && p->termNumber == curTermNumber; --n, p = p->next)
+    p->set(term);
 
   return false;
 }
@@ -500,4 +754,78 @@ void TinyGPSPlus::insertCustom(TinyGPSCustom *pElt, const char *sentenceName, in
 
    pElt->next = *ppelt;
    *ppelt = pElt;
+   indexCustom();
+}
+
+// static
+// Hash of a sentence name for the custom sentence index
+uint8_t TinyGPSPlus::nameHash(const char *name)
+{
+   uint8_t h = 0;
+   while (*name)
+      h = (uint8_t)(h * 31 + *name++);
+   return h;
+}
+
+// Rebuilds the index of custom sentence names from the sorted list: where the
+// elements of each name start and how many there are
+void TinyGPSPlus::indexCustom()
+{
+   memset(customSentences, 0, sizeof(customSentences));
+   customIndexFull = false;
+   customCandidates = customNext = NULL;
+   customCandidateCount = customNextCount = 0;
+
+   uint8_t used = 0;
+   for (TinyGPSCustom *p = customElts; p != NULL; )
+   {
+      TinyGPSCustom *first = p;
+      uint16_t count = 0;
+      for ( ; p != NULL && strcmp(p->sentenceName, first->sentenceName) == 0; p = p->next)
+         ++count;
+
+      if (used == _GPS_CUSTOM_SENTENCES)
+      {
+         customIndexFull = true;
+         return;
+      }
+      uint8_t hash = nameHash(first->sentenceName);
+      uint8_t i = hash % _GPS_CUSTOM_SENTENCES;
+      while (customSentences[i].first != NULL)
+         i = (i + 1) % _GPS_CUSTOM_SENTENCES;
+      customSentences[i].first = first;
+      customSentences[i].count = count;
+      customSentences[i].hash = hash;
+      ++used;
+   }
+}
+
+// Custom elements of a sentence, NULL if none
+TinyGPSCustom *TinyGPSPlus::findCustom(const char *sentenceName, uint16_t *count)
+{
+   if (customIndexFull)
+   {
+      // More names than the index holds: walk the sorted list
+      TinyGPSCustom *first;
+      for (first = customElts; first != NULL && strcmp(first->sentenceName, sentenceName) < 0; first = first->next);
+      if (first == NULL || strcmp(first->sentenceName, sentenceName) != 0)
+         return NULL;
+      *count = 0;
+      for (TinyGPSCustom *p = first; p != NULL && strcmp(p->sentenceName, sentenceName) == 0; p = p->next)
+         ++*count;
+      return first;
+   }
+
+   uint8_t hash = nameHash(sentenceName);
+   uint8_t i = hash % _GPS_CUSTOM_SENTENCES;
+   for (uint8_t probes = 0; probes < _GPS_CUSTOM_SENTENCES && customSentences[i].first != NULL; ++probes)
+   {
+      if (customSentences[i].hash == hash && strcmp(customSentences[i].first->sentenceName, sentenceName) == 0)
+      {
+         *count = customSentences[i].count;
+         return customSentences[i].first;
+      }
+      i = (i + 1) % _GPS_CUSTOM_SENTENCES;
+   }
+   return NULL;
 }
@@ -30,6 +30,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "WProgram.h"
 #endif
 #include <limits.h>
+#include <stddef.h>
 
 #define _GPS_VERSION "1.0.2" // software version of this library
 #define _GPS_MPH_PER_KNOT 1.15077945
@@ -39,6 +40,29 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define _GPS_KM_PER_METER 0.001
 #define _GPS_FEET_PER_METER 3.2808399
 #define _GPS_MAX_FIELD_SIZE 15
+#define _GPS_CUSTOM_SENTENCES 8 // custom sentence names found by hash, more are found by walking the list
+#define _GPS_MAX_SENTENCE_SIZE 82 // longest sentence given to the sentence callback ('$' to checksum, NMEA allows 80)
+#define _GPS_FIX_VERSION 1
+
+// Sentences of a fix record
+#define _GPS_FIX_RMC 0x01
+#define _GPS_FIX_GGA 0x02
+
+// Fields of a fix record
+#define _GPS_FIX_LOCATION   0x01
+#define _GPS_FIX_DATE       0x02
+#define _GPS_FIX_TIME       0x04
+#define _GPS_FIX_SPEED      0x08
+#define _GPS_FIX_COURSE     0x10
+#define _GPS_FIX_ALTITUDE   0x20
+#define _GPS_FIX_SATELLITES 0x40
+#define _GPS_FIX_HDOP       0x80
+
+#if defined(__GNUC__)
+#define _GPS_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define _GPS_FENCE()
+#endif
 
 struct RawDegrees
 {
@@ -189,6 +213,26 @@ struct TinyGPSHDOP : TinyGPSDecimal
    double hdop() { return value() / 100.0; }
 };
 
+// Everything one epoch's RMC and GGA say, in one record
+// Naturally aligned fields, no padding: it can be stored or sent as it is.
+struct TinyGPSFix
+{
+   uint8_t version;      // _GPS_FIX_VERSION
+   uint8_t sentences;    // _GPS_FIX_RMC/GGA: the sentences of this epoch that made it
+   uint8_t updated;      // _GPS_FIX_LOCATION...: the fields from this epoch, the others are older
+   uint8_t satellites;
+   uint32_t sequence;    // 1 for the first record, one more for each after it
+   uint32_t date;        // DDMMYY
+   uint32_t time;        // HHMMSSCC
+   int32_t lat;          // 1e-7 degrees, south negative
+   int32_t lng;          // 1e-7 degrees, west negative
+   int32_t altitude;     // centimeters
+   int32_t speed;        // 1/100 knots
+   int32_t course;       // 1/100 degrees
+   int32_t hdop;         // 1/100
+   uint32_t timestamp;   // millis() when it was published
+};
+
 class TinyGPSPlus;
 class TinyGPSCustom
 {
@@ -221,8 +265,27 @@ class TinyGPSPlus
 public:
   TinyGPSPlus();
   bool encode(char c); // process one character received from GPS
+  size_t encode(const char *buf, size_t len); // process a block received from GPS, returns the number of valid sentences in it
   TinyGPSPlus &operator << (char c) {encode(c); return *this;}
 
+  // Events, called from encode()
+  // The fix callback gets a record when the sentences set by setFixSentences()
+  // (RMC and GGA by default) of an epoch have passed their checksum, or when
+  // the next epoch starts without them. The sentence callback gets every
+  // sentence with a checksum ('$' to the checksum digits, not NUL terminated)
+  // and whether it passed. It points into the block given to encode() when
+  // the whole sentence is in it, into the parser otherwise, and is only good
+  // during the call.
+  typedef void (*FixCallback)(const TinyGPSFix &fix, void *arg);
+  typedef void (*SentenceCallback)(const char *sentence, size_t len, bool valid, void *arg);
+  void onFix(FixCallback callback, void *arg = NULL) { fixCallback = callback; fixArg = arg; }
+  void onSentence(SentenceCallback callback, void *arg = NULL) { sentenceCallback = callback; sentenceArg = arg; inSentence = false; }
+  void setFixSentences(uint8_t sentences) { fixSentences = sentences; }
+
+  // Latest fix record, whole even while another task or core runs encode()
+  // Returns false before the first one.
+  bool getFix(TinyGPSFix &fix) const;
+
   TinyGPSLocation location;
   TinyGPSDate date;
   TinyGPSTime time;
@@ -257,12 +320,43 @@ private:
   uint8_t curTermNumber;
   uint8_t curTermOffset;
   bool sentenceHasFix;
+  bool inSentence;
+  uint8_t sentenceLen;
+  char sentence[_GPS_MAX_SENTENCE_SIZE]; // sentence so far, for the callback
 
   // custom element support
   friend class TinyGPSCustom;
   TinyGPSCustom *customElts;
   TinyGPSCustom *customCandidates;
+  uint16_t customCandidateCount;
+  TinyGPSCustom *customNext; // first candidate not behind the current term
+  uint16_t customNextCount;
+  struct CustomSentence
+  {
+    TinyGPSCustom *first; // NULL: free
+    uint16_t count;
+    uint8_t hash;
+  };
+  CustomSentence customSentences[_GPS_CUSTOM_SENTENCES]; // open addressing on the sentence name
+  bool customIndexFull;
   void insertCustom(TinyGPSCustom *pElt, const char *sentenceName, int index);
+  void indexCustom();
+  TinyGPSCustom *findCustom(const char *sentenceName, uint16_t *count);
+
+  // events
+  FixCallback fixCallback;
+  void *fixArg;
+  SentenceCallback sentenceCallback;
+  void *sentenceArg;
+  uint8_t fixSentences;
+  TinyGPSFix fixStaging; // this epoch so far
+  TinyGPSFix fixSlots[2]; // written in turn: the one being written is never the published one
+  volatile uint32_t fixSlotSeq[2]; // odd while its slot is written
+  volatile uint8_t fixSlot; // published slot
+  void stageFix();
+  void publishFix();
+  void addToSentence(const char *chars, size_t len);
+  void endOfSentence(const char *chars, size_t len, bool valid);
 
   // statistics
   uint32_t encodedCharCount;
@@ -272,6 +366,9 @@ private:
 
   // internal utilities
   int fromHex(char a);
+  static uint8_t nameHash(const char *name);
+  void beginSentence();
+  bool endOfTerm(char c);
   bool endOfTermHandler();
 };
 
@@ -2534,9 +2534,11 @@ public:
     */
     uint64_t getIrqStatus(void)
     {
-        statusRegister[0] = readRegister(XPOWERS_AXP2101_INTSTS1);
-        statusRegister[1] = readRegister(XPOWERS_AXP2101_INTSTS2);
-        statusRegister[2] = readRegister(XPOWERS_AXP2101_INTSTS3);
+        // Whatever raised the interrupt changed the status the snapshot holds
+        invalidateSnapshot();
+        if (readRegister(XPOWERS_AXP2101_INTSTS1, statusRegister, XPOWERS_AXP2101_INTSTS_CNT) != 0) {
+            memset(statusRegister, 0, sizeof(statusRegister));
+        }
         return (uint32_t)(statusRegister[0] << 16) | (uint32_t)(statusRegister[1] << 8) | (uint32_t)(statusRegister[2]);
     }
 
@@ -2546,10 +2548,10 @@ public:
      */
     void clearIrqStatus()
     {
-        for (int i = 0; i < XPOWERS_AXP2101_INTSTS_CNT; i++) {
-            writeRegister(XPOWERS_AXP2101_INTSTS1 + i, 0xFF);
-            statusRegister[i] = 0;
-        }
+        uint8_t clear[XPOWERS_AXP2101_INTSTS_CNT];
+        memset(clear, 0xFF, sizeof(clear));
+        writeRegister(XPOWERS_AXP2101_INTSTS1, clear, XPOWERS_AXP2101_INTSTS_CNT);
+        memset(statusRegister, 0, sizeof(statusRegister));
     }
 
     /*
@@ -3018,8 +3020,15 @@ protected:
 
     bool initImpl()
     {
+        // Status, ADC results and fuel gauge, the registers a battery display reads
+        static const xpowers_shadow_span_t snapshot[] = {
+            {XPOWERS_AXP2101_STATUS1, 2},
+            {XPOWERS_AXP2101_ADC_DATA_RELUST0, 10},
+            {XPOWERS_AXP2101_BAT_PERCENT_DATA, 1},
+        };
         if (getChipID() == XPOWERS_AXP2101_CHIP_ID) {
             setChipModel(XPOWERS_AXP2101);
+            setShadowSpans(snapshot, sizeof(snapshot) / sizeof(snapshot[0]));
             disableTSPinMeasure();      //Disable NTC temperature detection by default
             return true;
         }
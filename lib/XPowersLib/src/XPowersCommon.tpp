@@ -32,6 +32,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <string.h>
 
 #if defined(ARDUINO)
 #include <Wire.h>
@@ -54,6 +55,24 @@
 
 #define XPOWERSLIB_I2C_MASTER_SPEED            400000
 
+// Bytes of the register snapshot, see setSnapshotMaxAge()
+#ifndef XPOWERS_SHADOW_SIZE
+#define XPOWERS_SHADOW_SIZE                    16
+#endif
+
+// Millisecond clock of the snapshot max-age
+#ifndef XPOWERS_MILLIS
+#if defined(ARDUINO)
+#define XPOWERS_MILLIS()                       millis()
+#elif defined(ESP_PLATFORM)
+#include "esp_timer.h"
+#define XPOWERS_MILLIS()                       ((uint32_t)(esp_timer_get_time() / 1000))
+#else
+// No clock, a snapshot is kept until it is invalidated
+#define XPOWERS_MILLIS()                       0
+#endif
+#endif
+
 
 #ifdef _BV
 #undef _BV
@@ -129,6 +148,12 @@
 
 typedef int (*iic_fptr_t)(uint8_t devAddr, uint8_t regAddr, uint8_t *data, uint8_t len);
 
+// A run of registers read in one burst into the snapshot
+typedef struct {
+    uint8_t reg;
+    uint8_t length;
+} xpowers_shadow_span_t;
+
 template <class chipType>
 class XPowersCommon
 {
@@ -284,6 +309,71 @@ public:
     }
 
     int readRegister(uint8_t reg, uint8_t *buf, uint8_t length)
+    {
+        if (__shadow_max_age) {
+            int offset = shadowOffset(reg, length);
+            if (offset >= 0 && (snapshotFresh() || updateSnapshot())) {
+                memcpy(buf, __shadow + offset, length);
+                return 0;
+            }
+        }
+        return readBus(reg, buf, length);
+    }
+
+    int writeRegister(uint8_t reg, uint8_t *buf, uint8_t length)
+    {
+        // What a register reads back after a write is up to the chip, read it again
+        if (__shadow_spans && shadowOverlaps(reg, length)) {
+            invalidateSnapshot();
+        }
+        return writeBus(reg, buf, length);
+    }
+
+    /**
+     * @brief  Serve the status, ADC and gauge registers of the chip from a snapshot.
+     * @note   The first read after the snapshot is invalidated or older than maxAgeMs
+     *         reads all of them again, in one burst per run of registers, and the
+     *         reads that follow cost no bus transaction. Call invalidateSnapshot()
+     *         from the PMU interrupt so status changes are seen at once.
+     * @param  maxAgeMs: 0 reads every register from the chip (default)
+     */
+    void setSnapshotMaxAge(uint32_t maxAgeMs)
+    {
+        __shadow_max_age = __shadow_spans ? maxAgeMs : 0;
+        invalidateSnapshot();
+    }
+
+    // The next read of a snapshot register reads them all again, safe to call from an ISR
+    void invalidateSnapshot()
+    {
+        __shadow_valid = false;
+    }
+
+    /**
+     * @brief  Read the snapshot registers now
+     * @retval false on a bus error, reads then go to the chip until a snapshot succeeds
+     */
+    bool updateSnapshot()
+    {
+        if (!__shadow_spans) {
+            return false;
+        }
+        __shadow_valid = false;
+        uint8_t *dst = __shadow;
+        for (uint8_t i = 0; i < __shadow_span_cnt; ++i) {
+            if (readBus(__shadow_spans[i].reg, dst, __shadow_spans[i].length) != 0) {
+                return false;
+            }
+            dst += __shadow_spans[i].length;
+        }
+        __shadow_ms = XPOWERS_MILLIS();
+        __shadow_valid = true;
+        return true;
+    }
+
+protected:
+
+    int readBus(uint8_t reg, uint8_t *buf, uint8_t length)
     {
         if (thisReadRegCallback) {
             return thisReadRegCallback(__addr, reg, buf, length);
@@ -325,7 +415,7 @@ public:
         return -1;
     }
 
-    int writeRegister(uint8_t reg, uint8_t *buf, uint8_t length)
+    int writeBus(uint8_t reg, uint8_t *buf, uint8_t length)
     {
         if (thisWriteRegCallback) {
             return thisWriteRegCallback(__addr, reg, buf, length);
@@ -371,6 +461,53 @@ public:
 #endif //ESP_PLATFORM
     }
 
+    // Registers of the snapshot, set by the chip in initImpl()
+    void setShadowSpans(const xpowers_shadow_span_t *spans, uint8_t count)
+    {
+        uint16_t size = 0;
+        for (uint8_t i = 0; i < count; ++i) {
+            size += spans[i].length;
+        }
+        if (size > XPOWERS_SHADOW_SIZE) {
+            log_e("Snapshot needs %u bytes, XPOWERS_SHADOW_SIZE is %u", size, XPOWERS_SHADOW_SIZE);
+            return;
+        }
+        __shadow_spans = spans;
+        __shadow_span_cnt = count;
+        invalidateSnapshot();
+    }
+
+    bool snapshotFresh()
+    {
+        return __shadow_valid && (uint32_t)(XPOWERS_MILLIS() - __shadow_ms) < __shadow_max_age;
+    }
+
+    // Offset of registers reg..reg+length-1 in the snapshot, -1 if not all in one span
+    int shadowOffset(uint8_t reg, uint8_t length)
+    {
+        int offset = 0;
+        for (uint8_t i = 0; i < __shadow_span_cnt; ++i) {
+            const xpowers_shadow_span_t &span = __shadow_spans[i];
+            if (reg >= span.reg && reg + length <= span.reg + span.length) {
+                return offset + reg - span.reg;
+            }
+            offset += span.length;
+        }
+        return -1;
+    }
+
+    bool shadowOverlaps(uint8_t reg, uint8_t length)
+    {
+        for (uint8_t i = 0; i < __shadow_span_cnt; ++i) {
+            const xpowers_shadow_span_t &span = __shadow_spans[i];
+            if (reg < span.reg + span.length && span.reg < reg + length) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
 
     bool inline clrRegisterBit(uint8_t registers, uint8_t bit)
     {
@@ -506,4 +643,11 @@ protected:
     uint8_t     __addr                  = 0xFF;
     iic_fptr_t  thisReadRegCallback     = NULL;
     iic_fptr_t  thisWriteRegCallback    = NULL;
+
+    const xpowers_shadow_span_t *__shadow_spans = NULL;
+    uint8_t     __shadow_span_cnt       = 0;
+    uint8_t     __shadow[XPOWERS_SHADOW_SIZE];
+    volatile bool __shadow_valid        = false;
+    uint32_t    __shadow_ms             = 0;
+    uint32_t    __shadow_max_age        = 0;
 };
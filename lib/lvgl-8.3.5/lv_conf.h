@@ -64,6 +64,31 @@
     #define LV_MEM_CUSTOM_ALLOC   malloc
     #define LV_MEM_CUSTOM_FREE    free
     #define LV_MEM_CUSTOM_REALLOC realloc
+
+    /*Allocator for large, rarely written buffers such as render caches (e.g. PSRAM).
+     *`LV_MEM_CUSTOM_FREE` has to be able to free this memory too.*/
+    #define LV_MEM_CUSTOM_LARGE_INCLUDE <esp32-hal-psram.h>
+    #define LV_MEM_CUSTOM_LARGE_ALLOC   ps_malloc
+
+    /*Serve the small allocations (objects, styles, linked list nodes, etc.) from fixed size classes
+     *to not fragment the heap. The classes grow in chunks allocated with `LV_MEM_CUSTOM_ALLOC`
+     *or with `LV_MEM_CUSTOM_LARGE_ALLOC` if it fails.*/
+    #define LV_MEM_CUSTOM_POOL 1
+    #if LV_MEM_CUSTOM_POOL
+        /*Size of a chunk of a size class in bytes*/
+        #define LV_MEM_CUSTOM_POOL_CHUNK_SIZE (2 * 1024)
+
+        /*Max. number of the chunks.
+         *If all are used, the allocations go to `LV_MEM_CUSTOM_ALLOC` directly.*/
+        #define LV_MEM_CUSTOM_POOL_CHUNK_MAX 64
+    #endif
+
+    /*Optional functions to get the state of the system heap for `lv_mem_monitor()`*/
+    #define LV_MEM_CUSTOM_MONITOR_INCLUDE <esp_heap_caps.h>
+    #define LV_MEM_CUSTOM_TOTAL_SIZE()          heap_caps_get_total_size(MALLOC_CAP_INTERNAL)
+    #define LV_MEM_CUSTOM_FREE_SIZE()           heap_caps_get_free_size(MALLOC_CAP_INTERNAL)
+    #define LV_MEM_CUSTOM_BIGGEST_FREE_SIZE()   heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL)
+    #define LV_MEM_CUSTOM_MIN_FREE_SIZE()       heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL)
 #endif     /*LV_MEM_CUSTOM*/
 
 /*Number of the intermediate memory buffer used during rendering and other internal processing mechanisms.
@@ -121,6 +146,16 @@
     * radius * 4 bytes are used per circle (the most often used radiuses are saved)
     * 0: to disable caching */
     #define LV_CIRCLE_CACHE_SIZE 4
+
+    /* Set number of maximally cached ring (arc) coverage tables.
+    * The row spans and anti-aliased edges of a 1/4 ring are saved for each (radius, width) pair
+    * and used by the arc drawing to blend only the pixels of the ring instead of masking its whole area.
+    * About radius * 12 bytes + the anti-aliased pixels are used per ring
+    * 0: to disable caching */
+    #define LV_RING_MASK_CACHE_SIZE 4
+
+    /*Ring tables larger than this are allocated with `LV_MEM_CUSTOM_LARGE_ALLOC` (if `LV_MEM_CUSTOM == 1`)*/
+    #define LV_RING_MASK_CACHE_LARGE_LIMIT (4 * 1024)
 #endif /*LV_DRAW_COMPLEX*/
 
 /**
@@ -168,10 +203,45 @@
     #define LV_DITHER_ERROR_DIFFUSION 0
 #endif
 
+/*Keep gradient color maps, blurred shadow corners and decoded images in a common cache.
+ *Small items are stored in the internal RAM, larger ones with `LV_MEM_CUSTOM_LARGE_ALLOC` (e.g. PSRAM).
+ *The budget of each tier is reserved as one block by `lv_init()`, so drawing doesn't allocate memory.
+ *The least recently used items are dropped when the budget of a tier is exceeded.
+ *Replaces LV_GRAD_CACHE_DEF_SIZE and LV_SHADOW_CACHE_SIZE.
+ *Hits, misses and evictions can be read with `lv_render_cache_get_stat()`*/
+#define LV_USE_RENDER_CACHE 1
+#if LV_USE_RENDER_CACHE
+    /*Items up to this size [bytes] are stored in the internal RAM tier*/
+    #define LV_RENDER_CACHE_SMALL_ITEM_SIZE 1024
+
+    /*The budgets are the working sets of the screens of the firmware, see tools/render_cache/render_cache_replay.cpp*/
+
+    /*Budget of the internal RAM tier [bytes]. The screens draw no gradients or shadows.*/
+    #define LV_RENDER_CACHE_INTERNAL_SIZE 0
+
+    /*Budget of the large item (e.g. PSRAM) tier [bytes]. ~27 kB of glyphs.*/
+    #define LV_RENDER_CACHE_LARGE_SIZE (32 * 1024)
+
+    /*Keep the 8 bit coverage of glyphs having at least this many pixels in the large tier
+     *instead of unpacking their 1..4 bpp bitmap on every redraw. 0: don't cache glyphs*/
+    #define LV_RENDER_CACHE_GLYPH_MIN_SIZE 400
+#endif
+
 /*Maximum buffer size to allocate for rotation.
  *Only used if software rotation is enabled in the display driver.*/
 #define LV_DISP_ROT_MAX_BUF (10*1024)
 
+/*Fill and blend RGB565 pixels with kernels which handle more pixels per iteration
+ *(in 32 or 64 bit words, according to the architecture) instead of pixel by pixel.
+ *The result is the same as without them. Used only with LV_COLOR_DEPTH 16 and LV_COLOR_16_SWAP 0*/
+#define LV_DRAW_SW_RGB565_KERNEL 1
+#if LV_DRAW_SW_RGB565_KERNEL
+    /*Header of platform specific (e.g. SIMD) kernels.
+     *Define e.g. `LV_DRAW_SW_RGB565_FILL_CUSTOM` in it to replace `lv_draw_sw_rgb565_fill()` with an own implementation.
+     *See `src/draw/sw/lv_draw_sw_blend_rgb565.h` for the list of kernels*/
+    //#define LV_DRAW_SW_RGB565_KERNEL_INCLUDE "my_rgb565_kernels.h"
+#endif
+
 /*-------------
  * GPU
  *-----------*/
@@ -398,6 +468,10 @@
  *Compiler error will be triggered if a font needs it.*/
 #define LV_FONT_FMT_TXT_LARGE 0
 
+/*Number of (letter, next letter) pairs whose glyph ID and kerning value are remembered
+ *to not search the character maps and the kerning table again. Must be a power of 2. 0: disable*/
+#define LV_FONT_FMT_TXT_PAIR_CACHE_SIZE 64
+
 /*Enables/disables support for compressed fonts.*/
 #define LV_USE_FONT_COMPRESSED 0
 
@@ -483,6 +557,7 @@
 #if LV_USE_LABEL
     #define LV_LABEL_TEXT_SELECTION 1 /*Enable selecting text of the label*/
     #define LV_LABEL_LONG_TXT_HINT 1  /*Store some extra info in labels to speed up drawing of very long texts*/
+    #define LV_LABEL_FROZEN 0         /*Allow rendering the text of a label once to an A8 bitmap and blit it afterwards*/
 #endif
 
 #define LV_USE_LINE       1
@@ -680,7 +755,7 @@
  *----------*/
 
 /*1: Enable API to take snapshot for object*/
-#define LV_USE_SNAPSHOT 0
+#define LV_USE_SNAPSHOT 1
 
 /*1: Enable Monkey test*/
 #define LV_USE_MONKEY 0
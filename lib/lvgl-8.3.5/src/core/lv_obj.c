@@ -138,6 +138,9 @@ void lv_init(void)
     _lv_img_decoder_init();
 #if LV_IMG_CACHE_DEF_SIZE
     lv_img_cache_set_size(LV_IMG_CACHE_DEF_SIZE);
+#endif
+#if LV_USE_RENDER_CACHE
+    _lv_render_cache_init();
 #endif
     /*Test if the IDE has UTF-8 encoding*/
     char * txt = "Á";
@@ -187,6 +190,12 @@ void lv_init(void)
 
 void lv_deinit(void)
 {
+#if LV_DRAW_COMPLEX
+    _lv_draw_mask_deinit();
+#endif
+#if LV_USE_RENDER_CACHE
+    _lv_render_cache_deinit();
+#endif
     _lv_gc_clear_roots();
 
     lv_disp_set_default(NULL);
@@ -18,6 +18,7 @@
  *********************/
 #define CIRCLE_CACHE_LIFE_MAX   1000
 #define CIRCLE_CACHE_AGING(life, r)   life = LV_MIN(life + (r < 16 ? 1 : (r >> 4)), 1000)
+#define RING_CACHE_AGING(life, r)     CIRCLE_CACHE_AGING(life, r)
 
 /**********************
  *      TYPEDEFS
@@ -44,6 +45,9 @@ LV_ATTRIBUTE_FAST_MEM static lv_draw_mask_res_t lv_draw_mask_map(lv_opa_t * mask
 LV_ATTRIBUTE_FAST_MEM static lv_draw_mask_res_t lv_draw_mask_polygon(lv_opa_t * mask_buf, lv_coord_t abs_x,
                                                                      lv_coord_t abs_y, lv_coord_t len,
                                                                      lv_draw_mask_polygon_param_t * param);
+LV_ATTRIBUTE_FAST_MEM static lv_draw_mask_res_t lv_draw_mask_ring(lv_opa_t * mask_buf, lv_coord_t abs_x,
+                                                                  lv_coord_t abs_y, lv_coord_t len,
+                                                                  lv_draw_mask_ring_param_t * param);
 
 LV_ATTRIBUTE_FAST_MEM static lv_draw_mask_res_t line_mask_flat(lv_opa_t * mask_buf, lv_coord_t abs_x, lv_coord_t abs_y,
                                                                lv_coord_t len,
@@ -58,6 +62,8 @@ static void circ_next(lv_point_t * c, lv_coord_t * tmp);
 static void circ_calc_aa4(_lv_draw_mask_radius_circle_dsc_t * c, lv_coord_t radius);
 static lv_opa_t * get_next_line(_lv_draw_mask_radius_circle_dsc_t * c, lv_coord_t y, lv_coord_t * len,
                                 lv_coord_t * x_start);
+static void ring_calc(_lv_draw_mask_ring_dsc_t * c, lv_coord_t radius, lv_coord_t width);
+static void ring_free(_lv_draw_mask_ring_dsc_t * c);
 LV_ATTRIBUTE_FAST_MEM static inline lv_opa_t mask_mix(lv_opa_t mask_act, lv_opa_t mask_new);
 
 /**********************
@@ -226,6 +232,18 @@ void lv_draw_mask_free_param(void * p)
         lv_draw_mask_polygon_param_t * poly_p = (lv_draw_mask_polygon_param_t *) p;
         lv_mem_free(poly_p->cfg.points);
     }
+    else if(pdsc->type == LV_DRAW_MASK_TYPE_RING) {
+        lv_draw_mask_ring_param_t * ring_p = (lv_draw_mask_ring_param_t *) p;
+        if(ring_p->ring) {
+            if(ring_p->ring->life < 0) {
+                ring_free(ring_p->ring);
+                lv_mem_free(ring_p->ring);
+            }
+            else {
+                ring_p->ring->used_cnt--;
+            }
+        }
+    }
 }
 
 void _lv_draw_mask_cleanup(void)
@@ -237,6 +255,22 @@ void _lv_draw_mask_cleanup(void)
         }
         lv_memset_00(&LV_GC_ROOT(_lv_circle_cache[i]), sizeof(LV_GC_ROOT(_lv_circle_cache[i])));
     }
+
+    /*The ring mask cache is kept: an arc is usually drawn once per frame so its table is reused
+     *only in the next frames. It's freed in `_lv_draw_mask_deinit()`*/
+}
+
+void _lv_draw_mask_deinit(void)
+{
+    _lv_draw_mask_cleanup();
+
+#if LV_RING_MASK_CACHE_SIZE
+    uint8_t i;
+    for(i = 0; i < LV_RING_MASK_CACHE_SIZE; i++) {
+        ring_free(&LV_GC_ROOT(_lv_ring_mask_cache[i]));
+        lv_memset_00(&LV_GC_ROOT(_lv_ring_mask_cache[i]), sizeof(LV_GC_ROOT(_lv_ring_mask_cache[i])));
+    }
+#endif
 }
 
 /**
@@ -528,6 +562,74 @@ void lv_draw_mask_radius_init(lv_draw_mask_radius_param_t * param, const lv_area
     circ_calc_aa4(param->circle, radius);
 }
 
+/**
+ * Initialize a ring mask. It keeps the same pixels as an inverted circle mask on `rect` shrunk by `width`
+ * and a circle mask on `rect` (the masks of an arc) but the row spans and the anti-aliased edges
+ * are taken from a cache (see `LV_RING_MASK_CACHE_SIZE`).
+ * @param param pointer to an `lv_draw_mask_ring_param_t` to initialize
+ * @param rect outer coordinates of the ring (absolute coordinates). Its width is the diameter.
+ * @param width thickness of the ring. If >= the radius, a filled circle is kept.
+ */
+void lv_draw_mask_ring_init(lv_draw_mask_ring_param_t * param, const lv_area_t * rect, lv_coord_t width)
+{
+    lv_coord_t radius = lv_area_get_width(rect) >> 1;
+    if(width > radius) width = radius;
+    if(width < 0) width = 0;
+
+    lv_area_copy(&param->cfg.rect, rect);
+    param->cfg.width = width;
+    param->dsc.cb = (lv_draw_mask_xcb_t)lv_draw_mask_ring;
+    param->dsc.type = LV_DRAW_MASK_TYPE_RING;
+
+    if(radius <= 0) {
+        param->ring = NULL;
+        return;
+    }
+
+    _lv_draw_mask_ring_dsc_t * entry = NULL;
+
+#if LV_RING_MASK_CACHE_SIZE
+    uint32_t i;
+
+    /*Try to reuse a ring cache entry*/
+    for(i = 0; i < LV_RING_MASK_CACHE_SIZE; i++) {
+        _lv_draw_mask_ring_dsc_t * c = &LV_GC_ROOT(_lv_ring_mask_cache[i]);
+        if(c->rows && c->radius == radius && c->width == width) {
+            c->used_cnt++;
+            RING_CACHE_AGING(c->life, radius);
+            param->ring = c;
+            return;
+        }
+    }
+
+    /*If not found find a free entry with lowest life*/
+    for(i = 0; i < LV_RING_MASK_CACHE_SIZE; i++) {
+        _lv_draw_mask_ring_dsc_t * c = &LV_GC_ROOT(_lv_ring_mask_cache[i]);
+        if(c->used_cnt == 0) {
+            if(!entry) entry = c;
+            else if(c->life < entry->life) entry = c;
+        }
+    }
+#endif
+
+    if(!entry) {
+        entry = lv_mem_alloc(sizeof(_lv_draw_mask_ring_dsc_t));
+        LV_ASSERT_MALLOC(entry);
+        lv_memset_00(entry, sizeof(_lv_draw_mask_ring_dsc_t));
+        entry->life = -1;
+    }
+    else {
+        ring_free(entry);
+        entry->used_cnt++;
+        entry->life = 0;
+        RING_CACHE_AGING(entry->life, radius);
+    }
+
+    param->ring = entry;
+
+    ring_calc(param->ring, radius, width);
+}
+
 /**
  * Initialize a fade mask.
  * @param param pointer to a `lv_draw_mask_param_t` to initialize
@@ -1167,6 +1269,89 @@ LV_ATTRIBUTE_FAST_MEM static lv_draw_mask_res_t lv_draw_mask_radius(lv_opa_t * m
     return LV_DRAW_MASK_RES_CHANGED;
 }
 
+/**
+ * Clear the pixels of the `[a, b)` span (relative to the ring) which are in the `[x0, x0 + len)` line.
+ */
+LV_ATTRIBUTE_FAST_MEM static inline void ring_span_clear(lv_opa_t * mask_buf, int32_t x0, int32_t len,
+                                                         int32_t a, int32_t b)
+{
+    a = LV_MAX(a - x0, 0);
+    b = LV_MIN(b - x0, len);
+    if(b > a) lv_memset_00(&mask_buf[a], b - a);
+}
+
+/**
+ * Mix the anti-aliased pixels of the `[a, b)` span (relative to the ring) into the `[x0, x0 + len)` line.
+ * If `mirror` is set `aa` is read backward, i.e. `aa[0]` belongs to `b - 1`.
+ */
+LV_ATTRIBUTE_FAST_MEM static inline void ring_span_mix(lv_opa_t * mask_buf, int32_t x0, int32_t len,
+                                                       int32_t a, int32_t b, const lv_opa_t * aa, bool mirror)
+{
+    int32_t k = LV_MAX(a, x0);
+    int32_t k_end = LV_MIN(b, x0 + len);
+    if(mirror) {
+        for(; k < k_end; k++) mask_buf[k - x0] = mask_mix(aa[b - 1 - k], mask_buf[k - x0]);
+    }
+    else {
+        for(; k < k_end; k++) mask_buf[k - x0] = mask_mix(aa[k - a], mask_buf[k - x0]);
+    }
+}
+
+LV_ATTRIBUTE_FAST_MEM static lv_draw_mask_res_t lv_draw_mask_ring(lv_opa_t * mask_buf, lv_coord_t abs_x,
+                                                                  lv_coord_t abs_y, lv_coord_t len,
+                                                                  lv_draw_mask_ring_param_t * p)
+{
+    const _lv_draw_mask_ring_dsc_t * c = p->ring;
+    if(c == NULL || c->rows == NULL) return LV_DRAW_MASK_RES_TRANSP;
+
+    int32_t r = c->radius;
+    int32_t d = r * 2;
+    int32_t y = abs_y - p->cfg.rect.y1;
+    if(y < 0 || y >= d) return LV_DRAW_MASK_RES_TRANSP;
+
+    /*The bottom half is the mirror of the top half*/
+    if(y >= r) y = d - 1 - y;
+
+    const _lv_draw_mask_ring_row_t * row = &c->rows[y];
+    int32_t xs = row->x_start;
+    int32_t ss = row->solid_start;
+    int32_t se = row->solid_end;
+    int32_t xe = row->x_end;
+
+    /*The line relative to the ring. The right half is the mirror of the left half*/
+    int32_t x0 = abs_x - p->cfg.rect.x1;
+    int32_t x1 = x0 + len;
+
+    /*Transparent outside or in the hole*/
+    if(x1 <= xs || x0 >= d - xs) return LV_DRAW_MASK_RES_TRANSP;
+    if(x0 >= xe && x1 <= d - xe) return LV_DRAW_MASK_RES_TRANSP;
+
+    /*Fully covered on the left or right solid part. If the solid part reaches the middle they are joined.*/
+    if(se == r) {
+        if(x0 >= ss && x1 <= d - ss) return LV_DRAW_MASK_RES_FULL_COVER;
+    }
+    else {
+        if(x0 >= ss && x1 <= se) return LV_DRAW_MASK_RES_FULL_COVER;
+        if(x0 >= d - se && x1 <= d - ss) return LV_DRAW_MASK_RES_FULL_COVER;
+    }
+
+    const lv_opa_t * aa_start = &c->opa[row->opa_ofs];
+    const lv_opa_t * aa_end = aa_start + (ss - xs);
+
+    /*Left half*/
+    ring_span_clear(mask_buf, x0, len, x0, xs);
+    ring_span_mix(mask_buf, x0, len, xs, ss, aa_start, false);
+    ring_span_mix(mask_buf, x0, len, se, xe, aa_end, false);
+    ring_span_clear(mask_buf, x0, len, xe, d - xe);
+
+    /*Right half*/
+    ring_span_mix(mask_buf, x0, len, d - xe, d - se, aa_end, true);
+    ring_span_mix(mask_buf, x0, len, d - ss, d - xs, aa_start, true);
+    ring_span_clear(mask_buf, x0, len, d - xs, x1);
+
+    return LV_DRAW_MASK_RES_CHANGED;
+}
+
 LV_ATTRIBUTE_FAST_MEM static lv_draw_mask_res_t lv_draw_mask_fade(lv_opa_t * mask_buf, lv_coord_t abs_x,
                                                                   lv_coord_t abs_y, lv_coord_t len,
                                                                   lv_draw_mask_fade_param_t * p)
@@ -1518,6 +1703,105 @@ static lv_opa_t * get_next_line(_lv_draw_mask_radius_circle_dsc_t * c, lv_coord_
 }
 
 
+/**
+ * Calculate the row spans and the anti-aliased pixels of the top left 1/4 of a ring.
+ * The pixels are evaluated with the same radius masks which would be used to draw the ring
+ * so the result is identical to drawing with them.
+ * @param c the cache entry to fill. Its previous tables have to be freed already.
+ * @param radius outer radius of the ring
+ * @param width thickness of the ring (`radius` for a filled circle)
+ */
+static void ring_calc(_lv_draw_mask_ring_dsc_t * c, lv_coord_t radius, lv_coord_t width)
+{
+    c->radius = radius;
+    c->width = width;
+    c->rows = NULL;
+    c->opa = NULL;
+
+    lv_area_t rect_out;
+    lv_area_set(&rect_out, 0, 0, radius * 2 - 1, radius * 2 - 1);
+    lv_draw_mask_radius_param_t out_param;
+    lv_draw_mask_radius_init(&out_param, &rect_out, LV_RADIUS_CIRCLE, false);
+
+    bool has_in = width < radius;
+    lv_draw_mask_radius_param_t in_param;
+    if(has_in) {
+        lv_area_t rect_in;
+        lv_area_set(&rect_in, width, width, radius * 2 - 1 - width, radius * 2 - 1 - width);
+        lv_draw_mask_radius_init(&in_param, &rect_in, LV_RADIUS_CIRCLE, true);
+    }
+
+    lv_opa_t * line = lv_mem_buf_get(radius);
+    uint32_t rows_size = radius * sizeof(_lv_draw_mask_ring_row_t);
+    uint32_t opa_size = 0;
+
+    /*First pass: find the spans and count the anti-aliased pixels. Second pass: save them.*/
+    uint32_t pass;
+    for(pass = 0; pass < 2; pass++) {
+        if(pass == 1) {
+            if(rows_size + opa_size > LV_RING_MASK_CACHE_LARGE_LIMIT) {
+                c->rows = lv_mem_alloc_large(rows_size);
+                c->opa = lv_mem_alloc_large(opa_size);
+            }
+            else {
+                c->rows = lv_mem_alloc(rows_size);
+                c->opa = lv_mem_alloc(opa_size);
+            }
+            LV_ASSERT_MALLOC(c->rows);
+            LV_ASSERT_MALLOC(c->opa);
+            if(c->rows == NULL || c->opa == NULL) break;
+        }
+
+        uint32_t opa_ofs = 0;
+        lv_coord_t y;
+        for(y = 0; y < radius; y++) {
+            /*Same order as the masks are added by the arc drawing*/
+            lv_memset_ff(line, radius);
+            if(has_in) lv_draw_mask_radius(line, 0, y, radius, &in_param);
+            lv_draw_mask_radius(line, 0, y, radius, &out_param);
+
+            lv_coord_t xs = 0;
+            while(xs < radius && line[xs] == LV_OPA_TRANSP) xs++;
+            lv_coord_t xe = radius;
+            while(xe > xs && line[xe - 1] == LV_OPA_TRANSP) xe--;
+            lv_coord_t ss = xs;
+            while(ss < xe && line[ss] != LV_OPA_COVER) ss++;
+            lv_coord_t se = ss;
+            while(se < xe && line[se] == LV_OPA_COVER) se++;
+
+            if(pass == 1) {
+                _lv_draw_mask_ring_row_t * row = &c->rows[y];
+                row->x_start = xs;
+                row->solid_start = ss;
+                row->solid_end = se;
+                row->x_end = xe;
+                row->opa_ofs = opa_ofs;
+                lv_memcpy(&c->opa[opa_ofs], &line[xs], ss - xs);
+                lv_memcpy(&c->opa[opa_ofs + ss - xs], &line[se], xe - se);
+            }
+            opa_ofs += (ss - xs) + (xe - se);
+        }
+        opa_size = opa_ofs;
+    }
+
+    lv_mem_buf_release(line);
+    lv_draw_mask_free_param(&out_param);
+    if(has_in) lv_draw_mask_free_param(&in_param);
+
+    if(c->rows == NULL || c->opa == NULL) {
+        LV_LOG_WARN("ring_calc: couldn't allocate the ring tables");
+        ring_free(c);
+    }
+}
+
+static void ring_free(_lv_draw_mask_ring_dsc_t * c)
+{
+    lv_mem_free(c->rows);
+    lv_mem_free(c->opa);
+    c->rows = NULL;
+    c->opa = NULL;
+}
+
 LV_ATTRIBUTE_FAST_MEM static inline lv_opa_t mask_mix(lv_opa_t mask_act, lv_opa_t mask_new)
 {
     if(mask_new >= LV_OPA_MAX) return mask_act;
@@ -74,6 +74,7 @@ enum {
     LV_DRAW_MASK_TYPE_FADE,
     LV_DRAW_MASK_TYPE_MAP,
     LV_DRAW_MASK_TYPE_POLYGON,
+    LV_DRAW_MASK_TYPE_RING,
 };
 
 typedef uint8_t lv_draw_mask_type_t;
@@ -179,6 +180,39 @@ typedef struct {
     _lv_draw_mask_radius_circle_dsc_t * circle;
 } lv_draw_mask_radius_param_t;
 
+typedef struct {
+    lv_coord_t x_start;         /*First not transparent pixel of the left half*/
+    lv_coord_t solid_start;     /*First fully covered pixel*/
+    lv_coord_t solid_end;       /*First not fully covered pixel after the solid part*/
+    lv_coord_t x_end;           /*First transparent pixel after the covered part*/
+    uint32_t opa_ofs;           /*Index of the row's anti-aliased pixels in `opa`*/
+} _lv_draw_mask_ring_row_t;
+
+typedef struct {
+    _lv_draw_mask_ring_row_t * rows;    /*Spans of the rows of the top left 1/4 ring*/
+    lv_opa_t * opa;             /*Anti-aliased pixels of the rows: [x_start..solid_start) then [solid_end..x_end)*/
+    int32_t life;               /*How many times the entry way used*/
+    uint32_t used_cnt;          /*Like a semaphore to count the referencing masks*/
+    lv_coord_t radius;          /*The outer radius of the entry*/
+    lv_coord_t width;           /*The thickness of the entry. `radius` means a filled circle*/
+} _lv_draw_mask_ring_dsc_t;
+
+#if LV_RING_MASK_CACHE_SIZE
+typedef _lv_draw_mask_ring_dsc_t _lv_draw_mask_ring_dsc_arr_t[LV_RING_MASK_CACHE_SIZE];
+#endif
+
+typedef struct {
+    /*The first element must be the common descriptor*/
+    _lv_draw_mask_common_dsc_t dsc;
+
+    struct {
+        lv_area_t rect;
+        lv_coord_t width;
+    } cfg;
+
+    _lv_draw_mask_ring_dsc_t * ring;
+} lv_draw_mask_ring_param_t;
+
 
 typedef struct {
     /*The first element must be the common descriptor*/
@@ -293,6 +327,12 @@ void lv_draw_mask_free_param(void * p);
  */
 void _lv_draw_mask_cleanup(void);
 
+/**
+ * Free all the cached data of the masks, the kept ring tables too.
+ * Called by `lv_deinit()`
+ */
+void _lv_draw_mask_deinit(void);
+
 //! @cond Doxygen_Suppress
 
 /**
@@ -358,6 +398,16 @@ void lv_draw_mask_angle_init(lv_draw_mask_angle_param_t * param, lv_coord_t vert
  */
 void lv_draw_mask_radius_init(lv_draw_mask_radius_param_t * param, const lv_area_t * rect, lv_coord_t radius, bool inv);
 
+/**
+ * Initialize a ring mask. It keeps the same pixels as an inverted circle mask on `rect` shrunk by `width`
+ * and a circle mask on `rect` (the masks of an arc) but the row spans and the anti-aliased edges
+ * are taken from a cache (see `LV_RING_MASK_CACHE_SIZE`).
+ * @param param pointer to an `lv_draw_mask_ring_param_t` to initialize
+ * @param rect outer coordinates of the ring (absolute coordinates). Its width is the diameter.
+ * @param width thickness of the ring. If >= the radius, a filled circle is kept.
+ */
+void lv_draw_mask_ring_init(lv_draw_mask_ring_param_t * param, const lv_area_t * rect, lv_coord_t width);
+
 /**
  * Initialize a fade mask.
  * @param param pointer to a `lv_draw_mask_param_t` to initialize
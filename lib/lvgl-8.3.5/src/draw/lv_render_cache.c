@@ -0,0 +1,375 @@
+/**
+ * @file lv_render_cache.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_render_cache.h"
+#if LV_USE_RENDER_CACHE
+
+#include "../misc/lv_assert.h"
+#include "../misc/lv_gc.h"
+#include "../misc/lv_mem.h"
+
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define CACHE           LV_GC_ROOT(_lv_render_cache)
+
+/*Used to size the hash tables of the tiers*/
+#define AVG_ITEM_SIZE_INTERNAL  256
+#define AVG_ITEM_SIZE_LARGE     4096
+
+/*Keep the keys and the data 8 byte aligned*/
+#define ALIGN8(x)       (((x) + 7) & ~(size_t)7)
+#define HEADER_SIZE     ALIGN8(sizeof(entry_t))
+#define DATA_OFS(e)     (HEADER_SIZE + ALIGN8((e)->key_size))
+
+/*Don't split free blocks to smaller parts than this*/
+#define MIN_BLOCK_SIZE  (HEADER_SIZE + 8)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+/*The pool of a tier is covered by blocks. The used ones are the items, followed by their key and data*/
+typedef struct _lv_render_cache_entry_t {
+    struct _lv_render_cache_entry_t * lru_prev;
+    struct _lv_render_cache_entry_t * lru_next;
+    struct _lv_render_cache_entry_t * hash_next;
+    uint32_t size;          /*Size of the block with the header*/
+    uint32_t prev_size;     /*Size of the previous block in the pool or 0 for the first one*/
+    uint32_t hash;
+    lv_render_cache_class_t cls;
+    uint8_t key_size;
+    uint8_t used;
+} entry_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void create_tier(lv_render_cache_tier_t tier, size_t size);
+static void drop_all(lv_render_cache_tier_t tier);
+static entry_t * find(lv_render_cache_tier_t tier, lv_render_cache_class_t cls, const void * key, size_t key_size,
+                      uint32_t hash);
+static void drop(lv_render_cache_tier_t tier, entry_t * e, bool evict);
+static entry_t * first_block(_lv_render_cache_tier_t * t);
+static entry_t * block_alloc(_lv_render_cache_tier_t * t, uint32_t size);
+static void block_free(_lv_render_cache_tier_t * t, entry_t * b);
+static lv_render_cache_tier_t get_tier(lv_render_cache_class_t cls, size_t data_size);
+static uint32_t get_hash(lv_render_cache_class_t cls, const void * key, size_t key_size);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void _lv_render_cache_init(void)
+{
+    lv_memset_00(&CACHE, sizeof(CACHE));
+    create_tier(LV_RENDER_CACHE_TIER_INTERNAL, LV_RENDER_CACHE_INTERNAL_SIZE);
+    create_tier(LV_RENDER_CACHE_TIER_LARGE, LV_RENDER_CACHE_LARGE_SIZE);
+}
+
+void _lv_render_cache_deinit(void)
+{
+    create_tier(LV_RENDER_CACHE_TIER_INTERNAL, 0);
+    create_tier(LV_RENDER_CACHE_TIER_LARGE, 0);
+}
+
+void * lv_render_cache_get(lv_render_cache_class_t cls, const void * key, size_t key_size, size_t data_size)
+{
+    LV_ASSERT(cls < _LV_RENDER_CACHE_CLASS_LAST);
+    LV_ASSERT(key_size <= LV_RENDER_CACHE_KEY_MAX);
+
+    lv_render_cache_tier_t tier = get_tier(cls, data_size);
+    _lv_render_cache_tier_t * t = &CACHE.tier[tier];
+    entry_t * e = t->pool ? find(tier, cls, key, key_size, get_hash(cls, key, key_size)) : NULL;
+    if(e == NULL) {
+        CACHE.stat[cls][tier].miss_cnt++;
+        return NULL;
+    }
+
+    /*Move to the front of the LRU list*/
+    if(e != t->lru_head) {
+        e->lru_prev->lru_next = e->lru_next;
+        if(e->lru_next) e->lru_next->lru_prev = e->lru_prev;
+        else t->lru_tail = e->lru_prev;
+        e->lru_prev = NULL;
+        e->lru_next = t->lru_head;
+        t->lru_head->lru_prev = e;
+        t->lru_head = e;
+    }
+
+    CACHE.stat[cls][tier].hit_cnt++;
+    return (uint8_t *)e + DATA_OFS(e);
+}
+
+void * lv_render_cache_add(lv_render_cache_class_t cls, const void * key, size_t key_size, size_t data_size)
+{
+    LV_ASSERT(cls < _LV_RENDER_CACHE_CLASS_LAST);
+    LV_ASSERT(key_size <= LV_RENDER_CACHE_KEY_MAX);
+
+    lv_render_cache_tier_t tier = get_tier(cls, data_size);
+    _lv_render_cache_tier_t * t = &CACHE.tier[tier];
+    if(t->pool == NULL) return NULL;
+
+    /*Larger than the whole pool without the hash table?*/
+    size_t block_size = HEADER_SIZE + ALIGN8(key_size) + ALIGN8(data_size);
+    if(block_size > (size_t)(t->pool + t->size - (uint8_t *)first_block(t))) return NULL;
+
+    /*Replace the existing item with the same key if any*/
+    uint32_t hash = get_hash(cls, key, key_size);
+    entry_t * e = find(tier, cls, key, key_size, hash);
+    if(e) drop(tier, e, false);
+
+    /*Drop the least recently used items until a large enough free block is made*/
+    while((e = block_alloc(t, block_size)) == NULL) {
+        LV_ASSERT_NULL(t->lru_tail);
+        drop(tier, t->lru_tail, true);
+    }
+
+    e->hash = hash;
+    e->cls = cls;
+    e->key_size = key_size;
+    lv_memcpy((uint8_t *)e + HEADER_SIZE, key, key_size);
+
+    uint32_t b = hash % t->bucket_cnt;
+    e->hash_next = t->buckets[b];
+    t->buckets[b] = e;
+
+    e->lru_prev = NULL;
+    e->lru_next = t->lru_head;
+    if(t->lru_head) t->lru_head->lru_prev = e;
+    else t->lru_tail = e;
+    t->lru_head = e;
+
+    lv_render_cache_stat_t * stat = &CACHE.stat[cls][tier];
+    stat->entry_cnt++;
+    stat->used_size += e->size;
+    if(stat->used_size > stat->max_used_size) stat->max_used_size = stat->used_size;
+
+    return (uint8_t *)e + DATA_OFS(e);
+}
+
+void lv_render_cache_clean(void)
+{
+    lv_render_cache_tier_t tier;
+    for(tier = 0; tier < _LV_RENDER_CACHE_TIER_LAST; tier++) {
+        drop_all(tier);
+    }
+}
+
+void lv_render_cache_set_budget(lv_render_cache_tier_t tier, size_t size)
+{
+    LV_ASSERT(tier < _LV_RENDER_CACHE_TIER_LAST);
+    create_tier(tier, size);
+}
+
+size_t lv_render_cache_get_budget(lv_render_cache_tier_t tier)
+{
+    LV_ASSERT(tier < _LV_RENDER_CACHE_TIER_LAST);
+    return CACHE.tier[tier].size;
+}
+
+void lv_render_cache_get_stat(lv_render_cache_class_t cls, lv_render_cache_tier_t tier, lv_render_cache_stat_t * stat)
+{
+    LV_ASSERT(cls < _LV_RENDER_CACHE_CLASS_LAST);
+    LV_ASSERT(tier < _LV_RENDER_CACHE_TIER_LAST);
+    *stat = CACHE.stat[cls][tier];
+}
+
+void lv_render_cache_reset_stat(void)
+{
+    lv_render_cache_class_t cls;
+    lv_render_cache_tier_t tier;
+    for(cls = 0; cls < _LV_RENDER_CACHE_CLASS_LAST; cls++) {
+        for(tier = 0; tier < _LV_RENDER_CACHE_TIER_LAST; tier++) {
+            lv_render_cache_stat_t * stat = &CACHE.stat[cls][tier];
+            stat->hit_cnt = 0;
+            stat->miss_cnt = 0;
+            stat->evict_cnt = 0;
+            stat->max_used_size = stat->used_size;
+        }
+    }
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * (Re)create a tier with a given budget. The old items are dropped and the old pool is freed.
+ */
+static void create_tier(lv_render_cache_tier_t tier, size_t size)
+{
+    _lv_render_cache_tier_t * t = &CACHE.tier[tier];
+    if(t->pool) {
+        drop_all(tier);
+        lv_mem_free(t->pool);
+        lv_memset_00(t, sizeof(*t));
+    }
+
+    size &= ~(size_t)7;
+    if(size == 0) return;
+
+    size_t avg = tier == LV_RENDER_CACHE_TIER_LARGE ? AVG_ITEM_SIZE_LARGE : AVG_ITEM_SIZE_INTERNAL;
+    uint32_t bucket_cnt = size / avg;
+    if(bucket_cnt == 0) bucket_cnt = 1;
+    size_t buckets_size = ALIGN8(bucket_cnt * sizeof(entry_t *));
+    if(size < buckets_size + MIN_BLOCK_SIZE) return;
+
+    t->pool = tier == LV_RENDER_CACHE_TIER_LARGE ? lv_mem_alloc_large(size) : lv_mem_alloc(size);
+    LV_ASSERT_MALLOC(t->pool);
+    if(t->pool == NULL) return;
+
+    t->size = size;
+    t->buckets = (entry_t **)t->pool;
+    t->bucket_cnt = bucket_cnt;
+    lv_memset_00(t->buckets, buckets_size);
+
+    /*One free block after the hash table*/
+    entry_t * b = first_block(t);
+    b->size = size - buckets_size;
+    b->prev_size = 0;
+    b->used = 0;
+}
+
+/**
+ * Drop all items of a tier without counting them as evictions
+ */
+static void drop_all(lv_render_cache_tier_t tier)
+{
+    _lv_render_cache_tier_t * t = &CACHE.tier[tier];
+    while(t->lru_tail) drop(tier, t->lru_tail, false);
+}
+
+static entry_t * find(lv_render_cache_tier_t tier, lv_render_cache_class_t cls, const void * key, size_t key_size,
+                      uint32_t hash)
+{
+    _lv_render_cache_tier_t * t = &CACHE.tier[tier];
+    entry_t * e;
+    for(e = t->buckets[hash % t->bucket_cnt]; e; e = e->hash_next) {
+        if(e->hash == hash && e->cls == cls && e->key_size == key_size &&
+           memcmp((uint8_t *)e + HEADER_SIZE, key, key_size) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Remove an item from the hash table and the LRU list and free its block
+ */
+static void drop(lv_render_cache_tier_t tier, entry_t * e, bool evict)
+{
+    _lv_render_cache_tier_t * t = &CACHE.tier[tier];
+
+    entry_t ** p = &t->buckets[e->hash % t->bucket_cnt];
+    while(*p != e) p = &(*p)->hash_next;
+    *p = e->hash_next;
+
+    if(e->lru_prev) e->lru_prev->lru_next = e->lru_next;
+    else t->lru_head = e->lru_next;
+    if(e->lru_next) e->lru_next->lru_prev = e->lru_prev;
+    else t->lru_tail = e->lru_prev;
+
+    lv_render_cache_stat_t * stat = &CACHE.stat[e->cls][tier];
+    stat->entry_cnt--;
+    stat->used_size -= e->size;
+    if(evict) stat->evict_cnt++;
+
+    block_free(t, e);
+}
+
+/**
+ * The blocks start after the hash table
+ */
+static entry_t * first_block(_lv_render_cache_tier_t * t)
+{
+    return (entry_t *)(t->pool + ALIGN8(t->bucket_cnt * sizeof(entry_t *)));
+}
+
+/**
+ * Find the first free block of at least `size` bytes and split off the rest
+ */
+static entry_t * block_alloc(_lv_render_cache_tier_t * t, uint32_t size)
+{
+    uint8_t * end = t->pool + t->size;
+    uint8_t * p = (uint8_t *)first_block(t);
+    while(p < end) {
+        entry_t * b = (entry_t *)p;
+        if(!b->used && b->size >= size) {
+            if(b->size - size >= MIN_BLOCK_SIZE) {
+                entry_t * rest = (entry_t *)(p + size);
+                rest->size = b->size - size;
+                rest->prev_size = size;
+                rest->used = 0;
+                if(p + b->size < end) ((entry_t *)(p + b->size))->prev_size = rest->size;
+                b->size = size;
+            }
+            b->used = 1;
+            return b;
+        }
+        p += b->size;
+    }
+    return NULL;
+}
+
+/**
+ * Mark a block free and merge it with its free neighbors
+ */
+static void block_free(_lv_render_cache_tier_t * t, entry_t * b)
+{
+    uint8_t * end = t->pool + t->size;
+    b->used = 0;
+
+    entry_t * next = (entry_t *)((uint8_t *)b + b->size);
+    if((uint8_t *)next < end && !next->used) b->size += next->size;
+
+    if(b->prev_size) {
+        entry_t * prev = (entry_t *)((uint8_t *)b - b->prev_size);
+        if(!prev->used) {
+            prev->size += b->size;
+            b = prev;
+        }
+    }
+
+    next = (entry_t *)((uint8_t *)b + b->size);
+    if((uint8_t *)next < end) next->prev_size = b->size;
+}
+
+static lv_render_cache_tier_t get_tier(lv_render_cache_class_t cls, size_t data_size)
+{
+    /*Glyphs are read many times but written once, and they would push out the gradients and shadows*/
+    if(cls == LV_RENDER_CACHE_CLASS_GLYPH) return LV_RENDER_CACHE_TIER_LARGE;
+
+    return data_size + HEADER_SIZE <= LV_RENDER_CACHE_SMALL_ITEM_SIZE ? LV_RENDER_CACHE_TIER_INTERNAL :
+           LV_RENDER_CACHE_TIER_LARGE;
+}
+
+/**
+ * FNV-1a of the class and the key. The tiers are shared by the classes.
+ */
+static uint32_t get_hash(lv_render_cache_class_t cls, const void * key, size_t key_size)
+{
+    const uint8_t * k = key;
+    uint32_t h = (2166136261u ^ cls) * 16777619u;
+    size_t i;
+    for(i = 0; i < key_size; i++) {
+        h = (h ^ k[i]) * 16777619u;
+    }
+    return h;
+}
+
+#endif /*LV_USE_RENDER_CACHE*/
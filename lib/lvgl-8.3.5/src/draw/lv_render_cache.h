@@ -0,0 +1,153 @@
+/**
+ * @file lv_render_cache.h
+ *
+ */
+
+#ifndef LV_RENDER_CACHE_H
+#define LV_RENDER_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../lv_conf_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+/*Max. length of the keys in bytes*/
+#define LV_RENDER_CACHE_KEY_MAX     64
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/** Kind of the cached items. The statistics are collected separately for each*/
+enum {
+    LV_RENDER_CACHE_CLASS_IMG,      /**< Decoded images*/
+    LV_RENDER_CACHE_CLASS_GRAD,     /**< Gradient color maps*/
+    LV_RENDER_CACHE_CLASS_SHADOW,   /**< Blurred shadow corners*/
+    LV_RENDER_CACHE_CLASS_GLYPH,    /**< 8 bit coverage of large glyphs. Always in the large tier.*/
+    _LV_RENDER_CACHE_CLASS_LAST
+};
+typedef uint8_t lv_render_cache_class_t;
+
+/** Where the items are stored*/
+enum {
+    LV_RENDER_CACHE_TIER_INTERNAL,  /**< Small, often used items with `lv_mem_alloc()`*/
+    LV_RENDER_CACHE_TIER_LARGE,     /**< Large items with `lv_mem_alloc_large()` (e.g. PSRAM)*/
+    _LV_RENDER_CACHE_TIER_LAST
+};
+typedef uint8_t lv_render_cache_tier_t;
+
+typedef struct {
+    uint32_t hit_cnt;       /**< Number of successful lookups*/
+    uint32_t miss_cnt;      /**< Number of failed lookups*/
+    uint32_t evict_cnt;     /**< Number of items dropped to make room for new ones*/
+    uint32_t entry_cnt;     /**< Number of items in the cache now*/
+    uint32_t used_size;     /**< Bytes used by the items now*/
+    uint32_t max_used_size; /**< The largest `used_size` since the last `lv_render_cache_reset_stat()`*/
+} lv_render_cache_stat_t;
+
+struct _lv_render_cache_entry_t;
+
+typedef struct {
+    uint8_t * pool;                                 /**< One block of the budget's size, reserved by `lv_render_cache_set_budget()`*/
+    uint32_t size;                                  /**< Size of `pool` in bytes*/
+    struct _lv_render_cache_entry_t ** buckets;     /**< Hash table at the beginning of `pool`*/
+    uint32_t bucket_cnt;
+    struct _lv_render_cache_entry_t * lru_head;     /**< The most recently used item*/
+    struct _lv_render_cache_entry_t * lru_tail;     /**< The least recently used item, dropped first*/
+} _lv_render_cache_tier_t;
+
+typedef struct {
+    _lv_render_cache_tier_t tier[_LV_RENDER_CACHE_TIER_LAST];
+    lv_render_cache_stat_t stat[_LV_RENDER_CACHE_CLASS_LAST][_LV_RENDER_CACHE_TIER_LAST];
+} _lv_render_cache_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+#if LV_USE_RENDER_CACHE
+
+/**
+ * Create the cache tiers with the default budgets. Called by `lv_init()`.
+ * The memory of the tiers is reserved here so drawing doesn't allocate anything for the cache.
+ */
+void _lv_render_cache_init(void);
+
+/**
+ * Free the memory of the tiers. Called by `lv_deinit()`.
+ */
+void _lv_render_cache_deinit(void);
+
+/**
+ * Find an item in the cache.
+ * The returned data is valid until the next `lv_render_cache_add()`, `lv_render_cache_clean()`
+ * or `lv_render_cache_set_budget()`.
+ * @param cls           class of the item, e.g. `LV_RENDER_CACHE_CLASS_GRAD`
+ * @param key           the key of the item. Every byte is compared so padding bytes should be cleared.
+ * @param key_size      size of the key in bytes (max. `LV_RENDER_CACHE_KEY_MAX`)
+ * @param data_size     size of the item's data in bytes. Decides which tier is searched.
+ * @return              pointer to the item's data or NULL if not found
+ */
+void * lv_render_cache_get(lv_render_cache_class_t cls, const void * key, size_t key_size, size_t data_size);
+
+/**
+ * Add a new item to the cache. Least recently used items are dropped if the tier's budget is exceeded.
+ * The caller should fill the returned buffer before it's used again from the cache.
+ * @param cls           class of the item
+ * @param key           the key of the item
+ * @param key_size      size of the key in bytes (max. `LV_RENDER_CACHE_KEY_MAX`)
+ * @param data_size     size of the item's data in bytes
+ * @return              pointer to a buffer with `data_size` bytes or NULL if the item doesn't fit into the cache
+ */
+void * lv_render_cache_add(lv_render_cache_class_t cls, const void * key, size_t key_size, size_t data_size);
+
+/**
+ * Drop all items from the cache.
+ */
+void lv_render_cache_clean(void);
+
+/**
+ * Set the budget of a tier. It drops all the items of the tier and reserves `size` bytes for the new ones,
+ * including the headers of the items and the hash table.
+ * @param tier          `LV_RENDER_CACHE_TIER_INTERNAL` or `LV_RENDER_CACHE_TIER_LARGE`
+ * @param size          new budget in bytes. 0: disable the tier.
+ */
+void lv_render_cache_set_budget(lv_render_cache_tier_t tier, size_t size);
+
+/**
+ * Get the budget of a tier.
+ * @param tier          `LV_RENDER_CACHE_TIER_INTERNAL` or `LV_RENDER_CACHE_TIER_LARGE`
+ * @return              the budget in bytes
+ */
+size_t lv_render_cache_get_budget(lv_render_cache_tier_t tier);
+
+/**
+ * Get the statistics of a class in a tier.
+ * @param cls           class of the items
+ * @param tier          `LV_RENDER_CACHE_TIER_INTERNAL` or `LV_RENDER_CACHE_TIER_LARGE`
+ * @param stat          store the result here
+ */
+void lv_render_cache_get_stat(lv_render_cache_class_t cls, lv_render_cache_tier_t tier, lv_render_cache_stat_t * stat);
+
+/**
+ * Clear the hit, miss and eviction counters and set `max_used_size` to the current usage.
+ */
+void lv_render_cache_reset_stat(void);
+
+#endif /*LV_USE_RENDER_CACHE*/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_RENDER_CACHE_H*/
@@ -21,6 +21,7 @@
 /**********************
  *      TYPEDEFS
  **********************/
+#if LV_DRAW_COMPLEX
 typedef struct {
     const lv_point_t * center;
     lv_coord_t radius;
@@ -32,7 +33,9 @@ typedef struct {
     lv_draw_rect_dsc_t * draw_dsc;
     const lv_area_t * draw_area;
     lv_draw_ctx_t * draw_ctx;
+    const lv_draw_mask_ring_param_t * ring_param;
 } quarter_draw_dsc_t;
+#endif /*LV_DRAW_COMPLEX*/
 
 /**********************
  *  STATIC PROTOTYPES
@@ -43,6 +46,8 @@ typedef struct {
     static void draw_quarter_2(quarter_draw_dsc_t * q);
     static void draw_quarter_3(quarter_draw_dsc_t * q);
     static void get_rounded_area(int16_t angle, lv_coord_t radius, uint8_t thickness, lv_area_t * res_area);
+    static void draw_ring_rect(lv_draw_ctx_t * draw_ctx, const lv_draw_rect_dsc_t * dsc, const lv_area_t * coords,
+                               const lv_draw_mask_ring_param_t * ring_param);
 #endif /*LV_DRAW_COMPLEX*/
 
 /**********************
@@ -87,6 +92,13 @@ void lv_draw_sw_arc(lv_draw_ctx_t * draw_ctx, const lv_draw_arc_dsc_t * dsc, con
     area_out.x2 = center->x + radius - 1;  /*-1 because the center already belongs to the left/bottom part*/
     area_out.y2 = center->y + radius - 1;
 
+#if LV_RING_MASK_CACHE_SIZE
+    /*Create a ring mask from the cached spans. It's the same as the inner and outer circle masks*/
+    lv_draw_mask_ring_param_t mask_ring_param;
+    lv_draw_mask_ring_init(&mask_ring_param, &area_out, dsc->width);
+    int16_t mask_ring_id = lv_draw_mask_add(&mask_ring_param, NULL);
+    const lv_draw_mask_ring_param_t * ring_param = &mask_ring_param;
+#else
     lv_area_t area_in;
     lv_area_copy(&area_in, &area_out);
     area_in.x1 += dsc->width;
@@ -107,12 +119,18 @@ void lv_draw_sw_arc(lv_draw_ctx_t * draw_ctx, const lv_draw_arc_dsc_t * dsc, con
     lv_draw_mask_radius_param_t mask_out_param;
     lv_draw_mask_radius_init(&mask_out_param, &area_out, LV_RADIUS_CIRCLE, false);
     int16_t mask_out_id = lv_draw_mask_add(&mask_out_param, NULL);
+    const lv_draw_mask_ring_param_t * ring_param = NULL;
+#endif
 
     /*Draw a full ring*/
     if(start_angle + 360 == end_angle || start_angle == end_angle + 360) {
         cir_dsc.radius = LV_RADIUS_CIRCLE;
-        lv_draw_rect(draw_ctx, &cir_dsc, &area_out);
+        draw_ring_rect(draw_ctx, &cir_dsc, &area_out, ring_param);
 
+#if LV_RING_MASK_CACHE_SIZE
+        lv_draw_mask_remove_id(mask_ring_id);
+        lv_draw_mask_free_param(&mask_ring_param);
+#else
         lv_draw_mask_remove_id(mask_out_id);
         if(mask_in_id != LV_MASK_ID_INV) lv_draw_mask_remove_id(mask_in_id);
 
@@ -120,6 +138,7 @@ void lv_draw_sw_arc(lv_draw_ctx_t * draw_ctx, const lv_draw_arc_dsc_t * dsc, con
         if(mask_in_param_valid) {
             lv_draw_mask_free_param(&mask_in_param);
         }
+#endif
 
         return;
     }
@@ -154,6 +173,7 @@ void lv_draw_sw_arc(lv_draw_ctx_t * draw_ctx, const lv_draw_arc_dsc_t * dsc, con
         q_dsc.draw_dsc = &cir_dsc;
         q_dsc.draw_area = &area_out;
         q_dsc.draw_ctx = draw_ctx;
+        q_dsc.ring_param = ring_param;
 
         draw_quarter_0(&q_dsc);
         draw_quarter_1(&q_dsc);
@@ -161,18 +181,26 @@ void lv_draw_sw_arc(lv_draw_ctx_t * draw_ctx, const lv_draw_arc_dsc_t * dsc, con
         draw_quarter_3(&q_dsc);
     }
     else {
-        lv_draw_rect(draw_ctx, &cir_dsc, &area_out);
+        draw_ring_rect(draw_ctx, &cir_dsc, &area_out, ring_param);
     }
 
     lv_draw_mask_free_param(&mask_angle_param);
+#if LV_RING_MASK_CACHE_SIZE
+    lv_draw_mask_free_param(&mask_ring_param);
+#else
     lv_draw_mask_free_param(&mask_out_param);
     if(mask_in_param_valid) {
         lv_draw_mask_free_param(&mask_in_param);
     }
+#endif
 
     lv_draw_mask_remove_id(mask_angle_id);
+#if LV_RING_MASK_CACHE_SIZE
+    lv_draw_mask_remove_id(mask_ring_id);
+#else
     lv_draw_mask_remove_id(mask_out_id);
     if(mask_in_id != LV_MASK_ID_INV) lv_draw_mask_remove_id(mask_in_id);
+#endif
 
     if(dsc->rounded) {
 
@@ -243,7 +271,7 @@ static void draw_quarter_0(quarter_draw_dsc_t * q)
         bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
         if(ok) {
             q->draw_ctx->clip_area = &quarter_area;
-            lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+            draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
         }
     }
     else if(q->start_quarter == 0 || q->end_quarter == 0) {
@@ -258,7 +286,7 @@ static void draw_quarter_0(quarter_draw_dsc_t * q)
             bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
             if(ok) {
                 q->draw_ctx->clip_area = &quarter_area;
-                lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+                draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
             }
         }
         if(q->end_quarter == 0) {
@@ -271,7 +299,7 @@ static void draw_quarter_0(quarter_draw_dsc_t * q)
             bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
             if(ok) {
                 q->draw_ctx->clip_area = &quarter_area;
-                lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+                draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
             }
         }
     }
@@ -288,7 +316,7 @@ static void draw_quarter_0(quarter_draw_dsc_t * q)
         bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
         if(ok) {
             q->draw_ctx->clip_area = &quarter_area;
-            lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+            draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
         }
     }
     q->draw_ctx->clip_area = clip_area_ori;
@@ -310,7 +338,7 @@ static void draw_quarter_1(quarter_draw_dsc_t * q)
         bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
         if(ok) {
             q->draw_ctx->clip_area = &quarter_area;
-            lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+            draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
         }
     }
     else if(q->start_quarter == 1 || q->end_quarter == 1) {
@@ -325,7 +353,7 @@ static void draw_quarter_1(quarter_draw_dsc_t * q)
             bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
             if(ok) {
                 q->draw_ctx->clip_area = &quarter_area;
-                lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+                draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
             }
         }
         if(q->end_quarter == 1) {
@@ -338,7 +366,7 @@ static void draw_quarter_1(quarter_draw_dsc_t * q)
             bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
             if(ok) {
                 q->draw_ctx->clip_area = &quarter_area;
-                lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+                draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
             }
         }
     }
@@ -355,7 +383,7 @@ static void draw_quarter_1(quarter_draw_dsc_t * q)
         bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
         if(ok) {
             q->draw_ctx->clip_area = &quarter_area;
-            lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+            draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
         }
     }
     q->draw_ctx->clip_area = clip_area_ori;
@@ -377,7 +405,7 @@ static void draw_quarter_2(quarter_draw_dsc_t * q)
         bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
         if(ok) {
             q->draw_ctx->clip_area = &quarter_area;
-            lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+            draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
         }
     }
     else if(q->start_quarter == 2 || q->end_quarter == 2) {
@@ -392,7 +420,7 @@ static void draw_quarter_2(quarter_draw_dsc_t * q)
             bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
             if(ok) {
                 q->draw_ctx->clip_area = &quarter_area;
-                lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+                draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
             }
         }
         if(q->end_quarter == 2) {
@@ -405,7 +433,7 @@ static void draw_quarter_2(quarter_draw_dsc_t * q)
             bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
             if(ok) {
                 q->draw_ctx->clip_area = &quarter_area;
-                lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+                draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
             }
         }
     }
@@ -422,7 +450,7 @@ static void draw_quarter_2(quarter_draw_dsc_t * q)
         bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
         if(ok) {
             q->draw_ctx->clip_area = &quarter_area;
-            lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+            draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
         }
     }
     q->draw_ctx->clip_area = clip_area_ori;
@@ -444,7 +472,7 @@ static void draw_quarter_3(quarter_draw_dsc_t * q)
         bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
         if(ok) {
             q->draw_ctx->clip_area = &quarter_area;
-            lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+            draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
         }
     }
     else if(q->start_quarter == 3 || q->end_quarter == 3) {
@@ -459,7 +487,7 @@ static void draw_quarter_3(quarter_draw_dsc_t * q)
             bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
             if(ok) {
                 q->draw_ctx->clip_area = &quarter_area;
-                lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+                draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
             }
         }
         if(q->end_quarter == 3) {
@@ -472,7 +500,7 @@ static void draw_quarter_3(quarter_draw_dsc_t * q)
             bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
             if(ok) {
                 q->draw_ctx->clip_area = &quarter_area;
-                lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+                draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
             }
         }
     }
@@ -489,13 +517,110 @@ static void draw_quarter_3(quarter_draw_dsc_t * q)
         bool ok = _lv_area_intersect(&quarter_area, &quarter_area, clip_area_ori);
         if(ok) {
             q->draw_ctx->clip_area = &quarter_area;
-            lv_draw_rect(q->draw_ctx, q->draw_dsc, q->draw_area);
+            draw_ring_rect(q->draw_ctx, q->draw_dsc, q->draw_area, q->ring_param);
         }
     }
 
     q->draw_ctx->clip_area = clip_area_ori;
 }
 
+/**
+ * Draw the ring part of an arc.
+ * With ring mask cache a plain colored ring is blended directly from the spans of the table row by row.
+ * The corners outside of the ring and its hole are skipped, so only the pixels of the ring are masked and blended.
+ * @param draw_ctx draw context
+ * @param dsc the rectangle descriptor to draw the ring with
+ * @param coords outer area of the ring
+ * @param ring_param pointer to the added `lv_draw_mask_ring_param_t` or NULL if there is no ring mask
+ */
+static void draw_ring_rect(lv_draw_ctx_t * draw_ctx, const lv_draw_rect_dsc_t * dsc, const lv_area_t * coords,
+                           const lv_draw_mask_ring_param_t * ring_param)
+{
+#if LV_RING_MASK_CACHE_SIZE
+    const _lv_draw_mask_ring_dsc_t * ring = ring_param ? ring_param->ring : NULL;
+    /*Images and gradients are drawn by the rectangle drawing with the ring mask*/
+    if(ring == NULL || ring->rows == NULL || dsc->bg_img_src || dsc->bg_grad.dir != LV_GRAD_DIR_NONE) {
+        lv_draw_rect(draw_ctx, dsc, coords);
+        return;
+    }
+    if(dsc->bg_opa <= LV_OPA_MIN) return;
+
+    lv_area_t clip_area;
+    if(!_lv_area_intersect(&clip_area, draw_ctx->clip_area, coords)) return;
+
+    /*Add the radius mask the rectangle drawing would add to have the same pixels*/
+    int32_t rout = LV_MIN(dsc->radius, LV_MIN(lv_area_get_width(coords), lv_area_get_height(coords)) >> 1);
+    lv_draw_mask_radius_param_t mask_rout_param;
+    int16_t mask_rout_id = LV_MASK_ID_INV;
+    if(rout > 0) {
+        lv_draw_mask_radius_init(&mask_rout_param, coords, rout, false);
+        mask_rout_id = lv_draw_mask_add(&mask_rout_param, NULL);
+    }
+
+    /*Initialize the mask to opa and blend with LV_OPA_COVER like the rectangle drawing*/
+    lv_opa_t opa = dsc->bg_opa >= LV_OPA_MAX ? LV_OPA_COVER : dsc->bg_opa;
+    lv_opa_t * mask_buf = lv_mem_buf_get(lv_area_get_width(&clip_area));
+
+    lv_area_t blend_area;
+    lv_draw_sw_blend_dsc_t blend_dsc;
+    lv_memset_00(&blend_dsc, sizeof(blend_dsc));
+    blend_dsc.blend_mode = dsc->blend_mode;
+    blend_dsc.color = dsc->bg_color;
+    blend_dsc.opa = LV_OPA_COVER;
+    blend_dsc.mask_buf = mask_buf;
+    blend_dsc.blend_area = &blend_area;
+    blend_dsc.mask_area = &blend_area;
+
+    int32_t r = ring->radius;
+    int32_t d = r * 2;
+    int32_t y;
+    for(y = clip_area.y1; y <= clip_area.y2; y++) {
+        int32_t ry = y - coords->y1;
+        const _lv_draw_mask_ring_row_t * row = &ring->rows[ry < r ? ry : d - 1 - ry];
+        if(row->x_start >= row->x_end) continue;
+
+        /*The covered part of the row, or its left and right side if it has a hole*/
+        int32_t xs = row->x_start;
+        int32_t xe = row->x_end;
+        int32_t spans[2][2] = {{xs, d - xs}, {0, 0}};
+        if(xe < r) {
+            spans[0][1] = xe;
+            spans[1][0] = d - xe;
+            spans[1][1] = d - xs;
+        }
+
+        blend_area.y1 = y;
+        blend_area.y2 = y;
+
+        uint32_t i;
+        for(i = 0; i < 2; i++) {
+            blend_area.x1 = LV_MAX(coords->x1 + spans[i][0], clip_area.x1);
+            blend_area.x2 = LV_MIN(coords->x1 + spans[i][1] - 1, clip_area.x2);
+            if(blend_area.x1 > blend_area.x2) continue;
+
+            /*The ring mask only mixes the AA pixels here. The other masks (e.g. the angle) apply too.*/
+            int32_t len = lv_area_get_width(&blend_area);
+            lv_memset(mask_buf, opa, len);
+            blend_dsc.mask_res = lv_draw_mask_apply(mask_buf, blend_area.x1, y, len);
+            if(blend_dsc.mask_res == LV_DRAW_MASK_RES_FULL_COVER && opa < LV_OPA_COVER) {
+                blend_dsc.mask_res = LV_DRAW_MASK_RES_CHANGED;
+            }
+            lv_draw_sw_blend(draw_ctx, &blend_dsc);
+        }
+    }
+
+    lv_mem_buf_release(mask_buf);
+
+    if(mask_rout_id != LV_MASK_ID_INV) {
+        lv_draw_mask_remove_id(mask_rout_id);
+        lv_draw_mask_free_param(&mask_rout_param);
+    }
+#else
+    LV_UNUSED(ring_param);
+    lv_draw_rect(draw_ctx, dsc, coords);
+#endif
+}
+
 static void get_rounded_area(int16_t angle, lv_coord_t radius, uint8_t thickness, lv_area_t * res_area)
 {
     const uint8_t ps = 8;
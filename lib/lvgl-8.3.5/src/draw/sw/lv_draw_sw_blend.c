@@ -243,6 +243,17 @@ LV_ATTRIBUTE_FAST_MEM static void fill_normal(lv_color_t * dest_buf, const lv_ar
     int32_t w = lv_area_get_width(dest_area);
     int32_t h = lv_area_get_height(dest_area);
 
+#if _LV_DRAW_SW_RGB565_KERNEL
+    if(mask == NULL) {
+        if(opa >= LV_OPA_MAX) lv_draw_sw_rgb565_fill(dest_buf, w, h, dest_stride, color);
+        else lv_draw_sw_rgb565_fill_opa(dest_buf, w, h, dest_stride, color, opa);
+    }
+    else {
+        lv_draw_sw_rgb565_fill_mask(dest_buf, w, h, dest_stride, color, opa, mask, mask_stride);
+    }
+    return;
+#endif
+
     int32_t x;
     int32_t y;
 
@@ -653,6 +664,10 @@ LV_ATTRIBUTE_FAST_MEM static void map_normal(lv_color_t * dest_buf, const lv_are
             }
         }
         else {
+#if _LV_DRAW_SW_RGB565_KERNEL
+            lv_draw_sw_rgb565_map_opa(dest_buf, w, h, dest_stride, src_buf, src_stride, opa);
+            return;
+#endif
             for(y = 0; y < h; y++) {
                 for(x = 0; x < w; x++) {
                     dest_buf[x] = lv_color_mix(src_buf[x], dest_buf[x], opa);
@@ -664,6 +679,10 @@ LV_ATTRIBUTE_FAST_MEM static void map_normal(lv_color_t * dest_buf, const lv_are
     }
     /*Masked*/
     else {
+#if _LV_DRAW_SW_RGB565_KERNEL
+        lv_draw_sw_rgb565_map_mask(dest_buf, w, h, dest_stride, src_buf, src_stride, opa, mask, mask_stride);
+        return;
+#endif
         /*Only the mask matters*/
         if(opa > LV_OPA_MAX) {
             int32_t x_end4 = w - 4;
@@ -0,0 +1,339 @@
+/**
+ * @file lv_draw_sw_blend_rgb565.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_draw_sw_blend_rgb565.h"
+#include "../../misc/lv_math.h"
+#include "../../misc/lv_mem.h"
+
+#if _LV_DRAW_SW_RGB565_KERNEL
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/*The channels of an RGB565 color spread in a 32 bit word with gaps between them:
+ *0b00000GGGGGG00000RRRRR000000BBBBB. `(fg * mix + bg * (32 - mix)) >> 5` can be calculated on all the channels
+ *at once because the gaps have room for the products. It's the same as the algorithm of `lv_color_mix()`
+ *(the only difference is above the 27th bit which is masked out anyway)*/
+#define SPREAD_MASK     0x07E0F81FU
+#define SPREAD_MASK_2   0x07E0F81F07E0F81FULL
+
+/*Small fills with opacity are not worth to prepare the lookup tables*/
+#define FILL_OPA_LUT_MIN_PX 128
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/*The widest word which is natively handled by the CPU*/
+#ifdef LV_ARCH_64
+    typedef uint64_t lane_t;
+#else
+    typedef uint32_t lane_t;
+#endif
+
+#define LANE_PX         (int32_t)(sizeof(lane_t) / sizeof(lv_color_t))   /*Pixels in a lane*/
+#define LANE_MASK_PX    (int32_t)(sizeof(lane_t))                         /*Mask values in a lane*/
+#define LANE_ALIGN_MASK (sizeof(lane_t) - 1)
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static inline uint32_t spread(lv_color_t c);
+static inline lv_color_t unspread(uint32_t s);
+static inline lv_color_t mix_spread(uint32_t fg, uint32_t bg, uint32_t mix5);
+static inline lane_t color_to_lane(lv_color_t color);
+LV_ATTRIBUTE_FAST_MEM static inline void fill_row(lv_color_t * dest_buf, int32_t w, lv_color_t color, lane_t color_lane);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#define MIX5(mix) (((uint32_t)(mix) + 4) >> 3)
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+#ifndef LV_DRAW_SW_RGB565_FILL_CUSTOM
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_fill(lv_color_t * dest_buf, int32_t w, int32_t h, lv_coord_t dest_stride,
+                                                  lv_color_t color)
+{
+    lane_t color_lane = color_to_lane(color);
+    int32_t y;
+    for(y = 0; y < h; y++) {
+        fill_row(dest_buf, w, color, color_lane);
+        dest_buf += dest_stride;
+    }
+}
+#endif /*LV_DRAW_SW_RGB565_FILL_CUSTOM*/
+
+#ifndef LV_DRAW_SW_RGB565_FILL_OPA_CUSTOM
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_fill_opa(lv_color_t * dest_buf, int32_t w, int32_t h,
+                                                      lv_coord_t dest_stride, lv_color_t color, lv_opa_t opa)
+{
+    int32_t x;
+    int32_t y;
+
+    /*Introduce the same rounding error on opa as `fill_normal()` does to match `lv_color_mix`*/
+    opa = (uint32_t)((uint32_t)opa + 4) >> 3;
+    opa = opa << 3;
+
+    uint16_t color_premult[3];
+    lv_color_premult(color, opa, color_premult);
+    lv_opa_t opa_inv = 255 - opa;
+
+    if(w * h < FILL_OPA_LUT_MIN_PX) {
+        for(y = 0; y < h; y++) {
+            for(x = 0; x < w; x++) {
+                dest_buf[x] = lv_color_mix_premult(color_premult, dest_buf[x], opa_inv);
+            }
+            dest_buf += dest_stride;
+        }
+        return;
+    }
+
+    /*The channels are mixed independently so the result of every possible channel value can be prepared*/
+    uint16_t lut_r[32];
+    uint16_t lut_g[64];
+    uint16_t lut_b[32];
+    uint32_t i;
+    for(i = 0; i < 64; i++) {
+        lv_color_t c;
+        if(i < 32) {
+            c.full = (uint16_t)(i << 11);
+            lut_r[i] = lv_color_mix_premult(color_premult, c, opa_inv).full & 0xF800;
+            c.full = (uint16_t)i;
+            lut_b[i] = lv_color_mix_premult(color_premult, c, opa_inv).full & 0x001F;
+        }
+        c.full = (uint16_t)(i << 5);
+        lut_g[i] = lv_color_mix_premult(color_premult, c, opa_inv).full & 0x07E0;
+    }
+
+    for(y = 0; y < h; y++) {
+        for(x = 0; x <= w - 2; x += 2) {
+            uint16_t c0 = dest_buf[x].full;
+            uint16_t c1 = dest_buf[x + 1].full;
+            dest_buf[x].full = lut_r[c0 >> 11] | lut_g[(c0 >> 5) & 0x3F] | lut_b[c0 & 0x1F];
+            dest_buf[x + 1].full = lut_r[c1 >> 11] | lut_g[(c1 >> 5) & 0x3F] | lut_b[c1 & 0x1F];
+        }
+        if(x < w) {
+            uint16_t c0 = dest_buf[x].full;
+            dest_buf[x].full = lut_r[c0 >> 11] | lut_g[(c0 >> 5) & 0x3F] | lut_b[c0 & 0x1F];
+        }
+        dest_buf += dest_stride;
+    }
+}
+#endif /*LV_DRAW_SW_RGB565_FILL_OPA_CUSTOM*/
+
+#ifndef LV_DRAW_SW_RGB565_FILL_MASK_CUSTOM
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_fill_mask(lv_color_t * dest_buf, int32_t w, int32_t h,
+                                                       lv_coord_t dest_stride, lv_color_t color, lv_opa_t opa,
+                                                       const lv_opa_t * mask, lv_coord_t mask_stride)
+{
+    int32_t x;
+    int32_t y;
+    uint32_t color_spread = spread(color);
+
+    /*Only the mask matters*/
+    if(opa >= LV_OPA_MAX) {
+        lane_t color_lane = color_to_lane(color);
+        for(y = 0; y < h; y++) {
+            x = 0;
+            while(x < w) {
+                /*Check whole lanes of the mask to find fully covered or transparent parts quickly*/
+                if(((lv_uintptr_t)&mask[x] & LANE_ALIGN_MASK) == 0 && x <= w - LANE_MASK_PX) {
+                    lane_t m = *((const lane_t *)&mask[x]);
+                    if(m == 0) {
+                        x += LANE_MASK_PX;
+                        continue;
+                    }
+                    if(m == (lane_t)(-1)) {
+                        fill_row(&dest_buf[x], LANE_MASK_PX, color, color_lane);
+                        x += LANE_MASK_PX;
+                        continue;
+                    }
+                }
+
+                /*A mixed lane or an unaligned start: handle it pixel by pixel. 0 and 255 work here too*/
+                int32_t x_end = LV_MIN(w, x + LANE_MASK_PX - (int32_t)((lv_uintptr_t)&mask[x] & LANE_ALIGN_MASK));
+                for(; x < x_end; x++) {
+                    dest_buf[x] = mix_spread(color_spread, spread(dest_buf[x]), MIX5(mask[x]));
+                }
+            }
+            dest_buf += dest_stride;
+            mask += mask_stride;
+        }
+    }
+    /*With opacity*/
+    else {
+        for(y = 0; y < h; y++) {
+            for(x = 0; x < w; x++) {
+                if(mask[x] == 0) continue;
+                uint32_t opa_tmp = mask[x] == LV_OPA_COVER ? opa : (uint32_t)((uint32_t)mask[x] * opa) >> 8;
+                dest_buf[x] = mix_spread(color_spread, spread(dest_buf[x]), MIX5(opa_tmp));
+            }
+            dest_buf += dest_stride;
+            mask += mask_stride;
+        }
+    }
+}
+#endif /*LV_DRAW_SW_RGB565_FILL_MASK_CUSTOM*/
+
+#ifndef LV_DRAW_SW_RGB565_MAP_OPA_CUSTOM
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_map_opa(lv_color_t * dest_buf, int32_t w, int32_t h,
+                                                     lv_coord_t dest_stride, const lv_color_t * src_buf, lv_coord_t src_stride, lv_opa_t opa)
+{
+    int32_t x;
+    int32_t y;
+    uint32_t mix5 = MIX5(opa);
+
+    for(y = 0; y < h; y++) {
+        x = 0;
+#ifdef LV_ARCH_64
+        /*Two spread pixels fit into 64 bit and the sums can't overflow into the other pixel*/
+        for(; x <= w - 2; x += 2) {
+            uint64_t fg = (uint64_t)src_buf[x].full | ((uint64_t)src_buf[x + 1].full << 32);
+            uint64_t bg = (uint64_t)dest_buf[x].full | ((uint64_t)dest_buf[x + 1].full << 32);
+            fg = (fg | (fg << 16)) & SPREAD_MASK_2;
+            bg = (bg | (bg << 16)) & SPREAD_MASK_2;
+            uint64_t res = ((fg * mix5 + bg * (32 - mix5)) >> 5) & SPREAD_MASK_2;
+            dest_buf[x] = unspread((uint32_t)res);
+            dest_buf[x + 1] = unspread((uint32_t)(res >> 32));
+        }
+#endif
+        for(; x < w; x++) {
+            dest_buf[x] = mix_spread(spread(src_buf[x]), spread(dest_buf[x]), mix5);
+        }
+        dest_buf += dest_stride;
+        src_buf += src_stride;
+    }
+}
+#endif /*LV_DRAW_SW_RGB565_MAP_OPA_CUSTOM*/
+
+#ifndef LV_DRAW_SW_RGB565_MAP_MASK_CUSTOM
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_map_mask(lv_color_t * dest_buf, int32_t w, int32_t h,
+                                                      lv_coord_t dest_stride, const lv_color_t * src_buf, lv_coord_t src_stride, lv_opa_t opa,
+                                                      const lv_opa_t * mask, lv_coord_t mask_stride)
+{
+    int32_t x;
+    int32_t y;
+
+    /*Only the mask matters*/
+    if(opa > LV_OPA_MAX) {
+        for(y = 0; y < h; y++) {
+            x = 0;
+            while(x < w) {
+                /*Check whole lanes of the mask to find fully covered or transparent parts quickly*/
+                if(((lv_uintptr_t)&mask[x] & LANE_ALIGN_MASK) == 0 && x <= w - LANE_MASK_PX) {
+                    lane_t m = *((const lane_t *)&mask[x]);
+                    if(m == 0) {
+                        x += LANE_MASK_PX;
+                        continue;
+                    }
+                    if(m == (lane_t)(-1)) {
+                        lv_memcpy(&dest_buf[x], &src_buf[x], LANE_MASK_PX * sizeof(lv_color_t));
+                        x += LANE_MASK_PX;
+                        continue;
+                    }
+                }
+
+                /*A mixed lane or an unaligned start: handle it pixel by pixel. 0 and 255 work here too*/
+                int32_t x_end = LV_MIN(w, x + LANE_MASK_PX - (int32_t)((lv_uintptr_t)&mask[x] & LANE_ALIGN_MASK));
+                for(; x < x_end; x++) {
+                    dest_buf[x] = mix_spread(spread(src_buf[x]), spread(dest_buf[x]), MIX5(mask[x]));
+                }
+            }
+            dest_buf += dest_stride;
+            src_buf += src_stride;
+            mask += mask_stride;
+        }
+    }
+    /*Handle opa and mask values too*/
+    else {
+        for(y = 0; y < h; y++) {
+            for(x = 0; x < w; x++) {
+                if(mask[x] == 0) continue;
+                uint32_t opa_tmp = mask[x] >= LV_OPA_MAX ? opa : (uint32_t)((uint32_t)opa * mask[x]) >> 8;
+                dest_buf[x] = mix_spread(spread(src_buf[x]), spread(dest_buf[x]), MIX5(opa_tmp));
+            }
+            dest_buf += dest_stride;
+            src_buf += src_stride;
+            mask += mask_stride;
+        }
+    }
+}
+#endif /*LV_DRAW_SW_RGB565_MAP_MASK_CUSTOM*/
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static inline uint32_t spread(lv_color_t c)
+{
+    return ((uint32_t)c.full | ((uint32_t)c.full << 16)) & SPREAD_MASK;
+}
+
+static inline lv_color_t unspread(uint32_t s)
+{
+    lv_color_t c;
+    c.full = (uint16_t)((s >> 16) | s);
+    return c;
+}
+
+/**
+ * Mix two spread colors
+ * @param fg    spread foreground color
+ * @param bg    spread background color
+ * @param mix5  ratio of the colors on 5 bits (0..32). `MIX5(opa)`
+ * @return      the mixed color as `lv_color_mix(fg, bg, opa)` returns it
+ */
+static inline lv_color_t mix_spread(uint32_t fg, uint32_t bg, uint32_t mix5)
+{
+    return unspread(((fg * mix5 + bg * (32 - mix5)) >> 5) & SPREAD_MASK);
+}
+
+LV_ATTRIBUTE_FAST_MEM static inline void fill_row(lv_color_t * dest_buf, int32_t w, lv_color_t color, lane_t color_lane)
+{
+    int32_t x = 0;
+    /*Go pixel by pixel until the lane alignment*/
+    for(; x < w && ((lv_uintptr_t)&dest_buf[x] & LANE_ALIGN_MASK); x++) {
+        dest_buf[x] = color;
+    }
+
+    lane_t * d = (lane_t *)&dest_buf[x];
+    for(; x <= w - LANE_PX * 4; x += LANE_PX * 4) {
+        d[0] = color_lane;
+        d[1] = color_lane;
+        d[2] = color_lane;
+        d[3] = color_lane;
+        d += 4;
+    }
+
+    for(; x <= w - LANE_PX; x += LANE_PX) {
+        *d = color_lane;
+        d++;
+    }
+
+    for(; x < w; x++) {
+        dest_buf[x] = color;
+    }
+}
+
+static inline lane_t color_to_lane(lv_color_t color)
+{
+    lane_t c = color.full;
+    c |= c << 16;
+#ifdef LV_ARCH_64
+    c |= c << 32;
+#endif
+    return c;
+}
+
+#endif /*_LV_DRAW_SW_RGB565_KERNEL*/
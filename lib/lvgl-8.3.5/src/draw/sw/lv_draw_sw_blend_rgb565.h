@@ -0,0 +1,123 @@
+/**
+ * @file lv_draw_sw_blend_rgb565.h
+ *
+ */
+
+#ifndef LV_DRAW_SW_BLEND_RGB565_H
+#define LV_DRAW_SW_BLEND_RGB565_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../misc/lv_color.h"
+#include "../../misc/lv_area.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#if LV_DRAW_SW_RGB565_KERNEL && LV_COLOR_DEPTH == 16 && LV_COLOR_16_SWAP == 0 && LV_COLOR_MIX_ROUND_OFS == 0
+#define _LV_DRAW_SW_RGB565_KERNEL 1
+#else
+#define _LV_DRAW_SW_RGB565_KERNEL 0
+#endif
+
+#if _LV_DRAW_SW_RGB565_KERNEL && defined(LV_DRAW_SW_RGB565_KERNEL_INCLUDE)
+#include LV_DRAW_SW_RGB565_KERNEL_INCLUDE
+#endif
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+#if _LV_DRAW_SW_RGB565_KERNEL
+
+/* Every kernel gives exactly the same result as the pixel by pixel blending of `lv_draw_sw_blend.c`.
+ * A kernel can be replaced by defining `LV_DRAW_SW_RGB565_<NAME>_CUSTOM` in `LV_DRAW_SW_RGB565_KERNEL_INCLUDE`.*/
+
+/**
+ * Fill an area with a color.
+ * Can be replaced with `LV_DRAW_SW_RGB565_FILL_CUSTOM`.
+ * @param dest_buf      pointer to the first pixel of the area
+ * @param w             width of the area
+ * @param h             height of the area
+ * @param dest_stride   width of the destination buffer in pixels
+ * @param color         the fill color
+ */
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_fill(lv_color_t * dest_buf, int32_t w, int32_t h, lv_coord_t dest_stride,
+                                                  lv_color_t color);
+
+/**
+ * Fill an area with a color and an opacity.
+ * Can be replaced with `LV_DRAW_SW_RGB565_FILL_OPA_CUSTOM`.
+ * @param dest_buf      pointer to the first pixel of the area
+ * @param w             width of the area
+ * @param h             height of the area
+ * @param dest_stride   width of the destination buffer in pixels
+ * @param color         the fill color
+ * @param opa           opacity of the fill (< LV_OPA_MAX)
+ */
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_fill_opa(lv_color_t * dest_buf, int32_t w, int32_t h,
+                                                      lv_coord_t dest_stride, lv_color_t color, lv_opa_t opa);
+
+/**
+ * Fill an area with a color through a mask.
+ * Can be replaced with `LV_DRAW_SW_RGB565_FILL_MASK_CUSTOM`.
+ * @param dest_buf      pointer to the first pixel of the area
+ * @param w             width of the area
+ * @param h             height of the area
+ * @param dest_stride   width of the destination buffer in pixels
+ * @param color         the fill color
+ * @param opa           opacity of the fill
+ * @param mask          pointer to the first mask value of the area
+ * @param mask_stride   width of the mask buffer
+ */
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_fill_mask(lv_color_t * dest_buf, int32_t w, int32_t h,
+                                                       lv_coord_t dest_stride, lv_color_t color, lv_opa_t opa,
+                                                       const lv_opa_t * mask, lv_coord_t mask_stride);
+
+/**
+ * Blend an image onto an area with an opacity.
+ * Can be replaced with `LV_DRAW_SW_RGB565_MAP_OPA_CUSTOM`.
+ * @param dest_buf      pointer to the first pixel of the area
+ * @param w             width of the area
+ * @param h             height of the area
+ * @param dest_stride   width of the destination buffer in pixels
+ * @param src_buf       pointer to the first pixel of the image
+ * @param src_stride    width of the image buffer in pixels
+ * @param opa           opacity of the image (< LV_OPA_MAX)
+ */
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_map_opa(lv_color_t * dest_buf, int32_t w, int32_t h,
+                                                     lv_coord_t dest_stride, const lv_color_t * src_buf, lv_coord_t src_stride, lv_opa_t opa);
+
+/**
+ * Blend an image onto an area through a mask.
+ * Can be replaced with `LV_DRAW_SW_RGB565_MAP_MASK_CUSTOM`.
+ * @param dest_buf      pointer to the first pixel of the area
+ * @param w             width of the area
+ * @param h             height of the area
+ * @param dest_stride   width of the destination buffer in pixels
+ * @param src_buf       pointer to the first pixel of the image
+ * @param src_stride    width of the image buffer in pixels
+ * @param opa           opacity of the image
+ * @param mask          pointer to the first mask value of the area
+ * @param mask_stride   width of the mask buffer
+ */
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_map_mask(lv_color_t * dest_buf, int32_t w, int32_t h,
+                                                      lv_coord_t dest_stride, const lv_color_t * src_buf, lv_coord_t src_stride, lv_opa_t opa,
+                                                      const lv_opa_t * mask, lv_coord_t mask_stride);
+
+#endif /*_LV_DRAW_SW_RGB565_KERNEL*/
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_DRAW_SW_BLEND_RGB565_H*/
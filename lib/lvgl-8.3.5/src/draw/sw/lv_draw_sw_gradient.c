@@ -9,6 +9,7 @@
 #include "lv_draw_sw_gradient.h"
 #include "../../misc/lv_gc.h"
 #include "../../misc/lv_types.h"
+#include "../lv_render_cache.h"
 
 /*********************
  *      DEFINES
@@ -32,27 +33,50 @@
     #error "LV_GRAD_CACHE_DEF_SIZE is too small"
 #endif
 
+/**********************
+ *      TYPEDEFS
+ **********************/
+#if LV_USE_RENDER_CACHE
+/*Everything the content of a gradient item depends on. Compared byte by byte so it's always cleared first.*/
+typedef struct {
+    lv_gradient_stop_t stops[LV_GRADIENT_MAX_STOPS];
+    lv_coord_t size;
+    lv_coord_t map_size;
+    lv_coord_t w;
+    uint8_t stops_count;
+    uint8_t dir;
+    uint8_t dither;
+} grad_key_t;
+#endif
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
+#if LV_USE_RENDER_CACHE
+static void fill_key(grad_key_t * key, const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h);
+#else
 static lv_grad_t * next_in_cache(lv_grad_t * item);
 
 typedef lv_res_t (*op_cache_t)(lv_grad_t * c, void * ctx);
 static lv_res_t iterate_cache(op_cache_t func, void * ctx, lv_grad_t ** out);
 static size_t get_cache_item_size(lv_grad_t * c);
-static lv_grad_t * allocate_item(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h);
 static lv_res_t find_oldest_item_life(lv_grad_t * c, void * ctx);
 static lv_res_t kill_oldest_item(lv_grad_t * c, void * ctx);
 static lv_res_t find_item(lv_grad_t * c, void * ctx);
 static void free_item(lv_grad_t * c);
+#endif
+static size_t get_req_size(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h);
+static lv_grad_t * allocate_item(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h);
 static  uint32_t compute_key(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h);
 
 
 /**********************
  *   STATIC VARIABLE
  **********************/
+#if !LV_USE_RENDER_CACHE
 static size_t    grad_cache_size = 0;
 static uint8_t * grad_cache_end = 0;
+#endif
 
 /**********************
  *   STATIC FUNCTIONS
@@ -69,6 +93,23 @@ static uint32_t compute_key(const lv_grad_dsc_t * g, lv_coord_t size, lv_coord_t
     return (v.value ^ size ^ (w >> 1)); /*Yes, this is correct, it's like a hash that changes if the width changes*/
 }
 
+#if LV_USE_RENDER_CACHE
+static void fill_key(grad_key_t * key, const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h)
+{
+    lv_memset_00(key, sizeof(grad_key_t));
+    uint8_t i;
+    for(i = 0; i < g->stops_count; i++) {
+        key->stops[i].color = g->stops[i].color;
+        key->stops[i].frac = g->stops[i].frac;
+    }
+    key->size = g->dir == LV_GRAD_DIR_HOR ? w : h;
+    key->map_size = LV_MAX(w, h);
+    key->w = w;
+    key->stops_count = g->stops_count;
+    key->dir = g->dir;
+    key->dither = g->dither;
+}
+#else
 static size_t get_cache_item_size(lv_grad_t * c)
 {
     size_t s = ALIGN(sizeof(*c)) + ALIGN(c->alloc_size * sizeof(lv_color_t));
@@ -154,21 +195,47 @@ static lv_res_t find_item(lv_grad_t * c, void * ctx)
     if(c->key == *k) return LV_RES_OK;
     return LV_RES_INV;
 }
+#endif /*LV_USE_RENDER_CACHE*/
 
-static lv_grad_t * allocate_item(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h)
+static size_t get_req_size(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h)
 {
-    lv_coord_t size = g->dir == LV_GRAD_DIR_HOR ? w : h;
     lv_coord_t map_size = LV_MAX(w, h); /* The map is being used horizontally (width) unless
                                            no dithering is selected where it's used vertically */
 
     size_t req_size = ALIGN(sizeof(lv_grad_t)) + ALIGN(map_size * sizeof(lv_color_t));
 #if _DITHER_GRADIENT
+    lv_coord_t size = g->dir == LV_GRAD_DIR_HOR ? w : h;
     req_size += ALIGN(size * sizeof(lv_color32_t));
 #if LV_DITHER_ERROR_DIFFUSION == 1
     req_size += ALIGN(w * sizeof(lv_scolor24_t));
 #endif
+#else
+    LV_UNUSED(g);
 #endif
+    return req_size;
+}
 
+static lv_grad_t * allocate_item(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h)
+{
+    lv_coord_t size = g->dir == LV_GRAD_DIR_HOR ? w : h;
+    lv_coord_t map_size = LV_MAX(w, h);
+    size_t req_size = get_req_size(g, w, h);
+
+#if LV_USE_RENDER_CACHE
+    grad_key_t key;
+    fill_key(&key, g, w, h);
+    lv_grad_t * item = lv_render_cache_add(LV_RENDER_CACHE_CLASS_GRAD, &key, sizeof(key), req_size);
+    if(item) {
+        item->not_cached = 0;
+    }
+    else {
+        /*It doesn't fit into the render cache. Allocate the item manually and free it later.*/
+        item = lv_mem_alloc(req_size);
+        LV_ASSERT_MALLOC(item);
+        if(item == NULL) return NULL;
+        item->not_cached = 1;
+    }
+#else
     size_t act_size = (size_t)(grad_cache_end - LV_GC_ROOT(_lv_grad_cache_mem));
     lv_grad_t * item = NULL;
     if(req_size + act_size < grad_cache_size) {
@@ -195,36 +262,29 @@ static lv_grad_t * allocate_item(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord
             item->not_cached = 1;
         }
     }
+#endif /*LV_USE_RENDER_CACHE*/
 
     item->key = compute_key(g, size, w);
     item->life = 1;
     item->filled = 0;
     item->alloc_size = map_size;
     item->size = size;
-    if(item->not_cached) {
-        uint8_t * p = (uint8_t *)item;
-        item->map = (lv_color_t *)(p + ALIGN(sizeof(*item)));
+
+    /*The buffers are always right after the item (in the cache's buffer too)*/
+    uint8_t * p = (uint8_t *)item;
+    item->map = (lv_color_t *)(p + ALIGN(sizeof(*item)));
 #if _DITHER_GRADIENT
-        item->hmap = (lv_color32_t *)(p + ALIGN(sizeof(*item)) + ALIGN(map_size * sizeof(lv_color_t)));
+    item->hmap = (lv_color32_t *)(p + ALIGN(sizeof(*item)) + ALIGN(map_size * sizeof(lv_color_t)));
 #if LV_DITHER_ERROR_DIFFUSION == 1
-        item->error_acc = (lv_scolor24_t *)(p + ALIGN(sizeof(*item)) + ALIGN(size * sizeof(lv_grad_color_t)) +
-                                            ALIGN(map_size * sizeof(lv_color_t)));
-        item->w = w;
+    item->error_acc = (lv_scolor24_t *)(p + ALIGN(sizeof(*item)) + ALIGN(size * sizeof(lv_grad_color_t)) +
+                                        ALIGN(map_size * sizeof(lv_color_t)));
+    item->w = w;
 #endif
 #endif
-    }
-    else {
-        item->map = (lv_color_t *)(grad_cache_end + ALIGN(sizeof(*item)));
-#if _DITHER_GRADIENT
-        item->hmap = (lv_color32_t *)(grad_cache_end + ALIGN(sizeof(*item)) + ALIGN(map_size * sizeof(lv_color_t)));
-#if LV_DITHER_ERROR_DIFFUSION == 1
-        item->error_acc = (lv_scolor24_t *)(grad_cache_end + ALIGN(sizeof(*item)) + ALIGN(size * sizeof(lv_grad_color_t)) +
-                                            ALIGN(map_size * sizeof(lv_color_t)));
-        item->w = w;
-#endif
+
+#if !LV_USE_RENDER_CACHE
+    if(!item->not_cached) grad_cache_end += req_size;
 #endif
-        grad_cache_end += req_size;
-    }
     return item;
 }
 
@@ -234,18 +294,28 @@ static lv_grad_t * allocate_item(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord
  **********************/
 void lv_gradient_free_cache(void)
 {
+#if LV_USE_RENDER_CACHE
+    /*The gradients are stored together with the other items*/
+    lv_render_cache_clean();
+#else
     lv_mem_free(LV_GC_ROOT(_lv_grad_cache_mem));
     LV_GC_ROOT(_lv_grad_cache_mem) = grad_cache_end = NULL;
     grad_cache_size = 0;
+#endif
 }
 
 void lv_gradient_set_cache_size(size_t max_bytes)
 {
+#if LV_USE_RENDER_CACHE
+    /*The budgets of the render cache are used instead. See `lv_render_cache_set_budget()`*/
+    LV_UNUSED(max_bytes);
+#else
     lv_mem_free(LV_GC_ROOT(_lv_grad_cache_mem));
     grad_cache_end = LV_GC_ROOT(_lv_grad_cache_mem) = lv_mem_alloc(max_bytes);
     LV_ASSERT_MALLOC(LV_GC_ROOT(_lv_grad_cache_mem));
     lv_memset_00(LV_GC_ROOT(_lv_grad_cache_mem), max_bytes);
     grad_cache_size = max_bytes;
+#endif
 }
 
 lv_grad_t * lv_gradient_get(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h)
@@ -253,6 +323,16 @@ lv_grad_t * lv_gradient_get(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h)
     /* No gradient, no cache */
     if(g->dir == LV_GRAD_DIR_NONE) return NULL;
 
+#if LV_USE_RENDER_CACHE
+    /* Step 1: Search the render cache for the given key */
+    grad_key_t key;
+    fill_key(&key, g, w, h);
+    lv_grad_t * item = lv_render_cache_get(LV_RENDER_CACHE_CLASS_GRAD, &key, sizeof(key), get_req_size(g, w, h));
+    if(item) {
+        item->life++;
+        return item;
+    }
+#else
     /* Step 0: Check if the cache exist (else create it) */
     static bool inited = false;
     if(!inited) {
@@ -268,6 +348,7 @@ lv_grad_t * lv_gradient_get(const lv_grad_dsc_t * g, lv_coord_t w, lv_coord_t h)
         item->life++; /* Don't forget to bump the counter */
         return item;
     }
+#endif
 
     /* Step 2: Need to allocate an item for it */
     item = allocate_item(g, w, h);
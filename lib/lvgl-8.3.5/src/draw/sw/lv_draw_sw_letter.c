@@ -22,10 +22,19 @@
 /**********************
  *      TYPEDEFS
  **********************/
+#if LV_USE_RENDER_CACHE && LV_RENDER_CACHE_GLYPH_MIN_SIZE
+typedef struct {
+    const lv_font_t * font;
+    uint32_t letter;
+} glyph_key_t;
+#endif
 
 /**********************
  *  STATIC PROTOTYPES
  **********************/
+#if LV_USE_RENDER_CACHE && LV_RENDER_CACHE_GLYPH_MIN_SIZE
+    static const uint8_t * get_glyph_a8(const lv_font_glyph_dsc_t * g, uint32_t letter);
+#endif
 
 LV_ATTRIBUTE_FAST_MEM static void draw_letter_normal(lv_draw_ctx_t * draw_ctx, const lv_draw_label_dsc_t * dsc,
                                                      const lv_point_t * pos, lv_font_glyph_dsc_t * g, const uint8_t * map_p);
@@ -36,6 +45,10 @@ static void draw_letter_subpx(lv_draw_ctx_t * draw_ctx, const lv_draw_label_dsc_
                               lv_font_glyph_dsc_t * g, const uint8_t * map_p);
 #endif /*LV_DRAW_COMPLEX && LV_USE_FONT_SUBPX*/
 
+#if LV_USE_LABEL && LV_LABEL_FROZEN
+    static void blend_a8(lv_draw_ctx_t * draw_ctx, const lv_draw_sw_blend_dsc_t * dsc);
+#endif
+
 /**********************
  *  STATIC VARIABLES
  **********************/
@@ -140,7 +153,16 @@ void lv_draw_sw_letter(lv_draw_ctx_t * draw_ctx, const lv_draw_label_dsc_t * dsc
         return;
     }
 
-    const uint8_t * map_p = lv_font_get_glyph_bitmap(g.resolved_font, letter);
+    const uint8_t * map_p = NULL;
+#if LV_USE_RENDER_CACHE && LV_RENDER_CACHE_GLYPH_MIN_SIZE
+    /*Use the already expanded 8 bit coverage of large glyphs*/
+    if(!g.resolved_font->subpx && g.bpp < 8 && (uint32_t)g.box_w * g.box_h >= LV_RENDER_CACHE_GLYPH_MIN_SIZE) {
+        map_p = get_glyph_a8(&g, letter);
+        if(map_p) g.bpp = 8;
+    }
+    if(map_p == NULL)
+#endif
+        map_p = lv_font_get_glyph_bitmap(g.resolved_font, letter);
     if(map_p == NULL) {
         LV_LOG_WARN("lv_draw_letter: character's bitmap not found");
         return;
@@ -158,6 +180,43 @@ void lv_draw_sw_letter(lv_draw_ctx_t * draw_ctx, const lv_draw_label_dsc_t * dsc
     }
 }
 
+#if LV_USE_LABEL && LV_LABEL_FROZEN
+/**
+ * Render a text to an 8 bit coverage map instead of the display buffer.
+ * The color, opacity and blend mode of `dsc` are ignored, they can be applied when the map is drawn as
+ * an `LV_IMG_CF_ALPHA_8BIT` image. Masks are not applied and sub-pixel fonts are not supported.
+ * @param dsc       descriptor of the label
+ * @param coords    coordinates of the text
+ * @param txt       the text to render
+ * @param buf       the coverage map with `lv_area_get_size(buf_area)` bytes
+ * @param buf_area  absolute coordinates of `buf`. The text is clipped to it.
+ */
+void lv_draw_sw_label_a8(const lv_draw_label_dsc_t * dsc, const lv_area_t * coords, const char * txt,
+                         lv_opa_t * buf, const lv_area_t * buf_area)
+{
+    lv_area_t area;
+    lv_area_copy(&area, buf_area);
+
+    lv_draw_sw_ctx_t ctx;
+    lv_draw_sw_init_ctx(NULL, &ctx.base_draw);
+    ctx.blend = blend_a8;
+    ctx.base_draw.buf = buf;
+    ctx.base_draw.buf_area = &area;
+    ctx.base_draw.clip_area = &area;
+
+    lv_memset_00(buf, lv_area_get_size(&area));
+
+    lv_draw_label_dsc_t a8_dsc = *dsc;
+    a8_dsc.color = lv_color_white();
+    a8_dsc.opa = LV_OPA_COVER;
+    a8_dsc.blend_mode = LV_BLEND_MODE_NORMAL;
+    a8_dsc.sel_start = LV_DRAW_LABEL_NO_TXT_SEL;
+    a8_dsc.sel_end = LV_DRAW_LABEL_NO_TXT_SEL;
+
+    lv_draw_label(&ctx.base_draw, &a8_dsc, coords, txt, NULL);
+}
+#endif
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
@@ -244,6 +303,43 @@ LV_ATTRIBUTE_FAST_MEM static void draw_letter_normal(lv_draw_ctx_t * draw_ctx, c
     int32_t row_start = pos->y >= draw_ctx->clip_area->y1 ? 0 : draw_ctx->clip_area->y1 - pos->y;
     int32_t row_end   = pos->y + box_h <= draw_ctx->clip_area->y2 ? box_h : draw_ctx->clip_area->y2 - pos->y + 1;
 
+    lv_draw_sw_blend_dsc_t blend_dsc;
+    lv_memset_00(&blend_dsc, sizeof(blend_dsc));
+    blend_dsc.color = dsc->color;
+    blend_dsc.opa = dsc->opa;
+    blend_dsc.blend_mode = dsc->blend_mode;
+
+    lv_area_t fill_area;
+    fill_area.x1 = col_start + pos->x;
+    fill_area.x2 = col_end  + pos->x - 1;
+    fill_area.y1 = row_start + pos->y;
+    fill_area.y2 = fill_area.y1;
+
+    lv_disp_t * disp = _lv_refr_get_disp_refreshing();
+
+    /*An 8 bit coverage (e.g. a cached glyph) at full opacity is already the mask of the letter.
+     *Blend it in one step instead of copying it to a mask buffer row by row.
+     *Without anti-aliasing the blending rounds the mask in place so it can't be used then.*/
+    if(bpp == 8 && bpp_opa_table_p == _lv_bpp8_opa_table && disp->driver->antialiasing) {
+        lv_area_t map_area;
+        map_area.x1 = pos->x;
+        map_area.y1 = pos->y;
+        map_area.x2 = pos->x + box_w - 1;
+        map_area.y2 = pos->y + box_h - 1;
+#if LV_DRAW_COMPLEX
+        if(!lv_draw_mask_is_any(&map_area))
+#endif
+        {
+            fill_area.y2 = row_end + pos->y - 1;
+            blend_dsc.blend_area = &fill_area;
+            blend_dsc.mask_area = &map_area;
+            blend_dsc.mask_buf = (lv_opa_t *)map_p;
+            blend_dsc.mask_res = LV_DRAW_MASK_RES_CHANGED;
+            lv_draw_sw_blend(draw_ctx, &blend_dsc);
+            return;
+        }
+    }
+
     /*Move on the map too*/
     uint32_t bit_ofs = (row_start * width_bit) + (col_start * bpp);
     map_p += bit_ofs >> 3;
@@ -252,23 +348,12 @@ LV_ATTRIBUTE_FAST_MEM static void draw_letter_normal(lv_draw_ctx_t * draw_ctx, c
     uint32_t col_bit;
     col_bit = bit_ofs & 0x7; /*"& 0x7" equals to "% 8" just faster*/
 
-    lv_draw_sw_blend_dsc_t blend_dsc;
-    lv_memset_00(&blend_dsc, sizeof(blend_dsc));
-    blend_dsc.color = dsc->color;
-    blend_dsc.opa = dsc->opa;
-    blend_dsc.blend_mode = dsc->blend_mode;
-
-    lv_coord_t hor_res = lv_disp_get_hor_res(_lv_refr_get_disp_refreshing());
+    lv_coord_t hor_res = lv_disp_get_hor_res(disp);
     uint32_t mask_buf_size = box_w * box_h > hor_res ? hor_res : box_w * box_h;
     lv_opa_t * mask_buf = lv_mem_buf_get(mask_buf_size);
     blend_dsc.mask_buf = mask_buf;
     int32_t mask_p = 0;
 
-    lv_area_t fill_area;
-    fill_area.x1 = col_start + pos->x;
-    fill_area.x2 = col_end  + pos->x - 1;
-    fill_area.y1 = row_start + pos->y;
-    fill_area.y2 = fill_area.y1;
 #if LV_DRAW_COMPLEX
     lv_coord_t fill_w = lv_area_get_width(&fill_area);
     lv_area_t mask_area;
@@ -286,30 +371,44 @@ LV_ATTRIBUTE_FAST_MEM static void draw_letter_normal(lv_draw_ctx_t * draw_ctx, c
 #if LV_DRAW_COMPLEX
         int32_t mask_p_start = mask_p;
 #endif
-        bitmask = bitmask_init >> col_bit;
-        for(col = col_start; col < col_end; col++) {
-            /*Load the pixel's opacity into the mask*/
-            letter_px = (*map_p & bitmask) >> (col_bit_max - col_bit);
-            if(letter_px) {
-                mask_buf[mask_p] = bpp_opa_table_p[letter_px];
+        if(bpp == 8) {
+            /*The coverage is already 1 byte/pixel, no need to unpack it*/
+            int32_t w = col_end - col_start;
+            if(bpp_opa_table_p == _lv_bpp8_opa_table) {
+                lv_memcpy(mask_buf + mask_p, map_p, w);
             }
             else {
-                mask_buf[mask_p] = 0;
+                for(col = 0; col < w; col++) mask_buf[mask_p + col] = bpp_opa_table_p[map_p[col]];
             }
+            map_p += w;
+            mask_p += w;
+        }
+        else {
+            bitmask = bitmask_init >> col_bit;
+            for(col = col_start; col < col_end; col++) {
+                /*Load the pixel's opacity into the mask*/
+                letter_px = (*map_p & bitmask) >> (col_bit_max - col_bit);
+                if(letter_px) {
+                    mask_buf[mask_p] = bpp_opa_table_p[letter_px];
+                }
+                else {
+                    mask_buf[mask_p] = 0;
+                }
 
-            /*Go to the next column*/
-            if(col_bit < col_bit_max) {
-                col_bit += bpp;
-                bitmask = bitmask >> bpp;
-            }
-            else {
-                col_bit = 0;
-                bitmask = bitmask_init;
-                map_p++;
-            }
+                /*Go to the next column*/
+                if(col_bit < col_bit_max) {
+                    col_bit += bpp;
+                    bitmask = bitmask >> bpp;
+                }
+                else {
+                    col_bit = 0;
+                    bitmask = bitmask_init;
+                    map_p++;
+                }
 
-            /*Next mask byte*/
-            mask_p++;
+                /*Next mask byte*/
+                mask_p++;
+            }
         }
 
 #if LV_DRAW_COMPLEX
@@ -351,6 +450,59 @@ LV_ATTRIBUTE_FAST_MEM static void draw_letter_normal(lv_draw_ctx_t * draw_ctx, c
     lv_mem_buf_release(mask_buf);
 }
 
+#if LV_USE_RENDER_CACHE && LV_RENDER_CACHE_GLYPH_MIN_SIZE
+/**
+ * Get the 8 bit coverage of a glyph from the render cache or expand and add it to the cache.
+ * @return the coverage (`box_w * box_h` bytes) or NULL if the glyph can't be cached
+ */
+static const uint8_t * get_glyph_a8(const lv_font_glyph_dsc_t * g, uint32_t letter)
+{
+    glyph_key_t key;
+    lv_memset_00(&key, sizeof(key));  /*Clear the padding too*/
+    key.font = g->resolved_font;
+    key.letter = letter;
+
+    uint32_t px_cnt = (uint32_t)g->box_w * g->box_h;
+    uint8_t * a8 = lv_render_cache_get(LV_RENDER_CACHE_CLASS_GLYPH, &key, sizeof(key), px_cnt);
+    if(a8) return a8;
+
+    const uint8_t * bpp_opa_table_p;
+    uint32_t bpp = g->bpp;
+    switch(bpp) {
+        case 1:
+            bpp_opa_table_p = _lv_bpp1_opa_table;
+            break;
+        case 2:
+            bpp_opa_table_p = _lv_bpp2_opa_table;
+            break;
+        case 3:
+        case 4:
+            bpp = 4;
+            bpp_opa_table_p = _lv_bpp4_opa_table;
+            break;
+        default:
+            return NULL;
+    }
+
+    const uint8_t * map_p = lv_font_get_glyph_bitmap(g->resolved_font, letter);
+    if(map_p == NULL) return NULL;
+
+    a8 = lv_render_cache_add(LV_RENDER_CACHE_CLASS_GLYPH, &key, sizeof(key), px_cnt);
+    if(a8 == NULL) return NULL;
+
+    /*The rows aren't padded, the pixels follow each other bit by bit*/
+    uint32_t px_per_byte = 8 / bpp;
+    uint32_t mask = (1 << bpp) - 1;
+    uint32_t i;
+    for(i = 0; i < px_cnt; i++) {
+        uint32_t shift = 8 - bpp - (i % px_per_byte) * bpp;
+        a8[i] = bpp_opa_table_p[(map_p[i / px_per_byte] >> shift) & mask];
+    }
+
+    return a8;
+}
+#endif /*LV_USE_RENDER_CACHE && LV_RENDER_CACHE_GLYPH_MIN_SIZE*/
+
 #if LV_DRAW_COMPLEX && LV_USE_FONT_SUBPX
 static void draw_letter_subpx(lv_draw_ctx_t * draw_ctx, const lv_draw_label_dsc_t * dsc, const lv_point_t * pos,
                               lv_font_glyph_dsc_t * g, const uint8_t * map_p)
@@ -571,3 +723,45 @@ static void draw_letter_subpx(lv_draw_ctx_t * draw_ctx, const lv_draw_label_dsc_
 }
 #endif /*LV_DRAW_COMPLEX && LV_USE_FONT_SUBPX*/
 
+#if LV_USE_LABEL && LV_LABEL_FROZEN
+/**
+ * Blend callback of `lv_draw_sw_label_a8`. Accumulates the coverage the same way as
+ * `lv_color_mix` would mix the same color over itself.
+ */
+static void blend_a8(lv_draw_ctx_t * draw_ctx, const lv_draw_sw_blend_dsc_t * dsc)
+{
+    if(dsc->mask_buf && dsc->mask_res == LV_DRAW_MASK_RES_TRANSP) return;
+
+    lv_area_t blend_area;
+    if(!_lv_area_intersect(&blend_area, dsc->blend_area, draw_ctx->clip_area)) return;
+
+    const lv_opa_t * mask = NULL;
+    lv_coord_t mask_stride = 0;
+    if(dsc->mask_buf && dsc->mask_res != LV_DRAW_MASK_RES_FULL_COVER) {
+        mask_stride = lv_area_get_width(dsc->mask_area);
+        mask = dsc->mask_buf + mask_stride * (blend_area.y1 - dsc->mask_area->y1) + (blend_area.x1 - dsc->mask_area->x1);
+    }
+
+    lv_coord_t dest_stride = lv_area_get_width(draw_ctx->buf_area);
+    lv_opa_t * dest = draw_ctx->buf;
+    dest += dest_stride * (blend_area.y1 - draw_ctx->buf_area->y1) + (blend_area.x1 - draw_ctx->buf_area->x1);
+
+    lv_coord_t w = lv_area_get_width(&blend_area);
+    lv_coord_t h = lv_area_get_height(&blend_area);
+    lv_coord_t x;
+    lv_coord_t y;
+    for(y = 0; y < h; y++) {
+        for(x = 0; x < w; x++) {
+            lv_opa_t a = mask ? mask[x] : LV_OPA_COVER;
+            if(dsc->opa < LV_OPA_MAX) a = (a * dsc->opa) >> 8;
+            if(a == LV_OPA_TRANSP) continue;
+
+            if(a >= LV_OPA_MAX) dest[x] = LV_OPA_COVER;
+            else if(dest[x] == LV_OPA_TRANSP) dest[x] = a;
+            else dest[x] += (a * (LV_OPA_COVER - dest[x])) >> 8;
+        }
+        dest += dest_stride;
+        if(mask) mask += mask_stride;
+    }
+}
+#endif
@@ -52,7 +52,7 @@ static void draw_border_simple(lv_draw_ctx_t * draw_ctx, const lv_area_t * outer
 /**********************
  *  STATIC VARIABLES
  **********************/
-#if defined(LV_SHADOW_CACHE_SIZE) && LV_SHADOW_CACHE_SIZE > 0
+#if defined(LV_SHADOW_CACHE_SIZE) && LV_SHADOW_CACHE_SIZE > 0 && !LV_USE_RENDER_CACHE
     static uint8_t sh_cache[LV_SHADOW_CACHE_SIZE * LV_SHADOW_CACHE_SIZE];
     static int32_t sh_cache_size = -1;
     static int32_t sh_cache_r = -1;
@@ -485,7 +485,24 @@ LV_ATTRIBUTE_FAST_MEM static void draw_shadow(lv_draw_ctx_t * draw_ctx, const lv
 
     lv_opa_t * sh_buf;
 
-#if LV_SHADOW_CACHE_SIZE
+#if LV_USE_RENDER_CACHE
+    /*The corner is mirrored in place later so work on a copy of the cached one*/
+    int32_t sh_key[2] = {corner_size, r_sh};
+    uint32_t sh_size = corner_size * corner_size;
+    lv_opa_t * sh_cached = lv_render_cache_get(LV_RENDER_CACHE_CLASS_SHADOW, sh_key, sizeof(sh_key), sh_size);
+    if(sh_cached) {
+        sh_buf = lv_mem_buf_get(sh_size);
+        lv_memcpy(sh_buf, sh_cached, sh_size);
+    }
+    else {
+        /*A larger buffer is required for calculation*/
+        sh_buf = lv_mem_buf_get(sh_size * sizeof(uint16_t));
+        shadow_draw_corner_buf(&core_area, (uint16_t *)sh_buf, dsc->shadow_width, r_sh);
+
+        sh_cached = lv_render_cache_add(LV_RENDER_CACHE_CLASS_SHADOW, sh_key, sizeof(sh_key), sh_size);
+        if(sh_cached) lv_memcpy(sh_cached, sh_buf, sh_size);
+    }
+#elif LV_SHADOW_CACHE_SIZE
     if(sh_cache_size == corner_size && sh_cache_r == r_sh) {
         /*Use the cache if available*/
         sh_buf = lv_mem_buf_get(corner_size * corner_size);
@@ -18,10 +18,24 @@
 /*********************
  *      DEFINES
  *********************/
+#if LV_FONT_FMT_TXT_PAIR_CACHE_SIZE & (LV_FONT_FMT_TXT_PAIR_CACHE_SIZE - 1)
+    #error "LV_FONT_FMT_TXT_PAIR_CACHE_SIZE must be a power of 2"
+#endif
 
 /**********************
  *      TYPEDEFS
  **********************/
+#if LV_FONT_FMT_TXT_PAIR_CACHE_SIZE
+/*Glyph ID and kerning of a letter followed by an other letter*/
+typedef struct {
+    const lv_font_t * font;
+    uint32_t letter;
+    uint32_t letter_next;
+    uint32_t gid;
+    int8_t kvalue;
+} pair_cache_t;
+#endif
+
 typedef enum {
     RLE_STATE_SINGLE = 0,
     RLE_STATE_REPEATE,
@@ -36,6 +50,7 @@ static int8_t get_kern_value(const lv_font_t * font, uint32_t gid_left, uint32_t
 static int32_t unicode_list_compare(const void * ref, const void * element);
 static int32_t kern_pair_8_compare(const void * ref, const void * element);
 static int32_t kern_pair_16_compare(const void * ref, const void * element);
+static uint32_t get_glyph_id_and_kern(const lv_font_t * font, uint32_t letter, uint32_t letter_next, int8_t * kvalue);
 
 #if LV_USE_FONT_COMPRESSED
     static void decompress(const uint8_t * in, uint8_t * out, lv_coord_t w, lv_coord_t h, uint8_t bpp, bool prefilter);
@@ -58,6 +73,10 @@ static int32_t kern_pair_16_compare(const void * ref, const void * element);
     static rle_state_t rle_state;
 #endif /*LV_USE_FONT_COMPRESSED*/
 
+#if LV_FONT_FMT_TXT_PAIR_CACHE_SIZE
+    static pair_cache_t pair_cache[LV_FONT_FMT_TXT_PAIR_CACHE_SIZE];
+#endif
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -154,16 +173,29 @@ bool lv_font_get_glyph_dsc_fmt_txt(const lv_font_t * font, lv_font_glyph_dsc_t *
         is_tab = true;
     }
     lv_font_fmt_txt_dsc_t * fdsc = (lv_font_fmt_txt_dsc_t *)font->dsc;
-    uint32_t gid = get_glyph_dsc_id(font, unicode_letter);
-    if(!gid) return false;
 
     int8_t kvalue = 0;
-    if(fdsc->kern_dsc) {
-        uint32_t gid_next = get_glyph_dsc_id(font, unicode_letter_next);
-        if(gid_next) {
-            kvalue = get_kern_value(font, gid, gid_next);
-        }
+#if LV_FONT_FMT_TXT_PAIR_CACHE_SIZE
+    /*The same pairs are measured and drawn again and again, remember the last ones*/
+    lv_uintptr_t hash = ((lv_uintptr_t)font >> 2) ^ (unicode_letter * 31) ^ (unicode_letter_next * 7);
+    pair_cache_t * pc = &pair_cache[hash & (LV_FONT_FMT_TXT_PAIR_CACHE_SIZE - 1)];
+    uint32_t gid;
+    if(pc->font == font && pc->letter == unicode_letter && pc->letter_next == unicode_letter_next) {
+        gid = pc->gid;
+        kvalue = pc->kvalue;
+    }
+    else {
+        gid = get_glyph_id_and_kern(font, unicode_letter, unicode_letter_next, &kvalue);
+        pc->font = font;
+        pc->letter = unicode_letter;
+        pc->letter_next = unicode_letter_next;
+        pc->gid = gid;
+        pc->kvalue = kvalue;
     }
+#else
+    uint32_t gid = get_glyph_id_and_kern(font, unicode_letter, unicode_letter_next, &kvalue);
+#endif
+    if(!gid) return false;
 
     /*Put together a glyph dsc*/
     const lv_font_fmt_txt_glyph_dsc_t * gdsc = &fdsc->glyph_dsc[gid];
@@ -202,10 +234,42 @@ void _lv_font_clean_up_fmt_txt(void)
 #endif
 }
 
+/**
+ * Forget the cached glyph IDs and kerning values. Needed if a font is freed
+ * as an other font might be created at the same address.
+ */
+void _lv_font_fmt_txt_clean_pair_cache(void)
+{
+#if LV_FONT_FMT_TXT_PAIR_CACHE_SIZE
+    lv_memset_00(pair_cache, sizeof(pair_cache));
+#endif
+}
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
 
+/**
+ * Get the glyph ID of a letter and the kerning value to the next letter
+ * @return the glyph ID or 0 if the letter is not in the font
+ */
+static uint32_t get_glyph_id_and_kern(const lv_font_t * font, uint32_t letter, uint32_t letter_next, int8_t * kvalue)
+{
+    lv_font_fmt_txt_dsc_t * fdsc = (lv_font_fmt_txt_dsc_t *)font->dsc;
+    uint32_t gid = get_glyph_dsc_id(font, letter);
+    if(!gid) return 0;
+
+    *kvalue = 0;
+    if(fdsc->kern_dsc) {
+        uint32_t gid_next = get_glyph_dsc_id(font, letter_next);
+        if(gid_next) {
+            *kvalue = get_kern_value(font, gid, gid_next);
+        }
+    }
+
+    return gid;
+}
+
 static uint32_t get_glyph_dsc_id(const lv_font_t * font, uint32_t letter)
 {
     if(letter == '\0') return 0;
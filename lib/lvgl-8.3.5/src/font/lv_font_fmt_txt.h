@@ -225,6 +225,12 @@ bool lv_font_get_glyph_dsc_fmt_txt(const lv_font_t * font, lv_font_glyph_dsc_t *
  */
 void _lv_font_clean_up_fmt_txt(void);
 
+/**
+ * Forget the cached glyph IDs and kerning values. Needed if a font is freed
+ * as an other font might be created at the same address.
+ */
+void _lv_font_fmt_txt_clean_pair_cache(void);
+
 /**********************
  *      MACROS
  **********************/
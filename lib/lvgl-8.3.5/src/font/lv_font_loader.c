@@ -175,6 +175,12 @@ void lv_font_free(lv_font_t * font)
             lv_mem_free(dsc);
         }
         lv_mem_free(font);
+
+        /*Don't find this font's glyphs for an other font loaded to the same address*/
+        _lv_font_fmt_txt_clean_pair_cache();
+#if LV_USE_RENDER_CACHE
+        lv_render_cache_clean();
+#endif
     }
 }
 
@@ -186,6 +186,61 @@
             #define LV_MEM_CUSTOM_REALLOC realloc
         #endif
     #endif
+
+    /*Allocator for large, rarely written buffers such as render caches (e.g. PSRAM).
+     *`LV_MEM_CUSTOM_FREE` has to be able to free this memory too.*/
+    #ifndef LV_MEM_CUSTOM_LARGE_INCLUDE
+        #ifdef CONFIG_LV_MEM_CUSTOM_LARGE_INCLUDE
+            #define LV_MEM_CUSTOM_LARGE_INCLUDE CONFIG_LV_MEM_CUSTOM_LARGE_INCLUDE
+        #else
+            #define LV_MEM_CUSTOM_LARGE_INCLUDE <stdlib.h>
+        #endif
+    #endif
+    #ifndef LV_MEM_CUSTOM_LARGE_ALLOC
+        #ifdef CONFIG_LV_MEM_CUSTOM_LARGE_ALLOC
+            #define LV_MEM_CUSTOM_LARGE_ALLOC CONFIG_LV_MEM_CUSTOM_LARGE_ALLOC
+        #else
+            #define LV_MEM_CUSTOM_LARGE_ALLOC   malloc
+        #endif
+    #endif
+
+    /*Serve the small allocations (objects, styles, linked list nodes, etc.) from fixed size classes
+     *to not fragment the heap. The classes grow in chunks allocated with `LV_MEM_CUSTOM_ALLOC`
+     *or with `LV_MEM_CUSTOM_LARGE_ALLOC` if it fails.*/
+    #ifndef LV_MEM_CUSTOM_POOL
+        #ifdef CONFIG_LV_MEM_CUSTOM_POOL
+            #define LV_MEM_CUSTOM_POOL CONFIG_LV_MEM_CUSTOM_POOL
+        #else
+            #define LV_MEM_CUSTOM_POOL 0
+        #endif
+    #endif
+    #if LV_MEM_CUSTOM_POOL
+        /*Size of a chunk of a size class in bytes*/
+        #ifndef LV_MEM_CUSTOM_POOL_CHUNK_SIZE
+            #ifdef CONFIG_LV_MEM_CUSTOM_POOL_CHUNK_SIZE
+                #define LV_MEM_CUSTOM_POOL_CHUNK_SIZE CONFIG_LV_MEM_CUSTOM_POOL_CHUNK_SIZE
+            #else
+                #define LV_MEM_CUSTOM_POOL_CHUNK_SIZE (2 * 1024)
+            #endif
+        #endif
+
+        /*Max. number of the chunks.
+         *If all are used, the allocations go to `LV_MEM_CUSTOM_ALLOC` directly.*/
+        #ifndef LV_MEM_CUSTOM_POOL_CHUNK_MAX
+            #ifdef CONFIG_LV_MEM_CUSTOM_POOL_CHUNK_MAX
+                #define LV_MEM_CUSTOM_POOL_CHUNK_MAX CONFIG_LV_MEM_CUSTOM_POOL_CHUNK_MAX
+            #else
+                #define LV_MEM_CUSTOM_POOL_CHUNK_MAX 64
+            #endif
+        #endif
+    #endif
+
+    /*Optional functions to get the state of the system heap for `lv_mem_monitor()`*/
+    //#define LV_MEM_CUSTOM_MONITOR_INCLUDE <esp_heap_caps.h>
+    //#define LV_MEM_CUSTOM_TOTAL_SIZE()          heap_caps_get_total_size(MALLOC_CAP_INTERNAL)
+    //#define LV_MEM_CUSTOM_FREE_SIZE()           heap_caps_get_free_size(MALLOC_CAP_INTERNAL)
+    //#define LV_MEM_CUSTOM_BIGGEST_FREE_SIZE()   heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL)
+    //#define LV_MEM_CUSTOM_MIN_FREE_SIZE()       heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL)
 #endif     /*LV_MEM_CUSTOM*/
 
 /*Number of the intermediate memory buffer used during rendering and other internal processing mechanisms.
@@ -313,6 +368,28 @@
             #define LV_CIRCLE_CACHE_SIZE 4
         #endif
     #endif
+
+    /* Set number of maximally cached ring (arc) coverage tables.
+    * The row spans and anti-aliased edges of a 1/4 ring are saved for each (radius, width) pair
+    * and used by the arc drawing instead of an inner and an outer radius mask.
+    * About radius * 12 bytes + the anti-aliased pixels are used per ring
+    * 0: to disable caching */
+    #ifndef LV_RING_MASK_CACHE_SIZE
+        #ifdef CONFIG_LV_RING_MASK_CACHE_SIZE
+            #define LV_RING_MASK_CACHE_SIZE CONFIG_LV_RING_MASK_CACHE_SIZE
+        #else
+            #define LV_RING_MASK_CACHE_SIZE 0
+        #endif
+    #endif
+
+    /*Ring tables larger than this are allocated with `LV_MEM_CUSTOM_LARGE_ALLOC` (if `LV_MEM_CUSTOM == 1`)*/
+    #ifndef LV_RING_MASK_CACHE_LARGE_LIMIT
+        #ifdef CONFIG_LV_RING_MASK_CACHE_LARGE_LIMIT
+            #define LV_RING_MASK_CACHE_LARGE_LIMIT CONFIG_LV_RING_MASK_CACHE_LARGE_LIMIT
+        #else
+            #define LV_RING_MASK_CACHE_LARGE_LIMIT (4 * 1024)
+        #endif
+    #endif
 #endif /*LV_DRAW_COMPLEX*/
 
 /**
@@ -402,6 +479,58 @@
     #endif
 #endif
 
+/*Keep gradient color maps, blurred shadow corners and decoded images in a common cache.
+ *Small items are stored in the internal RAM, larger ones with `LV_MEM_CUSTOM_LARGE_ALLOC` (e.g. PSRAM).
+ *The budget of each tier is reserved as one block by `lv_init()`, so drawing doesn't allocate memory.
+ *The least recently used items are dropped when the budget of a tier is exceeded.
+ *Replaces LV_GRAD_CACHE_DEF_SIZE and LV_SHADOW_CACHE_SIZE.
+ *Hits, misses and evictions can be read with `lv_render_cache_get_stat()`*/
+#ifndef LV_USE_RENDER_CACHE
+    #ifdef CONFIG_LV_USE_RENDER_CACHE
+        #define LV_USE_RENDER_CACHE CONFIG_LV_USE_RENDER_CACHE
+    #else
+        #define LV_USE_RENDER_CACHE 0
+    #endif
+#endif
+#if LV_USE_RENDER_CACHE
+    /*Items up to this size [bytes] are stored in the internal RAM tier*/
+    #ifndef LV_RENDER_CACHE_SMALL_ITEM_SIZE
+        #ifdef CONFIG_LV_RENDER_CACHE_SMALL_ITEM_SIZE
+            #define LV_RENDER_CACHE_SMALL_ITEM_SIZE CONFIG_LV_RENDER_CACHE_SMALL_ITEM_SIZE
+        #else
+            #define LV_RENDER_CACHE_SMALL_ITEM_SIZE 1024
+        #endif
+    #endif
+
+    /*Budget of the internal RAM tier [bytes]*/
+    #ifndef LV_RENDER_CACHE_INTERNAL_SIZE
+        #ifdef CONFIG_LV_RENDER_CACHE_INTERNAL_SIZE
+            #define LV_RENDER_CACHE_INTERNAL_SIZE CONFIG_LV_RENDER_CACHE_INTERNAL_SIZE
+        #else
+            #define LV_RENDER_CACHE_INTERNAL_SIZE (4 * 1024)
+        #endif
+    #endif
+
+    /*Budget of the large item (e.g. PSRAM) tier [bytes]*/
+    #ifndef LV_RENDER_CACHE_LARGE_SIZE
+        #ifdef CONFIG_LV_RENDER_CACHE_LARGE_SIZE
+            #define LV_RENDER_CACHE_LARGE_SIZE CONFIG_LV_RENDER_CACHE_LARGE_SIZE
+        #else
+            #define LV_RENDER_CACHE_LARGE_SIZE (16 * 1024)
+        #endif
+    #endif
+
+    /*Keep the 8 bit coverage of glyphs having at least this many pixels in the large tier
+     *instead of unpacking their 1..4 bpp bitmap on every redraw. 0: don't cache glyphs*/
+    #ifndef LV_RENDER_CACHE_GLYPH_MIN_SIZE
+        #ifdef CONFIG_LV_RENDER_CACHE_GLYPH_MIN_SIZE
+            #define LV_RENDER_CACHE_GLYPH_MIN_SIZE CONFIG_LV_RENDER_CACHE_GLYPH_MIN_SIZE
+        #else
+            #define LV_RENDER_CACHE_GLYPH_MIN_SIZE 0
+        #endif
+    #endif
+#endif
+
 /*Maximum buffer size to allocate for rotation.
  *Only used if software rotation is enabled in the display driver.*/
 #ifndef LV_DISP_ROT_MAX_BUF
@@ -412,6 +541,23 @@
     #endif
 #endif
 
+/*Fill and blend RGB565 pixels with kernels which handle more pixels per iteration
+ *(in 32 or 64 bit words, according to the architecture) instead of pixel by pixel.
+ *The result is the same as without them. Used only with LV_COLOR_DEPTH 16 and LV_COLOR_16_SWAP 0*/
+#ifndef LV_DRAW_SW_RGB565_KERNEL
+    #ifdef CONFIG_LV_DRAW_SW_RGB565_KERNEL
+        #define LV_DRAW_SW_RGB565_KERNEL CONFIG_LV_DRAW_SW_RGB565_KERNEL
+    #else
+        #define LV_DRAW_SW_RGB565_KERNEL 0
+    #endif
+#endif
+#if LV_DRAW_SW_RGB565_KERNEL
+    /*Header of platform specific (e.g. SIMD) kernels.
+     *Define e.g. `LV_DRAW_SW_RGB565_FILL_CUSTOM` in it to replace `lv_draw_sw_rgb565_fill()` with an own implementation.
+     *See `src/draw/sw/lv_draw_sw_blend_rgb565.h` for the list of kernels*/
+    //#define LV_DRAW_SW_RGB565_KERNEL_INCLUDE "my_rgb565_kernels.h"
+#endif
+
 /*-------------
  * GPU
  *-----------*/
@@ -1200,6 +1346,16 @@
     #endif
 #endif
 
+/*Number of (letter, next letter) pairs whose glyph ID and kerning value are remembered
+ *to not search the character maps and the kerning table again. Must be a power of 2. 0: disable*/
+#ifndef LV_FONT_FMT_TXT_PAIR_CACHE_SIZE
+    #ifdef CONFIG_LV_FONT_FMT_TXT_PAIR_CACHE_SIZE
+        #define LV_FONT_FMT_TXT_PAIR_CACHE_SIZE CONFIG_LV_FONT_FMT_TXT_PAIR_CACHE_SIZE
+    #else
+        #define LV_FONT_FMT_TXT_PAIR_CACHE_SIZE 0
+    #endif
+#endif
+
 /*Enables/disables support for compressed fonts.*/
 #ifndef LV_USE_FONT_COMPRESSED
     #ifdef CONFIG_LV_USE_FONT_COMPRESSED
@@ -1477,6 +1633,13 @@
             #define LV_LABEL_LONG_TXT_HINT 1  /*Store some extra info in labels to speed up drawing of very long texts*/
         #endif
     #endif
+    #ifndef LV_LABEL_FROZEN
+        #ifdef CONFIG_LV_LABEL_FROZEN
+            #define LV_LABEL_FROZEN CONFIG_LV_LABEL_FROZEN
+        #else
+            #define LV_LABEL_FROZEN 0         /*Allow rendering the text of a label once to an A8 bitmap and blit it afterwards*/
+        #endif
+    #endif
 #endif
 
 #ifndef LV_USE_LINE
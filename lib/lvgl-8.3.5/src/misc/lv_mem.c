@@ -15,6 +15,10 @@
 
 #if LV_MEM_CUSTOM != 0
     #include LV_MEM_CUSTOM_INCLUDE
+    #include LV_MEM_CUSTOM_LARGE_INCLUDE
+    #ifdef LV_MEM_CUSTOM_MONITOR_INCLUDE
+        #include LV_MEM_CUSTOM_MONITOR_INCLUDE
+    #endif
 #endif
 
 #ifdef LV_MEM_POOL_INCLUDE
@@ -42,6 +46,14 @@
 /**********************
  *      TYPEDEFS
  **********************/
+#if _LV_MEM_USE_POOL
+/*A chunk of a size class*/
+typedef struct {
+    lv_uintptr_t start;
+    uint32_t size;
+    uint8_t cls;
+} pool_chunk_t;
+#endif
 
 /**********************
  *  STATIC PROTOTYPES
@@ -50,6 +62,16 @@
     static void lv_mem_walker(void * ptr, size_t size, int used, void * user);
 #endif
 
+#if _LV_MEM_USE_POOL
+    static void * pool_alloc(size_t size);
+    static void pool_free(pool_chunk_t * chunk, void * data);
+    static void * pool_realloc(void * data, size_t new_size);
+    static uint32_t get_class(size_t size);
+    static void * chunk_alloc(uint32_t size, uint8_t cls);
+    static void chunk_remove(uint32_t idx);
+    static pool_chunk_t * find_chunk(const void * data);
+#endif
+
 /**********************
  *  STATIC VARIABLES
  **********************/
@@ -59,6 +81,17 @@
     static uint32_t max_used;
 #endif
 
+#if _LV_MEM_USE_POOL
+    static const uint16_t class_size[LV_MEM_POOL_CLASS_CNT] = {16, 32, 48, 64, 96, 128};
+    static pool_chunk_t chunks[LV_MEM_CUSTOM_POOL_CHUNK_MAX];   /*Sorted by address*/
+    static uint32_t chunk_cnt;
+    static void * free_list[LV_MEM_POOL_CLASS_CNT];             /*The free blocks store the next free block*/
+    static lv_mem_pool_class_monitor_t class_mon[LV_MEM_POOL_CLASS_CNT];
+    static uint32_t pool_used_size;
+    static uint32_t pool_max_used_size;
+    static uint32_t fallback_cnt;
+#endif
+
 static uint32_t zero_mem = ZERO_MEM_SENTINEL; /*Give the address of this variable if 0 byte should be allocated*/
 
 /**********************
@@ -100,6 +133,13 @@ void lv_mem_init(void)
 #endif
 #endif
 
+#if _LV_MEM_USE_POOL
+    uint32_t i;
+    for(i = 0; i < LV_MEM_POOL_CLASS_CNT; i++) {
+        class_mon[i].block_size = class_size[i];
+    }
+#endif
+
 #if LV_MEM_ADD_JUNK
     LV_LOG_WARN("LV_MEM_ADD_JUNK is enabled which makes LVGL much slower");
 #endif
@@ -132,6 +172,8 @@ void * lv_mem_alloc(size_t size)
 
 #if LV_MEM_CUSTOM == 0
     void * alloc = lv_tlsf_malloc(tlsf, size);
+#elif _LV_MEM_USE_POOL
+    void * alloc = pool_alloc(size);
 #else
     void * alloc = LV_MEM_CUSTOM_ALLOC(size);
 #endif
@@ -162,6 +204,28 @@ void * lv_mem_alloc(size_t size)
     return alloc;
 }
 
+/**
+ * Allocate a large, rarely written buffer (e.g. a render cache).
+ * With `LV_MEM_CUSTOM == 1` `LV_MEM_CUSTOM_LARGE_ALLOC` is tried first (e.g. PSRAM),
+ * else or if it fails the memory is allocated with `lv_mem_alloc`.
+ * @param size size of the memory to allocate in bytes
+ * @return pointer to the allocated memory. Free it with `lv_mem_free`.
+ */
+void * lv_mem_alloc_large(size_t size)
+{
+#if LV_MEM_CUSTOM != 0
+    if(size != 0) {
+        void * alloc = LV_MEM_CUSTOM_LARGE_ALLOC(size);
+        if(alloc) {
+            MEM_TRACE("allocated %lu large bytes at %p", (unsigned long)size, alloc);
+            return alloc;
+        }
+    }
+#endif
+
+    return lv_mem_alloc(size);
+}
+
 /**
  * Free an allocated data
  * @param data pointer to an allocated memory
@@ -180,6 +244,13 @@ void lv_mem_free(void * data)
     if(cur_used > size) cur_used -= size;
     else cur_used = 0;
 #else
+#  if _LV_MEM_USE_POOL
+    pool_chunk_t * chunk = find_chunk(data);
+    if(chunk) {
+        pool_free(chunk, data);
+        return;
+    }
+#  endif
     LV_MEM_CUSTOM_FREE(data);
 #endif
 }
@@ -204,6 +275,8 @@ void * lv_mem_realloc(void * data_p, size_t new_size)
 
 #if LV_MEM_CUSTOM == 0
     void * new_p = lv_tlsf_realloc(tlsf, data_p, new_size);
+#elif _LV_MEM_USE_POOL
+    void * new_p = pool_realloc(data_p, new_size);
 #else
     void * new_p = LV_MEM_CUSTOM_REALLOC(data_p, new_size);
 #endif
@@ -233,6 +306,27 @@ lv_res_t lv_mem_test(void)
         LV_LOG_WARN("pool failed");
         return LV_RES_INV;
     }
+#elif _LV_MEM_USE_POOL
+    /*Every free block has to be in a chunk of its class*/
+    uint32_t cls;
+    for(cls = 0; cls < LV_MEM_POOL_CLASS_CNT; cls++) {
+        uint32_t free_cnt = 0;
+        void * block;
+        for(block = free_list[cls]; block; block = *(void **)block) {
+            pool_chunk_t * chunk = find_chunk(block);
+            if(chunk == NULL || chunk->cls != cls ||
+               ((lv_uintptr_t)block - chunk->start) % class_size[cls] != 0) {
+                LV_LOG_WARN("invalid free block in size class %d", (int)class_size[cls]);
+                return LV_RES_INV;
+            }
+            free_cnt++;
+        }
+
+        if(free_cnt + class_mon[cls].used_cnt != class_mon[cls].block_cnt) {
+            LV_LOG_WARN("lost blocks in size class %d", (int)class_size[cls]);
+            return LV_RES_INV;
+        }
+    }
 #endif
     MEM_TRACE("passed");
     return LV_RES_OK;
@@ -265,9 +359,99 @@ void lv_mem_monitor(lv_mem_monitor_t * mon_p)
     mon_p->max_used = max_used;
 
     MEM_TRACE("finished");
+#else
+    /*Report the system heap if the platform tells its state*/
+#  ifdef LV_MEM_CUSTOM_TOTAL_SIZE
+    mon_p->total_size = LV_MEM_CUSTOM_TOTAL_SIZE();
+#  endif
+#  ifdef LV_MEM_CUSTOM_FREE_SIZE
+    mon_p->free_size = LV_MEM_CUSTOM_FREE_SIZE();
+#  endif
+#  ifdef LV_MEM_CUSTOM_BIGGEST_FREE_SIZE
+    mon_p->free_biggest_size = LV_MEM_CUSTOM_BIGGEST_FREE_SIZE();
+    if(mon_p->free_size > 0) {
+        mon_p->frag_pct = 100 - mon_p->free_biggest_size * 100U / mon_p->free_size;
+    }
+#  endif
+#  ifdef LV_MEM_CUSTOM_MIN_FREE_SIZE
+    mon_p->max_used = mon_p->total_size - LV_MEM_CUSTOM_MIN_FREE_SIZE();
+#  endif
+    if(mon_p->total_size > 0) {
+        mon_p->used_pct = 100 - (100U * mon_p->free_size) / mon_p->total_size;
+    }
 #endif
 }
 
+#if _LV_MEM_USE_POOL
+
+/**
+ * Give information about the size classes
+ * @param mon_p pointer to a lv_mem_pool_monitor_t variable,
+ *              the result of the analysis will be stored here
+ */
+void lv_mem_pool_monitor(lv_mem_pool_monitor_t * mon_p)
+{
+    lv_memset_00(mon_p, sizeof(lv_mem_pool_monitor_t));
+    lv_memcpy(mon_p->cls, class_mon, sizeof(class_mon));
+
+    uint32_t i;
+    for(i = 0; i < chunk_cnt; i++) {
+        mon_p->total_size += chunks[i].size;
+    }
+    mon_p->chunk_cnt = chunk_cnt;
+
+    mon_p->used_size = pool_used_size;
+    mon_p->max_used_size = pool_max_used_size;
+    mon_p->fallback_cnt = fallback_cnt;
+    if(mon_p->total_size > 0) {
+        mon_p->frag_pct = 100 - (100U * mon_p->used_size) / mon_p->total_size;
+    }
+}
+
+/**
+ * Give the chunks of the size classes without used blocks back to the system heap.
+ * The chunks are kept by default to reuse them without fragmenting the heap.
+ */
+void lv_mem_pool_trim(void)
+{
+    /*Count the free blocks of each chunk*/
+    uint16_t free_cnt[LV_MEM_CUSTOM_POOL_CHUNK_MAX];
+    lv_memset_00(free_cnt, sizeof(free_cnt));
+
+    uint32_t cls;
+    for(cls = 0; cls < LV_MEM_POOL_CLASS_CNT; cls++) {
+        void * block;
+        for(block = free_list[cls]; block; block = *(void **)block) {
+            free_cnt[find_chunk(block) - chunks]++;
+        }
+    }
+
+    /*Unlink the blocks of the empty chunks*/
+    for(cls = 0; cls < LV_MEM_POOL_CLASS_CNT; cls++) {
+        void ** prev = &free_list[cls];
+        while(*prev) {
+            void ** block = *prev;
+            pool_chunk_t * chunk = find_chunk(block);
+            if(free_cnt[chunk - chunks] == chunk->size / class_size[cls]) *prev = *block;
+            else prev = block;
+        }
+    }
+
+    /*Free the empty chunks. Go backward as the following chunks are moved on remove.*/
+    uint32_t i = chunk_cnt;
+    while(i > 0) {
+        i--;
+        pool_chunk_t * chunk = &chunks[i];
+        if(free_cnt[i] != chunk->size / class_size[chunk->cls]) continue;
+
+        class_mon[chunk->cls].block_cnt -= free_cnt[i];
+        LV_MEM_CUSTOM_FREE((void *)chunk->start);
+        chunk_remove(i);
+    }
+}
+
+#endif /*_LV_MEM_USE_POOL*/
+
 
 /**
  * Get a temporal buffer with the given size.
@@ -564,3 +748,142 @@ static void lv_mem_walker(void * ptr, size_t size, int used, void * user)
     }
 }
 #endif
+
+#if _LV_MEM_USE_POOL
+
+/**
+ * Allocate from a size class if `size` fits into one.
+ * Fall back to `LV_MEM_CUSTOM_ALLOC` if there are no more chunks.
+ */
+static void * pool_alloc(size_t size)
+{
+    uint32_t cls = get_class(size);
+    if(cls < LV_MEM_POOL_CLASS_CNT) {
+        if(free_list[cls] == NULL) {
+            uint8_t * chunk = chunk_alloc(LV_MEM_CUSTOM_POOL_CHUNK_SIZE, cls);
+            if(chunk) {
+                uint32_t block_cnt = LV_MEM_CUSTOM_POOL_CHUNK_SIZE / class_size[cls];
+                uint32_t i;
+                for(i = 0; i < block_cnt; i++) {
+                    void ** block = (void **)(chunk + (block_cnt - 1 - i) * class_size[cls]);
+                    *block = free_list[cls];
+                    free_list[cls] = block;
+                }
+                class_mon[cls].block_cnt += block_cnt;
+            }
+        }
+
+        void ** block = free_list[cls];
+        if(block) {
+            free_list[cls] = *block;
+
+            class_mon[cls].used_cnt++;
+            class_mon[cls].max_used_cnt = LV_MAX(class_mon[cls].used_cnt, class_mon[cls].max_used_cnt);
+            pool_used_size += class_size[cls];
+            pool_max_used_size = LV_MAX(pool_used_size, pool_max_used_size);
+            return block;
+        }
+
+        fallback_cnt++;
+    }
+
+    return LV_MEM_CUSTOM_ALLOC(size);
+}
+
+/**
+ * Put a block back to its size class
+ */
+static void pool_free(pool_chunk_t * chunk, void * data)
+{
+    uint8_t cls = chunk->cls;
+    *(void **)data = free_list[cls];
+    free_list[cls] = data;
+    class_mon[cls].used_cnt--;
+    pool_used_size -= class_size[cls];
+}
+
+static void * pool_realloc(void * data, size_t new_size)
+{
+    pool_chunk_t * chunk = find_chunk(data);
+    if(chunk == NULL) return LV_MEM_CUSTOM_REALLOC(data, new_size);
+
+    /*The block is large enough, keep it*/
+    size_t old_size = class_size[chunk->cls];
+    if(new_size <= old_size) return data;
+
+    void * new_p = pool_alloc(new_size);
+    if(new_p == NULL) return NULL;
+
+    /*The allocation can add a chunk and move the others in `chunks`*/
+    lv_memcpy(new_p, data, old_size);
+    pool_free(find_chunk(data), data);
+    return new_p;
+}
+
+/**
+ * Get the smallest size class for `size` or `LV_MEM_POOL_CLASS_CNT` if it's too large
+ */
+static uint32_t get_class(size_t size)
+{
+    uint32_t cls;
+    for(cls = 0; cls < LV_MEM_POOL_CLASS_CNT; cls++) {
+        if(size <= class_size[cls]) break;
+    }
+    return cls;
+}
+
+/**
+ * Allocate a chunk (in internal RAM if possible) and register it
+ * @return the chunk or NULL if there is no more memory or place to register it
+ */
+static void * chunk_alloc(uint32_t size, uint8_t cls)
+{
+    if(chunk_cnt >= LV_MEM_CUSTOM_POOL_CHUNK_MAX) return NULL;
+
+    void * mem = LV_MEM_CUSTOM_ALLOC(size);
+    if(mem == NULL) mem = LV_MEM_CUSTOM_LARGE_ALLOC(size);
+    if(mem == NULL) return NULL;
+
+    /*Keep the chunks sorted*/
+    uint32_t idx = chunk_cnt;
+    while(idx > 0 && chunks[idx - 1].start > (lv_uintptr_t)mem) {
+        chunks[idx] = chunks[idx - 1];
+        idx--;
+    }
+
+    chunks[idx].start = (lv_uintptr_t)mem;
+    chunks[idx].size = size;
+    chunks[idx].cls = cls;
+    chunk_cnt++;
+    return mem;
+}
+
+static void chunk_remove(uint32_t idx)
+{
+    chunk_cnt--;
+    for(; idx < chunk_cnt; idx++) {
+        chunks[idx] = chunks[idx + 1];
+    }
+}
+
+/**
+ * Find the chunk of a memory with a binary search
+ * @return the chunk or NULL if the memory wasn't allocated from a chunk
+ */
+static pool_chunk_t * find_chunk(const void * data)
+{
+    lv_uintptr_t p = (lv_uintptr_t)data;
+    uint32_t lo = 0;
+    uint32_t hi = chunk_cnt;
+    while(lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if(chunks[mid].start <= p) lo = mid + 1;
+        else hi = mid;
+    }
+
+    if(lo == 0) return NULL;
+    pool_chunk_t * chunk = &chunks[lo - 1];
+    return p < chunk->start + chunk->size ? chunk : NULL;
+}
+
+#endif /*_LV_MEM_USE_POOL*/
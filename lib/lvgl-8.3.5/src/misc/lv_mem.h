@@ -24,6 +24,15 @@ extern "C" {
 /*********************
  *      DEFINES
  *********************/
+/*The size classes can be used only with a custom allocator*/
+#if LV_MEM_CUSTOM == 0
+    #define _LV_MEM_USE_POOL    0
+#else
+    #define _LV_MEM_USE_POOL    LV_MEM_CUSTOM_POOL
+#endif
+
+/*Number of the size classes. Allocations larger than the largest class go to `LV_MEM_CUSTOM_ALLOC`*/
+#define LV_MEM_POOL_CLASS_CNT   6
 
 /**********************
  *      TYPEDEFS
@@ -51,6 +60,29 @@ typedef struct {
 
 typedef lv_mem_buf_t lv_mem_buf_arr_t[LV_MEM_BUF_MAX_NUM];
 
+/**
+ * Usage of a size class.
+ */
+typedef struct {
+    uint32_t block_size;    /**< Size of the blocks in bytes*/
+    uint32_t block_cnt;     /**< Number of blocks in the chunks of the class*/
+    uint32_t used_cnt;      /**< Number of blocks in use*/
+    uint32_t max_used_cnt;  /**< The largest `used_cnt` so far*/
+} lv_mem_pool_class_monitor_t;
+
+/**
+ * Usage of the size classes.
+ */
+typedef struct {
+    lv_mem_pool_class_monitor_t cls[LV_MEM_POOL_CLASS_CNT];
+    uint32_t chunk_cnt;     /**< Number of chunks of the size classes*/
+    uint32_t total_size;    /**< Size of the chunks of the size classes*/
+    uint32_t used_size;     /**< Bytes of the used blocks*/
+    uint32_t max_used_size; /**< The largest `used_size` so far*/
+    uint32_t fallback_cnt;  /**< Small allocations served by `LV_MEM_CUSTOM_ALLOC` because no more chunks were available*/
+    uint8_t frag_pct;       /**< Free part of the chunks which can't be used by the other size classes*/
+} lv_mem_pool_monitor_t;
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -73,6 +105,15 @@ void lv_mem_deinit(void);
  */
 void * lv_mem_alloc(size_t size);
 
+/**
+ * Allocate a large, rarely written buffer (e.g. a render cache).
+ * With `LV_MEM_CUSTOM == 1` `LV_MEM_CUSTOM_LARGE_ALLOC` is tried first (e.g. PSRAM),
+ * else or if it fails the memory is allocated with `lv_mem_alloc`.
+ * @param size size of the memory to allocate in bytes
+ * @return pointer to the allocated memory. Free it with `lv_mem_free`.
+ */
+void * lv_mem_alloc_large(size_t size);
+
 /**
  * Free an allocated data
  * @param data pointer to an allocated memory
@@ -101,6 +142,23 @@ lv_res_t lv_mem_test(void);
  */
 void lv_mem_monitor(lv_mem_monitor_t * mon_p);
 
+#if _LV_MEM_USE_POOL
+
+/**
+ * Give information about the size classes
+ * @param mon_p pointer to a lv_mem_pool_monitor_t variable,
+ *              the result of the analysis will be stored here
+ */
+void lv_mem_pool_monitor(lv_mem_pool_monitor_t * mon_p);
+
+/**
+ * Give the chunks of the size classes without used blocks back to the system heap.
+ * The chunks are kept by default to reuse them without fragmenting the heap.
+ */
+void lv_mem_pool_trim(void);
+
+#endif /*_LV_MEM_USE_POOL*/
+
 
 /**
  * Get a temporal buffer with the given size.
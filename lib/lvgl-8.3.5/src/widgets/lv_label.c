@@ -12,6 +12,7 @@
 #include "../misc/lv_assert.h"
 #include "../core/lv_group.h"
 #include "../draw/lv_draw.h"
+#include "../draw/sw/lv_draw_sw.h"
 #include "../misc/lv_color.h"
 #include "../misc/lv_math.h"
 #include "../misc/lv_bidi.h"
@@ -31,6 +32,23 @@
 /**********************
  *      TYPEDEFS
  **********************/
+#if LV_LABEL_FROZEN
+typedef struct _lv_label_frozen_t {
+    lv_opa_t * buf;             /*The rendered text. NULL if nothing is visible*/
+    lv_area_t buf_area;         /*Area of `buf` relative to the label*/
+    bool valid;                 /*false: the text needs to be rendered again*/
+
+    /*The text is rendered again if any of these changes*/
+    const lv_font_t * font;
+    lv_area_t txt_area;         /*Text area relative to the label. Covers the size, padding and scroll.*/
+    lv_coord_t letter_space;
+    lv_coord_t line_space;
+    lv_text_align_t align;
+    lv_text_decor_t decor;
+    lv_text_flag_t flag;
+    lv_base_dir_t bidi_dir;
+} lv_label_frozen_t;
+#endif
 
 /**********************
  *  STATIC PROTOTYPES
@@ -49,6 +67,14 @@ static void lv_label_dot_tmp_free(lv_obj_t * label);
 static void set_ofs_x_anim(void * obj, int32_t v);
 static void set_ofs_y_anim(void * obj, int32_t v);
 
+#if LV_LABEL_FROZEN
+    static bool draw_frozen(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx, const lv_draw_label_dsc_t * dsc,
+                            const lv_area_t * txt_coords);
+    static bool render_frozen(lv_obj_t * obj, const lv_draw_label_dsc_t * dsc, const lv_area_t * txt_coords,
+                              const lv_area_t * draw_area);
+    static void invalidate_frozen(lv_obj_t * obj);
+#endif
+
 /**********************
  *  STATIC VARIABLES
  **********************/
@@ -92,6 +118,11 @@ void lv_label_set_text(lv_obj_t * obj, const char * text)
     /*If text is NULL then just refresh with the current text*/
     if(text == NULL) text = label->text;
 
+#if LV_LABEL_FROZEN
+    /*Setting the same text again (e.g. a periodically refreshed status) keeps the rendered text*/
+    if(label->text == text || label->text == NULL || strcmp(label->text, text) != 0) invalidate_frozen(obj);
+#endif
+
     if(label->text == text && label->static_txt == 0) {
         /*If set its own text then reallocate it (maybe its size changed)*/
 #if LV_USE_ARABIC_PERSIAN_CHARS
@@ -169,6 +200,10 @@ void lv_label_set_text_fmt(lv_obj_t * obj, const char * fmt, ...)
     va_end(args);
     label->static_txt = 0; /*Now the text is dynamically allocated*/
 
+#if LV_LABEL_FROZEN
+    invalidate_frozen(obj);
+#endif
+
     lv_label_refr_text(obj);
 }
 
@@ -187,6 +222,10 @@ void lv_label_set_text_static(lv_obj_t * obj, const char * text)
         label->text       = (char *)text;
     }
 
+#if LV_LABEL_FROZEN
+    invalidate_frozen(obj);
+#endif
+
     lv_label_refr_text(obj);
 }
 
@@ -213,6 +252,9 @@ void lv_label_set_long_mode(lv_obj_t * obj, lv_label_long_mode_t long_mode)
     }
 
     label->long_mode = long_mode;
+#if LV_LABEL_FROZEN
+    invalidate_frozen(obj);
+#endif
     lv_label_refr_text(obj);
 }
 
@@ -229,6 +271,30 @@ void lv_label_set_recolor(lv_obj_t * obj, bool en)
     lv_label_refr_text(obj);
 }
 
+#if LV_LABEL_FROZEN
+void lv_label_set_frozen(lv_obj_t * obj, bool en)
+{
+    LV_ASSERT_OBJ(obj, MY_CLASS);
+
+    lv_label_t * label = (lv_label_t *)obj;
+    if((label->frozen != NULL) == en) return;
+
+    if(en) {
+        label->frozen = lv_mem_alloc(sizeof(lv_label_frozen_t));
+        LV_ASSERT_MALLOC(label->frozen);
+        if(label->frozen == NULL) return;
+        lv_memset_00(label->frozen, sizeof(lv_label_frozen_t));
+    }
+    else {
+        invalidate_frozen(obj);
+        lv_mem_free(label->frozen);
+        label->frozen = NULL;
+    }
+
+    lv_obj_invalidate(obj);
+}
+#endif
+
 void lv_label_set_text_sel_start(lv_obj_t * obj, uint32_t index)
 {
     LV_ASSERT_OBJ(obj, MY_CLASS);
@@ -283,6 +349,16 @@ bool lv_label_get_recolor(const lv_obj_t * obj)
     return label->recolor == 0 ? false : true;
 }
 
+#if LV_LABEL_FROZEN
+bool lv_label_get_frozen(const lv_obj_t * obj)
+{
+    LV_ASSERT_OBJ(obj, MY_CLASS);
+
+    lv_label_t * label = (lv_label_t *)obj;
+    return label->frozen != NULL;
+}
+#endif
+
 void lv_label_get_letter_pos(const lv_obj_t * obj, uint32_t char_id, lv_point_t * pos)
 {
     LV_ASSERT_OBJ(obj, MY_CLASS);
@@ -677,6 +753,10 @@ void lv_label_cut_text(lv_obj_t * obj, uint32_t pos, uint32_t cnt)
     /*Delete the characters*/
     _lv_txt_cut(label_txt, pos, cnt);
 
+#if LV_LABEL_FROZEN
+    invalidate_frozen(obj);
+#endif
+
     /*Refresh the label*/
     lv_label_refr_text(obj);
 }
@@ -713,6 +793,10 @@ static void lv_label_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
     label->dot.tmp_ptr   = NULL;
     label->dot_tmp_alloc = 0;
 
+#if LV_LABEL_FROZEN
+    label->frozen = NULL;
+#endif
+
     lv_obj_clear_flag(obj, LV_OBJ_FLAG_CLICKABLE);
     lv_label_set_long_mode(obj, LV_LABEL_LONG_WRAP);
     lv_label_set_text(obj, "Text");
@@ -729,6 +813,12 @@ static void lv_label_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
     lv_label_dot_tmp_free(obj);
     if(!label->static_txt) lv_mem_free(label->text);
     label->text = NULL;
+
+#if LV_LABEL_FROZEN
+    invalidate_frozen(obj);
+    lv_mem_free(label->frozen);
+    label->frozen = NULL;
+#endif
 }
 
 static void lv_label_event(const lv_obj_class_t * class_p, lv_event_t * e)
@@ -849,6 +939,10 @@ static void draw_main(lv_event_t * e)
         lv_area_move(&txt_coords, 0, -s);
         txt_coords.y2 = obj->coords.y2;
     }
+
+#if LV_LABEL_FROZEN
+    if(label->frozen && draw_frozen(obj, draw_ctx, &label_draw_dsc, &txt_coords)) return;
+#endif
     if(label->long_mode == LV_LABEL_LONG_SCROLL || label->long_mode == LV_LABEL_LONG_SCROLL_CIRCULAR) {
         const lv_area_t * clip_area_ori = draw_ctx->clip_area;
         draw_ctx->clip_area = &txt_clip;
@@ -888,6 +982,160 @@ static void draw_main(lv_event_t * e)
     draw_ctx->clip_area = clip_area_ori;
 }
 
+#if LV_LABEL_FROZEN
+/**
+ * Draw the text from the pre-rendered bitmap. Render the bitmap first if the layout of the text has changed.
+ * @param obj           pointer to a label object
+ * @param draw_ctx      the current draw context
+ * @param dsc           the descriptor the text would be drawn with
+ * @param txt_coords    the coordinates the text would be drawn to
+ * @return              false if the text can't be drawn from a bitmap and should be drawn normally
+ */
+static bool draw_frozen(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx, const lv_draw_label_dsc_t * dsc,
+                        const lv_area_t * txt_coords)
+{
+    lv_label_t * label = (lv_label_t *)obj;
+    lv_label_frozen_t * frozen = label->frozen;
+
+    /*These would need a moving or multi-colored bitmap*/
+    if(label->long_mode == LV_LABEL_LONG_SCROLL || label->long_mode == LV_LABEL_LONG_SCROLL_CIRCULAR) return false;
+    if(dsc->flag & LV_TEXT_FLAG_RECOLOR) return false;
+    if(dsc->sel_start != LV_DRAW_LABEL_NO_TXT_SEL && dsc->sel_end != LV_DRAW_LABEL_NO_TXT_SEL) return false;
+    if(dsc->font->subpx) return false;
+    /*The decoration would get the opacity twice (see below)*/
+    if(dsc->decor != LV_TEXT_DECOR_NONE && dsc->opa < LV_OPA_MAX) return false;
+
+    /*The letters can be drawn out of the label (see LV_EVENT_REFR_EXT_DRAW_SIZE) so render the whole draw area*/
+    lv_area_t draw_area;
+    lv_area_copy(&draw_area, &obj->coords);
+    lv_coord_t ext = _lv_obj_get_ext_draw_size(obj);
+    lv_area_increase(&draw_area, ext, ext);
+
+    /*The bitmap can't follow the masks*/
+    if(lv_draw_mask_is_any(&draw_area)) return false;
+
+    lv_area_t txt_area;
+    lv_area_copy(&txt_area, txt_coords);
+    lv_area_move(&txt_area, -obj->coords.x1, -obj->coords.y1);
+
+    if(!frozen->valid ||
+       frozen->font != dsc->font ||
+       frozen->letter_space != dsc->letter_space ||
+       frozen->line_space != dsc->line_space ||
+       frozen->align != dsc->align ||
+       frozen->decor != dsc->decor ||
+       frozen->flag != dsc->flag ||
+       frozen->bidi_dir != dsc->bidi_dir ||
+       !_lv_area_is_equal(&frozen->txt_area, &txt_area)) {
+
+        if(!render_frozen(obj, dsc, txt_coords, &draw_area)) return false;
+
+        frozen->font = dsc->font;
+        frozen->letter_space = dsc->letter_space;
+        frozen->line_space = dsc->line_space;
+        frozen->align = dsc->align;
+        frozen->decor = dsc->decor;
+        frozen->flag = dsc->flag;
+        frozen->bidi_dir = dsc->bidi_dir;
+        frozen->txt_area = txt_area;
+    }
+
+    /*Nothing is visible*/
+    if(frozen->buf == NULL) return true;
+
+    lv_area_t coords;
+    lv_area_copy(&coords, &frozen->buf_area);
+    lv_area_move(&coords, obj->coords.x1, obj->coords.y1);
+
+    lv_draw_img_dsc_t img_dsc;
+    lv_draw_img_dsc_init(&img_dsc);
+    img_dsc.recolor = dsc->color;
+    /*The letters apply the opacity both on their coverage and on the blending. Do the same to look the same.*/
+    img_dsc.opa = dsc->opa >= LV_OPA_MAX ? dsc->opa : (dsc->opa * dsc->opa) >> 8;
+    img_dsc.blend_mode = dsc->blend_mode;
+    lv_draw_img_decoded(draw_ctx, &img_dsc, &coords, frozen->buf, LV_IMG_CF_ALPHA_8BIT);
+
+    return true;
+}
+
+/**
+ * Render the text of a label to a bitmap and keep only the area where the text is visible.
+ * @param obj           pointer to a label object
+ * @param dsc           the descriptor to render the text with
+ * @param txt_coords    the coordinates of the text
+ * @param draw_area     the area to render
+ * @return              false if the bitmap couldn't be allocated
+ */
+static bool render_frozen(lv_obj_t * obj, const lv_draw_label_dsc_t * dsc, const lv_area_t * txt_coords,
+                          const lv_area_t * draw_area)
+{
+    lv_label_t * label = (lv_label_t *)obj;
+    lv_label_frozen_t * frozen = label->frozen;
+
+    invalidate_frozen(obj);
+
+    lv_opa_t * tmp = lv_mem_alloc_large(lv_area_get_size(draw_area));
+    if(tmp == NULL) {
+        LV_LOG_WARN("couldn't allocate the bitmap of a frozen label");
+        return false;
+    }
+
+    lv_draw_sw_label_a8(dsc, txt_coords, label->text, tmp, draw_area);
+
+    lv_coord_t w = lv_area_get_width(draw_area);
+    lv_coord_t h = lv_area_get_height(draw_area);
+    lv_area_t bbox = {LV_COORD_MAX, LV_COORD_MAX, LV_COORD_MIN, LV_COORD_MIN};
+    lv_coord_t x;
+    lv_coord_t y;
+    for(y = 0; y < h; y++) {
+        const lv_opa_t * row = tmp + y * w;
+        for(x = 0; x < w; x++) {
+            if(row[x] == LV_OPA_TRANSP) continue;
+            if(x < bbox.x1) bbox.x1 = x;
+            if(x > bbox.x2) bbox.x2 = x;
+            if(y < bbox.y1) bbox.y1 = y;
+            bbox.y2 = y;
+        }
+    }
+
+    if(bbox.x1 <= bbox.x2) {
+        lv_coord_t bbox_w = lv_area_get_width(&bbox);
+        frozen->buf = lv_mem_alloc_large(lv_area_get_size(&bbox));
+        if(frozen->buf == NULL) {
+            LV_LOG_WARN("couldn't allocate the bitmap of a frozen label");
+            lv_mem_free(tmp);
+            return false;
+        }
+
+        for(y = bbox.y1; y <= bbox.y2; y++) {
+            lv_memcpy(frozen->buf + (y - bbox.y1) * bbox_w, tmp + y * w + bbox.x1, bbox_w);
+        }
+
+        lv_area_move(&bbox, draw_area->x1 - obj->coords.x1, draw_area->y1 - obj->coords.y1);
+        frozen->buf_area = bbox;
+    }
+
+    lv_mem_free(tmp);
+    frozen->valid = true;
+    return true;
+}
+
+/**
+ * Free the bitmap of a frozen label to render it again on the next draw
+ * @param obj           pointer to a label object
+ */
+static void invalidate_frozen(lv_obj_t * obj)
+{
+    lv_label_t * label = (lv_label_t *)obj;
+    lv_label_frozen_t * frozen = label->frozen;
+    if(frozen == NULL) return;
+
+    lv_mem_free(frozen->buf);
+    frozen->buf = NULL;
+    frozen->valid = false;
+}
+#endif
+
 /**
  * Refresh the label with its text stored in its extended data
  * @param label pointer to a label object
@@ -914,7 +1162,16 @@ static void lv_label_refr_text(lv_obj_t * obj)
     if(label->expand != 0) flag |= LV_TEXT_FLAG_EXPAND;
     if(lv_obj_get_style_width(obj, LV_PART_MAIN) == LV_SIZE_CONTENT && !obj->w_layout) flag |= LV_TEXT_FLAG_FIT;
 
-    lv_txt_get_size(&size, label->text, font, letter_space, line_space, max_w, flag);
+    /*Only the scroll and dot modes use the text size here. Content sized labels are
+     *measured again on LV_EVENT_GET_SELF_SIZE, so wrapped and clipped labels skip it*/
+    if(label->long_mode == LV_LABEL_LONG_SCROLL || label->long_mode == LV_LABEL_LONG_SCROLL_CIRCULAR ||
+       label->long_mode == LV_LABEL_LONG_DOT) {
+        lv_txt_get_size(&size, label->text, font, letter_space, line_space, max_w, flag);
+    }
+    else {
+        size.x = 0;
+        size.y = 0;
+    }
 
     lv_obj_refresh_self_size(obj);
 
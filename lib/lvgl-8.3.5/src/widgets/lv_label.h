@@ -68,6 +68,10 @@ typedef struct {
     uint32_t sel_end;
 #endif
 
+#if LV_LABEL_FROZEN
+    struct _lv_label_frozen_t * frozen; /*The pre-rendered text if freezing is enabled, else NULL*/
+#endif
+
     lv_point_t offset; /*Text draw position offset*/
     lv_label_long_mode_t long_mode : 3; /*Determine what to do with the long texts*/
     uint8_t static_txt : 1;             /*Flag to indicate the text is static*/
@@ -132,6 +136,17 @@ void lv_label_set_long_mode(lv_obj_t * obj, lv_label_long_mode_t long_mode);
  */
 void lv_label_set_recolor(lv_obj_t * obj, bool en);
 
+#if LV_LABEL_FROZEN
+/**
+ * Render the text only once to an A8 bitmap and draw the bitmap afterwards.
+ * The bitmap is rendered again only if the text, the font or the size changes.
+ * Recolored, selected, scrolling, sub-pixel rendered and masked texts are drawn as usual.
+ * @param obj           pointer to a label object
+ * @param en            true: enable freezing, false: disable and free the bitmap
+ */
+void lv_label_set_frozen(lv_obj_t * obj, bool en);
+#endif
+
 /**
  * Set where text selection should start
  * @param obj       pointer to a label object
@@ -171,6 +186,15 @@ lv_label_long_mode_t lv_label_get_long_mode(const lv_obj_t * obj);
  */
 bool lv_label_get_recolor(const lv_obj_t * obj);
 
+#if LV_LABEL_FROZEN
+/**
+ * Get whether the text is drawn from a pre-rendered bitmap
+ * @param obj       pointer to a label object
+ * @return          true: freezing is enabled
+ */
+bool lv_label_get_frozen(const lv_obj_t * obj);
+#endif
+
 /**
  * Get the relative x and y coordinates of a letter
  * @param obj       pointer to a label object
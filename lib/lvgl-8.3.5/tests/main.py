@@ -22,6 +22,9 @@ build_only_options = {
 test_options = {
     'OPTIONS_TEST_SYSHEAP': 'Test config, system heap, 32 bit color depth',
     'OPTIONS_TEST_DEFHEAP': 'Test config, LVGL heap, 32 bit color depth',
+    'OPTIONS_TEST_MEM_POOL': 'Test config, system heap with LVGL pools, 32 bit color depth',
+    'OPTIONS_TEST_MEM_POOL_SOAK': 'Test config, system heap with LVGL pools, long soak of the pools',
+    'OPTIONS_TEST_RGB565': 'Test config, system heap, 16 bit color depth, RGB565 kernels',
 }
 
 
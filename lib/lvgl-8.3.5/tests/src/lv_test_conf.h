@@ -30,6 +30,18 @@ void lv_test_assert_fail(void);
 uint32_t custom_tick_get(void);
 #define LV_TICK_CUSTOM_SYS_TIME_EXPR custom_tick_get()
 
+/*Widgets added to this copy of LVGL without an lv_conf_template.h entry.
+ *Off here, so the -Wundef build doesn't stop at their `#if LV_USE_...`*/
+#define LV_USE_ANALOGCLOCK 0
+#define LV_USE_BARCODE 0
+#define LV_USE_CAROUSEL 0
+#define LV_USE_DCLOCK 0
+#define LV_USE_FS_RAWFS 0
+#define LV_USE_RADIOBTN 0
+#define LV_USE_TEXTPROGRESS 0
+#define LV_USE_VIDEO 0
+#define LV_USE_ZH_KEYBOARD 0
+
 typedef void * lv_user_data_t;
 
 /**********************
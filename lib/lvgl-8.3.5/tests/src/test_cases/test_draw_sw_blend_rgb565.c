@@ -0,0 +1,276 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+#include "../src/draw/sw/lv_draw_sw.h"
+
+#if _LV_DRAW_SW_RGB565_KERNEL
+
+#include "unity/unity.h"
+#include <stdio.h>
+#include <time.h>
+
+#define BUF_W   97      /*Odd to test the unaligned starts and ends too*/
+#define BUF_H   23
+#define BENCH_W 466
+#define BENCH_H 80
+#define BENCH_ROUNDS 200
+
+static lv_color_t dest_ref[BENCH_W * BENCH_H];
+static lv_color_t dest_act[BENCH_W * BENCH_H];
+static lv_color_t src_buf[BENCH_W * BENCH_H];
+static lv_opa_t mask_buf[BENCH_W * BENCH_H + 8];
+
+static uint32_t rnd_state;
+
+void setUp(void)
+{
+    rnd_state = 0x12345678;
+}
+
+void tearDown(void)
+{
+    /* Function run after every test */
+}
+
+static uint32_t rnd(void)
+{
+    rnd_state = rnd_state * 1103515245 + 12345;
+    return rnd_state >> 8;
+}
+
+/*Random mask with runs of 0x00 and 0xFF like an anti-aliased shape has*/
+static void fill_mask_random(lv_opa_t * mask, uint32_t len)
+{
+    uint32_t i = 0;
+    while(i < len) {
+        uint32_t run = 1 + rnd() % 24;
+        uint32_t type = rnd() % 4;
+        for(; run && i < len; run--, i++) {
+            if(type == 0) mask[i] = LV_OPA_TRANSP;
+            else if(type == 1) mask[i] = LV_OPA_COVER;
+            else mask[i] = rnd() & 0xFF;
+        }
+    }
+}
+
+static void fill_color_random(lv_color_t * buf, uint32_t len)
+{
+    uint32_t i;
+    for(i = 0; i < len; i++) buf[i].full = rnd() & 0xFFFF;
+}
+
+/*The pixel by pixel reference implementations the same as `fill_normal()` and `map_normal()` without kernels*/
+
+static void ref_fill(lv_color_t * dest_buf, int32_t w, int32_t h, lv_coord_t dest_stride, lv_color_t color,
+                     lv_opa_t opa, const lv_opa_t * mask, lv_coord_t mask_stride)
+{
+    int32_t x;
+    int32_t y;
+    if(mask == NULL) {
+        if(opa >= LV_OPA_MAX) {
+            for(y = 0; y < h; y++) {
+                for(x = 0; x < w; x++) dest_buf[x] = color;
+                dest_buf += dest_stride;
+            }
+        }
+        else {
+            opa = (uint32_t)((uint32_t)opa + 4) >> 3;
+            opa = opa << 3;
+            uint16_t color_premult[3];
+            lv_color_premult(color, opa, color_premult);
+            lv_opa_t opa_inv = 255 - opa;
+            for(y = 0; y < h; y++) {
+                for(x = 0; x < w; x++) dest_buf[x] = lv_color_mix_premult(color_premult, dest_buf[x], opa_inv);
+                dest_buf += dest_stride;
+            }
+        }
+    }
+    else {
+        for(y = 0; y < h; y++) {
+            for(x = 0; x < w; x++) {
+                if(opa >= LV_OPA_MAX) {
+                    if(mask[x] == LV_OPA_COVER) dest_buf[x] = color;
+                    else dest_buf[x] = lv_color_mix(color, dest_buf[x], mask[x]);
+                }
+                else if(mask[x]) {
+                    lv_opa_t opa_tmp = mask[x] == LV_OPA_COVER ? opa : (uint32_t)((uint32_t)mask[x] * opa) >> 8;
+                    if(opa_tmp == LV_OPA_COVER) dest_buf[x] = color;
+                    else dest_buf[x] = lv_color_mix(color, dest_buf[x], opa_tmp);
+                }
+            }
+            dest_buf += dest_stride;
+            mask += mask_stride;
+        }
+    }
+}
+
+static void ref_map(lv_color_t * dest_buf, int32_t w, int32_t h, lv_coord_t dest_stride, const lv_color_t * src,
+                    lv_coord_t src_stride, lv_opa_t opa, const lv_opa_t * mask, lv_coord_t mask_stride)
+{
+    int32_t x;
+    int32_t y;
+    for(y = 0; y < h; y++) {
+        for(x = 0; x < w; x++) {
+            if(mask == NULL) {
+                dest_buf[x] = opa >= LV_OPA_MAX ? src[x] : lv_color_mix(src[x], dest_buf[x], opa);
+            }
+            else if(opa > LV_OPA_MAX) {
+                if(mask[x] == LV_OPA_COVER) dest_buf[x] = src[x];
+                else if(mask[x]) dest_buf[x] = lv_color_mix(src[x], dest_buf[x], mask[x]);
+            }
+            else if(mask[x]) {
+                lv_opa_t opa_tmp = mask[x] >= LV_OPA_MAX ? opa : ((opa * mask[x]) >> 8);
+                dest_buf[x] = lv_color_mix(src[x], dest_buf[x], opa_tmp);
+            }
+        }
+        dest_buf += dest_stride;
+        src += src_stride;
+        if(mask) mask += mask_stride;
+    }
+}
+
+static void act_fill(lv_color_t * dest_buf, int32_t w, int32_t h, lv_coord_t dest_stride, lv_color_t color,
+                     lv_opa_t opa, const lv_opa_t * mask, lv_coord_t mask_stride)
+{
+    if(mask) lv_draw_sw_rgb565_fill_mask(dest_buf, w, h, dest_stride, color, opa, mask, mask_stride);
+    else if(opa >= LV_OPA_MAX) lv_draw_sw_rgb565_fill(dest_buf, w, h, dest_stride, color);
+    else lv_draw_sw_rgb565_fill_opa(dest_buf, w, h, dest_stride, color, opa);
+}
+
+static void act_map(lv_color_t * dest_buf, int32_t w, int32_t h, lv_coord_t dest_stride, const lv_color_t * src,
+                    lv_coord_t src_stride, lv_opa_t opa, const lv_opa_t * mask, lv_coord_t mask_stride)
+{
+    if(mask) lv_draw_sw_rgb565_map_mask(dest_buf, w, h, dest_stride, src, src_stride, opa, mask, mask_stride);
+    else lv_draw_sw_rgb565_map_opa(dest_buf, w, h, dest_stride, src, src_stride, opa);
+}
+
+static const lv_opa_t opas[] = {0, 1, 3, 4, 100, 127, 128, 200, 251, 252, 253, 254, 255};
+
+/*Try all the opacities with different offsets and widths to hit all the alignments and remainders*/
+static void test_kernel(bool map, bool masked)
+{
+    uint32_t o;
+    int32_t ofs;
+    int32_t w;
+    for(o = 0; o < sizeof(opas); o++) {
+        /*Without mask opa >= LV_OPA_MAX is a simple fill or memcpy*/
+        if(map && !masked && opas[o] >= LV_OPA_MAX) continue;
+        for(ofs = 0; ofs < 8; ofs++) {
+            for(w = 1; w <= BUF_W - ofs; w += 1 + w / 4) {
+                fill_color_random(dest_ref, BUF_W * BUF_H);
+                lv_memcpy(dest_act, dest_ref, sizeof(lv_color_t) * BUF_W * BUF_H);
+                fill_color_random(src_buf, BUF_W * BUF_H);
+                fill_mask_random(mask_buf, BUF_W * BUF_H);
+                lv_color_t color;
+                color.full = rnd() & 0xFFFF;
+
+                int32_t h = BUF_H - 1;
+                const lv_opa_t * mask = masked ? &mask_buf[ofs / 2] : NULL;
+                if(map) {
+                    ref_map(&dest_ref[ofs], w, h, BUF_W, &src_buf[ofs], BUF_W, opas[o], mask, BUF_W);
+                    act_map(&dest_act[ofs], w, h, BUF_W, &src_buf[ofs], BUF_W, opas[o], mask, BUF_W);
+                }
+                else {
+                    ref_fill(&dest_ref[ofs], w, h, BUF_W, color, opas[o], mask, BUF_W);
+                    act_fill(&dest_act[ofs], w, h, BUF_W, color, opas[o], mask, BUF_W);
+                }
+
+                TEST_ASSERT_EQUAL_HEX16_ARRAY(dest_ref, dest_act, BUF_W * BUF_H);
+            }
+        }
+    }
+}
+
+void test_rgb565_fill_is_bit_exact(void)
+{
+    test_kernel(false, false);
+}
+
+void test_rgb565_fill_mask_is_bit_exact(void)
+{
+    test_kernel(false, true);
+}
+
+void test_rgb565_map_opa_is_bit_exact(void)
+{
+    test_kernel(true, false);
+}
+
+void test_rgb565_map_mask_is_bit_exact(void)
+{
+    test_kernel(true, true);
+}
+
+/*Mix every possible background color with some foreground colors and many opacities*/
+void test_rgb565_map_opa_all_colors(void)
+{
+    uint32_t o;
+    uint32_t fg;
+    uint32_t base;
+    for(o = 0; o < 256; o += 5) {
+        for(fg = 0; fg <= 0xFFFF; fg += 0x0F0F) {
+            for(base = 0; base < 0x10000; base += 0x8000) {
+                uint32_t i;
+                for(i = 0; i < 0x8000; i++) {
+                    src_buf[i].full = fg;
+                    dest_ref[i].full = base + i;
+                    dest_act[i].full = base + i;
+                }
+                ref_map(dest_ref, 256, 128, 256, src_buf, 256, o, NULL, 0);
+                act_map(dest_act, 256, 128, 256, src_buf, 256, o, NULL, 0);
+                TEST_ASSERT_EQUAL_HEX16_ARRAY(dest_ref, dest_act, 0x8000);
+            }
+        }
+    }
+}
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec * 1000000.0 + (double)t.tv_nsec / 1000.0;
+}
+
+static void bench(const char * name, bool map, lv_opa_t opa, bool masked)
+{
+    const lv_opa_t * mask = masked ? mask_buf : NULL;
+    uint32_t i;
+    lv_color_t color = lv_color_white();
+
+    double t_ref = now_us();
+    for(i = 0; i < BENCH_ROUNDS; i++) {
+        if(map) ref_map(dest_ref, BENCH_W, BENCH_H, BENCH_W, src_buf, BENCH_W, opa, mask, BENCH_W);
+        else ref_fill(dest_ref, BENCH_W, BENCH_H, BENCH_W, color, opa, mask, BENCH_W);
+    }
+    t_ref = now_us() - t_ref;
+
+    double t_act = now_us();
+    for(i = 0; i < BENCH_ROUNDS; i++) {
+        if(map) act_map(dest_act, BENCH_W, BENCH_H, BENCH_W, src_buf, BENCH_W, opa, mask, BENCH_W);
+        else act_fill(dest_act, BENCH_W, BENCH_H, BENCH_W, color, opa, mask, BENCH_W);
+    }
+    t_act = now_us() - t_act;
+
+    double px = (double)BENCH_W * BENCH_H * BENCH_ROUNDS;
+    printf("%-16s reference: %8.1f Mpx/s, kernel: %8.1f Mpx/s\n", name, px / t_ref, px / t_act);
+}
+
+/*Not a real test, just prints the throughput of a typical (466x80 px) draw buffer*/
+void test_rgb565_benchmark(void)
+{
+    fill_color_random(src_buf, BENCH_W * BENCH_H);
+    fill_mask_random(mask_buf, BENCH_W * BENCH_H);
+    lv_memset_00(dest_ref, sizeof(dest_ref));
+    lv_memset_00(dest_act, sizeof(dest_act));
+
+    bench("fill", false, LV_OPA_COVER, false);
+    bench("fill opa", false, LV_OPA_50, false);
+    bench("fill mask", false, LV_OPA_COVER, true);
+    bench("fill mask opa", false, LV_OPA_50, true);
+    bench("map opa", true, LV_OPA_50, false);
+    bench("map mask", true, LV_OPA_COVER, true);
+    bench("map mask opa", true, LV_OPA_50, true);
+}
+
+#endif
+
+#endif
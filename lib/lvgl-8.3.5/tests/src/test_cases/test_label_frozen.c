@@ -0,0 +1,245 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#if LV_LABEL_FROZEN
+
+#include "unity/unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if LV_FONT_MONTSERRAT_48
+    #define TEST_FONT   &lv_font_montserrat_48
+#else
+    #define TEST_FONT   LV_FONT_DEFAULT
+#endif
+
+/*The flush callback of the test display copies the rendered frame here*/
+extern lv_color_t test_fb[];
+
+/*The frame drawn without freezing. As large as the test display.*/
+static lv_color_t ref_fb[800 * 480];
+
+void setUp(void)
+{
+    uint32_t px_cnt = lv_disp_get_hor_res(NULL) * lv_disp_get_ver_res(NULL);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(ref_fb) / sizeof(ref_fb[0]), px_cnt);
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+}
+
+static uint32_t get_fb_size(void)
+{
+    return lv_disp_get_hor_res(NULL) * lv_disp_get_ver_res(NULL) * sizeof(lv_color_t);
+}
+
+static void refr_screen(void)
+{
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+}
+
+static void assert_fb_similar(uint32_t max_diff)
+{
+    if(max_diff == 0) {
+        TEST_ASSERT_EQUAL_MEMORY(ref_fb, test_fb, get_fb_size());
+        return;
+    }
+
+    uint32_t px_cnt = lv_disp_get_hor_res(NULL) * lv_disp_get_ver_res(NULL);
+    uint32_t i;
+    for(i = 0; i < px_cnt; i++) {
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(max_diff, abs(LV_COLOR_GET_R(ref_fb[i]) - LV_COLOR_GET_R(test_fb[i])));
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(max_diff, abs(LV_COLOR_GET_G(ref_fb[i]) - LV_COLOR_GET_G(test_fb[i])));
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(max_diff, abs(LV_COLOR_GET_B(ref_fb[i]) - LV_COLOR_GET_B(test_fb[i])));
+    }
+}
+
+/*Draw the label normally and then frozen and compare the frames.
+ *With opacity the letters are rounded a little differently so allow a small difference.*/
+static void assert_frozen_draws_the_same(lv_obj_t * label, uint32_t max_diff)
+{
+    lv_label_set_frozen(label, false);
+    refr_screen();
+    lv_memcpy(ref_fb, test_fb, get_fb_size());
+
+    lv_label_set_frozen(label, true);
+    refr_screen();
+    assert_fb_similar(max_diff);
+
+    /*Now from the already rendered bitmap*/
+    refr_screen();
+    assert_fb_similar(max_diff);
+}
+
+static lv_obj_t * create_label(const char * txt)
+{
+    lv_obj_t * label = lv_label_create(lv_scr_act());
+    lv_obj_set_style_text_font(label, TEST_FONT, 0);
+    lv_obj_set_style_text_align(label, LV_TEXT_ALIGN_CENTER, 0);
+    lv_label_set_long_mode(label, LV_LABEL_LONG_WRAP);
+    lv_obj_set_width(label, 380);
+    lv_label_set_text(label, txt);
+    lv_obj_align(label, LV_ALIGN_TOP_MID, 0, 150);
+    return label;
+}
+
+void test_label_frozen_draws_the_same(void)
+{
+    lv_obj_t * label = create_label("Connecting to WiFi...");
+    assert_frozen_draws_the_same(label, 0);
+
+    lv_obj_set_style_text_color(label, lv_palette_main(LV_PALETTE_RED), 0);
+    lv_obj_set_style_text_decor(label, LV_TEXT_DECOR_UNDERLINE, 0);
+    assert_frozen_draws_the_same(label, 0);
+
+    /*With opacity the decoration is not frozen*/
+    lv_obj_set_style_text_opa(label, LV_OPA_60, 0);
+    assert_frozen_draws_the_same(label, 0);
+
+    lv_obj_set_style_text_decor(label, LV_TEXT_DECOR_NONE, 0);
+    assert_frozen_draws_the_same(label, 2);
+
+    lv_obj_set_style_text_opa(label, LV_OPA_COVER, 0);
+    lv_label_set_long_mode(label, LV_LABEL_LONG_DOT);
+    lv_obj_set_height(label, 60);
+    assert_frozen_draws_the_same(label, 0);
+}
+
+void test_label_frozen_follows_the_changes(void)
+{
+    lv_obj_t * label = create_label("Connecting to WiFi...");
+    lv_label_set_frozen(label, true);
+    TEST_ASSERT_TRUE(lv_label_get_frozen(label));
+    refr_screen();
+
+    lv_label_set_text(label, "Connecting to New WiFi...");
+    assert_frozen_draws_the_same(label, 0);
+
+    lv_obj_set_width(label, 250);
+    assert_frozen_draws_the_same(label, 0);
+
+    lv_obj_set_style_text_letter_space(label, 4, 0);
+    assert_frozen_draws_the_same(label, 0);
+
+    lv_obj_set_style_text_font(label, LV_FONT_DEFAULT, 0);
+    assert_frozen_draws_the_same(label, 0);
+
+    lv_label_set_text(label, "");
+    assert_frozen_draws_the_same(label, 0);
+
+    lv_label_set_frozen(label, false);
+    TEST_ASSERT_FALSE(lv_label_get_frozen(label));
+}
+
+#if LV_USE_RENDER_CACHE && LV_RENDER_CACHE_GLYPH_MIN_SIZE
+static uint32_t get_glyph_lookup_cnt(void)
+{
+    uint32_t cnt = 0;
+    lv_render_cache_tier_t tier;
+    for(tier = 0; tier < _LV_RENDER_CACHE_TIER_LAST; tier++) {
+        lv_render_cache_stat_t s;
+        lv_render_cache_get_stat(LV_RENDER_CACHE_CLASS_GLYPH, tier, &s);
+        cnt += s.hit_cnt + s.miss_cnt;
+    }
+    return cnt;
+}
+#endif
+
+/*The glyphs are looked up only when the text is rendered to the bitmap*/
+void test_label_frozen_renders_only_on_layout_change(void)
+{
+#if LV_USE_RENDER_CACHE && LV_RENDER_CACHE_GLYPH_MIN_SIZE
+    lv_obj_t * label = create_label("Connecting to WiFi...");
+    lv_label_set_frozen(label, true);
+    refr_screen();
+
+    uint32_t cnt = get_glyph_lookup_cnt();
+    refr_screen();
+    lv_obj_set_style_text_color(label, lv_palette_main(LV_PALETTE_BLUE), 0);
+    lv_obj_set_style_text_opa(label, LV_OPA_50, 0);
+    lv_obj_align(label, LV_ALIGN_TOP_MID, 0, 100);
+    lv_label_set_text(label, "Connecting to WiFi...");
+    refr_screen();
+    TEST_ASSERT_EQUAL_UINT32(cnt, get_glyph_lookup_cnt());
+
+    lv_label_set_text(label, "Connected");
+    refr_screen();
+    TEST_ASSERT_GREATER_THAN_UINT32(cnt, get_glyph_lookup_cnt());
+#endif
+}
+
+/*A screen similar to the loading screens of the firmware: a rotating arc around a wrapped text.
+ *`full_redraw` redraws the whole screen in each frame like the screen transitions do.*/
+static uint32_t bench_loader_frames(const char * txt, uint16_t arc_length, bool frozen, bool full_redraw,
+                                    uint32_t frame_cnt)
+{
+    lv_obj_clean(lv_scr_act());
+    lv_obj_set_style_bg_color(lv_scr_act(), lv_color_black(), 0);
+
+    lv_obj_t * arc = lv_arc_create(lv_scr_act());
+    lv_obj_set_size(arc, 466, 466);
+    lv_obj_center(arc);
+    lv_obj_remove_style(arc, NULL, LV_PART_KNOB);
+    lv_obj_set_style_arc_width(arc, 30, 0);
+    lv_obj_set_style_arc_width(arc, 30, LV_PART_INDICATOR);
+    lv_arc_set_bg_angles(arc, 0, arc_length);
+    lv_arc_set_angles(arc, 0, arc_length);
+
+    lv_obj_t * label = create_label(txt);
+    lv_obj_set_style_text_color(label, lv_color_white(), 0);
+    lv_obj_align(label, LV_ALIGN_CENTER, 0, -40);
+    lv_label_set_frozen(label, frozen);
+    refr_screen();
+
+    clock_t t = clock();
+    uint32_t i;
+    for(i = 0; i < frame_cnt; i++) {
+        uint16_t start = (i * 6) % 360;
+        lv_arc_set_bg_angles(arc, start, start + arc_length);
+        lv_arc_set_angles(arc, start, start + arc_length);
+        if(full_redraw) lv_obj_invalidate(lv_scr_act());
+        lv_refr_now(NULL);
+    }
+    return (uint32_t)((clock() - t) * 1000000 / CLOCKS_PER_SEC / frame_cnt);
+}
+
+/*Render the loading screens with and without frozen labels and print the time of a frame.
+ *The rounds are alternated and the fastest one is kept to filter out the noise of the host.*/
+void test_label_frozen_bench(void)
+{
+    static const struct {
+        const char * name;
+        const char * txt;
+        uint16_t arc_length;
+    } screens[] = {
+        {"Screen2", "Connecting to WiFi...", 180},
+        {"Screen11", "Connecting to New WiFi...", 180},
+        {"Screen3", "WiFi Connected", 90},
+    };
+
+    uint32_t i;
+    for(i = 0; i < sizeof(screens) / sizeof(screens[0]); i++) {
+        uint32_t t[4] = {UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX};
+        uint32_t round;
+        for(round = 0; round < 5; round++) {
+            uint32_t v;
+            for(v = 0; v < 4; v++) {
+                bool frozen = v & 1;
+                bool full_redraw = v & 2;
+                t[v] = LV_MIN(t[v], bench_loader_frames(screens[i].txt, screens[i].arc_length, frozen, full_redraw, 30));
+            }
+        }
+        printf("%s us/frame: loader %lu normal, %lu frozen; full redraw %lu normal, %lu frozen\n",
+               screens[i].name, (unsigned long)t[0], (unsigned long)t[1], (unsigned long)t[2], (unsigned long)t[3]);
+    }
+
+    lv_obj_set_style_bg_color(lv_scr_act(), lv_color_white(), 0);
+}
+
+#endif
+
+#endif
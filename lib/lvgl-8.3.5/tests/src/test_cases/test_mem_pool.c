@@ -0,0 +1,232 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#if LV_MEM_CUSTOM != 0 && LV_MEM_CUSTOM_POOL
+
+#include "unity/unity.h"
+#include <stdio.h>
+
+/*Increase it to soak the allocator for a long time. The OPTIONS_TEST_MEM_POOL_SOAK set runs 5000.*/
+#ifndef MEM_POOL_SOAK_CYCLES
+    #define MEM_POOL_SOAK_CYCLES    200
+#endif
+
+/*Let ASan reuse the freed chunks at once to place a new chunk below the others*/
+const char * __asan_default_options(void);
+const char * __asan_default_options(void)
+{
+    return "quarantine_size_mb=0:thread_local_quarantine_size_kb=0";
+}
+
+void setUp(void)
+{
+    lv_mem_pool_trim();
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+}
+
+static uint32_t get_used_cnt(void)
+{
+    lv_mem_pool_monitor_t mon;
+    lv_mem_pool_monitor(&mon);
+
+    uint32_t used = 0;
+    uint32_t i;
+    for(i = 0; i < LV_MEM_POOL_CLASS_CNT; i++) used += mon.cls[i].used_cnt;
+    return used;
+}
+
+void test_mem_pool_alloc_free(void)
+{
+    uint32_t used_start = get_used_cnt();
+
+    void * p[100];
+    uint32_t i;
+    for(i = 0; i < 100; i++) {
+        p[i] = lv_mem_alloc(1 + i);
+        TEST_ASSERT_NOT_NULL(p[i]);
+        TEST_ASSERT_EQUAL(0, (lv_uintptr_t)p[i] & 0x3);
+        lv_memset(p[i], i, 1 + i);
+    }
+
+    /*1..128 bytes are in the size classes, the others are allocated directly*/
+    TEST_ASSERT_EQUAL_UINT32(used_start + 100, get_used_cnt());
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_mem_test());
+
+    for(i = 0; i < 100; i++) {
+        TEST_ASSERT_EACH_EQUAL_UINT8(i, p[i], 1 + i);
+        lv_mem_free(p[i]);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(used_start, get_used_cnt());
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_mem_test());
+
+    void * large = lv_mem_alloc(1000);
+    TEST_ASSERT_EQUAL_UINT32(used_start, get_used_cnt());
+    lv_mem_free(large);
+}
+
+void test_mem_pool_realloc_keeps_data(void)
+{
+    uint8_t * p = lv_mem_alloc(10);
+    lv_memset(p, 0x5a, 10);
+
+    /*Fits into the same block*/
+    TEST_ASSERT_EQUAL_PTR(p, lv_mem_realloc(p, 16));
+
+    /*Moves to a larger class and then to the system heap*/
+    p = lv_mem_realloc(p, 100);
+    TEST_ASSERT_EACH_EQUAL_UINT8(0x5a, p, 10);
+    lv_memset(p, 0x3c, 100);
+    p = lv_mem_realloc(p, 3000);
+    TEST_ASSERT_EACH_EQUAL_UINT8(0x3c, p, 100);
+    p = lv_mem_realloc(p, 20);
+    TEST_ASSERT_EACH_EQUAL_UINT8(0x3c, p, 20);
+    lv_mem_free(p);
+
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_mem_test());
+}
+
+/*Allocate until the free blocks of a size class are used up. The blocks are linked to free them later.*/
+static void * use_up_class(uint32_t cls, size_t size)
+{
+    lv_mem_pool_monitor_t mon;
+    void * used = NULL;
+    while(1) {
+        lv_mem_pool_monitor(&mon);
+        if(mon.cls[cls].block_cnt > 0 && mon.cls[cls].used_cnt == mon.cls[cls].block_cnt) return used;
+        void ** block = lv_mem_alloc(size);
+        *block = used;
+        used = block;
+    }
+}
+
+static void free_used(void * used)
+{
+    while(used) {
+        void * next = *(void **)used;
+        lv_mem_free(used);
+        used = next;
+    }
+}
+
+void test_mem_pool_realloc_to_a_new_chunk(void)
+{
+    /*Add three chunks in this order: an empty one of the 48 byte class,
+     *one of the 96 byte class and the chunk of the block*/
+    void * used48 = use_up_class(2, 40);
+    void * used96 = use_up_class(4, 90);
+    void * used16 = use_up_class(0, 10);
+    void * below = lv_mem_alloc(40);
+    void * between = lv_mem_alloc(90);
+    uint8_t * p = lv_mem_alloc(10);
+    lv_memset(p, 0x5a, 10);
+    lv_mem_free(below);
+    lv_mem_pool_trim();
+
+    /*The realloc adds a chunk to the 48 byte class in the place of the trimmed one,
+     *so the chunk of the block moves in the table of chunks*/
+    p = lv_mem_realloc(p, 40);
+
+    lv_mem_pool_monitor_t mon;
+    lv_mem_pool_monitor(&mon);
+    TEST_ASSERT_GREATER_THAN_UINT32(mon.cls[2].used_cnt, mon.cls[2].block_cnt);
+
+    TEST_ASSERT_EACH_EQUAL_UINT8(0x5a, p, 10);
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_mem_test());
+
+    lv_mem_free(p);
+    lv_mem_free(between);
+    free_used(used16);
+    free_used(used48);
+    free_used(used96);
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_mem_test());
+}
+
+void test_mem_pool_trim(void)
+{
+    void * p[200];
+    uint32_t i;
+    for(i = 0; i < 200; i++) p[i] = lv_mem_alloc(40);
+
+    lv_mem_pool_monitor_t mon1;
+    lv_mem_pool_monitor(&mon1);
+
+    for(i = 0; i < 200; i++) lv_mem_free(p[i]);
+    lv_mem_pool_trim();
+
+    lv_mem_pool_monitor_t mon2;
+    lv_mem_pool_monitor(&mon2);
+    TEST_ASSERT_LESS_THAN_UINT32(mon1.chunk_cnt, mon2.chunk_cnt);
+    TEST_ASSERT_LESS_THAN_UINT32(mon1.cls[2].block_cnt, mon2.cls[2].block_cnt);
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_mem_test());
+}
+
+/*A screen similar to the ones of the firmware: a ring of ticks, a few labels and buttons*/
+static lv_obj_t * create_screen(uint32_t id)
+{
+    lv_obj_t * scr = lv_obj_create(NULL);
+
+    lv_obj_t * arc = lv_arc_create(scr);
+    lv_obj_set_size(arc, 300, 300);
+    lv_obj_center(arc);
+
+    static lv_point_t points[60][2];
+    uint32_t i;
+    for(i = 0; i < 60; i++) {
+        points[i][0].x = i;
+        points[i][0].y = 0;
+        points[i][1].x = i;
+        points[i][1].y = 10;
+        lv_obj_t * line = lv_line_create(scr);
+        lv_line_set_points(line, points[i], 2);
+        lv_obj_set_style_line_color(line, lv_palette_main(i % 2 ? LV_PALETTE_RED : LV_PALETTE_BLUE), 0);
+    }
+
+    for(i = 0; i < 4 + id % 3; i++) {
+        lv_obj_t * label = lv_label_create(scr);
+        lv_label_set_text_fmt(label, "Screen %d, label %d", (int)id, (int)i);
+
+        lv_obj_t * btn = lv_btn_create(scr);
+        lv_obj_set_style_bg_color(btn, lv_palette_main(LV_PALETTE_GREEN), 0);
+        lv_obj_add_flag(btn, LV_OBJ_FLAG_CHECKABLE);
+    }
+
+    return scr;
+}
+
+/*Cycle screens like a kiosk running for a long time. The pools must not grow after the first cycles.*/
+void test_mem_pool_soak_screens(void)
+{
+    uint32_t used_start = get_used_cnt();
+    lv_mem_pool_monitor_t mon;
+    uint32_t chunk_cnt = 0;
+
+    uint32_t cycle;
+    for(cycle = 0; cycle < MEM_POOL_SOAK_CYCLES; cycle++) {
+        lv_obj_t * scr = create_screen(cycle);
+        lv_obj_del(scr);
+
+        if(cycle == 10) {
+            lv_mem_pool_monitor(&mon);
+            chunk_cnt = mon.chunk_cnt;
+        }
+    }
+
+    lv_mem_pool_monitor(&mon);
+    TEST_ASSERT_EQUAL_UINT32(chunk_cnt, mon.chunk_cnt);
+    TEST_ASSERT_EQUAL_UINT32(0, mon.fallback_cnt);
+    TEST_ASSERT_EQUAL_UINT32(used_start, get_used_cnt());
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_mem_test());
+
+    printf("mem pool after %lu screens: %lu chunks, %lu bytes, peak %lu bytes used\n",
+           (unsigned long)MEM_POOL_SOAK_CYCLES, (unsigned long)mon.chunk_cnt, (unsigned long)mon.total_size,
+           (unsigned long)mon.max_used_size);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,387 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#if LV_USE_RENDER_CACHE
+
+#include "unity/unity.h"
+#include <stdio.h>
+#include <time.h>
+
+#define CANVAS_W    120
+#define CANVAS_H    80
+
+static lv_color_t canvas_buf1[CANVAS_W * CANVAS_H];
+static lv_color_t canvas_buf2[CANVAS_W * CANVAS_H];
+
+static size_t def_budget[_LV_RENDER_CACHE_TIER_LAST];
+
+void setUp(void)
+{
+    def_budget[LV_RENDER_CACHE_TIER_INTERNAL] = lv_render_cache_get_budget(LV_RENDER_CACHE_TIER_INTERNAL);
+    def_budget[LV_RENDER_CACHE_TIER_LARGE] = lv_render_cache_get_budget(LV_RENDER_CACHE_TIER_LARGE);
+    lv_render_cache_clean();
+    lv_render_cache_reset_stat();
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+    lv_render_cache_set_budget(LV_RENDER_CACHE_TIER_INTERNAL, def_budget[LV_RENDER_CACHE_TIER_INTERNAL]);
+    lv_render_cache_set_budget(LV_RENDER_CACHE_TIER_LARGE, def_budget[LV_RENDER_CACHE_TIER_LARGE]);
+}
+
+static lv_render_cache_stat_t get_stat(lv_render_cache_class_t cls)
+{
+    lv_render_cache_stat_t sum;
+    lv_memset_00(&sum, sizeof(sum));
+    lv_render_cache_tier_t tier;
+    for(tier = 0; tier < _LV_RENDER_CACHE_TIER_LAST; tier++) {
+        lv_render_cache_stat_t s;
+        lv_render_cache_get_stat(cls, tier, &s);
+        sum.hit_cnt += s.hit_cnt;
+        sum.miss_cnt += s.miss_cnt;
+        sum.evict_cnt += s.evict_cnt;
+        sum.entry_cnt += s.entry_cnt;
+        sum.used_size += s.used_size;
+        sum.max_used_size += s.max_used_size;
+    }
+    return sum;
+}
+
+static void draw_rect_to(lv_color_t * buf)
+{
+    lv_obj_t * canvas = lv_canvas_create(lv_scr_act());
+    lv_canvas_set_buffer(canvas, buf, CANVAS_W, CANVAS_H, LV_IMG_CF_TRUE_COLOR);
+    lv_canvas_fill_bg(canvas, lv_color_white(), LV_OPA_COVER);
+
+    lv_draw_rect_dsc_t dsc;
+    lv_draw_rect_dsc_init(&dsc);
+    dsc.radius = 12;
+    dsc.bg_color = lv_palette_main(LV_PALETTE_RED);
+    dsc.bg_grad.dir = LV_GRAD_DIR_VER;
+    dsc.bg_grad.stops_count = 2;
+    dsc.bg_grad.stops[0].color = lv_palette_main(LV_PALETTE_RED);
+    dsc.bg_grad.stops[0].frac = 0;
+    dsc.bg_grad.stops[1].color = lv_palette_main(LV_PALETTE_BLUE);
+    dsc.bg_grad.stops[1].frac = 255;
+    dsc.shadow_width = 10;
+    dsc.shadow_spread = 2;
+    dsc.shadow_opa = LV_OPA_70;
+    dsc.shadow_color = lv_color_black();
+    lv_canvas_draw_rect(canvas, 20, 15, 80, 50, &dsc);
+
+    lv_obj_del(canvas);
+}
+
+void test_render_cache_hit_draws_the_same(void)
+{
+    draw_rect_to(canvas_buf1);
+
+    lv_render_cache_stat_t grad = get_stat(LV_RENDER_CACHE_CLASS_GRAD);
+    lv_render_cache_stat_t shadow = get_stat(LV_RENDER_CACHE_CLASS_SHADOW);
+    TEST_ASSERT_EQUAL_UINT32(0, grad.hit_cnt);
+    TEST_ASSERT_EQUAL_UINT32(1, grad.entry_cnt);
+    TEST_ASSERT_EQUAL_UINT32(0, shadow.hit_cnt);
+    TEST_ASSERT_EQUAL_UINT32(1, shadow.entry_cnt);
+
+    draw_rect_to(canvas_buf2);
+
+    grad = get_stat(LV_RENDER_CACHE_CLASS_GRAD);
+    shadow = get_stat(LV_RENDER_CACHE_CLASS_SHADOW);
+    TEST_ASSERT_EQUAL_UINT32(1, grad.hit_cnt);
+    TEST_ASSERT_EQUAL_UINT32(1, grad.entry_cnt);
+    TEST_ASSERT_EQUAL_UINT32(1, shadow.hit_cnt);
+    TEST_ASSERT_EQUAL_UINT32(1, shadow.entry_cnt);
+
+    TEST_ASSERT_EQUAL_MEMORY(canvas_buf1, canvas_buf2, sizeof(canvas_buf1));
+}
+
+void test_render_cache_evicts_in_budget(void)
+{
+    lv_render_cache_set_budget(LV_RENDER_CACHE_TIER_INTERNAL, 1024);
+
+    uint32_t i;
+    for(i = 0; i < 16; i++) {
+        uint8_t * data = lv_render_cache_add(LV_RENDER_CACHE_CLASS_IMG, &i, sizeof(i), 200);
+        TEST_ASSERT_NOT_NULL(data);
+        lv_memset(data, i, 200);
+
+        lv_render_cache_stat_t s;
+        lv_render_cache_get_stat(LV_RENDER_CACHE_CLASS_IMG, LV_RENDER_CACHE_TIER_INTERNAL, &s);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(1024, s.used_size);
+    }
+
+    lv_render_cache_stat_t s;
+    lv_render_cache_get_stat(LV_RENDER_CACHE_CLASS_IMG, LV_RENDER_CACHE_TIER_INTERNAL, &s);
+    TEST_ASSERT_EQUAL_UINT32(16 - s.entry_cnt, s.evict_cnt);
+
+    /*The most recent item is still there with its data, the oldest one was dropped*/
+    i = 15;
+    uint8_t * data = lv_render_cache_get(LV_RENDER_CACHE_CLASS_IMG, &i, sizeof(i), 200);
+    TEST_ASSERT_NOT_NULL(data);
+    TEST_ASSERT_EQUAL_UINT8(15, data[199]);
+    i = 0;
+    TEST_ASSERT_NULL(lv_render_cache_get(LV_RENDER_CACHE_CLASS_IMG, &i, sizeof(i), 200));
+
+    /*Same key in an other class is an other item*/
+    i = 15;
+    TEST_ASSERT_NULL(lv_render_cache_get(LV_RENDER_CACHE_CLASS_SHADOW, &i, sizeof(i), 200));
+
+    /*Too large for the budget*/
+    lv_render_cache_set_budget(LV_RENDER_CACHE_TIER_LARGE, 4096);
+    TEST_ASSERT_NULL(lv_render_cache_add(LV_RENDER_CACHE_CLASS_IMG, &i, sizeof(i), 8192));
+
+    /*Cleaning doesn't count as eviction*/
+    lv_render_cache_get_stat(LV_RENDER_CACHE_CLASS_IMG, LV_RENDER_CACHE_TIER_INTERNAL, &s);
+    uint32_t evict_cnt = s.evict_cnt;
+    lv_render_cache_clean();
+    lv_render_cache_get_stat(LV_RENDER_CACHE_CLASS_IMG, LV_RENDER_CACHE_TIER_INTERNAL, &s);
+    TEST_ASSERT_EQUAL_UINT32(evict_cnt, s.evict_cnt);
+    TEST_ASSERT_EQUAL_UINT32(0, s.entry_cnt);
+    TEST_ASSERT_EQUAL_UINT32(0, s.used_size);
+}
+
+/*The budgets are reserved by `lv_init()` so the heap doesn't move with what is drawn*/
+void test_render_cache_draws_without_allocating(void)
+{
+#if LV_MEM_CUSTOM == 0  /*Only the built-in heap can be monitored*/
+    /*Create the canvas' object once to let the object allocations settle*/
+    draw_rect_to(canvas_buf1);
+    lv_render_cache_clean();
+
+    lv_mem_monitor_t m1;
+    lv_mem_monitor(&m1);
+
+    /*The items are stored in the memory reserved for the budgets*/
+    draw_rect_to(canvas_buf1);
+    lv_render_cache_stat_t grad = get_stat(LV_RENDER_CACHE_CLASS_GRAD);
+    lv_render_cache_stat_t shadow = get_stat(LV_RENDER_CACHE_CLASS_SHADOW);
+    TEST_ASSERT_EQUAL_UINT32(1, grad.entry_cnt);
+    TEST_ASSERT_EQUAL_UINT32(1, shadow.entry_cnt);
+
+    lv_mem_monitor_t m2;
+    lv_mem_monitor(&m2);
+    TEST_ASSERT_EQUAL_UINT32(m1.free_size, m2.free_size);
+
+    /*Changing the budget moves the reserved memory*/
+    lv_render_cache_set_budget(LV_RENDER_CACHE_TIER_INTERNAL, def_budget[LV_RENDER_CACHE_TIER_INTERNAL] + 1024);
+    lv_mem_monitor(&m2);
+    TEST_ASSERT_UINT32_WITHIN(32, m1.free_size - 1024, m2.free_size);
+#endif
+}
+
+void test_render_cache_should_not_leak_memory(void)
+{
+    lv_mem_monitor_t m1;
+    lv_mem_monitor(&m1);
+
+    uint32_t i;
+    for(i = 0; i < 100; i++) {
+        lv_render_cache_add(LV_RENDER_CACHE_CLASS_IMG, &i, sizeof(i), 100 + i * 100);
+    }
+    lv_render_cache_clean();
+
+    lv_mem_monitor_t m2;
+    lv_mem_monitor(&m2);
+    TEST_ASSERT_UINT32_WITHIN(32, m1.free_size, m2.free_size);
+}
+
+#if LV_RENDER_CACHE_GLYPH_MIN_SIZE
+static void draw_text_to(lv_color_t * buf, lv_opa_t opa)
+{
+    lv_obj_t * canvas = lv_canvas_create(lv_scr_act());
+    lv_canvas_set_buffer(canvas, buf, CANVAS_W, CANVAS_H, LV_IMG_CF_TRUE_COLOR);
+    lv_canvas_fill_bg(canvas, lv_color_white(), LV_OPA_COVER);
+
+    lv_draw_label_dsc_t dsc;
+    lv_draw_label_dsc_init(&dsc);
+    dsc.color = lv_palette_main(LV_PALETTE_BLUE);
+    dsc.opa = opa;
+    lv_canvas_draw_text(canvas, 3, 5, CANVAS_W - 6, &dsc, "Connecting to WiFi...\nAV To Wa 0123");
+
+    lv_obj_del(canvas);
+}
+#endif
+
+void test_render_cache_glyphs_draw_the_same(void)
+{
+#if LV_RENDER_CACHE_GLYPH_MIN_SIZE
+    /*Without glyph cache*/
+    lv_render_cache_set_budget(LV_RENDER_CACHE_TIER_LARGE, 0);
+    draw_text_to(canvas_buf1, LV_OPA_COVER);
+    lv_render_cache_set_budget(LV_RENDER_CACHE_TIER_LARGE, def_budget[LV_RENDER_CACHE_TIER_LARGE]);
+    lv_render_cache_reset_stat();
+
+    /*Fill the cache*/
+    draw_text_to(canvas_buf2, LV_OPA_COVER);
+    TEST_ASSERT_EQUAL_MEMORY(canvas_buf1, canvas_buf2, sizeof(canvas_buf1));
+    lv_render_cache_stat_t glyph1 = get_stat(LV_RENDER_CACHE_CLASS_GLYPH);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, glyph1.entry_cnt);
+
+    /*Draw from the cache*/
+    draw_text_to(canvas_buf2, LV_OPA_COVER);
+    TEST_ASSERT_EQUAL_MEMORY(canvas_buf1, canvas_buf2, sizeof(canvas_buf1));
+    lv_render_cache_stat_t glyph2 = get_stat(LV_RENDER_CACHE_CLASS_GLYPH);
+    TEST_ASSERT_EQUAL_UINT32(glyph1.miss_cnt, glyph2.miss_cnt);
+    TEST_ASSERT_GREATER_THAN_UINT32(glyph1.hit_cnt, glyph2.hit_cnt);
+
+    /*The opacity is applied on the cached coverage too*/
+    lv_render_cache_set_budget(LV_RENDER_CACHE_TIER_LARGE, 0);
+    draw_text_to(canvas_buf1, LV_OPA_60);
+    lv_render_cache_set_budget(LV_RENDER_CACHE_TIER_LARGE, def_budget[LV_RENDER_CACHE_TIER_LARGE]);
+    draw_text_to(canvas_buf2, LV_OPA_60);
+    draw_text_to(canvas_buf2, LV_OPA_60);
+    TEST_ASSERT_EQUAL_MEMORY(canvas_buf1, canvas_buf2, sizeof(canvas_buf1));
+#endif
+}
+
+#if LV_RENDER_CACHE_GLYPH_MIN_SIZE && LV_FONT_MONTSERRAT_48
+#define BENCH_FRAMES    50
+#define BENCH_ROUNDS    10
+
+static void create_text_screen(bool with_text)
+{
+    lv_obj_clean(lv_scr_act());
+    if(!with_text) return;
+
+    uint32_t i;
+    for(i = 0; i < 6; i++) {
+        lv_obj_t * label = lv_label_create(lv_scr_act());
+        lv_obj_set_style_text_font(label, &lv_font_montserrat_48, 0);
+        lv_label_set_text(label, i % 2 ? "Almost done, wait" : "Connecting to WiFi...");
+        lv_obj_align(label, LV_ALIGN_TOP_MID, 0, 10 + i * 75);
+    }
+}
+
+/*Time of `BENCH_FRAMES` full screen refreshes in microseconds*/
+static uint32_t bench_frames(size_t large_budget)
+{
+    lv_render_cache_set_budget(LV_RENDER_CACHE_TIER_LARGE, large_budget);
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);      /*Fill the cache*/
+    lv_render_cache_reset_stat();
+
+    clock_t t = clock();
+    uint32_t i;
+    for(i = 0; i < BENCH_FRAMES; i++) {
+        lv_obj_invalidate(lv_scr_act());
+        lv_refr_now(NULL);
+    }
+    return (uint32_t)((uint64_t)(clock() - t) * 1000000 / CLOCKS_PER_SEC);
+}
+#endif
+
+/*Render text-only frames with and without the glyph cache and print the time spent on the text.
+ *The rounds are alternated and the fastest one is kept to filter out the noise of the host.*/
+void test_render_cache_glyph_bench(void)
+{
+#if LV_RENDER_CACHE_GLYPH_MIN_SIZE && LV_FONT_MONTSERRAT_48
+    size_t large_budget = def_budget[LV_RENDER_CACHE_TIER_LARGE];
+    uint32_t t_empty = UINT32_MAX;
+    uint32_t t_off = UINT32_MAX;
+    uint32_t t_on = UINT32_MAX;
+    uint32_t round;
+    for(round = 0; round < BENCH_ROUNDS; round++) {
+        create_text_screen(false);
+        t_empty = LV_MIN(t_empty, bench_frames(large_budget));
+        create_text_screen(true);
+        t_off = LV_MIN(t_off, bench_frames(0));
+        t_on = LV_MIN(t_on, bench_frames(large_budget));
+    }
+
+    lv_render_cache_stat_t glyph = get_stat(LV_RENDER_CACHE_CLASS_GLYPH);
+    printf("%d frames of text: %lu us without, %lu us with glyph cache (%lu hits, %lu misses, %lu bytes),"
+           " %lu us without text\n", BENCH_FRAMES,
+           (unsigned long)(t_off - t_empty), (unsigned long)(t_on - t_empty), (unsigned long)glyph.hit_cnt,
+           (unsigned long)glyph.miss_cnt, (unsigned long)glyph.used_size, (unsigned long)t_empty);
+    TEST_ASSERT_EQUAL_UINT32(0, glyph.miss_cnt);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, glyph.hit_cnt);
+#endif
+}
+
+/*Screens similar to the ones of the firmware: buttons, cards and a list with shadows and gradients*/
+static void create_screen(uint32_t id)
+{
+    lv_obj_clean(lv_scr_act());
+
+    uint32_t i;
+    for(i = 0; i < 6; i++) {
+        lv_obj_t * obj = id == 0 ? lv_btn_create(lv_scr_act()) : lv_obj_create(lv_scr_act());
+        lv_obj_set_size(obj, 100 + id * 40, 60 + (i % 3) * 20);
+        lv_obj_set_pos(obj, 20 + (i % 3) * 250, 20 + (i / 3) * 200);
+        lv_obj_set_style_radius(obj, 8 + id * 8, 0);
+        lv_obj_set_style_shadow_width(obj, 10 + id * 10, 0);
+        if(id != 1) {
+            lv_obj_set_style_bg_grad_color(obj, lv_palette_main(LV_PALETTE_BLUE), 0);
+            lv_obj_set_style_bg_grad_dir(obj, i % 2 ? LV_GRAD_DIR_VER : LV_GRAD_DIR_HOR, 0);
+        }
+    }
+}
+
+static uint32_t get_tier_used(lv_render_cache_tier_t tier)
+{
+    uint32_t used = 0;
+    lv_render_cache_class_t cls;
+    for(cls = 0; cls < _LV_RENDER_CACHE_CLASS_LAST; cls++) {
+        lv_render_cache_stat_t s;
+        lv_render_cache_get_stat(cls, tier, &s);
+        used += s.used_size;
+    }
+    return used;
+}
+
+static void replay(size_t internal_size, size_t large_size)
+{
+    lv_render_cache_set_budget(LV_RENDER_CACHE_TIER_INTERNAL, internal_size);
+    lv_render_cache_set_budget(LV_RENDER_CACHE_TIER_LARGE, large_size);
+    lv_render_cache_reset_stat();
+
+    uint32_t max_internal = 0;
+    uint32_t max_large = 0;
+    uint32_t round;
+    for(round = 0; round < 4; round++) {
+        uint32_t id;
+        for(id = 0; id < 3; id++) {
+            create_screen(id);
+            lv_refr_now(NULL);
+
+            uint32_t used_internal = get_tier_used(LV_RENDER_CACHE_TIER_INTERNAL);
+            uint32_t used_large = get_tier_used(LV_RENDER_CACHE_TIER_LARGE);
+            TEST_ASSERT_LESS_OR_EQUAL_UINT32(internal_size, used_internal);
+            TEST_ASSERT_LESS_OR_EQUAL_UINT32(large_size, used_large);
+            max_internal = LV_MAX(max_internal, used_internal);
+            max_large = LV_MAX(max_large, used_large);
+        }
+    }
+
+    uint32_t hit = 0;
+    uint32_t miss = 0;
+    lv_render_cache_class_t cls;
+    for(cls = 0; cls < _LV_RENDER_CACHE_CLASS_LAST; cls++) {
+        lv_render_cache_stat_t s = get_stat(cls);
+        hit += s.hit_cnt;
+        miss += s.miss_cnt;
+    }
+
+    printf("render cache %6lu + %6lu bytes: %4lu hits, %4lu misses, max. used %6lu + %6lu bytes\n",
+           (unsigned long)internal_size, (unsigned long)large_size, (unsigned long)hit, (unsigned long)miss,
+           (unsigned long)max_internal, (unsigned long)max_large);
+}
+
+/*Replay the screens with different budgets. The budgets of the firmware are taken from
+ *tools/render_cache/render_cache_replay.cpp which replays its real screens.*/
+void test_render_cache_replay_screens(void)
+{
+    replay(0, 0);
+    replay(2 * 1024, 8 * 1024);
+    replay(4 * 1024, 32 * 1024);
+    replay(8 * 1024, 64 * 1024);
+
+    /*With enough memory everything is drawn from the cache after the first round*/
+    lv_render_cache_stat_t s = get_stat(LV_RENDER_CACHE_CLASS_SHADOW);
+    TEST_ASSERT_GREATER_THAN_UINT32(s.miss_cnt, s.hit_cnt);
+}
+
+#endif
+
+#endif
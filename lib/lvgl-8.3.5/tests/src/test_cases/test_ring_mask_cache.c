@@ -0,0 +1,266 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+#include "../src/misc/lv_gc.h"
+
+#if LV_USE_CANVAS && LV_DRAW_COMPLEX && LV_RING_MASK_CACHE_SIZE
+
+#include "unity/unity.h"
+
+#define CANVAS_SIZE 120
+
+static lv_color_t buf_arc[CANVAS_SIZE * CANVAS_SIZE];
+static lv_color_t buf_ref[CANVAS_SIZE * CANVAS_SIZE];
+static lv_obj_t * canvas_arc;
+static lv_obj_t * canvas_ref;
+
+void setUp(void)
+{
+    canvas_arc = lv_canvas_create(lv_scr_act());
+    lv_canvas_set_buffer(canvas_arc, buf_arc, CANVAS_SIZE, CANVAS_SIZE, LV_IMG_CF_TRUE_COLOR);
+    canvas_ref = lv_canvas_create(lv_scr_act());
+    lv_canvas_set_buffer(canvas_ref, buf_ref, CANVAS_SIZE, CANVAS_SIZE, LV_IMG_CF_TRUE_COLOR);
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+}
+
+typedef struct {
+    lv_draw_mask_radius_param_t in_param;
+    lv_draw_mask_radius_param_t out_param;
+    int16_t in_id;
+    int16_t out_id;
+} ref_masks_t;
+
+/*Add the radius masks `lv_draw_sw_arc` used for a full ring without the ring mask cache*/
+static void ref_masks_add(ref_masks_t * m, const lv_area_t * area_out, lv_coord_t width)
+{
+    lv_area_t area_in;
+    lv_area_copy(&area_in, area_out);
+    area_in.x1 += width;
+    area_in.y1 += width;
+    area_in.x2 -= width;
+    area_in.y2 -= width;
+
+    m->in_id = LV_MASK_ID_INV;
+    if(lv_area_get_width(&area_in) > 0 && lv_area_get_height(&area_in) > 0) {
+        lv_draw_mask_radius_init(&m->in_param, &area_in, LV_RADIUS_CIRCLE, true);
+        m->in_id = lv_draw_mask_add(&m->in_param, NULL);
+    }
+
+    lv_draw_mask_radius_init(&m->out_param, area_out, LV_RADIUS_CIRCLE, false);
+    m->out_id = lv_draw_mask_add(&m->out_param, NULL);
+}
+
+static void ref_masks_remove(ref_masks_t * m)
+{
+    lv_draw_mask_remove_id(m->out_id);
+    if(m->in_id != LV_MASK_ID_INV) lv_draw_mask_remove_id(m->in_id);
+    lv_draw_mask_free_param(&m->out_param);
+    if(m->in_id != LV_MASK_ID_INV) lv_draw_mask_free_param(&m->in_param);
+}
+
+/*Draw a full ring with the built-in radius masks as `lv_draw_sw_arc` did without the ring mask cache*/
+static void draw_ref_ring(lv_coord_t radius, lv_coord_t width, lv_color_t color, lv_opa_t opa)
+{
+    lv_area_t area_out;
+    area_out.x1 = CANVAS_SIZE / 2 - radius;
+    area_out.y1 = CANVAS_SIZE / 2 - radius;
+    area_out.x2 = CANVAS_SIZE / 2 + radius - 1;
+    area_out.y2 = CANVAS_SIZE / 2 + radius - 1;
+
+    ref_masks_t masks;
+    ref_masks_add(&masks, &area_out, width);
+
+    lv_draw_rect_dsc_t rect_dsc;
+    lv_draw_rect_dsc_init(&rect_dsc);
+    rect_dsc.bg_color = color;
+    rect_dsc.bg_opa = opa;
+    rect_dsc.radius = LV_RADIUS_CIRCLE;
+    lv_canvas_draw_rect(canvas_ref, area_out.x1, area_out.y1, radius * 2, radius * 2, &rect_dsc);
+
+    ref_masks_remove(&masks);
+}
+
+static void full_rings_match_radius_masks(lv_opa_t opa)
+{
+    static const lv_coord_t radii[] = {1, 2, 5, 17, 40, 59};
+    static const lv_coord_t widths[] = {1, 2, 3, 12, 30, 100};
+    uint32_t i;
+    uint32_t j;
+
+    for(i = 0; i < sizeof(radii) / sizeof(radii[0]); i++) {
+        for(j = 0; j < sizeof(widths) / sizeof(widths[0]); j++) {
+            lv_color_t color = lv_palette_main((lv_palette_t)((i * 7 + j) % _LV_PALETTE_LAST));
+            lv_canvas_fill_bg(canvas_arc, lv_color_black(), LV_OPA_COVER);
+            lv_canvas_fill_bg(canvas_ref, lv_color_black(), LV_OPA_COVER);
+
+            lv_draw_arc_dsc_t arc_dsc;
+            lv_draw_arc_dsc_init(&arc_dsc);
+            arc_dsc.color = color;
+            arc_dsc.width = widths[j];
+            arc_dsc.opa = opa;
+            /*Draw it twice to render from the cache too*/
+            lv_canvas_draw_arc(canvas_arc, CANVAS_SIZE / 2, CANVAS_SIZE / 2, radii[i], 0, 360, &arc_dsc);
+            lv_canvas_draw_arc(canvas_arc, CANVAS_SIZE / 2, CANVAS_SIZE / 2, radii[i], 0, 360, &arc_dsc);
+
+            draw_ref_ring(radii[i], LV_MIN(widths[j], radii[i]), color, opa);
+            draw_ref_ring(radii[i], LV_MIN(widths[j], radii[i]), color, opa);
+
+            TEST_ASSERT_EQUAL_MEMORY(buf_ref, buf_arc, sizeof(buf_arc));
+        }
+    }
+}
+
+void test_ring_mask_cache_full_ring_matches_radius_masks(void)
+{
+    full_rings_match_radius_masks(LV_OPA_COVER);
+}
+
+void test_ring_mask_cache_translucent_ring_matches_radius_masks(void)
+{
+    full_rings_match_radius_masks(LV_OPA_50);
+}
+
+/*Draw an arc with the built-in radius masks and the angle mask as `lv_draw_sw_arc` did without the ring mask cache*/
+static void draw_ref_arc(lv_coord_t radius, lv_coord_t width, uint16_t start_angle, uint16_t end_angle,
+                         lv_color_t color)
+{
+    lv_area_t area_out;
+    area_out.x1 = CANVAS_SIZE / 2 - radius;
+    area_out.y1 = CANVAS_SIZE / 2 - radius;
+    area_out.x2 = CANVAS_SIZE / 2 + radius - 1;
+    area_out.y2 = CANVAS_SIZE / 2 + radius - 1;
+
+    ref_masks_t masks;
+    ref_masks_add(&masks, &area_out, width);
+
+    /*The canvas draws to a display whose origin is the canvas, so the center is in canvas coordinates*/
+    lv_draw_mask_angle_param_t angle_param;
+    lv_draw_mask_angle_init(&angle_param, CANVAS_SIZE / 2, CANVAS_SIZE / 2, start_angle, end_angle);
+    int16_t angle_id = lv_draw_mask_add(&angle_param, NULL);
+
+    lv_draw_rect_dsc_t rect_dsc;
+    lv_draw_rect_dsc_init(&rect_dsc);
+    rect_dsc.bg_color = color;
+    lv_canvas_draw_rect(canvas_ref, area_out.x1, area_out.y1, radius * 2, radius * 2, &rect_dsc);
+
+    lv_draw_mask_remove_id(angle_id);
+    lv_draw_mask_free_param(&angle_param);
+    ref_masks_remove(&masks);
+}
+
+/*The angle mask is applied on the spans of the ring.
+ *Large arcs with a gap > 60 deg are drawn in quarters clipped to estimated areas, so only arcs drawn in one go
+ *are compared: small radius or small gap. The quarters only narrow the clip area of the same drawing.*/
+void test_ring_mask_cache_arc_matches_radius_masks(void)
+{
+    static const uint16_t angles[][2] = {{0, 90}, {200, 350}, {0, 330}, {100, 60}, {300, 250}, {45, 30}};
+    static const lv_coord_t radii[] = {5, 9, 40, 59};
+    static const lv_coord_t widths[] = {3, 12, 100};
+    uint32_t a;
+    uint32_t i;
+    uint32_t j;
+
+    for(a = 0; a < sizeof(angles) / sizeof(angles[0]); a++) {
+        for(i = 0; i < sizeof(radii) / sizeof(radii[0]); i++) {
+            for(j = 0; j < sizeof(widths) / sizeof(widths[0]); j++) {
+                uint16_t gap = angles[a][1] > angles[a][0] ? 360 - (angles[a][1] - angles[a][0]) :
+                               angles[a][0] - angles[a][1];
+                if(radii[i] > 10 && gap > 60) continue;
+
+                lv_color_t color = lv_palette_main((lv_palette_t)((a * 5 + i * 7 + j) % _LV_PALETTE_LAST));
+                lv_canvas_fill_bg(canvas_arc, lv_color_black(), LV_OPA_COVER);
+                lv_canvas_fill_bg(canvas_ref, lv_color_black(), LV_OPA_COVER);
+
+                lv_draw_arc_dsc_t arc_dsc;
+                lv_draw_arc_dsc_init(&arc_dsc);
+                arc_dsc.color = color;
+                arc_dsc.width = widths[j];
+                lv_canvas_draw_arc(canvas_arc, CANVAS_SIZE / 2, CANVAS_SIZE / 2, radii[i], angles[a][0], angles[a][1],
+                                   &arc_dsc);
+
+                draw_ref_arc(radii[i], LV_MIN(widths[j], radii[i]), angles[a][0], angles[a][1], color);
+
+                TEST_ASSERT_EQUAL_MEMORY(buf_ref, buf_arc, sizeof(buf_arc));
+            }
+        }
+    }
+}
+
+static void draw_many_rings(void)
+{
+    lv_draw_arc_dsc_t arc_dsc;
+    lv_draw_arc_dsc_init(&arc_dsc);
+    arc_dsc.width = 10;
+
+    /*Draw more different rings than the cache can hold to test the eviction too*/
+    uint32_t i;
+    for(i = 0; i < LV_RING_MASK_CACHE_SIZE * 3; i++) {
+        lv_canvas_draw_arc(canvas_arc, CANVAS_SIZE / 2, CANVAS_SIZE / 2, 30 + i, 45, 300, &arc_dsc);
+    }
+}
+
+void test_ring_mask_cache_should_not_leak_memory(void)
+{
+    lv_mem_monitor_t monitor;
+
+    /*Fill the cache first so the cache entries are not counted as a leak*/
+    draw_many_rings();
+    lv_mem_monitor(&monitor);
+    uint32_t initial_available_memory = monitor.free_size;
+
+    draw_many_rings();
+    lv_mem_monitor(&monitor);
+    TEST_ASSERT_EQUAL(initial_available_memory, monitor.free_size);
+}
+
+#define FRAME_SIZE 466  /*The rings of the firmware have the size of the display*/
+
+/*Draw a full ring in the object's draw event*/
+static void frame_draw_cb(lv_event_t * e)
+{
+    lv_obj_t * obj = lv_event_get_target(e);
+    lv_draw_ctx_t * draw_ctx = lv_event_get_draw_ctx(e);
+
+    lv_point_t center;
+    center.x = obj->coords.x1 + FRAME_SIZE / 2;
+    center.y = obj->coords.y1 + FRAME_SIZE / 2;
+
+    lv_draw_arc_dsc_t arc_dsc;
+    lv_draw_arc_dsc_init(&arc_dsc);
+    arc_dsc.color = lv_color_white();
+    arc_dsc.width = 20;
+    lv_draw_arc(draw_ctx, &arc_dsc, &center, 150, 0, 360);
+}
+
+static bool ring_is_cached(lv_coord_t radius, lv_coord_t width)
+{
+    uint32_t i;
+    for(i = 0; i < LV_RING_MASK_CACHE_SIZE; i++) {
+        _lv_draw_mask_ring_dsc_t * c = &LV_GC_ROOT(_lv_ring_mask_cache[i]);
+        if(c->rows && c->radius == radius && c->width == width) return true;
+    }
+    return false;
+}
+
+/*An arc is usually drawn once in a frame, so its table is useful only if it's kept for the next frames*/
+void test_ring_mask_cache_is_kept_between_frames(void)
+{
+    lv_obj_t * obj = lv_obj_create(lv_scr_act());
+    lv_obj_remove_style_all(obj);
+    lv_obj_set_size(obj, FRAME_SIZE, FRAME_SIZE);
+    lv_obj_add_event_cb(obj, frame_draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+
+    lv_refr_now(NULL);
+    TEST_ASSERT_TRUE(ring_is_cached(150, 20));
+
+    lv_obj_invalidate(obj);
+    lv_refr_now(NULL);
+    TEST_ASSERT_TRUE(ring_is_cached(150, 20));
+}
+
+#endif
+
+#endif
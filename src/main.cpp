@@ -18,6 +18,28 @@
 // Main UI controller (includes all screens)
 #include "main.h"
 
+// One pass of loop(), also run by the host harness
+#include "AppLoop.h"
+
+// Skip unchanged tiles when flushing
+#include "utils/FrameDiff.h"
+
+// Serial byte to flushed pixels trace points (-DLATENCY_TRACE_ENABLED=1, "TRACE" dumps)
+#include "utils/LatencyTrace.h"
+
+// Battery level and charge state from the ADC divider into AppState
+#include "state/PowerMonitor.h"
+
+// Print the shown battery level periodically (0: disabled, Serial carries the protocol replies)
+#ifndef POWER_LOG_INTERVAL_MS
+#define POWER_LOG_INTERVAL_MS 0
+#endif
+
+// Print the heap and LVGL pool statistics periodically (0: disabled)
+#ifndef MEM_LOG_INTERVAL_MS
+#define MEM_LOG_INTERVAL_MS 0
+#endif
+
 // Display
 Arduino_DataBus *bus = new Arduino_ESP32QSPI(
     LCD_CS, LCD_SCLK, LCD_SDIO0, LCD_SDIO1, LCD_SDIO2, LCD_SDIO3);
@@ -41,16 +63,29 @@ bool IIC_Interrupt_Flag = false;
 // Application managers
 AppState* appState;
 SerialManager* serialManager;
+PowerMonitor* powerMonitor;
 
 // LVGL callbacks
 void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p)
 {
+    bool last = lv_disp_flush_is_last(disp);
+    if (last) latency_trace_rendered();
+#if FRAME_DIFF_ENABLED
+    frame_diff_flush(area, color_p);
+#else
     uint32_t w = (area->x2 - area->x1 + 1);
     uint32_t h = (area->y2 - area->y1 + 1);
     gfx->draw16bitRGBBitmap(area->x1, area->y1, (uint16_t *)&color_p->full, w, h);
+#endif
+    if (last) latency_trace_flushed();
     lv_disp_flush_ready(disp);
 }
 
+void my_frame_diff_send(int32_t x, int32_t y, uint32_t w, uint32_t h, uint16_t *pixels)
+{
+    gfx->draw16bitRGBBitmap(x, y, pixels, w, h);
+}
+
 void my_touchpad_read(lv_indev_drv_t *indev_driver, lv_indev_data_t *data)
 {
     static bool was_pressed = false;
@@ -98,6 +133,17 @@ void my_rounder_cb(lv_disp_drv_t *disp_drv, lv_area_t *area)
         area->y2 -= 1;
 }
 
+#if LATENCY_TRACE_ENABLED
+// Rounder chosen in lvgl_init(), wrapped to see every invalidation
+static void (*base_rounder_cb)(lv_disp_drv_t *, lv_area_t *) = my_rounder_cb;
+
+void traced_rounder_cb(lv_disp_drv_t *disp_drv, lv_area_t *area)
+{
+    base_rounder_cb(disp_drv, area);
+    latency_trace_invalidated(area->x1, area->y1, area->x2, area->y2);
+}
+#endif
+
 void Touch_Interrupt()
 {
     IIC_Interrupt_Flag = true;
@@ -123,6 +169,17 @@ void lvgl_init()
     disp_drv.ver_res = LCD_HEIGHT;
     disp_drv.flush_cb = my_disp_flush;
     disp_drv.rounder_cb = my_rounder_cb;
+#if FRAME_DIFF_ENABLED
+    // Tile aligned areas (32x8) also satisfy the even alignment of my_rounder_cb
+    if (!frame_diff_init(LCD_WIDTH, LCD_HEIGHT, my_frame_diff_send, true)) {
+        Serial.println("Frame diff allocation failed, see the unhashed/unverified counters");
+    }
+    disp_drv.rounder_cb = frame_diff_rounder;
+#endif
+#if LATENCY_TRACE_ENABLED
+    base_rounder_cb = disp_drv.rounder_cb;
+    disp_drv.rounder_cb = traced_rounder_cb;
+#endif
     disp_drv.draw_buf = &draw_buf;
     disp_drv.full_refresh = 0;
     lv_disp_drv_register(&disp_drv);
@@ -166,7 +223,15 @@ void setup()
     serialManager = new SerialManager();
     serialManager->begin(115200);
     
-    // Initialize UI (creates all screens)
+    // Battery widgets subscribe with setPowerChangeCallback, called only when the shown level changes
+    powerMonitor = new PowerMonitor();
+    powerMonitor->begin(power_read_adc);
+    
+    // Background jobs run between frames, timed by the microsecond clock
+    idle_sched_init([]() -> uint32_t { return micros(); });
+    latency_trace_init([]() -> uint32_t { return micros(); });
+    
+    // Initialize UI (creates the first screen, the others in the idle time)
     init_ui();
     
     // Connect AppState screen change callback to use smooth transitions
@@ -187,28 +252,65 @@ void setup()
 
 void loop()
 {
-    // Update LVGL (high frequency for smooth animations)
-    lv_timer_handler();
+    // LVGL, serial, battery, screen updates and the idle jobs (shared with the host harness)
+    app_loop_step(appState, serialManager, powerMonitor);
     
-    // Update serial communication (handles {"screen": N} commands and nose tracking "X:###,Y:###")
-    serialManager->update();
-    
-    // Update Screen 7 target position if on Screen 7
-    if (appState->getCurrentScreen() == SCREEN_7) {
-        screen7_update_position();  // Declared in Screen7.h
+#if FRAME_DIFF_ENABLED && FRAME_DIFF_LOG_INTERVAL_MS
+    static uint32_t lastFrameDiffLog = 0;
+    if (millis() - lastFrameDiffLog >= FRAME_DIFF_LOG_INTERVAL_MS) {
+        lastFrameDiffLog = millis();
+        frame_diff_stats_t stats = frame_diff_get_stats();
+        Serial.printf("Frame diff: %lu/%lu tiles skipped, %lu KB sent, %lu KB skipped, %lu windows, %lu collisions, "
+                      "%lu unhashed, %lu unverified\n",
+                      (unsigned long)stats.tiles_skipped, (unsigned long)stats.tiles_checked,
+                      (unsigned long)(stats.bytes_sent / 1024), (unsigned long)(stats.bytes_skipped / 1024),
+                      (unsigned long)stats.windows_sent, (unsigned long)stats.hash_collisions,
+                      (unsigned long)stats.unhashed_flushes, (unsigned long)stats.unverified_skips);
+        frame_diff_reset_stats();
     }
-    
-    // Check if screen needs to change based on state
-    static ScreenID lastScreen = SCREEN_1;
-    ScreenID currentScreen = appState->getCurrentScreen();
-    if (currentScreen != lastScreen) {
-        switch_to_screen(currentScreen, true);  // true = with animation
-        lastScreen = currentScreen;
+#endif
+
+#if IDLE_SCHED_LOG_INTERVAL_MS
+    static uint32_t lastIdleLog = 0;
+    if (millis() - lastIdleLog >= IDLE_SCHED_LOG_INTERVAL_MS) {
+        lastIdleLog = millis();
+        idle_sched_stats_t stats = idle_sched_get_stats();
+        Serial.printf("Idle jobs: %u waiting, %lu steps in %lu slices, %lu ms busy, %lu deferred, %lu forced, %lu missed (max %lu us late)\n",
+                      idle_sched_get_job_cnt(), (unsigned long)stats.steps, (unsigned long)stats.slices,
+                      (unsigned long)(stats.busy_us / 1000), (unsigned long)stats.deferred, (unsigned long)stats.forced,
+                      (unsigned long)stats.missed, (unsigned long)stats.max_overrun_us);
+        idle_sched_reset_stats();
     }
-    
-    // Update UI based on state changes
-    update_ui();
-    
+#endif
+
+#if POWER_LOG_INTERVAL_MS
+    static uint32_t lastPowerLog = 0;
+    if (millis() - lastPowerLog >= POWER_LOG_INTERVAL_MS) {
+        lastPowerLog = millis();
+        Serial.printf("Battery: %d%%%s\n", (int)appState->getBatteryLevel(), appState->isCharging() ? " (charging)" : "");
+    }
+#endif
+
+#if MEM_LOG_INTERVAL_MS
+    static uint32_t lastMemLog = 0;
+    if (millis() - lastMemLog >= MEM_LOG_INTERVAL_MS) {
+        lastMemLog = millis();
+        lv_mem_monitor_t mon;
+        lv_mem_monitor(&mon);
+        Serial.printf("Heap: %lu KB free, %lu KB largest block, %u%% frag, %lu KB peak used\n",
+                      (unsigned long)(mon.free_size / 1024), (unsigned long)(mon.free_biggest_size / 1024),
+                      mon.frag_pct, (unsigned long)(mon.max_used / 1024));
+#if LV_MEM_CUSTOM && LV_MEM_CUSTOM_POOL
+        lv_mem_pool_monitor_t pool;
+        lv_mem_pool_monitor(&pool);
+        Serial.printf("LVGL pools: %lu chunks, %lu/%lu bytes used (peak %lu), %lu fallbacks\n",
+                      (unsigned long)pool.chunk_cnt, (unsigned long)pool.used_size,
+                      (unsigned long)pool.total_size, (unsigned long)pool.max_used_size,
+                      (unsigned long)pool.fallback_cnt);
+#endif
+    }
+#endif
+
     // Small delay to prevent task watchdog (1ms is negligible for 350ms animation)
     delay(1);
 }
@@ -0,0 +1,268 @@
+/*
+ * Circular Text Benchmark - CircularText.h against the wrapped label
+ * Lays out the status strings of the screens and the serial protocol, and a
+ * few edge cases, with circular_text_set() and checks, for every font, top
+ * Y, letter space and line space, that the label shows exactly the flowed
+ * layout:
+ *
+ *   - lv_txt_get_size() of the flowed text at the label's content width
+ *     gives the layout's height (LVGL doesn't break a line again)
+ *   - without a width limit it gives the layout's width (the widest line)
+ *   - the label's own size is the layout's size
+ *   - circular_text_fits() on the shown text agrees with the layout and
+ *     doesn't touch the cache
+ *
+ * Then times, in ns per string (min of alternating rounds):
+ *
+ *   measure   lv_txt_get_size() at the chord of the first line, what the
+ *             wrapped labels of create_multiline_text() cost
+ *   flow      circular_text_flow() with the advance table ready
+ *   cached    circular_text_layout() from the cache
+ *   set       circular_text_set() on a label, cached layout, text changed
+ *
+ * and building the advance table once per font.
+ *
+ * Build (from the project root, after tools/host/build_lvgl.sh):
+ *   g++ -O2 -DLV_CONF_INCLUDE_SIMPLE -DLV_LVGL_H_INCLUDE_SIMPLE -Itools/host -Ilib/lvgl-8.3.5 \
+ *       -Ilib/lvgl-8.3.5/src -Iinclude tools/circular_text/circular_text_bench.cpp \
+ *       build_host/liblvgl.a -lm -o circular_text_bench
+ *
+ * With ASan/UBSan, against an LVGL built with
+ * CFLAGS="-O1 -g -fsanitize=address,undefined" BUILD=build_host_asan:
+ *   g++ -O1 -g -fsanitize=address,undefined ... build_host_asan/liblvgl.a -lm -o circular_text_asan
+ *
+ * Usage:
+ *   ./circular_text_bench                 # check, then 200 rounds of the corpus
+ *   ./circular_text_bench --rounds 20
+ */
+
+#include <lvgl.h>
+#include "utils/CircularText.h"
+// One generated font per translation unit: they share their static table names
+#include "fonts/stack_sans_semibold_48.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Alternating timing rounds, the fastest one is reported
+#define BENCH_ROUNDS 5
+
+// The status strings of the screens and the serial protocol, all fit into the layout cache
+
+static const char* const bench_corpus[] = {
+    "Connecting to WiFi...",
+    "Connecting to New WiFi...",
+    "WiFi Connected",
+    "\xE2\x9C\x93 WiFi Connected",
+    "\xE2\x9C\x97 WiFi Failed\nReverting...",
+    "\xE2\x9C\x93 Success",
+    "\xE2\x9C\x97 Error",
+    "Thank You",
+    "Scan the QR code to connect",
+    "Look at the camera and hold still",
+    "Move closer to the device",
+    "Measuring, please keep your finger on the sensor",
+    "Uploading results to the server, this can take a minute",
+    "Firmware update available. Restarting in 10 seconds",
+    "Battery low, please connect the charger",
+    "No network found. Check the router and try again",
+};
+#define BENCH_CORPUS_CNT (sizeof(bench_corpus) / sizeof(bench_corpus[0]))
+
+// Checked only: no spaces, runs of spaces, empty lines
+static const char* const bench_edge[] = {
+    "Supercalifragilisticexpialidocious_without_any_spaces",
+    "A  double  spaced   text with  many words to wrap",
+    "",
+    "\n\nx",
+};
+#define BENCH_EDGE_CNT (sizeof(bench_edge) / sizeof(bench_edge[0]))
+
+typedef struct {
+    const char* name;
+    const lv_font_t* font;
+} bench_font_t;
+
+static const bench_font_t bench_fonts[] = {
+    {"stack_sans 48", &stack_sans_semibold_48},
+    {"montserrat 14", &lv_font_montserrat_14},
+};
+
+static_assert(BENCH_CORPUS_CNT <= CIRCULAR_TEXT_CACHE_SIZE, "the cached times would measure evictions");
+
+static lv_color_t bench_buf[466 * 80];
+
+static uint64_t bench_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void bench_flush(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p) {
+    (void)area;
+    (void)color_p;
+    lv_disp_flush_ready(disp);
+}
+
+static void bench_init_lvgl() {
+    lv_init();
+
+    static lv_disp_draw_buf_t draw_buf;
+    lv_disp_draw_buf_init(&draw_buf, bench_buf, NULL, 466 * 80);
+
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = 466;
+    disp_drv.ver_res = 466;
+    disp_drv.flush_cb = bench_flush;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+}
+
+// Number of the layouts the label doesn't show as flowed
+static uint32_t bench_check(const lv_font_t* font, lv_coord_t top_y, lv_coord_t letter_space,
+                            lv_coord_t line_space) {
+    uint32_t fails = 0;
+    lv_obj_t* label = lv_label_create(lv_scr_act());
+    lv_obj_set_style_text_font(label, font, 0);
+    lv_obj_set_style_text_letter_space(label, letter_space, 0);
+    lv_obj_set_style_text_line_space(label, line_space, 0);
+    circular_text_set_top(label, top_y);
+
+    for (uint32_t i = 0; i < BENCH_CORPUS_CNT + BENCH_EDGE_CNT; i++) {
+        const char* text = i < BENCH_CORPUS_CNT ? bench_corpus[i] : bench_edge[i - BENCH_CORPUS_CNT];
+        const circular_text_layout_t* layout = circular_text_set(label, text);
+        lv_obj_update_layout(label);
+
+        lv_point_t wrapped, unwrapped;
+        lv_txt_get_size(&wrapped, lv_label_get_text(label), font, letter_space, line_space,
+                        lv_obj_get_content_width(label), LV_TEXT_FLAG_NONE);
+        lv_txt_get_size(&unwrapped, lv_label_get_text(label), font, letter_space, line_space,
+                        LV_COORD_MAX, LV_TEXT_FLAG_NONE);
+
+        // Checking the shown text doesn't touch the cache
+        circular_text_stats_t before = circular_text_get_stats();
+        bool fits = circular_text_fits(label);
+        circular_text_stats_t after = circular_text_get_stats();
+
+        if (layout == NULL || wrapped.y != layout->height || unwrapped.x != layout->width ||
+            lv_obj_get_height(label) != layout->height || fits != layout->fits ||
+            memcmp(&before, &after, sizeof(before)) != 0) {
+            if (fails == 0) {
+                printf("FAIL top %d, letter space %d, line space %d: \"%s\"\n", top_y, letter_space,
+                       line_space, text);
+            }
+            fails++;
+        }
+    }
+    lv_obj_del(label);
+    return fails;
+}
+
+typedef struct {
+    uint64_t measure_ns;
+    uint64_t flow_ns;
+    uint64_t cached_ns;
+    uint64_t set_ns;
+    uint64_t table_ns;
+} bench_times_t;
+
+static void bench_min(uint64_t* best, uint64_t t) {
+    if (*best == 0 || t < *best) *best = t;
+}
+
+static void bench_time(const lv_font_t* font, lv_coord_t top_y, uint32_t rounds, bench_times_t* res) {
+    static char out[256];
+    circular_text_layout_t layout;
+    lv_coord_t raw;
+    lv_coord_t w = circular_text_line_width(top_y, lv_font_get_line_height(font), &raw);
+    uint32_t strings = BENCH_CORPUS_CNT * rounds;
+
+    circular_text_clean();
+    uint64_t t = bench_now_ns();
+    circular_text_get_adv(font);
+    bench_min(&res->table_ns, bench_now_ns() - t);
+
+    t = bench_now_ns();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t i = 0; i < BENCH_CORPUS_CNT; i++) {
+            lv_point_t size;
+            lv_txt_get_size(&size, bench_corpus[i], font, 0, 0, w, LV_TEXT_FLAG_NONE);
+        }
+    }
+    bench_min(&res->measure_ns, (bench_now_ns() - t) / strings);
+
+    t = bench_now_ns();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t i = 0; i < BENCH_CORPUS_CNT; i++) {
+            circular_text_flow(bench_corpus[i], font, top_y, 0, 0, out, &layout);
+        }
+    }
+    bench_min(&res->flow_ns, (bench_now_ns() - t) / strings);
+
+    for (uint32_t i = 0; i < BENCH_CORPUS_CNT; i++) circular_text_layout(bench_corpus[i], font, top_y, 0, 0);
+    t = bench_now_ns();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t i = 0; i < BENCH_CORPUS_CNT; i++) circular_text_layout(bench_corpus[i], font, top_y, 0, 0);
+    }
+    bench_min(&res->cached_ns, (bench_now_ns() - t) / strings);
+
+    lv_obj_t* label = lv_label_create(lv_scr_act());
+    lv_obj_set_style_text_font(label, font, 0);
+    circular_text_set_top(label, top_y);
+    t = bench_now_ns();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t i = 0; i < BENCH_CORPUS_CNT; i++) circular_text_set(label, bench_corpus[i]);
+    }
+    bench_min(&res->set_ns, (bench_now_ns() - t) / strings);
+    lv_obj_del(label);
+}
+
+int main(int argc, char** argv) {
+    uint32_t rounds = 200;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--rounds N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    bench_init_lvgl();
+    const uint32_t font_cnt = sizeof(bench_fonts) / sizeof(bench_fonts[0]);
+
+    uint32_t fails = 0, checks = 0;
+    for (uint32_t f = 0; f < font_cnt; f++) {
+        for (lv_coord_t top_y = -20; top_y < 470; top_y += 17) {
+            for (lv_coord_t letter_space = -2; letter_space <= 4; letter_space += 3) {
+                for (lv_coord_t line_space = 0; line_space <= 6; line_space += 6) {
+                    fails += bench_check(bench_fonts[f].font, top_y, letter_space, line_space);
+                    checks += BENCH_CORPUS_CNT + BENCH_EDGE_CNT;
+                }
+            }
+        }
+    }
+    circular_text_stats_t stats = circular_text_get_stats();
+    printf("%u layouts checked, %u not shown as flowed (%u cache hits, %u misses, %u evictions)\n",
+           checks, fails, stats.hits, stats.misses, stats.evictions);
+
+    bench_times_t times[sizeof(bench_fonts) / sizeof(bench_fonts[0])];
+    memset(times, 0, sizeof(times));
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (uint32_t f = 0; f < font_cnt; f++) bench_time(bench_fonts[f].font, DISPLAY_CENTER_Y - 40, rounds, &times[f]);
+    }
+
+    printf("\n%u strings x %u rounds, ns per string (min of %d):\n", (unsigned)BENCH_CORPUS_CNT, rounds, BENCH_ROUNDS);
+    printf("  font             measure    flow  cached     set   table us\n");
+    for (uint32_t f = 0; f < font_cnt; f++) {
+        printf("  %-14s %9llu %7llu %7llu %7llu %10.1f\n", bench_fonts[f].name,
+               (unsigned long long)times[f].measure_ns, (unsigned long long)times[f].flow_ns,
+               (unsigned long long)times[f].cached_ns, (unsigned long long)times[f].set_ns,
+               times[f].table_ns / 1000.0);
+    }
+
+    circular_text_clean();
+    return fails != 0;
+}
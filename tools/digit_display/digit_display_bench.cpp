@@ -0,0 +1,288 @@
+/*
+ * Digit Display Benchmark - DigitDisplay.h against a label readout
+ * Three parts, on a 466x466 display with the device's 80-line draw buffer:
+ *
+ *   atlas      every character of DIGIT_DISPLAY_CHARS drawn by a one slot
+ *              display has to match a white label of the same character,
+ *              placed at the same spot, pixel for pixel
+ *   screen 7   {"progress": N} lines through SerialManager, and the
+ *              placeholder after a screen change, have to show on the
+ *              processing screen's ring and digits
+ *   bench      a percentage counting 0-100% one step per update, as a
+ *              30 Hz readout would, once with a label and once with a
+ *              digit display: microseconds per update (set + refresh)
+ *              and invalidated pixels, min of alternating rounds
+ *
+ * Build (from the project root, after tools/host/build_lvgl.sh):
+ *   g++ -O2 -DLV_CONF_INCLUDE_SIMPLE -DLV_LVGL_H_INCLUDE_SIMPLE -Itools/host -Ilib/lvgl-8.3.5 \
+ *       -Ilib/lvgl-8.3.5/src -Iinclude tools/digit_display/digit_display_bench.cpp \
+ *       build_host/liblvgl.a -lm -o digit_display_bench
+ *
+ * Usage:
+ *   ./digit_display_bench                 # 5 rounds of 303 updates
+ *   ./digit_display_bench --updates 1010
+ */
+
+#include <lvgl.h>
+#include "state/AppState.h"
+#include "state/SerialManager.h"
+#include "main.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+SerialClass Serial;
+
+#define BENCH_W 466
+#define BENCH_H 466
+
+// Alternating timing rounds, the fastest one is reported
+#define BENCH_ROUNDS 5
+
+typedef struct {
+    const char* name;
+    const lv_font_t* font;
+} bench_font_t;
+
+static const bench_font_t bench_fonts[] = {
+    {"stack_sans 48", &stack_sans_semibold_48},
+    {"montserrat 14", &lv_font_montserrat_14},
+};
+#define BENCH_FONT_CNT (sizeof(bench_fonts) / sizeof(bench_fonts[0]))
+
+typedef struct {
+    uint64_t us;            // Per update, set + refresh
+    uint64_t px;            // Invalidated per update
+} bench_cost_t;
+
+static lv_color_t bench_buf[BENCH_W * 80];
+static lv_color_t bench_fb[BENCH_W * BENCH_H];
+static lv_color_t bench_ref[BENCH_W * BENCH_H];
+
+static uint64_t bench_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void bench_flush(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p) {
+    lv_coord_t w = lv_area_get_width(area);
+    for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&bench_fb[y * BENCH_W + area->x1], &color_p[(y - area->y1) * w], w * sizeof(lv_color_t));
+    }
+    lv_disp_flush_ready(disp);
+}
+
+static void bench_init_lvgl() {
+    lv_init();
+
+    static lv_disp_draw_buf_t draw_buf;
+    lv_disp_draw_buf_init(&draw_buf, bench_buf, NULL, BENCH_W * 80);
+
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = BENCH_W;
+    disp_drv.ver_res = BENCH_H;
+    disp_drv.flush_cb = bench_flush;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+}
+
+static void bench_redraw() {
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+}
+
+// Number of the characters whose atlas cell doesn't draw like the label
+static uint32_t bench_check_atlas(const lv_font_t* font) {
+    uint32_t fails = 0;
+    for (const char* c = DIGIT_DISPLAY_CHARS; *c; c++) {
+        char text[2] = {*c, '\0'};
+
+        digit_display_config_t config = digit_display_config_default(font);
+        config.slots = 1;
+        digit_display_t* dd = digit_display_create(lv_scr_act(), &config);
+        if (!dd) return DIGIT_DISPLAY_CHAR_CNT;
+        lv_obj_set_pos(dd->obj, 100, 100);
+        digit_display_set_text(dd, text);
+        bench_redraw();
+        memcpy(bench_ref, bench_fb, sizeof(bench_fb));
+        digit_display_delete(dd);
+
+        // The label puts the glyph at its ofs_x, the cell centers the advance (see digit_atlas_render)
+        const digit_atlas_t* atlas = digit_atlas_get(font);
+        lv_font_glyph_dsc_t g;
+        lv_font_get_glyph_dsc(font, &g, *c, 0);
+        lv_coord_t cell_w = atlas->cell_w[digit_atlas_index(*c)];
+        lv_coord_t x0 = (cell_w - g.adv_w) / 2 + g.ofs_x;
+        if (x0 + g.box_w > cell_w) x0 = cell_w - g.box_w;
+        if (x0 < 0) x0 = 0;
+
+        lv_obj_t* label = lv_label_create(lv_scr_act());
+        lv_obj_set_style_text_font(label, font, 0);
+        lv_obj_set_style_text_color(label, lv_color_white(), 0);
+        lv_label_set_text(label, text);
+        lv_obj_set_pos(label, 100 + x0 - g.ofs_x, 100);
+        bench_redraw();
+        if (memcmp(bench_ref, bench_fb, sizeof(bench_fb)) != 0) {
+            printf("FAIL atlas: '%c' differs from the label\n", *c);
+            fails++;
+        }
+        lv_obj_del(label);
+    }
+    return fails;
+}
+
+static bool bench_screen7_shows(const char* digits, bool hidden, int ring_percent) {
+    screen7_update();
+    bool ok = screen7_percent && strcmp(screen7_percent->text, digits) == 0 &&
+              lv_obj_has_flag(screen7_percent->obj, LV_OBJ_FLAG_HIDDEN) == hidden &&
+              (int)(screen7_ring->config.progress * 100 + 0.5f) == ring_percent &&
+              (screen7_ring->anim_timer != NULL) == hidden;
+    if (!ok) {
+        printf("FAIL screen 7: \"%s\"%s, ring %d%%%s, expected \"%s\"%s, ring %d%%\n", screen7_percent->text,
+               lv_obj_has_flag(screen7_percent->obj, LV_OBJ_FLAG_HIDDEN) ? " hidden" : "",
+               (int)(screen7_ring->config.progress * 100 + 0.5f), screen7_ring->anim_timer ? " animating" : "",
+               digits, hidden ? " hidden" : "", ring_percent);
+    }
+    return ok;
+}
+
+// Number of the failed steps of a processing screen run
+static uint32_t bench_check_screen7(SerialManager* serial) {
+    uint32_t fails = 0;
+    AppState* app = AppState::getInstance();
+
+    serial->begin(115200);
+    Serial.inject("7\n");
+    serial->update();
+    switch_to_screen(app->getCurrentScreen(), false);
+    fails += !bench_screen7_shows("", true, 0);
+
+    Serial.inject("{\"progress\": 42}\n");
+    serial->update();
+    fails += !bench_screen7_shows(" 42%", false, 42);
+
+    Serial.inject("{\"progress\": 100}\n{\"progress\": 101}\n");
+    serial->update();
+    fails += !bench_screen7_shows("100%", false, 100);
+
+    // Leaving and coming back starts over with the placeholder
+    Serial.inject("8\n7\n");
+    serial->update();
+    switch_to_screen(app->getCurrentScreen(), false);
+    fails += !bench_screen7_shows("100%", true, 0);
+
+    Serial.take_output();
+    return fails;
+}
+
+// Sum of the areas waiting for the refresh
+static uint64_t bench_inv_px(lv_disp_t* disp) {
+    uint64_t px = 0;
+    for (uint16_t i = 0; i < disp->inv_p; i++) {
+        if (!disp->inv_area_joined[i]) px += lv_area_get_size(&disp->inv_areas[i]);
+    }
+    return px;
+}
+
+static void bench_min(bench_cost_t* best, uint64_t us, uint64_t px) {
+    if (best->us == 0 || us < best->us) best->us = us;
+    best->px = px;
+}
+
+static void bench_label(const lv_font_t* font, uint32_t updates, bench_cost_t* res) {
+    lv_disp_t* disp = lv_disp_get_default();
+    char buf[8];
+
+    lv_obj_t* label = lv_label_create(lv_scr_act());
+    lv_obj_set_style_text_font(label, font, 0);
+    lv_obj_align(label, LV_ALIGN_CENTER, 0, 0);
+    lv_refr_now(disp);
+
+    uint64_t px = 0;
+    uint64_t t = bench_now_ns();
+    for (uint32_t i = 0; i < updates; i++) {
+        lv_snprintf(buf, sizeof(buf), "%d%%", (int)(i % 101));
+        lv_label_set_text(label, buf);
+        lv_obj_update_layout(label);
+        px += bench_inv_px(disp);
+        lv_refr_now(disp);
+    }
+    bench_min(res, (bench_now_ns() - t) / 1000 / updates, px / updates);
+    lv_obj_del(label);
+    lv_refr_now(disp);
+}
+
+static void bench_digits(const lv_font_t* font, uint32_t updates, bench_cost_t* res) {
+    lv_disp_t* disp = lv_disp_get_default();
+
+    digit_display_config_t config = digit_display_config_default(font);
+    config.slots = 4;
+    digit_display_t* dd = digit_display_create(lv_scr_act(), &config);
+    if (!dd) return;
+    lv_obj_align(dd->obj, LV_ALIGN_CENTER, 0, 0);
+    lv_refr_now(disp);
+
+    uint64_t px = 0;
+    uint64_t t = bench_now_ns();
+    for (uint32_t i = 0; i < updates; i++) {
+        digit_display_set_int(dd, i % 101, "%");
+        px += bench_inv_px(disp);
+        lv_refr_now(disp);
+    }
+    bench_min(res, (bench_now_ns() - t) / 1000 / updates, px / updates);
+    digit_display_delete(dd);
+    lv_refr_now(disp);
+}
+
+int main(int argc, char** argv) {
+    uint32_t updates = 303;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--updates") && i + 1 < argc) {
+            updates = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--updates N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    bench_init_lvgl();
+    sim_clock_set_tick_cb(lv_tick_inc);
+    lv_obj_set_style_bg_color(lv_scr_act(), lv_color_black(), 0);
+    lv_obj_add_flag(lv_layer_sys(), LV_OBJ_FLAG_HIDDEN);  // The perf monitor, it changes between the compared frames
+
+    uint32_t fails = 0;
+    for (uint32_t f = 0; f < BENCH_FONT_CNT; f++) fails += bench_check_atlas(bench_fonts[f].font);
+    printf("atlas: %u characters x %u fonts, %u differ from the label\n", (unsigned)DIGIT_DISPLAY_CHAR_CNT,
+           (unsigned)BENCH_FONT_CNT, fails);
+
+    lv_obj_t* bench_screen = lv_scr_act();
+    init_ui();
+    SerialManager serial;
+    uint32_t screen_fails = bench_check_screen7(&serial);
+    printf("screen 7: %u failed steps\n", screen_fails);
+    fails += screen_fails;
+    lv_scr_load(bench_screen);
+
+    bench_cost_t label[BENCH_FONT_CNT], digits[BENCH_FONT_CNT];
+    memset(label, 0, sizeof(label));
+    memset(digits, 0, sizeof(digits));
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (uint32_t f = 0; f < BENCH_FONT_CNT; f++) {
+            bench_label(bench_fonts[f].font, updates, &label[f]);
+            bench_digits(bench_fonts[f].font, updates, &digits[f]);
+        }
+    }
+
+    printf("\n%u updates of 0-100%%, per update (min of %d):\n", updates, BENCH_ROUNDS);
+    printf("  font            label us      px   digits us      px\n");
+    for (uint32_t f = 0; f < BENCH_FONT_CNT; f++) {
+        printf("  %-14s %9llu %7llu %11llu %7llu\n", bench_fonts[f].name, (unsigned long long)label[f].us,
+               (unsigned long long)label[f].px, (unsigned long long)digits[f].us, (unsigned long long)digits[f].px);
+    }
+
+    digit_atlas_clean();
+    return fails != 0;
+}
@@ -0,0 +1,326 @@
+/*
+ * Load Generator - Serial traffic for the end-to-end harness
+ * Builds a schedule of messages in the line protocol that SerialManager reads
+ * and writes them to a pty (or any fd) at their times. Every message carries
+ * the state change it should cause, so the harness can tell when it's applied
+ * and time it until the first flush showing it.
+ *
+ * Sources:
+ *   - Replay of a recorded session: one message per line, "@<ms> " in front
+ *     sets its time, lines without it follow the previous one at the given rate
+ *     (a plain capture of nose_tracker.py output replays at 30 Hz)
+ *   - Synthetic nose tracking "X:###,Y:###" along a Lissajous path
+ *   - Screen-state script: the STATE_* IDs of ScreenMapping.h sent as bare
+ *     digits, which SerialManager maps to the same screens as stateToScreen()
+ *   - Kiosk session: the state script with the tracking streamed while the
+ *     tracking screen (Screen 7) shows
+ *   - Adversarial bursts: garbage bytes, lines overflowing the 512 byte
+ *     buffer, out of range coordinates and screens, CRLF floods
+ *
+ * Usage:
+ *   loadgen_t gen;
+ *   loadgen_add_kiosk(&gen, 0, 2000, 10000, 30, 60000);    // a state every 2 s, 10 s of 30 Hz tracking
+ *   loadgen_sort(&gen);
+ *   loadgen_run(&gen, master_fd, start_us, now_us, &stop);  // in its own thread
+ */
+
+#ifndef LOADGEN_H
+#define LOADGEN_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "ScreenMapping.h"
+
+// Maximum line SerialManager keeps before reporting an overflow
+#define LOADGEN_RX_LINE_MAX 512
+
+typedef enum {
+    LOADGEN_EFFECT_NONE,     // Nothing visible should change
+    LOADGEN_EFFECT_SCREEN,   // Switch to screen `a`
+    LOADGEN_EFFECT_TARGET,   // Move the target to (a, b)
+} loadgen_effect_t;
+
+typedef struct {
+    uint64_t at_us;          // Offset from the start
+    std::string bytes;
+    loadgen_effect_t effect;
+    int16_t a;
+    int16_t b;
+    uint64_t written_us;     // Set by loadgen_run() right before the first byte is written
+} loadgen_msg_t;
+
+typedef struct {
+    std::vector<loadgen_msg_t> msgs;
+    std::atomic<uint32_t> written{0};   // Messages started so far, in schedule order
+    uint64_t bytes_written = 0;
+    uint64_t bytes_read = 0;            // Replies from the UI drained from the pty
+    uint32_t max_late_us = 0;           // Worst delay of a write behind its schedule
+    uint32_t seed = 1;
+} loadgen_t;
+
+static inline uint32_t loadgen_random(loadgen_t* gen, uint32_t max) {
+    gen->seed = gen->seed * 1103515245u + 12345u;
+    return (gen->seed >> 16) % (max + 1);
+}
+
+/**
+ * The state change SerialManager::handleMessage() makes for a line
+ */
+static inline loadgen_effect_t loadgen_classify(const std::string& line, int16_t* a, int16_t* b) {
+    std::string msg = line;
+    while (!msg.empty() && (msg.back() == '\n' || msg.back() == '\r' || msg.back() == ' ')) msg.pop_back();
+    size_t first = msg.find_first_not_of(" \t");
+    msg = first == std::string::npos ? "" : msg.substr(first);
+    if (msg.empty() || msg.size() > LOADGEN_RX_LINE_MAX) return LOADGEN_EFFECT_NONE;
+
+    if (msg.size() <= 2 && isdigit((unsigned char)msg[0]) && (msg.size() == 1 || isdigit((unsigned char)msg[1]))) {
+        int n = atoi(msg.c_str());
+        if (n >= 0 && n <= 10) {
+            *a = n;
+            return LOADGEN_EFFECT_SCREEN;
+        }
+    }
+
+    int x, y;
+    if (sscanf(msg.c_str(), "X:%d,Y:%d", &x, &y) == 2) {
+        if (x >= 0 && x < 466 && y >= 0 && y < 466) {
+            *a = x;
+            *b = y;
+            return LOADGEN_EFFECT_TARGET;
+        }
+        return LOADGEN_EFFECT_NONE;
+    }
+
+    size_t key = msg.find("\"screen\"");
+    if (key != std::string::npos) {
+        size_t colon = msg.find(':', key);
+        int n = colon == std::string::npos ? 0 : atoi(msg.c_str() + colon + 1);
+        if (n >= 1 && n <= 10) {
+            *a = n - 1;
+            return LOADGEN_EFFECT_SCREEN;
+        }
+    }
+    return LOADGEN_EFFECT_NONE;
+}
+
+static inline void loadgen_add(loadgen_t* gen, uint64_t at_us, const std::string& bytes) {
+    loadgen_msg_t msg;
+    msg.at_us = at_us;
+    msg.bytes = bytes;
+    msg.a = 0;
+    msg.b = 0;
+    msg.effect = loadgen_classify(bytes, &msg.a, &msg.b);
+    msg.written_us = 0;
+    gen->msgs.push_back(msg);
+}
+
+/**
+ * Replay a recorded session
+ * @param path One message per line, optionally "@<ms> <message>"
+ * @param start_ms Offset of the first line
+ * @param hz Rate of the lines without a time
+ * @param speed Time scale, 2.0 replays twice as fast
+ * @return Lines read, -1 if the file can't be opened
+ */
+static inline int loadgen_add_replay(loadgen_t* gen, const char* path, uint32_t start_ms, uint32_t hz, float speed) {
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+    if (hz == 0) hz = 30;
+    if (speed <= 0) speed = 1;
+
+    char line[1024];
+    double t_ms = 0;
+    int cnt = 0;
+    while (fgets(line, sizeof(line), f)) {
+        const char* msg = line;
+        if (line[0] == '@') {
+            char* end;
+            t_ms = strtod(line + 1, &end);
+            msg = end;
+            while (*msg == ' ' || *msg == '\t') msg++;
+        } else if (cnt > 0) {
+            t_ms += 1000.0 / hz;
+        }
+        std::string bytes = msg;
+        if (bytes.empty() || bytes.back() != '\n') bytes += '\n';
+        loadgen_add(gen, (uint64_t)((start_ms + t_ms / speed) * 1000), bytes);
+        cnt++;
+    }
+    fclose(f);
+    return cnt;
+}
+
+/**
+ * Synthetic nose tracking around the center of the panel
+ */
+static inline void loadgen_add_tracking(loadgen_t* gen, uint32_t start_ms, uint32_t duration_ms, uint32_t hz) {
+    if (hz == 0) return;
+    uint32_t cnt = (uint64_t)duration_ms * hz / 1000;
+    for (uint32_t i = 0; i < cnt; i++) {
+        double t = (double)i / hz;
+        int x = 233 + (int)(150 * sin(t * 1.3));
+        int y = 233 + (int)(120 * sin(t * 1.7 + 0.5));
+        char buf[32];
+        snprintf(buf, sizeof(buf), "X:%d,Y:%d\n", x, y);
+        loadgen_add(gen, (uint64_t)start_ms * 1000 + (uint64_t)i * 1000000 / hz, buf);
+    }
+}
+
+// The states of a kiosk session in order
+static const uint8_t loadgen_kiosk_flow[] = {
+    STATE_SCAN_ADMIN_QR, STATE_WIFI, STATE_MDAI_READY, STATE_SCAN_USER_QR, STATE_WARMUP,
+    STATE_ALIGN, STATE_PROCESSING, STATE_SUCCESS, STATE_MDAI_READY, STATE_ERROR,
+};
+#define LOADGEN_KIOSK_FLOW_LEN sizeof(loadgen_kiosk_flow)
+
+/**
+ * Walk through the kiosk states
+ * @param states STATE_* IDs (NULL: STATE_SCAN_ADMIN_QR..STATE_ERROR), repeated until duration_ms
+ */
+static inline void loadgen_add_states(loadgen_t* gen, uint32_t start_ms, uint32_t interval_ms,
+                                      const uint8_t* states, uint32_t state_cnt, uint32_t duration_ms) {
+    if (!states) {
+        states = loadgen_kiosk_flow;
+        state_cnt = LOADGEN_KIOSK_FLOW_LEN;
+    }
+    if (interval_ms == 0 || state_cnt == 0) return;
+    for (uint32_t t = 0, i = 0; t < duration_ms; t += interval_ms, i++) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "%d\n", stateToScreen(states[i % state_cnt]));
+        loadgen_add(gen, (uint64_t)(start_ms + t) * 1000, buf);
+    }
+}
+
+/**
+ * Walk through the kiosk states with nose tracking only where it's shown
+ * The walk starts on the tracking screen (STATE_PROCESSING, Screen 7) and
+ * stays there for tracking_ms while the target moves at hz, the other
+ * states take interval_ms each.
+ */
+static inline void loadgen_add_kiosk(loadgen_t* gen, uint32_t start_ms, uint32_t interval_ms,
+                                     uint32_t tracking_ms, uint32_t hz, uint32_t duration_ms) {
+    if (interval_ms == 0) return;
+    uint32_t first = 0;
+    while (loadgen_kiosk_flow[first] != STATE_PROCESSING) first++;
+
+    for (uint32_t t = 0, i = first; t < duration_ms; i++) {
+        uint8_t state = loadgen_kiosk_flow[i % LOADGEN_KIOSK_FLOW_LEN];
+        char buf[8];
+        snprintf(buf, sizeof(buf), "%d\n", stateToScreen(state));
+        loadgen_add(gen, (uint64_t)(start_ms + t) * 1000, buf);
+
+        bool tracking = state == STATE_PROCESSING && hz > 0;
+        uint32_t stay = tracking && tracking_ms > 0 ? tracking_ms : interval_ms;
+        if (stay > duration_ms - t) stay = duration_ms - t;
+        if (tracking) loadgen_add_tracking(gen, start_ms + t, stay, hz);
+        t += stay;
+    }
+}
+
+/**
+ * Bursts of hostile input, each written as fast as the pty takes it
+ * @param period_ms Time between bursts
+ * @param burst_bytes Approximate size of a burst
+ */
+static inline void loadgen_add_bursts(loadgen_t* gen, uint32_t start_ms, uint32_t duration_ms,
+                                      uint32_t period_ms, uint32_t burst_bytes) {
+    if (period_ms == 0) return;
+    for (uint32_t t = 0; t < duration_ms; t += period_ms) {
+        std::string burst;
+        while (burst.size() < burst_bytes) {
+            switch (loadgen_random(gen, 5)) {
+                case 0:   // Binary garbage ending the line (high bytes, can't form a command)
+                    for (int i = loadgen_random(gen, 64); i >= 0; i--) burst += (char)(0x80 + loadgen_random(gen, 127));
+                    burst += '\n';
+                    break;
+                case 1:   // Longer than the receive buffer
+                    burst += std::string(LOADGEN_RX_LINE_MAX + 1 + loadgen_random(gen, 200), 'A');
+                    burst += '\n';
+                    break;
+                case 2:   // Out of range coordinates
+                    burst += "X:" + std::to_string((int)loadgen_random(gen, 2000) - 1000) +
+                             ",Y:" + std::to_string(466 + loadgen_random(gen, 1000)) + "\n";
+                    break;
+                case 3:   // Invalid screens
+                    burst += "{\"screen\": " + std::to_string(11 + loadgen_random(gen, 100)) + "}\n";
+                    break;
+                case 4:   // Empty lines
+                    burst += "\r\n\r\n\r\n";
+                    break;
+                default:  // Half a JSON object, completed by the garbage after it
+                    burst += "{\"scr";
+                    break;
+            }
+        }
+        burst += '\n';
+        loadgen_msg_t msg;
+        msg.at_us = (uint64_t)(start_ms + t) * 1000;
+        msg.bytes = burst;
+        msg.effect = LOADGEN_EFFECT_NONE;
+        msg.a = 0;
+        msg.b = 0;
+        msg.written_us = 0;
+        gen->msgs.push_back(msg);
+    }
+}
+
+static inline void loadgen_sort(loadgen_t* gen) {
+    std::stable_sort(gen->msgs.begin(), gen->msgs.end(),
+                     [](const loadgen_msg_t& a, const loadgen_msg_t& b) { return a.at_us < b.at_us; });
+}
+
+// Take the replies of the UI so its writes never block
+static inline void loadgen_drain(loadgen_t* gen, int fd, int timeout_ms) {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) <= 0) return;
+    char buf[1024];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) gen->bytes_read += n;
+}
+
+/**
+ * Write the schedule. Blocks until it's written or `stop` is set.
+ * @param fd Master side of the pty (non-blocking)
+ * @param start_us Time of offset 0 on the `now_us` clock
+ * @param now_us Microsecond clock shared with the harness
+ */
+static inline void loadgen_run(loadgen_t* gen, int fd, uint64_t start_us, uint64_t (*now_us)(void),
+                               const std::atomic<bool>* stop) {
+    for (size_t i = 0; i < gen->msgs.size() && !*stop; i++) {
+        loadgen_msg_t* msg = &gen->msgs[i];
+        uint64_t due = start_us + msg->at_us;
+        uint64_t now;
+        while ((now = now_us()) < due && !*stop) {
+            uint64_t wait_ms = (due - now) / 1000;
+            loadgen_drain(gen, fd, wait_ms > 2 ? 2 : (int)wait_ms);
+        }
+        if (now > due && now - due > gen->max_late_us) gen->max_late_us = now - due;
+
+        // Published before the write, the UI may act on the first bytes right away
+        msg->written_us = now_us();
+        gen->written.store(i + 1, std::memory_order_release);
+
+        size_t done = 0;
+        while (done < msg->bytes.size() && !*stop) {
+            ssize_t n = write(fd, msg->bytes.data() + done, msg->bytes.size() - done);
+            if (n > 0) done += n;
+            else if (n < 0 && errno != EAGAIN && errno != EINTR) return;
+            else loadgen_drain(gen, fd, 1);
+        }
+        gen->bytes_written += done;
+    }
+}
+
+#endif // LOADGEN_H
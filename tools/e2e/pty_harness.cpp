@@ -0,0 +1,381 @@
+/*
+ * End-to-End Harness - Serial command to flushed pixels on a Linux host
+ * Runs the host build of the UI (main.h, AppState, SerialManager and
+ * PowerMonitor, and app_loop_step() of AppLoop.h, the body of the device's
+ * loop()) with Serial attached to a pty, and feeds the
+ * other side of the pty from LoadGen.h in a second thread. Each message
+ * which should change the screen or move the target is matched to the
+ * moment the UI applies it, and timed from the write of its first byte to
+ * the end of the first refresh flushed after that.
+ *
+ * The display is headless: the flush callback only timestamps, plus an
+ * optional busy wait per pixel to model the QSPI bus (about 33 ns/px for
+ * RGB565 at 120 MHz x 4 lines). Host CPU time is not device CPU time, so
+ * compare runs with each other rather than with the panel.
+ *
+ * The latencies are wall-clock time: the pty, the writer thread and the
+ * rendering all take real time. tools/soak runs the same schedule for
+ * hours on the virtual clock of ArduinoCompat.h instead.
+ *
+ * The battery reads a steady 3.9 V. The display driver has the device's
+ * latency trace hooks, so with -DLATENCY_TRACE_ENABLED=1 a "TRACE" line
+ * dumps the trace points as on the device.
+ *
+ * Build (from the project root, after tools/host/build_lvgl.sh):
+ *   g++ -O2 -pthread -DLV_CONF_INCLUDE_SIMPLE -DLV_LVGL_H_INCLUDE_SIMPLE -Itools/host \
+ *       -Ilib/lvgl-8.3.5 -Ilib/lvgl-8.3.5/src -Iinclude -Itools/e2e \
+ *       tools/e2e/pty_harness.cpp build_host/liblvgl.a -lm -o pty_harness
+ *
+ * Usage:
+ *   ./pty_harness                                     # kiosk flow, 30 Hz tracking on screen 7, 60 s
+ *   ./pty_harness --tracking-hz 0 --state-interval-ms 500   # screen changes only
+ *   ./pty_harness --replay session.txt --speed 2      # recorded tracking at twice the rate
+ *   ./pty_harness --burst-period-ms 500 --burst-bytes 8192
+ *   ./pty_harness --pty-only                          # print the pty path and serve it
+ */
+
+#include <lvgl.h>
+#include "state/AppState.h"
+#include "state/SerialManager.h"
+#include "state/PowerMonitor.h"
+#include "utils/LatencyTrace.h"
+#include "main.h"
+#include "AppLoop.h"
+#include "LoadGen.h"
+
+#include <stdlib.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <thread>
+#include <deque>
+
+SerialClass Serial;
+
+// Longer runs keep the first latencies only
+#define HARNESS_MAX_SAMPLES 200000
+
+typedef struct {
+    uint32_t duration_ms = 60000;
+    const char* replay = NULL;
+    uint32_t replay_hz = 30;
+    float speed = 1;
+    uint32_t tracking_hz = 30;
+    uint32_t tracking_ms = 10000;           // On screen 7 per walk (0: state_interval_ms)
+    uint32_t state_interval_ms = 2000;
+    uint32_t burst_period_ms = 0;
+    uint32_t burst_bytes = 4096;
+    uint32_t bus_ns_per_px = 0;
+    bool pty_only = false;
+} harness_opts_t;
+
+typedef struct {
+    uint32_t msgs;
+    uint32_t applied;
+    uint32_t coalesced;       // Overwritten by a newer message before any refresh
+    uint32_t hidden;          // Applied while nothing showed it (target off screen 7)
+    uint32_t unmatched;       // Written but never applied
+    std::vector<uint32_t> latency_us;
+} harness_kind_t;
+
+static harness_opts_t opts;
+static loadgen_t gen;
+static AppState* appState;
+static SerialManager* serialManager;
+static PowerMonitor* powerMonitor;
+
+static harness_kind_t kind_screen, kind_target;
+static uint32_t none_msgs;
+static size_t next_written;                 // First message not looked at yet
+static std::deque<size_t> pending_screen;   // Written, not applied yet
+static std::deque<size_t> pending_target;
+static std::vector<size_t> awaiting_flush;  // Applied, not flushed yet
+static int16_t shown_x = -1, shown_y = -1;
+static unsigned long shown_tracking_time;
+
+static uint32_t refreshes;
+static uint64_t flushed_px;
+static uint32_t max_loop_us;
+
+static uint64_t now_us() {
+    return sim_clock_now_us();
+}
+
+static void busy_wait_ns(uint64_t ns) {
+    struct timespec t0, t;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &t);
+    } while ((uint64_t)(t.tv_sec - t0.tv_sec) * 1000000000ULL + t.tv_nsec - t0.tv_nsec < ns);
+}
+
+static void harness_flush(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p) {
+    (void)color_p;
+    bool last = lv_disp_flush_is_last(disp);
+    if (last) latency_trace_rendered();
+    uint64_t px = (uint64_t)lv_area_get_width(area) * lv_area_get_height(area);
+    if (opts.bus_ns_per_px) busy_wait_ns(px * opts.bus_ns_per_px);
+    flushed_px += px;
+    if (last) latency_trace_flushed();
+
+    if (last) {
+        refreshes++;
+        uint64_t t = now_us();
+        for (size_t i : awaiting_flush) {
+            loadgen_msg_t* msg = &gen.msgs[i];
+            harness_kind_t* kind = msg->effect == LOADGEN_EFFECT_SCREEN ? &kind_screen : &kind_target;
+            if (kind->latency_us.size() < HARNESS_MAX_SAMPLES) kind->latency_us.push_back(t - msg->written_us);
+        }
+        awaiting_flush.clear();
+    }
+    lv_disp_flush_ready(disp);
+}
+
+// Sees every invalidation, like traced_rounder_cb() in src/main.cpp
+static void harness_rounder(lv_disp_drv_t* disp, lv_area_t* area) {
+    (void)disp;
+    latency_trace_invalidated(area->x1, area->y1, area->x2, area->y2);
+}
+
+// A steady battery, discharging
+static bool harness_read_power(PowerSample* out) {
+    out->millivolts = 3900;
+    out->percent = -1;
+    out->charging = 0;
+    return true;
+}
+
+// Queue the messages the generator started writing since the last call
+static void harness_take_written() {
+    size_t written = gen.written.load(std::memory_order_acquire);
+    for (; next_written < written; next_written++) {
+        switch (gen.msgs[next_written].effect) {
+            case LOADGEN_EFFECT_SCREEN:
+                kind_screen.msgs++;
+                pending_screen.push_back(next_written);
+                break;
+            case LOADGEN_EFFECT_TARGET:
+                kind_target.msgs++;
+                pending_target.push_back(next_written);
+                break;
+            default:
+                none_msgs++;
+                break;
+        }
+    }
+}
+
+// Every changeScreen() of AppState, in order, also for the current screen
+static void harness_screen_changed(ScreenID screen) {
+    switch_to_screen((int)screen, true);
+
+    harness_take_written();
+    while (!pending_screen.empty()) {
+        size_t i = pending_screen.front();
+        pending_screen.pop_front();
+        if (gen.msgs[i].a == screen) {
+            kind_screen.applied++;
+            awaiting_flush.push_back(i);
+            return;
+        }
+        kind_screen.unmatched++;
+    }
+}
+
+// The target moves only once per loop, the newest position wins
+static void harness_check_target() {
+    AppStateData* state = appState->getState();
+    if (state->lastTrackingUpdate == shown_tracking_time &&
+        state->targetX == shown_x && state->targetY == shown_y) return;
+
+    harness_take_written();
+    size_t hit = SIZE_MAX;
+    for (size_t n = pending_target.size(); n > 0; n--) {
+        loadgen_msg_t* msg = &gen.msgs[pending_target[n - 1]];
+        if (msg->a == state->targetX && msg->b == state->targetY) {
+            hit = n - 1;
+            break;
+        }
+    }
+    if (hit == SIZE_MAX) return;
+
+    kind_target.coalesced += hit;
+    size_t i = pending_target[hit];
+    pending_target.erase(pending_target.begin(), pending_target.begin() + hit + 1);
+    kind_target.applied++;
+
+    bool visible = appState->getCurrentScreen() == SCREEN_7 && get_current_screen() == SCREEN_7;
+    bool moved = state->targetX != shown_x || state->targetY != shown_y;
+    if (visible && moved) awaiting_flush.push_back(i);
+    else kind_target.hidden++;
+
+    shown_x = state->targetX;
+    shown_y = state->targetY;
+    shown_tracking_time = state->lastTrackingUpdate;
+}
+
+// loop() of src/main.cpp without its logs, timed
+static void harness_loop() {
+#if !LV_TICK_CUSTOM
+    static unsigned long last_tick = millis();
+    unsigned long ms = millis();
+    lv_tick_inc(ms - last_tick);
+    last_tick = ms;
+#endif
+    harness_take_written();
+    uint64_t t0 = now_us();
+    app_loop_step(appState, serialManager, powerMonitor);
+    uint32_t took = now_us() - t0;
+    if (took > max_loop_us) max_loop_us = took;
+    harness_check_target();
+
+    delay(1);
+}
+
+static void harness_init_lvgl() {
+    lv_init();
+
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf_1[466 * 80];
+    static lv_color_t buf_2[466 * 80];
+    lv_disp_draw_buf_init(&draw_buf, buf_1, buf_2, 466 * 80);
+
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = 466;
+    disp_drv.ver_res = 466;
+    disp_drv.flush_cb = harness_flush;
+    disp_drv.rounder_cb = harness_rounder;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+}
+
+// Master side for the generator, the slave in raw mode for Serial
+static int harness_open_pty(int* slave_fd) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) return -1;
+    *slave_fd = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (*slave_fd < 0) return -1;
+
+    struct termios tio;
+    tcgetattr(*slave_fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(*slave_fd, TCSANOW, &tio);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    return master;
+}
+
+static void harness_print_kind(const char* name, harness_kind_t* kind) {
+    std::vector<uint32_t>& lat = kind->latency_us;
+    printf("%-8s %6u msgs, %6u applied, %6u coalesced, %6u hidden, %4u unmatched",
+           name, kind->msgs, kind->applied, kind->coalesced, kind->hidden,
+           kind->unmatched + (uint32_t)(name[0] == 's' ? pending_screen.size() : pending_target.size()));
+    if (lat.empty()) {
+        printf("\n");
+        return;
+    }
+    std::sort(lat.begin(), lat.end());
+    auto pct = [&](double p) { return lat[(size_t)(p * (lat.size() - 1))] / 1000.0; };
+    printf("\n         latency ms: p50 %.2f  p90 %.2f  p99 %.2f  p99.9 %.2f  max %.2f  (%zu samples)\n",
+           pct(0.5), pct(0.9), pct(0.99), pct(0.999), lat.back() / 1000.0, lat.size());
+}
+
+static bool harness_parse_args(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const char* key = argv[i];
+        const char* val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!strcmp(key, "--pty-only")) { opts.pty_only = true; continue; }
+        if (!val) return false;
+        i++;
+        if (!strcmp(key, "--duration-ms")) opts.duration_ms = atoi(val);
+        else if (!strcmp(key, "--replay")) opts.replay = val;
+        else if (!strcmp(key, "--replay-hz")) opts.replay_hz = atoi(val);
+        else if (!strcmp(key, "--speed")) opts.speed = atof(val);
+        else if (!strcmp(key, "--tracking-hz")) opts.tracking_hz = atoi(val);
+        else if (!strcmp(key, "--tracking-ms")) opts.tracking_ms = atoi(val);
+        else if (!strcmp(key, "--state-interval-ms")) opts.state_interval_ms = atoi(val);
+        else if (!strcmp(key, "--burst-period-ms")) opts.burst_period_ms = atoi(val);
+        else if (!strcmp(key, "--burst-bytes")) opts.burst_bytes = atoi(val);
+        else if (!strcmp(key, "--bus-ns-per-px")) opts.bus_ns_per_px = atoi(val);
+        else if (!strcmp(key, "--seed")) gen.seed = atoi(val);
+        else return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (!harness_parse_args(argc, argv)) {
+        fprintf(stderr, "usage: %s [--duration-ms N] [--replay FILE] [--replay-hz N] [--speed X]\n"
+                        "       [--tracking-hz N] [--tracking-ms N] [--state-interval-ms N]\n"
+                        "       [--burst-period-ms N] [--burst-bytes N] [--bus-ns-per-px N] [--seed N]\n"
+                        "       [--pty-only]\n", argv[0]);
+        return 2;
+    }
+
+    int slave_fd;
+    int master_fd = harness_open_pty(&slave_fd);
+    if (master_fd < 0) {
+        perror("pty");
+        return 1;
+    }
+
+    harness_init_lvgl();
+    appState = AppState::getInstance();
+    serialManager = new SerialManager();
+    // With --pty-only another program opens the slave like a serial port, Serial takes the master.
+    // The slave stays open so the master doesn't hang up while nothing is connected.
+    Serial.attach(opts.pty_only ? master_fd : slave_fd);
+    serialManager->begin(115200);
+    powerMonitor = new PowerMonitor();
+    powerMonitor->begin(harness_read_power);
+    idle_sched_init([]() -> uint32_t { return (uint32_t)now_us(); });
+    latency_trace_init([]() -> uint32_t { return (uint32_t)now_us(); });
+    init_ui();
+    appState->setScreenChangeCallback(harness_screen_changed);
+
+    if (opts.pty_only) {
+        // Drive the UI from another program, e.g. a real nose_tracker.py
+        printf("Serial on %s\n", ptsname(master_fd));
+        fflush(stdout);
+        for (;;) harness_loop();
+    }
+
+    if (opts.replay) {
+        if (loadgen_add_replay(&gen, opts.replay, 0, opts.replay_hz, opts.speed) < 0) {
+            perror(opts.replay);
+            return 1;
+        }
+    } else {
+        loadgen_add_kiosk(&gen, 0, opts.state_interval_ms, opts.tracking_ms, opts.tracking_hz, opts.duration_ms);
+    }
+    loadgen_add_bursts(&gen, opts.burst_period_ms / 2, opts.duration_ms, opts.burst_period_ms, opts.burst_bytes);
+    loadgen_sort(&gen);
+    uint64_t end_ms = gen.msgs.empty() ? 0 : gen.msgs.back().at_us / 1000;
+
+    std::atomic<bool> stop(false);
+    uint64_t start = now_us() + 100000;
+    std::thread writer([&]() { loadgen_run(&gen, master_fd, start, now_us, &stop); });
+
+    // Run a second past the last message for its refresh
+    while (now_us() < start + (end_ms + 1000) * 1000) harness_loop();
+    stop = true;
+    writer.join();
+    harness_take_written();
+
+    double secs = (now_us() - start) / 1e6;
+    printf("%.1f s, %zu messages, %llu bytes written (max %u us behind schedule), %llu bytes replied\n",
+           secs, gen.msgs.size(), (unsigned long long)gen.bytes_written, gen.max_late_us,
+           (unsigned long long)gen.bytes_read);
+    printf("%u refreshes, %.1f Mpx flushed, slowest loop %.2f ms, %u other messages\n",
+           refreshes, flushed_px / 1e6, max_loop_us / 1000.0, none_msgs);
+    harness_print_kind("screen", &kind_screen);
+    harness_print_kind("target", &kind_target);
+
+    // Targets that never showed measured nothing
+    uint32_t failed = 0;
+    if (kind_target.msgs > 0 && kind_target.latency_us.empty()) {
+        printf("FAIL %u target messages, none shown on screen 7\n", kind_target.msgs);
+        failed++;
+    }
+    printf("%u failed\n", failed);
+    return failed != 0;
+}
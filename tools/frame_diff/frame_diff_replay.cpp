@@ -0,0 +1,440 @@
+/*
+ * Frame Diff Replay - Checks and measures include/utils/FrameDiff.h
+ * Renders scenes like the ones of the firmware into a reference frame on a
+ * 466x466 panel, flushes the invalidated areas the way LVGL does (rounder of
+ * main.cpp, 80 line draw buffer) and sends them to a simulated panel. After every
+ * frame the panel must match the reference pixel by pixel.
+ *
+ * Scenes:
+ *   loader      a 180 degree arc rotating 6 degrees per frame around a
+ *               static text, the two moving ends invalidated
+ *   restyle     a button re-rendered every frame, the color changes once
+ *               per second
+ *   counter     a percentage counting up in a 150x70 label
+ *   transition  the whole screen sliding, every pixel changes
+ *   random      unaligned areas without the rounder, half of them with the
+ *               same pixels, some with one pixel changed
+ *
+ * Every scene runs with these flushes:
+ *   plain       every area sent as it is (FRAME_DIFF_ENABLED=0)
+ *   mirror      frame diff with the panel mirror
+ *   hash        frame diff trusting the hashes
+ *   nomirror    the mirror allocation fails: must work like "hash" and
+ *               count the unverified skips
+ *   unhashed    the hash allocation fails: must work like "plain" and
+ *               count the unhashed flushes
+ *
+ * The QSPI time is modeled from the bytes and windows sent (--qspi-mhz,
+ * 4 data lines, --window-us per address window). The diff time is the host
+ * CPU time in frame_diff_flush() without the send callback.
+ *
+ * Build (from the project root):
+ *   g++ -O2 -Itools/frame_diff -Iinclude tools/frame_diff/frame_diff_replay.cpp -o frame_diff_replay
+ *
+ * Usage:
+ *   ./frame_diff_replay                          # 300 frames per scene
+ *   ./frame_diff_replay --frames 1000 --qspi-mhz 40 --window-us 10 --seed 7
+ * Exits non-zero if the panel ever differs from the reference.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+// Lets the replay fail the mirror allocation
+static bool replay_mirror_fail = false;
+
+static void* replay_mirror_alloc(size_t size) {
+    return replay_mirror_fail ? NULL : malloc(size);
+}
+
+#define FRAME_DIFF_MIRROR_ALLOC(size) replay_mirror_alloc(size)
+#include "utils/FrameDiff.h"
+
+#define REPLAY_W 466
+#define REPLAY_H 466
+#define REPLAY_BUF_LINES 80     // Draw buffer of main.cpp: LCD_WIDTH * 80 pixels
+#define REPLAY_MAX_AREAS 8
+
+typedef enum {
+    REPLAY_SCENE_LOADER,
+    REPLAY_SCENE_RESTYLE,
+    REPLAY_SCENE_COUNTER,
+    REPLAY_SCENE_TRANSITION,
+    REPLAY_SCENE_RANDOM,
+    REPLAY_SCENE_CNT
+} replay_scene_t;
+
+typedef enum {
+    REPLAY_MODE_PLAIN,
+    REPLAY_MODE_MIRROR,
+    REPLAY_MODE_HASH,
+    REPLAY_MODE_NOMIRROR,
+    REPLAY_MODE_UNHASHED,
+    REPLAY_MODE_CNT
+} replay_mode_t;
+
+static const char* const replay_scene_names[REPLAY_SCENE_CNT] = {
+    "loader", "restyle", "counter", "transition", "random"
+};
+
+static const char* const replay_mode_names[REPLAY_MODE_CNT] = {
+    "plain", "mirror", "hash", "nomirror", "unhashed"
+};
+
+typedef struct {
+    uint64_t bytes;
+    uint32_t windows;
+    uint64_t send_ns;
+} replay_link_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t bad_frames;       // Frames after which the panel differed from the reference
+    uint64_t bytes;
+    uint32_t windows;
+    uint64_t diff_ns;
+    frame_diff_stats_t stats;
+} replay_result_t;
+
+static uint16_t replay_ref[REPLAY_W * REPLAY_H];    // What LVGL rendered
+static uint16_t replay_panel[REPLAY_W * REPLAY_H];  // What the panel shows
+static uint16_t replay_buf[REPLAY_W * REPLAY_BUF_LINES];
+static replay_link_t replay_link;
+static uint32_t replay_rand_state = 1;
+
+static uint64_t replay_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint32_t replay_rand() {
+    replay_rand_state = replay_rand_state * 1103515245u + 12345u;
+    return replay_rand_state >> 8;
+}
+
+// ============================================================================
+// PANEL
+// ============================================================================
+
+static void replay_send(int32_t x, int32_t y, uint32_t w, uint32_t h, uint16_t* pixels) {
+    uint64_t t = replay_now_ns();
+    for (uint32_t row = 0; row < h; row++) {
+        memcpy(&replay_panel[(y + row) * REPLAY_W + x], pixels + row * w, w * sizeof(uint16_t));
+    }
+    replay_link.bytes += w * h * sizeof(uint16_t);
+    replay_link.windows++;
+    replay_link.send_ns += replay_now_ns() - t;
+}
+
+// ============================================================================
+// DRAWING
+// ============================================================================
+
+static void replay_fill(int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color) {
+    x1 = LV_MAX(x1, 0);
+    y1 = LV_MAX(y1, 0);
+    x2 = LV_MIN(x2, REPLAY_W - 1);
+    y2 = LV_MIN(y2, REPLAY_H - 1);
+    for (int32_t y = y1; y <= y2; y++) {
+        for (int32_t x = x1; x <= x2; x++) replay_ref[y * REPLAY_W + x] = color;
+    }
+}
+
+static bool replay_angle_in(float a, float start, float length) {
+    float d = fmodf(a - start + 720.0f, 360.0f);
+    return d < length;
+}
+
+/**
+ * The ring of the loader screens: 30 px wide at the edge of the panel,
+ * the indicator from `start` over 180 degrees
+ */
+static void replay_draw_ring(uint32_t start) {
+    const float cx = (REPLAY_W - 1) / 2.0f;
+    const float cy = (REPLAY_H - 1) / 2.0f;
+    for (int32_t y = 0; y < REPLAY_H; y++) {
+        for (int32_t x = 0; x < REPLAY_W; x++) {
+            float dx = x - cx;
+            float dy = y - cy;
+            float r = sqrtf(dx * dx + dy * dy);
+            if (r < 203.0f || r > 233.0f) continue;
+            float a = atan2f(dy, dx) * 57.29578f + 180.0f;
+            replay_ref[y * REPLAY_W + x] = replay_angle_in(a, (float)start, 180.0f) ? 0x2D7F : 0x39E7;
+        }
+    }
+}
+
+/**
+ * Bounding box of the ring between two angles
+ */
+static lv_area_t replay_ring_span_area(uint32_t start, uint32_t length) {
+    const float cx = (REPLAY_W - 1) / 2.0f;
+    const float cy = (REPLAY_H - 1) / 2.0f;
+    lv_area_t a = {REPLAY_W, REPLAY_H, -1, -1};
+    for (uint32_t i = 0; i <= length * 4; i++) {
+        float rad = ((start + i / 4.0f) - 180.0f) / 57.29578f;
+        for (float r = 202.0f; r <= 234.0f; r += 4.0f) {
+            int32_t x = (int32_t)(cx + r * cosf(rad));
+            int32_t y = (int32_t)(cy + r * sinf(rad));
+            a.x1 = LV_MIN(a.x1, x - 2);
+            a.y1 = LV_MIN(a.y1, y - 2);
+            a.x2 = LV_MAX(a.x2, x + 2);
+            a.y2 = LV_MAX(a.y2, y + 2);
+        }
+    }
+    return a;
+}
+
+// A 7 segment digit, 30x60 px
+static void replay_draw_digit(int32_t x, int32_t y, uint32_t digit, uint16_t color) {
+    static const uint8_t segments[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+    uint8_t s = segments[digit % 10];
+    if (s & 0x01) replay_fill(x + 4, y, x + 25, y + 5, color);
+    if (s & 0x02) replay_fill(x + 24, y + 4, x + 29, y + 29, color);
+    if (s & 0x04) replay_fill(x + 24, y + 30, x + 29, y + 55, color);
+    if (s & 0x08) replay_fill(x + 4, y + 54, x + 25, y + 59, color);
+    if (s & 0x10) replay_fill(x, y + 30, x + 5, y + 55, color);
+    if (s & 0x20) replay_fill(x, y + 4, x + 5, y + 29, color);
+    if (s & 0x40) replay_fill(x + 4, y + 27, x + 25, y + 32, color);
+}
+
+// A static text line of the loader screens
+static void replay_draw_text(int32_t y) {
+    for (int32_t i = 0; i < 12; i++) replay_draw_digit(53 + i * 30, y, i * 7, 0xFFFF);
+}
+
+/**
+ * Render the frame of a scene into the reference and list the invalidated areas
+ * @return number of areas
+ */
+static int replay_render(replay_scene_t scene, uint32_t frame, lv_area_t* areas) {
+    switch (scene) {
+    case REPLAY_SCENE_LOADER: {
+        uint32_t start = (frame * 6) % 360;
+        if (frame == 0) {
+            replay_fill(0, 0, REPLAY_W - 1, REPLAY_H - 1, 0);
+            replay_draw_ring(start);
+            replay_draw_text(190);
+            areas[0] = {0, 0, REPLAY_W - 1, REPLAY_H - 1};
+            return 1;
+        }
+        replay_draw_ring(start);
+        uint32_t prev = (start + 354) % 360;
+        areas[0] = replay_ring_span_area(prev, 6);
+        areas[1] = replay_ring_span_area((prev + 180) % 360, 6);
+        return 2;
+    }
+    case REPLAY_SCENE_RESTYLE: {
+        if (frame == 0) {
+            replay_fill(0, 0, REPLAY_W - 1, REPLAY_H - 1, 0);
+            areas[0] = {0, 0, REPLAY_W - 1, REPLAY_H - 1};
+            return 1;
+        }
+        uint16_t color = (frame / 30) % 2 ? 0x2D7F : 0xF800;
+        replay_fill(133, 300, 332, 359, color);
+        replay_draw_digit(218, 300, frame / 30, 0xFFFF);
+        areas[0] = {133, 300, 332, 359};
+        return 1;
+    }
+    case REPLAY_SCENE_COUNTER: {
+        if (frame == 0) {
+            replay_fill(0, 0, REPLAY_W - 1, REPLAY_H - 1, 0);
+            areas[0] = {0, 0, REPLAY_W - 1, REPLAY_H - 1};
+            return 1;
+        }
+        uint32_t value = frame % 101;
+        replay_fill(158, 198, 307, 267, 0);
+        if (value >= 100) replay_draw_digit(163, 203, 1, 0xFFFF);
+        if (value >= 10) replay_draw_digit(203, 203, (value / 10) % 10, 0xFFFF);
+        replay_draw_digit(243, 203, value % 10, 0xFFFF);
+        replay_fill(280, 248, 300, 262, 0xFFFF);
+        areas[0] = {158, 198, 307, 267};
+        return 1;
+    }
+    case REPLAY_SCENE_TRANSITION: {
+        int32_t ofs = (frame * 8) % REPLAY_W;
+        for (int32_t y = 0; y < REPLAY_H; y++) {
+            for (int32_t x = 0; x < REPLAY_W; x++) {
+                replay_ref[y * REPLAY_W + x] = (uint16_t)(((x + ofs) * 31 / REPLAY_W) << 11 | (y * 63 / REPLAY_H) << 5);
+            }
+        }
+        areas[0] = {0, 0, REPLAY_W - 1, REPLAY_H - 1};
+        return 1;
+    }
+    default: {
+        int cnt = 1 + replay_rand() % 4;
+        for (int i = 0; i < cnt; i++) {
+            lv_area_t a;
+            a.x1 = replay_rand() % REPLAY_W;
+            a.y1 = replay_rand() % REPLAY_H;
+            int32_t w = replay_rand() % 200;
+            int32_t h = replay_rand() % 200;
+            a.x2 = LV_MIN(a.x1 + w, REPLAY_W - 1);
+            a.y2 = LV_MIN(a.y1 + h, REPLAY_H - 1);
+            uint32_t kind = replay_rand() % 4;
+            if (kind == 1) {
+                // One pixel changed
+                int32_t x = a.x1 + replay_rand() % (a.x2 - a.x1 + 1);
+                int32_t y = a.y1 + replay_rand() % (a.y2 - a.y1 + 1);
+                replay_ref[y * REPLAY_W + x] ^= 1 + replay_rand() % 0xFFFF;
+            } else if (kind >= 2) {
+                uint16_t color = replay_rand();
+                for (int32_t y = a.y1; y <= a.y2; y++) {
+                    for (int32_t x = a.x1; x <= a.x2; x++) {
+                        replay_ref[y * REPLAY_W + x] = kind == 2 ? color : (uint16_t)replay_rand();
+                    }
+                }
+            }
+            areas[i] = a;
+        }
+        return cnt;
+    }
+    }
+}
+
+// ============================================================================
+// FLUSHING
+// ============================================================================
+
+/**
+ * The rounder of main.cpp without frame diff: even x coordinates and height for the CO5300
+ */
+static void replay_even_rounder(lv_disp_drv_t* disp_drv, lv_area_t* area) {
+    LV_UNUSED(disp_drv);
+    area->x1 = (area->x1 >> 1) << 1;
+    area->x2 = ((area->x2 >> 1) << 1) + 1;
+    if ((area->y2 - area->y1 + 1) % 2 != 0) area->y2 -= 1;
+}
+
+/**
+ * Refresh an invalidated area like lv_refr_area(): round it, then render it
+ * into the draw buffer in bands and flush every band
+ */
+static uint64_t replay_refresh_area(lv_area_t area, replay_mode_t mode, bool use_rounder) {
+    if (use_rounder && mode == REPLAY_MODE_PLAIN) replay_even_rounder(NULL, &area);
+    else if (use_rounder) frame_diff_rounder(NULL, &area);
+    area.x1 = LV_MAX(area.x1, 0);
+    area.y1 = LV_MAX(area.y1, 0);
+    area.x2 = LV_MIN(area.x2, REPLAY_W - 1);
+    area.y2 = LV_MIN(area.y2, REPLAY_H - 1);
+
+    int32_t w = area.x2 - area.x1 + 1;
+    int32_t max_rows = REPLAY_W * REPLAY_BUF_LINES / w;
+    if (use_rounder) max_rows = max_rows / FRAME_DIFF_TILE_H * FRAME_DIFF_TILE_H;  // Also even
+
+    uint64_t diff_ns = 0;
+    for (int32_t y1 = area.y1; y1 <= area.y2; y1 += max_rows) {
+        lv_area_t band = {area.x1, (lv_coord_t)y1, area.x2, (lv_coord_t)LV_MIN(y1 + max_rows - 1, area.y2)};
+        int32_t h = band.y2 - band.y1 + 1;
+        for (int32_t row = 0; row < h; row++) {
+            memcpy(&replay_buf[row * w], &replay_ref[(band.y1 + row) * REPLAY_W + band.x1], w * sizeof(uint16_t));
+        }
+
+        if (mode == REPLAY_MODE_PLAIN) {
+            replay_send(band.x1, band.y1, w, h, replay_buf);
+        } else {
+            uint64_t send_ns = replay_link.send_ns;
+            uint64_t t = replay_now_ns();
+            frame_diff_flush(&band, (lv_color_t*)replay_buf);
+            diff_ns += replay_now_ns() - t - (replay_link.send_ns - send_ns);
+        }
+    }
+    return diff_ns;
+}
+
+static replay_result_t replay_run(replay_scene_t scene, replay_mode_t mode, uint32_t frames, uint32_t seed) {
+    memset(replay_ref, 0, sizeof(replay_ref));
+    memset(replay_panel, 0, sizeof(replay_panel));
+    memset(&replay_link, 0, sizeof(replay_link));
+    replay_rand_state = seed;
+
+    free(frame_diff.hashes);
+    free(frame_diff.mirror);
+    free(frame_diff.scratch);
+    free(frame_diff.changed);
+    memset(&frame_diff, 0, sizeof(frame_diff));
+    if (mode != REPLAY_MODE_PLAIN) {
+        replay_mirror_fail = mode == REPLAY_MODE_NOMIRROR;
+        bool ok = frame_diff_init(REPLAY_W, REPLAY_H, replay_send, mode != REPLAY_MODE_HASH);
+        replay_mirror_fail = false;
+        if (ok != (mode != REPLAY_MODE_NOMIRROR)) printf("  frame_diff_init() returned %d\n", ok);
+        if (mode == REPLAY_MODE_UNHASHED) {
+            // Like a failed allocation of the hashes
+            free(frame_diff.hashes);
+            frame_diff.hashes = NULL;
+        }
+    }
+
+    replay_result_t res;
+    memset(&res, 0, sizeof(res));
+    bool use_rounder = scene != REPLAY_SCENE_RANDOM;
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        lv_area_t areas[REPLAY_MAX_AREAS];
+        int cnt = replay_render(scene, frame, areas);
+        for (int i = 0; i < cnt; i++) res.diff_ns += replay_refresh_area(areas[i], mode, use_rounder);
+        if (memcmp(replay_panel, replay_ref, sizeof(replay_ref)) != 0) res.bad_frames++;
+        res.frames++;
+    }
+
+    res.bytes = replay_link.bytes;
+    res.windows = replay_link.windows;
+    res.stats = frame_diff_get_stats();
+    return res;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main(int argc, char** argv) {
+    uint32_t frames = 300;
+    float qspi_mhz = 80.0f;
+    float window_us = 8.0f;
+    uint32_t seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--frames")) frames = strtoul(argv[i + 1], NULL, 0);
+        else if (!strcmp(argv[i], "--qspi-mhz")) qspi_mhz = strtof(argv[i + 1], NULL);
+        else if (!strcmp(argv[i], "--window-us")) window_us = strtof(argv[i + 1], NULL);
+        else if (!strcmp(argv[i], "--seed")) seed = strtoul(argv[i + 1], NULL, 0);
+        else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    // 4 data lines: half a byte per clock
+    float bytes_per_us = qspi_mhz / 2.0f;
+    printf("%u frames per scene, %.0f MHz QSPI, %.0f us per window\n\n", frames, qspi_mhz, window_us);
+    printf("%-10s %-9s %8s %10s %9s %9s %9s %8s %s\n", "scene", "flush", "skipped", "KB/frame", "win/frame",
+           "qspi us", "diff us", "panel", "counters");
+
+    int failures = 0;
+    for (int scene = 0; scene < REPLAY_SCENE_CNT; scene++) {
+        for (int mode = 0; mode < REPLAY_MODE_CNT; mode++) {
+            replay_result_t r = replay_run((replay_scene_t)scene, (replay_mode_t)mode, frames, seed);
+            float qspi_us = (r.bytes / bytes_per_us + r.windows * window_us) / r.frames;
+            float skipped = r.stats.tiles_checked ? 100.0f * r.stats.tiles_skipped / r.stats.tiles_checked : 0.0f;
+
+            // The counters must tell the failed allocations apart
+            bool counters_ok = true;
+            if (mode == REPLAY_MODE_NOMIRROR) counters_ok = r.stats.unverified_skips == r.stats.tiles_skipped;
+            else counters_ok = r.stats.unverified_skips == 0;
+            if (mode == REPLAY_MODE_UNHASHED) counters_ok = counters_ok && r.stats.unhashed_flushes > 0 && r.stats.tiles_skipped == 0;
+            else counters_ok = counters_ok && r.stats.unhashed_flushes == 0;
+
+            printf("%-10s %-9s %7.1f%% %10.1f %9.1f %9.0f %9.1f %8s %s\n", replay_scene_names[scene],
+                   replay_mode_names[mode], skipped, r.bytes / 1024.0f / r.frames, (float)r.windows / r.frames, qspi_us,
+                   r.diff_ns / 1000.0f / r.frames, r.bad_frames ? "STALE" : "ok", counters_ok ? "ok" : "WRONG");
+            if (r.bad_frames || !counters_ok) failures++;
+        }
+        printf("\n");
+    }
+
+    printf("%s\n", failures ? "FAILED" : "All frames match the reference");
+    return failures ? 1 : 0;
+}
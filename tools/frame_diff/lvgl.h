@@ -0,0 +1,32 @@
+/*
+ * Host LVGL types for the frame diff replay
+ * Just what include/utils/FrameDiff.h needs: the area and 16 bit color
+ * types, the driver type of the rounder callback and the min/max macros.
+ */
+
+#ifndef FRAME_DIFF_LVGL_H
+#define FRAME_DIFF_LVGL_H
+
+#include <stdint.h>
+
+typedef int16_t lv_coord_t;
+
+typedef struct {
+    lv_coord_t x1;
+    lv_coord_t y1;
+    lv_coord_t x2;
+    lv_coord_t y2;
+} lv_area_t;
+
+// LV_COLOR_DEPTH 16 with LV_COLOR_16_SWAP: the byte order doesn't matter to the diff
+typedef union {
+    uint16_t full;
+} lv_color_t;
+
+typedef struct _lv_disp_drv_t lv_disp_drv_t;
+
+#define LV_MIN(a, b) ((a) < (b) ? (a) : (b))
+#define LV_MAX(a, b) ((a) > (b) ? (a) : (b))
+#define LV_UNUSED(x) ((void)x)
+
+#endif // FRAME_DIFF_LVGL_H
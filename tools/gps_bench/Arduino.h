@@ -0,0 +1,31 @@
+/*
+ * Host Arduino core for the TinyGPSPlus benchmark
+ * Just what TinyGPS++.cpp needs: millis() from the monotonic clock and the
+ * math helpers of Arduino.h.
+ */
+
+#ifndef GPS_BENCH_ARDUINO_H
+#define GPS_BENCH_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <time.h>
+
+typedef uint8_t byte;
+
+#define PI 3.1415926535897932384626433832795
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+#define sq(x) ((x) * (x))
+
+static inline uint32_t millis(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+#endif // GPS_BENCH_ARDUINO_H
@@ -0,0 +1,149 @@
+/*
+ * NMEA Generator - Receiver output for the TinyGPSPlus benchmark
+ * Builds the sentences a multi-constellation receiver sends every epoch
+ * (10 Hz by default): RMC, VTG, GGA, one GSA per system, GSV for GPS,
+ * GLONASS, Galileo and BeiDou, GLL and a ZDA once a second, with correct
+ * checksums, along a track around a fixed point. Optionally corrupts a
+ * byte in some sentences (the checksum then fails), drops the fix for a
+ * while (status V, quality 0) and mixes in line noise: random bytes, cut
+ * off sentences, terms longer than a parser keeps, lowercase checksums and
+ * a sentence of 300 terms (past a uint8_t term counter).
+ *
+ * Usage:
+ *   nmeagen_t gen;
+ *   nmeagen_init(&gen, 10, 1);                  // 10 Hz, seed 1
+ *   gen.corrupt_every = 50;                     // about one in 50 sentences
+ *   std::string out;
+ *   for (int i = 0; i < 600; i++) nmeagen_epoch(&gen, &out);
+ */
+
+#ifndef NMEAGEN_H
+#define NMEAGEN_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <string>
+
+typedef struct {
+    uint32_t rate_hz;
+    uint32_t epoch;
+    uint32_t seed;
+    uint32_t corrupt_every;   // 0: never
+    uint32_t no_fix_every;    // seconds, 0: always a fix
+    uint32_t noise_every;     // seconds, 0: no line noise
+    uint32_t sentences;
+} nmeagen_t;
+
+static inline void nmeagen_init(nmeagen_t* g, uint32_t rate_hz, uint32_t seed) {
+    memset(g, 0, sizeof(*g));
+    g->rate_hz = rate_hz;
+    g->seed = seed;
+}
+
+static inline uint32_t nmeagen_random(nmeagen_t* g, uint32_t n) {
+    g->seed = g->seed * 1103515245u + 12345u;
+    return n ? (g->seed >> 8) % n : 0;
+}
+
+// Appends "$<body>*CS\r\n"
+static inline void nmeagen_sentence(nmeagen_t* g, std::string* out, const char* body) {
+    uint8_t cs = 0;
+    for (const char* p = body; *p; p++) cs ^= (uint8_t)*p;
+    char tail[8];
+    snprintf(tail, sizeof(tail), "*%02X\r\n", cs);
+    std::string s = std::string("$") + body + tail;
+    g->sentences++;
+    if (g->corrupt_every && nmeagen_random(g, g->corrupt_every) == 0) {
+        size_t pos = 1 + nmeagen_random(g, (uint32_t)strlen(body));
+        s[pos] = (s[pos] == '5') ? '6' : '5';
+    }
+    *out += s;
+}
+
+static inline void nmeagen_ddmm(char* buf, size_t size, double deg, int deg_digits) {
+    double a = fabs(deg);
+    int d = (int)a;
+    double m = (a - d) * 60.0;
+    snprintf(buf, size, "%0*d%08.5f", deg_digits, d, m);
+}
+
+static inline void nmeagen_gsv(nmeagen_t* g, std::string* out, const char* talker, uint32_t sats, uint32_t first_prn) {
+    uint32_t msgs = (sats + 3) / 4;
+    for (uint32_t m = 0; m < msgs; m++) {
+        char body[160];
+        int n = snprintf(body, sizeof(body), "%sGSV,%u,%u,%02u", talker, msgs, m + 1, sats);
+        for (uint32_t i = m * 4; i < sats && i < m * 4 + 4; i++) {
+            n += snprintf(body + n, sizeof(body) - n, ",%02u,%02u,%03u,%02u", first_prn + i,
+                          5 + nmeagen_random(g, 80), nmeagen_random(g, 360), 15 + nmeagen_random(g, 35));
+        }
+        snprintf(body + n, sizeof(body) - n, ",1");
+        nmeagen_sentence(g, out, body);
+    }
+}
+
+// Appends line noise
+static inline void nmeagen_noise(nmeagen_t* g, std::string* out) {
+    for (uint32_t i = 0, n = nmeagen_random(g, 64); i < n; i++) *out += (char)nmeagen_random(g, 256);
+    *out += "$GNGGA,120000.00,4722.61";   // cut off by the next '$'
+    *out += "$GPGSV,3,1,12,05,70,123,456789012345678901234567,*00\r\n";
+    std::string body = "GPTXT";
+    for (int i = 0; i < 300; i++) body += ",7";
+    nmeagen_sentence(g, out, body.c_str());
+    nmeagen_sentence(g, out, "GNGGA,120000.00,4722.61400,N,00832.50200,E,1,08,1.01,400.0,M,48.0,M,,");
+    size_t star = out->rfind('*');
+    for (size_t i = star + 1; i < star + 3; i++) (*out)[i] = (char)tolower((*out)[i]);
+}
+
+// Appends one epoch of output
+static inline void nmeagen_epoch(nmeagen_t* g, std::string* out) {
+    double t = (double)g->epoch / g->rate_hz;
+    uint32_t cs = (uint32_t)(t * 100) % 100;
+    uint32_t secs = 12 * 3600 + (uint32_t)t;
+    char hms[16], date[8] = "180426", lat[32], lng[32], body[200];
+    snprintf(hms, sizeof(hms), "%02u%02u%02u.%02u", secs / 3600 % 24, secs / 60 % 60, secs % 60, cs);
+
+    double la = 47.3769 + 0.001 * sin(t / 60.0), lo = 8.5417 + 0.001 * cos(t / 60.0);
+    nmeagen_ddmm(lat, sizeof(lat), la, 2);
+    nmeagen_ddmm(lng, sizeof(lng), lo, 3);
+    bool fix = !(g->no_fix_every && (g->epoch / g->rate_hz) % g->no_fix_every == g->no_fix_every - 1);
+    double knots = 2.0 + 1.5 * sin(t / 7.0), course = fmod(t * 3.0, 360.0);
+
+    snprintf(body, sizeof(body), "GNRMC,%s,%c,%s,N,%s,E,%.3f,%.2f,%s,,,%c,V", hms, fix ? 'A' : 'V', lat, lng, knots, course, date, fix ? 'A' : 'N');
+    nmeagen_sentence(g, out, body);
+    snprintf(body, sizeof(body), "GNVTG,%.2f,T,,M,%.3f,N,%.3f,K,%c", course, knots, knots * 1.852, fix ? 'A' : 'N');
+    nmeagen_sentence(g, out, body);
+    snprintf(body, sizeof(body), "GNGGA,%s,%s,N,%s,E,%d,%02u,%.2f,%.1f,M,48.0,M,,", hms, lat, lng, fix ? 1 : 0,
+             fix ? 18 + nmeagen_random(g, 6) : 0, 0.6 + nmeagen_random(g, 40) / 100.0, 408.0 + 3 * sin(t / 30.0));
+    nmeagen_sentence(g, out, body);
+
+    static const char* const sys_ids[4] = {"1", "2", "3", "4"};
+    for (int s = 0; s < 4; s++) {
+        int n = snprintf(body, sizeof(body), "GNGSA,A,%d", fix ? 3 : 1);
+        for (int i = 0; i < 12; i++) {
+            if (fix && i < 6 + s) n += snprintf(body + n, sizeof(body) - n, ",%02d", 1 + s * 30 + i);
+            else n += snprintf(body + n, sizeof(body) - n, ",");
+        }
+        snprintf(body + n, sizeof(body) - n, ",1.%02u,0.%02u,0.%02u,%s", nmeagen_random(g, 100), 50 + nmeagen_random(g, 50),
+                 50 + nmeagen_random(g, 50), sys_ids[s]);
+        nmeagen_sentence(g, out, body);
+    }
+
+    nmeagen_gsv(g, out, "GP", 12, 1);
+    nmeagen_gsv(g, out, "GL", 8, 65);
+    nmeagen_gsv(g, out, "GA", 9, 1);
+    nmeagen_gsv(g, out, "GB", 10, 1);
+
+    snprintf(body, sizeof(body), "GNGLL,%s,N,%s,E,%s,%c,%c", lat, lng, hms, fix ? 'A' : 'V', fix ? 'A' : 'N');
+    nmeagen_sentence(g, out, body);
+    if (g->epoch % g->rate_hz == 0) {
+        snprintf(body, sizeof(body), "GNZDA,%s,18,04,2026,00,00", hms);
+        nmeagen_sentence(g, out, body);
+        if (g->noise_every && (g->epoch / g->rate_hz) % g->noise_every == g->noise_every - 1) nmeagen_noise(g, out);
+    }
+    g->epoch++;
+}
+
+#endif // NMEAGEN_H
@@ -0,0 +1,226 @@
+/*
+ * NMEA Benchmark - TinyGPSPlus block encode() against encode(char)
+ * Feeds the same receiver output to two parsers, one character at a time and
+ * in blocks of random size, checks after every block that both hold the same
+ * fixes, counters and custom field values, then times both:
+ *
+ *   char    encode(c) for every character, as a UART loop does
+ *   block   encode(buf, len) with what a UART read returns (64, 256 bytes)
+ *           and with the whole capture at once
+ *
+ * Each runs without custom fields, with the custom fields of a satellite
+ * view (GSV, GSA, VTG, GLL, ZDA: 8 sentence names, all in the hash index)
+ * and with more names than the index holds (the sorted list walk).
+ *
+ * The built-in output is NmeaGen.h at 10 Hz, one corrupted sentence in 50,
+ * a lost fix every 20 s and line noise every 5 s; captures of receiver
+ * output can be given too.
+ *
+ * Build (from the project root):
+ *   g++ -O2 -DARDUINO=10819 -Itools/gps_bench -Ilib/TinyGPSPlus/src \
+ *       tools/gps_bench/nmea_bench.cpp lib/TinyGPSPlus/src/TinyGPS++.cpp -o nmea_bench
+ *
+ * Usage:
+ *   ./nmea_bench                         # 600 s of built-in output
+ *   ./nmea_bench --seconds 60 --seed 3
+ *   ./nmea_bench capture.nmea ...
+ */
+
+#include "Arduino.h"
+#include "TinyGPS++.h"
+#include "NmeaGen.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// Timing runs over the capture, for a stable figure
+#define BENCH_REPEAT 20
+
+typedef struct {
+    const char* sentence;
+    int term;
+} bench_field_t;
+
+static const bench_field_t bench_fields_view[] = {
+    {"GPGSV", 3}, {"GPGSV", 4}, {"GLGSV", 3}, {"GAGSV", 3}, {"GBGSV", 3},
+    {"GNGSA", 2}, {"GNGSA", 15}, {"GNGSA", 16}, {"GNGSA", 17}, {"GNGSA", 18},
+    {"GNVTG", 7}, {"GNGLL", 6}, {"GNZDA", 2}, {"GNZDA", 3}, {"GNZDA", 4},
+};
+
+// Past the 8 names of the index: the list walk
+static const bench_field_t bench_fields_many[] = {
+    {"GPGSV", 3}, {"GLGSV", 3}, {"GAGSV", 3}, {"GBGSV", 3}, {"GNGSA", 15},
+    {"GNVTG", 7}, {"GNGLL", 6}, {"GNZDA", 4}, {"GNGNS", 7}, {"GPTXT", 4},
+    {"GNRMC", 12}, {"GNGGA", 11},
+};
+
+typedef struct {
+    const char* name;
+    const bench_field_t* fields;
+    size_t count;
+} bench_config_t;
+
+static const bench_config_t bench_configs[] = {
+    {"no custom fields", NULL, 0},
+    {"satellite view (8 names)", bench_fields_view, sizeof(bench_fields_view) / sizeof(bench_fields_view[0])},
+    {"12 names (list walk)", bench_fields_many, sizeof(bench_fields_many) / sizeof(bench_fields_many[0])},
+};
+
+typedef struct {
+    TinyGPSPlus gps;
+    std::vector<TinyGPSCustom> custom;
+} bench_parser_t;
+
+static void bench_parser_init(bench_parser_t* p, const bench_config_t* cfg) {
+    p->custom.resize(cfg->count);   // Never resized again: the parser keeps pointers to them
+    for (size_t i = 0; i < cfg->count; i++) p->custom[i].begin(p->gps, cfg->fields[i].sentence, cfg->fields[i].term);
+}
+
+// Everything a sketch can read, reading it (which clears the updated flags)
+static std::string bench_state(bench_parser_t* p) {
+    TinyGPSPlus& g = p->gps;
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+             "chars %u fix %u pass %u fail %u | loc %d%d %u.%u%d %u.%u%d | date %d%d %u | time %d%d %u | "
+             "speed %d%d %d | course %d%d %d | alt %d%d %d | sats %d%d %u | hdop %d%d %d",
+             g.charsProcessed(), g.sentencesWithFix(), g.passedChecksum(), g.failedChecksum(),
+             g.location.isValid(), g.location.isUpdated(), g.location.rawLat().deg, g.location.rawLat().billionths,
+             g.location.rawLat().negative, g.location.rawLng().deg, g.location.rawLng().billionths, g.location.rawLng().negative,
+             g.date.isValid(), g.date.isUpdated(), g.date.value(), g.time.isValid(), g.time.isUpdated(), g.time.value(),
+             g.speed.isValid(), g.speed.isUpdated(), g.speed.value(), g.course.isValid(), g.course.isUpdated(), g.course.value(),
+             g.altitude.isValid(), g.altitude.isUpdated(), g.altitude.value(), g.satellites.isValid(), g.satellites.isUpdated(),
+             g.satellites.value(), g.hdop.isValid(), g.hdop.isUpdated(), g.hdop.value());
+    std::string s = buf;
+    for (size_t i = 0; i < p->custom.size(); i++) {
+        TinyGPSCustom& c = p->custom[i];
+        snprintf(buf, sizeof(buf), " | %d%d %s", c.isValid(), c.isUpdated(), c.value());
+        s += buf;
+    }
+    return s;
+}
+
+static uint32_t bench_rand = 1;
+
+static uint32_t bench_random(uint32_t n) {
+    bench_rand = bench_rand * 1103515245u + 12345u;
+    return (bench_rand >> 8) % n;
+}
+
+// encode(char) against encode(buf, len) in random blocks, state compared after every block
+static bool bench_check(const std::string& data, const bench_config_t* cfg, uint32_t* sentences) {
+    bench_parser_t a, b;
+    bench_parser_init(&a, cfg);
+    bench_parser_init(&b, cfg);
+    size_t valid_a = 0, valid_b = 0, blocks = 0;
+    for (size_t pos = 0; pos < data.size(); blocks++) {
+        size_t len = 1 + bench_random(blocks % 4 == 0 ? 8 : 300);
+        if (len > data.size() - pos) len = data.size() - pos;
+        for (size_t i = 0; i < len; i++) valid_a += a.gps.encode(data[pos + i]);
+        valid_b += b.gps.encode(data.data() + pos, len);
+        pos += len;
+        std::string sa = bench_state(&a), sb = bench_state(&b);
+        if (valid_a != valid_b || sa != sb) {
+            printf("  MISMATCH after %zu bytes (valid sentences %zu / %zu)\n    char:  %s\n    block: %s\n", pos, valid_a, valid_b,
+                   sa.c_str(), sb.c_str());
+            return false;
+        }
+    }
+    *sentences = (uint32_t)valid_a;
+    return true;
+}
+
+static double bench_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// MB/s of one way of feeding the parser, block 0: one character at a time
+static double bench_time(const std::string& data, const bench_config_t* cfg, size_t block) {
+    double best = 0;
+    for (int r = 0; r < BENCH_REPEAT; r++) {
+        bench_parser_t p;
+        bench_parser_init(&p, cfg);
+        size_t valid = 0;
+        double start = bench_seconds();
+        if (block == 0) {
+            for (size_t i = 0; i < data.size(); i++) valid += p.gps.encode(data[i]);
+        } else {
+            for (size_t pos = 0; pos < data.size(); pos += block) {
+                valid += p.gps.encode(data.data() + pos, block < data.size() - pos ? block : data.size() - pos);
+            }
+        }
+        double mbs = data.size() / (bench_seconds() - start) / 1e6;
+        if (mbs > best) best = mbs;
+        if (valid == 0 && data.size() > 1000) fprintf(stderr, "no valid sentence\n");
+    }
+    return best;
+}
+
+static bool bench_run(const char* name, const std::string& data) {
+    bool ok = true;
+    printf("%s: %zu bytes\n", name, data.size());
+    for (size_t c = 0; c < sizeof(bench_configs) / sizeof(bench_configs[0]); c++) {
+        const bench_config_t* cfg = &bench_configs[c];
+        uint32_t sentences = 0;
+        bool same = bench_check(data, cfg, &sentences);
+        ok &= same;
+        double per_char = bench_time(data, cfg, 0);
+        double b64 = bench_time(data, cfg, 64);
+        double b256 = bench_time(data, cfg, 256);
+        double whole = bench_time(data, cfg, data.size());
+        printf("  %-26s %s (%u valid)  char %7.1f MB/s  block 64 %7.1f  256 %7.1f  all %7.1f  (x%.2f)\n", cfg->name,
+               same ? "same" : "DIFFERENT", sentences, per_char, b64, b256, whole, b256 / per_char);
+    }
+    return ok;
+}
+
+static bool bench_load(const char* path, std::string* data) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data->append(buf, n);
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    uint32_t seconds = 600;
+    uint32_t seed = 1;
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = atoi(argv[++i]);
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: %s [--seconds N] [--seed N] [capture ...]\n", argv[0]);
+            return 2;
+        } else files.push_back(argv[i]);
+    }
+
+    bool ok = true;
+    bench_rand = seed;
+    if (files.empty()) {
+        nmeagen_t gen;
+        nmeagen_init(&gen, 10, seed);
+        gen.corrupt_every = 50;
+        gen.no_fix_every = 20;
+        gen.noise_every = 5;
+        std::string data;
+        for (uint32_t i = 0; i < seconds * gen.rate_hz; i++) nmeagen_epoch(&gen, &data);
+        char name[64];
+        snprintf(name, sizeof(name), "built-in, %u s at %u Hz, %u sentences", seconds, gen.rate_hz, gen.sentences);
+        ok &= bench_run(name, data);
+    }
+    for (size_t i = 0; i < files.size(); i++) {
+        std::string data;
+        if (!bench_load(files[i], &data)) {
+            fprintf(stderr, "can't read %s\n", files[i]);
+            return 1;
+        }
+        ok &= bench_run(files[i], data);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,424 @@
+/*
+ * NMEA Replay - Checks the TinyGPSPlus fix records and sentence callback
+ * Replays receiver output (NmeaGen.h, the stream of the library's
+ * BasicExample, or captures given on the command line) into the parser three
+ * ways: encode(c), encode(buf, len) in random blocks and the whole capture
+ * in one block, and checks:
+ *
+ *   sentences  the callback sees every sentence with a checksum, with the
+ *              right text and verdict (from a scan of the raw bytes that
+ *              follows NMEA framing on its own), the same all three ways,
+ *              and without a copy when the sentence is inside the block
+ *   fixes      one record per epoch, with the fields of that epoch's RMC and
+ *              GGA (read from the sentences with sscanf), versioned and
+ *              numbered without gaps, the same all three ways
+ *   snapshot   a reader thread calling getFix() while another thread runs
+ *              encode() only ever gets records the parser published, whole
+ *
+ * BasicExample's stream also has known answers for its first records.
+ *
+ * Build (from the project root):
+ *   g++ -O2 -pthread -DARDUINO=10819 -Itools/gps_bench -Ilib/TinyGPSPlus/src \
+ *       tools/gps_bench/nmea_replay.cpp lib/TinyGPSPlus/src/TinyGPS++.cpp -o nmea_replay
+ *
+ * Usage:
+ *   ./nmea_replay                        # built-in output, 300 s
+ *   ./nmea_replay capture.nmea ...       # and these
+ * Exits non-zero on the first failed check.
+ */
+
+#include "Arduino.h"
+#include "TinyGPS++.h"
+#include "NmeaGen.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+
+// Stream of lib/TinyGPSPlus/examples/BasicExample: its RMC and GGA are a
+// second apart, so every record holds one of them
+static const char* const replay_basic_stream =
+    "$GPRMC,045103.000,A,3014.1984,N,09749.2872,W,0.67,161.46,030913,,,A*7C\r\n"
+    "$GPGGA,045104.000,3014.1985,N,09749.2873,W,1,09,1.2,211.6,M,-22.5,M,,0000*62\r\n"
+    "$GPRMC,045200.000,A,3014.3820,N,09748.9514,W,36.88,65.02,030913,,,A*77\r\n"
+    "$GPGGA,045201.000,3014.3864,N,09748.9411,W,1,10,1.2,200.8,M,-22.5,M,,0000*6C\r\n"
+    "$GPRMC,045251.000,A,3014.4275,N,09749.0626,W,0.51,217.94,030913,,,A*7D\r\n"
+    "$GPGGA,045252.000,3014.4273,N,09749.0628,W,1,09,1.3,206.9,M,-22.5,M,,0000*6F\r\n";
+
+static int replay_failures = 0;
+
+#define REPLAY_CHECK(cond, ...)                         \
+    do {                                                \
+        if (!(cond)) {                                  \
+            printf("  FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__);                        \
+            printf("\n");                               \
+            replay_failures++;                          \
+            return false;                               \
+        }                                               \
+    } while (0)
+
+typedef struct {
+    std::string text;
+    bool valid;
+    bool in_block;           // Pointed into the data given to encode()
+} replay_sentence_t;
+
+typedef struct {
+    const std::string* data;
+    std::vector<replay_sentence_t> sentences;
+    std::vector<TinyGPSFix> fixes;
+    const char* block_start;
+    size_t block_len;
+} replay_log_t;
+
+static void replay_on_sentence(const char* sentence, size_t len, bool valid, void* arg) {
+    replay_log_t* log = (replay_log_t*)arg;
+    replay_sentence_t s;
+    s.text.assign(sentence, len);
+    s.valid = valid;
+    s.in_block = log->block_start && sentence >= log->block_start && sentence < log->block_start + log->block_len;
+    log->sentences.push_back(s);
+}
+
+static void replay_on_fix(const TinyGPSFix& fix, void* arg) {
+    ((replay_log_t*)arg)->fixes.push_back(fix);
+}
+
+static uint32_t replay_rand = 1;
+
+static uint32_t replay_random(uint32_t n) {
+    replay_rand = replay_rand * 1103515245u + 12345u;
+    return (replay_rand >> 8) % n;
+}
+
+// mode 0: encode(c), 1: random blocks, 2: all at once
+static void replay_feed(const std::string& data, int mode, replay_log_t* log) {
+    TinyGPSPlus gps;
+    log->data = &data;
+    log->block_start = NULL;
+    log->block_len = 0;
+    gps.onSentence(replay_on_sentence, log);
+    gps.onFix(replay_on_fix, log);
+    if (mode == 0) {
+        for (size_t i = 0; i < data.size(); i++) gps.encode(data[i]);
+        return;
+    }
+    for (size_t pos = 0; pos < data.size();) {
+        size_t len = mode == 2 ? data.size() : 1 + replay_random(replay_random(4) == 0 ? 8 : 200);
+        if (len > data.size() - pos) len = data.size() - pos;
+        log->block_start = data.data() + pos;
+        log->block_len = len;
+        gps.encode(data.data() + pos, len);
+        pos += len;
+    }
+}
+
+// Sentences by NMEA framing: '$', terms up to '*', the checksum term up to
+// the next delimiter; a '$' anywhere starts over
+static int replay_hex(char a) {
+    if (a >= 'A' && a <= 'F') return a - 'A' + 10;
+    if (a >= 'a' && a <= 'f') return a - 'a' + 10;
+    return a - '0';
+}
+
+static std::vector<replay_sentence_t> replay_expected_sentences(const std::string& d) {
+    std::vector<replay_sentence_t> out;
+    size_t i = d.find('$');
+    while (i != std::string::npos) {
+        size_t j = i + 1;
+        uint8_t parity = 0;
+        while (j < d.size() && d[j] != '*' && d[j] != '$') {
+            if (d[j] != '\r' && d[j] != '\n') parity ^= (uint8_t)d[j];
+            j++;
+        }
+        if (j >= d.size()) break;
+        if (d[j] == '$') { i = j; continue; }
+        size_t k = j + 1;
+        while (k < d.size() && d[k] != ',' && d[k] != '\r' && d[k] != '\n' && d[k] != '*' && d[k] != '$') k++;
+        if (k >= d.size()) break;
+        if (d[k] == '$') { i = k; continue; }
+        char t0 = k > j + 1 ? d[j + 1] : 0, t1 = k > j + 2 ? d[j + 2] : 0;
+        uint8_t checksum = (uint8_t)(16 * replay_hex(t0) + replay_hex(t1));
+        if (k - i <= _GPS_MAX_SENTENCE_SIZE) {
+            replay_sentence_t s = {d.substr(i, k - i), checksum == parity, false};
+            out.push_back(s);
+        }
+        i = d.find('$', k);
+    }
+    return out;
+}
+
+// Fix records from the valid RMC/GGA sentences, the way the parser groups
+// them. Empty fields keep the last value, as the parser does.
+typedef struct {
+    std::string field[20];
+    int count;
+} replay_fields_t;
+
+static replay_fields_t replay_split(const std::string& s) {
+    replay_fields_t f;
+    f.count = 0;
+    size_t star = s.find('*');
+    std::string body = s.substr(1, star - 1);
+    size_t pos = 0;
+    while (f.count < 20) {
+        size_t comma = body.find(',', pos);
+        f.field[f.count++] = body.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    return f;
+}
+
+static int32_t replay_degrees(const std::string& f, bool negative) {
+    double v = atof(f.c_str());
+    double deg = floor(v / 100) + fmod(v, 100) / 60.0;
+    int32_t r = (int32_t)floor(deg * 1e7 + 0.5);
+    return negative ? -r : r;
+}
+
+static int32_t replay_hundredths(const std::string& f) {
+    double v = atof(f.c_str());
+    return (int32_t)(v < 0 ? -floor(-v * 100 + 1e-6) : floor(v * 100 + 1e-6));
+}
+
+static std::vector<TinyGPSFix> replay_expected_fixes(const std::vector<replay_sentence_t>& sentences) {
+    std::vector<TinyGPSFix> out;
+    TinyGPSFix st;
+    memset(&st, 0, sizeof(st));
+    // Latest non-empty fields
+    std::string time_f, date_f, lat_f, lat_h, lng_f, lng_h, speed_f, course_f, alt_f, sats_f, hdop_f;
+    uint32_t last_sequence = 0;
+
+    for (size_t n = 0; n < sentences.size(); n++) {
+        if (!sentences[n].valid) continue;
+        replay_fields_t f = replay_split(sentences[n].text);
+        const std::string& name = f.field[0];
+        bool rmc = name == "GPRMC" || name == "GNRMC";
+        bool gga = name == "GPGGA" || name == "GNGGA";
+        if (!rmc && !gga) continue;
+
+#define LATEST(var, idx) if (f.count > (idx) && !f.field[idx].empty()) var = f.field[idx]
+        LATEST(time_f, 1);
+        bool fix;
+        if (rmc) {
+            fix = f.count > 2 && f.field[2][0] == 'A';
+            LATEST(lat_f, 3); LATEST(lat_h, 4); LATEST(lng_f, 5); LATEST(lng_h, 6);
+            LATEST(speed_f, 7); LATEST(course_f, 8); LATEST(date_f, 9);
+        } else {
+            fix = f.count > 6 && !f.field[6].empty() && f.field[6][0] > '0';
+            LATEST(lat_f, 2); LATEST(lat_h, 3); LATEST(lng_f, 4); LATEST(lng_h, 5);
+            LATEST(sats_f, 7); LATEST(hdop_f, 8); LATEST(alt_f, 9);
+        }
+#undef LATEST
+        uint8_t bit = rmc ? _GPS_FIX_RMC : _GPS_FIX_GGA;
+        uint32_t t = (uint32_t)replay_hundredths(time_f);
+        if (st.sentences && (st.time != t || (st.sentences & bit))) {
+            st.sequence = ++last_sequence;
+            out.push_back(st);
+            st.sentences = st.updated = 0;
+        }
+        st.sentences |= bit;
+        st.time = t;
+        st.updated |= _GPS_FIX_TIME;
+        if (fix) {
+            st.lat = replay_degrees(lat_f, lat_h == "S");
+            st.lng = replay_degrees(lng_f, lng_h == "W");
+            st.updated |= _GPS_FIX_LOCATION;
+        }
+        if (rmc) {
+            st.date = (uint32_t)atol(date_f.c_str());
+            st.updated |= _GPS_FIX_DATE;
+            if (fix) {
+                st.speed = replay_hundredths(speed_f);
+                st.course = replay_hundredths(course_f);
+                st.updated |= _GPS_FIX_SPEED | _GPS_FIX_COURSE;
+            }
+        } else {
+            if (fix) {
+                st.altitude = replay_hundredths(alt_f);
+                st.updated |= _GPS_FIX_ALTITUDE;
+            }
+            st.satellites = (uint8_t)atol(sats_f.c_str());
+            st.hdop = replay_hundredths(hdop_f);
+            st.updated |= _GPS_FIX_SATELLITES | _GPS_FIX_HDOP;
+        }
+        if ((st.sentences & (_GPS_FIX_RMC | _GPS_FIX_GGA)) == (_GPS_FIX_RMC | _GPS_FIX_GGA)) {
+            st.sequence = ++last_sequence;
+            out.push_back(st);
+            st.sentences = st.updated = 0;
+        }
+    }
+    return out;
+}
+
+static bool replay_same_fix(const TinyGPSFix& a, const TinyGPSFix& b, bool exact) {
+    int32_t tol = exact ? 0 : 1;   // Rounding of the oracle's floating point
+    return a.sequence == b.sequence && a.sentences == b.sentences && a.updated == b.updated && a.date == b.date &&
+           a.time == b.time && labs((long)a.lat - b.lat) <= tol && labs((long)a.lng - b.lng) <= tol &&
+           labs((long)a.altitude - b.altitude) <= tol && labs((long)a.speed - b.speed) <= tol &&
+           labs((long)a.course - b.course) <= tol && a.satellites == b.satellites && a.hdop == b.hdop;
+}
+
+static void replay_print_fix(const char* what, const TinyGPSFix& f) {
+    printf("    %s: #%u s%02x u%02x %06u %08u %d %d alt %d spd %d crs %d sats %u hdop %d\n", what, f.sequence, f.sentences,
+           f.updated, f.date, f.time, f.lat, f.lng, f.altitude, f.speed, f.course, f.satellites, f.hdop);
+}
+
+static bool replay_check(const char* name, const std::string& data) {
+    replay_log_t logs[3];
+    for (int mode = 0; mode < 3; mode++) replay_feed(data, mode, &logs[mode]);
+    std::vector<replay_sentence_t> sentences = replay_expected_sentences(data);
+    std::vector<TinyGPSFix> fixes = replay_expected_fixes(sentences);
+
+    size_t valid = 0, in_block = 0;
+    for (size_t i = 0; i < sentences.size(); i++) valid += sentences[i].valid;
+    for (size_t i = 0; i < logs[1].sentences.size(); i++) in_block += logs[1].sentences[i].in_block;
+    printf("%s: %zu bytes, %zu sentences (%zu valid), %zu fixes, %.1f%% of the sentences passed without a copy in random blocks\n",
+           name, data.size(), sentences.size(), valid, fixes.size(),
+           logs[1].sentences.empty() ? 0.0 : 100.0 * in_block / logs[1].sentences.size());
+
+    for (int mode = 0; mode < 3; mode++) {
+        const replay_log_t* log = &logs[mode];
+        REPLAY_CHECK(log->sentences.size() == sentences.size(), "mode %d: %zu sentences, expected %zu", mode,
+                     log->sentences.size(), sentences.size());
+        for (size_t i = 0; i < sentences.size(); i++) {
+            REPLAY_CHECK(log->sentences[i].text == sentences[i].text && log->sentences[i].valid == sentences[i].valid,
+                         "mode %d sentence %zu: \"%s\" (%d), expected \"%s\" (%d)", mode, i, log->sentences[i].text.c_str(),
+                         log->sentences[i].valid, sentences[i].text.c_str(), sentences[i].valid);
+        }
+        // All at once: every sentence straight from the data
+        if (mode == 2) {
+            for (size_t i = 0; i < sentences.size(); i++) REPLAY_CHECK(log->sentences[i].in_block, "sentence %zu was copied", i);
+        }
+
+        REPLAY_CHECK(log->fixes.size() == fixes.size(), "mode %d: %zu fixes, expected %zu", mode, log->fixes.size(), fixes.size());
+        for (size_t i = 0; i < fixes.size(); i++) {
+            const TinyGPSFix& f = log->fixes[i];
+            if (f.version != _GPS_FIX_VERSION || !replay_same_fix(f, fixes[i], false) ||
+                (mode > 0 && !replay_same_fix(f, logs[0].fixes[i], true))) {
+                replay_print_fix("got", f);
+                replay_print_fix("expected", fixes[i]);
+                REPLAY_CHECK(false, "mode %d fix %zu differs", mode, i);
+            }
+        }
+    }
+    return true;
+}
+
+static bool replay_basic_answers() {
+    replay_log_t log;
+    std::string data = replay_basic_stream;
+    replay_feed(data, 1, &log);
+    printf("BasicExample stream: %zu fixes\n", log.fixes.size());
+    // The last GGA is still waiting for its RMC
+    REPLAY_CHECK(log.fixes.size() == 5, "%zu fixes, expected 5", log.fixes.size());
+    const TinyGPSFix& a = log.fixes[0];
+    REPLAY_CHECK(a.sequence == 1 && a.sentences == _GPS_FIX_RMC, "first record: #%u sentences %x", a.sequence, a.sentences);
+    REPLAY_CHECK(a.updated == (_GPS_FIX_LOCATION | _GPS_FIX_DATE | _GPS_FIX_TIME | _GPS_FIX_SPEED | _GPS_FIX_COURSE),
+                 "first record: updated %x", a.updated);
+    REPLAY_CHECK(a.time == 4510300 && a.date == 30913, "first record: time %u date %u", a.time, a.date);
+    // 30 deg 14.1984' N = 30.236640, 97 deg 49.2872' W = -97.8214533
+    REPLAY_CHECK(a.lat == 302366400 && a.lng == -978214533, "first record: %d %d", a.lat, a.lng);
+    REPLAY_CHECK(a.speed == 67 && a.course == 16146, "first record: speed %d course %d", a.speed, a.course);
+    const TinyGPSFix& b = log.fixes[1];
+    REPLAY_CHECK(b.sentences == _GPS_FIX_GGA && b.time == 4510400 && b.satellites == 9 && b.hdop == 120 && b.altitude == 21160,
+                 "second record: sentences %x time %u sats %u hdop %d alt %d", b.sentences, b.time, b.satellites, b.hdop, b.altitude);
+    REPLAY_CHECK(b.lat == 302366417 && b.lng == -978214550, "second record: %d %d", b.lat, b.lng);
+    REPLAY_CHECK(b.date == 30913 && b.speed == 67 && !(b.updated & (_GPS_FIX_DATE | _GPS_FIX_SPEED)),
+                 "second record keeps the older RMC fields, marked as older");
+    return true;
+}
+
+// One thread encodes, one reads getFix(); every record read must be one that
+// was published, byte for byte
+static bool replay_snapshot(const std::string& data, uint32_t passes) {
+    const size_t max_fixes = 1 << 20;
+    std::vector<TinyGPSFix> published(max_fixes);
+    std::atomic<bool> done(false);
+    uint64_t reads = 0, changes = 0, torn = 0, backwards = 0;
+
+    TinyGPSPlus gps;
+    struct Publish {
+        static void on_fix(const TinyGPSFix& fix, void* arg) {
+            std::vector<TinyGPSFix>* v = (std::vector<TinyGPSFix>*)arg;
+            if (fix.sequence < v->size()) (*v)[fix.sequence] = fix;
+        }
+    };
+    gps.onFix(Publish::on_fix, &published);
+
+    std::vector<TinyGPSFix> seen;
+    seen.reserve(max_fixes);
+    std::thread reader([&]() {
+        uint32_t last = 0;
+        TinyGPSFix f;
+        while (!done.load()) {
+            reads++;
+            if (!gps.getFix(f)) continue;
+            if (f.sequence < last) backwards++;
+            if (f.sequence != last && seen.size() < max_fixes) {
+                seen.push_back(f);
+                changes++;
+            }
+            last = f.sequence;
+            std::this_thread::yield();
+        }
+    });
+    for (uint32_t p = 0; p < passes; p++) {
+        for (size_t pos = 0; pos < data.size(); pos += 64) {
+            gps.encode(data.data() + pos, data.size() - pos < 64 ? data.size() - pos : 64);
+            std::this_thread::yield();   // Hand over often, even on one core
+        }
+    }
+    done.store(true);
+    reader.join();
+
+    for (size_t i = 0; i < seen.size(); i++) {
+        if (seen[i].sequence >= max_fixes || memcmp(&seen[i], &published[seen[i].sequence], sizeof(TinyGPSFix)) != 0) torn++;
+    }
+    printf("snapshot: %llu reads, %llu records seen, %llu torn, %llu out of order\n", (unsigned long long)reads,
+           (unsigned long long)changes, (unsigned long long)torn, (unsigned long long)backwards);
+    REPLAY_CHECK(torn == 0 && backwards == 0, "getFix() returned a record that was never published");
+    REPLAY_CHECK(changes > 0, "the reader saw no record");
+    return true;
+}
+
+static bool replay_load(const char* path, std::string* data) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data->append(buf, n);
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    nmeagen_t gen;
+    nmeagen_init(&gen, 10, 1);
+    gen.corrupt_every = 50;
+    gen.no_fix_every = 20;
+    gen.noise_every = 5;
+    std::string generated;
+    for (uint32_t i = 0; i < 300 * gen.rate_hz; i++) nmeagen_epoch(&gen, &generated);
+
+    replay_basic_answers();
+    replay_check("BasicExample stream", replay_basic_stream);
+    replay_check("built-in, 300 s at 10 Hz", generated);
+    for (int i = 1; i < argc; i++) {
+        std::string data;
+        if (!replay_load(argv[i], &data)) {
+            fprintf(stderr, "can't read %s\n", argv[i]);
+            return 2;
+        }
+        replay_check(argv[i], data);
+    }
+    replay_snapshot(generated, 3);
+
+    printf(replay_failures ? "FAILED\n" : "all passed\n");
+    return replay_failures ? 1 : 0;
+}
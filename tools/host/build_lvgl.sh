@@ -0,0 +1,30 @@
+#!/bin/sh
+# Build lib/lvgl-8.3.5 for the host tools with tools/host/lv_conf.h
+# Usage (from the project root): [CC=gcc] [CFLAGS=-O2] [BUILD=build_host] tools/host/build_lvgl.sh
+set -e
+
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:--O2}
+BUILD=${BUILD:-build_host}
+LVGL=lib/lvgl-8.3.5
+JOBS=$(nproc 2>/dev/null || echo 4)
+
+mkdir -p "$BUILD/obj"
+find "$LVGL/src" -name '*.c' | sort > "$BUILD/srcs.txt"
+
+# One object per source, named after its path; rebuild what is older than its source or the configs
+: > "$BUILD/objs.txt"
+: > "$BUILD/todo.txt"
+while read -r src; do
+    obj="$BUILD/obj/$(echo "$src" | sed "s#^$LVGL/##; s#/#_#g").o"
+    echo "$obj" >> "$BUILD/objs.txt"
+    if [ ! -f "$obj" ] || [ "$src" -nt "$obj" ] || [ tools/host/lv_conf.h -nt "$obj" ] || [ "$LVGL/lv_conf.h" -nt "$obj" ]; then
+        echo "$src $obj" >> "$BUILD/todo.txt"
+    fi
+done < "$BUILD/srcs.txt"
+
+xargs -P "$JOBS" -n 2 sh -c '"$0" '"$CFLAGS"' -DLV_CONF_INCLUDE_SIMPLE -Itools/host -I'"$LVGL"' -c "$1" -o "$2"' "$CC" < "$BUILD/todo.txt"
+
+rm -f "$BUILD/liblvgl.a"
+ar rcs "$BUILD/liblvgl.a" $(cat "$BUILD/objs.txt")
+echo "$BUILD/liblvgl.a: $(wc -l < "$BUILD/objs.txt") objects, $(wc -l < "$BUILD/todo.txt") rebuilt"
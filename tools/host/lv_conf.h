@@ -0,0 +1,45 @@
+/*
+ * Host lv_conf.h - The project's LVGL configuration for Linux host tools
+ * Includes lib/lvgl-8.3.5/lv_conf.h and replaces only what needs the ESP32:
+ * PSRAM and heap_caps become malloc and "not available", the tick comes
+ * from lv_tick_inc() (e.g. sim_clock_set_tick_cb(lv_tick_inc)) and a failed
+ * assert aborts instead of spinning. Everything else, including the render
+ * cache, the pools and the fonts, is the device configuration.
+ *
+ * Build LVGL with it once (from the project root):
+ *   tools/host/build_lvgl.sh                  # -> build_host/liblvgl.a
+ *   CFLAGS="-O1 -g -fsanitize=address,undefined" BUILD=build_host_asan tools/host/build_lvgl.sh
+ *
+ * Tools then compile with:
+ *   -DLV_CONF_INCLUDE_SIMPLE -DLV_LVGL_H_INCLUDE_SIMPLE -Itools/host -Ilib/lvgl-8.3.5 -Ilib/lvgl-8.3.5/src
+ *   ... build_host/liblvgl.a -lm
+ */
+
+#ifndef HOST_LV_CONF_H
+#define HOST_LV_CONF_H
+
+#include "../../lib/lvgl-8.3.5/lv_conf.h"
+
+// No PSRAM: large buffers come from malloc too
+#undef LV_MEM_CUSTOM_LARGE_INCLUDE
+#undef LV_MEM_CUSTOM_LARGE_ALLOC
+#define LV_MEM_CUSTOM_LARGE_INCLUDE <stdlib.h>
+#define LV_MEM_CUSTOM_LARGE_ALLOC   malloc
+
+// No heap_caps: lv_mem_monitor() reports only the pools
+#undef LV_MEM_CUSTOM_MONITOR_INCLUDE
+#undef LV_MEM_CUSTOM_TOTAL_SIZE
+#undef LV_MEM_CUSTOM_FREE_SIZE
+#undef LV_MEM_CUSTOM_BIGGEST_FREE_SIZE
+#undef LV_MEM_CUSTOM_MIN_FREE_SIZE
+
+// No Arduino.h in the C files: the tool drives lv_tick_inc()
+#undef LV_TICK_CUSTOM
+#define LV_TICK_CUSTOM 0
+
+#undef LV_ASSERT_HANDLER_INCLUDE
+#undef LV_ASSERT_HANDLER
+#define LV_ASSERT_HANDLER_INCLUDE <stdlib.h>
+#define LV_ASSERT_HANDLER abort();
+
+#endif // HOST_LV_CONF_H
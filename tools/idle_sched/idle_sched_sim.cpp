@@ -0,0 +1,143 @@
+/*
+ * Idle Scheduler Simulation - IdleScheduler.h on a virtual clock
+ * Each frame LVGL renders for part of the refresh period and returns the
+ * rest, like lv_timer_handler(), then idle_sched_run() gets that slice. The
+ * steps of the jobs advance the same virtual clock by a random cost, so
+ * every run is the same. Per scenario:
+ *
+ *   mixed        renders of 0..90% of the period; jobs like building the
+ *                screens (0..6 ms steps, queued at 8 ms as init_ui() does),
+ *                warming a cache and draining a log
+ *   slow steps   steps of 9..14 ms, longer than any slice, with 70% of the
+ *                frames animating: they run in the frames with nothing drawn
+ *   always busy  renders of 3..8 ms every frame, never a fully idle slice:
+ *                the queued 8 ms estimate of 2..5 ms steps has to shrink
+ *   idle         nothing drawn, the mixed jobs
+ *
+ * A frame is late when it starts after its refresh time. A scenario fails
+ * when a job is left after the frames.
+ *
+ * Build (from the project root, after tools/host/build_lvgl.sh):
+ *   g++ -O2 -DLV_CONF_INCLUDE_SIMPLE -DLV_LVGL_H_INCLUDE_SIMPLE -Itools/host -Ilib/lvgl-8.3.5 \
+ *       -Ilib/lvgl-8.3.5/src -Iinclude tools/idle_sched/idle_sched_sim.cpp \
+ *       build_host/liblvgl.a -lm -o idle_sched_sim
+ *
+ * Usage:
+ *   ./idle_sched_sim                 # 10000 frames per scenario
+ *   ./idle_sched_sim --frames 1000
+ */
+
+#include "utils/IdleScheduler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SIM_PERIOD_US (LV_DISP_DEF_REFR_PERIOD * 1000)
+
+typedef struct {
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t left;             // Steps until the job is done
+} sim_job_t;
+
+typedef struct {
+    const char* name;
+    uint32_t render_min_us;
+    uint32_t render_max_us;
+    uint32_t busy_pct;         // Frames rendering at all
+    sim_job_t jobs[3];
+    uint32_t queued_us[3];     // Estimates given to idle_sched_add()
+    uint8_t job_cnt;
+} sim_scenario_t;
+
+static const sim_scenario_t sim_scenarios[] = {
+    {"mixed", 0, SIM_PERIOD_US * 9 / 10, 100,
+     {{0, 6000, 14}, {0, 2000, 200}, {0, 100, 5000}}, {8000, 2000, 100}, 3},
+    {"slow steps", 2000, 9000, 70,
+     {{9000, 14000, 14}, {0, 100, 5000}}, {8000, 100}, 2},
+    {"always busy", 3000, 8000, 100,
+     {{2000, 5000, 14}, {0, 2000, 200}}, {8000, 2000}, 2},
+    {"idle", 0, 0, 0,
+     {{0, 6000, 14}, {0, 2000, 200}, {0, 100, 5000}}, {8000, 2000, 100}, 3},
+};
+#define SIM_SCENARIO_CNT (sizeof(sim_scenarios) / sizeof(sim_scenarios[0]))
+
+typedef struct {
+    uint32_t late_frames;
+    uint32_t done_frame;       // Frame the last job ended in (0: not done)
+    uint32_t jobs_left;
+    idle_sched_stats_t stats;
+} sim_result_t;
+
+static uint32_t sim_clock_us;
+static uint32_t sim_rand = 1;
+
+static uint32_t sim_clock() {
+    return sim_clock_us;
+}
+
+static uint32_t sim_random(uint32_t min, uint32_t max) {
+    sim_rand = sim_rand * 1103515245u + 12345u;
+    return min + (sim_rand >> 16) % (max - min + 1);
+}
+
+static bool sim_step(void* user_data) {
+    sim_job_t* job = (sim_job_t*)user_data;
+    sim_clock_us += sim_random(job->min_us, job->max_us);
+    return --job->left == 0;
+}
+
+static void sim_run(const sim_scenario_t* sc, uint32_t frames, sim_result_t* res) {
+    memset(&idle_sched, 0, sizeof(idle_sched));
+    idle_sched_init(sim_clock);
+    sim_clock_us = 0;
+    sim_rand = 1;
+
+    sim_job_t jobs[3];
+    memcpy(jobs, sc->jobs, sizeof(jobs));
+    for (uint8_t j = 0; j < sc->job_cnt; j++) idle_sched_add(sim_step, &jobs[j], sc->queued_us[j], sc->name);
+
+    memset(res, 0, sizeof(*res));
+    uint32_t next_frame_us = 0;
+    for (uint32_t f = 0; f < frames; f++) {
+        if (sim_clock_us > next_frame_us) res->late_frames++;
+        if (sim_clock_us < next_frame_us) sim_clock_us = next_frame_us;
+
+        // Render, then the loop gets the rest of the period like from lv_timer_handler()
+        if (sim_random(1, 100) <= sc->busy_pct) sim_clock_us += sim_random(sc->render_min_us, sc->render_max_us);
+        next_frame_us += SIM_PERIOD_US;
+        uint32_t idle_ms = next_frame_us > sim_clock_us ? (next_frame_us - sim_clock_us) / 1000 : 0;
+        idle_sched_set_deadline(idle_ms);
+        idle_sched_run();
+
+        if (res->done_frame == 0 && idle_sched_get_job_cnt() == 0) res->done_frame = f + 1;
+    }
+    res->jobs_left = idle_sched_get_job_cnt();
+    res->stats = idle_sched_get_stats();
+}
+
+int main(int argc, char** argv) {
+    uint32_t frames = 10000;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--frames N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    uint32_t failed = 0;
+    printf("%u frames of %d ms, %d us guard:\n", frames, LV_DISP_DEF_REFR_PERIOD, IDLE_SCHED_GUARD_US);
+    printf("  scenario      late  steps  deferred  forced  missed  max late us  done in  jobs left\n");
+    for (uint32_t s = 0; s < SIM_SCENARIO_CNT; s++) {
+        sim_result_t res;
+        sim_run(&sim_scenarios[s], frames, &res);
+        printf("  %-11s  %5u  %5u  %8u  %6u  %6u  %11u  %7u  %9u\n", sim_scenarios[s].name, res.late_frames,
+               res.stats.steps, res.stats.deferred, res.stats.forced, res.stats.missed, res.stats.max_overrun_us,
+               res.done_frame, res.jobs_left);
+        if (res.jobs_left) failed++;
+    }
+    printf("%u failed\n", failed);
+    return failed != 0;
+}
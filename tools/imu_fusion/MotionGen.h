@@ -0,0 +1,182 @@
+/*
+ * Motion Generator - Known orientation trajectories and the IMU samples they give
+ * Integrates body rates into a true orientation, then makes the samples a
+ * QMI8658 with a magnetometer would report along it: gravity plus linear
+ * acceleration in g, angular rate in degrees per second with a constant bias,
+ * and the unit magnetic field, each with white noise of the datasheet's
+ * order. The truth is kept next to every sample so a fusion filter's output
+ * can be checked against it.
+ *
+ * Frames: earth is x north, y west, z up. q maps body to earth
+ * (v_earth = q v_body q*), the same convention as SensorFusion.hpp, so at
+ * rest and face up the accelerometer reads (0, 0, 1).
+ */
+
+#ifndef MOTION_GEN_H
+#define MOTION_GEN_H
+
+#include <math.h>
+#include <stdint.h>
+
+#define MOTION_DEG (M_PI / 180.0)
+
+// Sample interval of the QMI8658 gyroscope at 896.8 Hz
+#define MOTION_SAMPLE_US 1115
+
+typedef enum {
+    MOTION_DESK,        // Lying still, tilted
+    MOTION_SLOW_TILT,   // Turned slowly by hand, like tilting the screen to look at it
+    MOTION_WRIST,       // Walking: fast wrist swing with linear acceleration
+    MOTION_YAW_SPIN,    // Turning on the spot with a little wobble
+} motion_kind_t;
+
+typedef struct {
+    double w, x, y, z;
+} motion_quat_t;
+
+typedef struct {
+    uint32_t t_us;
+    float accel[3];     // g
+    float gyro[3];      // dps
+    float mag[3];       // Unit field in the body frame
+    motion_quat_t truth;
+} motion_sample_t;
+
+typedef struct {
+    motion_kind_t kind;
+    double t;           // Seconds
+    motion_quat_t q;
+    double gyro_bias[3];
+    double gyro_noise;  // dps, standard deviation
+    double accel_noise; // g
+    double mag_noise;   // Of the unit field
+    double incl;        // Magnetic inclination, radians below horizontal
+    uint64_t rng;
+} motion_gen_t;
+
+static inline double motion_gauss(motion_gen_t* g) {
+    // Box-Muller on a 64 bit LCG
+    double u[2];
+    for (int i = 0; i < 2; ++i) {
+        g->rng = g->rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        u[i] = ((g->rng >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+    }
+    return sqrt(-2.0 * log(u[0])) * cos(2.0 * M_PI * u[1]);
+}
+
+static inline motion_quat_t motion_mul(motion_quat_t a, motion_quat_t b) {
+    motion_quat_t r = {
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+    };
+    return r;
+}
+
+// Earth vector into the body frame: q* v q
+static inline void motion_to_body(motion_quat_t q, const double e[3], double b[3]) {
+    motion_quat_t v = {0, e[0], e[1], e[2]};
+    motion_quat_t c = {q.w, -q.x, -q.y, -q.z};
+    motion_quat_t r = motion_mul(motion_mul(c, v), q);
+    b[0] = r.x;
+    b[1] = r.y;
+    b[2] = r.z;
+}
+
+static inline motion_quat_t motion_from_euler(double roll, double pitch, double yaw) {
+    double cr = cos(roll / 2), sr = sin(roll / 2);
+    double cp = cos(pitch / 2), sp = sin(pitch / 2);
+    double cy = cos(yaw / 2), sy = sin(yaw / 2);
+    motion_quat_t q = {
+        cr * cp * cy + sr * sp * sy,
+        sr * cp * cy - cr * sp * sy,
+        cr * sp * cy + sr * cp * sy,
+        cr * cp * sy - sr * sp * cy,
+    };
+    return q;
+}
+
+// Body rates (dps) and linear acceleration in the earth frame (g) at time t
+static inline void motion_profile(const motion_gen_t* g, double t, double w[3], double lin[3]) {
+    w[0] = w[1] = w[2] = 0;
+    lin[0] = lin[1] = lin[2] = 0;
+    switch (g->kind) {
+        case MOTION_DESK:
+            break;
+        case MOTION_SLOW_TILT:
+            w[0] = 25 * sin(2 * M_PI * 0.11 * t);
+            w[1] = 20 * sin(2 * M_PI * 0.07 * t + 1.0);
+            w[2] = 10 * sin(2 * M_PI * 0.05 * t);
+            break;
+        case MOTION_WRIST:
+            w[0] = 120 * sin(2 * M_PI * 1.8 * t);
+            w[1] = 60 * sin(2 * M_PI * 0.9 * t + 0.5);
+            w[2] = 40 * sin(2 * M_PI * 0.9 * t + 2.0);
+            lin[0] = 0.25 * sin(2 * M_PI * 1.8 * t);
+            lin[2] = 0.15 * sin(2 * M_PI * 3.6 * t);
+            break;
+        case MOTION_YAW_SPIN:
+            w[0] = 8 * sin(2 * M_PI * 0.5 * t);
+            w[1] = 8 * cos(2 * M_PI * 0.3 * t);
+            w[2] = 90;
+            break;
+    }
+}
+
+static inline void motion_init(motion_gen_t* g, motion_kind_t kind, uint64_t seed) {
+    g->kind = kind;
+    g->t = 0;
+    g->rng = seed * 2654435761ULL + 1;
+    g->q = motion_from_euler(12 * MOTION_DEG, -20 * MOTION_DEG, 35 * MOTION_DEG);
+    // QMI8658: 13 mdps/sqrt(Hz) and 150 ug/sqrt(Hz) at ~450 Hz bandwidth
+    g->gyro_noise = 0.28;
+    g->accel_noise = 0.0032;
+    g->mag_noise = 0.01;
+    g->gyro_bias[0] = 0.5;
+    g->gyro_bias[1] = -0.4;
+    g->gyro_bias[2] = 0.3;
+    g->incl = 60 * MOTION_DEG;
+}
+
+// Advance one sample interval and return what the sensors read at its end
+static inline motion_sample_t motion_next(motion_gen_t* g) {
+    const int steps = 8;
+    double h = MOTION_SAMPLE_US * 1e-6 / steps;
+    double w[3], lin[3];
+    for (int i = 0; i < steps; ++i) {
+        // Midpoint rate, exact rotation over the substep
+        motion_profile(g, g->t + h / 2, w, lin);
+        double angle = sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]) * MOTION_DEG * h;
+        if (angle > 0) {
+            double s = sin(angle / 2) / (angle / h / MOTION_DEG);
+            motion_quat_t d = {cos(angle / 2), w[0] * s, w[1] * s, w[2] * s};
+            g->q = motion_mul(g->q, d);
+        }
+        g->t += h;
+    }
+    double n = sqrt(g->q.w * g->q.w + g->q.x * g->q.x + g->q.y * g->q.y + g->q.z * g->q.z);
+    g->q.w /= n;
+    g->q.x /= n;
+    g->q.y /= n;
+    g->q.z /= n;
+
+    motion_sample_t s;
+    s.t_us = (uint32_t)(g->t * 1e6 + 0.5);
+    s.truth = g->q;
+    motion_profile(g, g->t, w, lin);
+
+    double f[3] = {lin[0], lin[1], lin[2] + 1.0};
+    double m[3] = {cos(g->incl), 0, -sin(g->incl)};
+    double fb[3], mb[3];
+    motion_to_body(g->q, f, fb);
+    motion_to_body(g->q, m, mb);
+    for (int i = 0; i < 3; ++i) {
+        s.accel[i] = (float)(fb[i] + g->accel_noise * motion_gauss(g));
+        s.gyro[i] = (float)(w[i] + g->gyro_bias[i] + g->gyro_noise * motion_gauss(g));
+        s.mag[i] = (float)(mb[i] + g->mag_noise * motion_gauss(g));
+    }
+    return s;
+}
+
+#endif // MOTION_GEN_H
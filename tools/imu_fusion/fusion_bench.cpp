@@ -0,0 +1,282 @@
+/*
+ * IMU Fusion Bench - Accuracy and cost of SensorFusion on known motion
+ * Runs lib/SensorLib/src/SensorFusion.hpp on the samples of MotionGen.h
+ * (896.8 Hz accelerometer and gyroscope with bias and noise, a magnetometer
+ * at about 100 Hz) for each scenario, algorithm, update rate and with and
+ * without the magnetometer, and reports:
+ *
+ *   tilt     angle between the estimated and true "up" (getGravity()),
+ *            mean and max after the first 2 s
+ *   attitude full orientation error, with the magnetometer only (without
+ *            one the heading is free to drift)
+ *   cost     filter updates per second, ns and cycles (TSC, x86 only) per
+ *            update and ns per sample, feeding batches of 16 samples the
+ *            way readFromFifo(IMUbatch *) delivers them
+ *
+ * Host cycles only rank the configurations against each other, the
+ * QMI8658_FusionExample prints the cycles per update on the ESP32-S3.
+ *
+ * Recorded data (t_us,ax,ay,az,gx,gy,gz[,mx,my,mz] per line, g and dps, the
+ * magnetometer in the IMU axes) is replayed with --csv and the orientation
+ * printed after every update. --record writes a scenario in that format.
+ *
+ * Build (from the project root):
+ *   g++ -O2 -Ilib/SensorLib/src tools/imu_fusion/fusion_bench.cpp -o fusion_bench
+ *
+ * Usage:
+ *   ./fusion_bench                          # built-in scenarios, 60 s each
+ *   ./fusion_bench --seconds 300 --seed 7
+ *   ./fusion_bench --record 2 > wrist.csv
+ *   ./fusion_bench --csv wrist.csv --mahony --rate 100
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#else
+#define BENCH_HAVE_TSC 0
+#endif
+
+#include "SensorFusion.hpp"
+#include "MotionGen.h"
+
+// Samples per FIFO read, the watermark of the QMI8658 examples
+#define BENCH_BATCH 16
+
+// Magnetometer reading every this many IMU samples (~100 Hz)
+#define BENCH_MAG_EVERY 9
+
+#define BENCH_SETTLE_US 2000000
+
+// Same layout as SensorQMI8658's IMUbatch, without the driver
+typedef struct {
+    float accel[3][BENCH_BATCH];
+    float gyro[3][BENCH_BATCH];
+    uint32_t timestamp[BENCH_BATCH];
+    uint16_t count;
+} bench_batch_t;
+
+typedef struct {
+    const char* name;
+    motion_kind_t kind;
+} bench_scenario_t;
+
+static const bench_scenario_t scenarios[] = {
+    {"desk, still and tilted", MOTION_DESK},
+    {"slow tilt by hand", MOTION_SLOW_TILT},
+    {"wrist while walking", MOTION_WRIST},
+    {"turning on the spot", MOTION_YAW_SPIN},
+};
+
+static const float bench_rates[] = {0, 200, 100, 50};
+
+typedef struct {
+    double tilt_sum, tilt_max;
+    double att_sum, att_max;
+    uint32_t n;
+    uint32_t updates;
+    double ns;          // Best of the timed runs
+    double cycles;
+} bench_result_t;
+
+static double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t bench_tsc(void) {
+#if BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static double bench_clamp_acos(double c) {
+    return acos(c > 1 ? 1 : (c < -1 ? -1 : c)) / MOTION_DEG;
+}
+
+// Accuracy, one sample at a time so every update is checked against the truth of its sample
+static void bench_accuracy(const std::vector<motion_sample_t>& samples, SensorFusion::Algorithm algo,
+                           float rate, bool mag, bench_result_t* r) {
+    SensorFusion fusion;
+    fusion.begin(rate, algo);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const motion_sample_t& s = samples[i];
+        if (mag && i % BENCH_MAG_EVERY == 0) fusion.setMagnetometer(s.mag[0], s.mag[1], s.mag[2]);
+        if (!fusion.update(s.accel[0], s.accel[1], s.accel[2], s.gyro[0], s.gyro[1], s.gyro[2], s.t_us)) continue;
+        r->updates++;
+        if (s.t_us < BENCH_SETTLE_US) continue;
+
+        double up[3], e[3] = {0, 0, 1};
+        motion_to_body(s.truth, e, up);
+        float gx, gy, gz;
+        fusion.getGravity(gx, gy, gz);
+        double tilt = bench_clamp_acos(gx * up[0] + gy * up[1] + gz * up[2]);
+        r->tilt_sum += tilt;
+        if (tilt > r->tilt_max) r->tilt_max = tilt;
+
+        float w, x, y, z;
+        fusion.getQuaternion(w, x, y, z);
+        double dot = fabs(w * s.truth.w + x * s.truth.x + y * s.truth.y + z * s.truth.z);
+        double att = 2 * bench_clamp_acos(dot);
+        r->att_sum += att;
+        if (att > r->att_max) r->att_max = att;
+        r->n++;
+    }
+}
+
+// Cost, in FIFO batches as the application feeds it
+static void bench_cost(const std::vector<motion_sample_t>& samples, SensorFusion::Algorithm algo,
+                       float rate, bool mag, bench_result_t* r) {
+    // Batches are built up front so only the filter is timed
+    std::vector<bench_batch_t> batches((samples.size() + BENCH_BATCH - 1) / BENCH_BATCH);
+    std::vector<const float*> mags(batches.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+        bench_batch_t& b = batches[i / BENCH_BATCH];
+        uint16_t k = i % BENCH_BATCH;
+        for (int a = 0; a < 3; ++a) {
+            b.accel[a][k] = samples[i].accel[a];
+            b.gyro[a][k] = samples[i].gyro[a];
+        }
+        b.timestamp[k] = samples[i].t_us;
+        b.count = k + 1;
+        if (k == 0) mags[i / BENCH_BATCH] = samples[i].mag;
+    }
+
+    r->ns = r->cycles = 1e30;
+    volatile float sink = 0;
+    for (int run = 0; run < 15; ++run) {
+        SensorFusion fusion;
+        fusion.begin(rate, algo);
+        uint32_t updates = 0;
+        double t0 = bench_now_ns();
+        uint64_t c0 = bench_tsc();
+        for (size_t i = 0; i < batches.size(); ++i) {
+            if (mag) fusion.setMagnetometer(mags[i][0], mags[i][1], mags[i][2]);
+            updates += fusion.update(batches[i]);
+        }
+        uint64_t c1 = bench_tsc();
+        double t1 = bench_now_ns();
+        float w, x, y, z;
+        fusion.getQuaternion(w, x, y, z);
+        sink = sink + w;
+        if (!updates) continue;
+        if ((t1 - t0) / updates < r->ns) r->ns = (t1 - t0) / updates;
+        if ((double)(c1 - c0) / updates < r->cycles) r->cycles = (double)(c1 - c0) / updates;
+    }
+    (void)sink;
+}
+
+static int bench_replay(const char* path, SensorFusion::Algorithm algo, float rate) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    SensorFusion fusion;
+    fusion.begin(rate, algo);
+    char line[256];
+    uint32_t lines = 0, updates = 0;
+    printf("t_us,roll,pitch,yaw,tilt\n");
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long t;
+        float v[9];
+        int n = sscanf(line, "%lu,%f,%f,%f,%f,%f,%f,%f,%f,%f", &t, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5],
+                       &v[6], &v[7], &v[8]);
+        if (n < 7) continue;   // Header or comment
+        lines++;
+        if (n == 10) fusion.setMagnetometer(v[6], v[7], v[8]);
+        if (!fusion.update(v[0], v[1], v[2], v[3], v[4], v[5], (uint32_t)t)) continue;
+        updates++;
+        printf("%lu,%.2f,%.2f,%.2f,%.2f\n", t, fusion.getRoll(), fusion.getPitch(), fusion.getYaw(), fusion.getTilt());
+    }
+    fclose(f);
+    fprintf(stderr, "%u samples, %u updates\n", lines, updates);
+    return 0;
+}
+
+static void bench_generate(motion_kind_t kind, uint32_t seconds, uint64_t seed, std::vector<motion_sample_t>* out) {
+    motion_gen_t gen;
+    motion_init(&gen, kind, seed);
+    out->clear();
+    out->push_back(motion_next(&gen));
+    while (out->back().t_us < seconds * 1000000u) out->push_back(motion_next(&gen));
+}
+
+int main(int argc, char** argv) {
+    uint32_t seconds = 60;
+    uint64_t seed = 1;
+    const char* csv = NULL;
+    int record = -1;
+    SensorFusion::Algorithm algo = SensorFusion::FUSION_MADGWICK;
+    float rate = 100;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--csv") && i + 1 < argc) csv = argv[++i];
+        else if (!strcmp(argv[i], "--record") && i + 1 < argc) record = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--rate") && i + 1 < argc) rate = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--mahony")) algo = SensorFusion::FUSION_MAHONY;
+        else {
+            fprintf(stderr, "usage: %s [--seconds N] [--seed N] [--record SCENARIO] "
+                            "[--csv FILE [--mahony] [--rate HZ]]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (csv) return bench_replay(csv, algo, rate);
+
+    const size_t count = sizeof(scenarios) / sizeof(scenarios[0]);
+    std::vector<motion_sample_t> samples;
+    if (record >= 0) {
+        if ((size_t)record >= count) {
+            fprintf(stderr, "scenario 0-%zu\n", count - 1);
+            return 1;
+        }
+        bench_generate(scenarios[record].kind, seconds, seed, &samples);
+        printf("# %s\n# t_us,ax,ay,az,gx,gy,gz,mx,my,mz\n", scenarios[record].name);
+        for (size_t i = 0; i < samples.size(); ++i) {
+            const motion_sample_t& s = samples[i];
+            printf("%u,%.5f,%.5f,%.5f,%.3f,%.3f,%.3f", s.t_us, s.accel[0], s.accel[1], s.accel[2], s.gyro[0],
+                   s.gyro[1], s.gyro[2]);
+            if (i % BENCH_MAG_EVERY == 0) printf(",%.4f,%.4f,%.4f", s.mag[0], s.mag[1], s.mag[2]);
+            printf("\n");
+        }
+        return 0;
+    }
+
+    for (size_t sc = 0; sc < count; ++sc) {
+        bench_generate(scenarios[sc].kind, seconds, seed + sc, &samples);
+        printf("%s (%zu samples at 896.8 Hz)\n", scenarios[sc].name, samples.size());
+        for (int mag = 0; mag < 2; ++mag) {
+            for (int a = 0; a < 2; ++a) {
+                SensorFusion::Algorithm alg = a ? SensorFusion::FUSION_MAHONY : SensorFusion::FUSION_MADGWICK;
+                for (size_t ri = 0; ri < sizeof(bench_rates) / sizeof(bench_rates[0]); ++ri) {
+                    bench_result_t r;
+                    memset(&r, 0, sizeof(r));
+                    bench_accuracy(samples, alg, bench_rates[ri], mag, &r);
+                    bench_cost(samples, alg, bench_rates[ri], mag, &r);
+                    char hz[16];
+                    if (bench_rates[ri] > 0) snprintf(hz, sizeof(hz), "%.0f Hz", bench_rates[ri]);
+                    else snprintf(hz, sizeof(hz), "every");
+                    printf("  %-8s %-5s %-6s tilt mean %5.2f max %5.2f deg", a ? "mahony" : "madgwick",
+                           mag ? "+mag" : "", hz, r.n ? r.tilt_sum / r.n : 0.0, r.tilt_max);
+                    if (mag) printf("  attitude mean %5.2f max %6.2f deg", r.n ? r.att_sum / r.n : 0.0, r.att_max);
+                    else printf("  %36s", "");
+                    printf("  %6.1f upd/s %6.1f ns/upd", r.updates / (double)seconds, r.ns);
+                    if (BENCH_HAVE_TSC) printf(" %6.0f cyc/upd", r.cycles);
+                    printf(" %5.1f ns/sample\n", r.ns * r.updates / samples.size());
+                }
+            }
+        }
+    }
+    return 0;
+}
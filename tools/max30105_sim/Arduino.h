@@ -0,0 +1,40 @@
+/*
+ * Host Arduino core for the MAX30105 simulation
+ * Just what MAX30105.cpp needs. Time is virtual: it moves with the loop's
+ * delays and the simulated I2C transfers, and the sensor model produces its
+ * samples (and raises INT) as it passes. Defined in fifo_sim.cpp.
+ */
+
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define FALLING 2
+
+#define digitalPinToInterrupt(pin) (pin)
+
+uint32_t micros(void);
+uint32_t millis(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t interrupt);
+void noInterrupts(void);
+void interrupts(void);
+
+#endif // SIM_ARDUINO_H
@@ -0,0 +1,236 @@
+/*
+ * MAX30105 Model - Registers, FIFO and INT pin of the sensor for host tests
+ * Produces a sample every sample period of its own clock (which can drift
+ * from the host's), stores it in the 32 deep FIFO with the pointers and
+ * overflow counter of the datasheet, and pulls INT low when the FIFO holds
+ * the almost full count. The red value of each sample is its sequence
+ * number, so a reader can tell lost, repeated and reordered samples apart,
+ * and the true time of every sample is kept to check timestamps.
+ *
+ * Modeled: FIFO_WR_PTR/OVF_COUNTER/FIFO_RD_PTR, FIFO_DATA (3 bytes per LED,
+ * read pointer moves per complete sample), FIFO_CONFIG (averaging, rollover,
+ * A_FULL), MODE_CONFIG (reset, LED mode), SPO2_CONFIG (sample rate),
+ * INT status/enable 1 (A_FULL only), part and revision IDs. With rollover a
+ * full FIFO drops its oldest sample for the new one.
+ */
+
+#ifndef MAX30105_MODEL_H
+#define MAX30105_MODEL_H
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#define MAX30105_MODEL_ADDRESS 0x57
+#define MAX30105_MODEL_FIFO_DEPTH 32
+
+// Sequence numbers start here so no sample reads as 0 (a failed read)
+#define MAX30105_MODEL_SEQ_BASE 1000
+
+enum {
+    MAX30105_MODEL_INTSTAT1 = 0x00,
+    MAX30105_MODEL_INTENABLE1 = 0x02,
+    MAX30105_MODEL_FIFOWRITEPTR = 0x04,
+    MAX30105_MODEL_FIFOOVERFLOW = 0x05,
+    MAX30105_MODEL_FIFOREADPTR = 0x06,
+    MAX30105_MODEL_FIFODATA = 0x07,
+    MAX30105_MODEL_FIFOCONFIG = 0x08,
+    MAX30105_MODEL_MODECONFIG = 0x09,
+    MAX30105_MODEL_PARTICLECONFIG = 0x0A,
+    MAX30105_MODEL_REVISIONID = 0xFE,
+    MAX30105_MODEL_PARTID = 0xFF,
+};
+
+#define MAX30105_MODEL_INT_A_FULL 0x80
+
+typedef struct {
+    uint8_t regs[256];
+    uint8_t ptr;                         // Register pointer of the next transfer
+    uint32_t fifo[MAX30105_MODEL_FIFO_DEPTH][3];
+    uint8_t count;                       // Unread samples
+    uint8_t byte_pos;                    // Bytes of the oldest sample already read
+
+    int32_t drift_ppm;                   // Sensor clock error
+    uint64_t next_sample_us;             // 0: not sampling
+    uint32_t seq;                        // Sequence number of the next sample
+    std::vector<uint64_t> sample_us;     // True time of each sample, by sequence number
+
+    bool int_low;
+    void (*on_falling)(uint64_t now_us); // INT went low
+
+    uint32_t overwritten;                // Samples dropped by the FIFO
+} max30105_model_t;
+
+static inline void max30105_model_reset(max30105_model_t* m) {
+    memset(m->regs, 0, sizeof(m->regs));
+    m->regs[MAX30105_MODEL_PARTID] = 0x15;
+    m->regs[MAX30105_MODEL_REVISIONID] = 0x03;
+    m->count = 0;
+    m->byte_pos = 0;
+    m->next_sample_us = 0;
+    m->int_low = false;
+}
+
+static inline void max30105_model_init(max30105_model_t* m, int32_t drift_ppm, void (*on_falling)(uint64_t)) {
+    max30105_model_reset(m);
+    m->ptr = 0;
+    m->drift_ppm = drift_ppm;
+    m->seq = 0;
+    m->sample_us.clear();
+    m->on_falling = on_falling;
+    m->overwritten = 0;
+}
+
+static inline uint8_t max30105_model_leds(const max30105_model_t* m) {
+    switch (m->regs[MAX30105_MODEL_MODECONFIG] & 0x07) {
+        case 0x02: return 1;
+        case 0x03: return 2;
+        case 0x07: return 3;
+        default: return 0;
+    }
+}
+
+// Time between FIFO samples on the sensor's clock
+static inline uint64_t max30105_model_period_us(const max30105_model_t* m) {
+    static const uint32_t rates[8] = {50, 100, 200, 400, 800, 1000, 1600, 3200};
+    uint32_t rate = rates[(m->regs[MAX30105_MODEL_PARTICLECONFIG] >> 2) & 0x07];
+    uint32_t avg = 1 << ((m->regs[MAX30105_MODEL_FIFOCONFIG] >> 5) & 0x07);
+    if (avg > 32) avg = 32;
+    return (uint64_t)1000000 * avg * (1000000 + m->drift_ppm) / rate / 1000000;
+}
+
+static inline uint8_t max30105_model_almost_full(const max30105_model_t* m) {
+    return MAX30105_MODEL_FIFO_DEPTH - (m->regs[MAX30105_MODEL_FIFOCONFIG] & 0x0F);
+}
+
+static inline void max30105_model_update_int(max30105_model_t* m, uint64_t now_us) {
+    bool low = (m->regs[MAX30105_MODEL_INTSTAT1] & m->regs[MAX30105_MODEL_INTENABLE1] & 0xF0) != 0;
+    if (low && !m->int_low && m->on_falling) {
+        m->int_low = true;
+        m->on_falling(now_us);
+    }
+    m->int_low = low;
+}
+
+// Keep the pointer registers in step with the FIFO
+static inline void max30105_model_sync_ptrs(max30105_model_t* m) {
+    uint8_t rd = m->regs[MAX30105_MODEL_FIFOREADPTR];
+    m->regs[MAX30105_MODEL_FIFOWRITEPTR] = (rd + m->count) % MAX30105_MODEL_FIFO_DEPTH;
+}
+
+static inline void max30105_model_sample(max30105_model_t* m, uint64_t now_us) {
+    uint32_t seq = m->seq++;
+    m->sample_us.push_back(now_us);
+    uint32_t value = (seq + MAX30105_MODEL_SEQ_BASE) & 0x3FFFF;
+
+    if (m->count == MAX30105_MODEL_FIFO_DEPTH) {
+        uint8_t* ovf = &m->regs[MAX30105_MODEL_FIFOOVERFLOW];
+        if (*ovf < 0x1F) (*ovf)++;
+        m->overwritten++;
+        if (!(m->regs[MAX30105_MODEL_FIFOCONFIG] & 0x10)) return;   // No rollover: the new one is lost
+        // Rollover: the oldest goes
+        m->regs[MAX30105_MODEL_FIFOREADPTR] = (m->regs[MAX30105_MODEL_FIFOREADPTR] + 1) % MAX30105_MODEL_FIFO_DEPTH;
+        m->count--;
+        m->byte_pos = 0;
+    }
+    uint8_t wr = (m->regs[MAX30105_MODEL_FIFOREADPTR] + m->count) % MAX30105_MODEL_FIFO_DEPTH;
+    m->fifo[wr][0] = value;
+    m->fifo[wr][1] = (value * 7 + 1) & 0x3FFFF;
+    m->fifo[wr][2] = (value * 13 + 2) & 0x3FFFF;
+    m->count++;
+    max30105_model_sync_ptrs(m);
+
+    if (m->count == max30105_model_almost_full(m)) {
+        m->regs[MAX30105_MODEL_INTSTAT1] |= MAX30105_MODEL_INT_A_FULL;
+        max30105_model_update_int(m, now_us);
+    }
+}
+
+/**
+ * Produce the samples due until `to_us`
+ * @param now_us Advanced to each sample time (the interrupt sees it), then to `to_us`
+ */
+static inline void max30105_model_run(max30105_model_t* m, uint64_t* now_us, uint64_t to_us) {
+    while (m->next_sample_us && m->next_sample_us <= to_us) {
+        *now_us = m->next_sample_us;
+        max30105_model_sample(m, *now_us);
+        m->next_sample_us += max30105_model_period_us(m);
+    }
+    *now_us = to_us;
+}
+
+static inline void max30105_model_write(max30105_model_t* m, uint8_t reg, uint8_t value, uint64_t now_us) {
+    switch (reg) {
+        case MAX30105_MODEL_MODECONFIG:
+            if (value & 0x40) {   // Reset, done at once
+                max30105_model_reset(m);
+                return;
+            }
+            m->regs[reg] = value;
+            if (!m->next_sample_us && max30105_model_leds(m) && !(value & 0x80)) {
+                m->next_sample_us = now_us + max30105_model_period_us(m);
+            }
+            if (value & 0x80) m->next_sample_us = 0;   // Shutdown
+            return;
+        case MAX30105_MODEL_FIFOWRITEPTR:
+        case MAX30105_MODEL_FIFOREADPTR:
+            m->regs[reg] = value & 0x1F;
+            m->count = (m->regs[MAX30105_MODEL_FIFOWRITEPTR] - m->regs[MAX30105_MODEL_FIFOREADPTR]) & 0x1F;
+            m->byte_pos = 0;
+            return;
+        case MAX30105_MODEL_FIFOOVERFLOW:
+            m->regs[reg] = value & 0x1F;
+            return;
+        case MAX30105_MODEL_INTSTAT1:
+        case MAX30105_MODEL_FIFODATA:
+        case MAX30105_MODEL_PARTID:
+        case MAX30105_MODEL_REVISIONID:
+            return;   // Read only
+        default:
+            m->regs[reg] = value;
+            if (reg == MAX30105_MODEL_INTENABLE1) max30105_model_update_int(m, now_us);
+            return;
+    }
+}
+
+static inline uint8_t max30105_model_read(max30105_model_t* m, uint8_t reg, uint64_t now_us) {
+    if (reg == MAX30105_MODEL_INTSTAT1) {
+        uint8_t value = m->regs[reg];
+        m->regs[reg] = 0;   // Cleared by reading
+        max30105_model_update_int(m, now_us);
+        return value;
+    }
+    if (reg != MAX30105_MODEL_FIFODATA) return m->regs[reg];
+
+    // Reading the FIFO also clears A_FULL
+    if (m->regs[MAX30105_MODEL_INTSTAT1] & MAX30105_MODEL_INT_A_FULL) {
+        m->regs[MAX30105_MODEL_INTSTAT1] &= ~MAX30105_MODEL_INT_A_FULL;
+        max30105_model_update_int(m, now_us);
+    }
+    uint8_t leds = max30105_model_leds(m);
+    if (m->count == 0 || leds == 0) return 0;
+
+    uint8_t rd = m->regs[MAX30105_MODEL_FIFOREADPTR];
+    uint32_t value = m->fifo[rd][m->byte_pos / 3];
+    uint8_t out = (uint8_t)(value >> (8 * (2 - m->byte_pos % 3)));
+    if (++m->byte_pos == leds * 3) {
+        m->byte_pos = 0;
+        m->regs[MAX30105_MODEL_FIFOREADPTR] = (rd + 1) % MAX30105_MODEL_FIFO_DEPTH;
+        m->regs[MAX30105_MODEL_FIFOOVERFLOW] = 0;   // Reset when a sample is popped
+        m->count--;
+        max30105_model_sync_ptrs(m);
+    }
+    return out;
+}
+
+/**
+ * Sequence number of a sample read back (its red value)
+ * @param last Sequence number of the previous one, to undo the 18 bit wrap
+ */
+static inline uint32_t max30105_model_seq(uint32_t red, uint32_t last) {
+    uint32_t seq = (red - MAX30105_MODEL_SEQ_BASE) & 0x3FFFF;
+    while (seq + 0x20000 < last) seq += 0x40000;
+    return seq;
+}
+
+#endif // MAX30105_MODEL_H
@@ -0,0 +1,39 @@
+/*
+ * Host Wire for the MAX30105 simulation
+ * Transactions go to the register model of Max30105Model.h and take the time
+ * they would on the bus. Defined in fifo_sim.cpp.
+ */
+
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include "Arduino.h"
+
+class TwoWire {
+public:
+    void begin() {}
+    void setClock(uint32_t hz) { clock_hz = hz; }
+
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t value);
+    uint8_t endTransmission(bool stop = true);
+
+    uint8_t requestFrom(uint8_t address, uint8_t count);
+    uint8_t requestFrom(int address, int count) { return requestFrom((uint8_t)address, (uint8_t)count); }
+    int available() { return (int)(rx_len - rx_pos); }
+    int read() { return rx_pos < rx_len ? rx[rx_pos++] : -1; }
+
+    uint32_t clock_hz = 100000;
+
+private:
+    uint8_t address = 0;
+    uint8_t tx[64];
+    size_t tx_len = 0;
+    uint8_t rx[256];
+    size_t rx_len = 0;
+    size_t rx_pos = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // SIM_WIRE_H
@@ -0,0 +1,310 @@
+/*
+ * MAX30105 FIFO Simulation - Polled check() against the interrupt driven drain
+ * Runs the real driver (lib/SparkFun MAX3010x .../src/MAX30105.cpp) on the
+ * register model of Max30105Model.h over a simulated I2C bus, from a loop
+ * served at jittery intervals with occasional long stalls (like a UI loop
+ * during a screen transition), and checks every sample the application gets:
+ *
+ *   poll  check() every loop, then available()/getFIFOxxx()/nextSample()
+ *   irq   beginInterrupt() + drainFIFO() every loop into a 256 sample ring,
+ *         then ringRead()
+ *
+ * Reported per scenario and mode: samples delivered, lost and repeated (from
+ * the sequence numbers the model puts in the red channel), the samples the
+ * driver knows it lost, I2C transactions per loop and bus time, loops which
+ * used the bus for nothing, and for irq the error of the sample timestamps
+ * against the model's true sample times.
+ *
+ * Build (from the project root):
+ *   g++ -O2 -DARDUINO=10819 -Itools/max30105_sim \
+ *       -I"lib/SparkFun MAX3010x Pulse and Proximity Sensor Library/src" \
+ *       tools/max30105_sim/fifo_sim.cpp \
+ *       "lib/SparkFun MAX3010x Pulse and Proximity Sensor Library/src/MAX30105.cpp" -o fifo_sim
+ *
+ * Usage:
+ *   ./fifo_sim                 # built-in scenarios, 60 s each
+ *   ./fifo_sim --seconds 600 --seed 7
+ */
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "MAX30105.h"
+#include "Max30105Model.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Samples the ring given to drainFIFO() holds
+#define SIM_RING_SIZE 256
+
+// Pin the model's INT is wired to
+#define SIM_INT_PIN 4
+
+typedef struct {
+    const char* name;
+    uint16_t rate;              // Samples per second (before averaging)
+    uint8_t average;
+    uint8_t leds;
+    int32_t drift_ppm;          // Sensor clock against the MCU's
+    uint32_t loop_min_us;       // Time between two services of the loop
+    uint32_t loop_max_us;
+    uint32_t stall_every_ms;    // Mean time between stalls (0: none)
+    uint32_t stall_us;
+    uint8_t almost_full;        // FIFO samples raising INT
+} sim_scenario_t;
+
+static const sim_scenario_t scenarios[] = {
+    {"100 Hz Red+IR, UI loop", 100, 1, 2, 2000, 1000, 35000, 5000, 120000, 24},
+    {"100 Hz Red+IR, slow loop", 100, 1, 2, -3000, 5000, 60000, 10000, 250000, 24},
+    {"400 Hz Red+IR, avg 4", 400, 4, 2, 5000, 1000, 35000, 5000, 120000, 24},
+    {"400 Hz Red+IR", 400, 1, 2, 10000, 1000, 20000, 5000, 60000, 17},
+    {"1000 Hz 3 LEDs", 1000, 1, 3, 15000, 500, 10000, 0, 0, 17},
+};
+
+typedef struct {
+    uint32_t produced;
+    uint32_t delivered;
+    uint32_t lost;              // Gaps in the sequence numbers
+    uint32_t repeated;          // Same or older sequence number again
+    uint32_t driver_lost;       // getLostSamples()
+    uint32_t loops;
+    uint32_t idle_bus_loops;    // Loops using the bus without getting a sample
+    uint32_t transactions;
+    uint64_t bus_us;
+    uint64_t ts_err_sum;
+    uint32_t ts_err_max;
+    uint32_t ts_cnt;
+    uint16_t max_ring;
+} sim_result_t;
+
+static uint64_t sim_now_us;
+static uint32_t sim_rand = 1;
+static max30105_model_t model;
+static void (*sim_isr)(void);
+static bool sim_irq_enabled = true;
+static bool sim_irq_pending;
+static sim_result_t* sim_res;
+
+TwoWire Wire;
+
+static uint32_t sim_random(uint32_t max) {
+    sim_rand = sim_rand * 1103515245u + 12345u;
+    uint32_t r = (sim_rand >> 16) | ((sim_rand * 1103515245u + 12345u) >> 16 << 15);
+    return r % (max + 1);
+}
+
+static void sim_advance_us(uint64_t us) {
+    max30105_model_run(&model, &sim_now_us, sim_now_us + us);
+}
+
+static void sim_falling(uint64_t now_us) {
+    (void)now_us;
+    if (!sim_isr) return;
+    if (sim_irq_enabled) sim_isr();
+    else sim_irq_pending = true;
+}
+
+//
+// Host Arduino core (Arduino.h)
+//
+
+uint32_t micros(void) { return (uint32_t)sim_now_us; }
+uint32_t millis(void) { return (uint32_t)(sim_now_us / 1000); }
+void delay(uint32_t ms) { sim_advance_us((uint64_t)ms * 1000); }
+void delayMicroseconds(uint32_t us) { sim_advance_us(us); }
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+int digitalRead(uint8_t pin) { return pin == SIM_INT_PIN && model.int_low ? LOW : HIGH; }
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode) {
+    (void)mode;
+    if (interrupt == SIM_INT_PIN) sim_isr = isr;
+}
+
+void detachInterrupt(uint8_t interrupt) {
+    if (interrupt == SIM_INT_PIN) sim_isr = NULL;
+}
+
+void noInterrupts(void) { sim_irq_enabled = false; }
+
+void interrupts(void) {
+    sim_irq_enabled = true;
+    if (sim_irq_pending && sim_isr) {
+        sim_irq_pending = false;
+        sim_isr();
+    }
+}
+
+//
+// Host Wire (Wire.h): address byte, data bytes and ack bits, plus start/stop
+//
+
+static void sim_bus(size_t bytes, uint32_t clock_hz) {
+    uint64_t bits = (1 + bytes) * 9 + 2;
+    uint64_t us = (bits * 1000000 + clock_hz - 1) / clock_hz;
+    if (sim_res) {
+        sim_res->transactions++;
+        sim_res->bus_us += us;
+    }
+    sim_advance_us(us);
+}
+
+void TwoWire::beginTransmission(uint8_t addr) {
+    address = addr;
+    tx_len = 0;
+}
+
+size_t TwoWire::write(uint8_t value) {
+    if (tx_len >= sizeof(tx)) return 0;
+    tx[tx_len++] = value;
+    return 1;
+}
+
+uint8_t TwoWire::endTransmission(bool stop) {
+    (void)stop;
+    sim_bus(tx_len, clock_hz);
+    if (address != MAX30105_MODEL_ADDRESS) return 2;   // NACK
+    if (tx_len == 0) return 0;
+    model.ptr = tx[0];
+    for (size_t i = 1; i < tx_len; i++) {
+        max30105_model_write(&model, model.ptr, tx[i], sim_now_us);
+        if (model.ptr != MAX30105_MODEL_FIFODATA) model.ptr++;
+    }
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t addr, uint8_t count) {
+    rx_len = 0;
+    rx_pos = 0;
+    if (addr != MAX30105_MODEL_ADDRESS) return 0;
+    for (uint8_t i = 0; i < count; i++) {
+        rx[rx_len++] = max30105_model_read(&model, model.ptr, sim_now_us);
+        if (model.ptr != MAX30105_MODEL_FIFODATA) model.ptr++;
+    }
+    sim_bus(count, clock_hz);
+    return count;
+}
+
+//
+// Scenarios
+//
+
+// Check a delivered sample against the model
+static void sim_deliver(sim_result_t* res, uint32_t red, uint32_t ir, int64_t* last_seq,
+                        bool has_time, uint32_t time) {
+    uint32_t seq = max30105_model_seq(red, *last_seq < 0 ? 0 : (uint32_t)*last_seq);
+    if (ir != ((red * 7 + 1) & 0x3FFFF) || seq >= model.sample_us.size()) {
+        res->repeated++;   // Not a sample of the model, count it as a bad one
+        return;
+    }
+    if ((int64_t)seq <= *last_seq) {
+        res->repeated++;
+        return;
+    }
+    res->lost += seq - (uint32_t)(*last_seq + 1);
+    *last_seq = seq;
+    res->delivered++;
+
+    if (has_time) {
+        int64_t err = (int64_t)(int32_t)(time - (uint32_t)model.sample_us[seq]);
+        uint32_t abs_err = (uint32_t)(err < 0 ? -err : err);
+        res->ts_err_sum += abs_err;
+        res->ts_cnt++;
+        if (abs_err > res->ts_err_max) res->ts_err_max = abs_err;
+    }
+}
+
+static sim_result_t sim_run(const sim_scenario_t* sc, bool use_irq, uint32_t seconds, uint32_t seed) {
+    static max30105_sample ring[SIM_RING_SIZE];
+    sim_result_t res;
+    memset(&res, 0, sizeof(res));
+
+    sim_now_us = 0;
+    sim_rand = seed;
+    sim_isr = NULL;
+    sim_irq_enabled = true;
+    sim_irq_pending = false;
+    max30105_model_init(&model, sc->drift_ppm, sim_falling);
+
+    MAX30105 sensor;
+    sim_res = NULL;   // Setup traffic isn't counted
+    if (!sensor.begin(Wire, I2C_SPEED_FAST)) {
+        fprintf(stderr, "MAX30105 model not found\n");
+        exit(1);
+    }
+    sensor.setup(0x1F, sc->average, sc->leds, sc->rate, 411, 4096);
+    if (use_irq) {
+        sensor.setSampleRing(ring, SIM_RING_SIZE);
+        sensor.beginInterrupt(SIM_INT_PIN, sc->almost_full);
+    }
+    sim_res = &res;
+
+    uint64_t end_us = sim_now_us + (uint64_t)seconds * 1000000;
+    uint32_t first_seq = model.seq;
+    int64_t last_seq = (int64_t)first_seq - 1;
+    while (sim_now_us < end_us) {
+        uint32_t wait = sc->loop_min_us + sim_random(sc->loop_max_us - sc->loop_min_us);
+        if (sc->stall_every_ms && sim_random(sc->stall_every_ms * 1000 / ((sc->loop_min_us + sc->loop_max_us) / 2)) == 0) {
+            wait += sc->stall_us;
+        }
+        sim_advance_us(wait);
+        res.loops++;
+
+        uint32_t transactions = res.transactions;
+        uint32_t delivered = res.delivered;
+        if (use_irq) {
+            sensor.drainFIFO();
+            uint16_t fill = sensor.ringAvailable();
+            if (fill > res.max_ring) res.max_ring = fill;
+            max30105_sample s;
+            while (sensor.ringRead(&s)) sim_deliver(&res, s.red, s.IR, &last_seq, true, s.time);
+        } else {
+            sensor.check();
+            while (sensor.available()) {
+                sim_deliver(&res, sensor.getFIFORed(), sensor.getFIFOIR(), &last_seq, false, 0);
+                sensor.nextSample();
+            }
+        }
+        if (res.transactions != transactions && res.delivered == delivered) res.idle_bus_loops++;
+    }
+
+    res.produced = model.seq - first_seq;
+    res.driver_lost = use_irq ? sensor.getLostSamples() : 0;
+    sim_res = NULL;
+    return res;
+}
+
+static void sim_print(const char* mode, const sim_result_t* r, uint32_t seconds) {
+    printf("  %-4s delivered %6u/%-6u lost %5u rep %3u (driver: %5u)  i2c/loop %5.2f bus %5.2f%%  idle-bus loops %5.1f%%",
+           mode, r->delivered, r->produced, r->lost, r->repeated, r->driver_lost,
+           r->loops ? (double)r->transactions / r->loops : 0,
+           100.0 * r->bus_us / (seconds * 1000000.0),
+           r->loops ? 100.0 * r->idle_bus_loops / r->loops : 0);
+    if (r->ts_cnt) {
+        printf("  ts err mean %4llu max %5u us  ring max %u",
+               (unsigned long long)(r->ts_err_sum / r->ts_cnt), r->ts_err_max, r->max_ring);
+    }
+    printf("\n");
+}
+
+int main(int argc, char** argv) {
+    uint32_t seconds = 60;
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--seconds N] [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    for (const sim_scenario_t& sc : scenarios) {
+        printf("%s (loop %u-%u us, stall %u us every ~%u ms, drift %d ppm, A_FULL at %u)\n", sc.name,
+               sc.loop_min_us, sc.loop_max_us, sc.stall_us, sc.stall_every_ms, sc.drift_ppm, sc.almost_full);
+        sim_result_t poll = sim_run(&sc, false, seconds, seed);
+        sim_print("poll", &poll, seconds);
+        sim_result_t irq = sim_run(&sc, true, seconds, seed);
+        sim_print("irq", &irq, seconds);
+    }
+    return 0;
+}
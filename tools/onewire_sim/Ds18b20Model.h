@@ -0,0 +1,409 @@
+/*
+ * DS18B20 Model - A 1-Wire bus with DS18B20/DS18S20 sensors, for host tests
+ * The master drives the bus low and releases it at virtual microsecond
+ * times; the sensors see each edge like the chips do (a low of 480 us or
+ * more is a reset, 1-15 us a 1 or the start of a read slot, 60-120 us a
+ * 0), answer with a presence pulse and by holding the bus low in read
+ * slots, for random times within the datasheet's limits. The bus is
+ * wired-AND, so several sensors answering a search read as their AND.
+ *
+ * Every edge and sample is checked against the datasheet timing and
+ * counted as a violation when outside it: low times, slot length and
+ * recovery, reset recovery, when read slots and presence are sampled, and
+ * the strong pull-up a parasite powered sensor needs while it converts
+ * (without it the conversion is lost). A parasite powered sensor held low
+ * for more than 960 us powers up again with 85 C in its scratchpad.
+ *
+ * Modeled commands: Read ROM, Match ROM, Skip ROM, Search ROM (and Alarm
+ * Search, with no alarms), Convert T, Read/Write Scratchpad, Read Power
+ * Supply. Conversions take 75-100% of the datasheet's time for the
+ * configured resolution; an externally powered sensor answers 0 to read
+ * slots while it converts. A sensor can flip the bits it sends at a given
+ * rate, to test CRC checking.
+ */
+
+#ifndef DS18B20_MODEL_H
+#define DS18B20_MODEL_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define OW_MODEL_MAX_DEVICES 64
+
+enum {
+    OW_ERR_LOW_TIME,        // Low neither 1-15, 60-120 nor >= 480 us
+    OW_ERR_SLOT,            // Slot under 60 us, recovery under 1 us, or a sensor still holding the bus
+    OW_ERR_RESET_RECOVERY,  // Slot within 480 us of a reset's release
+    OW_ERR_READ_SAMPLE,     // Read slot sampled 15 us or more after its start
+    OW_ERR_PRESENCE_SAMPLE, // Presence sampled outside 60-75 us after the reset's release
+    OW_ERR_POWER,           // Parasite conversion without the strong pull-up
+    OW_ERR_COUNT,
+};
+
+static const char* const ow_err_names[OW_ERR_COUNT] = {
+    "low time", "slot", "reset recovery", "read sample", "presence sample", "parasite power",
+};
+
+typedef enum {
+    DS_IDLE,        // Waiting for a reset
+    DS_ROM_CMD,
+    DS_MATCH,
+    DS_SEARCH,
+    DS_FUNC,
+    DS_TX,
+    DS_RX,
+    DS_CONVERTING,
+    DS_POWER,
+} ds_state_t;
+
+typedef struct {
+    uint8_t rom[8];
+    bool parasite;
+    double temp_c;                // What the sensor measures
+    uint8_t scratch[9];
+    int16_t latched16;            // Temperature of the last conversion, 1/16 C
+    double flip_rate;             // Chance each bit sent is flipped
+
+    ds_state_t state;
+    ds_state_t after_tx;
+    uint8_t rx_byte;
+    uint8_t rx_bits;
+    uint8_t rx_count;
+    uint8_t rx_buf[3];
+    uint8_t tx_buf[9];
+    uint8_t tx_len;               // Bits
+    uint8_t tx_pos;
+    uint8_t search_bit;
+    uint8_t search_sub;
+    bool sending;                 // This slot is a read slot for the sensor
+    uint64_t hold_from_us;        // Holding the bus low
+    uint64_t hold_until_us;
+    uint64_t conv_start_us;
+    uint64_t conv_done_us;
+    bool conv_pending;
+} ds18b20_t;
+
+typedef struct {
+    uint64_t now_us;
+    ds18b20_t dev[OW_MODEL_MAX_DEVICES];
+    int count;
+
+    bool master_low;
+    bool strong;                  // Master holding the bus high
+    uint64_t fall_us;
+    uint64_t rise_us;
+    bool last_reset;              // The last release ended a reset
+    bool started;
+
+    uint32_t errors[OW_ERR_COUNT];
+    uint32_t resets;
+    uint32_t por;                 // Parasite sensors that powered up again
+    uint64_t rng;
+} ow_bus_t;
+
+static inline double ow_uniform(ow_bus_t* bus) {
+    bus->rng = bus->rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    return ((bus->rng >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+static inline uint64_t ow_random_us(ow_bus_t* bus, uint32_t lo, uint32_t hi) {
+    return lo + (uint64_t)(ow_uniform(bus) * (hi - lo + 1));
+}
+
+static inline uint8_t ow_model_crc8(const uint8_t* data, int len) {
+    uint8_t crc = 0;
+    for (int i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; ++b) crc = (crc & 1) ? (crc >> 1) ^ 0x8C : crc >> 1;
+    }
+    return crc;
+}
+
+static inline void ow_bus_init(ow_bus_t* bus, uint64_t seed) {
+    memset(bus, 0, sizeof(*bus));
+    bus->rng = seed * 2654435761ULL + 1;
+}
+
+// Scratchpad temperature bytes for t16 (1/16 C)
+static inline void ds_store_temp(ds18b20_t* d, int16_t t16) {
+    if (d->rom[0] == 0x10) {
+        // 0.5 C steps, the rest in COUNT_REMAIN: t16 = (raw & ~1) * 8 - 4 + 16 - remain
+        int base = 16 * (int)floor((t16 + 4) / 16.0);
+        int16_t raw = (int16_t)(base / 8);
+        d->scratch[0] = raw & 0xFF;
+        d->scratch[1] = (raw >> 8) & 0xFF;
+        d->scratch[6] = (uint8_t)(base + 12 - t16);
+    } else {
+        d->scratch[0] = t16 & 0xFF;
+        d->scratch[1] = (t16 >> 8) & 0xFF;
+    }
+    d->latched16 = t16;
+    d->scratch[8] = ow_model_crc8(d->scratch, 8);
+}
+
+static inline void ds_power_up(ds18b20_t* d) {
+    static const uint8_t b20[8] = {0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10};
+    static const uint8_t s20[8] = {0xAA, 0x00, 0x4B, 0x46, 0xFF, 0xFF, 0x0C, 0x10};
+    memcpy(d->scratch, d->rom[0] == 0x10 ? s20 : b20, 8);
+    ds_store_temp(d, 85 * 16);
+    d->state = DS_IDLE;
+    d->conv_pending = false;
+    d->hold_until_us = 0;
+}
+
+static inline int ow_bus_add(ow_bus_t* bus, const uint8_t rom7[7], bool parasite, double temp_c) {
+    if (bus->count >= OW_MODEL_MAX_DEVICES) return -1;
+    ds18b20_t* d = &bus->dev[bus->count];
+    memset(d, 0, sizeof(*d));
+    memcpy(d->rom, rom7, 7);
+    d->rom[7] = ow_model_crc8(d->rom, 7);
+    d->parasite = parasite;
+    d->temp_c = temp_c;
+    ds_power_up(d);
+    return bus->count++;
+}
+
+static inline uint32_t ds_conversion_us(const ds18b20_t* d) {
+    if (d->rom[0] == 0x10) return 750000;
+    return 93750u << ((d->scratch[4] >> 5) & 3);
+}
+
+// A conversion that finished by now updates the scratchpad
+static inline void ds_settle(ow_bus_t* bus, ds18b20_t* d) {
+    if (!d->conv_pending || bus->now_us < d->conv_done_us) return;
+    d->conv_pending = false;
+    int16_t t16 = (int16_t)lround(d->temp_c * 16);
+    if (d->rom[0] != 0x10) {
+        int bits = 9 + ((d->scratch[4] >> 5) & 3);
+        t16 &= ~((1 << (12 - bits)) - 1);
+    }
+    ds_store_temp(d, t16);
+}
+
+// Parasite sensors still converting lose the conversion without the strong pull-up
+static inline void ow_bus_check_power(ow_bus_t* bus) {
+    for (int i = 0; i < bus->count; ++i) {
+        ds18b20_t* d = &bus->dev[i];
+        ds_settle(bus, d);
+        if (d->parasite && d->conv_pending && !bus->strong && bus->now_us > d->conv_start_us) {
+            d->conv_pending = false;
+            bus->errors[OW_ERR_POWER]++;
+        }
+    }
+}
+
+static inline void ds_transmit(ds18b20_t* d, const uint8_t* buf, int len, ds_state_t after) {
+    memcpy(d->tx_buf, buf, len);
+    d->tx_len = len * 8;
+    d->tx_pos = 0;
+    d->after_tx = after;
+    d->state = DS_TX;
+}
+
+static inline void ds_function(ow_bus_t* bus, ds18b20_t* d, uint8_t cmd) {
+    switch (cmd) {
+    case 0x44:
+        d->conv_start_us = bus->now_us;
+        d->conv_done_us = bus->now_us + (uint64_t)(ds_conversion_us(d) * (0.75 + 0.25 * ow_uniform(bus)));
+        d->conv_pending = true;
+        d->state = DS_CONVERTING;
+        break;
+    case 0xBE:
+        ds_settle(bus, d);
+        ds_transmit(d, d->scratch, 9, DS_IDLE);
+        break;
+    case 0x4E:
+        d->rx_count = 0;
+        d->state = DS_RX;
+        break;
+    case 0xB4:
+        d->state = DS_POWER;
+        break;
+    default:
+        d->state = DS_IDLE;
+        break;
+    }
+}
+
+// A bit the master wrote
+static inline void ds_receive(ow_bus_t* bus, ds18b20_t* d, uint8_t bit) {
+    if (d->state == DS_MATCH) {
+        uint8_t want = (d->rom[d->rx_bits >> 3] >> (d->rx_bits & 7)) & 1;
+        if (bit != want) {
+            d->state = DS_IDLE;
+        } else if (++d->rx_bits == 64) {
+            d->rx_bits = 0;
+            d->state = DS_FUNC;
+        }
+        return;
+    }
+    if (d->state == DS_SEARCH) {
+        uint8_t own = (d->rom[d->search_bit >> 3] >> (d->search_bit & 7)) & 1;
+        if (bit != own) {
+            d->state = DS_IDLE;
+        } else {
+            d->search_sub = 0;
+            if (++d->search_bit == 64) d->state = DS_FUNC;
+        }
+        return;
+    }
+
+    d->rx_byte |= bit << d->rx_bits;
+    if (++d->rx_bits < 8) return;
+    uint8_t byte = d->rx_byte;
+    d->rx_byte = 0;
+    d->rx_bits = 0;
+
+    if (d->state == DS_ROM_CMD) {
+        switch (byte) {
+        case 0x33:
+            ds_transmit(d, d->rom, 8, DS_FUNC);
+            break;
+        case 0x55:
+            d->state = DS_MATCH;
+            break;
+        case 0xCC:
+            d->state = DS_FUNC;
+            break;
+        case 0xF0:
+            d->search_bit = 0;
+            d->search_sub = 0;
+            d->state = DS_SEARCH;
+            break;
+        default:    // Alarm search (no alarms) and the rest
+            d->state = DS_IDLE;
+            break;
+        }
+    } else if (d->state == DS_FUNC) {
+        ds_function(bus, d, byte);
+    } else if (d->state == DS_RX) {
+        d->rx_buf[d->rx_count++] = byte;
+        if (d->rx_count == 3) {
+            d->scratch[2] = d->rx_buf[0];
+            d->scratch[3] = d->rx_buf[1];
+            if (d->rom[0] != 0x10) d->scratch[4] = (d->rx_buf[2] & 0x60) | 0x1F;
+            d->scratch[8] = ow_model_crc8(d->scratch, 8);
+            d->state = DS_IDLE;
+        }
+    }
+}
+
+// Master drives the bus low
+static inline void ow_bus_low(ow_bus_t* bus) {
+    ow_bus_check_power(bus);
+    uint64_t t = bus->now_us;
+    if (bus->started) {
+        if (bus->last_reset) {
+            if (t - bus->rise_us < 480) bus->errors[OW_ERR_RESET_RECOVERY]++;
+        } else if (t - bus->fall_us < 60 || t - bus->rise_us < 1) {
+            bus->errors[OW_ERR_SLOT]++;
+        }
+    }
+    for (int i = 0; i < bus->count; ++i) {
+        if (bus->dev[i].hold_until_us > t) bus->errors[OW_ERR_SLOT]++;
+    }
+    bus->started = true;
+    bus->master_low = true;
+    bus->strong = false;
+    bus->fall_us = t;
+
+    // Sensors sending a bit hold the bus low for 15-60 us to send a 0
+    for (int i = 0; i < bus->count; ++i) {
+        ds18b20_t* d = &bus->dev[i];
+        int bit = -1;
+        if (d->state == DS_TX) {
+            bit = (d->tx_buf[d->tx_pos >> 3] >> (d->tx_pos & 7)) & 1;
+            if (++d->tx_pos == d->tx_len) d->state = d->after_tx;
+        } else if (d->state == DS_SEARCH && d->search_sub < 2) {
+            uint8_t own = (d->rom[d->search_bit >> 3] >> (d->search_bit & 7)) & 1;
+            bit = d->search_sub++ == 0 ? own : !own;
+        } else if (d->state == DS_CONVERTING) {
+            bit = d->parasite || !d->conv_pending || t >= d->conv_done_us;
+        } else if (d->state == DS_POWER) {
+            bit = !d->parasite;
+        }
+        if (bit < 0) continue;
+        d->sending = true;
+        if (ow_uniform(bus) < d->flip_rate) bit = !bit;
+        if (bit == 0) {
+            d->hold_from_us = t;
+            d->hold_until_us = t + ow_random_us(bus, 15, 60);
+        }
+    }
+}
+
+// Master releases the bus (the pull-up raises it)
+static inline void ow_bus_release(ow_bus_t* bus) {
+    uint64_t t = bus->now_us;
+    if (!bus->master_low) return;
+    bus->master_low = false;
+    bus->rise_us = t;
+    uint64_t low = t - bus->fall_us;
+    bus->last_reset = low >= 480;
+
+    if (low >= 480) {
+        bus->resets++;
+        for (int i = 0; i < bus->count; ++i) {
+            ds18b20_t* d = &bus->dev[i];
+            if (d->parasite && low > 960) {
+                ds_power_up(d);
+                bus->por++;
+            }
+            ds_settle(bus, d);
+            d->state = DS_ROM_CMD;
+            d->sending = false;
+            d->rx_byte = 0;
+            d->rx_bits = 0;
+            d->hold_from_us = t + ow_random_us(bus, 15, 60);
+            d->hold_until_us = d->hold_from_us + ow_random_us(bus, 60, 240);
+        }
+        return;
+    }
+
+    int bit = -1;
+    if (low >= 1 && low <= 15) bit = 1;
+    else if (low >= 60 && low <= 120) bit = 0;
+    else bus->errors[OW_ERR_LOW_TIME]++;
+
+    for (int i = 0; i < bus->count; ++i) {
+        ds18b20_t* d = &bus->dev[i];
+        if (d->sending) {
+            d->sending = false;
+            continue;
+        }
+        bool receiving = d->state == DS_ROM_CMD || d->state == DS_MATCH || d->state == DS_FUNC ||
+                         d->state == DS_RX || (d->state == DS_SEARCH && d->search_sub == 2);
+        if (!receiving) continue;
+        if (bit < 0) d->state = DS_IDLE;
+        else ds_receive(bus, d, (uint8_t)bit);
+    }
+}
+
+// Level of the bus now
+static inline uint8_t ow_bus_level(ow_bus_t* bus) {
+    if (bus->master_low) return 0;
+    for (int i = 0; i < bus->count; ++i) {
+        const ds18b20_t* d = &bus->dev[i];
+        if (bus->now_us >= d->hold_from_us && bus->now_us < d->hold_until_us) return 0;
+    }
+    return 1;
+}
+
+// The master samples the bus in a read slot or for presence
+static inline uint8_t ow_bus_sample(ow_bus_t* bus) {
+    uint64_t t = bus->now_us;
+    if (bus->last_reset) {
+        if (t - bus->rise_us < 60 || t - bus->rise_us > 75) bus->errors[OW_ERR_PRESENCE_SAMPLE]++;
+    } else {
+        if (t - bus->fall_us >= 15) bus->errors[OW_ERR_READ_SAMPLE]++;
+    }
+    return ow_bus_level(bus);
+}
+
+static inline void ow_bus_power(ow_bus_t* bus, bool on) {
+    if (!on) ow_bus_check_power(bus);
+    bus->strong = on;
+}
+
+#endif // DS18B20_MODEL_H
@@ -0,0 +1,314 @@
+/*
+ * OneWire Async Simulation - Search and conversions on a modeled sensor bus
+ * Steps the engine of lib/OneWire/OneWireAsync.h against the bus model of
+ * Ds18b20Model.h in virtual time, the way OneWireAsync runs it on ESP32:
+ * waits up to ONEWIRE_ASYNC_SPIN_US are spun in the callback, longer ones
+ * go through the timer, which adds 5 us to --latency us and now and then
+ * (--preempt percent of the time) up to 2 ms of a higher priority task.
+ * Each scenario searches the bus once and reads all sensors for --rounds
+ * conversions, each at new temperatures:
+ *
+ *   search      ROMs found against the bus, and passes taken
+ *   temps       readings reported ok, wrong (ok but not this round's
+ *               temperature, must be 0) and failed (CRC, no presence)
+ *   convert     from Convert T to the first scratchpad read, against the
+ *               750 ms a blocking reader waits
+ *   timing      datasheet violations seen by the sensors (must be 0), the
+ *               longest time with interrupts off and the longest callback;
+ *               callbacks which saw busy() false are listed (must be none,
+ *               the operation ends after its last callback)
+ *   cpu         time spent in callbacks per round, against the time a
+ *               blocking OneWire holds loop() for the same slots plus
+ *               delay(750)
+ *
+ * Build (from the project root):
+ *   g++ -O2 -Ilib/OneWire tools/onewire_sim/onewire_sim.cpp -o onewire_sim
+ *
+ * Usage:
+ *   ./onewire_sim                       # 20 rounds per scenario
+ *   ./onewire_sim --rounds 100 --latency 200 --preempt 5 --seed 7
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "OneWireAsync.h"
+#include "Ds18b20Model.h"
+
+// Time the CPU takes for a step outside of the slot itself
+#define SIM_STEP_US 2
+
+static ow_bus_t bus;
+
+typedef struct {
+    uint32_t max_masked_us;
+    uint32_t slots_write1, slots_write0, slots_read;
+} sim_pin_stats_t;
+
+static sim_pin_stats_t pin_stats;
+
+// The Pin of OneWireAsyncT, on the bus model
+class SimPin {
+public:
+    uint8_t read() { return ow_bus_level(&bus); }
+
+    void low() { ow_bus_low(&bus); }
+
+    uint8_t slot(uint16_t lowUs, uint16_t sampleUs, bool power = false) {
+        uint64_t start = bus.now_us;
+        uint8_t r = 1;
+        if (lowUs) {
+            ow_bus_low(&bus);
+            bus.now_us += lowUs;
+        }
+        ow_bus_release(&bus);
+        if (sampleUs) {
+            bus.now_us += sampleUs;
+            r = ow_bus_sample(&bus);
+        }
+        if (power) ow_bus_power(&bus, true);
+        uint32_t masked = (uint32_t)(bus.now_us - start);
+        if (masked > pin_stats.max_masked_us) pin_stats.max_masked_us = masked;
+        if (lowUs && sampleUs) pin_stats.slots_read++;
+        else if (lowUs && lowUs < 15) pin_stats.slots_write1++;
+        else if (lowUs && lowUs < 480) pin_stats.slots_write0++;
+        return r;
+    }
+
+    void power(bool on) { ow_bus_power(&bus, on); }
+};
+
+typedef OneWireAsyncT<SimPin> SimOneWire;
+
+typedef struct {
+    const char* name;
+    int sensors;
+    bool parasite;
+    int shared_prefix;          // ROMs differ only after this many bits
+    double flip_rate;
+    uint8_t config;             // DS18B20 resolution byte, 0x7F: 12 bit
+} sim_scenario_t;
+
+static const sim_scenario_t scenarios[] = {
+    {"1 DS18B20", 1, false, 0, 0, 0x7F},
+    {"8 mixed DS18B20/DS18S20, close ROMs", 8, false, 40, 0, 0x7F},
+    {"20 DS18B20 at 10 bit", 20, false, 0, 0, 0x3F},
+    {"4 parasite powered", 4, true, 0, 0, 0x7F},
+    {"12 sensors, bit errors 1e-3", 12, false, 8, 1e-3, 0x7F},
+    {"empty bus", 0, false, 0, 0, 0x7F},
+};
+
+typedef struct {
+    uint32_t latency_us;
+    double preempt;
+    uint32_t seed;
+} sim_options_t;
+
+typedef struct {
+    uint64_t busy_us;
+    uint32_t max_callback_us;
+} sim_cpu_t;
+
+static uint32_t sim_rand_state = 1;
+
+static uint32_t sim_random(uint32_t max) {
+    sim_rand_state = sim_rand_state * 1103515245u + 12345u;
+    uint32_t r = (sim_rand_state >> 16) | ((sim_rand_state * 1103515245u + 12345u) >> 16 << 15);
+    return r % (max + 1);
+}
+
+// Run the engine until it is idle (or the bus saw until_resets resets), as OneWireAsync::onTimer() does
+static void sim_run(SimOneWire& ow, const sim_options_t* opt, sim_cpu_t* cpu, uint32_t until_resets = UINT32_MAX) {
+    uint64_t callback_start = bus.now_us;
+    while (ow.busy() && bus.resets < until_resets) {
+        uint64_t t0 = bus.now_us;
+        uint32_t us = ow.step((uint32_t)bus.now_us);
+        bus.now_us += SIM_STEP_US;
+        cpu->busy_us += bus.now_us - t0;
+        if (us && us <= ONEWIRE_ASYNC_SPIN_US) {
+            bus.now_us += us;
+            cpu->busy_us += us;
+            continue;
+        }
+        uint32_t callback = (uint32_t)(bus.now_us - callback_start);
+        if (callback > cpu->max_callback_us) cpu->max_callback_us = callback;
+        if (!us) break;
+        uint64_t wait = us + 5 + sim_random(opt->latency_us > 5 ? opt->latency_us - 5 : 0);
+        if (sim_random(9999) < opt->preempt * 100) wait += sim_random(2000);
+        bus.now_us += wait;
+        callback_start = bus.now_us;
+    }
+}
+
+//
+// Callbacks
+//
+
+static SimOneWire* sim_ow;
+static uint32_t idle_callbacks;     // Callbacks which saw busy() false
+
+static uint8_t found_count;
+
+static void on_search(uint8_t count, void* arg) {
+    (void)arg;
+    found_count = count;
+    if (!sim_ow->busy()) idle_callbacks++;
+}
+
+typedef struct {
+    uint32_t ok, wrong, failed, reported;
+    int16_t expected[OW_MODEL_MAX_DEVICES];
+    uint8_t roms[OW_MODEL_MAX_DEVICES][8];
+} sim_round_t;
+
+static sim_round_t round_state;
+
+static void on_temp(uint8_t index, const uint8_t* rom, int16_t temp16, bool ok, void* arg) {
+    (void)rom;
+    sim_round_t* r = (sim_round_t*)arg;
+    r->reported++;
+    if (!sim_ow->busy()) idle_callbacks++;
+    if (!ok) {
+        r->failed++;
+        return;
+    }
+    if (temp16 == r->expected[index]) r->ok++;
+    else r->wrong++;
+}
+
+static int sim_find_device(const uint8_t rom[8]) {
+    for (int i = 0; i < bus.count; ++i) {
+        if (!memcmp(bus.dev[i].rom, rom, 8)) return i;
+    }
+    return -1;
+}
+
+static int16_t sim_expected16(const ds18b20_t* d) {
+    int16_t t16 = (int16_t)lround(d->temp_c * 16);
+    if (d->rom[0] != 0x10) {
+        int bits = 9 + ((d->scratch[4] >> 5) & 3);
+        t16 &= ~((1 << (12 - bits)) - 1);
+    }
+    return t16;
+}
+
+static void sim_scenario(const sim_scenario_t* sc, int rounds, const sim_options_t* opt) {
+    ow_bus_init(&bus, opt->seed);
+    sim_rand_state = opt->seed;
+    memset(&pin_stats, 0, sizeof(pin_stats));
+
+    // ROMs: family, then random serials; close ROMs share their first bits
+    uint8_t base[7];
+    for (int b = 0; b < 7; ++b) base[b] = (uint8_t)sim_random(255);
+    for (int i = 0; i < sc->sensors; ++i) {
+        uint8_t rom7[7];
+        for (int b = 0; b < 7; ++b) rom7[b] = (uint8_t)sim_random(255);
+        for (int bit = 8; bit < sc->shared_prefix; ++bit) {
+            uint8_t mask = 1 << (bit & 7);
+            rom7[bit >> 3] = (rom7[bit >> 3] & ~mask) | (base[bit >> 3] & mask);
+        }
+        rom7[0] = (sc->shared_prefix && (i & 1)) ? 0x10 : 0x28;
+        int d = ow_bus_add(&bus, rom7, sc->parasite, 20.0);
+        if (rom7[0] == 0x28) {
+            bus.dev[d].scratch[4] = sc->config;
+            bus.dev[d].scratch[8] = ow_model_crc8(bus.dev[d].scratch, 8);
+        }
+        bus.dev[d].flip_rate = sc->flip_rate;
+    }
+
+    SimOneWire ow;
+    sim_ow = &ow;
+    idle_callbacks = 0;
+    sim_cpu_t cpu = {0, 0};
+
+    // Search
+    uint64_t t0 = bus.now_us;
+    found_count = 0;
+    ow.search(round_state.roms, OW_MODEL_MAX_DEVICES, on_search);
+    sim_run(ow, opt, &cpu);
+    double search_ms = (bus.now_us - t0) / 1000.0;
+    int found_ok = 0;
+    for (int i = 0; i < found_count; ++i) {
+        if (sim_find_device(round_state.roms[i]) >= 0) found_ok++;
+    }
+    printf("%s\n  search    found %d/%d%s  %u passes  %.1f ms\n", sc->name, found_ok, sc->sensors,
+           found_count != found_ok ? "  WRONG ROMS" : "", bus.resets, search_ms);
+    cpu.busy_us = 0;
+    uint32_t slots_read = pin_stats.slots_read, slots_w1 = pin_stats.slots_write1;
+    uint32_t slots_w0 = pin_stats.slots_write0, resets = bus.resets;
+    uint32_t polls = 0;
+
+    // Conversions
+    uint32_t ok = 0, wrong = 0, failed = 0;
+    double convert_ms = 0;
+    uint8_t count = sc->sensors ? found_count : 1;
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < bus.count; ++i) {
+            bus.dev[i].temp_c = -10 + 50 * (sim_random(10000) / 10000.0);
+        }
+        memset(round_state.expected, 0, sizeof(round_state.expected));
+        for (int i = 0; i < count && sc->sensors; ++i) {
+            int d = sim_find_device(round_state.roms[i]);
+            if (d >= 0) round_state.expected[i] = sim_expected16(&bus.dev[d]);
+        }
+        round_state.ok = round_state.wrong = round_state.failed = round_state.reported = 0;
+        uint64_t start = bus.now_us;
+        uint32_t reads = pin_stats.slots_read;
+        ow.requestTemperatures(sc->sensors ? round_state.roms : NULL, count, on_temp, &round_state,
+                               750, sc->parasite);
+        // Convert T is the first reset, the first scratchpad read the second
+        sim_run(ow, opt, &cpu, bus.resets + 2);
+        convert_ms += (bus.now_us - start) / 1000.0;
+        polls += pin_stats.slots_read - reads;
+        sim_run(ow, opt, &cpu);
+        ok += round_state.ok;
+        wrong += round_state.wrong;
+        failed += round_state.failed;
+        bus.now_us += 100000;
+    }
+
+    printf("  temps     %u ok  %u wrong  %u failed  of %u\n", ok, wrong, failed, rounds * count);
+    printf("  convert   %.0f ms to the first read (blocking: 750)%s\n", convert_ms / rounds,
+           bus.por ? "  sensors powered up again" : "");
+    uint32_t violations = 0;
+    printf("  timing   ");
+    for (int e = 0; e < OW_ERR_COUNT; ++e) {
+        violations += bus.errors[e];
+        if (bus.errors[e]) printf(" %s %u", ow_err_names[e], bus.errors[e]);
+    }
+    if (!violations) printf(" 0 violations");
+    if (idle_callbacks) printf("  %u callbacks saw busy() false", idle_callbacks);
+    printf("  masked <= %u us  callback <= %u us\n", pin_stats.max_masked_us, cpu.max_callback_us);
+
+    // OneWire.cpp spends the whole slot in delays: reset 960 us, write 1 65, write 0 70, read 66.
+    // It doesn't poll the conversion.
+    double blocking_us = (bus.resets - resets) * 960.0 + (pin_stats.slots_write1 - slots_w1) * 65.0 +
+                         (pin_stats.slots_write0 - slots_w0) * 70.0 +
+                         (pin_stats.slots_read - slots_read - polls) * 66.0 + rounds * 750000.0;
+    printf("  cpu       %.2f ms per round in callbacks, loop() free (blocking: %.1f ms in loop())\n",
+           cpu.busy_us / 1000.0 / rounds, blocking_us / 1000.0 / rounds);
+}
+
+int main(int argc, char** argv) {
+    int rounds = 20;
+    sim_options_t opt = {50, 1.0, 1};
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--rounds") && i + 1 < argc) rounds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--latency") && i + 1 < argc) opt.latency_us = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--preempt") && i + 1 < argc) opt.preempt = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) opt.seed = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--rounds N] [--latency US] [--preempt PERCENT] [--seed N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("Timer latency 5-%u us, %.1f%% of waits up to 2 ms longer, spin <= %u us\n", opt.latency_us,
+           opt.preempt, ONEWIRE_ASYNC_SPIN_US);
+    for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); ++s) {
+        sim_scenario(&scenarios[s], rounds, &opt);
+    }
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ * AXP2101 Model - Register file of the PMU for host tests
+ * Holds the status, ADC, interrupt and fuel gauge registers of a battery
+ * that charges from VBUS or discharges into the system, worked out from the
+ * time of each read, and pulls IRQ low while an enabled interrupt status
+ * bit is set. Reads and writes auto-increment the register address like
+ * the chip, and the model remembers the true state of every register so a
+ * reader can be checked against it.
+ *
+ * Modeled: STATUS1/2 (VBUS good, battery present, charge direction and
+ * state), ADC results (battery, TS, VBUS, system, die temperature),
+ * INTEN1-3 and INTSTS1-3 (write 1 to clear; VBUS insert/remove, charge
+ * start/done), battery percent, IC type. Other registers read back what
+ * was written.
+ */
+
+#ifndef AXP2101_MODEL_H
+#define AXP2101_MODEL_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define AXP2101_MODEL_ADDRESS 0x34
+
+enum {
+    AXP2101_MODEL_STATUS1 = 0x00,
+    AXP2101_MODEL_STATUS2 = 0x01,
+    AXP2101_MODEL_IC_TYPE = 0x03,
+    AXP2101_MODEL_ADC_VBAT_H = 0x34,
+    AXP2101_MODEL_ADC_TEMP_L = 0x3D,
+    AXP2101_MODEL_INTEN1 = 0x40,
+    AXP2101_MODEL_INTSTS1 = 0x48,
+    AXP2101_MODEL_INTSTS3 = 0x4A,
+    AXP2101_MODEL_BAT_PERCENT = 0xA4,
+};
+
+// Interrupt status bits (INTSTS2, INTSTS3)
+#define AXP2101_MODEL_VBUS_INSERT 0x80
+#define AXP2101_MODEL_VBUS_REMOVE 0x40
+#define AXP2101_MODEL_CHG_START 0x08
+#define AXP2101_MODEL_CHG_DONE 0x10
+
+typedef struct {
+    uint8_t regs[256];
+    bool vbus;                    // Charger plugged in
+    bool charging;
+    double vbat_mv;               // Open circuit battery voltage
+    double percent;
+    uint64_t last_us;             // Time the battery was last worked out
+    bool irq_low;
+    void (*on_falling)(uint64_t now_us);
+} axp2101_model_t;
+
+static inline void axp2101_model_init(axp2101_model_t* m, void (*on_falling)(uint64_t)) {
+    memset(m->regs, 0, sizeof(m->regs));
+    m->regs[AXP2101_MODEL_IC_TYPE] = 0x4A;
+    m->vbus = false;
+    m->charging = false;
+    m->percent = 62;
+    m->vbat_mv = 3600 + 6 * m->percent;
+    m->last_us = 0;
+    m->irq_low = false;
+    m->on_falling = on_falling;
+}
+
+static inline void axp2101_model_update_irq(axp2101_model_t* m, uint64_t now_us) {
+    bool low = false;
+    for (int i = 0; i < 3; ++i) {
+        low |= (m->regs[AXP2101_MODEL_INTSTS1 + i] & m->regs[AXP2101_MODEL_INTEN1 + i]) != 0;
+    }
+    if (low && !m->irq_low && m->on_falling) m->on_falling(now_us);
+    m->irq_low = low;
+}
+
+static inline void axp2101_model_put_h8(axp2101_model_t* m, uint8_t reg, uint16_t value, uint8_t high_mask) {
+    m->regs[reg] = (value >> 8) & high_mask;
+    m->regs[reg + 1] = value & 0xFF;
+}
+
+// Bring the battery and the registers that follow it up to now_us
+static inline void axp2101_model_run(axp2101_model_t* m, uint64_t now_us) {
+    double dt = (now_us - m->last_us) * 1e-6;
+    m->last_us = now_us;
+    // 1% per 36 s charging, 1% per 90 s discharging
+    if (m->charging) {
+        m->percent += dt / 36;
+        if (m->percent >= 100) {
+            m->percent = 100;
+            m->charging = false;
+            m->regs[AXP2101_MODEL_INTSTS1 + 2] |= AXP2101_MODEL_CHG_DONE;
+        }
+    } else if (!m->vbus) {
+        m->percent -= dt / 90;
+        if (m->percent < 0) m->percent = 0;
+    }
+    m->vbat_mv = 3600 + 6 * m->percent;
+
+    double t = now_us * 1e-6;
+    uint16_t vbat = (uint16_t)(m->vbat_mv + (m->charging ? 80 : -40) + 6 * sin(t * 7.3));
+    uint16_t vbus = m->vbus ? (uint16_t)(5050 + 20 * sin(t * 3.1)) : 0;
+    uint16_t vsys = m->vbus ? 5000 : vbat - 30;
+    uint16_t temp = (uint16_t)(7274 - 20 * (35 + 3 * sin(t * 0.01) - 22));   // Inverse of XPOWERS_AXP2101_CONVERSION
+    axp2101_model_put_h8(m, 0x34, vbat, 0x1F);
+    axp2101_model_put_h8(m, 0x36, 0, 0x3F);
+    axp2101_model_put_h8(m, 0x38, vbus, 0x3F);
+    axp2101_model_put_h8(m, 0x3A, vsys, 0x3F);
+    axp2101_model_put_h8(m, 0x3C, temp, 0x3F);
+    m->regs[AXP2101_MODEL_BAT_PERCENT] = (uint8_t)m->percent;
+
+    // VBUS good, BATFET on, battery present, active
+    m->regs[AXP2101_MODEL_STATUS1] = (m->vbus ? 0x20 : 0) | 0x1C;
+    // Direction in 7:5 (01 charging, 10 discharging), system on, charger state in 2:0 (011 CC, 100 done)
+    uint8_t dir = m->charging ? 0x20 : (m->vbus ? 0x00 : 0x40);
+    uint8_t state = m->charging ? 0x03 : (m->vbus ? 0x04 : 0x00);
+    m->regs[AXP2101_MODEL_STATUS2] = dir | 0x10 | state;
+    axp2101_model_update_irq(m, now_us);
+}
+
+static inline void axp2101_model_set_vbus(axp2101_model_t* m, bool on, uint64_t now_us) {
+    axp2101_model_run(m, now_us);
+    if (on == m->vbus) return;
+    m->vbus = on;
+    m->charging = on && m->percent < 100;
+    m->regs[AXP2101_MODEL_INTSTS1 + 1] |= on ? AXP2101_MODEL_VBUS_INSERT : AXP2101_MODEL_VBUS_REMOVE;
+    if (m->charging) m->regs[AXP2101_MODEL_INTSTS1 + 2] |= AXP2101_MODEL_CHG_START;
+    axp2101_model_run(m, now_us);
+}
+
+static inline void axp2101_model_read(axp2101_model_t* m, uint8_t reg, uint8_t* buf, uint8_t len, uint64_t now_us) {
+    axp2101_model_run(m, now_us);
+    for (uint8_t i = 0; i < len; ++i) buf[i] = m->regs[(uint8_t)(reg + i)];
+}
+
+static inline void axp2101_model_write(axp2101_model_t* m, uint8_t reg, const uint8_t* buf, uint8_t len, uint64_t now_us) {
+    axp2101_model_run(m, now_us);
+    for (uint8_t i = 0; i < len; ++i) {
+        uint8_t r = reg + i;
+        if (r >= AXP2101_MODEL_INTSTS1 && r <= AXP2101_MODEL_INTSTS3) {
+            m->regs[r] &= ~buf[i];   // Write 1 to clear
+        } else if (r <= AXP2101_MODEL_STATUS2 || r == AXP2101_MODEL_IC_TYPE ||
+                   (r >= AXP2101_MODEL_ADC_VBAT_H && r <= AXP2101_MODEL_ADC_TEMP_L) ||
+                   r == AXP2101_MODEL_BAT_PERCENT) {
+            continue;                // Read only
+        } else {
+            m->regs[r] = buf[i];
+        }
+    }
+    axp2101_model_update_irq(m, now_us);
+}
+
+#endif // AXP2101_MODEL_H
@@ -0,0 +1,228 @@
+/*
+ * AXP2101 Snapshot Simulation - Register reads per battery display refresh
+ * Runs the real driver (lib/XPowersLib/src/XPowersAXP2101.tpp) on the
+ * register model of Axp2101Model.h through XPowersLib's custom I2C
+ * callbacks, which count the bus transactions and take the time they would
+ * on a 400 kHz bus. A battery widget refreshes at 5 Hz with the getters a
+ * status bar uses (charge state, VBUS, percent, battery/VBUS/system voltage,
+ * temperature) while the charger is plugged in and out at random, and the
+ * loop serves the PMU interrupt every 10 ms:
+ *
+ *   direct       every getter reads the chip (the driver's default)
+ *   snapshot     setSnapshotMaxAge(), getIrqStatus() invalidates on IRQ
+ *   no irq       setSnapshotMaxAge() with the IRQ pin not wired
+ *
+ * Reported per mode: I2C transactions per second and bus time, transactions
+ * per widget refresh, refreshes that showed the wrong charge state and the
+ * longest it took a plug or unplug to show, and the largest error of the
+ * shown battery voltage and percent against the model's registers.
+ *
+ * Build (from the project root):
+ *   g++ -O2 -Ilib/XPowersLib/src tools/pmu_sim/snapshot_sim.cpp \
+ *       lib/XPowersLib/src/XPowersLibInterface.cpp -o pmu_sim
+ *
+ * Usage:
+ *   ./pmu_sim                     # 600 s per mode, 1000 ms max age
+ *   ./pmu_sim --seconds 3600 --max-age 2000 --seed 7
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t sim_millis(void);
+#define XPOWERS_MILLIS() sim_millis()
+
+// The driver logs with printf on Linux, keep the report readable
+#undef linux
+
+#include "XPowersAXP2101.tpp"
+#include "Axp2101Model.h"
+
+#define SIM_I2C_HZ 400000
+#define SIM_LOOP_US 10000
+#define SIM_REFRESH_US 200000
+
+enum { SIM_DIRECT, SIM_SNAPSHOT, SIM_NO_IRQ };
+static const char* const sim_mode_names[] = {"direct", "snapshot", "no irq"};
+
+typedef struct {
+    uint32_t transactions;
+    uint64_t bus_us;
+    uint32_t refreshes;
+    uint32_t refresh_transactions;
+    uint32_t refresh_transactions_max;
+    uint32_t wrong_state;             // Refreshes showing the charge state before the last plug/unplug
+    uint64_t latency_max_us;          // Plug/unplug until a refresh showed it
+    uint32_t vbat_err_max;            // mV
+    uint32_t percent_err_max;
+    uint32_t events;
+} sim_result_t;
+
+static uint64_t sim_now_us;
+static uint32_t sim_rand = 1;
+static axp2101_model_t model;
+static sim_result_t* sim_res;
+static volatile bool sim_irq_flag;
+
+static uint32_t sim_millis(void) {
+    return (uint32_t)(sim_now_us / 1000);
+}
+
+static uint32_t sim_random(uint32_t max) {
+    sim_rand = sim_rand * 1103515245u + 12345u;
+    uint32_t r = (sim_rand >> 16) | ((sim_rand * 1103515245u + 12345u) >> 16 << 15);
+    return r % (max + 1);
+}
+
+static void sim_falling(uint64_t now_us) {
+    (void)now_us;
+    sim_irq_flag = true;
+}
+
+//
+// I2C callbacks: address and register, a repeated start and address for
+// reads, the data bytes, each with its ack bit, plus start/stop
+//
+
+static void sim_bus(uint8_t len, bool read) {
+    uint64_t bits = (uint64_t)(2 + (read ? 1 : 0) + len) * 9 + (read ? 3 : 2);
+    uint64_t us = (bits * 1000000 + SIM_I2C_HZ - 1) / SIM_I2C_HZ;
+    sim_res->transactions++;
+    sim_res->bus_us += us;
+    sim_now_us += us;
+}
+
+static int sim_read(uint8_t addr, uint8_t reg, uint8_t* data, uint8_t len) {
+    if (addr != AXP2101_MODEL_ADDRESS) return -1;
+    axp2101_model_read(&model, reg, data, len, sim_now_us);
+    sim_bus(len, true);
+    return 0;
+}
+
+static int sim_write(uint8_t addr, uint8_t reg, uint8_t* data, uint8_t len) {
+    if (addr != AXP2101_MODEL_ADDRESS) return -1;
+    sim_bus(len, false);
+    axp2101_model_write(&model, reg, data, len, sim_now_us);
+    return 0;
+}
+
+static void sim_run(int mode, uint32_t seconds, uint32_t max_age_ms, uint32_t seed, sim_result_t* r) {
+    memset(r, 0, sizeof(*r));
+    sim_res = r;
+    sim_now_us = 0;
+    sim_rand = seed;
+    sim_irq_flag = false;
+    axp2101_model_init(&model, mode == SIM_NO_IRQ ? NULL : sim_falling);
+
+    XPowersAXP2101 pmu(AXP2101_MODEL_ADDRESS, sim_read, sim_write);
+    if (!pmu.init()) {
+        fprintf(stderr, "AXP2101 model not found\n");
+        exit(1);
+    }
+    pmu.enableBattVoltageMeasure();
+    pmu.enableVbusVoltageMeasure();
+    pmu.enableSystemVoltageMeasure();
+    pmu.enableTemperatureMeasure();
+    pmu.disableIRQ(XPOWERS_AXP2101_ALL_IRQ);
+    pmu.clearIrqStatus();
+    pmu.enableIRQ(XPOWERS_AXP2101_VBUS_INSERT_IRQ | XPOWERS_AXP2101_VBUS_REMOVE_IRQ |
+                  XPOWERS_AXP2101_BAT_CHG_DONE_IRQ | XPOWERS_AXP2101_BAT_CHG_START_IRQ);
+    if (mode != SIM_DIRECT) pmu.setSnapshotMaxAge(max_age_ms);
+
+    uint64_t end_us = (uint64_t)seconds * 1000000;
+    uint64_t next_event_us = 20000000 + sim_random(40000) * 1000ULL;
+    uint64_t event_us = 0;            // Last plug/unplug
+    bool event_shown = true;
+    uint64_t next_refresh_us = SIM_REFRESH_US;
+    // Setup is not counted
+    r->transactions = 0;
+    r->bus_us = 0;
+
+    while (sim_now_us < end_us) {
+        uint64_t loop_us = sim_now_us + SIM_LOOP_US - sim_now_us % SIM_LOOP_US;
+        if (next_event_us <= loop_us) {
+            sim_now_us = next_event_us;
+            axp2101_model_set_vbus(&model, !model.vbus, sim_now_us);
+            event_us = sim_now_us;
+            event_shown = false;
+            r->events++;
+            next_event_us += 30000000 + sim_random(60000) * 1000ULL;
+        }
+        sim_now_us = loop_us;
+
+        if (sim_irq_flag) {
+            sim_irq_flag = false;
+            pmu.getIrqStatus();
+            pmu.clearIrqStatus();
+        }
+
+        if (sim_now_us < next_refresh_us) continue;
+        next_refresh_us += SIM_REFRESH_US;
+
+        // The battery widget
+        uint32_t t0 = r->transactions;
+        bool charging = pmu.isCharging();
+        bool discharging = pmu.isDischarge();
+        bool standby = pmu.isStandby();
+        bool vbus = pmu.isVbusIn();
+        bool battery = pmu.isBatteryConnect();
+        int percent = pmu.getBatteryPercent();
+        uint16_t vbat = pmu.getBattVoltage();
+        uint16_t vbusMv = pmu.getVbusVoltage();
+        uint16_t vsys = pmu.getSystemVoltage();
+        float temp = pmu.getTemperature();
+        xpowers_chg_status_t chg = pmu.getChargerStatus();
+        (void)discharging; (void)standby; (void)battery; (void)vbusMv; (void)vsys; (void)temp; (void)chg;
+        uint32_t n = r->transactions - t0;
+        r->refreshes++;
+        r->refresh_transactions += n;
+        if (n > r->refresh_transactions_max) r->refresh_transactions_max = n;
+
+        // Against the chip now
+        axp2101_model_run(&model, sim_now_us);
+        bool ok = charging == model.charging && vbus == model.vbus;
+        if (!ok) r->wrong_state++;
+        if (ok && !event_shown) {
+            event_shown = true;
+            if (sim_now_us - event_us > r->latency_max_us) r->latency_max_us = sim_now_us - event_us;
+        }
+        uint16_t true_vbat = ((model.regs[0x34] & 0x1F) << 8) | model.regs[0x35];
+        uint32_t verr = vbat > true_vbat ? vbat - true_vbat : true_vbat - vbat;
+        if (verr > r->vbat_err_max) r->vbat_err_max = verr;
+        uint32_t perr = abs(percent - (int)model.regs[AXP2101_MODEL_BAT_PERCENT]);
+        if (perr > r->percent_err_max) r->percent_err_max = perr;
+    }
+}
+
+static void sim_print(int mode, uint32_t seconds, const sim_result_t* r) {
+    printf("  %-8s i2c/s %6.1f bus %5.2f%%  per refresh %5.2f (max %2u)  wrong state %4u/%u  shown after <= %4llu ms"
+           "  vbat err %3u mV  percent err %u\n",
+           sim_mode_names[mode], r->transactions / (double)seconds, r->bus_us / (seconds * 1e4),
+           r->refresh_transactions / (double)r->refreshes, r->refresh_transactions_max, r->wrong_state,
+           r->refreshes, (unsigned long long)(r->latency_max_us / 1000), r->vbat_err_max, r->percent_err_max);
+}
+
+int main(int argc, char** argv) {
+    uint32_t seconds = 600;
+    uint32_t max_age_ms = 1000;
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--max-age") && i + 1 < argc) max_age_ms = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--seconds N] [--max-age MS] [--seed N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("Battery widget at 5 Hz, PMU interrupt served every 10 ms, max age %u ms\n", max_age_ms);
+    for (int mode = SIM_DIRECT; mode <= SIM_NO_IRQ; ++mode) {
+        sim_result_t r;
+        sim_run(mode, seconds, max_age_ms, seed, &r);
+        sim_print(mode, seconds, &r);
+    }
+    return 0;
+}
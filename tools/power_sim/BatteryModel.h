@@ -0,0 +1,166 @@
+/*
+ * Battery Model - A 1S LiPo cell under the load of the board, for host tests
+ * Integrates the state of charge from the current, and gives the voltage at
+ * the cell's terminals: open-circuit voltage of the charge, less the drop
+ * over the series resistance and a polarization RC (which recovers over
+ * tens of seconds after a load step). The charger runs constant current
+ * until the cell reaches 4.2 V, then constant voltage until the current
+ * falls to the termination level or the cell is full. The ADC reading adds noise, rare spikes
+ * (a sample taken during a radio burst) and 2 mV steps (1 mV at the pin
+ * behind the 1:2 divider).
+ *
+ * Load profiles (mA drawn by the board) model what the device does: idle,
+ * the panel switched on for a while every few minutes with radio bursts
+ * while it's on, and the same with a charger plugged in for a while.
+ */
+
+#ifndef BATTERY_MODEL_H
+#define BATTERY_MODEL_H
+
+#include <math.h>
+#include <stdint.h>
+
+// Open-circuit voltage in steps of 5%, a datasheet curve of a 1S LiPo at 25 C
+static const double battery_ocv_mv[21] = {
+    3280, 3490, 3595, 3655, 3685, 3712, 3728, 3748, 3768, 3786, 3808,
+    3832, 3858, 3886, 3918, 3952, 3988, 4026, 4068, 4116, 4175,
+};
+
+typedef enum {
+    BATTERY_IDLE,       // Screen off, 45 mA
+    BATTERY_UI,         // Panel on for 20-60 s every 1-4 min, radio bursts while on
+    BATTERY_CHARGE,     // UI load, charger plugged in from 1 h to 3 h
+} battery_profile_t;
+
+typedef struct {
+    battery_profile_t profile;
+    double soc;                 // 0-1
+    double capacity_mah;
+    double r_ohm;               // Series resistance
+    double rc_ohm;              // Polarization
+    double rc_tau_s;
+    double v_rc;                // Voltage over the polarization RC
+    double i_ma;                // Current out of the cell (negative while charging)
+    bool usb;
+    bool charging;              // Charger is putting current in
+    double cc_ma;               // Charge current
+    double term_ma;             // Termination current
+    double t_s;
+    double screen_until_s;      // Panel on until
+    double next_screen_s;       // Panel switched on next
+    double burst_until_s;
+    double next_burst_s;
+    double gauge_err;           // Error of a PMU fuel gauge, percent
+    uint64_t rng;
+} battery_model_t;
+
+static inline double battery_uniform(battery_model_t* b) {
+    b->rng = b->rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    return ((b->rng >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+static inline double battery_gauss(battery_model_t* b) {
+    return sqrt(-2.0 * log(battery_uniform(b))) * cos(2.0 * M_PI * battery_uniform(b));
+}
+
+static inline double battery_ocv(double soc) {
+    double x = soc * 20;
+    if (x <= 0) return battery_ocv_mv[0];
+    if (x >= 20) return battery_ocv_mv[20];
+    int i = (int)x;
+    return battery_ocv_mv[i] + (x - i) * (battery_ocv_mv[i + 1] - battery_ocv_mv[i]);
+}
+
+static inline void battery_init(battery_model_t* b, battery_profile_t profile, double soc, uint64_t seed) {
+    b->profile = profile;
+    b->soc = soc;
+    b->capacity_mah = 500;
+    b->r_ohm = 0.15;
+    b->rc_ohm = 0.08;
+    b->rc_tau_s = 25;
+    b->v_rc = 0;
+    b->i_ma = 0;
+    b->usb = false;
+    b->charging = false;
+    b->cc_ma = 250;
+    b->term_ma = 25;
+    b->t_s = 0;
+    b->screen_until_s = 0;
+    b->next_screen_s = 30;
+    b->burst_until_s = 0;
+    b->next_burst_s = 0;
+    b->gauge_err = 0;
+    b->rng = seed * 2654435761ULL + 1;
+}
+
+// Current the board draws at the time
+static inline double battery_load_ma(battery_model_t* b) {
+    double load = 45;
+    if (b->profile == BATTERY_IDLE) return load + 2 * battery_gauss(b);
+    if (b->t_s >= b->next_screen_s) {
+        b->screen_until_s = b->t_s + 20 + 40 * battery_uniform(b);
+        b->next_screen_s = b->screen_until_s + 60 + 180 * battery_uniform(b);
+        b->next_burst_s = b->t_s + 5;
+    }
+    if (b->t_s < b->screen_until_s) {
+        load += 110;
+        if (b->t_s >= b->next_burst_s) {
+            b->burst_until_s = b->t_s + 2;
+            b->next_burst_s = b->t_s + 10 + 20 * battery_uniform(b);
+        }
+        if (b->t_s < b->burst_until_s) load += 250;
+    }
+    return load + 3 * battery_gauss(b);
+}
+
+// Advance by dt seconds
+static inline void battery_step(battery_model_t* b, double dt) {
+    if (b->profile == BATTERY_CHARGE) {
+        bool usb = b->t_s >= 3600 && b->t_s < 3 * 3600;
+        if (usb && !b->usb) b->charging = true;
+        if (!usb) b->charging = false;
+        b->usb = usb;
+    }
+    double load = battery_load_ma(b);
+    if (b->charging) {
+        // The charger feeds the board, the cell gets CC, or CV once it is at 4.2 V
+        double ocv = battery_ocv(b->soc);
+        double cv_ma = (4200 - ocv - b->v_rc) / b->r_ohm;
+        double i = cv_ma < b->cc_ma ? cv_ma : b->cc_ma;
+        if (i < b->term_ma || b->soc >= 1) {
+            b->charging = false;
+            i = 0;
+        }
+        b->i_ma = -i;
+    } else {
+        b->i_ma = b->usb ? 0 : load;
+    }
+    b->soc -= b->i_ma * dt / 3600 / b->capacity_mah;
+    if (b->soc < 0) b->soc = 0;
+    if (b->soc > 1) b->soc = 1;
+    double target = b->i_ma * b->rc_ohm;
+    b->v_rc += (target - b->v_rc) * (1 - exp(-dt / b->rc_tau_s));
+    b->gauge_err = 1.5 * sin(b->t_s / 1800);
+    b->t_s += dt;
+}
+
+static inline double battery_terminal_mv(const battery_model_t* b) {
+    return battery_ocv(b->soc) - b->i_ma * b->r_ohm - b->v_rc;
+}
+
+// What the ADC divider reads, in battery millivolts
+static inline uint16_t battery_adc_mv(battery_model_t* b) {
+    double mv = battery_terminal_mv(b) + 12 * battery_gauss(b);
+    if (battery_uniform(b) < 0.005) mv -= 200;
+    return (uint16_t)(2 * (int)(mv / 2 + 0.5));
+}
+
+// What a PMU fuel gauge reports
+static inline int battery_gauge_pct(const battery_model_t* b) {
+    double pct = b->soc * 100 + b->gauge_err;
+    if (pct < 0) pct = 0;
+    if (pct > 100) pct = 100;
+    return (int)(pct + 0.5);
+}
+
+#endif // BATTERY_MODEL_H
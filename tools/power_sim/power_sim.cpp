@@ -0,0 +1,301 @@
+/*
+ * Power Monitor Simulation - Battery level updates on discharge and charge curves
+ * Runs include/state/PowerMonitor.h with AppState on the host, fed from the
+ * cell model of BatteryModel.h one second at a time, either through the ADC
+ * divider (voltage only, as on this board) or through a PMU (fuel gauge and
+ * charge state). Each run is compared with showing the percent of every raw
+ * ADC reading, sampled at the same interval:
+ *
+ *   pub/h       AppState updates per hour (battery widget redraws)
+ *   max/min     most updates in any minute
+ *   reversals   level shown going up while discharging or down while charging
+ *   err         shown level against the true state of charge, mean and max,
+ *               after the first 2 minutes (without a gauge this includes the
+ *               voltage drop of the load, which the curve can't know)
+ *   chg on/off  longest time from the charger starting or stopping (plugged,
+ *               unplugged, cell full) to AppState showing it
+ *
+ * Recorded data (t_ms,mv[,soc] per line, the battery side of the divider and
+ * the true charge 0-1 if known) is replayed with --csv, printing every
+ * update. --record writes a scenario in that format.
+ *
+ * Build (from the project root):
+ *   g++ -O2 -Iinclude tools/power_sim/power_sim.cpp -o power_sim
+ *
+ * Usage:
+ *   ./power_sim                           # built-in scenarios
+ *   ./power_sim --seed 7
+ *   ./power_sim --record 1 > ui.csv
+ *   ./power_sim --csv ui.csv
+ */
+
+#include "state/AppState.h"
+#include "state/PowerMonitor.h"
+#include "BatteryModel.h"
+
+#include <time.h>
+#include <vector>
+
+SerialClass Serial;
+
+// One second of the cell
+typedef struct {
+    uint32_t t_ms;
+    uint16_t mv;                // ADC reading
+    int8_t gauge;               // PMU fuel gauge
+    int8_t charging;            // True charger state
+    float soc;                  // True state of charge, < 0 if unknown
+} sim_trace_t;
+
+typedef struct {
+    const char* name;
+    battery_profile_t profile;
+    double soc;
+    double hours;
+} sim_scenario_t;
+
+static const sim_scenario_t scenarios[] = {
+    {"idle discharge", BATTERY_IDLE, 1.0, 12},
+    {"UI discharge", BATTERY_UI, 1.0, 8},
+    {"UI, charger 1 h to 3 h", BATTERY_CHARGE, 0.6, 5},
+};
+
+typedef struct {
+    uint32_t publishes;
+    uint32_t max_per_min;
+    uint32_t reversals;
+    double err_sum;
+    double err_max;
+    uint32_t err_cnt;
+    uint32_t on_ms;             // Longest delay of a charge state change, 0: none seen
+    uint32_t off_ms;
+    bool missed_charge;         // A charge state change never shown
+} sim_result_t;
+
+enum { SIM_ADC, SIM_PMU };
+
+static const std::vector<sim_trace_t>* sim_trace;
+static size_t sim_pos;
+static std::vector<uint32_t> sim_pub_ms;
+static std::vector<int> sim_pub_level;
+static std::vector<bool> sim_pub_charging;
+
+static bool sim_read_adc(PowerSample* out) {
+    out->millivolts = (*sim_trace)[sim_pos].mv;
+    out->percent = -1;
+    out->charging = -1;
+    return true;
+}
+
+static bool sim_read_pmu(PowerSample* out) {
+    const sim_trace_t& t = (*sim_trace)[sim_pos];
+    out->millivolts = t.mv;
+    out->percent = t.gauge;
+    out->charging = t.charging;
+    return true;
+}
+
+static void sim_on_power(float level, bool charging) {
+    sim_pub_ms.push_back((*sim_trace)[sim_pos].t_ms);
+    sim_pub_level.push_back((int)level);
+    sim_pub_charging.push_back(charging);
+}
+
+static void sim_generate(const sim_scenario_t& sc, uint32_t seed, std::vector<sim_trace_t>* out) {
+    battery_model_t b;
+    battery_init(&b, sc.profile, sc.soc, seed);
+    out->clear();
+    for (uint32_t s = 0; s < sc.hours * 3600 && b.soc > 0.02; ++s) {
+        battery_step(&b, 1.0);
+        sim_trace_t t;
+        t.t_ms = s * 1000;
+        t.mv = battery_adc_mv(&b);
+        t.gauge = (int8_t)battery_gauge_pct(&b);
+        t.charging = b.charging;
+        t.soc = (float)b.soc;
+        out->push_back(t);
+    }
+}
+
+// Score a list of shown levels against the trace
+static void sim_score(const std::vector<sim_trace_t>& trace, const std::vector<uint32_t>& pub_ms,
+                      const std::vector<int>& level, const std::vector<bool>* charging, sim_result_t* r) {
+    r->publishes = pub_ms.size();
+    size_t first = 0;
+    for (size_t i = 0; i < pub_ms.size(); ++i) {
+        while (pub_ms[i] - pub_ms[first] >= 60000) first++;
+        if (i - first + 1 > r->max_per_min) r->max_per_min = i - first + 1;
+    }
+
+    size_t p = 0;
+    int shown = -1;
+    bool shown_charging = false;
+    int8_t last_charging = trace.empty() ? 0 : trace[0].charging;
+    uint32_t change_ms = 0;
+    bool change_pending = false;
+    for (size_t i = 0; i < trace.size(); ++i) {
+        const sim_trace_t& t = trace[i];
+        if (t.charging != last_charging) {
+            if (change_pending) r->missed_charge = true;
+            last_charging = t.charging;
+            change_ms = t.t_ms;
+            change_pending = true;
+        }
+        while (p < pub_ms.size() && pub_ms[p] <= t.t_ms) {
+            if (shown >= 0 && ((level[p] > shown && !t.charging) || (level[p] < shown && t.charging))) {
+                r->reversals++;
+            }
+            shown = level[p];
+            if (charging) shown_charging = (*charging)[p];
+            p++;
+        }
+        if (charging && change_pending && shown_charging == (bool)t.charging) {
+            uint32_t delay = t.t_ms - change_ms;
+            uint32_t* worst = t.charging ? &r->on_ms : &r->off_ms;
+            if (delay > *worst) *worst = delay;
+            if (!*worst) *worst = 1;
+            change_pending = false;
+        }
+        if (shown < 0 || t.soc < 0 || t.t_ms < 120000) continue;
+        double err = fabs(shown - t.soc * 100);
+        r->err_sum += err;
+        r->err_cnt++;
+        if (err > r->err_max) r->err_max = err;
+    }
+    if (charging && change_pending) r->missed_charge = true;
+}
+
+// PowerMonitor on the trace, one update() per second
+static double sim_run(const std::vector<sim_trace_t>& trace, int source, sim_result_t* r, bool print) {
+    sim_trace = &trace;
+    sim_pub_ms.clear();
+    sim_pub_level.clear();
+    sim_pub_charging.clear();
+    AppState* app = AppState::getInstance();
+    app->setPowerChangeCallback(nullptr);
+    app->updatePower(-1, false);   // Nothing shown yet
+    app->setPowerChangeCallback(sim_on_power);
+
+    PowerMonitor monitor;
+    monitor.begin(source == SIM_PMU ? sim_read_pmu : sim_read_adc);
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (sim_pos = 0; sim_pos < trace.size(); ++sim_pos) {
+        monitor.update(trace[sim_pos].t_ms);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (print) {
+        printf("t_ms,level,charging\n");
+        for (size_t i = 0; i < sim_pub_ms.size(); ++i) {
+            printf("%u,%d,%d\n", sim_pub_ms[i], sim_pub_level[i], (int)sim_pub_charging[i]);
+        }
+    }
+    memset(r, 0, sizeof(*r));
+    sim_score(trace, sim_pub_ms, sim_pub_level, &sim_pub_charging, r);
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / trace.size();
+}
+
+// The percent of each raw reading, at the same sample interval
+static void sim_run_raw(const std::vector<sim_trace_t>& trace, sim_result_t* r) {
+    std::vector<uint32_t> pub_ms;
+    std::vector<int> level;
+    int shown = -1;
+    for (size_t i = 0; i < trace.size(); i += POWER_SAMPLE_INTERVAL_MS / 1000) {
+        int pct = (int)(power_percent_from_mv(trace[i].mv) + 0.5f);
+        if (pct == shown) continue;
+        shown = pct;
+        pub_ms.push_back(trace[i].t_ms);
+        level.push_back(pct);
+    }
+    memset(r, 0, sizeof(*r));
+    sim_score(trace, pub_ms, level, NULL, r);
+}
+
+static void sim_print(const char* name, const sim_result_t* r, double hours, bool charge) {
+    printf("  %-9s pub/h %6.1f  max/min %2u  reversals %4u  err mean %4.1f max %5.1f %%", name,
+           r->publishes / hours, r->max_per_min, r->reversals, r->err_cnt ? r->err_sum / r->err_cnt : 0.0,
+           r->err_max);
+    if (charge) {
+        printf("  chg on %4.0f s  off %4.0f s%s", r->on_ms / 1000.0, r->off_ms / 1000.0,
+               r->missed_charge ? "  MISSED" : "");
+    }
+    printf("\n");
+}
+
+static int sim_replay(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    std::vector<sim_trace_t> trace;
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long t;
+        unsigned mv;
+        float soc = -1;
+        if (sscanf(line, "%lu,%u,%f", &t, &mv, &soc) < 2) continue;   // Header or comment
+        sim_trace_t s = {(uint32_t)t, (uint16_t)mv, -1, 0, soc};
+        trace.push_back(s);
+    }
+    fclose(f);
+    if (trace.empty()) return 1;
+    sim_result_t r;
+    sim_run(trace, SIM_ADC, &r, true);
+    double hours = trace.back().t_ms / 3.6e6;
+    fprintf(stderr, "%zu readings over %.1f h, %u updates (%.1f/h)", trace.size(), hours, r.publishes,
+            r.publishes / hours);
+    if (r.err_cnt) fprintf(stderr, ", err mean %.1f max %.1f %%", r.err_sum / r.err_cnt, r.err_max);
+    fprintf(stderr, "\n");
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t seed = 1;
+    const char* csv = NULL;
+    int record = -1;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--csv") && i + 1 < argc) csv = argv[++i];
+        else if (!strcmp(argv[i], "--record") && i + 1 < argc) record = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--seed N] [--record SCENARIO] [--csv FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (csv) return sim_replay(csv);
+
+    const size_t count = sizeof(scenarios) / sizeof(scenarios[0]);
+    std::vector<sim_trace_t> trace;
+    if (record >= 0) {
+        if ((size_t)record >= count) {
+            fprintf(stderr, "scenario 0-%zu\n", count - 1);
+            return 1;
+        }
+        sim_generate(scenarios[record], seed, &trace);
+        printf("# %s\n# t_ms,mv,soc\n", scenarios[record].name);
+        for (size_t i = 0; i < trace.size(); ++i) {
+            printf("%u,%u,%.4f\n", trace[i].t_ms, trace[i].mv, trace[i].soc);
+        }
+        return 0;
+    }
+
+    printf("Sample every %u ms, filter %u ms, hysteresis %.1f%%\n", POWER_SAMPLE_INTERVAL_MS,
+           POWER_FILTER_TAU_MS, POWER_HYSTERESIS_PCT);
+    for (size_t sc = 0; sc < count; ++sc) {
+        sim_generate(scenarios[sc], seed + sc, &trace);
+        double hours = trace.back().t_ms / 3.6e6;
+        bool charge = scenarios[sc].profile == BATTERY_CHARGE;
+        printf("%s (%.1f h, %.0f%% to %.0f%%)\n", scenarios[sc].name, hours, trace.front().soc * 100,
+               trace.back().soc * 100);
+        sim_result_t r;
+        sim_run_raw(trace, &r);
+        sim_print("raw adc", &r, hours, false);
+        double ns = sim_run(trace, SIM_ADC, &r, false);
+        sim_print("adc", &r, hours, charge);
+        printf("            %.0f ns per update()\n", ns);
+        sim_run(trace, SIM_PMU, &r, false);
+        sim_print("pmu", &r, hours, charge);
+    }
+    return 0;
+}
@@ -0,0 +1,326 @@
+/*
+ * QMI8658 Model - Registers, FIFO and INT1 of the IMU for host tests
+ * Produces a sample every output data rate period of its own clock (which
+ * can drift from the host's) into the data registers and, unless bypassed,
+ * the FIFO. Each sample is derived from its sequence number, so a reader can
+ * tell lost, repeated and torn (accelerometer and gyroscope of different
+ * samples) ones apart, and the true time of every sample is kept to check
+ * timestamps.
+ *
+ * Modeled: WHOAMI/REVISION, RESET and RST_RESULT, CTRL1 (address auto
+ * increment, FIFO on INT1, INT1 enable), CTRL2/CTRL3 output data rates, CTRL7
+ * sensor enables, CTRL9 commands (ACK, RST_FIFO, REQ_FIFO, COPY_USID, others
+ * just acknowledged) with the STATUS_INT bit 7 handshake after a latency,
+ * FIFO_WTM_TH, FIFO_CTRL (mode, size, read mode), FIFO_COUNT/FIFO_STATUS,
+ * FIFO_DATA (only while in read mode, a sample leaves after its last byte),
+ * STATUS0 (cleared by reading), TIMESTAMP and the data registers. INT1 is
+ * high while the FIFO holds at least the watermark, as in FIFO mode a full
+ * FIFO drops the new samples and in Stream mode the oldest.
+ */
+
+#ifndef QMI8658_MODEL_H
+#define QMI8658_MODEL_H
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#define QMI8658_MODEL_ADDRESS 0x6B
+#define QMI8658_MODEL_FIFO_MAX 128
+
+enum {
+    QMI8658_MODEL_WHOAMI = 0x00,
+    QMI8658_MODEL_REVISION = 0x01,
+    QMI8658_MODEL_CTRL1 = 0x02,
+    QMI8658_MODEL_CTRL2 = 0x03,
+    QMI8658_MODEL_CTRL3 = 0x04,
+    QMI8658_MODEL_CTRL7 = 0x08,
+    QMI8658_MODEL_CTRL9 = 0x0A,
+    QMI8658_MODEL_FIFO_WTM_TH = 0x13,
+    QMI8658_MODEL_FIFO_CTRL = 0x14,
+    QMI8658_MODEL_FIFO_COUNT = 0x15,
+    QMI8658_MODEL_FIFO_STATUS = 0x16,
+    QMI8658_MODEL_FIFO_DATA = 0x17,
+    QMI8658_MODEL_STATUS_INT = 0x2D,
+    QMI8658_MODEL_STATUS0 = 0x2E,
+    QMI8658_MODEL_TIMESTAMP_L = 0x30,
+    QMI8658_MODEL_AX_L = 0x35,
+    QMI8658_MODEL_GX_L = 0x3B,
+    QMI8658_MODEL_DQW_L = 0x49,
+    QMI8658_MODEL_RST_RESULT = 0x4D,
+    QMI8658_MODEL_RESET = 0x60,
+};
+
+typedef struct {
+    uint8_t regs[128];
+    uint8_t fifo[QMI8658_MODEL_FIFO_MAX][12];
+    uint8_t head;                        // Oldest sample
+    uint8_t count;                       // Samples in the FIFO
+    uint8_t byte_pos;                    // Bytes of the oldest sample already read
+    uint8_t sample_bytes;                // 6 or 12, from the sensors enabled
+    bool overflow;
+
+    int32_t drift_ppm;                   // Sensor clock error
+    uint32_t cmd_latency_us;             // Time a CTRL9 command takes to be done
+    uint64_t cmd_done_us;                // 0: no command running
+    uint64_t next_sample_ns;             // 0: not sampling
+    uint32_t seq;                        // Sequence number of the next sample
+    std::vector<uint64_t> sample_us;     // True time of each sample, by sequence number
+
+    bool int1_high;
+    void (*on_rising)(uint64_t now_us);  // INT1 went high
+
+    uint32_t dropped;                    // Samples lost by the FIFO
+    uint32_t protocol_errors;            // FIFO_DATA read outside read mode
+} qmi8658_model_t;
+
+static inline void qmi8658_model_reset(qmi8658_model_t* m) {
+    memset(m->regs, 0, sizeof(m->regs));
+    m->regs[QMI8658_MODEL_WHOAMI] = 0x05;
+    m->regs[QMI8658_MODEL_REVISION] = 0x7C;
+    m->regs[QMI8658_MODEL_RST_RESULT] = 0x80;
+    m->head = 0;
+    m->count = 0;
+    m->byte_pos = 0;
+    m->sample_bytes = 0;
+    m->overflow = false;
+    m->cmd_done_us = 0;
+    m->next_sample_ns = 0;
+    m->int1_high = false;
+}
+
+static inline void qmi8658_model_init(qmi8658_model_t* m, int32_t drift_ppm, uint32_t cmd_latency_us,
+                                      void (*on_rising)(uint64_t)) {
+    qmi8658_model_reset(m);
+    m->drift_ppm = drift_ppm;
+    m->cmd_latency_us = cmd_latency_us;
+    m->seq = 0;
+    m->sample_us.clear();
+    m->on_rising = on_rising;
+    m->dropped = 0;
+    m->protocol_errors = 0;
+}
+
+// Raw axis values of a sample: accelerometer x, y, z then gyroscope x, y, z
+static inline void qmi8658_model_values(uint32_t seq, int16_t v[6]) {
+    for (int i = 0; i < 6; i++) v[i] = (int16_t)(uint16_t)(seq * (2 * i + 1) + i);
+}
+
+// Sequence number of an accelerometer x value read back, `last` undoes the 16 bit wrap
+static inline uint32_t qmi8658_model_seq(int16_t ax, uint32_t last) {
+    uint32_t seq = (uint16_t)ax;
+    while (seq + 0x8000 < last) seq += 0x10000;
+    return seq;
+}
+
+static inline bool qmi8658_model_accel(const qmi8658_model_t* m) { return m->regs[QMI8658_MODEL_CTRL7] & 0x01; }
+static inline bool qmi8658_model_gyro(const qmi8658_model_t* m) { return m->regs[QMI8658_MODEL_CTRL7] & 0x02; }
+
+// Time between samples on the sensor's clock, the gyroscope's rate when it runs
+static inline uint64_t qmi8658_model_period_ns(const qmi8658_model_t* m) {
+    uint64_t ns;
+    if (qmi8658_model_gyro(m)) {
+        ns = (uint64_t)(1e9 / 7174.4 * (1 << (m->regs[QMI8658_MODEL_CTRL3] & 0x0F)) + 0.5);
+    } else {
+        uint8_t odr = m->regs[QMI8658_MODEL_CTRL2] & 0x0F;
+        static const uint32_t low_power_hz[4] = {128, 21, 11, 3};
+        if (odr >= 12) ns = 1000000000ull / low_power_hz[odr - 12];
+        else ns = 1000000ull << (odr < 3 ? 0 : odr - 3);
+    }
+    return ns * (1000000 + m->drift_ppm) / 1000000;
+}
+
+static inline uint8_t qmi8658_model_fifo_size(const qmi8658_model_t* m) {
+    return 16 << ((m->regs[QMI8658_MODEL_FIFO_CTRL] >> 2) & 0x03);
+}
+
+static inline uint8_t qmi8658_model_fifo_mode(const qmi8658_model_t* m) {
+    return m->regs[QMI8658_MODEL_FIFO_CTRL] & 0x03;
+}
+
+static inline void qmi8658_model_update_int(qmi8658_model_t* m, uint64_t now_us) {
+    uint8_t ctrl1 = m->regs[QMI8658_MODEL_CTRL1];
+    uint8_t wtm = m->regs[QMI8658_MODEL_FIFO_WTM_TH];
+    if (m->regs[QMI8658_MODEL_FIFO_CTRL] & 0x80) return;   // Held through the read mode
+    bool high = (ctrl1 & 0x04) && (ctrl1 & 0x08) && qmi8658_model_fifo_mode(m) && wtm && m->count >= wtm;
+    if (high && !m->int1_high && m->on_rising) {
+        m->int1_high = true;
+        m->on_rising(now_us);
+    }
+    m->int1_high = high;
+}
+
+static inline void qmi8658_model_sync_fifo_regs(qmi8658_model_t* m) {
+    uint16_t words = (m->count * m->sample_bytes - m->byte_pos) / 2;
+    uint8_t status = (words >> 8) & 0x03;
+    if (m->count) status |= 0x10;
+    if (m->overflow) status |= 0x20;
+    uint8_t wtm = m->regs[QMI8658_MODEL_FIFO_WTM_TH];
+    if (wtm && m->count >= wtm) status |= 0x40;
+    if (m->count == qmi8658_model_fifo_size(m)) status |= 0x80;
+    m->regs[QMI8658_MODEL_FIFO_COUNT] = (uint8_t)words;
+    m->regs[QMI8658_MODEL_FIFO_STATUS] = status;
+}
+
+static inline void qmi8658_model_clear_fifo(qmi8658_model_t* m) {
+    m->head = 0;
+    m->count = 0;
+    m->byte_pos = 0;
+    m->overflow = false;
+    qmi8658_model_sync_fifo_regs(m);
+}
+
+static inline void qmi8658_model_sample(qmi8658_model_t* m, uint64_t now_us) {
+    uint32_t seq = m->seq++;
+    m->sample_us.push_back(now_us);
+    int16_t v[6];
+    qmi8658_model_values(seq, v);
+
+    // Data registers, STATUS0 and the sample counter
+    for (int i = 0; i < 6; i++) {
+        m->regs[QMI8658_MODEL_AX_L + 2 * i] = (uint8_t)v[i];
+        m->regs[QMI8658_MODEL_AX_L + 2 * i + 1] = (uint8_t)((uint16_t)v[i] >> 8);
+    }
+    m->regs[QMI8658_MODEL_STATUS0] |= (qmi8658_model_accel(m) ? 0x01 : 0) | (qmi8658_model_gyro(m) ? 0x02 : 0);
+    m->regs[QMI8658_MODEL_STATUS_INT] |= 0x01;
+    uint32_t ts = (m->regs[QMI8658_MODEL_TIMESTAMP_L] | m->regs[QMI8658_MODEL_TIMESTAMP_L + 1] << 8 |
+                   m->regs[QMI8658_MODEL_TIMESTAMP_L + 2] << 16) + 1;
+    for (int i = 0; i < 3; i++) m->regs[QMI8658_MODEL_TIMESTAMP_L + i] = (uint8_t)(ts >> (8 * i));
+
+    if (!qmi8658_model_fifo_mode(m)) return;
+    uint8_t size = qmi8658_model_fifo_size(m);
+    if (m->count == size) {
+        m->overflow = true;
+        m->dropped++;
+        if (qmi8658_model_fifo_mode(m) == 1) {   // FIFO: the new one is lost
+            qmi8658_model_sync_fifo_regs(m);
+            return;
+        }
+        m->head = (m->head + 1) % QMI8658_MODEL_FIFO_MAX;   // Stream: the oldest goes
+        m->count--;
+        m->byte_pos = 0;
+    }
+    uint8_t* slot = m->fifo[(m->head + m->count) % QMI8658_MODEL_FIFO_MAX];
+    uint8_t n = 0;
+    for (int s = 0; s < 2; s++) {
+        if (!(s == 0 ? qmi8658_model_accel(m) : qmi8658_model_gyro(m))) continue;
+        for (int i = 0; i < 3; i++) {
+            slot[n++] = (uint8_t)v[3 * s + i];
+            slot[n++] = (uint8_t)((uint16_t)v[3 * s + i] >> 8);
+        }
+    }
+    m->count++;
+    qmi8658_model_sync_fifo_regs(m);
+    qmi8658_model_update_int(m, now_us);
+}
+
+/**
+ * Produce the samples due until `to_us` and finish a running command
+ * @param now_us Advanced to each sample time (the interrupt sees it), then to `to_us`
+ */
+static inline void qmi8658_model_run(qmi8658_model_t* m, uint64_t* now_us, uint64_t to_us) {
+    while (m->next_sample_ns && m->next_sample_ns / 1000 <= to_us) {
+        *now_us = m->next_sample_ns / 1000;
+        qmi8658_model_sample(m, *now_us);
+        m->next_sample_ns += qmi8658_model_period_ns(m);
+    }
+    if (m->cmd_done_us && m->cmd_done_us <= to_us) {
+        m->regs[QMI8658_MODEL_STATUS_INT] |= 0x80;
+        m->cmd_done_us = 0;
+    }
+    *now_us = to_us;
+}
+
+static inline void qmi8658_model_command(qmi8658_model_t* m, uint8_t cmd, uint64_t now_us) {
+    if (cmd == 0x00) {   // ACK
+        m->regs[QMI8658_MODEL_STATUS_INT] &= ~0x80;
+        return;
+    }
+    switch (cmd) {
+        case 0x04:   // RST_FIFO
+            qmi8658_model_clear_fifo(m);
+            break;
+        case 0x05:   // REQ_FIFO: read mode
+            m->regs[QMI8658_MODEL_FIFO_CTRL] |= 0x80;
+            break;
+        case 0x10:   // COPY_USID: firmware version
+            m->regs[QMI8658_MODEL_DQW_L] = 0x02;
+            m->regs[QMI8658_MODEL_DQW_L + 1] = 0x01;
+            m->regs[QMI8658_MODEL_DQW_L + 2] = 0x00;
+            break;
+    }
+    m->cmd_done_us = now_us + m->cmd_latency_us;
+    if (!m->cmd_latency_us) m->regs[QMI8658_MODEL_STATUS_INT] |= 0x80;
+}
+
+static inline void qmi8658_model_write(qmi8658_model_t* m, uint8_t reg, uint8_t value, uint64_t now_us) {
+    switch (reg) {
+        case QMI8658_MODEL_RESET:
+            if (value == 0xB0) qmi8658_model_reset(m);
+            return;
+        case QMI8658_MODEL_CTRL7: {
+            bool was = m->regs[reg] & 0x03;
+            m->regs[reg] = value;
+            m->sample_bytes = ((value & 0x01) + ((value >> 1) & 0x01)) * 6;
+            if (!(value & 0x03)) m->next_sample_ns = 0;
+            else if (!was) m->next_sample_ns = now_us * 1000 + qmi8658_model_period_ns(m);
+            return;
+        }
+        case QMI8658_MODEL_CTRL9:
+            m->regs[reg] = value;
+            qmi8658_model_command(m, value, now_us);
+            return;
+        case QMI8658_MODEL_FIFO_CTRL:
+            // Writing it ends the read mode, what was read is gone and the flags start over
+            m->regs[reg] = value & 0x7F;
+            if (!(value & 0x03)) qmi8658_model_clear_fifo(m);
+            m->overflow = false;
+            qmi8658_model_sync_fifo_regs(m);
+            qmi8658_model_update_int(m, now_us);
+            return;
+        case QMI8658_MODEL_WHOAMI:
+        case QMI8658_MODEL_REVISION:
+        case QMI8658_MODEL_FIFO_COUNT:
+        case QMI8658_MODEL_FIFO_STATUS:
+        case QMI8658_MODEL_FIFO_DATA:
+        case QMI8658_MODEL_STATUS_INT:
+        case QMI8658_MODEL_STATUS0:
+            return;   // Read only
+        default:
+            if (reg < sizeof(m->regs)) m->regs[reg] = value;
+            if (reg == QMI8658_MODEL_CTRL1 || reg == QMI8658_MODEL_FIFO_WTM_TH) qmi8658_model_update_int(m, now_us);
+            return;
+    }
+}
+
+static inline uint8_t qmi8658_model_read(qmi8658_model_t* m, uint8_t reg, uint64_t now_us) {
+    if (reg == QMI8658_MODEL_STATUS0) {
+        uint8_t value = m->regs[reg];
+        m->regs[reg] = 0;   // Cleared by reading
+        return value;
+    }
+    if (reg != QMI8658_MODEL_FIFO_DATA) return reg < sizeof(m->regs) ? m->regs[reg] : 0;
+
+    if (!(m->regs[QMI8658_MODEL_FIFO_CTRL] & 0x80)) {
+        m->protocol_errors++;
+        return 0;
+    }
+    if (m->count == 0) return 0;
+    uint8_t out = m->fifo[m->head][m->byte_pos];
+    if (++m->byte_pos == m->sample_bytes) {
+        m->byte_pos = 0;
+        m->head = (m->head + 1) % QMI8658_MODEL_FIFO_MAX;
+        m->count--;
+    }
+    qmi8658_model_sync_fifo_regs(m);
+    (void)now_us;
+    return out;
+}
+
+// Register a transfer starting at `reg` moves to after each byte
+static inline uint8_t qmi8658_model_next_reg(const qmi8658_model_t* m, uint8_t reg) {
+    if (reg == QMI8658_MODEL_FIFO_DATA || !(m->regs[QMI8658_MODEL_CTRL1] & 0x40)) return reg;
+    return reg + 1;
+}
+
+#endif // QMI8658_MODEL_H
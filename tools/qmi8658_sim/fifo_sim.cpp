@@ -0,0 +1,329 @@
+/*
+ * QMI8658 FIFO Simulation - Polled data registers against FIFO batches
+ * Runs the real driver (lib/SensorLib/src/SensorQMI8658.hpp) on the register
+ * model of Qmi8658Model.h through SensorLib's custom I2C callbacks, which
+ * count the bus transactions and take the time they would on a 400 kHz bus.
+ * The application loop is served at jittery intervals, with occasional long
+ * stalls for the UI loop profile, and every sample it gets is checked:
+ *
+ *   poll  getDataReady() every loop, then getAccelerometer()/getGyroscope()
+ *   fifo  readFromFifo(IMUbatch *) every loop, no interrupt pin
+ *   irq   readFromFifo(IMUbatch *, irq time) with the FIFO watermark on INT1,
+ *         an ISR that saves micros(), and a pin read when nothing is pending
+ *
+ * Reported per scenario and mode: samples delivered, lost and bad (repeated
+ * or torn between the accelerometer and gyroscope reads, from the sequence
+ * numbers in the model's values), I2C transactions per second and bus time,
+ * samples per read that got any, and for the FIFO modes the error of the
+ * sample timestamps against the model's true sample times.
+ *
+ * Build (from the project root):
+ *   g++ -O2 -Ilib/SensorLib/src tools/qmi8658_sim/fifo_sim.cpp -o qmi8658_sim
+ *
+ * Usage:
+ *   ./qmi8658_sim                 # built-in scenarios, 60 s each
+ *   ./qmi8658_sim --seconds 600 --seed 7
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// SensorLib's host build (no ARDUINO) leaves the core to the platform
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+
+#include "SensorQMI8658.hpp"
+#include "Qmi8658Model.h"
+
+// Pin the model's INT1 is wired to
+#define SIM_INT_PIN 33
+
+#define SIM_I2C_HZ 400000
+
+typedef struct {
+    const char* name;
+    SensorQMI8658::GyroODR gyro_odr;    // SIM_GYRO_OFF: accelerometer only
+    SensorQMI8658::AccelODR accel_odr;
+    SensorQMI8658::FIFO_Mode fifo_mode;
+    SensorQMI8658::FIFO_Samples fifo_size;
+    uint8_t watermark;
+    int32_t drift_ppm;                  // Sensor clock against the MCU's
+    uint32_t loop_min_us;               // Time between two services of the loop
+    uint32_t loop_max_us;
+    uint32_t stall_every_ms;            // Mean time between stalls (0: none)
+    uint32_t stall_us;
+} sim_scenario_t;
+
+#define SIM_GYRO_OFF ((SensorQMI8658::GyroODR)9)
+
+static const sim_scenario_t scenarios[] = {
+    {"896.8 Hz 6DOF, sensor task", SensorQMI8658::GYR_ODR_896_8Hz, SensorQMI8658::ACC_ODR_1000Hz,
+     SensorQMI8658::FIFO_MODE_FIFO, SensorQMI8658::FIFO_SAMPLES_128, 16, 3000, 200, 1500, 0, 0},
+    {"896.8 Hz 6DOF, UI loop", SensorQMI8658::GYR_ODR_896_8Hz, SensorQMI8658::ACC_ODR_1000Hz,
+     SensorQMI8658::FIFO_MODE_FIFO, SensorQMI8658::FIFO_SAMPLES_128, 32, -2000, 1000, 35000, 5000, 120000},
+    {"224.2 Hz 6DOF, UI loop", SensorQMI8658::GYR_ODR_224_2Hz, SensorQMI8658::ACC_ODR_250Hz,
+     SensorQMI8658::FIFO_MODE_FIFO, SensorQMI8658::FIFO_SAMPLES_64, 8, 5000, 1000, 35000, 5000, 120000},
+    {"448.4 Hz 6DOF, UI loop, stream", SensorQMI8658::GYR_ODR_448_4Hz, SensorQMI8658::ACC_ODR_1000Hz,
+     SensorQMI8658::FIFO_MODE_STREAM, SensorQMI8658::FIFO_SAMPLES_32, 16, -8000, 1000, 35000, 5000, 120000},
+    {"125 Hz accel, sensor task", SIM_GYRO_OFF, SensorQMI8658::ACC_ODR_125Hz,
+     SensorQMI8658::FIFO_MODE_FIFO, SensorQMI8658::FIFO_SAMPLES_16, 8, 10000, 200, 1500, 0, 0},
+};
+
+enum { SIM_POLL, SIM_FIFO, SIM_IRQ };
+static const char* const sim_mode_names[] = {"poll", "fifo", "irq"};
+
+typedef struct {
+    uint32_t produced;
+    uint32_t delivered;
+    uint32_t lost;                      // Gaps in the sequence numbers
+    uint32_t bad;                       // Repeated, older or torn
+    uint32_t reads;                     // Reads that got samples
+    uint32_t transactions;
+    uint64_t bus_us;
+    uint64_t ts_err_sum;
+    uint32_t ts_err_max;
+    uint32_t ts_cnt;
+    uint32_t overflows;                 // Batches flagged by the driver
+    uint32_t protocol_errors;
+} sim_result_t;
+
+static uint64_t sim_now_us;
+static uint32_t sim_rand = 1;
+static qmi8658_model_t model;
+static sim_result_t* sim_res;
+static volatile bool sim_irq_flag;
+static volatile uint32_t sim_irq_us;
+
+static uint32_t sim_random(uint32_t max) {
+    sim_rand = sim_rand * 1103515245u + 12345u;
+    uint32_t r = (sim_rand >> 16) | ((sim_rand * 1103515245u + 12345u) >> 16 << 15);
+    return r % (max + 1);
+}
+
+static void sim_advance_us(uint64_t us) {
+    qmi8658_model_run(&model, &sim_now_us, sim_now_us + us);
+}
+
+// ISR of the FIFO watermark interrupt
+static void sim_rising(uint64_t now_us) {
+    sim_irq_us = (uint32_t)now_us;
+    sim_irq_flag = true;
+}
+
+//
+// Host core for SensorLib
+//
+
+uint32_t micros(void) { return (uint32_t)sim_now_us; }
+uint32_t millis(void) { return (uint32_t)(sim_now_us / 1000); }
+void delay(uint32_t ms) { sim_advance_us((uint64_t)ms * 1000); }
+
+static int sim_gpio_read(uint32_t gpio) {
+    return gpio == SIM_INT_PIN && model.int1_high ? HIGH : LOW;
+}
+
+static void sim_gpio_mode(uint32_t gpio, uint8_t mode) { (void)gpio; (void)mode; }
+
+//
+// I2C callbacks: address, register and data bytes with their ack bits, a
+// repeated start and address for reads, plus start/stop
+//
+
+static void sim_bus(size_t bytes) {
+    uint64_t bits = bytes * 9 + 2;
+    uint64_t us = (bits * 1000000 + SIM_I2C_HZ - 1) / SIM_I2C_HZ;
+    if (sim_res) {
+        sim_res->transactions++;
+        sim_res->bus_us += us;
+    }
+    sim_advance_us(us);
+}
+
+static int sim_i2c_read(uint8_t addr, uint8_t reg, uint8_t* data, uint8_t len) {
+    if (addr != QMI8658_MODEL_ADDRESS) return DEV_WIRE_ERR;
+    sim_bus(2);
+    for (uint8_t i = 0; i < len; i++) {
+        data[i] = qmi8658_model_read(&model, reg, sim_now_us);
+        reg = qmi8658_model_next_reg(&model, reg);
+    }
+    sim_bus(1 + len);
+    return DEV_WIRE_NONE;
+}
+
+static int sim_i2c_write(uint8_t addr, uint8_t reg, uint8_t* data, uint8_t len) {
+    if (addr != QMI8658_MODEL_ADDRESS) return DEV_WIRE_ERR;
+    sim_bus(2 + len);
+    for (uint8_t i = 0; i < len; i++) {
+        qmi8658_model_write(&model, reg, data[i], sim_now_us);
+        reg = qmi8658_model_next_reg(&model, reg);
+    }
+    return DEV_WIRE_NONE;
+}
+
+//
+// Scenarios
+//
+
+// Check a delivered sample against the model
+static void sim_deliver(sim_result_t* res, const int16_t raw[6], bool gyro, int64_t* last_seq,
+                        bool has_time, uint32_t time) {
+    uint32_t seq = qmi8658_model_seq(raw[0], *last_seq < 0 ? 0 : (uint32_t)*last_seq);
+    int16_t v[6];
+    qmi8658_model_values(seq, v);
+    bool match = seq < model.sample_us.size();
+    for (int i = 0; i < (gyro ? 6 : 3) && match; i++) {
+        if (raw[i] != v[i]) match = false;
+    }
+    if (!match || (int64_t)seq <= *last_seq) {
+        res->bad++;
+        return;
+    }
+    res->lost += seq - (uint32_t)(*last_seq + 1);
+    *last_seq = seq;
+    res->delivered++;
+
+    if (has_time) {
+        int64_t err = (int64_t)(int32_t)(time - (uint32_t)model.sample_us[seq]);
+        uint32_t abs_err = (uint32_t)(err < 0 ? -err : err);
+        res->ts_err_sum += abs_err;
+        res->ts_cnt++;
+        if (abs_err > res->ts_err_max) res->ts_err_max = abs_err;
+    }
+}
+
+static int16_t sim_raw(float value, float scales) {
+    return (int16_t)lrintf(value / scales);
+}
+
+static sim_result_t sim_run(const sim_scenario_t* sc, int mode, uint32_t seconds, uint32_t seed) {
+    static IMUbatch batch;
+    sim_result_t res;
+    memset(&res, 0, sizeof(res));
+
+    sim_now_us = 0;
+    sim_rand = seed;
+    sim_irq_flag = false;
+    qmi8658_model_init(&model, sc->drift_ppm, 20, sim_rising);
+
+    SensorQMI8658 qmi;
+    sim_res = NULL;   // Setup traffic isn't counted
+    qmi.setGpioReadCallback(sim_gpio_read);
+    qmi.setGpioModeCallback(sim_gpio_mode);
+    if (mode == SIM_IRQ) qmi.setPins(SIM_INT_PIN);
+    if (!qmi.begin(QMI8658_L_SLAVE_ADDRESS, sim_i2c_read, sim_i2c_write)) {
+        fprintf(stderr, "QMI8658 model not found\n");
+        exit(1);
+    }
+    bool gyro = sc->gyro_odr != SIM_GYRO_OFF;
+    qmi.configAccelerometer(SensorQMI8658::ACC_RANGE_4G, sc->accel_odr, SensorQMI8658::LPF_MODE_0);
+    if (gyro) qmi.configGyroscope(SensorQMI8658::GYR_RANGE_64DPS, sc->gyro_odr, SensorQMI8658::LPF_MODE_3);
+    if (mode != SIM_POLL) {
+        qmi.configFIFO(sc->fifo_mode, sc->fifo_size,
+                       mode == SIM_IRQ ? SensorQMI8658::INTERRUPT_PIN_1 : SensorQMI8658::INTERRUPT_PIN_DISABLE,
+                       sc->watermark);
+    }
+    qmi.enableAccelerometer();
+    if (gyro) qmi.enableGyroscope();
+    if (mode == SIM_IRQ) qmi.enableINT(SensorQMI8658::INTERRUPT_PIN_1, true);
+    sim_res = &res;
+
+    float accel_scales = qmi.getAccelerometerScales();
+    float gyro_scales = qmi.getGyroscopeScales();
+    uint64_t end_us = sim_now_us + (uint64_t)seconds * 1000000;
+    uint32_t first_seq = model.seq;
+    int64_t last_seq = (int64_t)first_seq - 1;
+    while (sim_now_us < end_us) {
+        uint32_t wait = sc->loop_min_us + sim_random(sc->loop_max_us - sc->loop_min_us);
+        if (sc->stall_every_ms && sim_random(sc->stall_every_ms * 1000 / ((sc->loop_min_us + sc->loop_max_us) / 2)) == 0) {
+            wait += sc->stall_us;
+        }
+        sim_advance_us(wait);
+
+        int16_t raw[6] = {0};
+        if (mode == SIM_POLL) {
+            if (!qmi.getDataReady()) continue;
+            float x = 0, y = 0, z = 0;
+            qmi.getAccelerometer(x, y, z);
+            raw[0] = sim_raw(x, accel_scales);
+            raw[1] = sim_raw(y, accel_scales);
+            raw[2] = sim_raw(z, accel_scales);
+            if (gyro) {
+                qmi.getGyroscope(x, y, z);
+                raw[3] = sim_raw(x, gyro_scales);
+                raw[4] = sim_raw(y, gyro_scales);
+                raw[5] = sim_raw(z, gyro_scales);
+            }
+            res.reads++;
+            sim_deliver(&res, raw, gyro, &last_seq, false, 0);
+            continue;
+        }
+
+        uint32_t irq_us = 0;
+        if (mode == SIM_IRQ && sim_irq_flag) {
+            sim_irq_flag = false;
+            irq_us = sim_irq_us;
+        }
+        uint16_t n = qmi.readFromFifo(&batch, irq_us);
+        if (!n) continue;
+        res.reads++;
+        if (batch.overflow) res.overflows++;
+        for (uint16_t i = 0; i < n; i++) {
+            raw[0] = sim_raw(batch.accel[0][i], accel_scales);
+            raw[1] = sim_raw(batch.accel[1][i], accel_scales);
+            raw[2] = sim_raw(batch.accel[2][i], accel_scales);
+            if (gyro) {
+                raw[3] = sim_raw(batch.gyro[0][i], gyro_scales);
+                raw[4] = sim_raw(batch.gyro[1][i], gyro_scales);
+                raw[5] = sim_raw(batch.gyro[2][i], gyro_scales);
+            }
+            sim_deliver(&res, raw, gyro, &last_seq, true, batch.timestamp[i]);
+        }
+    }
+
+    res.produced = model.seq - first_seq;
+    res.protocol_errors = model.protocol_errors;
+    sim_res = NULL;
+    return res;
+}
+
+static void sim_print(const char* mode, const sim_result_t* r, uint32_t seconds) {
+    printf("  %-4s delivered %6u/%-6u lost %6u bad %5u  i2c/s %7.1f bus %5.2f%%  samples/read %5.1f",
+           mode, r->delivered, r->produced, r->lost, r->bad,
+           (double)r->transactions / seconds, 100.0 * r->bus_us / (seconds * 1000000.0),
+           r->reads ? (double)r->delivered / r->reads : 0);
+    if (r->ts_cnt) {
+        printf("  ts err mean %4llu max %5u us  overflows %u",
+               (unsigned long long)(r->ts_err_sum / r->ts_cnt), r->ts_err_max, r->overflows);
+    }
+    if (r->protocol_errors) printf("  PROTOCOL ERRORS %u", r->protocol_errors);
+    printf("\n");
+}
+
+int main(int argc, char** argv) {
+    uint32_t seconds = 60;
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--seconds N] [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    for (const sim_scenario_t& sc : scenarios) {
+        printf("%s (loop %u-%u us, stall %u us every ~%u ms, drift %d ppm, watermark %u)\n", sc.name,
+               sc.loop_min_us, sc.loop_max_us, sc.stall_us, sc.stall_every_ms, sc.drift_ppm, sc.watermark);
+        for (int mode = SIM_POLL; mode <= SIM_IRQ; mode++) {
+            sim_result_t r = sim_run(&sc, mode, seconds, seed);
+            sim_print(sim_mode_names[mode], &r, seconds);
+        }
+    }
+    return 0;
+}
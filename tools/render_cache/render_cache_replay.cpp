@@ -0,0 +1,195 @@
+/*
+ * Render Cache Replay - Working set of the render cache on the real screens
+ * Walks through the screens of the firmware (main.h) on a 466x466 display
+ * with the device's 80-line draw buffer, with the animated transitions and
+ * 1 s on each screen, and reads lv_render_cache_get_stat() every frame:
+ *
+ *   unlimited     budgets large enough to keep everything: the largest
+ *                 use of each tier is the working set of the flow
+ *   lv_conf.h     LV_RENDER_CACHE_INTERNAL_SIZE / LV_RENDER_CACHE_LARGE_SIZE
+ *
+ * Each run is a new process, as after a boot: the screens keep static
+ * pointers to their objects and are built only once. The budgets include
+ * the hash table and the headers of the items, so the working set is
+ * reported as the budget it needs. The configured budgets have to hold the working set: the same
+ * peaks as with unlimited budgets, and after the first walk no more misses
+ * and no evictions.
+ *
+ * Build (from the project root, after tools/host/build_lvgl.sh):
+ *   g++ -O2 -DLV_CONF_INCLUDE_SIMPLE -DLV_LVGL_H_INCLUDE_SIMPLE -Itools/host -Ilib/lvgl-8.3.5 \
+ *       -Ilib/lvgl-8.3.5/src -Iinclude tools/render_cache/render_cache_replay.cpp \
+ *       build_host/liblvgl.a -lm -o render_cache_replay
+ *
+ * Usage:
+ *   ./render_cache_replay                 # 3 walks
+ *   ./render_cache_replay --rounds 5
+ */
+
+#include <lvgl.h>
+#include "main.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define REPLAY_W 466
+#define REPLAY_H 466
+#define REPLAY_TICK_MS 16
+#define REPLAY_SCREEN_MS 1000
+
+#if !LV_USE_RENDER_CACHE
+#error "LV_USE_RENDER_CACHE is 0 in lv_conf.h, there is nothing to replay"
+#endif
+
+// Large enough to never evict
+#define REPLAY_UNLIMITED (4 * 1024 * 1024)
+
+// The kiosk's flow: logo, loaders and texts, tracking, info, then the WiFi change screens
+static const int replay_flow[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13};
+#define REPLAY_FLOW_LEN (sizeof(replay_flow) / sizeof(replay_flow[0]))
+
+typedef struct {
+    uint32_t max_used[_LV_RENDER_CACHE_TIER_LAST];  // Largest sum of the classes' used_size
+    uint32_t hit_cnt;                               // After the first walk
+    uint32_t miss_cnt;
+    uint32_t evict_cnt;
+} replay_result_t;
+
+static lv_color_t replay_buf[REPLAY_W * 80];
+
+static void replay_flush(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p) {
+    (void)area;
+    (void)color_p;
+    lv_disp_flush_ready(disp);
+}
+
+static void replay_init_lvgl() {
+    lv_init();
+
+    static lv_disp_draw_buf_t draw_buf;
+    lv_disp_draw_buf_init(&draw_buf, replay_buf, NULL, REPLAY_W * 80);
+
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = REPLAY_W;
+    disp_drv.ver_res = REPLAY_H;
+    disp_drv.flush_cb = replay_flush;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+}
+
+static void replay_sum_stat(replay_result_t* res, bool count) {
+    for (int tier = 0; tier < _LV_RENDER_CACHE_TIER_LAST; tier++) {
+        uint32_t used = 0;
+        for (int cls = 0; cls < _LV_RENDER_CACHE_CLASS_LAST; cls++) {
+            lv_render_cache_stat_t s;
+            lv_render_cache_get_stat(cls, tier, &s);
+            used += s.used_size;
+            if (count) {
+                res->hit_cnt += s.hit_cnt;
+                res->miss_cnt += s.miss_cnt;
+                res->evict_cnt += s.evict_cnt;
+            }
+        }
+        if (used > res->max_used[tier]) res->max_used[tier] = used;
+    }
+}
+
+// The hash table in front of the items, as lv_render_cache.c sizes it
+static uint32_t replay_table_size(int tier, uint32_t budget) {
+    uint32_t cnt = budget / (tier == LV_RENDER_CACHE_TIER_LARGE ? 4096 : 256);
+    if (cnt == 0) cnt = 1;
+    return (cnt * sizeof(void*) + 7) & ~7U;
+}
+
+static void replay_walk(size_t internal_size, size_t large_size, int rounds, replay_result_t* res) {
+    replay_init_lvgl();
+    lv_render_cache_set_budget(LV_RENDER_CACHE_TIER_INTERNAL, internal_size);
+    lv_render_cache_set_budget(LV_RENDER_CACHE_TIER_LARGE, large_size);
+    init_ui();
+    memset(res, 0, sizeof(*res));
+
+    for (int r = 0; r < rounds; r++) {
+        // Count from the second walk: the first one fills the cache
+        if (r == 1) lv_render_cache_reset_stat();
+        for (uint32_t i = 0; i < REPLAY_FLOW_LEN; i++) {
+            switch_to_screen(replay_flow[i], true);
+            for (int t = 0; t < REPLAY_SCREEN_MS; t += REPLAY_TICK_MS) {
+                lv_tick_inc(REPLAY_TICK_MS);
+                lv_timer_handler();
+                replay_sum_stat(res, false);
+            }
+        }
+    }
+    if (rounds > 1) replay_sum_stat(res, true);
+}
+
+// Each run in a new process, as after a boot: the screens can be built only once
+static bool replay_run(size_t internal_size, size_t large_size, int rounds, replay_result_t* res) {
+    int fd[2];
+    if (pipe(fd) != 0) return false;
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fd[0]);
+        replay_walk(internal_size, large_size, rounds, res);
+        bool ok = write(fd[1], res, sizeof(*res)) == (ssize_t)sizeof(*res);
+        _exit(ok ? 0 : 1);
+    }
+    close(fd[1]);
+    bool ok = pid > 0 && read(fd[0], res, sizeof(*res)) == (ssize_t)sizeof(*res);
+    close(fd[0]);
+    int status = 0;
+    if (pid > 0) waitpid(pid, &status, 0);
+    return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static void replay_print(const char* name, const replay_result_t* res) {
+    printf("  %-10s  %8u  %8u  %6u  %6u  %6u\n", name, res->max_used[LV_RENDER_CACHE_TIER_INTERNAL],
+           res->max_used[LV_RENDER_CACHE_TIER_LARGE], res->hit_cnt, res->miss_cnt, res->evict_cnt);
+}
+
+int main(int argc, char** argv) {
+    int rounds = 3;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--rounds N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (rounds < 2) rounds = 2;
+
+    replay_result_t unlimited, conf;
+    if (!replay_run(REPLAY_UNLIMITED, REPLAY_UNLIMITED, rounds, &unlimited) ||
+        !replay_run(LV_RENDER_CACHE_INTERNAL_SIZE, LV_RENDER_CACHE_LARGE_SIZE, rounds, &conf)) {
+        printf("FAIL a replay crashed\n1 failed\n");
+        return 1;
+    }
+
+    printf("%u screens, %d ms each, %d walks, bytes, counts after the first walk:\n", (unsigned)REPLAY_FLOW_LEN,
+           REPLAY_SCREEN_MS, rounds);
+    printf("  budgets     internal     large    hits  misses  evicts\n");
+    replay_print("unlimited", &unlimited);
+    replay_print("lv_conf.h", &conf);
+
+    uint32_t need[_LV_RENDER_CACHE_TIER_LAST];
+    for (int tier = 0; tier < _LV_RENDER_CACHE_TIER_LAST; tier++) {
+        uint32_t used = unlimited.max_used[tier];
+        need[tier] = used ? used + replay_table_size(tier, used) : 0;
+    }
+    printf("working set: %u + %u bytes with the hash tables, lv_conf.h: %u + %u bytes\n",
+           need[LV_RENDER_CACHE_TIER_INTERNAL], need[LV_RENDER_CACHE_TIER_LARGE],
+           (unsigned)LV_RENDER_CACHE_INTERNAL_SIZE, (unsigned)LV_RENDER_CACHE_LARGE_SIZE);
+
+    // Evicting anything in the first walk shows up as a smaller peak
+    uint32_t failed = 0;
+    if (conf.miss_cnt > unlimited.miss_cnt || conf.evict_cnt != 0 ||
+        memcmp(conf.max_used, unlimited.max_used, sizeof(conf.max_used)) != 0) {
+        printf("FAIL the budgets of lv_conf.h don't hold the working set\n");
+        failed++;
+    }
+    printf("%u failed\n", failed);
+    return failed != 0;
+}
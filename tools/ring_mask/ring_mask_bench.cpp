@@ -0,0 +1,232 @@
+/*
+ * Ring Mask Benchmark - Arc drawing with and without the ring mask cache
+ * Draws rings of the display's size (466 px, like the loaders) in an
+ * object's draw event with the device's 80-line draw buffer, two ways:
+ *
+ *   radius masks  an inner and an outer radius mask (and the angle mask of
+ *                 an arc) over lv_draw_rect(), what lv_draw_sw_arc did
+ *                 without LV_RING_MASK_CACHE_SIZE
+ *   ring cache    lv_draw_arc(): the spans of the cached table blended
+ *                 directly
+ *
+ * Only arcs lv_draw_sw_arc draws in one go are compared: full rings and
+ * gaps up to 60 deg. Larger gaps are drawn in quarters clipped to estimated
+ * areas, which can't be rebuilt outside of it.
+ *
+ * Both have to give the same frame. The two alternate over the rounds and
+ * the fastest frame of each is reported, with the first draw of the cache
+ * (it builds the table).
+ *
+ * Build (from the project root, after tools/host/build_lvgl.sh):
+ *   g++ -O2 -DLV_CONF_INCLUDE_SIMPLE -DLV_LVGL_H_INCLUDE_SIMPLE -Itools/host -Ilib/lvgl-8.3.5 \
+ *       -Ilib/lvgl-8.3.5/src tools/ring_mask/ring_mask_bench.cpp build_host/liblvgl.a -lm -o ring_mask_bench
+ *
+ * Usage:
+ *   ./ring_mask_bench                 # 20 rounds
+ *   ./ring_mask_bench --rounds 5
+ */
+
+#include <lvgl.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_SIZE 466
+#define BENCH_BUF_LINES 80
+
+#if !LV_RING_MASK_CACHE_SIZE
+#error "LV_RING_MASK_CACHE_SIZE is 0 in lv_conf.h, there is nothing to compare"
+#endif
+
+typedef struct {
+    lv_coord_t radius;
+    lv_coord_t width;
+    uint16_t start_angle;
+    uint16_t end_angle;
+} bench_arc_t;
+
+static const bench_arc_t bench_arcs[] = {
+    {233, 2, 0, 360},
+    {233, 20, 0, 360},
+    {200, 40, 0, 360},
+    {100, 12, 0, 360},
+    {233, 20, 0, 330},
+    {233, 20, 100, 60},
+};
+#define BENCH_ARC_CNT (sizeof(bench_arcs) / sizeof(bench_arcs[0]))
+
+typedef struct {
+    const bench_arc_t* arc;
+    bool ref;
+    uint64_t draw_us;       // Time spent in drawing the arc
+} bench_state_t;
+
+static lv_color_t bench_buf[BENCH_SIZE * BENCH_BUF_LINES];
+static lv_color_t bench_fb[BENCH_SIZE * BENCH_SIZE];
+static lv_color_t bench_ref_fb[BENCH_SIZE * BENCH_SIZE];
+
+static uint64_t bench_now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void bench_flush(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p) {
+    lv_coord_t w = lv_area_get_width(area);
+    for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&bench_fb[y * BENCH_SIZE + area->x1], &color_p[(y - area->y1) * w], w * sizeof(lv_color_t));
+    }
+    lv_disp_flush_ready(disp);
+}
+
+static void bench_init_lvgl() {
+    lv_init();
+
+    static lv_disp_draw_buf_t draw_buf;
+    lv_disp_draw_buf_init(&draw_buf, bench_buf, NULL, BENCH_SIZE * BENCH_BUF_LINES);
+
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = BENCH_SIZE;
+    disp_drv.ver_res = BENCH_SIZE;
+    disp_drv.flush_cb = bench_flush;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+}
+
+// The arc as lv_draw_sw_arc drew it without the cache
+static void bench_draw_ref(lv_draw_ctx_t* draw_ctx, const bench_arc_t* arc, const lv_point_t* center) {
+    lv_area_t area_out;
+    area_out.x1 = center->x - arc->radius;
+    area_out.y1 = center->y - arc->radius;
+    area_out.x2 = center->x + arc->radius - 1;
+    area_out.y2 = center->y + arc->radius - 1;
+
+    lv_area_t area_in = area_out;
+    area_in.x1 += arc->width;
+    area_in.y1 += arc->width;
+    area_in.x2 -= arc->width;
+    area_in.y2 -= arc->width;
+
+    lv_draw_mask_radius_param_t in_param;
+    int16_t in_id = LV_MASK_ID_INV;
+    if (lv_area_get_width(&area_in) > 0 && lv_area_get_height(&area_in) > 0) {
+        lv_draw_mask_radius_init(&in_param, &area_in, LV_RADIUS_CIRCLE, true);
+        in_id = lv_draw_mask_add(&in_param, NULL);
+    }
+    lv_draw_mask_radius_param_t out_param;
+    lv_draw_mask_radius_init(&out_param, &area_out, LV_RADIUS_CIRCLE, false);
+    int16_t out_id = lv_draw_mask_add(&out_param, NULL);
+
+    bool full = arc->end_angle - arc->start_angle == 360;
+    lv_draw_mask_angle_param_t angle_param;
+    int16_t angle_id = LV_MASK_ID_INV;
+    if (!full) {
+        lv_draw_mask_angle_init(&angle_param, center->x, center->y, arc->start_angle, arc->end_angle);
+        angle_id = lv_draw_mask_add(&angle_param, NULL);
+    }
+
+    lv_draw_rect_dsc_t rect_dsc;
+    lv_draw_rect_dsc_init(&rect_dsc);
+    rect_dsc.bg_color = lv_color_white();
+    rect_dsc.radius = full ? LV_RADIUS_CIRCLE : 0;
+    lv_draw_rect(draw_ctx, &rect_dsc, &area_out);
+
+    if (angle_id != LV_MASK_ID_INV) {
+        lv_draw_mask_remove_id(angle_id);
+        lv_draw_mask_free_param(&angle_param);
+    }
+    lv_draw_mask_remove_id(out_id);
+    lv_draw_mask_free_param(&out_param);
+    if (in_id != LV_MASK_ID_INV) {
+        lv_draw_mask_remove_id(in_id);
+        lv_draw_mask_free_param(&in_param);
+    }
+}
+
+static void bench_draw_cb(lv_event_t* e) {
+    bench_state_t* st = (bench_state_t*)lv_event_get_user_data(e);
+    lv_obj_t* obj = lv_event_get_target(e);
+    lv_draw_ctx_t* draw_ctx = lv_event_get_draw_ctx(e);
+
+    lv_point_t center;
+    center.x = obj->coords.x1 + BENCH_SIZE / 2;
+    center.y = obj->coords.y1 + BENCH_SIZE / 2;
+
+    uint64_t t = bench_now_us();
+    if (st->ref) {
+        bench_draw_ref(draw_ctx, st->arc, &center);
+    } else {
+        lv_draw_arc_dsc_t arc_dsc;
+        lv_draw_arc_dsc_init(&arc_dsc);
+        arc_dsc.color = lv_color_white();
+        arc_dsc.width = st->arc->width;
+        lv_draw_arc(draw_ctx, &arc_dsc, &center, st->arc->radius, st->arc->start_angle, st->arc->end_angle);
+    }
+    st->draw_us += bench_now_us() - t;
+}
+
+static uint64_t bench_frame(lv_obj_t* obj, bench_state_t* st, bool ref) {
+    st->ref = ref;
+    st->draw_us = 0;
+    lv_obj_invalidate(obj);
+    lv_refr_now(NULL);
+    return st->draw_us;
+}
+
+static void bench_min(uint64_t* best, uint64_t t) {
+    if (*best == 0 || t < *best) *best = t;
+}
+
+int main(int argc, char** argv) {
+    int rounds = 20;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--rounds N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    bench_init_lvgl();
+    lv_obj_t* scr = lv_scr_act();
+    lv_obj_set_style_bg_color(scr, lv_color_black(), 0);
+
+    uint32_t failed = 0;
+    printf("%dx%d, %d-line buffer, us per frame, min of %d rounds:\n", BENCH_SIZE, BENCH_SIZE, BENCH_BUF_LINES, rounds);
+    printf("  radius  width  angles     radius masks  ring cache  first draw\n");
+    for (uint32_t a = 0; a < BENCH_ARC_CNT; a++) {
+        lv_obj_t* obj = lv_obj_create(scr);
+        lv_obj_remove_style_all(obj);
+        lv_obj_set_size(obj, BENCH_SIZE, BENCH_SIZE);
+
+        bench_state_t st = {&bench_arcs[a], false, 0};
+        lv_obj_add_event_cb(obj, bench_draw_cb, LV_EVENT_DRAW_MAIN, &st);
+
+        // The first frame builds the table: the rings before have different sizes
+        uint64_t t_first = bench_frame(obj, &st, false);
+
+        uint64_t t_ref = 0, t_act = 0;
+        for (int r = 0; r < rounds; r++) {
+            bench_min(&t_ref, bench_frame(obj, &st, true));
+            bench_min(&t_act, bench_frame(obj, &st, false));
+        }
+
+        // The same pixels both ways
+        bench_frame(obj, &st, true);
+        memcpy(bench_ref_fb, bench_fb, sizeof(bench_fb));
+        bench_frame(obj, &st, false);
+        bool same = memcmp(bench_ref_fb, bench_fb, sizeof(bench_fb)) == 0;
+        if (!same) failed++;
+
+        printf("  %6d  %5d  %3u-%-3u  %12llu  %10llu  %10llu%s\n", bench_arcs[a].radius, bench_arcs[a].width,
+               bench_arcs[a].start_angle, bench_arcs[a].end_angle, (unsigned long long)t_ref,
+               (unsigned long long)t_act, (unsigned long long)t_first, same ? "" : "  FAIL the frames differ");
+        lv_obj_del(obj);
+    }
+    printf("%u failed\n", failed);
+    return failed != 0;
+}
@@ -0,0 +1,422 @@
+/*
+ * Serial Host Test - ArduinoCompat.h, SerialManager and SerialProtocol on the host
+ * Builds the state and protocol code the way the simulator does and checks:
+ *
+ *   string     String against the Arduino core's results (numbers, +,
+ *              out of range indexOf/substring/operator[], trim, toInt)
+ *   serial     inject/read/peek, CRLF println, printf past the stack buffer,
+ *              the bounded output capture
+ *   clock      virtual millis(), delay() and sim_clock_run() stopping at
+ *              its end time with delays inside the loop
+ *   manager    scripted lines through SerialManager: replies, screen,
+ *              target and progress changes, the 2 s tracking timeout, lines
+ *              split over updates, the 512 byte overflow
+ *   protocol   packets built as SerialProtocol.h documents them: accepted,
+ *              split over updates, after garbage; bad checksum, end and
+ *              length rejected without losing the next packet
+ *   fuzz       random bytes (biased to the syntax of both parsers) into
+ *              each parser in random chunks; the state has to stay in range
+ *   bench      ns per tracking line through SerialManager::update() and
+ *              per nose packet through SerialProtocol::update(), min of
+ *              alternating rounds
+ *
+ * Build (from the project root):
+ *   g++ -O2 -Iinclude tools/serial_host/serial_host_test.cpp -o serial_host_test
+ *
+ * With ASan/UBSan:
+ *   g++ -O1 -g -fsanitize=address,undefined -fsanitize=float-cast-overflow -Iinclude \
+ *       tools/serial_host/serial_host_test.cpp -o serial_host_asan
+ *
+ * Usage:
+ *   ./serial_host_test                    # checks, 2M fuzz bytes per parser, bench
+ *   ./serial_host_test --fuzz 100000 --seed 7
+ */
+
+#include "state/AppState.h"
+#include "state/SerialManager.h"
+#include "SerialProtocol.h"
+
+#include <math.h>
+#include <time.h>
+
+SerialClass Serial;
+
+// Alternating timing rounds, the fastest one is reported
+#define TEST_ROUNDS 5
+#define TEST_BENCH_LINES 20000
+
+static uint32_t test_fails;
+static const char* test_section;
+
+#define TEST_CHECK(cond)                                                          \
+    do {                                                                          \
+        if (!(cond)) {                                                            \
+            printf("FAIL %s:%d (%s): %s\n", __FILE__, __LINE__, test_section, #cond); \
+            test_fails++;                                                         \
+        }                                                                         \
+    } while (0)
+
+static uint32_t test_rand = 1;
+
+static uint32_t test_random(uint32_t max) {
+    test_rand = test_rand * 1103515245u + 12345u;
+    return (test_rand >> 16) % (max + 1);
+}
+
+static uint64_t test_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static bool test_output_has(const std::string& out, const char* text) {
+    return out.find(text) != std::string::npos;
+}
+
+static void test_string() {
+    test_section = "string";
+    TEST_CHECK(String(42) == "42");
+    TEST_CHECK(String(-7) == "-7");
+    TEST_CHECK(String(255u, 16) == "ff");
+    TEST_CHECK(String(-1L, 16) == String(0xFFFFFFFFFFFFFFFFUL, 16));
+    TEST_CHECK(String(3.14159f) == "3.14");
+    TEST_CHECK(String(2.25, 1) == "2.2");
+    TEST_CHECK(String('c') == "c");
+    TEST_CHECK("a" + String("b") + 'c' + 1 == "abc1");
+
+    String s("hello world");
+    TEST_CHECK(s.indexOf('x') == -1);
+    TEST_CHECK(s.indexOf("o", 5) == 7);
+    TEST_CHECK(s.indexOf('o', 100) == -1);
+    TEST_CHECK(s.lastIndexOf('o') == 7);
+    TEST_CHECK(s.substring(3, 1) == s.substring(1, 3));
+    TEST_CHECK(s.substring(100) == "");
+    TEST_CHECK(s.substring(6, 100) == "world");
+    TEST_CHECK(s[100] == 0);
+    TEST_CHECK(s.startsWith("hello") && s.endsWith("world") && !s.endsWith("hello world!"));
+
+    String t(" \t 42abc \r\n");
+    t.trim();
+    TEST_CHECK(t == "42abc");
+    TEST_CHECK(t.toInt() == 42);
+    TEST_CHECK(String("-5").toInt() == -5);
+    TEST_CHECK(String("x").toInt() == 0);
+    TEST_CHECK(String().length() == 0 && String((const char*)NULL) == "");
+
+    String r("a-b-c");
+    r.replace("-", "--");
+    TEST_CHECK(r == "a--b--c");
+    r.remove(1);
+    TEST_CHECK(r == "a");
+}
+
+static void test_serial() {
+    test_section = "serial";
+    Serial.take_output();
+    Serial.inject("ab");
+    TEST_CHECK(Serial.available() == 2);
+    TEST_CHECK(Serial.peek() == 'a');
+    TEST_CHECK(Serial.read() == 'a' && Serial.read() == 'b');
+    TEST_CHECK(Serial.read() == -1 && Serial.peek() == -1 && Serial.available() == 0);
+
+    Serial.println("x");
+    Serial.print(12);
+    Serial.println(1.5, 1);
+    TEST_CHECK(Serial.take_output() == "x\r\n121.5\r\n");
+
+    std::string big(300, 'y');
+    Serial.printf("%s|", big.c_str());
+    TEST_CHECK(Serial.take_output() == big + "|");
+
+    std::string fill(ARDUINO_COMPAT_TX_CAPTURE + 10, 'z');
+    uint32_t dropped = Serial.get_tx_dropped();
+    Serial.write((const uint8_t*)fill.data(), fill.size());
+    TEST_CHECK(Serial.take_output().size() == ARDUINO_COMPAT_TX_CAPTURE);
+    TEST_CHECK(Serial.get_tx_dropped() - dropped == 10);
+}
+
+static uint32_t test_ticks_ms;
+static uint32_t test_loop_calls;
+
+static void test_tick(uint32_t ms) {
+    test_ticks_ms += ms;
+}
+
+static void test_loop_with_delay() {
+    test_loop_calls++;
+    delay(15);
+}
+
+static void test_clock() {
+    test_section = "clock";
+    sim_clock_use_virtual(1000);
+    sim_clock_set_tick_cb(test_tick);
+    TEST_CHECK(millis() == 1000);
+    delay(2500);
+    TEST_CHECK(millis() == 3500 && test_ticks_ms == 2500);
+    delayMicroseconds(1500);
+    TEST_CHECK(micros() == 3501500);
+
+    // 25 ms per call: 15 in the loop and the 10 ms step, 100 ms is over after 4 calls
+    TEST_CHECK(sim_clock_run(100, 10, test_loop_with_delay) == 4 && test_loop_calls == 4);
+    TEST_CHECK(millis() == 3601);
+    sim_clock_set_tick_cb(NULL);
+}
+
+static void test_manager() {
+    test_section = "manager";
+    AppState* app = AppState::getInstance();
+    SerialManager manager;
+    manager.begin(115200);
+    std::string out = Serial.take_output();
+    TEST_CHECK(test_output_has(out, "SerialManager ready"));
+
+    Serial.inject("3\n");
+    manager.update();
+    out = Serial.take_output();
+    TEST_CHECK(app->getCurrentScreen() == SCREEN_3 && test_output_has(out, "OK: Switched to Screen 3"));
+
+    Serial.inject("{\"screen\": 5}\r\n");
+    manager.update();
+    out = Serial.take_output();
+    TEST_CHECK(app->getCurrentScreen() == SCREEN_4 && test_output_has(out, "OK: Screen changed to 5"));
+
+    // Short lines that aren't numbers
+    Serial.inject("\x80\n\xC3\xA9\n  \t \nA\n-1\n");
+    manager.update();
+    TEST_CHECK(app->getCurrentScreen() == SCREEN_4);
+    Serial.take_output();
+
+    Serial.inject("{\"screen\": 11}\n");
+    manager.update();
+    TEST_CHECK(app->getCurrentScreen() == SCREEN_4 && test_output_has(Serial.take_output(), "ERR: Screen must be 1-10"));
+
+    // Split over updates
+    Serial.inject("{\"scr");
+    manager.update();
+    TEST_CHECK(app->getCurrentScreen() == SCREEN_4);
+    Serial.inject("een\": 8}\n");
+    manager.update();
+    TEST_CHECK(app->getCurrentScreen() == SCREEN_7);
+    Serial.take_output();
+
+    Serial.inject("X:100,Y:200\n");
+    manager.update();
+    TEST_CHECK(app->getTargetX() == 100 && app->getTargetY() == 200 && app->isTrackingActive());
+    TEST_CHECK(Serial.take_output().empty());
+    delay(1999);
+    TEST_CHECK(app->isTrackingActive());
+    delay(501);
+    TEST_CHECK(!app->isTrackingActive());
+
+    Serial.inject("X:500,Y:10\n");
+    manager.update();
+    TEST_CHECK(app->getTargetX() == 100 && test_output_has(Serial.take_output(), "RX: X:500,Y:10"));
+
+    Serial.inject("{\"progress\": 42}\n");
+    manager.update();
+    TEST_CHECK(app->getProgress() == 42 && app->isProgressActive());
+    TEST_CHECK(test_output_has(Serial.take_output(), "OK: Progress 42%"));
+    Serial.inject("{\"progress\": 101}\n");
+    manager.update();
+    TEST_CHECK(app->getProgress() == 42 && test_output_has(Serial.take_output(), "ERR: Progress must be 0-100"));
+
+    std::string line(600, 'q');
+    Serial.inject(line.c_str());
+    Serial.inject("\n2\n");
+    manager.update();
+    out = Serial.take_output();
+    TEST_CHECK(test_output_has(out, "ERR: Buffer overflow") && app->getCurrentScreen() == SCREEN_2);
+}
+
+// A packet as documented in SerialProtocol.h
+static std::string test_packet(uint8_t cmd, const void* data, uint8_t data_len) {
+    std::string p;
+    uint8_t len = 1 + data_len;
+    uint8_t checksum = len ^ cmd;
+    p += (char)PACKET_START;
+    p += (char)len;
+    p += (char)cmd;
+    for (uint8_t i = 0; i < data_len; i++) {
+        p += ((const char*)data)[i];
+        checksum ^= ((const uint8_t*)data)[i];
+    }
+    p += (char)checksum;
+    p += (char)PACKET_END;
+    return p;
+}
+
+static std::string test_nose_packet(float x, float y) {
+    uint8_t data[8];
+    memcpy(&data[0], &x, 4);
+    memcpy(&data[4], &y, 4);
+    return test_packet(CMD_NOSE_POSITION, data, 8);
+}
+
+static void test_protocol() {
+    test_section = "protocol";
+    AppState* app = AppState::getInstance();
+    SerialProtocol protocol;
+    protocol.begin(115200);
+    Serial.take_output();
+
+    uint8_t state = STATE_PROCESSING;
+    Serial.inject(test_packet(CMD_SET_STATE, &state, 1).c_str());
+    protocol.update();
+    TEST_CHECK(app->getCurrentScreen() == SCREEN_7 && test_output_has(Serial.take_output(), "Set State: 7"));
+
+    std::string p = test_nose_packet(0.5f, 0.25f);
+    Serial.inject(p.data(), p.size());
+    protocol.update();
+    TEST_CHECK(app->getTargetX() == 300 && app->getTargetY() == 112);
+    Serial.take_output();
+
+    // Byte by byte, after garbage
+    uint8_t percent = 80;
+    p = "\x01\x55garbage" + test_packet(CMD_PROGRESS, &percent, 1);
+    for (size_t i = 0; i < p.size(); i++) {
+        Serial.inject(&p[i], 1);
+        protocol.update();
+    }
+    TEST_CHECK(app->getProgress() == 80 && test_output_has(Serial.take_output(), "Progress: 80%"));
+
+    // Rejected, and the packet after each one still goes through
+    state = STATE_SUCCESS;
+    std::string good = test_packet(CMD_SET_STATE, &state, 1);
+    std::string bad_checksum = good;
+    bad_checksum[4] ^= 1;
+    std::string bad_end = good;
+    bad_end[5] = 0x00;
+    const struct {
+        std::string packet;
+        const char* reply;
+    } rejects[] = {
+        {bad_checksum, "Checksum error"},
+        {bad_end, "Invalid packet end"},
+        {std::string("\xAA\x00", 2), "Invalid length: 0"},
+        {std::string("\xAA\x28\x01", 3), "Invalid length: 40"},
+    };
+    for (const auto& reject : rejects) {
+        app->changeScreen(SCREEN_0);
+        Serial.take_output();
+        Serial.inject(reject.packet.data(), reject.packet.size());
+        protocol.update();
+        TEST_CHECK(app->getCurrentScreen() == SCREEN_0 && test_output_has(Serial.take_output(), reject.reply));
+        Serial.inject(good.data(), good.size());
+        protocol.update();
+        TEST_CHECK(app->getCurrentScreen() == SCREEN_8);
+    }
+
+    // The longest packet fits
+    uint8_t data[MAX_PACKET_SIZE - 4] = {1};
+    p = test_packet(CMD_PROGRESS, data, sizeof(data));
+    Serial.inject(p.data(), p.size());
+    protocol.update();
+    TEST_CHECK(app->getProgress() == 1 && test_output_has(Serial.take_output(), "Progress: 1%"));
+
+    // Only normalized positions move the target
+    p = test_nose_packet(NAN, 2.0f) + test_nose_packet(-0.5f, 0.5f);
+    Serial.inject(p.data(), p.size());
+    protocol.update();
+    TEST_CHECK(app->getTargetX() == 300 && app->getTargetY() == 112);
+    Serial.take_output();
+}
+
+// The state both parsers can reach
+static bool test_state_ok() {
+    AppState* app = AppState::getInstance();
+    return app->getCurrentScreen() >= SCREEN_0 && app->getCurrentScreen() <= SCREEN_10 && app->getProgress() <= 100 &&
+           app->getTargetX() >= 0 && app->getTargetX() <= 600 && app->getTargetY() >= 0 && app->getTargetY() <= 450;
+}
+
+// Bytes mostly from the syntax of the parsers, so that they get past their first checks
+static char test_fuzz_byte() {
+    static const char syntax[] = "\n\r{}\":, 0123456789-XY:screenprogressdata\xAA\x55\x01\x02\x03\x09";
+    return test_random(3) ? syntax[test_random(sizeof(syntax) - 2)] : (char)test_random(255);
+}
+
+template <typename Parser>
+static uint32_t test_fuzz_parser(Parser* parser, uint32_t bytes) {
+    uint32_t bad = 0;
+    char chunk[64];
+    for (uint32_t done = 0; done < bytes;) {
+        uint32_t n = 1 + test_random(sizeof(chunk) - 1);
+        for (uint32_t i = 0; i < n; i++) chunk[i] = test_fuzz_byte();
+        Serial.inject(chunk, n);
+        parser->update();
+        Serial.take_output();
+        bad += !test_state_ok();
+        done += n;
+    }
+    return bad;
+}
+
+static void test_fuzz(uint32_t bytes) {
+    test_section = "fuzz";
+    SerialManager manager;
+    SerialProtocol protocol;
+    uint32_t manager_bad = test_fuzz_parser(&manager, bytes);
+    uint32_t protocol_bad = test_fuzz_parser(&protocol, bytes);
+    printf("fuzz: %u bytes per parser, state out of range %u (manager), %u (protocol)\n", bytes, manager_bad,
+           protocol_bad);
+    TEST_CHECK(manager_bad == 0 && protocol_bad == 0);
+}
+
+static void test_min(uint64_t* best, uint64_t t) {
+    if (*best == 0 || t < *best) *best = t;
+}
+
+static void test_bench() {
+    SerialManager manager;
+    SerialProtocol protocol;
+    std::string lines, packets;
+    char line[32];
+    for (uint32_t i = 0; i < TEST_BENCH_LINES; i++) {
+        snprintf(line, sizeof(line), "X:%u,Y:%u\n", i % 466, (i * 7) % 466);
+        lines += line;
+        packets += test_nose_packet((i % 100) / 100.0f, ((i * 7) % 100) / 100.0f);
+    }
+
+    uint64_t manager_ns = 0, protocol_ns = 0;
+    for (int r = 0; r < TEST_ROUNDS; r++) {
+        Serial.inject(lines.data(), lines.size());
+        uint64_t t = test_now_ns();
+        manager.update();
+        test_min(&manager_ns, (test_now_ns() - t) / TEST_BENCH_LINES);
+        Serial.take_output();
+
+        Serial.inject(packets.data(), packets.size());
+        t = test_now_ns();
+        protocol.update();
+        test_min(&protocol_ns, (test_now_ns() - t) / TEST_BENCH_LINES);
+        Serial.take_output();
+    }
+    printf("\n%u messages, ns per message (min of %d):\n", TEST_BENCH_LINES, TEST_ROUNDS);
+    printf("  manager \"X:..,Y:..\"   %6llu\n", (unsigned long long)manager_ns);
+    printf("  protocol nose packet  %6llu  (prints a line per packet)\n", (unsigned long long)protocol_ns);
+}
+
+int main(int argc, char** argv) {
+    uint32_t fuzz_bytes = 2000000;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--fuzz") && i + 1 < argc) {
+            fuzz_bytes = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+            test_rand = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--fuzz BYTES] [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    test_string();
+    test_serial();
+    test_clock();
+    test_manager();
+    test_protocol();
+    test_fuzz(fuzz_bytes);
+    printf("%u failed checks\n", test_fails);
+
+    test_bench();
+    return test_fails != 0;
+}
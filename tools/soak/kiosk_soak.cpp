@@ -0,0 +1,324 @@
+/*
+ * Kiosk Soak - Hours of the kiosk's screen flow in virtual time
+ * Runs the host build of the UI (main.h, AppState, SerialManager and
+ * PowerMonitor, and app_loop_step() of AppLoop.h, the body of the device's
+ * loop()) on the virtual clock of ArduinoCompat.h: millis(), micros(),
+ * LVGL's tick (sim_clock_set_tick_cb(lv_tick_inc)) and so the animations,
+ * the transitions and AppState's timeouts all move only when the clock is
+ * advanced, 1 ms per loop() like its delay(1). An hour takes seconds.
+ *
+ * The serial input is the schedule of the end-to-end harness
+ * (tools/e2e/LoadGen.h): the kiosk states, starting on the tracking screen
+ * with the nose tracking streamed while it shows, and bursts of hostile
+ * input. Each message is injected into Serial at its time. Checked:
+ *
+ *   screens    every state shows its screen (AppState and main.h) before
+ *              the next state arrives
+ *   tracking   isTrackingActive() every loop against the time of the last
+ *              target: active for exactly 2 s after it, then timed out
+ *   memory     the LVGL pools use no more at the start of the last walk of
+ *              the flow than at the start of the second one
+ *   clock      lv_tick_get() follows millis()
+ *   repeat     two runs (each in a new process, as after a boot) give the
+ *              same counts and the same flushed areas
+ *
+ * Build (from the project root, after tools/host/build_lvgl.sh):
+ *   g++ -O2 -DLV_CONF_INCLUDE_SIMPLE -DLV_LVGL_H_INCLUDE_SIMPLE -Itools/host \
+ *       -Ilib/lvgl-8.3.5 -Ilib/lvgl-8.3.5/src -Iinclude -Itools/e2e \
+ *       tools/soak/kiosk_soak.cpp build_host/liblvgl.a -lm -o kiosk_soak
+ *
+ * Usage:
+ *   ./kiosk_soak                      # 2 hours, twice
+ *   ./kiosk_soak --minutes 10 --seed 7
+ */
+
+#include <lvgl.h>
+#include "state/AppState.h"
+#include "state/SerialManager.h"
+#include "state/PowerMonitor.h"
+#include "utils/LatencyTrace.h"
+#include "main.h"
+#include "AppLoop.h"
+#include "LoadGen.h"
+
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+SerialClass Serial;
+
+// loop()'s delay(1)
+#define SOAK_LOOP_MS 1
+// AppState::isTrackingActive()
+#define SOAK_TRACKING_TIMEOUT_MS 2000
+
+typedef struct {
+    uint32_t minutes = 120;
+    uint32_t state_interval_ms = 2000;
+    uint32_t tracking_ms = 10000;
+    uint32_t tracking_hz = 30;
+    uint32_t burst_period_ms = 60000;
+    uint32_t burst_bytes = 4096;
+    uint32_t seed = 1;
+} soak_opts_t;
+
+typedef struct {
+    uint64_t loops;
+    uint32_t msgs;
+    uint32_t screens;            // State messages shown by the next one
+    uint32_t screens_missed;
+    uint32_t targets;
+    uint32_t tracking_timeouts;  // Active -> inactive after the last target
+    uint32_t tracking_wrong;     // Loops where isTrackingActive() disagreed
+    uint32_t walks;              // Returns to the first state
+    uint32_t pool_used_second;   // At the start of the second walk
+    uint32_t pool_used_last;     // At the start of the last one
+    uint32_t refreshes;
+    uint64_t flushed_px;
+    uint32_t flush_hash;         // Of the flushed areas, in order
+    uint32_t tick_ms;            // lv_tick_get() at the end
+    uint32_t millis;
+} soak_result_t;
+
+static soak_opts_t opts;
+static loadgen_t gen;
+static AppState* appState;
+static SerialManager* serialManager;
+static PowerMonitor* powerMonitor;
+
+static soak_result_t* res;
+static size_t next_msg;
+static int expected_screen = -1;     // Of the last state message
+static uint8_t first_screen;         // The state the walks start with
+static bool target_seen;
+static uint64_t last_target_ms;
+static bool was_active;
+
+static void soak_hash(uint32_t v) {
+    // FNV-1a over the bytes of v
+    for (int i = 0; i < 4; i++) {
+        res->flush_hash ^= (v >> (i * 8)) & 0xFF;
+        res->flush_hash *= 16777619u;
+    }
+}
+
+static void soak_flush(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p) {
+    (void)color_p;
+    res->flushed_px += (uint64_t)lv_area_get_width(area) * lv_area_get_height(area);
+    soak_hash(((uint32_t)area->x1 << 16) | (uint16_t)area->y1);
+    soak_hash(((uint32_t)area->x2 << 16) | (uint16_t)area->y2);
+    if (lv_disp_flush_is_last(disp)) res->refreshes++;
+    lv_disp_flush_ready(disp);
+}
+
+// A steady battery, discharging
+static bool soak_read_power(PowerSample* out) {
+    out->millivolts = 3900;
+    out->percent = -1;
+    out->charging = 0;
+    return true;
+}
+
+static void soak_init_lvgl() {
+    lv_init();
+
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf_1[466 * 80];
+    static lv_color_t buf_2[466 * 80];
+    lv_disp_draw_buf_init(&draw_buf, buf_1, buf_2, 466 * 80);
+
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = 466;
+    disp_drv.ver_res = 466;
+    disp_drv.flush_cb = soak_flush;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+}
+
+// The previous state had its whole stay to show up
+static void soak_check_screen() {
+    if (expected_screen < 0) return;
+    res->screens++;
+    if (appState->getCurrentScreen() != expected_screen || get_current_screen() != expected_screen) {
+        if (res->screens_missed == 0) {
+            printf("FAIL at %lu ms screen %d expected, AppState %d, shown %d\n", millis(), expected_screen,
+                   (int)appState->getCurrentScreen(), get_current_screen());
+        }
+        res->screens_missed++;
+    }
+}
+
+// Messages due by now go to Serial, as if they had been received since the last loop
+static void soak_inject() {
+    uint64_t now_us = sim_clock_now_us();
+    while (next_msg < gen.msgs.size() && gen.msgs[next_msg].at_us <= now_us) {
+        loadgen_msg_t* msg = &gen.msgs[next_msg++];
+        Serial.inject(msg->bytes.data(), msg->bytes.size());
+        res->msgs++;
+
+        if (msg->effect == LOADGEN_EFFECT_SCREEN) {
+            soak_check_screen();
+            expected_screen = msg->a;
+            if (msg->a == first_screen) {
+                res->walks++;
+                lv_mem_pool_monitor_t mon;
+                lv_mem_pool_monitor(&mon);
+                if (res->walks == 2) res->pool_used_second = mon.used_size;
+                res->pool_used_last = mon.used_size;
+            }
+        } else if (msg->effect == LOADGEN_EFFECT_TARGET) {
+            res->targets++;
+            target_seen = true;
+            last_target_ms = millis();
+        }
+    }
+}
+
+static void soak_check_tracking() {
+    bool active = appState->isTrackingActive();
+    bool expected = target_seen && millis() - last_target_ms < SOAK_TRACKING_TIMEOUT_MS;
+    if (active != expected) {
+        if (res->tracking_wrong == 0) {
+            printf("FAIL at %lu ms tracking %s, last target at %llu ms\n", millis(),
+                   active ? "active" : "inactive", (unsigned long long)last_target_ms);
+        }
+        res->tracking_wrong++;
+    }
+    if (was_active && !active) res->tracking_timeouts++;
+    was_active = active;
+}
+
+static void soak_loop() {
+    soak_inject();
+    app_loop_step(appState, serialManager, powerMonitor);
+    soak_check_tracking();
+    Serial.take_output();
+    res->loops++;
+}
+
+static void soak_run(soak_result_t* out) {
+    res = out;
+    memset(res, 0, sizeof(*res));
+
+    sim_clock_use_virtual(0);
+    sim_clock_set_tick_cb(lv_tick_inc);
+
+    soak_init_lvgl();
+    appState = AppState::getInstance();
+    serialManager = new SerialManager();
+    serialManager->begin(115200);
+    powerMonitor = new PowerMonitor();
+    powerMonitor->begin(soak_read_power);
+    idle_sched_init([]() -> uint32_t { return micros(); });
+    latency_trace_init([]() -> uint32_t { return micros(); });
+    init_ui();
+    appState->setScreenChangeCallback([](ScreenID screen) { switch_to_screen((int)screen, true); });
+
+    uint32_t duration_ms = opts.minutes * 60000;
+    gen.seed = opts.seed;
+    loadgen_add_kiosk(&gen, 0, opts.state_interval_ms, opts.tracking_ms, opts.tracking_hz, duration_ms);
+    loadgen_add_bursts(&gen, opts.burst_period_ms / 2, duration_ms, opts.burst_period_ms, opts.burst_bytes);
+    loadgen_sort(&gen);
+    for (const loadgen_msg_t& msg : gen.msgs) {
+        if (msg.effect == LOADGEN_EFFECT_SCREEN) {
+            first_screen = msg.a;
+            break;
+        }
+    }
+
+    sim_clock_run(duration_ms, SOAK_LOOP_MS, soak_loop);
+    soak_check_screen();
+
+    res->tick_ms = lv_tick_get();
+    res->millis = millis();
+}
+
+// Each run in a new process, as after a boot: the screens can be built only once
+static bool soak_fork(soak_result_t* out) {
+    int fd[2];
+    if (pipe(fd) != 0) return false;
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fd[0]);
+        soak_run(out);
+        fflush(stdout);
+        bool ok = write(fd[1], out, sizeof(*out)) == (ssize_t)sizeof(*out);
+        _exit(ok ? 0 : 1);
+    }
+    close(fd[1]);
+    bool ok = pid > 0 && read(fd[0], out, sizeof(*out)) == (ssize_t)sizeof(*out);
+    close(fd[0]);
+    int status = 0;
+    if (pid > 0) waitpid(pid, &status, 0);
+    return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static bool soak_parse_args(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* key = argv[i];
+        uint32_t val = atoi(argv[i + 1]);
+        if (!strcmp(key, "--minutes")) opts.minutes = val;
+        else if (!strcmp(key, "--state-interval-ms")) opts.state_interval_ms = val;
+        else if (!strcmp(key, "--tracking-ms")) opts.tracking_ms = val;
+        else if (!strcmp(key, "--tracking-hz")) opts.tracking_hz = val;
+        else if (!strcmp(key, "--burst-period-ms")) opts.burst_period_ms = val;
+        else if (!strcmp(key, "--burst-bytes")) opts.burst_bytes = val;
+        else if (!strcmp(key, "--seed")) opts.seed = val;
+        else return false;
+    }
+    return argc % 2 == 1;
+}
+
+int main(int argc, char** argv) {
+    if (!soak_parse_args(argc, argv)) {
+        fprintf(stderr, "usage: %s [--minutes N] [--state-interval-ms N] [--tracking-ms N] [--tracking-hz N]\n"
+                        "       [--burst-period-ms N] [--burst-bytes N] [--seed N]\n", argv[0]);
+        return 2;
+    }
+
+    soak_result_t runs[2];
+    double wall_s[2];
+    for (int r = 0; r < 2; r++) {
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (!soak_fork(&runs[r])) {
+            printf("FAIL run %d crashed\n1 failed\n", r + 1);
+            return 1;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        wall_s[r] = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    }
+
+    soak_result_t* s = &runs[0];
+    printf("%u min of virtual time in %.1f s and %.1f s (x%.0f), %llu loops, %u messages\n", opts.minutes,
+           wall_s[0], wall_s[1], opts.minutes * 60 / wall_s[0], (unsigned long long)s->loops, s->msgs);
+    printf("screens  %u shown, %u missed, %u walks\n", s->screens, s->screens_missed, s->walks);
+    printf("tracking %u targets, %u timeouts, %u loops wrong\n", s->targets, s->tracking_timeouts,
+           s->tracking_wrong);
+    printf("display  %u refreshes, %.1f Mpx flushed\n", s->refreshes, s->flushed_px / 1e6);
+    printf("pools    %u bytes used at the second walk, %u at the last\n", s->pool_used_second, s->pool_used_last);
+
+    uint32_t failed = 0;
+    if (s->screens_missed || s->screens == 0) failed++;
+    if (s->tracking_wrong || (s->targets && s->tracking_timeouts == 0)) {
+        if (!s->tracking_wrong) printf("FAIL the tracking never timed out\n");
+        failed++;
+    }
+    if (s->pool_used_last > s->pool_used_second) {
+        printf("FAIL the pools grew by %u bytes\n", s->pool_used_last - s->pool_used_second);
+        failed++;
+    }
+    if (s->tick_ms != s->millis) {
+        printf("FAIL lv_tick_get() %u, millis() %u\n", s->tick_ms, s->millis);
+        failed++;
+    }
+    if (memcmp(&runs[0], &runs[1], sizeof(runs[0])) != 0) {
+        printf("FAIL the second run differs\n");
+        failed++;
+    }
+    printf("%u failed\n", failed);
+    return failed != 0;
+}
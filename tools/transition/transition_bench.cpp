@@ -0,0 +1,255 @@
+/*
+ * Transition Benchmark - Frame times of the screen transitions
+ * Runs every transition of SmartTransition.h, and LVGL's own FADE_ON for
+ * comparison, between pairs of the real screens (main.h) on a 466x466
+ * display with the device's 80-line draw buffer:
+ *
+ *   black fade    the overlay over the live object tree
+ *   cross-fade    snapshot_transition(), the RGB565 blend
+ *   slide         snapshot_transition(), row copies
+ *   radial wipe   snapshot_transition(), only the ring that changed
+ *   lvgl fade     lv_scr_load_anim(FADE_ON), both trees every frame
+ *
+ * Each frame is lv_tick_inc(16) and lv_timer_handler(), timed on the host
+ * clock. The flush copies into a frame buffer; after a transition the
+ * buffer has to equal a full redraw of the target screen, and the target
+ * has to be loaded. Styles alternate over the rounds and the fastest
+ * round is reported.
+ *
+ * Then smart_transition() is called again halfway through a transition,
+ * twice: the second screen has to be skipped and the third one loaded,
+ * with the same frame check.
+ *
+ * Build (from the project root, after tools/host/build_lvgl.sh):
+ *   g++ -O2 -DLV_CONF_INCLUDE_SIMPLE -DLV_LVGL_H_INCLUDE_SIMPLE -Itools/host -Ilib/lvgl-8.3.5 \
+ *       -Ilib/lvgl-8.3.5/src -Iinclude tools/transition/transition_bench.cpp \
+ *       build_host/liblvgl.a -lm -o transition_bench
+ *
+ * With ASan/UBSan, against an LVGL built with
+ * CFLAGS="-O1 -g -fsanitize=address,undefined" BUILD=build_host_asan:
+ *   g++ -O1 -g -fsanitize=address,undefined ... build_host_asan/liblvgl.a -lm -o transition_asan
+ *
+ * Usage:
+ *   ./transition_bench                 # 5 rounds
+ *   ./transition_bench --rounds 1
+ */
+
+#include <lvgl.h>
+#include "main.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_W 466
+#define BENCH_H 466
+#define BENCH_TICK_MS 16
+
+// Frames after which a transition counts as stuck
+#define BENCH_MAX_FRAMES 200
+
+enum {
+    BENCH_BLACK_FADE,
+    BENCH_CROSSFADE,
+    BENCH_SLIDE,
+    BENCH_RADIAL_WIPE,
+    BENCH_LVGL_FADE,
+    BENCH_STYLE_CNT
+};
+
+static const char* const bench_style_names[BENCH_STYLE_CNT] = {
+    "black fade", "cross-fade", "slide", "radial wipe", "lvgl fade",
+};
+
+// Screens switched between: logo -> loader, loader -> text, text -> tracking, tracking -> info
+static const int bench_pairs[][2] = {{1, 2}, {2, 3}, {3, 7}, {7, 8}};
+#define BENCH_PAIR_CNT (sizeof(bench_pairs) / sizeof(bench_pairs[0]))
+
+typedef struct {
+    uint64_t capture_us;    // Starting the transition (the snapshots)
+    uint64_t avg_us;        // Per frame
+    uint64_t max_us;
+    uint32_t frames;
+    uint32_t failed;        // Didn't end on the target screen or with its picture
+} bench_result_t;
+
+static lv_color_t bench_buf[BENCH_W * 80];
+static lv_color_t bench_fb[BENCH_W * BENCH_H];
+static lv_color_t bench_ref[BENCH_W * BENCH_H];
+
+static uint64_t bench_now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void bench_flush(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p) {
+    lv_coord_t w = lv_area_get_width(area);
+    for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&bench_fb[y * BENCH_W + area->x1], &color_p[(y - area->y1) * w], w * sizeof(lv_color_t));
+    }
+    lv_disp_flush_ready(disp);
+}
+
+static void bench_init_lvgl() {
+    lv_init();
+
+    static lv_disp_draw_buf_t draw_buf;
+    lv_disp_draw_buf_init(&draw_buf, bench_buf, NULL, BENCH_W * 80);
+
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = BENCH_W;
+    disp_drv.ver_res = BENCH_H;
+    disp_drv.flush_cb = bench_flush;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_drv_register(&disp_drv);
+}
+
+static bool bench_running(lv_obj_t* target) {
+    return transition_in_progress || lv_disp_get_default()->prev_scr || lv_scr_act() != target;
+}
+
+static void bench_min(uint64_t* best, uint64_t t) {
+    if (*best == 0 || t < *best) *best = t;
+}
+
+static void bench_run(int style, int from, int to, bench_result_t* res) {
+    if (all_screens[to] == NULL) all_screens[to] = create_screen(to);
+    switch_to_screen(from, false);
+    lv_refr_now(NULL);
+
+    uint64_t t = bench_now_us();
+    switch (style) {
+        case BENCH_BLACK_FADE:
+            smooth_black_fade_transition(all_screens[to]);
+            break;
+        case BENCH_LVGL_FADE:
+            lv_scr_load_anim(all_screens[to], LV_SCR_LOAD_ANIM_FADE_ON, SMART_TRANSITION_TIME_MS, 0, false);
+            break;
+        default:
+            if (!snapshot_transition(all_screens[to], (snapshot_transition_type_t)style, SMART_TRANSITION_TIME_MS)) {
+                printf("%s %d -> %d: no snapshots\n", bench_style_names[style], from, to);
+                res->failed++;
+                return;
+            }
+            break;
+    }
+    bench_min(&res->capture_us, bench_now_us() - t);
+
+    uint64_t sum = 0, max = 0;
+    uint32_t frames = 0;
+    // Until the target is loaded, plus the frame showing it
+    bool done = false;
+    while (!done && frames < BENCH_MAX_FRAMES) {
+        done = !bench_running(all_screens[to]);
+        lv_tick_inc(BENCH_TICK_MS);
+        t = bench_now_us();
+        lv_timer_handler();
+        t = bench_now_us() - t;
+        sum += t;
+        if (t > max) max = t;
+        frames++;
+    }
+    bench_min(&res->avg_us, sum / frames);
+    bench_min(&res->max_us, max);
+    res->frames = frames;
+
+    // Then the frame buffer has to be the target screen as a full redraw draws it. First draw what
+    // the animations of the screen invalidated after the last refresh of the loop
+    lv_refr_now(NULL);
+    memcpy(bench_ref, bench_fb, sizeof(bench_fb));
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+    bool loaded = !bench_running(all_screens[to]);
+    if (!loaded || memcmp(bench_ref, bench_fb, sizeof(bench_fb)) != 0) {
+        printf("FAIL %s %d -> %d: %s\n", bench_style_names[style], from, to,
+               loaded ? "the last frame differs" : "the target isn't loaded");
+        res->failed++;
+    }
+}
+
+// Frame buffer against a full redraw of the active screen, after the last invalidations
+static bool bench_frame_matches() {
+    lv_refr_now(NULL);
+    memcpy(bench_ref, bench_fb, sizeof(bench_fb));
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+    return memcmp(bench_ref, bench_fb, sizeof(bench_fb)) == 0;
+}
+
+// Screen switches during a transition: the newest waits for the running one, the others are dropped
+static uint32_t bench_check_queued(int from, int skipped, int to) {
+    for (int i : {skipped, to}) {
+        if (all_screens[i] == NULL) all_screens[i] = create_screen(i);
+    }
+    switch_to_screen(from, false);
+    lv_refr_now(NULL);
+
+    smart_transition(all_screens[skipped]);
+    smart_transition(all_screens[to]);
+    uint32_t frames = 0;
+    for (; frames < SMART_TRANSITION_TIME_MS / 2 / BENCH_TICK_MS; frames++) {
+        lv_tick_inc(BENCH_TICK_MS);
+        lv_timer_handler();
+    }
+    smart_transition(all_screens[skipped]);
+    smart_transition(all_screens[to]);
+
+    bool passed_skipped = false;
+    while (bench_running(all_screens[to]) && frames < BENCH_MAX_FRAMES) {
+        passed_skipped |= lv_scr_act() == all_screens[skipped] && !transition_in_progress;
+        lv_tick_inc(BENCH_TICK_MS);
+        lv_timer_handler();
+        frames++;
+    }
+    const char* fail = bench_running(all_screens[to]) ? "the last screen isn't loaded"
+                       : passed_skipped                ? "the skipped screen was loaded"
+                       : !bench_frame_matches()        ? "the last frame differs"
+                                                       : NULL;
+    printf("queued %d -> (%d) -> %d: %u frames%s%s\n", from, skipped, to, frames, fail ? ", FAIL " : "",
+           fail ? fail : "");
+    return fail != NULL;
+}
+
+int main(int argc, char** argv) {
+    int rounds = 5;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--rounds N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    bench_init_lvgl();
+    init_ui();
+
+    static bench_result_t results[BENCH_STYLE_CNT][BENCH_PAIR_CNT];
+    for (int r = 0; r < rounds; r++) {
+        for (int s = 0; s < BENCH_STYLE_CNT; s++) {
+            for (uint32_t p = 0; p < BENCH_PAIR_CNT; p++) {
+                bench_run(s, bench_pairs[p][0], bench_pairs[p][1], &results[s][p]);
+            }
+        }
+    }
+
+    uint32_t failed = 0;
+    printf("%d ms transitions, %d ms ticks, us, min of %d rounds:\n", SMART_TRANSITION_TIME_MS, BENCH_TICK_MS, rounds);
+    printf("  style        screens  capture  frames  avg/frame  max/frame\n");
+    for (int s = 0; s < BENCH_STYLE_CNT; s++) {
+        for (uint32_t p = 0; p < BENCH_PAIR_CNT; p++) {
+            bench_result_t* res = &results[s][p];
+            printf("  %-11s  %2d -> %-2d  %7llu  %6u  %9llu  %9llu\n", bench_style_names[s],
+                   bench_pairs[p][0], bench_pairs[p][1], (unsigned long long)res->capture_us, res->frames,
+                   (unsigned long long)res->avg_us, (unsigned long long)res->max_us);
+            failed += res->failed;
+        }
+    }
+    for (uint32_t p = 0; p < BENCH_PAIR_CNT; p++) {
+        failed += bench_check_queued(bench_pairs[p][0], bench_pairs[p][1], bench_pairs[(p + 1) % BENCH_PAIR_CNT][1]);
+    }
+    printf("%u failed\n", failed);
+    return failed != 0;
+}